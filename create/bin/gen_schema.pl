@@ -21,9 +21,9 @@ use File::Basename;
 
 my $file = dirname($0)."/../src/schema.tmpl";	# name the file
 
-my ($state, %output, $eol, $fk_bol, $fk_eol, $ltab, $pkey, $table_name);
+my ($state, %output, $eol, $fk_bol, $fk_eol, $ltab, $pkey, $table_name, $table_id);
 my ($szcol1, $szcol2, $szcol3, $szcol4, $sequences, $sql_suffix);
-my ($fkeys, $fkeys_prefix, $fkeys_suffix, $uniq);
+my ($fkeys, $fkeys_prefix, $fkeys_suffix, $uniq, $triggers, @table_fields);
 
 my %c = (
 	"type"		=>	"code",
@@ -205,6 +205,8 @@ sub process_table
 	newstate("table");
 
 	($table_name, $pkey, $flags) = split(/\|/, $line, 3);
+	$table_id = $pkey;
+	@table_fields = ();
 
 	if ($output{"type"} eq "code")
 	{
@@ -265,6 +267,8 @@ sub process_field
 	($name, $type, $default, $null, $flags, $relN, $fk_table, $fk_field, $fk_flags) = split(/\|/, $line, 9);
 	my ($type_short, $length) = split(/\(/, $type, 2);
 
+	push(@table_fields, $name);
+
 	if ($output{"type"} eq "code")
 	{
 		$type = $output{$type_short};
@@ -394,7 +398,7 @@ sub process_field
 				$sequences = "${sequences}BEFORE INSERT ON ${table_name}${eol}\n";
 				$sequences = "${sequences}FOR EACH ROW${eol}\n";
 				$sequences = "${sequences}BEGIN${eol}\n";
-				$sequences = "${sequences}SELECT ${table_name}_seq.nextval INTO :new.id FROM dual;${eol}\n";
+				$sequences = "${sequences}SELECT ${table_name}_seq.nextval INTO :new.${name} FROM dual;${eol}\n";
 				$sequences = "${sequences}END;${eol}\n/${eol}\n";
 			}
 		}
@@ -519,6 +523,85 @@ sub process_index
 	}
 }
 
+sub process_changelog
+{
+	my ($object, $runtime_fields) = split(/\|/, $_[0], 2);
+
+	if ($output{"type"} eq "code")
+	{
+		return;
+	}
+
+	my %operations = ("insert" => 1, "update" => 2, "delete" => 3);
+
+	# updates of runtime fields written by server (availability, trigger value etc.) are not logged
+	my %runtime = map { $_ => 1 } split(/,/, defined($runtime_fields) ? $runtime_fields : "");
+	my @fields = grep { $_ ne $table_id && !exists($runtime{$_}) } @table_fields;
+	my $update_of = (0 != keys(%runtime) ? " OF ".join(",", @fields) : "");
+
+	foreach my $operation ("insert", "update", "delete")
+	{
+		my $trigger_name = "${table_name}_${operation}";
+		my $event = uc($operation).($operation eq "update" ? $update_of : "");
+		my $objectid = ($operation eq "delete" ? "old" : "new").".${table_id}";
+		my $values = "${object},%s,$operations{$operation},%s";
+
+		if ($output{"database"} eq "mysql")
+		{
+			$values = sprintf($values, $objectid, "unix_timestamp()");
+			$event = uc($operation);
+			$triggers = "${triggers}CREATE TRIGGER `${trigger_name}` AFTER ${event} ON `${table_name}`${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+
+			# MySQL has no column list for update triggers, so old and new rows are compared instead
+			if ($operation eq "update" && "" ne $update_of)
+			{
+				my $changed = join(" AND ", map { "old.$_<=>new.$_" } @fields);
+
+				$triggers = "${triggers}SELECT ${values} FROM DUAL WHERE NOT (${changed});${eol}\n";
+			}
+			else
+			{
+				$triggers = "${triggers}VALUES (${values});${eol}\n";
+			}
+		}
+		elsif ($output{"database"} eq "postgresql")
+		{
+			$values = sprintf($values, $objectid, "cast(extract(epoch from now()) as int)");
+			$triggers = "${triggers}CREATE FUNCTION changelog_${trigger_name}() RETURNS TRIGGER LANGUAGE PLPGSQL AS \$\$${eol}\n";
+			$triggers = "${triggers}BEGIN${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+			$triggers = "${triggers}VALUES (${values});${eol}\n";
+			$triggers = "${triggers}RETURN NULL;${eol}\n";
+			$triggers = "${triggers}END \$\$;${eol}\n";
+			$triggers = "${triggers}CREATE TRIGGER ${trigger_name} AFTER ${event} ON ${table_name}${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW EXECUTE PROCEDURE changelog_${trigger_name}();${eol}\n";
+		}
+		elsif ($output{"database"} eq "oracle")
+		{
+			$values = sprintf($values, ":${objectid}",
+					"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400");
+			$triggers = "${triggers}CREATE TRIGGER ${trigger_name} AFTER ${event} ON ${table_name}${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW${eol}\n";
+			$triggers = "${triggers}BEGIN${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+			$triggers = "${triggers}VALUES (${values});${eol}\n";
+			$triggers = "${triggers}END;${eol}\n/${eol}\n";
+		}
+		elsif ($output{"database"} eq "sqlite3")
+		{
+			$values = sprintf($values, $objectid, "cast(strftime('%s','now') as integer)");
+			$triggers = "${triggers}CREATE TRIGGER ${trigger_name} AFTER ${event} ON ${table_name}${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW${eol}\n";
+			$triggers = "${triggers}BEGIN${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+			$triggers = "${triggers}VALUES (${values});${eol}\n";
+			$triggers = "${triggers}END;${eol}\n";
+		}
+	}
+}
+
 sub process_row
 {
 	my $line = $_[0];
@@ -633,6 +716,7 @@ sub process
 	$state = "bof";
 	$fkeys = "";
 	$sequences = "";
+	$triggers = "";
 	$uniq = "";
 	my ($type, $line);
 
@@ -653,13 +737,14 @@ sub process
 			elsif ($type eq 'INDEX')	{ process_index($line, 0); }
 			elsif ($type eq 'TABLE')	{ process_table($line); }
 			elsif ($type eq 'UNIQUE')	{ process_index($line, 1); }
+			elsif ($type eq 'CHANGELOG')	{ process_changelog($line); }
 			elsif ($type eq 'ROW' && $output{"type"} ne "code")		{ process_row($line); }
 		}
 	}
 
 	newstate("table");
 
-	print $sequences.$sql_suffix;
+	print $sequences.$triggers.$sql_suffix;
 	print $fkeys_prefix.$fkeys.$fkeys_suffix;
 	print $output{"after"};
 }
@@ -130,6 +130,24 @@ const char	*zbx_tcp_connection_type_name(unsigned int type);
 
 int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, unsigned char flags, int timeout);
 
+/* "ZBXD", protocol flags, data length and reserved data length */
+#define ZBX_TCP_HEADER_MAX_LEN	13
+
+/* state of Zabbix protocol message being sent over non-blocking socket */
+typedef struct
+{
+	const char	*data;
+	char		*compressed_data;
+	size_t		send_len;
+	size_t		written;
+	size_t		header_len;
+	char		header_buf[ZBX_TCP_HEADER_MAX_LEN];
+}
+zbx_tcp_send_context_t;
+
+int	zbx_tcp_send_context_init(const char *data, size_t len, unsigned char flags, zbx_tcp_send_context_t *context);
+void	zbx_tcp_send_context_clear(zbx_tcp_send_context_t *context);
+
 void	zbx_tcp_close(zbx_socket_t *s);
 
 #ifdef HAVE_IPV6
@@ -148,6 +166,29 @@ void	zbx_tcp_unaccept(zbx_socket_t *s);
 #define	zbx_tcp_recv_raw(s)		SUCCEED_OR_FAIL(zbx_tcp_recv_raw_ext(s, 0))
 
 ssize_t		zbx_tcp_recv_ext(zbx_socket_t *s, int timeout);
+
+/* state of Zabbix protocol message being received over non-blocking socket */
+typedef struct
+{
+	size_t		buf_dyn_bytes;
+	size_t		buf_stat_bytes;
+	size_t		offset;			/* protocol header length */
+	zbx_uint32_t	expected_len;
+	zbx_uint32_t	reserved;
+	unsigned char	expect;
+	int		protocol_version;
+}
+zbx_tcp_recv_context_t;
+
+void	zbx_tcp_recv_context_init(zbx_socket_t *s, zbx_tcp_recv_context_t *context);
+
+#ifndef _WINDOWS
+/* non-blocking operation must be continued when socket becomes ready */
+#define ZBX_TCP_AGAIN	1
+
+int	zbx_tcp_send_context(zbx_socket_t *s, zbx_tcp_send_context_t *context);
+int	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context);
+#endif
 ssize_t		zbx_tcp_recv_raw_ext(zbx_socket_t *s, int timeout);
 const char	*zbx_tcp_recv_line(zbx_socket_t *s);
 
@@ -482,7 +482,7 @@ int	zbx_db_validate_config_features(void);
 void	zbx_db_validate_config(void);
 #endif
 
-#ifdef HAVE_ORACLE
+#if defined(HAVE_ORACLE) || defined(HAVE_MYSQL)
 void	DBstatement_prepare(const char *sql);
 #endif
 int		DBexecute(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
@@ -648,6 +648,7 @@ int	DBfield_exists(const char *table_name, const char *field_name);
 #ifndef HAVE_SQLITE3
 int	DBindex_exists(const char *table_name, const char *index_name);
 #endif
+int	DBtrigger_exists(const char *table_name, const char *trigger_name);
 
 int	DBexecute_multiple_query(const char *query, const char *field_name, zbx_vector_uint64_t *ids);
 int	DBlock_record(const char *table, zbx_uint64_t id, const char *add_field, zbx_uint64_t add_id);
@@ -682,6 +683,8 @@ typedef struct
 	zbx_vector_ptr_t	rows;
 	/* index of autoincrement field */
 	int			autoincrement;
+	/* rows are loaded with COPY (PostgreSQL) or prepared statements (MySQL) instead of SQL text */
+	unsigned char		bulk;
 }
 zbx_db_insert_t;
 
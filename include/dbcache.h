@@ -36,12 +36,26 @@
 #define	ZBX_POLLER_TYPE_IPMI		2
 #define	ZBX_POLLER_TYPE_PINGER		3
 #define	ZBX_POLLER_TYPE_JAVA		4
-#define	ZBX_POLLER_TYPE_COUNT		5	/* number of poller types */
+#define	ZBX_POLLER_TYPE_AGENT		5
+#define	ZBX_POLLER_TYPE_SNMP		6
+#define	ZBX_POLLER_TYPE_COUNT		7	/* number of poller types */
 
 #define MAX_JAVA_ITEMS		32
 #define MAX_SNMP_ITEMS		128
 #define MAX_POLLER_ITEMS	128	/* MAX(MAX_JAVA_ITEMS, MAX_SNMP_ITEMS) */
 #define MAX_PINGER_ITEMS	128
+#define MAX_AGENT_ITEMS		512	/* concurrent agent connections, keep below the default open files limit */
+#define MAX_AGENT_REQUEST_KEYS	16	/* keys requested from agent over one connection */
+
+/* agent versions learned from passive checks */
+#define ZBX_AGENT_VERSION_UNKNOWN	0
+#define ZBX_AGENT_VERSION_LEGACY	-1	/* agent does not support multiple keys per request */
+#define ZBX_AGENT_VERSION_MULTIKEY	ZBX_COMPONENT_VERSION(5, 4)
+
+/* unknown agent versions are negotiated with multiple keys request */
+#define ZBX_AGENT_MULTIKEY_REQUEST(version)	\
+		(ZBX_AGENT_VERSION_UNKNOWN == (version) || ZBX_AGENT_VERSION_MULTIKEY <= (version))
+#define MAX_SNMP_ASYNC_ITEMS	512	/* items checked concurrently by SNMP poller */
 
 #define ZBX_TRIGGER_DEPENDENCY_LEVELS_MAX	32
 
@@ -50,17 +64,23 @@
 
 #define ZBX_SNMPTRAP_LOGGING_ENABLED	1
 
+/* maximum number of history cache lock stripes, limited by ZBX_MUTEX_CACHE_STRIPE_* mutexes */
+#define ZBX_HC_STRIPES_MAX	8
+
 extern int	CONFIG_TIMEOUT;
 
 extern zbx_uint64_t	CONFIG_CONF_CACHE_SIZE;
 extern zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE;
 extern zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE;
 extern zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE;
+extern int		CONFIG_HISTORY_CACHE_STRIPES;
 
 extern int	CONFIG_POLLER_FORKS;
 extern int	CONFIG_UNREACHABLE_POLLER_FORKS;
 extern int	CONFIG_IPMIPOLLER_FORKS;
 extern int	CONFIG_JAVAPOLLER_FORKS;
+extern int	CONFIG_AGENTPOLLER_FORKS;
+extern int	CONFIG_SNMPPOLLER_FORKS;
 extern int	CONFIG_PINGER_FORKS;
 extern int	CONFIG_UNAVAILABLE_DELAY;
 extern int	CONFIG_UNREACHABLE_PERIOD;
@@ -80,6 +100,7 @@ typedef struct
 	unsigned char	useip;
 	unsigned char	type;
 	unsigned char	main;
+	int		version;	/* agent version, see ZBX_AGENT_VERSION_* defines */
 }
 DC_INTERFACE;
 
@@ -206,6 +227,34 @@ typedef struct
 }
 DC_ITEM;
 
+/* item data required by history syncers, a lightweight subset of DC_ITEM */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	hostid;
+	zbx_uint64_t	proxy_hostid;
+	zbx_uint64_t	lastlogsize;
+	zbx_uint64_t	valuemapid;
+	char		host[HOST_HOST_LEN_MAX];
+	char		*key_orig;
+	char		*units;		/* numeric items only */
+	char		*error;
+	int		history_sec;
+	int		trends_sec;
+	int		mtime;
+	unsigned char	type;
+	unsigned char	value_type;
+	unsigned char	state;
+	unsigned char	status;
+	unsigned char	flags;
+	unsigned char	history;
+	unsigned char	trends;
+	unsigned char	inventory_link;
+	unsigned char	host_status;
+	char		host_inventory_mode;
+}
+zbx_dc_item_hist_t;
+
 typedef struct
 {
 	zbx_uint64_t	functionid;
@@ -245,6 +294,10 @@ typedef struct _DC_TRIGGER
 	char			*expression;
 	char			*recovery_expression;
 
+	/* compiled expressions, NULL if expression must be evaluated from text */
+	const unsigned char	*expression_bin;		/* shared with configuration cache */
+	const unsigned char	*recovery_expression_bin;
+
 	char			*error;
 	char			*new_error;
 	char			*correlation_tag;
@@ -623,6 +676,7 @@ void	zbx_sync_history_cache(int *values_num, int *triggers_num, int *more);
 void	zbx_log_sync_history_cache_progress(void);
 int	init_database_cache(char **error);
 void	free_database_cache(void);
+void	DCload_trends_ownership(void);
 
 #define ZBX_STATS_HISTORY_COUNTER	0
 #define ZBX_STATS_HISTORY_FLOAT_COUNTER	1
@@ -656,6 +710,8 @@ zbx_uint64_t	DCget_nextid(const char *table_name, int num);
 /* update sync, get changed data */
 #define ZBX_DBSYNC_UPDATE	1
 #define ZBX_SYNC_SECRETS	2
+/* update sync, compare all data ignoring changelog */
+#define ZBX_SYNC_FULL		3
 
 void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kvs_paths);
 int	init_configuration_cache(char **error);
@@ -669,6 +725,9 @@ int	DCconfig_get_hostid_by_name(const char *host, zbx_uint64_t *hostid);
 void	DCconfig_get_hosts_by_itemids(DC_HOST *hosts, const zbx_uint64_t *itemids, int *errcodes, size_t num);
 void	DCconfig_get_items_by_keys(DC_ITEM *items, zbx_host_key_t *keys, int *errcodes, size_t num);
 void	DCconfig_get_items_by_itemids(DC_ITEM *items, const zbx_uint64_t *itemids, int *errcodes, size_t num);
+void	zbx_dc_get_hist_items_by_itemids(zbx_dc_item_hist_t *items, const zbx_uint64_t *itemids, int *errcodes,
+		size_t num);
+void	zbx_dc_clean_hist_items(zbx_dc_item_hist_t *items, const int *errcodes, size_t num);
 void	DCconfig_get_preprocessable_items(zbx_hashset_t *items, int *timestamp);
 void	DCconfig_get_functions_by_functionids(DC_FUNCTION *functions,
 		zbx_uint64_t *functionids, int *errcodes, size_t num);
@@ -682,6 +741,7 @@ void	DCconfig_get_triggers_by_itemids(zbx_hashset_t *trigger_info, zbx_vector_pt
 		const zbx_uint64_t *itemids, const zbx_timespec_t *timespecs, int itemids_num);
 void	DCfree_triggers(zbx_vector_ptr_t *triggers);
 void	DCconfig_update_interface_snmp_stats(zbx_uint64_t interfaceid, int max_snmp_succeed, int min_snmp_fail);
+void	DCconfig_update_interface_version(zbx_uint64_t interfaceid, int version);
 int	DCconfig_get_suggested_snmp_vars(zbx_uint64_t interfaceid, int *bulk);
 int	DCconfig_get_interface_by_type(DC_INTERFACE *interface, zbx_uint64_t hostid, unsigned char type);
 int	DCconfig_get_interface(DC_INTERFACE *interface, zbx_uint64_t hostid, zbx_uint64_t itemid);
@@ -725,6 +785,8 @@ int	DCget_host_inventory_value_by_hostid(zbx_uint64_t hostid, char **replace_to,
 #define ZBX_CONFSTATS_BUFFER_FREE	3
 #define ZBX_CONFSTATS_BUFFER_PUSED	4
 #define ZBX_CONFSTATS_BUFFER_PFREE	5
+#define ZBX_CONFSTATS_SYNC_LOCK		6
+#define ZBX_CONFSTATS_SYNC_LOCK_MAX	7
 void	*DCconfig_get_stats(int request);
 
 int	DCconfig_get_last_sync_time(void);
@@ -1014,4 +1076,40 @@ void	zbx_dc_free_timers(zbx_vector_ptr_t *timers);
 int	zbx_db_trigger_queue_locked(void);
 void	zbx_db_trigger_queue_unlock(void);
 
+/* proxy history buffer record */
+typedef struct
+{
+	zbx_uint64_t	id;		/* buffer position after the record, set when reading */
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	lastlogsize;
+	const char	*source;
+	const char	*value;
+	int		clock;
+	int		ns;
+	int		timestamp;
+	int		severity;
+	int		logeventid;
+	int		mtime;
+	int		write_clock;
+	unsigned char	state;
+	unsigned char	flags;		/* see PROXY_HISTORY_FLAG_* */
+}
+zbx_pb_history_t;
+
+int		zbx_pb_init(const char *filename, zbx_uint64_t size, int max_age, char **error);
+void		zbx_pb_destroy(void);
+int		zbx_pb_enabled(void);
+int		zbx_pb_history_add(const zbx_pb_history_t *values, int values_num);
+void		zbx_pb_history_db_written(void);
+int		zbx_pb_history_get(zbx_uint64_t lastid, zbx_pb_history_t *values, int values_max);
+void		zbx_pb_history_set_lastid(zbx_uint64_t lastid);
+int		zbx_pb_history_get_delay(zbx_uint64_t lastid);
+zbx_uint64_t	zbx_pb_history_count(void);
+int		zbx_pb_history_get_source(zbx_uint64_t *db_maxid);
+void		zbx_pb_history_set_db_sent(void);
+int		zbx_pb_history_check_overflow(zbx_uint64_t *db_batches);
+int		zbx_pb_history_reset_overflow(zbx_uint64_t db_batches, zbx_uint64_t db_maxid);
+zbx_uint64_t	zbx_pb_get_valueid(void);
+void		zbx_pb_set_valueid(zbx_uint64_t valueid);
+
 #endif
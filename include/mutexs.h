@@ -49,6 +49,19 @@ typedef enum
 #endif
 	ZBX_MUTEX_MODBUS,
 	ZBX_MUTEX_TREND_FUNC,
+	ZBX_MUTEX_HISTORY_STORAGE,
+	ZBX_MUTEX_PROXY_BUFFER,
+	ZBX_MUTEX_CONFIG_EVAL,
+	ZBX_MUTEX_IPC_SHM,
+	/* history cache stripes */
+	ZBX_MUTEX_CACHE_STRIPE_0,
+	ZBX_MUTEX_CACHE_STRIPE_1,
+	ZBX_MUTEX_CACHE_STRIPE_2,
+	ZBX_MUTEX_CACHE_STRIPE_3,
+	ZBX_MUTEX_CACHE_STRIPE_4,
+	ZBX_MUTEX_CACHE_STRIPE_5,
+	ZBX_MUTEX_CACHE_STRIPE_6,
+	ZBX_MUTEX_CACHE_STRIPE_7,
 	/* NOTE: Do not forget to sync changes here with mutex names in diag_add_locks_info()! */
 	ZBX_MUTEX_COUNT
 }
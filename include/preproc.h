@@ -55,7 +55,8 @@ int	zbx_preprocessor_test(unsigned char value_type, const char *value, const zbx
 		const zbx_vector_ptr_t *steps, zbx_vector_ptr_t *results, zbx_vector_ptr_t *history,
 		char **preproc_error, char **error);
 
-int	zbx_preprocessor_get_diag_stats(int *values_num, int *values_preproc_num, char **error);
+int	zbx_preprocessor_get_diag_stats(int *values_num, int *values_preproc_num, zbx_uint64_t *regexp_hits,
+		zbx_uint64_t *regexp_misses, char **error);
 
 
 int	zbx_preprocessor_get_top_items(int limit, zbx_vector_ptr_t *items, char **error);
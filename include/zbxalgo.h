@@ -359,6 +359,18 @@ int	evaluate(double *value, const char *expression, char *error, size_t max_erro
 int	evaluate_unknown(const char *expression, double *value, char *error, size_t max_error_len);
 double	evaluate_string_to_double(const char *in);
 
+/* compiled expressions */
+
+/* returns function value or NULL if not available, Unknown values are returned as ZBX_UNKNOWN double */
+/* with unknown_idx set to the index of message in unknown_msgs vector                               */
+typedef const zbx_variant_t	*(*zbx_eval_function_cb_t)(zbx_uint64_t functionid, void *data, int *unknown_idx);
+
+unsigned char	*zbx_eval_compile(const char *expression);
+zbx_uint32_t	zbx_eval_get_size(const unsigned char *bin);
+void	zbx_eval_get_functionids(const unsigned char *bin, zbx_vector_uint64_t *functionids);
+int	zbx_eval_execute(const unsigned char *bin, unsigned char trigger_value, zbx_eval_function_cb_t function_cb,
+		void *data, double *value, char *error, size_t max_error_len, const zbx_vector_ptr_t *unknown_msgs);
+
 /* forecasting */
 
 #define ZBX_MATH_ERROR	-1.0
@@ -100,7 +100,7 @@ const char	*zbx_db_last_strerr(void);
 int	zbx_dbms_get_version(void);
 #endif
 
-#ifdef HAVE_ORACLE
+#if defined(HAVE_ORACLE) || defined(HAVE_MYSQL)
 
 /* context for dynamic parameter binding */
 typedef struct
@@ -124,6 +124,9 @@ int		zbx_db_bind_parameter_dyn(zbx_db_bind_context_t *context, int position, uns
 void		zbx_db_clean_bind_context(zbx_db_bind_context_t *context);
 int		zbx_db_statement_execute(int iters);
 #endif
+#ifdef HAVE_POSTGRESQL
+int		zbx_db_copy(const char *sql, const char *data, size_t size);
+#endif
 int		zbx_db_vexecute(const char *fmt, va_list args);
 DB_RESULT	zbx_db_vselect(const char *fmt, va_list args);
 DB_RESULT	zbx_db_select_n(const char *query, int n);
@@ -33,7 +33,8 @@ typedef enum
 	ZBX_DIAGINFO_PREPROCESSING,
 	ZBX_DIAGINFO_LLD,
 	ZBX_DIAGINFO_ALERTING,
-	ZBX_DIAGINFO_LOCKS
+	ZBX_DIAGINFO_LOCKS,
+	ZBX_DIAGINFO_HISTORYSTORAGE
 }
 zbx_diaginfo_section_t;
 
@@ -43,6 +44,7 @@ zbx_diaginfo_section_t;
 #define ZBX_DIAG_LLD		"lld"
 #define ZBX_DIAG_ALERTING	"alerting"
 #define ZBX_DIAG_LOCKS		"locks"
+#define ZBX_DIAG_HISTORYSTORAGE	"historystorage"
 
 int	zbx_diag_get_info(const struct zbx_json_parse *jp, char **info);
 void	zbx_diag_log_info(unsigned int flags);
@@ -30,6 +30,14 @@ zbx_history_record_t;
 
 ZBX_VECTOR_DECL(history_record, zbx_history_record_t)
 
+/* the history values of an item read by multiple item requests */
+typedef struct
+{
+	zbx_uint64_t			itemid;
+	zbx_vector_history_record_t	values;
+}
+zbx_history_item_values_t;
+
 void	zbx_history_record_vector_clean(zbx_vector_history_record_t *vector, int value_type);
 void	zbx_history_record_vector_destroy(zbx_vector_history_record_t *vector, int value_type);
 void	zbx_history_record_clear(zbx_history_record_t *value, int value_type);
@@ -53,8 +61,25 @@ void	zbx_history_destroy(void);
 int	zbx_history_add_values(const zbx_vector_ptr_t *history);
 int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
+int	zbx_history_get_values_multi(int value_type, int start, int count, int end, zbx_hashset_t *items);
 
 int	zbx_history_requires_trends(int value_type);
 
+/* history storage bulk writer statistics */
+typedef struct
+{
+	zbx_uint64_t	requests;	/* completed bulk requests             */
+	zbx_uint64_t	values;		/* values stored                       */
+	zbx_uint64_t	bytes;		/* request body bytes sent             */
+	zbx_uint64_t	retried;	/* values queued for resending         */
+	zbx_uint64_t	rejected;	/* values rejected by the storage      */
+	zbx_uint64_t	throttled;	/* values rejected with HTTP 429       */
+	double		time;		/* total bulk request time in seconds  */
+	double		time_max;	/* longest bulk request time           */
+}
+zbx_history_storage_stats_t;
+
+void	zbx_history_get_storage_stats(zbx_history_storage_stats_t *stats);
+
 
 #endif
@@ -175,6 +175,10 @@
 #define ZBX_PROTO_TAG_EXPRESSIONS		"expressions"
 #define ZBX_PROTO_TAG_EXPRESSION		"expression"
 #define ZBX_PROTO_TAG_CLIENTIP			"clientip"
+#define ZBX_PROTO_TAG_CONFIG_REVISION		"config_revision"
+#define ZBX_PROTO_TAG_BUCKETS			"buckets"
+#define ZBX_PROTO_TAG_DIGESTS			"digests"
+#define ZBX_PROTO_TAG_CHANGED			"changed"
 
 #define ZBX_PROTO_VALUE_FAILED		"failed"
 #define ZBX_PROTO_VALUE_SUCCESS		"success"
@@ -184,6 +188,7 @@
 #define ZBX_PROTO_VALUE_PROXY_HEARTBEAT		"proxy heartbeat"
 #define ZBX_PROTO_VALUE_SENDER_DATA		"sender data"
 #define ZBX_PROTO_VALUE_AGENT_DATA		"agent data"
+#define ZBX_PROTO_VALUE_PASSIVE_CHECKS		"passive checks"
 #define ZBX_PROTO_VALUE_COMMAND			"command"
 #define ZBX_PROTO_VALUE_JAVA_GATEWAY_INTERNAL	"java gateway internal"
 #define ZBX_PROTO_VALUE_JAVA_GATEWAY_JMX	"java gateway jmx"
@@ -303,4 +308,10 @@ void	zbx_jsonpath_clear(zbx_jsonpath_t *jsonpath);
 int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath);
 int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output);
 
+typedef struct zbx_jsonpath_index zbx_jsonpath_index_t;
+
+zbx_jsonpath_index_t	*zbx_jsonpath_index_create(const struct zbx_json_parse *jp);
+void	zbx_jsonpath_index_free(zbx_jsonpath_index_t *index);
+int	zbx_jsonpath_query_index(const zbx_jsonpath_index_t *index, const char *path, char **output);
+
 #endif /* ZABBIX_ZJSON_H */
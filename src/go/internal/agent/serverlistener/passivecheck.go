@@ -20,14 +20,37 @@
 package serverlistener
 
 import (
+	"encoding/json"
+	"sync"
 	"time"
 
 	"zabbix.com/internal/agent"
 	"zabbix.com/internal/agent/scheduler"
 	"zabbix.com/pkg/log"
+	"zabbix.com/pkg/version"
 )
 
 const notsupported = "ZBX_NOTSUPPORTED"
+const passiveChecksRequest = "passive checks"
+
+type passiveChecksRow struct {
+	Key string `json:"key"`
+}
+
+type passiveChecks struct {
+	Request string             `json:"request"`
+	Data    []passiveChecksRow `json:"data"`
+}
+
+type passiveChecksResult struct {
+	Value *string `json:"value,omitempty"`
+	Error *string `json:"error,omitempty"`
+}
+
+type passiveChecksResponse struct {
+	Version string                `json:"version"`
+	Data    []passiveChecksResult `json:"data"`
+}
 
 type passiveCheck struct {
 	conn      *passiveConnection
@@ -41,7 +64,68 @@ func (pc *passiveCheck) formatError(msg string) (data []byte) {
 	return
 }
 
+// parseChecks returns multiple passive checks request or nil if data contains single item key.
+func parseChecks(data []byte) (request *passiveChecks) {
+	// item keys cannot start with '{', so JSON requests do not clash with single key requests
+	if len(data) == 0 || data[0] != '{' {
+		return nil
+	}
+
+	var checks passiveChecks
+	if err := json.Unmarshal(data, &checks); err != nil || checks.Request != passiveChecksRequest {
+		return nil
+	}
+
+	return &checks
+}
+
+// handleChecks performs multiple passive checks concurrently and responds with their results in request order.
+func (pc *passiveCheck) handleChecks(request *passiveChecks) {
+	response := passiveChecksResponse{
+		Version: version.Long(),
+		Data:    make([]passiveChecksResult, len(request.Data)),
+	}
+
+	var wg sync.WaitGroup
+	for i := range request.Data {
+		if request.Data[i].Key == "" {
+			msg := "Invalid passive check request."
+			response.Data[i].Error = &msg
+			continue
+		}
+
+		wg.Add(1)
+		go func(key string, result *passiveChecksResult) {
+			defer wg.Done()
+
+			// each check is given its own timeout by the scheduler
+			if s, err := pc.scheduler.PerformTask(key, time.Minute, agent.PassiveChecksClientID); err != nil {
+				msg := err.Error()
+				result.Error = &msg
+			} else {
+				result.Value = &s
+			}
+		}(request.Data[i].Key, &response.Data[i])
+	}
+	wg.Wait()
+
+	data, err := json.Marshal(&response)
+	if err == nil {
+		log.Debugf("sending passive checks response: '%s' to '%s'", string(data), pc.conn.Address())
+		_, err = pc.conn.Write(data)
+	}
+
+	if err != nil {
+		log.Debugf("could not send response to server '%s': %s", pc.conn.Address(), err.Error())
+	}
+}
+
 func (pc *passiveCheck) handleCheck(data []byte) {
+	if request := parseChecks(data); request != nil {
+		pc.handleChecks(request)
+		return
+	}
+
 	// direct passive check timeout is handled by the scheduler
 	s, err := pc.scheduler.PerformTask(string(data), time.Minute, agent.PassiveChecksClientID)
 
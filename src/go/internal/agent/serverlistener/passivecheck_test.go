@@ -44,3 +44,20 @@ func TestFormatError(t *testing.T) {
 		return
 	}
 }
+
+func TestParseChecks(t *testing.T) {
+	request := parseChecks([]byte(`{"request":"passive checks","data":[{"key":"agent.ping"},{"key":"system.uname"}]}`))
+
+	if request == nil {
+		t.Fatalf("Expected multiple passive checks request to be parsed")
+	}
+	if len(request.Data) != 2 || request.Data[0].Key != "agent.ping" || request.Data[1].Key != "system.uname" {
+		t.Errorf("Unexpected keys %v", request.Data)
+	}
+
+	for _, data := range []string{"agent.ping", `{"request":"active checks"}`, "{invalid", ""} {
+		if parseChecks([]byte(data)) != nil {
+			t.Errorf("Expected '%s' not to be parsed as multiple passive checks request", data)
+		}
+	}
+}
@@ -952,6 +952,52 @@ static zbx_variant_t	evaluate_term1(int *unknown_idx)
 	return res;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: evaluate_unknown_error                                           *
+ *                                                                            *
+ * Purpose: map Unknown expression result to an error message                 *
+ *                                                                            *
+ * Parameters: unknown_idx   - [IN] index of message in 'unknown_msgs' vector *
+ *             expression    - [IN] the evaluated expression (for logging)    *
+ *             error         - [OUT] error message buffer                     *
+ *             max_error_len - [IN] error buffer size                         *
+ *             unknown_msgs  - [IN] messages about origins of Unknown values  *
+ *                                                                            *
+ ******************************************************************************/
+static void	evaluate_unknown_error(int unknown_idx, const char *expression, char *error, size_t max_error_len,
+		const zbx_vector_ptr_t *unknown_msgs)
+{
+	/* Map Unknown result to error. Callers currently do not operate with ZBX_UNKNOWN. */
+	if (NULL != unknown_msgs)
+	{
+		if (0 > unknown_idx)
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			zabbix_log(LOG_LEVEL_WARNING, "%s() internal error: " ZBX_UNKNOWN_STR " index:%d"
+					" expression:'%s'", __func__, unknown_idx, expression);
+			zbx_snprintf(error, max_error_len, "Internal error: " ZBX_UNKNOWN_STR " index %d."
+					" Please report this to Zabbix developers.", unknown_idx);
+		}
+		else if (unknown_msgs->values_num > unknown_idx)
+		{
+			zbx_snprintf(error, max_error_len, "Cannot evaluate expression: \"%s\".",
+					(char *)(unknown_msgs->values[unknown_idx]));
+		}
+		else
+		{
+			zbx_snprintf(error, max_error_len, "Cannot evaluate expression: unsupported "
+					ZBX_UNKNOWN_STR "%d value.", unknown_idx);
+		}
+	}
+	else
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		/* do not leave garbage in error buffer, write something helpful */
+		zbx_snprintf(error, max_error_len, "%s(): internal error: no message for unknown result", __func__);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Purpose: evaluate an expression like "(26.416>10) or (0=1)"                *
@@ -998,36 +1044,7 @@ int	evaluate(double *value, const char *expression, char *error, size_t max_erro
 
 	if (ZBX_UNKNOWN == *value)
 	{
-		/* Map Unknown result to error. Callers currently do not operate with ZBX_UNKNOWN. */
-		if (NULL != unknown_msgs)
-		{
-			if (0 > unknown_idx)
-			{
-				THIS_SHOULD_NEVER_HAPPEN;
-				zabbix_log(LOG_LEVEL_WARNING, "%s() internal error: " ZBX_UNKNOWN_STR " index:%d"
-						" expression:'%s'", __func__, unknown_idx, expression);
-				zbx_snprintf(error, max_error_len, "Internal error: " ZBX_UNKNOWN_STR " index %d."
-						" Please report this to Zabbix developers.", unknown_idx);
-			}
-			else if (unknown_msgs->values_num > unknown_idx)
-			{
-				zbx_snprintf(error, max_error_len, "Cannot evaluate expression: \"%s\".",
-						(char *)(unknown_msgs->values[unknown_idx]));
-			}
-			else
-			{
-				zbx_snprintf(error, max_error_len, "Cannot evaluate expression: unsupported "
-						ZBX_UNKNOWN_STR "%d value.", unknown_idx);
-			}
-		}
-		else
-		{
-			THIS_SHOULD_NEVER_HAPPEN;
-			/* do not leave garbage in error buffer, write something helpful */
-			zbx_snprintf(error, max_error_len, "%s(): internal error: no message for unknown result",
-					__func__);
-		}
-
+		evaluate_unknown_error(unknown_idx, expression, error, max_error_len, unknown_msgs);
 		*value = ZBX_INFINITY;
 	}
 
@@ -1128,3 +1145,994 @@ double	evaluate_string_to_double(const char *in)
 
 	return result_double_value;
 }
+
+/******************************************************************************
+ *                                                                            *
+ *                      Module for compiled expressions                       *
+ *                   -------------------------------------                    *
+ *                                                                            *
+ * Trigger expressions are compiled into postfix bytecode once, when the      *
+ * configuration cache is synced, and executed directly on function values   *
+ * instead of substituting them into expression text and parsing it again.    *
+ *                                                                            *
+ * Compiler functions compile_termX() follow the same grammar as              *
+ * evaluate_termX() functions and the operations mimic their semantics,       *
+ * including Unknown handling and the order in which errors are reported.     *
+ * Left operands of operators that convert them to numbers before parsing     *
+ * the right operand are followed by explicit ZBX_EVAL_OP_TO_DOUBLE           *
+ * operation for this reason.                                                 *
+ *                                                                            *
+ * Expressions that cannot be compiled (syntax errors, unresolved macros,     *
+ * tokens glued to function references) are left for evaluate().             *
+ *                                                                            *
+ * Bytecode layout: zbx_eval_header_t, array of zbx_eval_op_t, string pool.   *
+ *                                                                            *
+ ******************************************************************************/
+
+#define ZBX_EVAL_OP_NUMBER		0
+#define ZBX_EVAL_OP_STRING		1
+#define ZBX_EVAL_OP_FUNCTIONID		2
+#define ZBX_EVAL_OP_TRIGGER_VALUE	3
+#define ZBX_EVAL_OP_TO_DOUBLE		4
+#define ZBX_EVAL_OP_NEG			5
+#define ZBX_EVAL_OP_NOT			6
+#define ZBX_EVAL_OP_MUL			7
+#define ZBX_EVAL_OP_DIV			8
+#define ZBX_EVAL_OP_ADD			9
+#define ZBX_EVAL_OP_SUB			10
+#define ZBX_EVAL_OP_LT			11
+#define ZBX_EVAL_OP_LE			12
+#define ZBX_EVAL_OP_GE			13
+#define ZBX_EVAL_OP_GT			14
+#define ZBX_EVAL_OP_EQ			15
+#define ZBX_EVAL_OP_NE			16
+#define ZBX_EVAL_OP_AND			17
+#define ZBX_EVAL_OP_OR			18
+
+#define ZBX_EVAL_STACK_STATIC		32
+
+#define ZBX_TRIGGER_VALUE_MACRO		"{TRIGGER.VALUE}"
+
+typedef struct
+{
+	zbx_uint32_t	size;		/* total bytecode size in bytes       */
+	zbx_uint32_t	ops_num;	/* number of operations               */
+	zbx_uint32_t	stack_depth;	/* maximum stack depth when executing */
+	zbx_uint32_t	reserved;
+}
+zbx_eval_header_t;
+
+typedef struct
+{
+	unsigned char	type;
+	union
+	{
+		double		dbl;
+		zbx_uint64_t	ui64;
+		zbx_uint32_t	offset;		/* offset of string in the string pool */
+	}
+	data;
+}
+zbx_eval_op_t;
+
+typedef struct
+{
+	zbx_eval_op_t	*ops;
+	int		ops_num;
+	int		ops_alloc;
+
+	char		*strings;
+	size_t		strings_alloc;
+	size_t		strings_offset;
+
+	int		depth;
+	int		depth_max;
+}
+zbx_eval_compiler_t;
+
+typedef struct
+{
+	zbx_variant_t	value;
+	int		unknown_idx;
+}
+zbx_eval_value_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: append operation to the bytecode being compiled                   *
+ *                                                                            *
+ * Parameters: cmp   - [IN/OUT] the compiler                                  *
+ *             type  - [IN] the operation type                                *
+ *             delta - [IN] the stack depth change after the operation        *
+ *                                                                            *
+ * Return value: the appended operation                                       *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_eval_op_t	*compile_op(zbx_eval_compiler_t *cmp, unsigned char type, int delta)
+{
+	zbx_eval_op_t	*op;
+
+	if (cmp->ops_num == cmp->ops_alloc)
+	{
+		cmp->ops_alloc = (0 == cmp->ops_alloc ? 16 : cmp->ops_alloc * 2);
+		cmp->ops = (zbx_eval_op_t *)zbx_realloc(cmp->ops, sizeof(zbx_eval_op_t) * (size_t)cmp->ops_alloc);
+	}
+
+	op = &cmp->ops[cmp->ops_num++];
+	memset(op, 0, sizeof(zbx_eval_op_t));
+	op->type = type;
+
+	if (cmp->depth_max < (cmp->depth += delta))
+		cmp->depth_max = cmp->depth;
+
+	return op;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile a quoted string like "/etc/passwd"                        *
+ *                                                                            *
+ * Comments: follows evaluate_string() parsing rules                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_string(zbx_eval_compiler_t *cmp)
+{
+	const char	*start;
+	zbx_eval_op_t	*op;
+
+	for (start = ptr; '"' != *ptr; ptr++)
+	{
+		if ('\\' == *ptr)
+		{
+			ptr++;
+
+			if ('\\' != *ptr && '\"' != *ptr)
+				return FAIL;
+		}
+
+		if ('\0' == *ptr)
+			return FAIL;
+	}
+
+	op = compile_op(cmp, ZBX_EVAL_OP_STRING, 1);
+	op->data.offset = (zbx_uint32_t)cmp->strings_offset;
+
+	for (; start != ptr; start++)
+	{
+		switch (*start)
+		{
+			case '\\':
+				start++;
+				break;
+			case '\r':
+				continue;
+		}
+
+		zbx_chrcpy_alloc(&cmp->strings, &cmp->strings_alloc, &cmp->strings_offset, *start);
+	}
+
+	/* keep terminating zero in the string pool */
+	zbx_str_memcpy_alloc(&cmp->strings, &cmp->strings_alloc, &cmp->strings_offset, "", 1);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile function reference like {12345} or {TRIGGER.VALUE} macro *
+ *                                                                            *
+ * Comments: The referenced values are substituted into expression text by    *
+ *           evaluate_expressions() without parentheses when they are plain  *
+ *           numbers, so the same delimiter rules as for numeric tokens       *
+ *           apply.                                                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_reference(zbx_eval_compiler_t *cmp)
+{
+	const char	*br;
+	zbx_uint64_t	functionid;
+
+	if (0 == strncmp(ptr, ZBX_TRIGGER_VALUE_MACRO, ZBX_CONST_STRLEN(ZBX_TRIGGER_VALUE_MACRO)))
+	{
+		ptr += ZBX_CONST_STRLEN(ZBX_TRIGGER_VALUE_MACRO);
+		compile_op(cmp, ZBX_EVAL_OP_TRIGGER_VALUE, 1);
+	}
+	else
+	{
+		if (NULL == (br = strchr(ptr, '}')) || SUCCEED != is_uint64_n(ptr + 1, br - ptr - 1, &functionid))
+			return FAIL;
+
+		ptr = br + 1;
+		compile_op(cmp, ZBX_EVAL_OP_FUNCTIONID, 1)->data.ui64 = functionid;
+	}
+
+	return is_number_delimiter(*ptr);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile a suffixed number like 12.345K                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_number(zbx_eval_compiler_t *cmp)
+{
+	int	len;
+
+	if (SUCCEED != zbx_suffixed_number_parse(ptr, &len) || SUCCEED != is_number_delimiter(*(ptr + len)))
+		return FAIL;
+
+	compile_op(cmp, ZBX_EVAL_OP_NUMBER, 1)->data.dbl = atof(ptr) * suffix2factor(*(ptr + len - 1));
+	ptr += len;
+
+	return SUCCEED;
+}
+
+static int	compile_term1(zbx_eval_compiler_t *cmp);
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile an operand or a parenthesized expression                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term9(zbx_eval_compiler_t *cmp)
+{
+	while (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr)
+		ptr++;
+
+	switch (*ptr)
+	{
+		case '\0':
+			return FAIL;
+		case '(':
+			ptr++;
+
+			if (SUCCEED != compile_term1(cmp) || ')' != *ptr)
+				return FAIL;
+
+			ptr++;
+			break;
+		case '"':
+			ptr++;
+
+			if (SUCCEED != compile_string(cmp))
+				return FAIL;
+
+			ptr++;
+
+			if (FAIL == is_operator_delimiter(*ptr) && FAIL == is_number_delimiter(*ptr))
+				return FAIL;
+			break;
+		case '{':
+			if (SUCCEED != compile_reference(cmp))
+				return FAIL;
+			break;
+		default:
+			if (SUCCEED != compile_number(cmp))
+				return FAIL;
+	}
+
+	while ('\0' != *ptr && (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr))
+		ptr++;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "-" (unary)                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term8(zbx_eval_compiler_t *cmp)
+{
+	while (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr)
+		ptr++;
+
+	if ('-' != *ptr)
+		return compile_term9(cmp);
+
+	ptr++;
+
+	if (SUCCEED != compile_term9(cmp))
+		return FAIL;
+
+	compile_op(cmp, ZBX_EVAL_OP_NEG, 0);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "not"                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term7(zbx_eval_compiler_t *cmp)
+{
+	while (' ' == *ptr || '\r' == *ptr || '\n' == *ptr || '\t' == *ptr)
+		ptr++;
+
+	if ('n' != ptr[0] || 'o' != ptr[1] || 't' != ptr[2] || SUCCEED != is_operator_delimiter(ptr[3]))
+		return compile_term8(cmp);
+
+	ptr += 3;
+
+	if (SUCCEED != compile_term8(cmp))
+		return FAIL;
+
+	compile_op(cmp, ZBX_EVAL_OP_NOT, 0);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "*" and "/"                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term6(zbx_eval_compiler_t *cmp)
+{
+	unsigned char	type;
+
+	if (SUCCEED != compile_term7(cmp))
+		return FAIL;
+
+	while ('*' == *ptr || '/' == *ptr)
+	{
+		type = ('*' == *ptr++ ? ZBX_EVAL_OP_MUL : ZBX_EVAL_OP_DIV);
+		compile_op(cmp, ZBX_EVAL_OP_TO_DOUBLE, 0);
+
+		if (SUCCEED != compile_term7(cmp))
+			return FAIL;
+
+		compile_op(cmp, type, -1);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "+" and "-"                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term5(zbx_eval_compiler_t *cmp)
+{
+	unsigned char	type;
+
+	if (SUCCEED != compile_term6(cmp))
+		return FAIL;
+
+	while ('+' == *ptr || '-' == *ptr)
+	{
+		type = ('+' == *ptr++ ? ZBX_EVAL_OP_ADD : ZBX_EVAL_OP_SUB);
+		compile_op(cmp, ZBX_EVAL_OP_TO_DOUBLE, 0);
+
+		if (SUCCEED != compile_term6(cmp))
+			return FAIL;
+
+		compile_op(cmp, type, -1);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "<", "<=", ">=", ">"                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term4(zbx_eval_compiler_t *cmp)
+{
+	unsigned char	type;
+
+	if (SUCCEED != compile_term5(cmp))
+		return FAIL;
+
+	while (1)
+	{
+		if ('<' == ptr[0] && '=' == ptr[1])
+		{
+			type = ZBX_EVAL_OP_LE;
+			ptr += 2;
+		}
+		else if ('>' == ptr[0] && '=' == ptr[1])
+		{
+			type = ZBX_EVAL_OP_GE;
+			ptr += 2;
+		}
+		else if ('<' == ptr[0] && '>' != ptr[1])
+		{
+			type = ZBX_EVAL_OP_LT;
+			ptr++;
+		}
+		else if ('>' == ptr[0])
+		{
+			type = ZBX_EVAL_OP_GT;
+			ptr++;
+		}
+		else
+			break;
+
+		compile_op(cmp, ZBX_EVAL_OP_TO_DOUBLE, 0);
+
+		if (SUCCEED != compile_term5(cmp))
+			return FAIL;
+
+		compile_op(cmp, type, -1);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "=" and "<>"                                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term3(zbx_eval_compiler_t *cmp)
+{
+	unsigned char	type;
+
+	if (SUCCEED != compile_term4(cmp))
+		return FAIL;
+
+	while (1)
+	{
+		if ('=' == *ptr)
+		{
+			type = ZBX_EVAL_OP_EQ;
+			ptr++;
+		}
+		else if ('<' == ptr[0] && '>' == ptr[1])
+		{
+			type = ZBX_EVAL_OP_NE;
+			ptr += 2;
+		}
+		else
+			break;
+
+		/* equality operators do not convert the left operand */
+
+		if (SUCCEED != compile_term4(cmp))
+			return FAIL;
+
+		compile_op(cmp, type, -1);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "and"                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term2(zbx_eval_compiler_t *cmp)
+{
+	if (SUCCEED != compile_term3(cmp))
+		return FAIL;
+
+	while ('a' == ptr[0] && 'n' == ptr[1] && 'd' == ptr[2] && SUCCEED == is_operator_delimiter(ptr[3]))
+	{
+		ptr += 3;
+		compile_op(cmp, ZBX_EVAL_OP_TO_DOUBLE, 0);
+
+		if (SUCCEED != compile_term3(cmp))
+			return FAIL;
+
+		compile_op(cmp, ZBX_EVAL_OP_AND, -1);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: compile "or"                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	compile_term1(zbx_eval_compiler_t *cmp)
+{
+	if (32 < ++level)
+		return FAIL;
+
+	if (SUCCEED != compile_term2(cmp))
+		return FAIL;
+
+	while ('o' == ptr[0] && 'r' == ptr[1] && SUCCEED == is_operator_delimiter(ptr[2]))
+	{
+		ptr += 2;
+		compile_op(cmp, ZBX_EVAL_OP_TO_DOUBLE, 0);
+
+		if (SUCCEED != compile_term2(cmp))
+			return FAIL;
+
+		compile_op(cmp, ZBX_EVAL_OP_OR, -1);
+	}
+
+	level--;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_eval_compile                                                 *
+ *                                                                            *
+ * Purpose: compile expression like "({15}>10) or ({123}=1)" into bytecode    *
+ *                                                                            *
+ * Parameters: expression - [IN] the expression with expanded user macros    *
+ *                                                                            *
+ * Return value: The compiled expression or NULL if the expression cannot be  *
+ *               compiled and must be evaluated with evaluate() function.     *
+ *                                                                            *
+ * Comments: The returned bytecode must be freed by the caller.               *
+ *                                                                            *
+ ******************************************************************************/
+unsigned char	*zbx_eval_compile(const char *expression)
+{
+	zbx_eval_compiler_t	cmp;
+	zbx_eval_header_t	header;
+	unsigned char		*bin = NULL;
+	size_t			ops_size;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() expression:'%s'", __func__, expression);
+
+	memset(&cmp, 0, sizeof(cmp));
+
+	ptr = expression;
+	level = 0;
+
+	if (SUCCEED != compile_term1(&cmp) || '\0' != *ptr)
+		goto out;
+
+	ops_size = sizeof(zbx_eval_op_t) * (size_t)cmp.ops_num;
+
+	header.size = (zbx_uint32_t)(sizeof(zbx_eval_header_t) + ops_size + cmp.strings_offset);
+	header.ops_num = (zbx_uint32_t)cmp.ops_num;
+	header.stack_depth = (zbx_uint32_t)cmp.depth_max;
+	header.reserved = 0;
+
+	bin = (unsigned char *)zbx_malloc(NULL, header.size);
+	memcpy(bin, &header, sizeof(zbx_eval_header_t));
+	memcpy(bin + sizeof(zbx_eval_header_t), cmp.ops, ops_size);
+
+	if (0 != cmp.strings_offset)
+		memcpy(bin + sizeof(zbx_eval_header_t) + ops_size, cmp.strings, cmp.strings_offset);
+out:
+	zbx_free(cmp.strings);
+	zbx_free(cmp.ops);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() ops:%d", __func__, NULL == bin ? -1 : cmp.ops_num);
+
+	return bin;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_eval_get_size                                                *
+ *                                                                            *
+ * Purpose: get compiled expression size in bytes                             *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_eval_get_size(const unsigned char *bin)
+{
+	return ((const zbx_eval_header_t *)bin)->size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_eval_get_functionids                                         *
+ *                                                                            *
+ * Purpose: get identifiers of functions referenced by compiled expression    *
+ *                                                                            *
+ * Parameters: bin         - [IN] the compiled expression                     *
+ *             functionids - [OUT] the function identifiers in the order they *
+ *                                 appear in the expression                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_eval_get_functionids(const unsigned char *bin, zbx_vector_uint64_t *functionids)
+{
+	const zbx_eval_header_t	*header = (const zbx_eval_header_t *)bin;
+	const zbx_eval_op_t	*op = (const zbx_eval_op_t *)(bin + sizeof(zbx_eval_header_t));
+	zbx_uint32_t		i;
+
+	for (i = 0; i < header->ops_num; i++)
+	{
+		if (ZBX_EVAL_OP_FUNCTIONID == op[i].type)
+			zbx_vector_uint64_append(functionids, op[i].data.ui64);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: push function value on the stack in the same way as it would be   *
+ *          parsed after substituting it into expression text                 *
+ *                                                                            *
+ * Parameters: result - [IN] the function value                               *
+ *             value  - [OUT] the stack value                                 *
+ *                                                                            *
+ * Comments: String values are substituted as quoted strings in parentheses,  *
+ *           so the only difference from the original is dropped '\r'.       *
+ *           Non-finite numbers are printed and parsed to get the same error. *
+ *                                                                            *
+ ******************************************************************************/
+static void	execute_function_value(const zbx_variant_t *result, zbx_eval_value_t *value)
+{
+	char	text[ZBX_MAX_DOUBLE_LEN + 1];
+
+	switch (result->type)
+	{
+		case ZBX_VARIANT_UI64:
+			zbx_variant_set_dbl(&value->value, (double)result->data.ui64);
+			return;
+		case ZBX_VARIANT_STR:
+			zbx_variant_set_str(&value->value, zbx_strdup(NULL, result->data.str));
+			zbx_remove_chars(value->value.data.str, "\r");
+			return;
+		case ZBX_VARIANT_DBL:
+			if (ZBX_UNKNOWN == result->data.dbl || (ZBX_INFINITY > result->data.dbl &&
+					ZBX_UNKNOWN < result->data.dbl))
+			{
+				zbx_variant_set_dbl(&value->value, result->data.dbl);
+				return;
+			}
+			break;
+		default:
+			zbx_strlcpy(buffer, "Unexpected error while processing a trigger expression", max_buffer_len);
+			zbx_variant_set_dbl(&value->value, ZBX_INFINITY);
+			return;
+	}
+
+	zbx_snprintf(text, sizeof(text), ZBX_FS_DBL64, result->data.dbl);
+	ptr = text;
+	level = 0;
+	value->value = evaluate_term1(&value->unknown_idx);
+
+	if (ZBX_VARIANT_DBL == value->value.type && ZBX_INFINITY == value->value.data.dbl)
+		return;
+
+	if ('\0' != *ptr)
+	{
+		zbx_snprintf(buffer, max_buffer_len, "Cannot evaluate expression: expected closing parenthesis at"
+				" \"%s\".", ptr);
+		zbx_variant_clear(&value->value);
+		zbx_variant_set_dbl(&value->value, ZBX_INFINITY);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute binary arithmetic and relational operations               *
+ *                                                                            *
+ * Parameters: type  - [IN] the operation type                                *
+ *             left  - [IN/OUT] the left operand, converted to double by      *
+ *                              preceding ZBX_EVAL_OP_TO_DOUBLE operation,    *
+ *                              result on exit                                *
+ *             right - [IN] the right operand                                 *
+ *                                                                            *
+ * Comments: see evaluate_term6(), evaluate_term5() and evaluate_term4()      *
+ *                                                                            *
+ ******************************************************************************/
+static void	execute_arithmetic(unsigned char type, zbx_eval_value_t *left, zbx_eval_value_t *right)
+{
+	double	l, r;
+
+	variant_convert_to_double(&right->value);
+
+	if (ZBX_INFINITY == (r = right->value.data.dbl))
+	{
+		left->value.data.dbl = ZBX_INFINITY;
+		return;
+	}
+
+	if (ZBX_EVAL_OP_DIV == type && ZBX_UNKNOWN != r && SUCCEED == zbx_double_compare(r, 0.0))
+	{
+		zbx_strlcpy(buffer, "Cannot evaluate expression: division by zero.", max_buffer_len);
+		left->value.data.dbl = ZBX_INFINITY;
+		return;
+	}
+
+	if (ZBX_UNKNOWN == r)
+	{
+		left->unknown_idx = right->unknown_idx;
+		left->value.data.dbl = ZBX_UNKNOWN;
+		return;
+	}
+
+	if (ZBX_UNKNOWN == (l = left->value.data.dbl))
+		return;
+
+	switch (type)
+	{
+		case ZBX_EVAL_OP_MUL:
+			left->value.data.dbl = l * r;
+			break;
+		case ZBX_EVAL_OP_DIV:
+			left->value.data.dbl = l / r;
+			break;
+		case ZBX_EVAL_OP_ADD:
+			left->value.data.dbl = l + r;
+			break;
+		case ZBX_EVAL_OP_SUB:
+			left->value.data.dbl = l - r;
+			break;
+		case ZBX_EVAL_OP_LT:
+			left->value.data.dbl = (l < r - ZBX_DOUBLE_EPSILON);
+			break;
+		case ZBX_EVAL_OP_LE:
+			left->value.data.dbl = (l <= r + ZBX_DOUBLE_EPSILON);
+			break;
+		case ZBX_EVAL_OP_GE:
+			left->value.data.dbl = (l >= r - ZBX_DOUBLE_EPSILON);
+			break;
+		case ZBX_EVAL_OP_GT:
+			left->value.data.dbl = (l > r + ZBX_DOUBLE_EPSILON);
+			break;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute "=" and "<>" operations                                   *
+ *                                                                            *
+ * Comments: see evaluate_term3()                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	execute_equality(unsigned char type, zbx_eval_value_t *left, zbx_eval_value_t *right)
+{
+	double	l, r, value;
+
+	if (ZBX_VARIANT_DBL == right->value.type && ZBX_INFINITY == right->value.data.dbl)
+	{
+		zbx_variant_clear(&left->value);
+		zbx_variant_set_dbl(&left->value, ZBX_INFINITY);
+		return;
+	}
+
+	if (ZBX_VARIANT_DBL == left->value.type && ZBX_UNKNOWN == left->value.data.dbl)
+		return;
+
+	if (ZBX_VARIANT_DBL == right->value.type && ZBX_UNKNOWN == right->value.data.dbl)
+	{
+		zbx_variant_clear(&left->value);
+		*left = *right;
+		zbx_variant_set_none(&right->value);
+		return;
+	}
+
+	l = variant_get_double(&left->value);
+	r = variant_get_double(&right->value);
+
+	if (ZBX_INFINITY != l && ZBX_INFINITY != r)
+	{
+		value = (SUCCEED == zbx_double_compare(l, r) ? 1 : 0);
+	}
+	else if (ZBX_VARIANT_DBL == left->value.type || ZBX_VARIANT_DBL == right->value.type)
+	{
+		value = 0;
+	}
+	else
+		value = !strcmp(left->value.data.str, right->value.data.str);
+
+	if (ZBX_EVAL_OP_NE == type)
+		value = (SUCCEED == zbx_double_compare(value, 0.0) ? 1.0 : 0.0);
+
+	zbx_variant_clear(&left->value);
+	zbx_variant_set_dbl(&left->value, value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Purpose: execute "and" and "or" operations                                 *
+ *                                                                            *
+ * Comments: see evaluate_term2() and evaluate_term1()                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	execute_logical(unsigned char type, zbx_eval_value_t *left, zbx_eval_value_t *right)
+{
+	double	l, r;
+	int	l_set, r_set;
+
+	variant_convert_to_double(&right->value);
+
+	if (ZBX_INFINITY == (r = right->value.data.dbl))
+	{
+		left->value.data.dbl = ZBX_INFINITY;
+		return;
+	}
+
+	l = left->value.data.dbl;
+
+	/* "and" is decided by zero operands, "or" by non-zero operands */
+	if (ZBX_EVAL_OP_AND == type)
+	{
+		l_set = (ZBX_UNKNOWN != l && SUCCEED == zbx_double_compare(l, 0.0));
+		r_set = (ZBX_UNKNOWN != r && SUCCEED == zbx_double_compare(r, 0.0));
+	}
+	else
+	{
+		l_set = (ZBX_UNKNOWN != l && SUCCEED != zbx_double_compare(l, 0.0));
+		r_set = (ZBX_UNKNOWN != r && SUCCEED != zbx_double_compare(r, 0.0));
+	}
+
+	if (ZBX_UNKNOWN == l || ZBX_UNKNOWN == r)
+	{
+		if (0 != l_set || 0 != r_set)
+			left->value.data.dbl = (ZBX_EVAL_OP_AND == type ? 0.0 : 1.0);
+		else if (ZBX_UNKNOWN == r)
+		{
+			left->unknown_idx = right->unknown_idx;
+			left->value.data.dbl = ZBX_UNKNOWN;
+		}
+
+		return;
+	}
+
+	if (ZBX_EVAL_OP_AND == type)
+		left->value.data.dbl = (0 == l_set && 0 == r_set);
+	else
+		left->value.data.dbl = (0 != l_set || 0 != r_set);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_eval_execute                                                 *
+ *                                                                            *
+ * Purpose: evaluate compiled expression                                      *
+ *                                                                            *
+ * Parameters: bin            - [IN] the compiled expression                  *
+ *             trigger_value  - [IN] the {TRIGGER.VALUE} macro value          *
+ *             function_cb    - [IN] the callback returning function value    *
+ *                                   by functionid                            *
+ *             data           - [IN] the callback data                        *
+ *             value          - [OUT] the expression evaluation result        *
+ *             error          - [OUT] error message buffer                    *
+ *             max_error_len  - [IN] error buffer size                        *
+ *             unknown_msgs   - [IN] messages about origins of Unknown values *
+ *                                                                            *
+ * Return value: SUCCEED - expression evaluated successfully                  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Function values are returned by callback as typed values -       *
+ *           numbers, unquoted strings or Unknown values.                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_eval_execute(const unsigned char *bin, unsigned char trigger_value, zbx_eval_function_cb_t function_cb,
+		void *data, double *value, char *error, size_t max_error_len, const zbx_vector_ptr_t *unknown_msgs)
+{
+	const zbx_eval_header_t	*header = (const zbx_eval_header_t *)bin;
+	const zbx_eval_op_t	*op, *ops = (const zbx_eval_op_t *)(bin + sizeof(zbx_eval_header_t));
+	const char		*strings = (const char *)(ops + header->ops_num);
+	const zbx_variant_t	*result;
+	zbx_eval_value_t	stack_static[ZBX_EVAL_STACK_STATIC], *stack = stack_static, *top, *right;
+	zbx_uint32_t		i;
+	int			depth = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() ops:%u", __func__, header->ops_num);
+
+	buffer = error;
+	max_buffer_len = max_error_len;
+	*value = ZBX_INFINITY;
+
+	if (ZBX_EVAL_STACK_STATIC < header->stack_depth)
+		stack = (zbx_eval_value_t *)zbx_malloc(NULL, sizeof(zbx_eval_value_t) * header->stack_depth);
+
+	for (i = 0; i < header->ops_num; i++)
+	{
+		op = &ops[i];
+
+		switch (op->type)
+		{
+			case ZBX_EVAL_OP_NUMBER:
+				top = &stack[depth++];
+				zbx_variant_set_dbl(&top->value, op->data.dbl);
+				top->unknown_idx = -1;
+				break;
+			case ZBX_EVAL_OP_STRING:
+				top = &stack[depth++];
+				zbx_variant_set_str(&top->value, zbx_strdup(NULL, strings + op->data.offset));
+				top->unknown_idx = -1;
+				break;
+			case ZBX_EVAL_OP_TRIGGER_VALUE:
+				top = &stack[depth++];
+				zbx_variant_set_dbl(&top->value, trigger_value);
+				top->unknown_idx = -1;
+				break;
+			case ZBX_EVAL_OP_FUNCTIONID:
+				top = &stack[depth++];
+				top->unknown_idx = -1;
+
+				if (NULL == (result = function_cb(op->data.ui64, data, &top->unknown_idx)))
+				{
+					zbx_strlcpy(buffer, "Unexpected error while processing a trigger expression",
+							max_buffer_len);
+					zbx_variant_set_dbl(&top->value, ZBX_INFINITY);
+					break;
+				}
+
+				execute_function_value(result, top);
+				break;
+			case ZBX_EVAL_OP_TO_DOUBLE:
+				top = &stack[depth - 1];
+				variant_convert_to_double(&top->value);
+				break;
+			case ZBX_EVAL_OP_NEG:
+				top = &stack[depth - 1];
+				variant_convert_to_double(&top->value);
+
+				if (ZBX_UNKNOWN != top->value.data.dbl && ZBX_INFINITY != top->value.data.dbl)
+					top->value.data.dbl = -top->value.data.dbl;
+				break;
+			case ZBX_EVAL_OP_NOT:
+				top = &stack[depth - 1];
+				variant_convert_to_double(&top->value);
+
+				if (ZBX_UNKNOWN != top->value.data.dbl && ZBX_INFINITY != top->value.data.dbl)
+				{
+					top->value.data.dbl = (SUCCEED == zbx_double_compare(top->value.data.dbl, 0.0) ?
+							1.0 : 0.0);
+				}
+				break;
+			default:
+				right = &stack[--depth];
+				top = &stack[depth - 1];
+
+				switch (op->type)
+				{
+					case ZBX_EVAL_OP_EQ:
+					case ZBX_EVAL_OP_NE:
+						execute_equality(op->type, top, right);
+						break;
+					case ZBX_EVAL_OP_AND:
+					case ZBX_EVAL_OP_OR:
+						execute_logical(op->type, top, right);
+						break;
+					default:
+						execute_arithmetic(op->type, top, right);
+				}
+
+				zbx_variant_clear(&right->value);
+		}
+
+		/* errors are not recoverable by any operation, stop at the first one like evaluate() does */
+		if (ZBX_VARIANT_DBL == top->value.type && ZBX_INFINITY == top->value.data.dbl)
+			goto out;
+	}
+
+	top = &stack[0];
+
+	if (ZBX_VARIANT_STR == top->value.type)
+	{
+		if ('\0' == *top->value.data.str)
+		{
+			zbx_strlcpy(buffer, "Cannot evaluate expression: unexpected end of expression.", max_buffer_len);
+			goto out;
+		}
+
+		variant_convert_to_double(&top->value);
+	}
+
+	*value = top->value.data.dbl;
+
+	if (ZBX_UNKNOWN == *value)
+	{
+		evaluate_unknown_error(top->unknown_idx, "<compiled>", error, max_error_len, unknown_msgs);
+		*value = ZBX_INFINITY;
+	}
+out:
+	while (0 < depth)
+		zbx_variant_clear(&stack[--depth].value);
+
+	if (stack != stack_static)
+		zbx_free(stack);
+
+	if (ZBX_INFINITY == *value)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "End of %s() error:'%s'", __func__, error);
+		return FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() value:" ZBX_FS_DBL, __func__, *value);
+
+	return SUCCEED;
+}
@@ -1355,6 +1355,10 @@ const char	*get_process_type_string(unsigned char proc_type)
 			return "lld worker";
 		case ZBX_PROCESS_TYPE_ALERTSYNCER:
 			return "alert syncer";
+		case ZBX_PROCESS_TYPE_AGENTPOLLER:
+			return "agent poller";
+		case ZBX_PROCESS_TYPE_SNMPPOLLER:
+			return "snmp poller";
 	}
 
 	THIS_SHOULD_NEVER_HAPPEN;
@@ -797,6 +797,137 @@ static ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len)
 	return res;
 }
 
+#define ZBX_TCP_HEADER_DATA	"ZBXD"
+#define ZBX_TCP_HEADER_LEN	ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA)
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_send_context_init                                        *
+ *                                                                            *
+ * Purpose: prepare Zabbix protocol header and data to be sent                *
+ *                                                                            *
+ * Parameters: data    - [IN] the data to send                                *
+ *             len     - [IN] the data length                                 *
+ *             flags   - [IN] the protocol flags                              *
+ *             context - [OUT] the send context                               *
+ *                                                                            *
+ * Return value: SUCCEED - the context was initialized                        *
+ *               FAIL - the data could not be compressed                      *
+ *                                                                            *
+ * Comments: The data is referenced by context and must be kept until it is   *
+ *           sent. The context must be cleared with                           *
+ *           zbx_tcp_send_context_clear().                                    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_send_context_init(const char *data, size_t len, unsigned char flags, zbx_tcp_send_context_t *context)
+{
+	size_t		reserved = 0;
+	zbx_uint32_t	len32_le;
+
+	context->data = data;
+	context->compressed_data = NULL;
+	context->send_len = len;
+	context->written = 0;
+	context->header_len = 0;
+
+	if (0 == (flags & ZBX_TCP_PROTOCOL))
+		return SUCCEED;
+
+	if (0 != (flags & ZBX_TCP_COMPRESS))
+	{
+		if (SUCCEED != zbx_compress(data, len, &context->compressed_data, &context->send_len))
+		{
+			zbx_set_socket_strerror("cannot compress data: %s", zbx_compress_strerror());
+			return FAIL;
+		}
+
+		context->data = context->compressed_data;
+		reserved = len;
+	}
+
+	memcpy(context->header_buf, ZBX_TCP_HEADER_DATA, ZBX_TCP_HEADER_LEN);
+	context->header_len = ZBX_TCP_HEADER_LEN;
+
+	context->header_buf[context->header_len++] = flags;
+
+	len32_le = zbx_htole_uint32((zbx_uint32_t)context->send_len);
+	memcpy(context->header_buf + context->header_len, &len32_le, sizeof(len32_le));
+	context->header_len += sizeof(len32_le);
+
+	len32_le = zbx_htole_uint32((zbx_uint32_t)reserved);
+	memcpy(context->header_buf + context->header_len, &len32_le, sizeof(len32_le));
+	context->header_len += sizeof(len32_le);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_send_context_clear                                       *
+ *                                                                            *
+ * Purpose: free resources allocated by send context                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_tcp_send_context_clear(zbx_tcp_send_context_t *context)
+{
+	zbx_free(context->compressed_data);
+}
+
+#ifndef _WINDOWS
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_send_context                                             *
+ *                                                                            *
+ * Purpose: send as much of prepared data as non-blocking socket accepts      *
+ *                                                                            *
+ * Parameters: s       - [IN] the non-blocking unencrypted socket             *
+ *             context - [IN/OUT] the send context                            *
+ *                                                                            *
+ * Return value: SUCCEED - all data was sent                                  *
+ *               FAIL - an error occurred                                     *
+ *               ZBX_TCP_AGAIN - the socket must become writable before       *
+ *                               sending the rest of data                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_send_context(zbx_socket_t *s, zbx_tcp_send_context_t *context)
+{
+	const char	*buf;
+	size_t		len;
+	ssize_t		bytes_sent;
+	int		err;
+
+	while (context->written < context->header_len + context->send_len)
+	{
+		if (context->written < context->header_len)
+		{
+			buf = context->header_buf + context->written;
+			len = context->header_len - context->written;
+		}
+		else
+		{
+			buf = context->data + context->written - context->header_len;
+			len = context->send_len - (context->written - context->header_len);
+		}
+
+		if (ZBX_PROTO_ERROR == (bytes_sent = ZBX_TCP_WRITE(s->socket, buf, len)))
+		{
+			if (ZBX_PROTO_AGAIN == (err = zbx_socket_last_error()))
+				continue;
+
+			if (EAGAIN == err || EWOULDBLOCK == err)
+				return ZBX_TCP_AGAIN;
+
+			zbx_set_socket_strerror("ZBX_TCP_WRITE() failed: %s", strerror_from_system(err));
+			return FAIL;
+		}
+
+		context->written += (size_t)bytes_sent;
+	}
+
+	return SUCCEED;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_tcp_send_ext                                                 *
@@ -819,60 +950,40 @@ static ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len)
  *     unencrypted messages.                                                  *
  *                                                                            *
  ******************************************************************************/
-
-#define ZBX_TCP_HEADER_DATA	"ZBXD"
-#define ZBX_TCP_HEADER_LEN	ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA)
-
 int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, unsigned char flags, int timeout)
 {
 #define ZBX_TLS_MAX_REC_LEN	16384
 
-	ssize_t		bytes_sent, written = 0;
-	size_t		send_bytes, offset, send_len = len, reserved = 0;
-	int		ret = SUCCEED;
-	char		*compressed_data = NULL;
-	zbx_uint32_t	len32_le;
+	ssize_t			bytes_sent, written = 0;
+	size_t			send_bytes, send_len;
+	int			ret = SUCCEED;
+	zbx_tcp_send_context_t	context;
 
 	if (0 != timeout)
 		zbx_socket_timeout_set(s, timeout);
 
-	if (0 != (flags & ZBX_TCP_PROTOCOL))
+	if (SUCCEED != zbx_tcp_send_context_init(data, len, flags, &context))
+	{
+		ret = FAIL;
+		goto cleanup;
+	}
+
+	data = context.data;
+	send_len = context.send_len;
+
+	if (0 != context.header_len)
 	{
 		size_t	take_bytes;
 		char	header_buf[ZBX_TLS_MAX_REC_LEN];	/* Buffer is allocated on stack with a hope that it   */
 								/* will be short-lived in CPU cache. Static buffer is */
 								/* not used on purpose.				      */
 
-		if (0 != (flags & ZBX_TCP_COMPRESS))
-		{
-			if (SUCCEED != zbx_compress(data, len, &compressed_data, &send_len))
-			{
-				zbx_set_socket_strerror("cannot compress data: %s", zbx_compress_strerror());
-				ret = FAIL;
-				goto cleanup;
-			}
-
-			data = compressed_data;
-			reserved = len;
-		}
-
-		memcpy(header_buf, ZBX_TCP_HEADER_DATA, ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA));
-		offset = ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA);
-
-		header_buf[offset++] = flags;
-
-		len32_le = zbx_htole_uint32((zbx_uint32_t)send_len);
-		memcpy(header_buf + offset, &len32_le, sizeof(len32_le));
-		offset += sizeof(len32_le);
-
-		len32_le = zbx_htole_uint32((zbx_uint32_t)reserved);
-		memcpy(header_buf + offset, &len32_le, sizeof(len32_le));
-		offset += sizeof(len32_le);
+		memcpy(header_buf, context.header_buf, context.header_len);
 
-		take_bytes = MIN(send_len, ZBX_TLS_MAX_REC_LEN - offset);
-		memcpy(header_buf + offset, data, take_bytes);
+		take_bytes = MIN(send_len, ZBX_TLS_MAX_REC_LEN - context.header_len);
+		memcpy(header_buf + context.header_len, data, take_bytes);
 
-		send_bytes = offset + take_bytes;
+		send_bytes = context.header_len + take_bytes;
 
 		while (written < (ssize_t)send_bytes)
 		{
@@ -885,7 +996,7 @@ int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, unsigned cha
 			written += bytes_sent;
 		}
 
-		written -= offset;
+		written -= context.header_len;
 	}
 
 	while (written < (ssize_t)send_len)
@@ -903,7 +1014,7 @@ int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, unsigned cha
 		written += bytes_sent;
 	}
 cleanup:
-	zbx_free(compressed_data);
+	zbx_tcp_send_context_clear(&context);
 
 	if (0 != timeout)
 		zbx_socket_timeout_cleanup(s);
@@ -1700,177 +1811,206 @@ static ssize_t	zbx_tcp_read(zbx_socket_t *s, char *buf, size_t len)
 	return res;
 }
 
+#define ZBX_TCP_EXPECT_HEADER		1
+#define ZBX_TCP_EXPECT_VERSION		2
+#define ZBX_TCP_EXPECT_VERSION_VALIDATE	3
+#define ZBX_TCP_EXPECT_LENGTH		4
+#define ZBX_TCP_EXPECT_SIZE		5
+
 /******************************************************************************
  *                                                                            *
- * Function: zbx_tcp_recv_ext                                                 *
- *                                                                            *
- * Purpose: receive data                                                      *
+ * Function: zbx_tcp_recv_context_init                                        *
  *                                                                            *
- * Return value: number of bytes received - success,                          *
- *               FAIL - an error occurred                                     *
+ * Purpose: prepare socket and receive context for receiving new message      *
  *                                                                            *
- * Author: Eugene Grigorjev                                                   *
+ * Parameters: s       - [IN] the socket                                      *
+ *             context - [OUT] the receive context                            *
  *                                                                            *
  ******************************************************************************/
-ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
+void	zbx_tcp_recv_context_init(zbx_socket_t *s, zbx_tcp_recv_context_t *context)
 {
-#define ZBX_TCP_EXPECT_HEADER		1
-#define ZBX_TCP_EXPECT_VERSION		2
-#define ZBX_TCP_EXPECT_VERSION_VALIDATE	3
-#define ZBX_TCP_EXPECT_LENGTH		4
-#define ZBX_TCP_EXPECT_SIZE		5
-
-	ssize_t		nbytes;
-	size_t		buf_dyn_bytes = 0, buf_stat_bytes = 0, offset = 0;
-	zbx_uint32_t	expected_len = 16 * ZBX_MEBIBYTE, reserved = 0;
-	unsigned char	expect = ZBX_TCP_EXPECT_HEADER;
-	int		protocol_version;
-
-	if (0 != timeout)
-		zbx_socket_timeout_set(s, timeout);
-
 	zbx_socket_free(s);
 
 	s->buf_type = ZBX_BUF_TYPE_STAT;
 	s->buffer = s->buf_stat;
 
-	while (0 != (nbytes = zbx_tcp_read(s, s->buf_stat + buf_stat_bytes, sizeof(s->buf_stat) - buf_stat_bytes)))
+	context->buf_dyn_bytes = 0;
+	context->buf_stat_bytes = 0;
+	context->offset = 0;
+	context->expected_len = 16 * ZBX_MEBIBYTE;
+	context->reserved = 0;
+	context->expect = ZBX_TCP_EXPECT_HEADER;
+	context->protocol_version = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_recv_context_process                                     *
+ *                                                                            *
+ * Purpose: parse data read into socket static buffer                         *
+ *                                                                            *
+ * Parameters: s       - [IN] the socket                                      *
+ *             context - [IN/OUT] the receive context                         *
+ *             nbytes  - [IN] the number of bytes read                        *
+ *                                                                            *
+ * Return value: ZBX_TCP_AGAIN - more data is expected                        *
+ *               SUCCEED - reading must be stopped, the message must be       *
+ *                         validated by zbx_tcp_recv_context_finish()         *
+ *               FAIL - the message size exceeds limits                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_tcp_recv_context_process(zbx_socket_t *s, zbx_tcp_recv_context_t *context, size_t nbytes)
+{
+	if (ZBX_BUF_TYPE_STAT == s->buf_type)
+		context->buf_stat_bytes += nbytes;
+	else
 	{
-		if (ZBX_PROTO_ERROR == nbytes)
-			goto out;
+		if (context->buf_dyn_bytes + nbytes <= context->expected_len)
+			memcpy(s->buffer + context->buf_dyn_bytes, s->buf_stat, nbytes);
+		context->buf_dyn_bytes += nbytes;
+	}
 
-		if (ZBX_BUF_TYPE_STAT == s->buf_type)
-			buf_stat_bytes += nbytes;
-		else
-		{
-			if (buf_dyn_bytes + nbytes <= expected_len)
-				memcpy(s->buffer + buf_dyn_bytes, s->buf_stat, nbytes);
-			buf_dyn_bytes += nbytes;
-		}
+	if (context->buf_stat_bytes + context->buf_dyn_bytes >= context->expected_len)
+		return SUCCEED;
 
-		if (buf_stat_bytes + buf_dyn_bytes >= expected_len)
-			break;
+	if (ZBX_TCP_EXPECT_HEADER == context->expect)
+	{
+		if (ZBX_TCP_HEADER_LEN > context->buf_stat_bytes)
+		{
+			if (0 == strncmp(s->buf_stat, ZBX_TCP_HEADER_DATA, context->buf_stat_bytes))
+				return ZBX_TCP_AGAIN;
 
-		if (ZBX_TCP_EXPECT_HEADER == expect)
+			return SUCCEED;
+		}
+		else
 		{
-			if (ZBX_TCP_HEADER_LEN > buf_stat_bytes)
+			if (0 != strncmp(s->buf_stat, ZBX_TCP_HEADER_DATA, ZBX_TCP_HEADER_LEN))
 			{
-				if (0 == strncmp(s->buf_stat, ZBX_TCP_HEADER_DATA, buf_stat_bytes))
-					continue;
-
-				break;
+				/* invalid header, abort receiving */
+				return SUCCEED;
 			}
-			else
-			{
-				if (0 != strncmp(s->buf_stat, ZBX_TCP_HEADER_DATA, ZBX_TCP_HEADER_LEN))
-				{
-					/* invalid header, abort receiving */
-					break;
-				}
 
-				expect = ZBX_TCP_EXPECT_VERSION;
-				offset += ZBX_TCP_HEADER_LEN;
-			}
+			context->expect = ZBX_TCP_EXPECT_VERSION;
+			context->offset += ZBX_TCP_HEADER_LEN;
 		}
+	}
 
-		if (ZBX_TCP_EXPECT_VERSION == expect)
-		{
-			if (offset + 1 > buf_stat_bytes)
-				continue;
+	if (ZBX_TCP_EXPECT_VERSION == context->expect)
+	{
+		if (context->offset + 1 > context->buf_stat_bytes)
+			return ZBX_TCP_AGAIN;
 
-			expect = ZBX_TCP_EXPECT_VERSION_VALIDATE;
-			protocol_version = s->buf_stat[ZBX_TCP_HEADER_LEN];
+		context->expect = ZBX_TCP_EXPECT_VERSION_VALIDATE;
+		context->protocol_version = s->buf_stat[ZBX_TCP_HEADER_LEN];
 
-			if (0 == (protocol_version & ZBX_TCP_PROTOCOL) ||
-					protocol_version > (ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS))
-			{
-				/* invalid protocol version, abort receiving */
-				break;
-			}
-			s->protocol = protocol_version;
-			expect = ZBX_TCP_EXPECT_LENGTH;
-			offset++;
+		if (0 == (context->protocol_version & ZBX_TCP_PROTOCOL) ||
+				context->protocol_version > (ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS))
+		{
+			/* invalid protocol version, abort receiving */
+			return SUCCEED;
 		}
+		s->protocol = context->protocol_version;
+		context->expect = ZBX_TCP_EXPECT_LENGTH;
+		context->offset++;
+	}
 
-		if (ZBX_TCP_EXPECT_LENGTH == expect)
-		{
-			if (offset + 2 * sizeof(zbx_uint32_t) > buf_stat_bytes)
-				continue;
+	if (ZBX_TCP_EXPECT_LENGTH == context->expect)
+	{
+		if (context->offset + 2 * sizeof(zbx_uint32_t) > context->buf_stat_bytes)
+			return ZBX_TCP_AGAIN;
 
-			memcpy(&expected_len, s->buf_stat + offset, sizeof(zbx_uint32_t));
-			offset += sizeof(zbx_uint32_t);
-			expected_len = zbx_letoh_uint32(expected_len);
+		memcpy(&context->expected_len, s->buf_stat + context->offset, sizeof(zbx_uint32_t));
+		context->offset += sizeof(zbx_uint32_t);
+		context->expected_len = zbx_letoh_uint32(context->expected_len);
 
-			memcpy(&reserved, s->buf_stat + offset, sizeof(zbx_uint32_t));
-			offset += sizeof(zbx_uint32_t);
-			reserved = zbx_letoh_uint32(reserved);
+		memcpy(&context->reserved, s->buf_stat + context->offset, sizeof(zbx_uint32_t));
+		context->offset += sizeof(zbx_uint32_t);
+		context->reserved = zbx_letoh_uint32(context->reserved);
 
-			if (ZBX_MAX_RECV_DATA_SIZE < expected_len)
-			{
-				zabbix_log(LOG_LEVEL_WARNING, "Message size " ZBX_FS_UI64 " from %s exceeds the "
-						"maximum size " ZBX_FS_UI64 " bytes. Message ignored.",
-						(zbx_uint64_t)expected_len, s->peer,
-						(zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE);
-				nbytes = ZBX_PROTO_ERROR;
-				goto out;
-			}
+		if (ZBX_MAX_RECV_DATA_SIZE < context->expected_len)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "Message size " ZBX_FS_UI64 " from %s exceeds the "
+					"maximum size " ZBX_FS_UI64 " bytes. Message ignored.",
+					(zbx_uint64_t)context->expected_len, s->peer,
+					(zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE);
+			zbx_set_socket_strerror("message size exceeds the maximum size");
+			return FAIL;
+		}
 
-			/* compressed protocol stores uncompressed packet size in the reserved data */
-			if (0 != (protocol_version & ZBX_TCP_COMPRESS) && ZBX_MAX_RECV_DATA_SIZE < reserved)
-			{
-				zabbix_log(LOG_LEVEL_WARNING, "Uncompressed message size " ZBX_FS_UI64
-						" from %s exceeds the maximum size " ZBX_FS_UI64
-						" bytes. Message ignored.", (zbx_uint64_t)reserved, s->peer,
-						(zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE);
-				nbytes = ZBX_PROTO_ERROR;
-				goto out;
-			}
+		/* compressed protocol stores uncompressed packet size in the reserved data */
+		if (0 != (context->protocol_version & ZBX_TCP_COMPRESS) && ZBX_MAX_RECV_DATA_SIZE < context->reserved)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "Uncompressed message size " ZBX_FS_UI64
+					" from %s exceeds the maximum size " ZBX_FS_UI64
+					" bytes. Message ignored.", (zbx_uint64_t)context->reserved, s->peer,
+					(zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE);
+			zbx_set_socket_strerror("uncompressed message size exceeds the maximum size");
+			return FAIL;
+		}
 
-			if (sizeof(s->buf_stat) > expected_len)
-			{
-				buf_stat_bytes -= offset;
-				memmove(s->buf_stat, s->buf_stat + offset, buf_stat_bytes);
-			}
-			else
-			{
-				s->buf_type = ZBX_BUF_TYPE_DYN;
-				s->buffer = (char *)zbx_malloc(NULL, expected_len + 1);
-				buf_dyn_bytes = buf_stat_bytes - offset;
-				buf_stat_bytes = 0;
-				memcpy(s->buffer, s->buf_stat + offset, buf_dyn_bytes);
-			}
+		if (sizeof(s->buf_stat) > context->expected_len)
+		{
+			context->buf_stat_bytes -= context->offset;
+			memmove(s->buf_stat, s->buf_stat + context->offset, context->buf_stat_bytes);
+		}
+		else
+		{
+			s->buf_type = ZBX_BUF_TYPE_DYN;
+			s->buffer = (char *)zbx_malloc(NULL, context->expected_len + 1);
+			context->buf_dyn_bytes = context->buf_stat_bytes - context->offset;
+			context->buf_stat_bytes = 0;
+			memcpy(s->buffer, s->buf_stat + context->offset, context->buf_dyn_bytes);
+		}
 
-			expect = ZBX_TCP_EXPECT_SIZE;
+		context->expect = ZBX_TCP_EXPECT_SIZE;
 
-			if (buf_stat_bytes + buf_dyn_bytes >= expected_len)
-				break;
-		}
+		if (context->buf_stat_bytes + context->buf_dyn_bytes >= context->expected_len)
+			return SUCCEED;
 	}
 
-	if (ZBX_TCP_EXPECT_SIZE == expect)
+	return ZBX_TCP_AGAIN;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_recv_context_finish                                      *
+ *                                                                            *
+ * Purpose: validate received message and uncompress it if necessary          *
+ *                                                                            *
+ * Parameters: s       - [IN] the socket                                      *
+ *             context - [IN] the receive context                             *
+ *                                                                            *
+ * Return value: SUCCEED - the message was received, s->buffer contains its   *
+ *                         s->read_bytes bytes of data                        *
+ *               FAIL - the message is not valid                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_tcp_recv_context_finish(zbx_socket_t *s, zbx_tcp_recv_context_t *context)
+{
+	size_t	received = context->buf_stat_bytes + context->buf_dyn_bytes;
+
+	if (ZBX_TCP_EXPECT_SIZE == context->expect)
 	{
-		if (buf_stat_bytes + buf_dyn_bytes == expected_len)
+		if (received == context->expected_len)
 		{
-			if (0 != (protocol_version & ZBX_TCP_COMPRESS))
+			if (0 != (context->protocol_version & ZBX_TCP_COMPRESS))
 			{
 				char	*out;
-				size_t	out_size = reserved;
+				size_t	out_size = context->reserved;
 
-				out = (char *)zbx_malloc(NULL, reserved + 1);
-				if (FAIL == zbx_uncompress(s->buffer, buf_stat_bytes + buf_dyn_bytes, out, &out_size))
+				out = (char *)zbx_malloc(NULL, context->reserved + 1);
+				if (FAIL == zbx_uncompress(s->buffer, received, out, &out_size))
 				{
 					zbx_free(out);
 					zbx_set_socket_strerror("cannot uncompress data: %s", zbx_compress_strerror());
-					nbytes = ZBX_PROTO_ERROR;
-					goto out;
+					return FAIL;
 				}
 
-				if (out_size != reserved)
+				if (out_size != context->reserved)
 				{
 					zbx_free(out);
 					zbx_set_socket_strerror("size of uncompressed data is less than expected");
-					nbytes = ZBX_PROTO_ERROR;
-					goto out;
+					return FAIL;
 				}
 
 				if (ZBX_BUF_TYPE_DYN == s->buf_type)
@@ -1878,71 +2018,171 @@ ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
 
 				s->buf_type = ZBX_BUF_TYPE_DYN;
 				s->buffer = out;
-				s->read_bytes = reserved;
+				s->read_bytes = context->reserved;
 
 				zabbix_log(LOG_LEVEL_TRACE, "%s(): received " ZBX_FS_SIZE_T " bytes with"
-						" compression ratio %.1f", __func__,
-						(zbx_fs_size_t)(buf_stat_bytes + buf_dyn_bytes),
-						(double)reserved / (buf_stat_bytes + buf_dyn_bytes));
+						" compression ratio %.1f", __func__, (zbx_fs_size_t)received,
+						(double)context->reserved / received);
 			}
 			else
-				s->read_bytes = buf_stat_bytes + buf_dyn_bytes;
+				s->read_bytes = received;
 
 			s->buffer[s->read_bytes] = '\0';
 		}
 		else
 		{
-			if (buf_stat_bytes + buf_dyn_bytes < expected_len)
+			if (received < context->expected_len)
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "Message from %s is shorter than expected " ZBX_FS_UI64
-						" bytes. Message ignored.", s->peer, (zbx_uint64_t)expected_len);
+						" bytes. Message ignored.", s->peer, (zbx_uint64_t)context->expected_len);
+				zbx_set_socket_strerror("message is shorter than expected");
 			}
 			else
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "Message from %s is longer than expected " ZBX_FS_UI64
-						" bytes. Message ignored.", s->peer, (zbx_uint64_t)expected_len);
+						" bytes. Message ignored.", s->peer, (zbx_uint64_t)context->expected_len);
+				zbx_set_socket_strerror("message is longer than expected");
 			}
 
-			nbytes = ZBX_PROTO_ERROR;
+			return FAIL;
 		}
 	}
-	else if (ZBX_TCP_EXPECT_LENGTH == expect)
+	else if (ZBX_TCP_EXPECT_LENGTH == context->expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is missing data length. Message ignored.", s->peer);
-		nbytes = ZBX_PROTO_ERROR;
+		zbx_set_socket_strerror("message is missing data length");
+		return FAIL;
 	}
-	else if (ZBX_TCP_EXPECT_VERSION == expect)
+	else if (ZBX_TCP_EXPECT_VERSION == context->expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is missing protocol version. Message ignored.",
 				s->peer);
-		nbytes = ZBX_PROTO_ERROR;
+		zbx_set_socket_strerror("message is missing protocol version");
+		return FAIL;
 	}
-	else if (ZBX_TCP_EXPECT_VERSION_VALIDATE == expect)
+	else if (ZBX_TCP_EXPECT_VERSION_VALIDATE == context->expect)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is using unsupported protocol version \"%d\"."
-				" Message ignored.", s->peer, protocol_version);
-		nbytes = ZBX_PROTO_ERROR;
+				" Message ignored.", s->peer, context->protocol_version);
+		zbx_set_socket_strerror("message is using unsupported protocol version");
+		return FAIL;
 	}
-	else if (0 != buf_stat_bytes)
+	else if (0 != context->buf_stat_bytes)
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "Message from %s is missing header. Message ignored.", s->peer);
-		nbytes = ZBX_PROTO_ERROR;
+		zbx_set_socket_strerror("message is missing header");
+		return FAIL;
 	}
 	else
 	{
 		s->read_bytes = 0;
 		s->buffer[s->read_bytes] = '\0';
 	}
+
+	return SUCCEED;
+}
+
+#ifndef _WINDOWS
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_recv_context                                             *
+ *                                                                            *
+ * Purpose: receive as much of message as available on non-blocking socket   *
+ *                                                                            *
+ * Parameters: s       - [IN] the non-blocking unencrypted socket             *
+ *             context - [IN/OUT] the receive context, initialized with       *
+ *                                zbx_tcp_recv_context_init()                 *
+ *                                                                            *
+ * Return value: SUCCEED - the message was received, s->buffer contains its   *
+ *                         s->read_bytes bytes of data. Nothing was received  *
+ *                         before the peer closed connection if both          *
+ *                         s->read_bytes and context->offset are zero.        *
+ *               FAIL - an error occurred                                     *
+ *               ZBX_TCP_AGAIN - the socket must become readable before       *
+ *                               receiving the rest of message                *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_tcp_recv_context(zbx_socket_t *s, zbx_tcp_recv_context_t *context)
+{
+	ssize_t	nbytes;
+	int	ret, err;
+
+	while (0 != (nbytes = ZBX_TCP_READ(s->socket, s->buf_stat + context->buf_stat_bytes,
+			sizeof(s->buf_stat) - context->buf_stat_bytes)))
+	{
+		if (ZBX_PROTO_ERROR == nbytes)
+		{
+			if (ZBX_PROTO_AGAIN == (err = zbx_socket_last_error()))
+				continue;
+
+			if (EAGAIN == err || EWOULDBLOCK == err)
+				return ZBX_TCP_AGAIN;
+
+			zbx_set_socket_strerror("ZBX_TCP_READ() failed: %s", strerror_from_system(err));
+			return FAIL;
+		}
+
+		if (FAIL == (ret = zbx_tcp_recv_context_process(s, context, (size_t)nbytes)))
+			return FAIL;
+
+		if (SUCCEED == ret)
+			break;
+	}
+
+	return zbx_tcp_recv_context_finish(s, context);
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_tcp_recv_ext                                                 *
+ *                                                                            *
+ * Purpose: receive data                                                      *
+ *                                                                            *
+ * Return value: number of bytes received - success,                          *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ * Author: Eugene Grigorjev                                                   *
+ *                                                                            *
+ ******************************************************************************/
+ssize_t	zbx_tcp_recv_ext(zbx_socket_t *s, int timeout)
+{
+	zbx_tcp_recv_context_t	context;
+	ssize_t			nbytes;
+	int			ret = SUCCEED;
+
+	if (0 != timeout)
+		zbx_socket_timeout_set(s, timeout);
+
+	zbx_tcp_recv_context_init(s, &context);
+
+	while (0 != (nbytes = zbx_tcp_read(s, s->buf_stat + context.buf_stat_bytes,
+			sizeof(s->buf_stat) - context.buf_stat_bytes)))
+	{
+		if (ZBX_PROTO_ERROR == nbytes)
+		{
+			ret = FAIL;
+			goto out;
+		}
+
+		if (ZBX_TCP_AGAIN != (ret = zbx_tcp_recv_context_process(s, &context, (size_t)nbytes)))
+			break;
+	}
+
+	if (FAIL != ret)
+		ret = zbx_tcp_recv_context_finish(s, &context);
 out:
 	if (0 != timeout)
 		zbx_socket_timeout_cleanup(s);
 
-	return (ZBX_PROTO_ERROR == nbytes ? FAIL : (ssize_t)(s->read_bytes + offset));
+	return (FAIL == ret ? FAIL : (ssize_t)(s->read_bytes + context.offset));
+}
 
 #undef ZBX_TCP_EXPECT_HEADER
+#undef ZBX_TCP_EXPECT_VERSION
+#undef ZBX_TCP_EXPECT_VERSION_VALIDATE
 #undef ZBX_TCP_EXPECT_LENGTH
 #undef ZBX_TCP_EXPECT_SIZE
-}
 
 /******************************************************************************
  *                                                                            *
@@ -76,6 +76,10 @@ static int	db_auto_increment;
 
 #if defined(HAVE_MYSQL)
 static MYSQL			*conn = NULL;
+static MYSQL_STMT		*stmt = NULL;		/* the statement handle for bulk insert operations */
+static char			*stmt_sql = NULL;	/* the prepared statement */
+static MYSQL_BIND		*stmt_binds = NULL;
+static unsigned long		stmt_binds_num = 0;
 #elif defined(HAVE_ORACLE)
 #include "zbxalgo.h"
 
@@ -292,9 +296,9 @@ static DB_RESULT	zbx_db_select(const char *fmt, ...)
 }
 
 #if defined(HAVE_MYSQL)
-static int	is_recoverable_mysql_error(void)
+static int	is_recoverable_mysql_error(unsigned int err_no)
 {
-	switch (mysql_errno(conn))
+	switch (err_no)
 	{
 		case CR_CONN_HOST_ERROR:
 		case CR_SERVER_GONE_ERROR:
@@ -569,7 +573,7 @@ int	zbx_db_connect(char *host, char *user, char *password, char *dbname, char *d
 		ret = ZBX_DB_FAIL;
 	}
 
-	if (ZBX_DB_FAIL == ret && SUCCEED == is_recoverable_mysql_error())
+	if (ZBX_DB_FAIL == ret && SUCCEED == is_recoverable_mysql_error(mysql_errno(conn)))
 		ret = ZBX_DB_DOWN;
 
 #elif defined(HAVE_ORACLE)
@@ -923,6 +927,15 @@ void	zbx_db_deinit(void)
 void	zbx_db_close(void)
 {
 #if defined(HAVE_MYSQL)
+	if (NULL != stmt)
+	{
+		mysql_stmt_close(stmt);
+		stmt = NULL;
+		zbx_free(stmt_sql);
+		zbx_free(stmt_binds);
+		stmt_binds_num = 0;
+	}
+
 	if (NULL != conn)
 	{
 		mysql_close(conn);
@@ -1362,11 +1375,6 @@ out:
 	return ret;
 }
 
-void	zbx_db_clean_bind_context(zbx_db_bind_context_t *context)
-{
-	zbx_free(context->data);
-}
-
 int	zbx_db_statement_execute(int iters)
 {
 	sword	err;
@@ -1397,6 +1405,303 @@ out:
 }
 #endif
 
+#ifdef HAVE_MYSQL
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_statement_prepare                                         *
+ *                                                                            *
+ * Purpose: prepare statement with parameter placeholders                     *
+ *                                                                            *
+ * Comments: The statement is kept prepared and reused while the same SQL is  *
+ *           passed, so that bulk inserts split into equal chunks are parsed  *
+ *           by server only once.                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_statement_prepare(const char *sql)
+{
+	int	ret = ZBX_DB_OK;
+
+	if (0 == txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+	if (NULL != stmt_sql && 0 == strcmp(stmt_sql, sql) && ZBX_DB_OK == txn_error)
+		return ZBX_DB_OK;
+
+	zbx_free(stmt_sql);
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] within failed transaction", txn_level);
+		return ZBX_DB_FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level, sql);
+
+	if (NULL == conn)
+	{
+		zbx_db_errlog(ERR_Z3003, 0, NULL, NULL);
+		ret = ZBX_DB_FAIL;
+	}
+	else if (NULL == stmt && NULL == (stmt = mysql_stmt_init(conn)))
+	{
+		zbx_db_errlog(ERR_Z3005, mysql_errno(conn), mysql_error(conn), sql);
+		ret = ZBX_DB_FAIL;
+	}
+	else if (0 != mysql_stmt_prepare(stmt, sql, strlen(sql)))
+	{
+		zbx_db_errlog(ERR_Z3005, mysql_stmt_errno(stmt), mysql_stmt_error(stmt), sql);
+		ret = (SUCCEED == is_recoverable_mysql_error(mysql_stmt_errno(stmt)) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+	}
+	else
+	{
+		stmt_sql = zbx_strdup(NULL, sql);
+		stmt_binds_num = mysql_stmt_param_count(stmt);
+		stmt_binds = (MYSQL_BIND *)zbx_realloc(stmt_binds, sizeof(MYSQL_BIND) * MAX(1, stmt_binds_num));
+	}
+
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = ZBX_DB_FAIL;
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_bind_parameter_dyn                                        *
+ *                                                                            *
+ * Purpose: binds column values of all rows to the prepared statement         *
+ *                                                                            *
+ * Parameters: context  - [OUT] the bind context                              *
+ *             position - [IN] the column position, starting with 0           *
+ *             type     - [IN] the parameter type (ZBX_TYPE_* )               *
+ *             rows     - [IN] the data to bind - array of rows,              *
+ *                             each row being an array of columns             *
+ *             rows_num - [IN] the number of rows in the data                 *
+ *                                                                            *
+ * Comments: The statement must contain a group of placeholders for each row, *
+ *           the bound values must be kept until statement is executed.       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_bind_parameter_dyn(zbx_db_bind_context_t *context, int position, unsigned char type,
+		zbx_db_value_t **rows, int rows_num)
+{
+	int		i, fields_num;
+	unsigned long	*lengths = NULL;
+
+	context->position = position;
+	context->rows = rows;
+	context->data = NULL;
+	context->type = type;
+
+	/* statement preparation has failed */
+	if (NULL == stmt_sql)
+		return ZBX_DB_FAIL;
+
+	if (0 == rows_num || 0 != stmt_binds_num % rows_num || position >= (int)(stmt_binds_num / rows_num))
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		return ZBX_DB_FAIL;
+	}
+
+	fields_num = (int)(stmt_binds_num / rows_num);
+
+	switch (type)
+	{
+		case ZBX_TYPE_CHAR:
+		case ZBX_TYPE_TEXT:
+		case ZBX_TYPE_SHORTTEXT:
+		case ZBX_TYPE_LONGTEXT:
+			lengths = (unsigned long *)zbx_malloc(NULL, sizeof(unsigned long) * rows_num);
+			context->data = lengths;
+			break;
+	}
+
+	for (i = 0; i < rows_num; i++)
+	{
+		MYSQL_BIND	*bind = &stmt_binds[i * fields_num + position];
+		zbx_db_value_t	*value = &rows[i][position];
+
+		memset(bind, 0, sizeof(MYSQL_BIND));
+
+		switch (type)
+		{
+			case ZBX_TYPE_ID: /* handle 0 -> NULL conversion */
+				if (0 == value->ui64)
+				{
+					bind->buffer_type = MYSQL_TYPE_NULL;
+					break;
+				}
+				ZBX_FALLTHROUGH;
+			case ZBX_TYPE_UINT:
+				bind->buffer_type = MYSQL_TYPE_LONGLONG;
+				bind->buffer = &value->ui64;
+				bind->is_unsigned = 1;
+				break;
+			case ZBX_TYPE_INT:
+				bind->buffer_type = MYSQL_TYPE_LONG;
+				bind->buffer = &value->i32;
+				break;
+			case ZBX_TYPE_FLOAT:
+				bind->buffer_type = MYSQL_TYPE_DOUBLE;
+				bind->buffer = &value->dbl;
+				break;
+			case ZBX_TYPE_CHAR:
+			case ZBX_TYPE_TEXT:
+			case ZBX_TYPE_SHORTTEXT:
+			case ZBX_TYPE_LONGTEXT:
+				lengths[i] = (unsigned long)strlen(value->str);
+				bind->buffer_type = MYSQL_TYPE_STRING;
+				bind->buffer = value->str;
+				bind->buffer_length = lengths[i];
+				bind->length = &lengths[i];
+				break;
+			default:
+				THIS_SHOULD_NEVER_HAPPEN;
+				exit(EXIT_FAILURE);
+		}
+	}
+
+	return ZBX_DB_OK;
+}
+
+int	zbx_db_statement_execute(int iters)
+{
+	int	ret;
+
+	ZBX_UNUSED(iters);
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] within failed transaction", txn_level);
+		ret = ZBX_DB_FAIL;
+		goto out;
+	}
+
+	if (NULL == stmt_sql)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		ret = ZBX_DB_FAIL;
+	}
+	else if (0 != mysql_stmt_bind_param(stmt, stmt_binds) || 0 != mysql_stmt_execute(stmt))
+	{
+		zbx_db_errlog(ERR_Z3005, mysql_stmt_errno(stmt), mysql_stmt_error(stmt), stmt_sql);
+		ret = (SUCCEED == is_recoverable_mysql_error(mysql_stmt_errno(stmt)) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+	}
+	else
+		ret = (int)mysql_stmt_affected_rows(stmt);
+
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query failed, setting transaction as failed");
+		txn_error = ZBX_DB_FAIL;
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "%s():%d", __func__, ret);
+
+	return ret;
+}
+#endif
+
+#if defined(HAVE_ORACLE) || defined(HAVE_MYSQL)
+void	zbx_db_clean_bind_context(zbx_db_bind_context_t *context)
+{
+	zbx_free(context->data);
+}
+#endif
+
+#ifdef HAVE_POSTGRESQL
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_copy                                                      *
+ *                                                                            *
+ * Purpose: load data with COPY ... FROM STDIN statement                      *
+ *                                                                            *
+ * Parameters: sql  - [IN] the COPY statement                                 *
+ *             data - [IN] the data in format specified by the statement      *
+ *             size - [IN] the data size                                      *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows copied (on success)                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy(const char *sql, const char *data, size_t size)
+{
+	PGresult	*result;
+	char		*error = NULL;
+	int		ret = ZBX_DB_OK;
+	double		sec = 0;
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+		sec = zbx_time();
+
+	if (0 == txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level, sql);
+		return ZBX_DB_FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s] size:" ZBX_FS_SIZE_T, txn_level, sql,
+			(zbx_fs_size_t)size);
+
+	if (NULL != (result = PQexec(conn, sql)) && PGRES_COPY_IN == PQresultStatus(result))
+	{
+		PQclear(result);
+
+		/* errors of sending data are reported in the command result */
+		if (1 == PQputCopyData(conn, data, (int)size))
+			(void)PQputCopyEnd(conn, NULL);
+		else
+			(void)PQputCopyEnd(conn, "cannot send data");
+
+		result = PQgetResult(conn);
+	}
+
+	if (NULL == result)
+	{
+		zbx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
+		ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+	}
+	else if (PGRES_COMMAND_OK != PQresultStatus(result))
+	{
+		zbx_postgresql_error(&error, result);
+		zbx_db_errlog(ERR_Z3005, 0, error, sql);
+		zbx_free(error);
+
+		ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+	}
+
+	if (ZBX_DB_OK == ret)
+		ret = atoi(PQcmdTuples(result));
+
+	PQclear(result);
+
+	/* make connection ready for the next command */
+	while (NULL != (result = PQgetResult(conn)))
+		PQclear(result);
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)CONFIG_LOG_SLOW_QUERIES / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
+	}
+
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = ZBX_DB_FAIL;
+	}
+
+	return ret;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_vexecute                                                  *
@@ -1453,7 +1758,7 @@ int	zbx_db_vexecute(const char *fmt, va_list args)
 		{
 			zbx_db_errlog(ERR_Z3005, mysql_errno(conn), mysql_error(conn), sql);
 
-			ret = (SUCCEED == is_recoverable_mysql_error() ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+			ret = (SUCCEED == is_recoverable_mysql_error(mysql_errno(conn)) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
 		}
 		else
 		{
@@ -1471,7 +1776,7 @@ int	zbx_db_vexecute(const char *fmt, va_list args)
 				if (0 < (status = mysql_next_result(conn)))
 				{
 					zbx_db_errlog(ERR_Z3005, mysql_errno(conn), mysql_error(conn), sql);
-					ret = (SUCCEED == is_recoverable_mysql_error() ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+					ret = (SUCCEED == is_recoverable_mysql_error(mysql_errno(conn)) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
 				}
 			}
 			while (0 == status);
@@ -1619,7 +1924,7 @@ DB_RESULT	zbx_db_vselect(const char *fmt, va_list args)
 			zbx_db_errlog(ERR_Z3005, mysql_errno(conn), mysql_error(conn), sql);
 
 			DBfree_result(result);
-			result = (SUCCEED == is_recoverable_mysql_error() ? (DB_RESULT)ZBX_DB_DOWN : NULL);
+			result = (SUCCEED == is_recoverable_mysql_error(mysql_errno(conn)) ? (DB_RESULT)ZBX_DB_DOWN : NULL);
 		}
 	}
 #elif defined(HAVE_ORACLE)
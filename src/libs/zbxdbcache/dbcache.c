@@ -39,12 +39,17 @@
 #include "daemon.h"
 #include "zbxtrends.h"
 
-static zbx_mem_info_t	*hc_index_mem = NULL;
-static zbx_mem_info_t	*hc_mem = NULL;
+/* History cache values and index are partitioned into HistoryCacheStripes stripes by itemid. Each stripe has */
+/* its own lock, history queue and shared memory allocators, so values of different stripes can be added and   */
+/* synced concurrently.                                                                                         */
+static zbx_mem_info_t	*hc_index_mem[ZBX_HC_STRIPES_MAX];
+static zbx_mem_info_t	*hc_mem[ZBX_HC_STRIPES_MAX];
 static zbx_mem_info_t	*trend_mem = NULL;
 
 #define	LOCK_CACHE	zbx_mutex_lock(cache_lock)
 #define	UNLOCK_CACHE	zbx_mutex_unlock(cache_lock)
+#define	LOCK_STRIPE(stripe)	zbx_mutex_lock(hc_locks[stripe])
+#define	UNLOCK_STRIPE(stripe)	zbx_mutex_unlock(hc_locks[stripe])
 #define	LOCK_TRENDS	zbx_mutex_lock(trends_lock)
 #define	UNLOCK_TRENDS	zbx_mutex_unlock(trends_lock)
 #define	LOCK_CACHE_IDS		zbx_mutex_lock(cache_ids_lock)
@@ -53,12 +58,14 @@ static zbx_mem_info_t	*trend_mem = NULL;
 static zbx_mutex_t	cache_lock = ZBX_MUTEX_NULL;
 static zbx_mutex_t	trends_lock = ZBX_MUTEX_NULL;
 static zbx_mutex_t	cache_ids_lock = ZBX_MUTEX_NULL;
+static zbx_mutex_t	hc_locks[ZBX_HC_STRIPES_MAX];
 
 static char		*sql = NULL;
 static size_t		sql_alloc = 64 * ZBX_KIBIBYTE;
 
 extern unsigned char	program_type;
 extern int		CONFIG_DOUBLE_PRECISION;
+extern int		process_num;
 
 #define ZBX_IDS_SIZE	9
 
@@ -66,6 +73,14 @@ extern int		CONFIG_DOUBLE_PRECISION;
 
 #define ZBX_TRENDS_CLEANUP_TIME	((SEC_PER_HOUR * 55) / 60)
 
+/* Completed hourly trends are kept in cache and written to database at item specific offset within this period */
+/* after the hour, so that trends of all items are not flushed at once when hour changes. The period is kept   */
+/* short to limit the time completed hour is missing from database for trend functions and graphs.             */
+#define ZBX_TRENDS_FLUSH_PERIOD	(SEC_PER_MIN * 5)
+
+/* completed trends are written immediately when trend cache free space drops below this percentage */
+#define ZBX_TRENDS_DEFER_FREE_PCNT	25
+
 /* the maximum time spent synchronizing history */
 #define ZBX_HC_SYNC_TIME_MAX	10
 
@@ -100,17 +115,35 @@ ZBX_DC_IDS;
 
 static ZBX_DC_IDS	*ids = NULL;
 
+/* history cache stripe, protected by its own lock */
 typedef struct
 {
-	zbx_hashset_t		trends;
 	ZBX_DC_STATS		stats;
 
 	zbx_hashset_t		history_items;
 	zbx_binary_heap_t	history_queue;
 
 	int			history_num;
+}
+zbx_hc_stripe_t;
+
+typedef struct
+{
+	zbx_hashset_t		trends;
+	zbx_hashset_t		trends_pending;	/* completed trends waiting to be flushed */
+	zbx_binary_heap_t	trends_queue;	/* completed trends ordered by flush time */
+	zbx_hc_stripe_t		stripes[ZBX_HC_STRIPES_MAX];
+
 	int			trends_num;
 	int			trends_last_cleanup_hour;
+
+	/* The clock since which there are no trend rows in database, except the ones written by trend cache */
+	/* and tracked by trend disable_from field. Zero if unknown - then database is checked for existing   */
+	/* rows before trends are written.                                                                    */
+	int			trends_owned_from;
+	/* the latest clock of trends written by trend cache */
+	int			trends_max_clock;
+
 	int			history_num_total;
 	int			history_progress_ts;
 
@@ -168,9 +201,13 @@ static void	hc_pop_items(zbx_vector_ptr_t *history_items);
 static void	hc_get_item_values(ZBX_DC_HISTORY *history, zbx_vector_ptr_t *history_items);
 static void	hc_push_items(zbx_vector_ptr_t *history_items);
 static void	hc_free_item_values(ZBX_DC_HISTORY *history, int history_num);
-static void	hc_queue_item(zbx_hc_item_t *item);
+static void	hc_queue_item(zbx_hc_stripe_t *stripe, zbx_hc_item_t *item);
 static int	hc_queue_elem_compare_func(const void *d1, const void *d2);
 static int	hc_queue_get_size(void);
+static int	hc_get_history_num(void);
+static void	hc_get_wcache_stats(ZBX_DC_STATS *stats);
+static void	hc_get_wcache_mem(zbx_wcache_info_t *wcache_info);
+static void	hc_get_wcache_info(zbx_wcache_info_t *wcache_info);
 static int	hc_get_history_compression_age(void);
 
 /******************************************************************************
@@ -184,21 +221,17 @@ static int	hc_get_history_compression_age(void);
  ******************************************************************************/
 void	DCget_stats_all(zbx_wcache_info_t *wcache_info)
 {
-	LOCK_CACHE;
-
-	wcache_info->stats = cache->stats;
-	wcache_info->history_free = hc_mem->free_size;
-	wcache_info->history_total = hc_mem->total_size;
-	wcache_info->index_free = hc_index_mem->free_size;
-	wcache_info->index_total = hc_index_mem->total_size;
+	hc_get_wcache_info(wcache_info);
 
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 	{
+		LOCK_TRENDS;
+
 		wcache_info->trend_free = trend_mem->free_size;
 		wcache_info->trend_total = trend_mem->orig_size;
-	}
 
-	UNLOCK_CACHE;
+		UNLOCK_TRENDS;
+	}
 }
 
 /******************************************************************************
@@ -215,57 +248,62 @@ void	*DCget_stats(int request)
 	static zbx_uint64_t	value_uint;
 	static double		value_double;
 	void			*ret;
+	zbx_wcache_info_t	info;
 
-	LOCK_CACHE;
+	/* value counters and history memory are read separately, trend cache statistics do not need history cache */
+	if (ZBX_STATS_NOTSUPPORTED_COUNTER >= request)
+		hc_get_wcache_stats(&info.stats);
+	else if (ZBX_STATS_TREND_TOTAL > request || ZBX_STATS_TREND_PFREE < request)
+		hc_get_wcache_mem(&info);
 
 	switch (request)
 	{
 		case ZBX_STATS_HISTORY_COUNTER:
-			value_uint = cache->stats.history_counter;
+			value_uint = info.stats.history_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FLOAT_COUNTER:
-			value_uint = cache->stats.history_float_counter;
+			value_uint = info.stats.history_float_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_UINT_COUNTER:
-			value_uint = cache->stats.history_uint_counter;
+			value_uint = info.stats.history_uint_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_STR_COUNTER:
-			value_uint = cache->stats.history_str_counter;
+			value_uint = info.stats.history_str_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_LOG_COUNTER:
-			value_uint = cache->stats.history_log_counter;
+			value_uint = info.stats.history_log_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TEXT_COUNTER:
-			value_uint = cache->stats.history_text_counter;
+			value_uint = info.stats.history_text_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_NOTSUPPORTED_COUNTER:
-			value_uint = cache->stats.notsupported_counter;
+			value_uint = info.stats.notsupported_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TOTAL:
-			value_uint = hc_mem->total_size;
+			value_uint = info.history_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_USED:
-			value_uint = hc_mem->total_size - hc_mem->free_size;
+			value_uint = info.history_total - info.history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FREE:
-			value_uint = hc_mem->free_size;
+			value_uint = info.history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_PUSED:
-			value_double = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+			value_double = 100 * (double)(info.history_total - info.history_free) / info.history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_PFREE:
-			value_double = 100 * (double)hc_mem->free_size / hc_mem->total_size;
+			value_double = 100 * (double)info.history_free / info.history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_TREND_TOTAL:
@@ -290,32 +328,29 @@ void	*DCget_stats(int request)
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_TOTAL:
-			value_uint = hc_index_mem->total_size;
+			value_uint = info.index_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_USED:
-			value_uint = hc_index_mem->total_size - hc_index_mem->free_size;
+			value_uint = info.index_total - info.index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_FREE:
-			value_uint = hc_index_mem->free_size;
+			value_uint = info.index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PUSED:
-			value_double = 100 * (double)(hc_index_mem->total_size - hc_index_mem->free_size) /
-					hc_index_mem->total_size;
+			value_double = 100 * (double)(info.index_total - info.index_free) / info.index_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PFREE:
-			value_double = 100 * (double)hc_index_mem->free_size / hc_index_mem->total_size;
+			value_double = 100 * (double)info.index_free / info.index_total;
 			ret = (void *)&value_double;
 			break;
 		default:
 			ret = NULL;
 	}
 
-	UNLOCK_CACHE;
-
 	return ret;
 }
 
@@ -339,6 +374,7 @@ static ZBX_DC_TREND	*DCget_trend(zbx_uint64_t itemid)
 
 	memset(&trend, 0, sizeof(ZBX_DC_TREND));
 	trend.itemid = itemid;
+	trend.disable_from = cache->trends_owned_from;
 
 	return (ZBX_DC_TREND *)zbx_hashset_insert(&cache->trends, &trend, sizeof(ZBX_DC_TREND));
 }
@@ -362,7 +398,11 @@ static void	DCupdate_trends(zbx_vector_uint64_pair_t *trends_diff)
 	{
 		ZBX_DC_TREND	*trend;
 
-		if (NULL != (trend = (ZBX_DC_TREND *)zbx_hashset_search(&cache->trends, &trends_diff->values[i].first)))
+		if (NULL == (trend = (ZBX_DC_TREND *)zbx_hashset_search(&cache->trends, &trends_diff->values[i].first)))
+			continue;
+
+		/* trends of the same item can be flushed by several syncers, keep the latest clock */
+		if (trend->disable_from < (int)trends_diff->values[i].second)
 			trend->disable_from = trends_diff->values[i].second;
 	}
 
@@ -789,6 +829,93 @@ static void	DCflush_trend(ZBX_DC_TREND *trend, ZBX_DC_TREND **trends, int *trend
 	memcpy(&(*trends)[*trends_num], trend, sizeof(ZBX_DC_TREND));
 	(*trends_num)++;
 
+	if (cache->trends_max_clock < trend->clock)
+		cache->trends_max_clock = trend->clock;
+
+	trend->clock = 0;
+	trend->num = 0;
+	memset(&trend->value_min, 0, sizeof(history_value_t));
+	memset(&trend->value_avg, 0, sizeof(value_avg_t));
+	memset(&trend->value_max, 0, sizeof(history_value_t));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_trend_flush_time                                              *
+ *                                                                            *
+ * Purpose: get time when completed trend must be flushed to the database     *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_trend_flush_time(const ZBX_DC_TREND *trend)
+{
+	return trend->clock + SEC_PER_HOUR + (int)(trend->itemid % ZBX_TRENDS_FLUSH_PERIOD);
+}
+
+static int	dc_trend_queue_compare_func(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(dc_trend_flush_time((const ZBX_DC_TREND *)e1->data),
+			dc_trend_flush_time((const ZBX_DC_TREND *)e2->data));
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_flush_pending_trend                                           *
+ *                                                                            *
+ * Purpose: move completed trend from pending trends to the array of trends   *
+ *          for flushing to DB                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_flush_pending_trend(ZBX_DC_TREND *pending, ZBX_DC_TREND **trends, int *trends_alloc,
+		int *trends_num)
+{
+	zbx_binary_heap_remove_direct(&cache->trends_queue, pending->itemid);
+	DCflush_trend(pending, trends, trends_alloc, trends_num);
+	zbx_hashset_remove_direct(&cache->trends_pending, pending);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_defer_trend                                                   *
+ *                                                                            *
+ * Purpose: move completed trend to pending trends, to be flushed later       *
+ *                                                                            *
+ * Parameters: trend        - [IN/OUT] the completed trend                    *
+ *             trends       - [IN/OUT] the array of trends for flushing to DB *
+ *             trends_alloc - [IN/OUT]                                        *
+ *             trends_num   - [IN/OUT]                                        *
+ *                                                                            *
+ * Comments: The trend is flushed at once if another trend of the item is     *
+ *           still pending or trend cache is running out of memory.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_defer_trend(ZBX_DC_TREND *trend, ZBX_DC_TREND **trends, int *trends_alloc, int *trends_num)
+{
+	ZBX_DC_TREND		*pending;
+	zbx_binary_heap_elem_t	elem;
+
+	if (NULL != (pending = (ZBX_DC_TREND *)zbx_hashset_search(&cache->trends_pending, &trend->itemid)))
+		dc_flush_pending_trend(pending, trends, trends_alloc, trends_num);
+
+	if (trend_mem->free_size < trend_mem->orig_size / 100 * ZBX_TRENDS_DEFER_FREE_PCNT)
+	{
+		DCflush_trend(trend, trends, trends_alloc, trends_num);
+		return;
+	}
+
+	pending = (ZBX_DC_TREND *)zbx_hashset_insert(&cache->trends_pending, trend, sizeof(ZBX_DC_TREND));
+
+	elem.key = pending->itemid;
+	elem.data = (const void *)pending;
+	zbx_binary_heap_insert(&cache->trends_queue, &elem);
+
+	if (cache->trends_max_clock < trend->clock)
+		cache->trends_max_clock = trend->clock;
+
 	trend->clock = 0;
 	trend->num = 0;
 	memset(&trend->value_min, 0, sizeof(history_value_t));
@@ -817,7 +944,7 @@ static void	DCadd_trend(const ZBX_DC_HISTORY *history, ZBX_DC_TREND **trends, in
 	if (trend->num > 0 && (trend->clock != hour || trend->value_type != history->value_type) &&
 			SUCCEED == zbx_history_requires_trends(trend->value_type))
 	{
-		DCflush_trend(trend, trends, trends_alloc, trends_num);
+		dc_defer_trend(trend, trends, trends_alloc, trends_num);
 	}
 
 	trend->value_type = history->value_type;
@@ -884,10 +1011,24 @@ static void	DCmass_update_trends(const ZBX_DC_HISTORY *history, int history_num,
 		DCadd_trend(h, trends, &trends_alloc, trends_num);
 	}
 
+	/* flush completed trends which are due */
+	while (SUCCEED != zbx_binary_heap_empty(&cache->trends_queue))
+	{
+		ZBX_DC_TREND	*pending;
+
+		pending = (ZBX_DC_TREND *)zbx_binary_heap_find_min(&cache->trends_queue)->data;
+
+		if (dc_trend_flush_time(pending) > ts.sec)
+			break;
+
+		dc_flush_pending_trend(pending, trends, &trends_alloc, trends_num);
+	}
+
 	if (cache->trends_last_cleanup_hour < hour && ZBX_TRENDS_CLEANUP_TIME < seconds)
 	{
 		zbx_hashset_iter_t	iter;
 		ZBX_DC_TREND		*trend;
+		int			removed_num = 0;
 
 		zbx_hashset_iter_reset(&cache->trends, &iter);
 
@@ -910,6 +1051,15 @@ static void	DCmass_update_trends(const ZBX_DC_HISTORY *history, int history_num,
 				DCflush_trend(trend, trends, &trends_alloc, trends_num);
 
 			zbx_hashset_iter_remove(&iter);
+			removed_num++;
+		}
+
+		/* rows written for removed trends are not tracked any more, */
+		/* so the ownership must not cover clocks written so far     */
+		if (0 != cache->trends_owned_from && 0 != removed_num &&
+				cache->trends_owned_from < cache->trends_max_clock + SEC_PER_HOUR)
+		{
+			cache->trends_owned_from = cache->trends_max_clock + SEC_PER_HOUR;
 		}
 
 		cache->trends_last_cleanup_hour = hour;
@@ -951,6 +1101,7 @@ static void	DBmass_update_trends(const ZBX_DC_TREND *trends, int trends_num,
 typedef struct
 {
 	zbx_uint64_t		hostid;
+	char			*name;
 	zbx_vector_ptr_t	groups;
 }
 zbx_host_info_t;
@@ -959,7 +1110,8 @@ zbx_host_info_t;
  *                                                                            *
  * Function: zbx_host_info_clean                                              *
  *                                                                            *
- * Purpose: frees resources allocated to store host groups names              *
+ * Purpose: frees resources allocated to store host visible name and groups  *
+ *          names                                                             *
  *                                                                            *
  * Parameters: host_info - [IN] host information                              *
  *                                                                            *
@@ -968,17 +1120,20 @@ static void	zbx_host_info_clean(zbx_host_info_t *host_info)
 {
 	zbx_vector_ptr_clear_ext(&host_info->groups, zbx_ptr_free);
 	zbx_vector_ptr_destroy(&host_info->groups);
+	zbx_free(host_info->name);
 }
 
 /******************************************************************************
  *                                                                            *
  * Function: db_get_hosts_info_by_hostid                                      *
  *                                                                            *
- * Purpose: get hosts groups names                                            *
+ * Purpose: get hosts visible names and groups names                           *
  *                                                                            *
  * Parameters: hosts_info - [IN/OUT] output names of host groups for a host   *
  *             hostids    - [IN] hosts identifiers                            *
  *                                                                            *
+ * Comments: Host visible names are taken from configuration cache.           *
+ *                                                                            *
  ******************************************************************************/
 static void	db_get_hosts_info_by_hostid(zbx_hashset_t *hosts_info, const zbx_vector_uint64_t *hostids)
 {
@@ -986,11 +1141,17 @@ static void	db_get_hosts_info_by_hostid(zbx_hashset_t *hosts_info, const zbx_vec
 	size_t		sql_offset = 0;
 	DB_RESULT	result;
 	DB_ROW		row;
+	DC_HOST		host;
 
 	for (i = 0; i < hostids->values_num; i++)
 	{
 		zbx_host_info_t	host_info = {.hostid = hostids->values[i]};
 
+		if (SUCCEED == DCget_host_by_hostid(&host, host_info.hostid))
+			host_info.name = zbx_strdup(NULL, host.name);
+		else
+			host_info.name = zbx_strdup(NULL, "");
+
 		zbx_vector_ptr_create(&host_info.groups);
 		zbx_hashset_insert(hosts_info, &host_info, sizeof(host_info));
 	}
@@ -1027,7 +1188,7 @@ typedef struct
 {
 	zbx_uint64_t		itemid;
 	char			*name;
-	DC_ITEM			*item;
+	const zbx_dc_item_hist_t	*item;
 	zbx_vector_ptr_t	applications;
 }
 zbx_item_info_t;
@@ -1039,7 +1200,11 @@ zbx_item_info_t;
  * Purpose: get items name and applications                                   *
  *                                                                            *
  * Parameters: items_info - [IN/OUT] output item name and applications        *
- *             itemids    - [IN] the item identifiers                         *
+ *             itemids    - [IN] the sorted item identifiers                  *
+ *                                                                            *
+ * Comments: Item name macros are expanded using full item data, which is     *
+ *           retrieved from configuration cache only here, as history syncers *
+ *           otherwise work with the lightweight zbx_dc_item_hist_t.          *
  *                                                                            *
  ******************************************************************************/
 static void	db_get_items_info_by_itemid(zbx_hashset_t *items_info, const zbx_vector_uint64_t *itemids)
@@ -1047,6 +1212,13 @@ static void	db_get_items_info_by_itemid(zbx_hashset_t *items_info, const zbx_vec
 	size_t		sql_offset = 0;
 	DB_RESULT	result;
 	DB_ROW		row;
+	DC_ITEM		*items;
+	int		*errcodes, index;
+
+	items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * (size_t)itemids->values_num);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)itemids->values_num);
+
+	DCconfig_get_items_by_itemids(items, itemids->values, errcodes, (size_t)itemids->values_num);
 
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select itemid,name from items where");
 	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids->values, itemids->values_num);
@@ -1060,16 +1232,25 @@ static void	db_get_items_info_by_itemid(zbx_hashset_t *items_info, const zbx_vec
 
 		ZBX_DBROW2UINT64(itemid, row[0]);
 
-		if (NULL == (item_info = (zbx_item_info_t *)zbx_hashset_search(items_info, &itemid)))
+		if (NULL == (item_info = (zbx_item_info_t *)zbx_hashset_search(items_info, &itemid)) ||
+				FAIL == (index = zbx_vector_uint64_bsearch(itemids, itemid,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC)))
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
 			continue;
 		}
 
-		zbx_substitute_item_name_macros(item_info->item, row[1], &item_info->name);
+		if (SUCCEED != errcodes[index])
+			continue;
+
+		zbx_substitute_item_name_macros(&items[index], row[1], &item_info->name);
 	}
 	DBfree_result(result);
 
+	DCconfig_clean_items(items, errcodes, (size_t)itemids->values_num);
+	zbx_free(errcodes);
+	zbx_free(items);
+
 	sql_offset = 0;
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select i.itemid,a.name"
@@ -1133,7 +1314,7 @@ static void	DCexport_trends(const ZBX_DC_TREND *trends, int trends_num, zbx_hash
 	struct zbx_json		json;
 	const ZBX_DC_TREND	*trend = NULL;
 	int			i, j;
-	const DC_ITEM		*item;
+	const zbx_dc_item_hist_t	*item;
 	zbx_host_info_t		*host_info;
 	zbx_item_info_t		*item_info;
 	zbx_uint128_t		avg;	/* calculate the trend average value */
@@ -1149,7 +1330,7 @@ static void	DCexport_trends(const ZBX_DC_TREND *trends, int trends_num, zbx_hash
 
 		item = item_info->item;
 
-		if (NULL == (host_info = (zbx_host_info_t *)zbx_hashset_search(hosts_info, &item->host.hostid)))
+		if (NULL == (host_info = (zbx_host_info_t *)zbx_hashset_search(hosts_info, &item->hostid)))
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
 			continue;
@@ -1158,8 +1339,8 @@ static void	DCexport_trends(const ZBX_DC_TREND *trends, int trends_num, zbx_hash
 		zbx_json_clean(&json);
 
 		zbx_json_addobject(&json,ZBX_PROTO_TAG_HOST);
-		zbx_json_addstring(&json, ZBX_PROTO_TAG_HOST, item->host.host, ZBX_JSON_TYPE_STRING);
-		zbx_json_addstring(&json, ZBX_PROTO_TAG_NAME, item->host.name, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_HOST, item->host, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_NAME, host_info->name, ZBX_JSON_TYPE_STRING);
 		zbx_json_close(&json);
 
 		zbx_json_addarray(&json, ZBX_PROTO_TAG_GROUPS);
@@ -1224,7 +1405,7 @@ static void	DCexport_history(const ZBX_DC_HISTORY *history, int history_num, zbx
 		zbx_hashset_t *items_info)
 {
 	const ZBX_DC_HISTORY	*h;
-	const DC_ITEM		*item;
+	const zbx_dc_item_hist_t	*item;
 	int			i, j;
 	zbx_host_info_t		*host_info;
 	zbx_item_info_t		*item_info;
@@ -1247,7 +1428,7 @@ static void	DCexport_history(const ZBX_DC_HISTORY *history, int history_num, zbx
 
 		item = item_info->item;
 
-		if (NULL == (host_info = (zbx_host_info_t *)zbx_hashset_search(hosts_info, &item->host.hostid)))
+		if (NULL == (host_info = (zbx_host_info_t *)zbx_hashset_search(hosts_info, &item->hostid)))
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
 			continue;
@@ -1256,8 +1437,8 @@ static void	DCexport_history(const ZBX_DC_HISTORY *history, int history_num, zbx
 		zbx_json_clean(&json);
 
 		zbx_json_addobject(&json,ZBX_PROTO_TAG_HOST);
-		zbx_json_addstring(&json, ZBX_PROTO_TAG_HOST, item->host.host, ZBX_JSON_TYPE_STRING);
-		zbx_json_addstring(&json, ZBX_PROTO_TAG_NAME, item->host.name, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_HOST, item->host, ZBX_JSON_TYPE_STRING);
+		zbx_json_addstring(&json, ZBX_PROTO_TAG_NAME, host_info->name, ZBX_JSON_TYPE_STRING);
 		zbx_json_close(&json);
 
 		zbx_json_addarray(&json, ZBX_PROTO_TAG_GROUPS);
@@ -1333,14 +1514,14 @@ static void	DCexport_history(const ZBX_DC_HISTORY *history, int history_num, zbx
  *                                                                            *
  ******************************************************************************/
 static void	DCexport_history_and_trends(const ZBX_DC_HISTORY *history, int history_num,
-		const zbx_vector_uint64_t *itemids, DC_ITEM *items, const int *errcodes, const ZBX_DC_TREND *trends,
-		int trends_num)
+		const zbx_vector_uint64_t *itemids, const zbx_dc_item_hist_t *items, const int *errcodes,
+		const ZBX_DC_TREND *trends, int trends_num)
 {
-	int			i, index;
-	zbx_vector_uint64_t	hostids, item_info_ids;
-	zbx_hashset_t		hosts_info, items_info;
-	DC_ITEM			*item;
-	zbx_item_info_t		item_info;
+	int				i, index;
+	zbx_vector_uint64_t		hostids, item_info_ids;
+	zbx_hashset_t			hosts_info, items_info;
+	const zbx_dc_item_hist_t	*item;
+	zbx_item_info_t			item_info;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d trends_num:%d", __func__, history_num, trends_num);
 
@@ -1368,7 +1549,7 @@ static void	DCexport_history_and_trends(const ZBX_DC_HISTORY *history, int histo
 
 		item = &items[index];
 
-		zbx_vector_uint64_append(&hostids, item->host.hostid);
+		zbx_vector_uint64_append(&hostids, item->hostid);
 		zbx_vector_uint64_append(&item_info_ids, item->itemid);
 
 		item_info.itemid = item->itemid;
@@ -1396,7 +1577,7 @@ static void	DCexport_history_and_trends(const ZBX_DC_HISTORY *history, int histo
 
 			item = &items[index];
 
-			zbx_vector_uint64_append(&hostids, item->host.hostid);
+			zbx_vector_uint64_append(&hostids, item->hostid);
 			zbx_vector_uint64_append(&item_info_ids, item->itemid);
 
 			item_info.itemid = item->itemid;
@@ -1449,7 +1630,7 @@ clean:
  ******************************************************************************/
 static void	DCexport_all_trends(const ZBX_DC_TREND *trends, int trends_num)
 {
-	DC_ITEM			*items;
+	zbx_dc_item_hist_t	*items;
 	zbx_vector_uint64_t	itemids;
 	int			*errcodes, i, num;
 
@@ -1459,7 +1640,7 @@ static void	DCexport_all_trends(const ZBX_DC_TREND *trends, int trends_num)
 	{
 		num = MIN(ZBX_HC_SYNC_MAX, trends_num);
 
-		items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * (size_t)num);
+		items = (zbx_dc_item_hist_t *)zbx_malloc(NULL, sizeof(zbx_dc_item_hist_t) * (size_t)num);
 		errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
 
 		zbx_vector_uint64_create(&itemids);
@@ -1470,11 +1651,11 @@ static void	DCexport_all_trends(const ZBX_DC_TREND *trends, int trends_num)
 
 		zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-		DCconfig_get_items_by_itemids(items, itemids.values, errcodes, num);
+		zbx_dc_get_hist_items_by_itemids(items, itemids.values, errcodes, num);
 
 		DCexport_history_and_trends(NULL, 0, &itemids, items, errcodes, trends, num);
 
-		DCconfig_clean_items(items, errcodes, num);
+		zbx_dc_clean_hist_items(items, errcodes, num);
 		zbx_vector_uint64_destroy(&itemids);
 		zbx_free(items);
 		zbx_free(errcodes);
@@ -1486,6 +1667,76 @@ static void	DCexport_all_trends(const ZBX_DC_TREND *trends, int trends_num)
 	zabbix_log(LOG_LEVEL_WARNING, "exporting trend data done");
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_store_trends_ownership                                        *
+ *                                                                            *
+ * Purpose: persist the clock since which trend rows are owned by trend cache *
+ *                                                                            *
+ * Comments: Called when all trends are written on shutdown. Trend rows with  *
+ *           clock after the server start can be written only by trend cache, *
+ *           so the ownership is stored also if it was not known on start.    *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_store_trends_ownership(void)
+{
+	int	owned_from;
+
+	owned_from = MAX(cache->trends_owned_from, cache->trends_max_clock + SEC_PER_HOUR);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() owned_from:%d", __func__, owned_from);
+
+	DBexecute("update config set trends_owned_from=%d", owned_from);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCload_trends_ownership                                          *
+ *                                                                            *
+ * Purpose: restore the clock since which trend rows are owned by trend cache *
+ *                                                                            *
+ * Comments: The trends of owned clocks are written to database with plain    *
+ *           inserts, without checking for existing rows.                     *
+ *           The persisted clock is removed right away, as rows written by    *
+ *           this server are tracked only in memory and would be lost if the  *
+ *           server is not shut down normally.                                *
+ *                                                                            *
+ *           Without persisted clock (first start or crash) the ownership is  *
+ *           not known and database is checked for existing rows once for    *
+ *           each trend cache item.                                           *
+ *                                                                            *
+ ******************************************************************************/
+void	DCload_trends_ownership(void)
+{
+	DB_RESULT	result;
+	DB_ROW		row;
+	int		owned_from = 0, hour;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	result = DBselect("select trends_owned_from from config");
+
+	if (NULL != (row = DBfetch(result)))
+		owned_from = atoi(row[0]);
+
+	DBfree_result(result);
+
+	if (0 != owned_from && ZBX_DB_OK > DBexecute("update config set trends_owned_from=0"))
+		owned_from = 0;
+
+	hour = (int)time(NULL);
+	hour -= hour % SEC_PER_HOUR;
+
+	LOCK_TRENDS;
+
+	cache->trends_owned_from = owned_from;
+	cache->trends_max_clock = MAX(hour, owned_from - SEC_PER_HOUR);
+
+	UNLOCK_TRENDS;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() owned_from:%d", __func__, owned_from);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCsync_trends                                                    *
@@ -1517,6 +1768,18 @@ static void	DCsync_trends(void)
 			DCflush_trend(trend, &trends, &trends_alloc, &trends_num);
 	}
 
+	zbx_hashset_iter_reset(&cache->trends_pending, &iter);
+
+	while (NULL != (trend = (ZBX_DC_TREND *)zbx_hashset_iter_next(&iter)))
+	{
+		if (trend->clock >= compression_age)
+			DCflush_trend(trend, &trends, &trends_alloc, &trends_num);
+
+		zbx_hashset_iter_remove(&iter);
+	}
+
+	zbx_binary_heap_clear(&cache->trends_queue);
+
 	UNLOCK_TRENDS;
 
 	if (SUCCEED == zbx_is_export_enabled() && 0 != trends_num)
@@ -1527,7 +1790,8 @@ static void	DCsync_trends(void)
 	while (trends_num > 0)
 		DBflush_trends(trends, &trends_num, NULL);
 
-	DBcommit();
+	if (ZBX_DB_OK == DBcommit())
+		dc_store_trends_ownership();
 
 	zbx_free(trends);
 
@@ -1624,7 +1888,7 @@ out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
-static void	DCinventory_value_add(zbx_vector_ptr_t *inventory_values, const DC_ITEM *item, ZBX_DC_HISTORY *h)
+static void	DCinventory_value_add(zbx_vector_ptr_t *inventory_values, const zbx_dc_item_hist_t *item, ZBX_DC_HISTORY *h)
 {
 	char			value[MAX_BUFFER_LEN];
 	const char		*inventory_field;
@@ -1633,7 +1897,7 @@ static void	DCinventory_value_add(zbx_vector_ptr_t *inventory_values, const DC_I
 	if (ITEM_STATE_NOTSUPPORTED == h->state)
 		return;
 
-	if (HOST_INVENTORY_AUTOMATIC != item->host.inventory_mode)
+	if (HOST_INVENTORY_AUTOMATIC != item->host_inventory_mode)
 		return;
 
 	if (0 != (ZBX_DC_FLAG_UNDEF & h->flags) || 0 != (ZBX_DC_FLAG_NOVALUE & h->flags) ||
@@ -1662,7 +1926,7 @@ static void	DCinventory_value_add(zbx_vector_ptr_t *inventory_values, const DC_I
 
 	inventory_value = (zbx_inventory_value_t *)zbx_malloc(NULL, sizeof(zbx_inventory_value_t));
 
-	inventory_value->hostid = item->host.hostid;
+	inventory_value->hostid = item->hostid;
 	inventory_value->idx = item->inventory_link - 1;
 	inventory_value->field_name = inventory_field;
 	inventory_value->value = zbx_strdup(NULL, value);
@@ -1838,7 +2102,7 @@ static void	dc_history_set_value(ZBX_DC_HISTORY *hdata, unsigned char value_type
  *             hdata         - [IN/OUT] the historical data to process        *
  *                                                                            *
  ******************************************************************************/
-static void	normalize_item_value(const DC_ITEM *item, ZBX_DC_HISTORY *hdata)
+static void	normalize_item_value(const zbx_dc_item_hist_t *item, ZBX_DC_HISTORY *hdata)
 {
 	char		*logvalue;
 	zbx_variant_t	value_var;
@@ -1918,7 +2182,7 @@ static void	normalize_item_value(const DC_ITEM *item, ZBX_DC_HISTORY *hdata)
  * Comments: Will generate internal events when item state switches.          *
  *                                                                            *
  ******************************************************************************/
-static zbx_item_diff_t	*calculate_item_update(const DC_ITEM *item, const ZBX_DC_HISTORY *h)
+static zbx_item_diff_t	*calculate_item_update(const zbx_dc_item_hist_t *item, const ZBX_DC_HISTORY *h)
 {
 	zbx_uint64_t	flags = ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTCLOCK;
 	const char	*item_error = NULL;
@@ -1940,7 +2204,7 @@ static zbx_item_diff_t	*calculate_item_update(const DC_ITEM *item, const ZBX_DC_
 		if (ITEM_STATE_NOTSUPPORTED == h->state)
 		{
 			zabbix_log(LOG_LEVEL_WARNING, "item \"%s:%s\" became not supported: %s",
-					item->host.host, item->key_orig, h->value.str);
+					item->host, item->key_orig, h->value.str);
 
 			zbx_add_event(EVENT_SOURCE_INTERNAL, EVENT_OBJECT_ITEM, item->itemid, &h->ts, h->state, NULL,
 					NULL, NULL, 0, 0, NULL, 0, NULL, 0, NULL, NULL, h->value.err);
@@ -1951,7 +2215,7 @@ static zbx_item_diff_t	*calculate_item_update(const DC_ITEM *item, const ZBX_DC_
 		else
 		{
 			zabbix_log(LOG_LEVEL_WARNING, "item \"%s:%s\" became supported",
-					item->host.host, item->key_orig);
+					item->host, item->key_orig);
 
 			/* we know it's EVENT_OBJECT_ITEM because LLDRULE that becomes */
 			/* supported is handled in lld_process_discovery_rule()        */
@@ -1963,7 +2227,7 @@ static zbx_item_diff_t	*calculate_item_update(const DC_ITEM *item, const ZBX_DC_
 	}
 	else if (ITEM_STATE_NOTSUPPORTED == h->state && 0 != strcmp(item->error, h->value.err))
 	{
-		zabbix_log(LOG_LEVEL_WARNING, "error reason for \"%s:%s\" changed: %s", item->host.host,
+		zabbix_log(LOG_LEVEL_WARNING, "error reason for \"%s:%s\" changed: %s", item->host,
 				item->key_orig, h->value.err);
 
 		item_error = h->value.err;
@@ -2397,6 +2661,135 @@ static void	dc_add_proxy_history_notsupported(ZBX_DC_HISTORY *history, int histo
 	zbx_db_insert_clean(&db_insert);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_add_proxy_history_buffer                                      *
+ *                                                                            *
+ * Purpose: write history data to proxy history buffer                        *
+ *                                                                            *
+ * Parameters: history     - array of history data                            *
+ *             history_num - number of history structures                     *
+ *                                                                            *
+ * Return value: SUCCEED - the history data was written to the buffer         *
+ *               FAIL    - the buffer is disabled or cannot accept the data,  *
+ *                         history must be written to database                *
+ *                                                                            *
+ * Comment: the values are selected and converted the same way as in          *
+ *          dc_add_proxy_history*() functions                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_add_proxy_history_buffer(const ZBX_DC_HISTORY *history, int history_num)
+{
+#define ZBX_PB_NUMERIC_LEN	64
+	int			i, values_num = 0, now, ret;
+	char			*buffer;
+	zbx_pb_history_t	*values;
+
+	if (SUCCEED != zbx_pb_enabled())
+		return FAIL;
+
+	now = (int)time(NULL);
+	values = (zbx_pb_history_t *)zbx_malloc(NULL, sizeof(zbx_pb_history_t) * history_num);
+	buffer = (char *)zbx_malloc(NULL, ZBX_PB_NUMERIC_LEN * history_num);
+
+	for (i = 0; i < history_num; i++)
+	{
+		const ZBX_DC_HISTORY	*h = &history[i];
+		zbx_pb_history_t	*value = &values[values_num];
+		char			*pvalue = buffer + ZBX_PB_NUMERIC_LEN * i;
+
+		memset(value, 0, sizeof(zbx_pb_history_t));
+		value->itemid = h->itemid;
+		value->clock = h->ts.sec;
+		value->ns = h->ts.ns;
+		value->write_clock = now;
+		value->source = "";
+		value->value = "";
+
+		if (ITEM_STATE_NOTSUPPORTED == h->state)
+		{
+			value->state = ITEM_STATE_NOTSUPPORTED;
+			value->value = ZBX_NULL2EMPTY_STR(h->value.err);
+			values_num++;
+			continue;
+		}
+
+		if (ITEM_VALUE_TYPE_LOG == h->value_type)
+		{
+			if (0 == (h->flags & ZBX_DC_FLAG_NOVALUE))
+			{
+				const zbx_log_value_t	*log = h->value.log;
+
+				value->timestamp = log->timestamp;
+				value->source = ZBX_NULL2EMPTY_STR(log->source);
+				value->severity = log->severity;
+				value->value = log->value;
+				value->logeventid = log->logeventid;
+
+				if (0 != (h->flags & ZBX_DC_FLAG_META))
+				{
+					value->flags = PROXY_HISTORY_FLAG_META;
+					value->lastlogsize = h->lastlogsize;
+					value->mtime = h->mtime;
+				}
+			}
+			else
+			{
+				value->flags = PROXY_HISTORY_FLAG_META | PROXY_HISTORY_FLAG_NOVALUE;
+				value->lastlogsize = h->lastlogsize;
+				value->mtime = h->mtime;
+			}
+
+			values_num++;
+			continue;
+		}
+
+		if (0 != (h->flags & ZBX_DC_FLAG_UNDEF))
+			continue;
+
+		if (0 != (h->flags & ZBX_DC_FLAG_META))
+		{
+			value->flags = PROXY_HISTORY_FLAG_META;
+			value->lastlogsize = h->lastlogsize;
+			value->mtime = h->mtime;
+		}
+
+		if (0 == (h->flags & ZBX_DC_FLAG_NOVALUE))
+		{
+			switch (h->value_type)
+			{
+				case ITEM_VALUE_TYPE_FLOAT:
+					zbx_snprintf(pvalue, ZBX_PB_NUMERIC_LEN, ZBX_FS_DBL64, h->value.dbl);
+					value->value = pvalue;
+					break;
+				case ITEM_VALUE_TYPE_UINT64:
+					zbx_snprintf(pvalue, ZBX_PB_NUMERIC_LEN, ZBX_FS_UI64, h->value.ui64);
+					value->value = pvalue;
+					break;
+				case ITEM_VALUE_TYPE_STR:
+				case ITEM_VALUE_TYPE_TEXT:
+					value->value = h->value.str;
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					continue;
+			}
+		}
+		else
+			value->flags |= PROXY_HISTORY_FLAG_NOVALUE;
+
+		values_num++;
+	}
+
+	ret = (0 == values_num ? SUCCEED : zbx_pb_history_add(values, values_num));
+
+	zbx_free(buffer);
+	zbx_free(values);
+
+	return ret;
+#undef ZBX_PB_NUMERIC_LEN
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCmass_proxy_add_history                                         *
@@ -2483,7 +2876,7 @@ static void	DCmass_proxy_add_history(ZBX_DC_HISTORY *history, int history_num)
  *                                                                            *
  ******************************************************************************/
 static void	DCmass_prepare_history(ZBX_DC_HISTORY *history, const zbx_vector_uint64_t *itemids,
-		const DC_ITEM *items, const int *errcodes, int history_num, zbx_vector_ptr_t *item_diff,
+		const zbx_dc_item_hist_t *items, const int *errcodes, int history_num, zbx_vector_ptr_t *item_diff,
 		zbx_vector_ptr_t *inventory_values, int compression_age, zbx_vector_uint64_pair_t *proxy_subscribtions)
 {
 	static time_t	last_history_discard = 0;
@@ -2496,10 +2889,10 @@ static void	DCmass_prepare_history(ZBX_DC_HISTORY *history, const zbx_vector_uin
 
 	for (i = 0; i < history_num; i++)
 	{
-		ZBX_DC_HISTORY	*h = &history[i];
-		const DC_ITEM	*item;
-		zbx_item_diff_t	*diff;
-		int		index;
+		ZBX_DC_HISTORY			*h = &history[i];
+		const zbx_dc_item_hist_t	*item;
+		zbx_item_diff_t			*diff;
+		int				index;
 
 		/* discard history items that are older than compression age */
 		if (0 != compression_age && h->ts.sec < compression_age)
@@ -2530,7 +2923,7 @@ static void	DCmass_prepare_history(ZBX_DC_HISTORY *history, const zbx_vector_uin
 
 		item = &items[index];
 
-		if (ITEM_STATUS_ACTIVE != item->status || HOST_STATUS_MONITORED != item->host.status)
+		if (ITEM_STATUS_ACTIVE != item->status || HOST_STATUS_MONITORED != item->host_status)
 		{
 			h->flags |= ZBX_DC_FLAG_UNDEF;
 			continue;
@@ -2544,7 +2937,7 @@ static void	DCmass_prepare_history(ZBX_DC_HISTORY *history, const zbx_vector_uin
 		{
 			h->flags |= ZBX_DC_FLAG_NOHISTORY;
 			zabbix_log(LOG_LEVEL_WARNING, "item \"%s:%s\" value timestamp \"%s %s\" is outside history "
-					"storage period", item->host.host, item->key_orig,
+					"storage period", item->host, item->key_orig,
 					zbx_date2str(h->ts.sec, NULL), zbx_time2str(h->ts.sec, NULL));
 		}
 
@@ -2558,7 +2951,7 @@ static void	DCmass_prepare_history(ZBX_DC_HISTORY *history, const zbx_vector_uin
 			{
 				h->flags |= ZBX_DC_FLAG_NOTRENDS;
 				zabbix_log(LOG_LEVEL_WARNING, "item \"%s:%s\" value timestamp \"%s %s\" is outside "
-						"trends storage period", item->host.host, item->key_orig,
+						"trends storage period", item->host, item->key_orig,
 						zbx_date2str(h->ts.sec, NULL), zbx_time2str(h->ts.sec, NULL));
 			}
 		}
@@ -2571,9 +2964,9 @@ static void	DCmass_prepare_history(ZBX_DC_HISTORY *history, const zbx_vector_uin
 		zbx_vector_ptr_append(item_diff, diff);
 		DCinventory_value_add(inventory_values, item, h);
 
-		if (0 != item->host.proxy_hostid && FAIL == is_item_processed_by_server(item->type, item->key_orig))
+		if (0 != item->proxy_hostid && FAIL == is_item_processed_by_server(item->type, item->key_orig))
 		{
-			zbx_uint64_pair_t	p = {item->host.proxy_hostid, h->ts.sec};
+			zbx_uint64_pair_t	p = {item->proxy_hostid, h->ts.sec};
 
 			zbx_vector_uint64_pair_append(proxy_subscribtions, p);
 		}
@@ -2785,7 +3178,7 @@ static void	DCmodule_sync_history(int history_float_num, int history_integer_num
 static void	proxy_prepare_history(ZBX_DC_HISTORY *history, int history_num)
 {
 	int			i, *errcodes;
-	DC_ITEM			*items;
+	zbx_dc_item_hist_t	*items;
 	zbx_vector_uint64_t	itemids;
 
 	zbx_vector_uint64_create(&itemids);
@@ -2794,10 +3187,10 @@ static void	proxy_prepare_history(ZBX_DC_HISTORY *history, int history_num)
 	for (i = 0; i < history_num; i++)
 		zbx_vector_uint64_append(&itemids, history[i].itemid);
 
-	items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * (size_t)history_num);
+	items = (zbx_dc_item_hist_t *)zbx_malloc(NULL, sizeof(zbx_dc_item_hist_t) * (size_t)history_num);
 	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)history_num);
 
-	DCconfig_get_items_by_itemids(items, itemids.values, errcodes, itemids.values_num);
+	zbx_dc_get_hist_items_by_itemids(items, itemids.values, errcodes, itemids.values_num);
 
 	for (i = 0; i < history_num; i++)
 	{
@@ -2830,7 +3223,7 @@ static void	proxy_prepare_history(ZBX_DC_HISTORY *history, int history_num)
 		history[i].flags |= ZBX_DC_FLAG_NOVALUE;
 	}
 
-	DCconfig_clean_items(items, errcodes, history_num);
+	zbx_dc_clean_hist_items(items, errcodes, history_num);
 	zbx_free(items);
 	zbx_free(errcodes);
 	zbx_vector_uint64_destroy(&itemids);
@@ -2838,7 +3231,7 @@ static void	proxy_prepare_history(ZBX_DC_HISTORY *history, int history_num)
 
 static void	sync_proxy_history(int *total_num, int *more)
 {
-	int			history_num;
+	int			history_num, buffered;
 	time_t			sync_start;
 	zbx_vector_ptr_t	history_items;
 	ZBX_DC_HISTORY		history[ZBX_HC_SYNC_MAX];
@@ -2852,38 +3245,37 @@ static void	sync_proxy_history(int *total_num, int *more)
 	{
 		*more = ZBX_SYNC_DONE;
 
-		LOCK_CACHE;
-
 		hc_pop_items(&history_items);		/* select and take items out of history cache */
 		history_num = history_items.values_num;
 
-		UNLOCK_CACHE;
-
 		if (0 == history_num)
 			break;
 
 		hc_get_item_values(history, &history_items);	/* copy item data from history cache */
 		proxy_prepare_history(history, history_items.values_num);
 
+		/* buffer writes cannot be rolled back, so they are done before database transaction */
+		buffered = dc_add_proxy_history_buffer(history, history_num);
+
 		do
 		{
 			DBbegin();
 
-			DCmass_proxy_add_history(history, history_num);
+			if (SUCCEED != buffered)
+				DCmass_proxy_add_history(history, history_num);
+
 			DCmass_proxy_update_items(history, history_num);
 		}
 		while (ZBX_DB_DOWN == DBcommit());
 
-		LOCK_CACHE;
+		if (SUCCEED != buffered)
+			zbx_pb_history_db_written();
 
 		hc_push_items(&history_items);	/* return items to history cache */
-		cache->history_num -= history_num;
 
 		if (0 != hc_queue_get_size())
 			*more = ZBX_SYNC_MORE;
 
-		UNLOCK_CACHE;
-
 		*total_num += history_num;
 
 		zbx_vector_ptr_clear(&history_items);
@@ -2988,24 +3380,20 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 	do
 	{
-		DC_ITEM			*items;
+		zbx_dc_item_hist_t	*items;
 		int			*errcodes, trends_num = 0, timers_num = 0, ret = SUCCEED;
 		zbx_vector_uint64_t	itemids;
 		ZBX_DC_TREND		*trends = NULL;
 
 		*more = ZBX_SYNC_DONE;
 
-		LOCK_CACHE;
 		hc_pop_items(&history_items);		/* select and take items out of history cache */
-		UNLOCK_CACHE;
 
 		if (0 != history_items.values_num)
 		{
 			if (0 == (history_num = DCconfig_lock_triggers_by_history_items(&history_items, &triggerids)))
 			{
-				LOCK_CACHE;
 				hc_push_items(&history_items);
-				UNLOCK_CACHE;
 				zbx_vector_ptr_clear(&history_items);
 			}
 		}
@@ -3016,7 +3404,7 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 		{
 			hc_get_item_values(history, &history_items);	/* copy item data from history cache */
 
-			items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * (size_t)history_num);
+			items = (zbx_dc_item_hist_t *)zbx_malloc(NULL, sizeof(zbx_dc_item_hist_t) * (size_t)history_num);
 			errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)history_num);
 
 			zbx_vector_uint64_create(&itemids);
@@ -3027,7 +3415,7 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 			zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-			DCconfig_get_items_by_itemids(items, itemids.values, errcodes, history_num);
+			zbx_dc_get_hist_items_by_itemids(items, itemids.values, errcodes, history_num);
 
 			DCmass_prepare_history(history, &itemids, items, errcodes, history_num, &item_diff,
 					&inventory_values, compression_age, &proxy_subscribtions);
@@ -3137,9 +3525,7 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 		if (0 != history_num)
 		{
-			LOCK_CACHE;
 			hc_push_items(&history_items);	/* return items to history cache */
-			cache->history_num -= history_num;
 
 			if (0 != hc_queue_get_size())
 			{
@@ -3152,8 +3538,6 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 					*more = ZBX_SYNC_MORE;
 			}
 
-			UNLOCK_CACHE;
-
 			*values_num += history_num;
 		}
 
@@ -3190,7 +3574,7 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 		{
 			zbx_free(trends);
 			zbx_vector_uint64_destroy(&itemids);
-			DCconfig_clean_items(items, errcodes, history_num);
+			zbx_dc_clean_hist_items(items, errcodes, history_num);
 			zbx_free(errcodes);
 			zbx_free(items);
 
@@ -3228,12 +3612,13 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
  ******************************************************************************/
 static void	sync_history_cache_full(void)
 {
-	int			values_num = 0, triggers_num = 0, more;
+	int			values_num = 0, triggers_num = 0, more, i;
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
-	zbx_binary_heap_t	tmp_history_queue;
+	zbx_binary_heap_t	tmp_history_queue[ZBX_HC_STRIPES_MAX];
+	zbx_hc_stripe_t		*stripe;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, hc_get_history_num());
 
 	/* History index cache might be full without any space left for queueing items from history index to  */
 	/* history queue. The solution: replace the shared-memory history queue with heap-allocated one. Add  */
@@ -3252,18 +3637,23 @@ static void	sync_history_cache_full(void)
 		DCconfig_unlock_all_triggers();
 	}
 
-	tmp_history_queue = cache->history_queue;
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
+	{
+		stripe = &cache->stripes[i];
+		tmp_history_queue[i] = stripe->history_queue;
 
-	zbx_binary_heap_create(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
+		zbx_binary_heap_create(&stripe->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY);
+		zbx_hashset_iter_reset(&stripe->history_items, &iter);
 
-	/* add all items from history index to the new history queue */
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL != item->tail)
+		/* add all items from history index to the new history queue */
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
 		{
-			item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-			hc_queue_item(item);
+			if (NULL != item->tail)
+			{
+				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+				hc_queue_item(stripe, item);
+			}
 		}
 	}
 
@@ -3279,15 +3669,19 @@ static void	sync_history_cache_full(void)
 				sync_proxy_history(&values_num, &more);
 
 			zabbix_log(LOG_LEVEL_WARNING, "syncing history data... " ZBX_FS_DBL "%%",
-					(double)values_num / (cache->history_num + values_num) * 100);
+					(double)values_num / (hc_get_history_num() + values_num) * 100);
 		}
 		while (0 != hc_queue_get_size());
 
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data done");
 	}
 
-	zbx_binary_heap_destroy(&cache->history_queue);
-	cache->history_queue = tmp_history_queue;
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
+	{
+		stripe = &cache->stripes[i];
+		zbx_binary_heap_destroy(&stripe->history_queue);
+		stripe->history_queue = tmp_history_queue[i];
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -3302,7 +3696,9 @@ static void	sync_history_cache_full(void)
 void	zbx_log_sync_history_cache_progress(void)
 {
 	double		pcnt = -1.0;
-	int		ts_last, ts_next, sec;
+	int		ts_last, ts_next, sec, history_num;
+
+	history_num = hc_get_history_num();
 
 	LOCK_CACHE;
 
@@ -3317,16 +3713,16 @@ void	zbx_log_sync_history_cache_progress(void)
 
 	if (0 == cache->history_progress_ts)
 	{
-		cache->history_num_total = cache->history_num;
+		cache->history_num_total = history_num;
 		cache->history_progress_ts = sec;
 	}
 
-	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == cache->history_num)
+	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == history_num)
 	{
 		if (0 != cache->history_num_total)
-			pcnt = 100 * (double)(cache->history_num_total - cache->history_num) / cache->history_num_total;
+			pcnt = 100 * (double)(cache->history_num_total - history_num) / cache->history_num_total;
 
-		cache->history_progress_ts = (0 == cache->history_num ? INT_MAX : sec);
+		cache->history_progress_ts = (0 == history_num ? INT_MAX : sec);
 	}
 
 	ts_next = cache->history_progress_ts;
@@ -3357,7 +3753,7 @@ void	zbx_log_sync_history_cache_progress(void)
  ******************************************************************************/
 void	zbx_sync_history_cache(int *values_num, int *triggers_num, int *more)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, hc_get_history_num());
 
 	*values_num = 0;
 	*triggers_num = 0;
@@ -3720,14 +4116,8 @@ void	dc_flush_history(void)
 	if (0 == item_values_num)
 		return;
 
-	LOCK_CACHE;
-
 	hc_add_item_values(item_values, item_values_num);
 
-	cache->history_num += item_values_num;
-
-	UNLOCK_CACHE;
-
 	item_values_num = 0;
 	string_values_offset = 0;
 }
@@ -3737,8 +4127,53 @@ void	dc_flush_history(void)
  * history cache storage                                                      *
  *                                                                            *
  ******************************************************************************/
-ZBX_MEM_FUNC_IMPL(__hc_index, hc_index_mem)
-ZBX_MEM_FUNC_IMPL(__hc, hc_mem)
+ZBX_MEM_FUNC_IMPL(__hc_index0, hc_index_mem[0])
+ZBX_MEM_FUNC_IMPL(__hc_index1, hc_index_mem[1])
+ZBX_MEM_FUNC_IMPL(__hc_index2, hc_index_mem[2])
+ZBX_MEM_FUNC_IMPL(__hc_index3, hc_index_mem[3])
+ZBX_MEM_FUNC_IMPL(__hc_index4, hc_index_mem[4])
+ZBX_MEM_FUNC_IMPL(__hc_index5, hc_index_mem[5])
+ZBX_MEM_FUNC_IMPL(__hc_index6, hc_index_mem[6])
+ZBX_MEM_FUNC_IMPL(__hc_index7, hc_index_mem[7])
+
+typedef struct
+{
+	zbx_mem_malloc_func_t	malloc_func;
+	zbx_mem_realloc_func_t	realloc_func;
+	zbx_mem_free_func_t	free_func;
+}
+zbx_hc_mem_funcs_t;
+
+#define ZBX_HC_INDEX_MEM_FUNCS(__prefix)	\
+	{__prefix##_mem_malloc_func, __prefix##_mem_realloc_func, __prefix##_mem_free_func}
+
+/* history index allocators of each stripe, used by the stripe hashset and binary heap */
+static const zbx_hc_mem_funcs_t	hc_index_mem_funcs[ZBX_HC_STRIPES_MAX] = {
+	ZBX_HC_INDEX_MEM_FUNCS(__hc_index0),
+	ZBX_HC_INDEX_MEM_FUNCS(__hc_index1),
+	ZBX_HC_INDEX_MEM_FUNCS(__hc_index2),
+	ZBX_HC_INDEX_MEM_FUNCS(__hc_index3),
+	ZBX_HC_INDEX_MEM_FUNCS(__hc_index4),
+	ZBX_HC_INDEX_MEM_FUNCS(__hc_index5),
+	ZBX_HC_INDEX_MEM_FUNCS(__hc_index6),
+	ZBX_HC_INDEX_MEM_FUNCS(__hc_index7)
+};
+
+#undef ZBX_HC_INDEX_MEM_FUNCS
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_stripe                                                    *
+ *                                                                            *
+ * Purpose: returns index of the history cache stripe owning the item        *
+ *                                                                            *
+ * Parameters: itemid - [IN] the item id                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_stripe(zbx_uint64_t itemid)
+{
+	return (int)(ZBX_DEFAULT_UINT64_HASH_FUNC(&itemid) % CONFIG_HISTORY_CACHE_STRIPES);
+}
 
 /******************************************************************************
  *                                                                            *
@@ -3765,14 +4200,17 @@ static int	hc_queue_elem_compare_func(const void *d1, const void *d2)
  *                                                                            *
  * Purpose: free history item data allocated in history cache                 *
  *                                                                            *
- * Parameters: data - [IN] history item data                                  *
+ * Parameters: stripe_num - [IN] the history cache stripe                     *
+ *             data       - [IN] history item data                            *
  *                                                                            *
  ******************************************************************************/
-static void	hc_free_data(zbx_hc_data_t *data)
+static void	hc_free_data(int stripe_num, zbx_hc_data_t *data)
 {
+	zbx_mem_info_t	*mem = hc_mem[stripe_num];
+
 	if (ITEM_STATE_NOTSUPPORTED == data->state)
 	{
-		__hc_mem_free_func(data->value.str);
+		zbx_mem_free(mem, data->value.str);
 	}
 	else
 	{
@@ -3782,21 +4220,21 @@ static void	hc_free_data(zbx_hc_data_t *data)
 			{
 				case ITEM_VALUE_TYPE_STR:
 				case ITEM_VALUE_TYPE_TEXT:
-					__hc_mem_free_func(data->value.str);
+					zbx_mem_free(mem, data->value.str);
 					break;
 				case ITEM_VALUE_TYPE_LOG:
-					__hc_mem_free_func(data->value.log->value);
+					zbx_mem_free(mem, data->value.log->value);
 
 					if (NULL != data->value.log->source)
-						__hc_mem_free_func(data->value.log->source);
+						zbx_mem_free(mem, data->value.log->source);
 
-					__hc_mem_free_func(data->value.log);
+					zbx_mem_free(mem, data->value.log);
 					break;
 			}
 		}
 	}
 
-	__hc_mem_free_func(data);
+	zbx_mem_free(mem, data);
 }
 
 /******************************************************************************
@@ -3805,14 +4243,15 @@ static void	hc_free_data(zbx_hc_data_t *data)
  *                                                                            *
  * Purpose: put back item into history queue                                  *
  *                                                                            *
- * Parameters: data - [IN] history item data                                  *
+ * Parameters: stripe - [IN] the history cache stripe owning the item          *
+ *             item   - [IN] history item                                     *
  *                                                                            *
  ******************************************************************************/
-static void	hc_queue_item(zbx_hc_item_t *item)
+static void	hc_queue_item(zbx_hc_stripe_t *stripe, zbx_hc_item_t *item)
 {
 	zbx_binary_heap_elem_t	elem = {item->itemid, (const void *)item};
 
-	zbx_binary_heap_insert(&cache->history_queue, &elem);
+	zbx_binary_heap_insert(&stripe->history_queue, &elem);
 }
 
 /******************************************************************************
@@ -3821,15 +4260,16 @@ static void	hc_queue_item(zbx_hc_item_t *item)
  *                                                                            *
  * Purpose: returns history item by itemid                                    *
  *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
+ * Parameters: stripe - [IN] the history cache stripe owning the item          *
+ *             itemid - [IN] the item id                                      *
  *                                                                            *
  * Return value: the history item or NULL if the requested item is not in     *
  *               history cache                                                *
  *                                                                            *
  ******************************************************************************/
-static zbx_hc_item_t	*hc_get_item(zbx_uint64_t itemid)
+static zbx_hc_item_t	*hc_get_item(zbx_hc_stripe_t *stripe, zbx_uint64_t itemid)
 {
-	return (zbx_hc_item_t *)zbx_hashset_search(&cache->history_items, &itemid);
+	return (zbx_hc_item_t *)zbx_hashset_search(&stripe->history_items, &itemid);
 }
 
 /******************************************************************************
@@ -3838,17 +4278,18 @@ static zbx_hc_item_t	*hc_get_item(zbx_uint64_t itemid)
  *                                                                            *
  * Purpose: adds a new item to history cache                                  *
  *                                                                            *
- * Parameters: itemid - [IN] the item id                                      *
- *                      [IN] the item data                                    *
+ * Parameters: stripe - [IN] the history cache stripe owning the item          *
+ *             itemid - [IN] the item id                                      *
+ *             data   - [IN] the item data                                    *
  *                                                                            *
  * Return value: the added history item                                       *
  *                                                                            *
  ******************************************************************************/
-static zbx_hc_item_t	*hc_add_item(zbx_uint64_t itemid, zbx_hc_data_t *data)
+static zbx_hc_item_t	*hc_add_item(zbx_hc_stripe_t *stripe, zbx_uint64_t itemid, zbx_hc_data_t *data)
 {
 	zbx_hc_item_t	item_local = {itemid, ZBX_HC_ITEM_STATUS_NORMAL, 0, data, data};
 
-	return (zbx_hc_item_t *)zbx_hashset_insert(&cache->history_items, &item_local, sizeof(item_local));
+	return (zbx_hc_item_t *)zbx_hashset_insert(&stripe->history_items, &item_local, sizeof(item_local));
 }
 
 /******************************************************************************
@@ -3857,16 +4298,17 @@ static zbx_hc_item_t	*hc_add_item(zbx_uint64_t itemid, zbx_hc_data_t *data)
  *                                                                            *
  * Purpose: copies string value to history cache                              *
  *                                                                            *
- * Parameters: str - [IN] the string value                                    *
+ * Parameters: stripe_num - [IN] the history cache stripe                     *
+ *             str        - [IN] the string value                             *
  *                                                                            *
  * Return value: the copied string or NULL if there was not enough memory     *
  *                                                                            *
  ******************************************************************************/
-static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
+static char	*hc_mem_value_str_dup(int stripe_num, const dc_value_str_t *str)
 {
 	char	*ptr;
 
-	if (NULL == (ptr = (char *)__hc_mem_malloc_func(NULL, str->len)))
+	if (NULL == (ptr = (char *)zbx_mem_malloc(hc_mem[stripe_num], NULL, str->len)))
 		return NULL;
 
 	memcpy(ptr, &string_values[str->pvalue], str->len - 1);
@@ -3881,8 +4323,9 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *                                                                            *
  * Purpose: clones string value into history data memory                      *
  *                                                                            *
- * Parameters: dst - [IN/OUT] a reference to the cloned value                 *
- *             str - [IN] the string value to clone                           *
+ * Parameters: stripe_num - [IN] the history cache stripe                     *
+ *             dst        - [IN/OUT] a reference to the cloned value          *
+ *             str        - [IN] the string value to clone                    *
  *                                                                            *
  * Return value: SUCCESS - either there was no need to clone the string       *
  *                         (it was empty or already cloned) or the string was *
@@ -3893,7 +4336,7 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *           until it finishes cloning string value.                          *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
+static int	hc_clone_history_str_data(int stripe_num, char **dst, const dc_value_str_t *str)
 {
 	if (0 == str->len)
 		return SUCCEED;
@@ -3901,7 +4344,7 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
 	if (NULL != *dst)
 		return SUCCEED;
 
-	if (NULL != (*dst = hc_mem_value_str_dup(str)))
+	if (NULL != (*dst = hc_mem_value_str_dup(stripe_num, str)))
 		return SUCCEED;
 
 	return FAIL;
@@ -3913,7 +4356,8 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *                                                                            *
  * Purpose: clones log value into history data memory                         *
  *                                                                            *
- * Parameters: dst        - [IN/OUT] a reference to the cloned value          *
+ * Parameters: stripe_num - [IN] the history cache stripe                     *
+ *             dst        - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the log value to clone                       *
  *                                                                            *
  * Return value: SUCCESS - the log value was cloned successfully              *
@@ -3923,21 +4367,24 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *           until it finishes cloning log value.                             *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_t *item_value)
+static int	hc_clone_history_log_data(int stripe_num, zbx_log_value_t **dst, const dc_item_value_t *item_value)
 {
 	if (NULL == *dst)
 	{
-		/* using realloc instead of malloc just to suppress 'not used' warning for realloc */
-		if (NULL == (*dst = (zbx_log_value_t *)__hc_mem_realloc_func(NULL, sizeof(zbx_log_value_t))))
+		if (NULL == (*dst = (zbx_log_value_t *)zbx_mem_malloc(hc_mem[stripe_num], NULL,
+				sizeof(zbx_log_value_t))))
+		{
 			return FAIL;
+		}
+
 
 		memset(*dst, 0, sizeof(zbx_log_value_t));
 	}
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->value, &item_value->value.value_str))
+	if (SUCCEED != hc_clone_history_str_data(stripe_num, &(*dst)->value, &item_value->value.value_str))
 		return FAIL;
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->source, &item_value->source))
+	if (SUCCEED != hc_clone_history_str_data(stripe_num, &(*dst)->source, &item_value->source))
 		return FAIL;
 
 	(*dst)->logeventid = item_value->logeventid;
@@ -3953,7 +4400,8 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *                                                                            *
  * Purpose: clones item value from local cache into history cache             *
  *                                                                            *
- * Parameters: data       - [IN/OUT] a reference to the cloned value          *
+ * Parameters: stripe_num - [IN] the history cache stripe                     *
+ *             data       - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the item value                               *
  *                                                                            *
  * Return value: SUCCESS - the item value was cloned successfully             *
@@ -3963,11 +4411,13 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *           until it finishes cloning item value.                            *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value)
+static int	hc_clone_history_data(int stripe_num, zbx_hc_data_t **data, const dc_item_value_t *item_value)
 {
+	ZBX_DC_STATS	*stats = &cache->stripes[stripe_num].stats;
+
 	if (NULL == *data)
 	{
-		if (NULL == (*data = (zbx_hc_data_t *)__hc_mem_malloc_func(NULL, sizeof(zbx_hc_data_t))))
+		if (NULL == (*data = (zbx_hc_data_t *)zbx_mem_malloc(hc_mem[stripe_num], NULL, sizeof(zbx_hc_data_t))))
 			return FAIL;
 
 		memset(*data, 0, sizeof(zbx_hc_data_t));
@@ -3985,24 +4435,24 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 	if (ITEM_STATE_NOTSUPPORTED == item_value->state)
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(stripe_num, &item_value->value.value_str)))
 			return FAIL;
 
 		(*data)->value_type = item_value->value_type;
-		cache->stats.notsupported_counter++;
+		stats->notsupported_counter++;
 
 		return SUCCEED;
 	}
 
 	if (0 != (ZBX_DC_FLAG_LLD & item_value->flags))
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(stripe_num, &item_value->value.value_str)))
 			return FAIL;
 
 		(*data)->value_type = ITEM_VALUE_TYPE_TEXT;
 
-		cache->stats.history_text_counter++;
-		cache->stats.history_counter++;
+		stats->history_text_counter++;
+		stats->history_counter++;
 
 		return SUCCEED;
 	}
@@ -4018,21 +4468,21 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 				(*data)->value.ui64 = item_value->value.value_uint;
 				break;
 			case ITEM_VALUE_TYPE_STR:
-				if (SUCCEED != hc_clone_history_str_data(&(*data)->value.str,
+				if (SUCCEED != hc_clone_history_str_data(stripe_num, &(*data)->value.str,
 						&item_value->value.value_str))
 				{
 					return FAIL;
 				}
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
-				if (SUCCEED != hc_clone_history_str_data(&(*data)->value.str,
+				if (SUCCEED != hc_clone_history_str_data(stripe_num, &(*data)->value.str,
 						&item_value->value.value_str))
 				{
 					return FAIL;
 				}
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				if (SUCCEED != hc_clone_history_log_data(&(*data)->value.log, item_value))
+				if (SUCCEED != hc_clone_history_log_data(stripe_num, &(*data)->value.log, item_value))
 					return FAIL;
 				break;
 		}
@@ -4040,23 +4490,23 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 		switch (item_value->item_value_type)
 		{
 			case ITEM_VALUE_TYPE_FLOAT:
-				cache->stats.history_float_counter++;
+				stats->history_float_counter++;
 				break;
 			case ITEM_VALUE_TYPE_UINT64:
-				cache->stats.history_uint_counter++;
+				stats->history_uint_counter++;
 				break;
 			case ITEM_VALUE_TYPE_STR:
-				cache->stats.history_str_counter++;
+				stats->history_str_counter++;
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
-				cache->stats.history_text_counter++;
+				stats->history_text_counter++;
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				cache->stats.history_log_counter++;
+				stats->history_log_counter++;
 				break;
 		}
 
-		cache->stats.history_counter++;
+		stats->history_counter++;
 	}
 
 	(*data)->value_type = item_value->value_type;
@@ -4077,40 +4527,63 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
  *           history syncers processes values freeing enough space to store   *
  *           the new value.                                                   *
  *                                                                            *
+ *           Values are added stripe by stripe, locking only the stripe being *
+ *           updated. The order of values of the same item is preserved.      *
+ *                                                                            *
  ******************************************************************************/
 static void	hc_add_item_values(dc_item_value_t *values, int values_num)
 {
 	dc_item_value_t	*item_value;
-	int		i;
+	int		i, stripe_num, added_num;
 	zbx_hc_item_t	*item;
+	zbx_hc_stripe_t	*stripe;
 
-	for (i = 0; i < values_num; i++)
+	for (stripe_num = 0; stripe_num < CONFIG_HISTORY_CACHE_STRIPES; stripe_num++)
 	{
-		zbx_hc_data_t	*data = NULL;
-
-		item_value = &values[i];
+		stripe = &cache->stripes[stripe_num];
+		added_num = 0;
 
-		while (SUCCEED != hc_clone_history_data(&data, item_value))
+		for (i = 0; i < values_num; i++)
 		{
-			UNLOCK_CACHE;
+			zbx_hc_data_t	*data = NULL;
 
-			zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
-			sleep(1);
+			item_value = &values[i];
 
-			LOCK_CACHE;
-		}
+			if (stripe_num != hc_get_stripe(item_value->itemid))
+				continue;
 
-		if (NULL == (item = hc_get_item(item_value->itemid)))
-		{
-			item = hc_add_item(item_value->itemid, data);
-			hc_queue_item(item);
+			if (0 == added_num)
+				LOCK_STRIPE(stripe_num);
+
+			while (SUCCEED != hc_clone_history_data(stripe_num, &data, item_value))
+			{
+				UNLOCK_STRIPE(stripe_num);
+
+				zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
+				sleep(1);
+
+				LOCK_STRIPE(stripe_num);
+			}
+
+			if (NULL == (item = hc_get_item(stripe, item_value->itemid)))
+			{
+				item = hc_add_item(stripe, item_value->itemid, data);
+				hc_queue_item(stripe, item);
+			}
+			else
+			{
+				item->head->next = data;
+				item->head = data;
+			}
+			item->values_num++;
+			added_num++;
 		}
-		else
+
+		if (0 != added_num)
 		{
-			item->head->next = data;
-			item->head = data;
+			stripe->history_num += added_num;
+			UNLOCK_STRIPE(stripe_num);
 		}
-		item->values_num++;
 	}
 }
 
@@ -4189,19 +4662,50 @@ static void	hc_copy_history_data(ZBX_DC_HISTORY *history, zbx_uint64_t itemid, z
  * Comments: The history_items must be returned back to history cache with    *
  *           hc_push_items() function after they have been processed.         *
  *                                                                            *
+ *           The batch is first filled with an equal share of the oldest      *
+ *           items from each stripe and then topped up from any stripe still  *
+ *           having queued items. The starting stripe is rotated between      *
+ *           calls and syncer processes start from different stripes, so     *
+ *           concurrent syncers do not contend for the same lock.             *
+ *                                                                            *
  ******************************************************************************/
 static void	hc_pop_items(zbx_vector_ptr_t *history_items)
 {
+	static int		stripe_offset = -1;
 	zbx_binary_heap_elem_t	*elem;
 	zbx_hc_item_t		*item;
+	zbx_hc_stripe_t		*stripe;
+	int			i, stripe_num, limit, quota = ZBX_HC_SYNC_MAX / CONFIG_HISTORY_CACHE_STRIPES;
+
+	/* the offset is local to each syncer process, start syncers from different stripes */
+	if (-1 == stripe_offset)
+		stripe_offset = process_num;
 
-	while (ZBX_HC_SYNC_MAX > history_items->values_num && FAIL == zbx_binary_heap_empty(&cache->history_queue))
+	stripe_offset = (stripe_offset + 1) % CONFIG_HISTORY_CACHE_STRIPES;
+
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES * 2 && ZBX_HC_SYNC_MAX > history_items->values_num; i++)
 	{
-		elem = zbx_binary_heap_find_min(&cache->history_queue);
-		item = (zbx_hc_item_t *)elem->data;
-		zbx_vector_ptr_append(history_items, item);
+		stripe_num = (stripe_offset + i) % CONFIG_HISTORY_CACHE_STRIPES;
+		stripe = &cache->stripes[stripe_num];
+
+		/* first pass takes stripe quota, second pass fills the remaining batch space */
+		if (CONFIG_HISTORY_CACHE_STRIPES > i)
+			limit = MIN(ZBX_HC_SYNC_MAX, history_items->values_num + quota);
+		else
+			limit = ZBX_HC_SYNC_MAX;
+
+		LOCK_STRIPE(stripe_num);
 
-		zbx_binary_heap_remove_min(&cache->history_queue);
+		while (limit > history_items->values_num && FAIL == zbx_binary_heap_empty(&stripe->history_queue))
+		{
+			elem = zbx_binary_heap_find_min(&stripe->history_queue);
+			item = (zbx_hc_item_t *)elem->data;
+			zbx_vector_ptr_append(history_items, item);
+
+			zbx_binary_heap_remove_min(&stripe->history_queue);
+		}
+
+		UNLOCK_STRIPE(stripe_num);
 	}
 }
 
@@ -4249,33 +4753,49 @@ static void	hc_get_item_values(ZBX_DC_HISTORY *history, zbx_vector_ptr_t *histor
  ******************************************************************************/
 void	hc_push_items(zbx_vector_ptr_t *history_items)
 {
-	int		i;
+	int		i, stripe_num, locked_num = -1;
 	zbx_hc_item_t	*item;
 	zbx_hc_data_t	*data_free;
+	zbx_hc_stripe_t	*stripe = NULL;
 
 	for (i = 0; i < history_items->values_num; i++)
 	{
 		item = (zbx_hc_item_t *)history_items->values[i];
 
+		/* items are popped stripe by stripe, so the lock changes only at stripe boundaries */
+		if ((stripe_num = hc_get_stripe(item->itemid)) != locked_num)
+		{
+			if (-1 != locked_num)
+				UNLOCK_STRIPE(locked_num);
+
+			locked_num = stripe_num;
+			stripe = &cache->stripes[stripe_num];
+			LOCK_STRIPE(locked_num);
+		}
+
 		switch (item->status)
 		{
 			case ZBX_HC_ITEM_STATUS_BUSY:
 				/* reset item status before returning it to queue */
 				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-				hc_queue_item(item);
+				hc_queue_item(stripe, item);
 				break;
 			case ZBX_HC_ITEM_STATUS_NORMAL:
 				item->values_num--;
+				stripe->history_num--;
 				data_free = item->tail;
 				item->tail = item->tail->next;
-				hc_free_data(data_free);
+				hc_free_data(stripe_num, data_free);
 				if (NULL == item->tail)
-					zbx_hashset_remove(&cache->history_items, item);
+					zbx_hashset_remove(&stripe->history_items, item);
 				else
-					hc_queue_item(item);
+					hc_queue_item(stripe, item);
 				break;
 		}
 	}
+
+	if (-1 != locked_num)
+		UNLOCK_STRIPE(locked_num);
 }
 
 /******************************************************************************
@@ -4287,7 +4807,121 @@ void	hc_push_items(zbx_vector_ptr_t *history_items)
  ******************************************************************************/
 int	hc_queue_get_size(void)
 {
-	return cache->history_queue.elems_num;
+	int	i, size = 0;
+
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
+	{
+		LOCK_STRIPE(i);
+		size += cache->stripes[i].history_queue.elems_num;
+		UNLOCK_STRIPE(i);
+	}
+
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_history_num                                               *
+ *                                                                            *
+ * Purpose: retrieve the number of values in history cache                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_history_num(void)
+{
+	int	i, history_num = 0;
+
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
+	{
+		LOCK_STRIPE(i);
+		history_num += cache->stripes[i].history_num;
+		UNLOCK_STRIPE(i);
+	}
+
+	return history_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_wcache_stats                                              *
+ *                                                                            *
+ * Purpose: get history cache value counters summed over all stripes          *
+ *                                                                            *
+ * Parameters: stats - [OUT] the history cache value counters                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_get_wcache_stats(ZBX_DC_STATS *stats)
+{
+	int		i;
+	ZBX_DC_STATS	*stripe_stats;
+
+	memset(stats, 0, sizeof(ZBX_DC_STATS));
+
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
+	{
+		stripe_stats = &cache->stripes[i].stats;
+
+		LOCK_STRIPE(i);
+
+		stats->history_counter += stripe_stats->history_counter;
+		stats->history_float_counter += stripe_stats->history_float_counter;
+		stats->history_uint_counter += stripe_stats->history_uint_counter;
+		stats->history_str_counter += stripe_stats->history_str_counter;
+		stats->history_log_counter += stripe_stats->history_log_counter;
+		stats->history_text_counter += stripe_stats->history_text_counter;
+		stats->notsupported_counter += stripe_stats->notsupported_counter;
+
+		UNLOCK_STRIPE(i);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_wcache_mem                                                *
+ *                                                                            *
+ * Purpose: get history cache memory usage summed over all stripes            *
+ *                                                                            *
+ * Parameters: wcache_info - [OUT] the history cache statistics               *
+ *                                                                            *
+ * Comments: Only history and history index memory fields are set.            *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_get_wcache_mem(zbx_wcache_info_t *wcache_info)
+{
+	int	i;
+
+	wcache_info->history_free = 0;
+	wcache_info->history_total = 0;
+	wcache_info->index_free = 0;
+	wcache_info->index_total = 0;
+
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
+	{
+		LOCK_STRIPE(i);
+
+		wcache_info->history_free += hc_mem[i]->free_size;
+		wcache_info->history_total += hc_mem[i]->total_size;
+		wcache_info->index_free += hc_index_mem[i]->free_size;
+		wcache_info->index_total += hc_index_mem[i]->total_size;
+
+		UNLOCK_STRIPE(i);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_wcache_info                                               *
+ *                                                                            *
+ * Purpose: get history cache statistics summed over all stripes              *
+ *                                                                            *
+ * Parameters: wcache_info - [OUT] the history cache statistics               *
+ *                                                                            *
+ * Comments: Trend cache fields are not touched.                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_get_wcache_info(zbx_wcache_info_t *wcache_info)
+{
+	hc_get_wcache_stats(&wcache_info->stats);
+	hc_get_wcache_mem(wcache_info);
 }
 
 int	hc_get_history_compression_age(void)
@@ -4344,6 +4978,8 @@ static int	init_trend_cache(char **error)
 
 	cache->trends_num = 0;
 	cache->trends_last_cleanup_hour = 0;
+	cache->trends_owned_from = 0;
+	cache->trends_max_clock = 0;
 
 #define INIT_HASHSET_SIZE	100	/* Should be calculated dynamically based on trends size? */
 					/* Still does not make sense to have it more than initial */
@@ -4353,6 +4989,13 @@ static int	init_trend_cache(char **error)
 			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
 			__trend_mem_malloc_func, __trend_mem_realloc_func, __trend_mem_free_func);
 
+	zbx_hashset_create_ext(&cache->trends_pending, INIT_HASHSET_SIZE,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			__trend_mem_malloc_func, __trend_mem_realloc_func, __trend_mem_free_func);
+
+	zbx_binary_heap_create_ext(&cache->trends_queue, dc_trend_queue_compare_func, ZBX_BINARY_HEAP_OPTION_DIRECT,
+			__trend_mem_malloc_func, __trend_mem_realloc_func, __trend_mem_free_func);
+
 #undef INIT_HASHSET_SIZE
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -4371,7 +5014,9 @@ out:
  ******************************************************************************/
 int	init_database_cache(char **error)
 {
-	int	ret;
+	int				ret, i;
+	zbx_hc_stripe_t			*stripe;
+	const zbx_hc_mem_funcs_t	*funcs;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -4381,30 +5026,48 @@ int	init_database_cache(char **error)
 	if (SUCCEED != (ret = zbx_mutex_create(&cache_ids_lock, ZBX_MUTEX_CACHE_IDS, error)))
 		goto out;
 
-	if (SUCCEED != (ret = zbx_mem_create(&hc_mem, CONFIG_HISTORY_CACHE_SIZE, "history cache",
-			"HistoryCacheSize", 1, error)))
+	/* history cache and history index cache sizes are split evenly between stripes */
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
 	{
-		goto out;
-	}
+		if (SUCCEED != (ret = zbx_mutex_create(&hc_locks[i], (zbx_mutex_name_t)(ZBX_MUTEX_CACHE_STRIPE_0 + i),
+				error)))
+		{
+			goto out;
+		}
 
-	if (SUCCEED != (ret = zbx_mem_create(&hc_index_mem, CONFIG_HISTORY_INDEX_CACHE_SIZE, "history index cache",
-			"HistoryIndexCacheSize", 0, error)))
-	{
-		goto out;
+		if (SUCCEED != (ret = zbx_mem_create(&hc_mem[i], CONFIG_HISTORY_CACHE_SIZE /
+				CONFIG_HISTORY_CACHE_STRIPES, "history cache", "HistoryCacheSize", 1, error)))
+		{
+			goto out;
+		}
+
+		if (SUCCEED != (ret = zbx_mem_create(&hc_index_mem[i], CONFIG_HISTORY_INDEX_CACHE_SIZE /
+				CONFIG_HISTORY_CACHE_STRIPES, "history index cache", "HistoryIndexCacheSize", 0, error)))
+		{
+			goto out;
+		}
 	}
 
-	cache = (ZBX_DC_CACHE *)__hc_index_mem_malloc_func(NULL, sizeof(ZBX_DC_CACHE));
+	funcs = &hc_index_mem_funcs[0];
+
+	cache = (ZBX_DC_CACHE *)funcs->malloc_func(NULL, sizeof(ZBX_DC_CACHE));
 	memset(cache, 0, sizeof(ZBX_DC_CACHE));
 
-	ids = (ZBX_DC_IDS *)__hc_index_mem_malloc_func(NULL, sizeof(ZBX_DC_IDS));
+	ids = (ZBX_DC_IDS *)funcs->malloc_func(NULL, sizeof(ZBX_DC_IDS));
 	memset(ids, 0, sizeof(ZBX_DC_IDS));
 
-	zbx_hashset_create_ext(&cache->history_items, ZBX_HC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__hc_index_mem_malloc_func, __hc_index_mem_realloc_func, __hc_index_mem_free_func);
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
+	{
+		stripe = &cache->stripes[i];
+		funcs = &hc_index_mem_funcs[i];
 
-	zbx_binary_heap_create_ext(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY,
-			__hc_index_mem_malloc_func, __hc_index_mem_realloc_func, __hc_index_mem_free_func);
+		zbx_hashset_create_ext(&stripe->history_items, ZBX_HC_ITEMS_INIT_SIZE / CONFIG_HISTORY_CACHE_STRIPES,
+				ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+				funcs->malloc_func, funcs->realloc_func, funcs->free_func);
+
+		zbx_binary_heap_create_ext(&stripe->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY, funcs->malloc_func, funcs->realloc_func, funcs->free_func);
+	}
 
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 	{
@@ -4456,6 +5119,8 @@ static void	DCsync_all(void)
  ******************************************************************************/
 void	free_database_cache(void)
 {
+	int	i;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	DCsync_all();
@@ -4465,6 +5130,9 @@ void	free_database_cache(void)
 	zbx_mutex_destroy(&cache_lock);
 	zbx_mutex_destroy(&cache_ids_lock);
 
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
+		zbx_mutex_destroy(&hc_locks[i]);
+
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 		zbx_mutex_destroy(&trends_lock);
 
@@ -4612,12 +5280,47 @@ out:
  ******************************************************************************/
 void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
 {
-	LOCK_CACHE;
+	int	i;
 
-	*values_num = cache->history_num;
-	*items_num = cache->history_items.num_data;
+	*values_num = 0;
+	*items_num = 0;
 
-	UNLOCK_CACHE;
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
+	{
+		LOCK_STRIPE(i);
+
+		*values_num += cache->stripes[i].history_num;
+		*items_num += cache->stripes[i].history_items.num_data;
+
+		UNLOCK_STRIPE(i);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_merge_mem_stats                                               *
+ *                                                                            *
+ * Purpose: adds stripe allocator statistics to the total statistics          *
+ *                                                                            *
+ * Parameters: total - [IN/OUT] the total statistics                          *
+ *             stats - [IN] the stripe statistics                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_merge_mem_stats(zbx_mem_stats_t *total, const zbx_mem_stats_t *stats)
+{
+	int	i;
+
+	for (i = 0; i < MEM_BUCKET_COUNT; i++)
+		total->chunks_num[i] += stats->chunks_num[i];
+
+	total->min_chunk_size = MIN(total->min_chunk_size, stats->min_chunk_size);
+	total->max_chunk_size = MAX(total->max_chunk_size, stats->max_chunk_size);
+
+	total->overhead += stats->overhead;
+	total->used_chunks += stats->used_chunks;
+	total->free_chunks += stats->free_chunks;
+	total->free_size += stats->free_size;
+	total->used_size += stats->used_size;
 }
 
 /******************************************************************************
@@ -4629,15 +5332,39 @@ void	zbx_hc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num)
  ******************************************************************************/
 void	zbx_hc_get_mem_stats(zbx_mem_stats_t *data, zbx_mem_stats_t *index)
 {
-	LOCK_CACHE;
+	int		i;
+	zbx_mem_stats_t	stats;
 
 	if (NULL != data)
-		zbx_mem_get_stats(hc_mem, data);
+	{
+		memset(data, 0, sizeof(zbx_mem_stats_t));
+		data->min_chunk_size = __UINT64_C(0xffffffffffffffff);
+	}
 
 	if (NULL != index)
-		zbx_mem_get_stats(hc_index_mem, index);
+	{
+		memset(index, 0, sizeof(zbx_mem_stats_t));
+		index->min_chunk_size = __UINT64_C(0xffffffffffffffff);
+	}
 
-	UNLOCK_CACHE;
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
+	{
+		LOCK_STRIPE(i);
+
+		if (NULL != data)
+		{
+			zbx_mem_get_stats(hc_mem[i], &stats);
+			hc_merge_mem_stats(data, &stats);
+		}
+
+		if (NULL != index)
+		{
+			zbx_mem_get_stats(hc_index_mem[i], &stats);
+			hc_merge_mem_stats(index, &stats);
+		}
+
+		UNLOCK_STRIPE(i);
+	}
 }
 
 /******************************************************************************
@@ -4651,19 +5378,23 @@ void	zbx_hc_get_items(zbx_vector_uint64_pair_t *items)
 {
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
+	int			i;
 
-	LOCK_CACHE;
+	for (i = 0; i < CONFIG_HISTORY_CACHE_STRIPES; i++)
+	{
+		LOCK_STRIPE(i);
 
-	zbx_vector_uint64_pair_reserve(items, cache->history_items.num_data);
+		zbx_vector_uint64_pair_reserve(items, items->values_num + cache->stripes[i].history_items.num_data);
 
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
-		zbx_vector_uint64_pair_append_ptr(items, &pair);
-	}
+		zbx_hashset_iter_reset(&cache->stripes[i].history_items, &iter);
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			zbx_uint64_pair_t	pair = {item->itemid, item->values_num};
+			zbx_vector_uint64_pair_append_ptr(items, &pair);
+		}
 
-	UNLOCK_CACHE;
+		UNLOCK_STRIPE(i);
+	}
 }
 
 /******************************************************************************
@@ -4690,3 +5421,6 @@ void	zbx_db_trigger_queue_unlock(void)
 	cache->db_trigger_queue_lock = 0;
 }
 
+#ifdef HAVE_TESTS
+#	include "../../../tests/libs/zbxdbcache/dc_trends_ownership_test.c"
+#endif
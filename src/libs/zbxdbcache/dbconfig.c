@@ -43,8 +43,11 @@
 
 int	sync_in_progress = 0;
 
-#define START_SYNC	WRLOCK_CACHE; sync_in_progress = 1
-#define FINISH_SYNC	sync_in_progress = 0; UNLOCK_CACHE
+/* configuration cache write lock hold time during the current configuration sync */
+static double	sync_lock_ts, sync_lock_sec, sync_lock_max;
+
+#define START_SYNC	WRLOCK_CACHE; sync_in_progress = 1; sync_lock_ts = zbx_time()
+#define FINISH_SYNC	dc_sync_lock_update(); sync_in_progress = 0; UNLOCK_CACHE
 
 #define ZBX_LOC_NOWHERE	0
 #define ZBX_LOC_QUEUE	1
@@ -67,6 +70,9 @@ int	sync_in_progress = 0;
 #define ZBX_QUEUE_PRIORITY_NORMAL	1
 #define ZBX_QUEUE_PRIORITY_LOW		2
 
+/* period after which agent found not to support multiple keys per request is negotiated again */
+#define ZBX_AGENT_VERSION_LEGACY_TTL	SEC_PER_HOUR
+
 /* shorthand macro for calling in_maintenance_without_data_collection() */
 #define DCin_maintenance_without_data_collection(dc_host, dc_item)			\
 		in_maintenance_without_data_collection(dc_host->maintenance_status,	\
@@ -92,6 +98,9 @@ ZBX_DC_CONFIG	*config = NULL;
 zbx_rwlock_t	config_lock = ZBX_RWLOCK_NULL;
 static zbx_mem_info_t	*config_mem;
 
+/* protects reference counters of compiled expressions shared with trigger copies */
+static zbx_mutex_t	config_eval_lock = ZBX_MUTEX_NULL;
+
 extern unsigned char	program_type;
 extern int		CONFIG_TIMER_FORKS;
 
@@ -101,8 +110,31 @@ static void	dc_maintenance_precache_nested_groups(void);
 
 /* by default the macro environment is non-secure and all secret macros are masked with ****** */
 static unsigned char	macro_env = ZBX_MACRO_ENV_NONSECURE;
+
+/* set when secret macro values are changed, forcing full compare of configuration with expanded macros */
+static unsigned char	secrets_changed;
 extern char		*CONFIG_VAULTDBPATH;
 extern char		*CONFIG_VAULTTOKEN;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_sync_lock_update                                              *
+ *                                                                            *
+ * Purpose: accounts time the configuration cache write lock was held since   *
+ *          the last START_SYNC                                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_lock_update(void)
+{
+	double	sec;
+
+	sec = zbx_time() - sync_lock_ts;
+	sync_lock_sec += sec;
+
+	if (sec > sync_lock_max)
+		sync_lock_max = sec;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_strdup                                                        *
@@ -201,6 +233,14 @@ static unsigned char	poller_by_item(unsigned char type, const char *key)
 {
 	switch (type)
 	{
+		case ITEM_TYPE_ZABBIX:
+			if (0 != CONFIG_AGENTPOLLER_FORKS)
+				return ZBX_POLLER_TYPE_AGENT;
+
+			if (0 == CONFIG_POLLER_FORKS)
+				break;
+
+			return ZBX_POLLER_TYPE_NORMAL;
 		case ITEM_TYPE_SIMPLE:
 			if (SUCCEED == cmp_key_id(key, SERVER_ICMPPING_KEY) ||
 					SUCCEED == cmp_key_id(key, SERVER_ICMPPINGSEC_KEY) ||
@@ -212,7 +252,6 @@ static unsigned char	poller_by_item(unsigned char type, const char *key)
 				return ZBX_POLLER_TYPE_PINGER;
 			}
 			ZBX_FALLTHROUGH;
-		case ITEM_TYPE_ZABBIX:
 		case ITEM_TYPE_SNMP:
 		case ITEM_TYPE_INTERNAL:
 		case ITEM_TYPE_AGGREGATE:
@@ -389,10 +428,32 @@ static void	DCitem_poller_type_update(ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *d
 
 	poller_type = poller_by_item(dc_item->type, dc_item->key);
 
+	/* encrypted connections are established synchronously, keep them away from agent pollers */
+	if (ZBX_POLLER_TYPE_AGENT == poller_type && ZBX_TCP_SEC_UNENCRYPTED != dc_host->tls_connect &&
+			0 != CONFIG_POLLER_FORKS)
+	{
+		poller_type = ZBX_POLLER_TYPE_NORMAL;
+	}
+
+	/* SNMP pollers only get values of static OIDs, walks are left to regular pollers */
+	if (ITEM_TYPE_SNMP == dc_item->type && 0 != CONFIG_SNMPPOLLER_FORKS &&
+			0 == (ZBX_FLAG_DISCOVERY_RULE & dc_item->flags))
+	{
+		const ZBX_DC_SNMPITEM	*snmpitem;
+
+		snmpitem = (const ZBX_DC_SNMPITEM *)zbx_hashset_search(&config->snmpitems, &dc_item->itemid);
+
+		if (NULL != snmpitem && ZBX_SNMP_OID_TYPE_NORMAL == snmpitem->snmp_oid_type)
+			poller_type = ZBX_POLLER_TYPE_SNMP;
+	}
+
 	if (0 != (flags & ZBX_HOST_UNREACHABLE))
 	{
-		if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_JAVA == poller_type)
+		if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_JAVA == poller_type ||
+				ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_SNMP == poller_type)
+		{
 			poller_type = ZBX_POLLER_TYPE_UNREACHABLE;
+		}
 
 		dc_item->poller_type = poller_type;
 		return;
@@ -404,8 +465,9 @@ static void	DCitem_poller_type_update(ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *d
 		return;
 	}
 
-	if (ZBX_POLLER_TYPE_UNREACHABLE != dc_item->poller_type ||
-			(ZBX_POLLER_TYPE_NORMAL != poller_type && ZBX_POLLER_TYPE_JAVA != poller_type))
+	if (ZBX_POLLER_TYPE_UNREACHABLE != dc_item->poller_type || (ZBX_POLLER_TYPE_NORMAL != poller_type &&
+			ZBX_POLLER_TYPE_JAVA != poller_type && ZBX_POLLER_TYPE_AGENT != poller_type &&
+			ZBX_POLLER_TYPE_SNMP != poller_type))
 	{
 		dc_item->poller_type = poller_type;
 	}
@@ -2242,6 +2304,8 @@ static int	DCsync_kvs_paths(const struct zbx_json_parse *jp_kvs_paths)
 
 		if (0 != diff.values_num)
 		{
+			secrets_changed = 1;
+
 			START_SYNC;
 
 			for (j = 0; j < diff.values_num; j++)
@@ -2519,6 +2583,13 @@ static void	DCsync_interfaces(zbx_dbsync_t *sync)
 		reset_snmp_stats |= (SUCCEED == DCstrpool_replace(found, &interface->dns, row[6]));
 		reset_snmp_stats |= (SUCCEED == DCstrpool_replace(found, &interface->port, row[7]));
 
+		/* agent behind changed address must negotiate its version again */
+		if (0 != reset_snmp_stats)
+		{
+			interface->version = ZBX_AGENT_VERSION_UNKNOWN;
+			interface->version_lastcheck = 0;
+		}
+
 		/* update interfaces_ht index using new data, if not done already */
 
 		if (1 == update_index)
@@ -3623,6 +3694,189 @@ static void	DCsync_prototype_items(zbx_dbsync_t *sync)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/* compiled expression header, the expression is shared with trigger copies */
+/* made by DCget_trigger() and is freed when the last reference is released */
+typedef struct
+{
+	zbx_uint32_t	refcount;
+	zbx_uint32_t	size;
+}
+zbx_dc_eval_bin_t;
+
+#define ZBX_DC_EVAL_BIN(bin)	((zbx_dc_eval_bin_t *)(bin) - 1)
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_eval_dup                                                      *
+ *                                                                            *
+ * Purpose: copies compiled expression into configuration cache shared memory *
+ *                                                                            *
+ ******************************************************************************/
+static const unsigned char	*dc_eval_dup(const unsigned char *bin)
+{
+	zbx_dc_eval_bin_t	*dst;
+	zbx_uint32_t		size;
+
+	size = zbx_eval_get_size(bin);
+	dst = (zbx_dc_eval_bin_t *)__config_mem_malloc_func(NULL, sizeof(zbx_dc_eval_bin_t) + size);
+	dst->refcount = 1;
+	dst->size = size;
+	memcpy(dst + 1, bin, size);
+
+	return (const unsigned char *)(dst + 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_eval_release                                                  *
+ *                                                                            *
+ * Purpose: releases configuration cache reference to compiled expression     *
+ *                                                                            *
+ * Comments: Expressions still referenced by trigger copies are freed later   *
+ *           by dc_eval_free_released(). Must be called with configuration    *
+ *           cache write lock.                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_eval_release(const unsigned char *bin)
+{
+	zbx_dc_eval_bin_t	*eval = ZBX_DC_EVAL_BIN(bin);
+	zbx_uint32_t		refcount;
+
+	zbx_mutex_lock(config_eval_lock);
+	refcount = --eval->refcount;
+	zbx_mutex_unlock(config_eval_lock);
+
+	if (0 == refcount)
+		__config_mem_free_func(eval);
+	else
+		zbx_vector_ptr_append(&config->eval_released, eval);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_eval_free_released                                            *
+ *                                                                            *
+ * Purpose: frees released compiled expressions not referenced by trigger     *
+ *          copies anymore                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_eval_free_released(void)
+{
+	int	i;
+
+	if (0 == config->eval_released.values_num)
+		return;
+
+	zbx_mutex_lock(config_eval_lock);
+
+	for (i = 0; i < config->eval_released.values_num;)
+	{
+		zbx_dc_eval_bin_t	*eval = (zbx_dc_eval_bin_t *)config->eval_released.values[i];
+
+		if (0 != eval->refcount)
+		{
+			i++;
+			continue;
+		}
+
+		__config_mem_free_func(eval);
+		zbx_vector_ptr_remove_noorder(&config->eval_released, i);
+	}
+
+	zbx_mutex_unlock(config_eval_lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_trigger_free_expressions_bin                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_trigger_free_expressions_bin(ZBX_DC_TRIGGER *trigger)
+{
+	if (NULL != trigger->expression_bin)
+	{
+		dc_eval_release(trigger->expression_bin);
+		trigger->expression_bin = NULL;
+	}
+
+	if (NULL != trigger->recovery_expression_bin)
+	{
+		dc_eval_release(trigger->recovery_expression_bin);
+		trigger->recovery_expression_bin = NULL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_trigger_compile_expressions                                   *
+ *                                                                            *
+ * Purpose: compiles trigger problem and recovery expressions so history      *
+ *          syncers can evaluate them without parsing expression text         *
+ *                                                                            *
+ * Comments: The expressions are compiled only if both problem and, when it   *
+ *           is used, recovery expressions can be compiled. Otherwise trigger *
+ *           is evaluated from expression text.                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_trigger_compile_expressions(ZBX_DC_TRIGGER *trigger)
+{
+	unsigned char	*expression_bin, *recovery_expression_bin = NULL;
+
+	dc_trigger_free_expressions_bin(trigger);
+
+	if (NULL == (expression_bin = zbx_eval_compile(trigger->expression)))
+		return;
+
+	if (TRIGGER_RECOVERY_MODE_RECOVERY_EXPRESSION == trigger->recovery_mode &&
+			NULL == (recovery_expression_bin = zbx_eval_compile(trigger->recovery_expression)))
+	{
+		zbx_free(expression_bin);
+		return;
+	}
+
+	trigger->expression_bin = dc_eval_dup(expression_bin);
+	zbx_free(expression_bin);
+
+	if (NULL != recovery_expression_bin)
+	{
+		trigger->recovery_expression_bin = dc_eval_dup(recovery_expression_bin);
+		zbx_free(recovery_expression_bin);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_item_unlink_trigger                                           *
+ *                                                                            *
+ * Purpose: removes trigger from the list of triggers item is used by and     *
+ *          marks the list for update                                         *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             trigger - [IN] the trigger to remove, can be NULL              *
+ *                                                                            *
+ * Comments: The rest of item trigger list stays valid until trigger lists    *
+ *           are rebuilt at the end of configuration sync, which is done      *
+ *           partially without locking the cache.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_item_unlink_trigger(ZBX_DC_ITEM *item, const ZBX_DC_TRIGGER *trigger)
+{
+	int	i, j;
+
+	item->update_triggers = 1;
+
+	if (NULL == item->triggers || NULL == trigger)
+		return;
+
+	for (i = 0, j = 0; NULL != item->triggers[i]; i++)
+	{
+		if (item->triggers[i] != trigger)
+			item->triggers[j++] = item->triggers[i];
+	}
+
+	item->triggers[j] = NULL;
+}
+
 static void	DCsync_triggers(zbx_dbsync_t *sync)
 {
 	char		**row;
@@ -3631,8 +3885,9 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 
 	ZBX_DC_TRIGGER	*trigger;
 
-	int		found, ret;
+	int		found, ret, compile;
 	zbx_uint64_t	triggerid;
+	unsigned char	recovery_mode;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -3648,18 +3903,35 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 
 		/* store new information in trigger structure */
 
+		compile = 0;
+
 		DCstrpool_replace(found, &trigger->description, row[1]);
-		DCstrpool_replace(found, &trigger->expression, row[2]);
-		DCstrpool_replace(found, &trigger->recovery_expression, row[11]);
+		if (SUCCEED == DCstrpool_replace(found, &trigger->expression, row[2]))
+			compile = 1;
+		if (SUCCEED == DCstrpool_replace(found, &trigger->recovery_expression, row[11]))
+			compile = 1;
 		DCstrpool_replace(found, &trigger->correlation_tag, row[13]);
 		DCstrpool_replace(found, &trigger->opdata, row[14]);
 		DCstrpool_replace(found, &trigger->event_name, row[15]);
 		ZBX_STR2UCHAR(trigger->priority, row[4]);
 		ZBX_STR2UCHAR(trigger->type, row[5]);
 		ZBX_STR2UCHAR(trigger->status, row[9]);
-		ZBX_STR2UCHAR(trigger->recovery_mode, row[10]);
+		ZBX_STR2UCHAR(recovery_mode, row[10]);
 		ZBX_STR2UCHAR(trigger->correlation_mode, row[12]);
 
+		if (0 == found)
+		{
+			trigger->expression_bin = NULL;
+			trigger->recovery_expression_bin = NULL;
+		}
+		else if (recovery_mode != trigger->recovery_mode)
+			compile = 1;
+
+		trigger->recovery_mode = recovery_mode;
+
+		if (0 != compile)
+			dc_trigger_compile_expressions(trigger);
+
 		if (0 == found)
 		{
 			DCstrpool_replace(found, &trigger->error, row[3]);
@@ -3667,6 +3939,7 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 			ZBX_STR2UCHAR(trigger->state, row[7]);
 			trigger->lastchange = atoi(row[8]);
 			trigger->locked = 0;
+			trigger->functional = TRIGGER_FUNCTIONAL_TRUE;
 
 			zbx_vector_ptr_create_ext(&trigger->tags, __config_mem_malloc_func, __config_mem_realloc_func,
 					__config_mem_free_func);
@@ -3704,12 +3977,7 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 				if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)))
 					continue;
 
-				item->update_triggers = 1;
-				if (NULL != item->triggers)
-				{
-					config->items.mem_free_func(item->triggers);
-					item->triggers = NULL;
-				}
+				dc_item_unlink_trigger(item, trigger);
 			}
 			zbx_vector_uint64_clear(&functionids);
 
@@ -3721,6 +3989,8 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 			zbx_strpool_release(trigger->opdata);
 			zbx_strpool_release(trigger->event_name);
 
+			dc_trigger_free_expressions_bin(trigger);
+
 			zbx_vector_ptr_destroy(&trigger->tags);
 
 			zbx_hashset_remove_direct(&config->triggers, trigger);
@@ -4055,22 +4325,24 @@ static void	dc_schedule_trigger_timer(zbx_trigger_timer_t *timer, const zbx_time
  * Purpose: set timer schedule and evaluation times based on functions and    *
  *          old trend function queue                                          *
  *                                                                            *
+ * Parameters: functions   - [IN] the timer and trend functions               *
+ *             trend_queue - [IN] the old trend function queue (optional)     *
+ *             now         - [IN] the current time                            *
+ *                                                                            *
  ******************************************************************************/
-static void	dc_schedule_trigger_timers(zbx_hashset_t *trend_queue, int now)
+static void	dc_schedule_trigger_timers(const zbx_vector_ptr_t *functions, zbx_hashset_t *trend_queue, int now)
 {
 	ZBX_DC_FUNCTION		*function;
 	ZBX_DC_TRIGGER		*trigger;
 	zbx_trigger_timer_t	*timer, *old;
 	zbx_timespec_t		ts;
-	zbx_hashset_iter_t	iter;
+	int			i;
 
 	ts.ns = 0;
 
-	zbx_hashset_iter_reset(&config->functions, &iter);
-	while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
+	for (i = 0; i < functions->values_num; i++)
 	{
-		if (ZBX_FUNCTION_TYPE_TIMER != function->type && ZBX_FUNCTION_TYPE_TRENDS != function->type)
-			continue;
+		function = (ZBX_DC_FUNCTION *)functions->values[i];
 
 		if (function->timer_revision == function->revision)
 			continue;
@@ -4156,12 +4428,8 @@ static void	DCsync_functions(zbx_dbsync_t *sync)
 
 				if (NULL != (item_last = zbx_hashset_search(&config->items, &function->itemid)))
 				{
-					item_last->update_triggers = 1;
-					if (NULL != item_last->triggers)
-					{
-						config->items.mem_free_func(item_last->triggers);
-						item_last->triggers = NULL;
-					}
+					dc_item_unlink_trigger(item_last,
+							zbx_hashset_search(&config->triggers, &function->triggerid));
 				}
 			}
 		}
@@ -4176,9 +4444,8 @@ static void	DCsync_functions(zbx_dbsync_t *sync)
 		function->type = zbx_get_function_type(function->function);
 		function->revision = config->sync_start_ts;
 
+		/* keep the existing links, the linked triggers are still in cache */
 		item->update_triggers = 1;
-		if (NULL != item->triggers)
-			item->triggers[0] = NULL;
 	}
 
 	for (; SUCCEED == ret; ret = zbx_dbsync_next(sync, &rowid, &row, &tag))
@@ -4187,14 +4454,7 @@ static void	DCsync_functions(zbx_dbsync_t *sync)
 			continue;
 
 		if (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)))
-		{
-			item->update_triggers = 1;
-			if (NULL != item->triggers)
-			{
-				config->items.mem_free_func(item->triggers);
-				item->triggers = NULL;
-			}
-		}
+			dc_item_unlink_trigger(item, zbx_hashset_search(&config->triggers, &function->triggerid));
 
 		zbx_strpool_release(function->function);
 		zbx_strpool_release(function->parameter);
@@ -5571,36 +5831,52 @@ static int	zbx_default_ptr_pair_ptr_compare_func(const void *d1, const void *d2)
 	return 0;
 }
 
+typedef struct
+{
+	zbx_vector_ptr_pair_t	itemtrigs;	/* item - trigger links of items with outdated trigger lists */
+	zbx_vector_ptr_t	triggers;	/* triggers with changed functionality */
+	zbx_vector_ptr_t	timers;		/* timer and trend functions */
+}
+zbx_dc_trigger_update_t;
+
 /******************************************************************************
  *                                                                            *
- * Function: dc_trigger_update_cache                                          *
+ * Function: dc_trigger_update_prepare                                        *
  *                                                                            *
- * Purpose: updates trigger related cache data;                               *
- *              1) time triggers assigned to timer processes                  *
- *              2) trigger functionality (if it uses contain disabled         *
+ * Purpose: calculates trigger related cache data changes without modifying   *
+ *          the cache:                                                        *
+ *              1) time functions to be assigned to timer processes           *
+ *              2) triggers with changed functionality (if it uses disabled   *
  *                 items/hosts)                                               *
  *              3) list of triggers each item is used by                      *
  *                                                                            *
+ * Parameters: update - [OUT] the trigger cache changes                       *
+ *                                                                            *
+ * Comments: Cache structure is changed only by configuration syncer, so this *
+ *           function is called without locking the cache and the resolved    *
+ *           pointers stay valid until the changes are applied.               *
+ *           Meanwhile items keep their old trigger lists, only links to      *
+ *           removed triggers are dropped during sync.                        *
+ *                                                                            *
  ******************************************************************************/
-static void	dc_trigger_update_cache(void)
+static void	dc_trigger_update_prepare(zbx_dc_trigger_update_t *update)
 {
 	zbx_hashset_iter_t	iter;
 	ZBX_DC_TRIGGER		*trigger;
 	ZBX_DC_FUNCTION		*function;
 	ZBX_DC_ITEM		*item;
-	int			i, j, k;
-	zbx_ptr_pair_t		itemtrig;
-	zbx_vector_ptr_pair_t	itemtrigs;
 	ZBX_DC_HOST		*host;
+	zbx_ptr_pair_t		itemtrig;
+	zbx_vector_ptr_t	nonfunctional;
+	unsigned char		functional;
 
-	zbx_hashset_iter_reset(&config->triggers, &iter);
-	while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
-		trigger->functional = TRIGGER_FUNCTIONAL_TRUE;
+	zbx_vector_ptr_create(&nonfunctional);
 
-	zbx_vector_ptr_pair_create(&itemtrigs);
 	zbx_hashset_iter_reset(&config->functions, &iter);
 	while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
 	{
+		if (ZBX_FUNCTION_TYPE_TIMER == function->type || ZBX_FUNCTION_TYPE_TRENDS == function->type)
+			zbx_vector_ptr_append(&update->timers, function);
 
 		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)) ||
 				NULL == (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers, &function->triggerid)))
@@ -5613,48 +5889,87 @@ static void	dc_trigger_update_cache(void)
 		{
 			itemtrig.first = item;
 			itemtrig.second = trigger;
-			zbx_vector_ptr_pair_append(&itemtrigs, itemtrig);
+			zbx_vector_ptr_pair_append(&update->itemtrigs, itemtrig);
 		}
 
 		/* disable functionality for triggers with expression containing */
 		/* disabled or not monitored items                               */
 
-		if (TRIGGER_FUNCTIONAL_FALSE == trigger->functional)
-			continue;
-
 		if (ITEM_STATUS_DISABLED == item->status ||
 				(NULL == (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &item->hostid)) ||
 						HOST_STATUS_NOT_MONITORED == host->status))
 		{
-			trigger->functional = TRIGGER_FUNCTIONAL_FALSE;
+			zbx_vector_ptr_append(&nonfunctional, trigger);
 		}
 	}
 
-	zbx_vector_ptr_pair_sort(&itemtrigs, zbx_default_ptr_pair_ptr_compare_func);
-	zbx_vector_ptr_pair_uniq(&itemtrigs, zbx_default_ptr_pair_ptr_compare_func);
+	zbx_vector_ptr_sort(&nonfunctional, ZBX_DEFAULT_PTR_COMPARE_FUNC);
+	zbx_vector_ptr_uniq(&nonfunctional, ZBX_DEFAULT_PTR_COMPARE_FUNC);
+
+	zbx_hashset_iter_reset(&config->triggers, &iter);
+	while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
+	{
+		if (FAIL == zbx_vector_ptr_bsearch(&nonfunctional, trigger, ZBX_DEFAULT_PTR_COMPARE_FUNC))
+			functional = TRIGGER_FUNCTIONAL_TRUE;
+		else
+			functional = TRIGGER_FUNCTIONAL_FALSE;
+
+		if (functional != trigger->functional)
+			zbx_vector_ptr_append(&update->triggers, trigger);
+	}
+
+	zbx_vector_ptr_pair_sort(&update->itemtrigs, zbx_default_ptr_pair_ptr_compare_func);
+	zbx_vector_ptr_pair_uniq(&update->itemtrigs, zbx_default_ptr_pair_ptr_compare_func);
+
+	zbx_vector_ptr_destroy(&nonfunctional);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_trigger_update_apply                                          *
+ *                                                                            *
+ * Purpose: applies trigger related cache data changes prepared by            *
+ *          dc_trigger_update_prepare() function                              *
+ *                                                                            *
+ * Parameters: update - [IN] the trigger cache changes                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_trigger_update_apply(const zbx_dc_trigger_update_t *update)
+{
+	ZBX_DC_TRIGGER	*trigger;
+	ZBX_DC_ITEM	*item;
+	int		i, j, k;
+
+	for (i = 0; i < update->triggers.values_num; i++)
+	{
+		trigger = (ZBX_DC_TRIGGER *)update->triggers.values[i];
+
+		if (TRIGGER_FUNCTIONAL_TRUE == trigger->functional)
+			trigger->functional = TRIGGER_FUNCTIONAL_FALSE;
+		else
+			trigger->functional = TRIGGER_FUNCTIONAL_TRUE;
+	}
 
 	/* update links from items to triggers */
-	for (i = 0; i < itemtrigs.values_num; i++)
+	for (i = 0; i < update->itemtrigs.values_num; i++)
 	{
-		for (j = i + 1; j < itemtrigs.values_num; j++)
+		for (j = i + 1; j < update->itemtrigs.values_num; j++)
 		{
-			if (itemtrigs.values[i].first != itemtrigs.values[j].first)
+			if (update->itemtrigs.values[i].first != update->itemtrigs.values[j].first)
 				break;
 		}
 
-		item = (ZBX_DC_ITEM *)itemtrigs.values[i].first;
+		item = (ZBX_DC_ITEM *)update->itemtrigs.values[i].first;
 		item->update_triggers = 0;
 		item->triggers = (ZBX_DC_TRIGGER **)config->items.mem_realloc_func(item->triggers, (j - i + 1) * sizeof(ZBX_DC_TRIGGER *));
 
 		for (k = i; k < j; k++)
-			item->triggers[k - i] = (ZBX_DC_TRIGGER *)itemtrigs.values[k].second;
+			item->triggers[k - i] = (ZBX_DC_TRIGGER *)update->itemtrigs.values[k].second;
 
 		item->triggers[j - i] = NULL;
 
 		i = j - 1;
 	}
-
-	zbx_vector_ptr_pair_destroy(&itemtrigs);
 }
 
 /******************************************************************************
@@ -5735,14 +6050,15 @@ static void	dc_load_trigger_queue(zbx_hashset_t *trend_functions)
  ******************************************************************************/
 void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kvs_paths)
 {
-	int		i, flags;
+	int		i, flags, ret = FAIL;
 	double		sec, csec, hsec, hisec, htsec, gmsec, hmsec, ifsec, isec, tsec, dsec, fsec, expr_sec, csec2,
 			hsec2, hisec2, htsec2, gmsec2, hmsec2, ifsec2, isec2, tsec2, dsec2, fsec2, expr_sec2,
 			action_sec, action_sec2, action_op_sec, action_op_sec2, action_condition_sec,
 			action_condition_sec2, trigger_tag_sec, trigger_tag_sec2, host_tag_sec, host_tag_sec2,
 			correlation_sec, correlation_sec2, corr_condition_sec, corr_condition_sec2, corr_operation_sec,
 			corr_operation_sec2, hgroups_sec, hgroups_sec2, itempp_sec, itempp_sec2, itemscrp_sec,
-			itemscrp_sec2, total, total2, update_sec, maintenance_sec, maintenance_sec2;
+			itemscrp_sec2, total, total2, update_sec, update_prep_sec = 0, maintenance_sec,
+			maintenance_sec2;
 
 	zbx_dbsync_t	config_sync, hosts_sync, hi_sync, htmpl_sync, gmacro_sync, hmacro_sync, if_sync, items_sync,
 			template_items_sync, prototype_items_sync, triggers_sync, tdep_sync, func_sync, expr_sync,
@@ -5760,6 +6076,8 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	config->sync_start_ts = time(NULL);
+	sync_lock_sec = 0;
+	sync_lock_max = 0;
 
 	if (ZBX_SYNC_SECRETS == mode)
 	{
@@ -5768,6 +6086,10 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 	}
 
 	zbx_dbsync_init_env(config);
+	zbx_dbsync_env_prepare(mode);
+
+	if (ZBX_SYNC_FULL == mode)
+		mode = ZBX_DBSYNC_UPDATE;
 
 	if (ZBX_DBSYNC_INIT == mode)
 	{
@@ -5882,6 +6204,17 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 		goto out;
 	}
 
+	/* user macros are expanded in item, function and trigger rows, so macro changes affect also */
+	/* the rows not listed in changelog                                                            */
+	if (0 != htmpl_sync.add_num + htmpl_sync.update_num + htmpl_sync.remove_num +
+			gmacro_sync.add_num + gmacro_sync.update_num + gmacro_sync.remove_num +
+			hmacro_sync.add_num + hmacro_sync.update_num + hmacro_sync.remove_num ||
+			0 != secrets_changed)
+	{
+		zbx_dbsync_env_disable_changelog();
+		secrets_changed = 0;
+	}
+
 	/* sync host data to support host lookups when resolving macros during configuration sync */
 
 	sec = zbx_time();
@@ -6076,6 +6409,8 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 
 	START_SYNC;
 
+	dc_eval_free_released();
+
 	sec = zbx_time();
 	DCsync_triggers(&triggers_sync);
 	tsec2 = zbx_time() - sec;
@@ -6144,11 +6479,32 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 	if (0 != (update_flags & (ZBX_DBSYNC_UPDATE_HOSTS | ZBX_DBSYNC_UPDATE_ITEMS | ZBX_DBSYNC_UPDATE_FUNCTIONS |
 			ZBX_DBSYNC_UPDATE_TRIGGERS)))
 	{
-		dc_trigger_update_cache();
-		dc_schedule_trigger_timers((ZBX_DBSYNC_INIT == mode ? &trend_queue : NULL), time(NULL));
-	}
+		zbx_dc_trigger_update_t	trigger_update;
+
+		update_sec = zbx_time() - sec;
+		FINISH_SYNC;
+
+		/* scan all functions and triggers without locking, as they are changed only by configuration syncer */
+		sec = zbx_time();
+		zbx_vector_ptr_pair_create(&trigger_update.itemtrigs);
+		zbx_vector_ptr_create(&trigger_update.triggers);
+		zbx_vector_ptr_create(&trigger_update.timers);
+		dc_trigger_update_prepare(&trigger_update);
+		update_prep_sec = zbx_time() - sec;
+
+		START_SYNC;
+		sec = zbx_time();
+		dc_trigger_update_apply(&trigger_update);
+		dc_schedule_trigger_timers(&trigger_update.timers, (ZBX_DBSYNC_INIT == mode ? &trend_queue : NULL),
+				time(NULL));
 
-	update_sec = zbx_time() - sec;
+		zbx_vector_ptr_destroy(&trigger_update.timers);
+		zbx_vector_ptr_destroy(&trigger_update.triggers);
+		zbx_vector_ptr_pair_destroy(&trigger_update.itemtrigs);
+		update_sec += zbx_time() - sec;
+	}
+	else
+		update_sec = zbx_time() - sec;
 
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
 	{
@@ -6274,7 +6630,8 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 				__func__, maintenance_sec, maintenance_sec2, maintenance_sync.add_num,
 				maintenance_sync.update_num, maintenance_sync.remove_num);
 
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() reindex    : " ZBX_FS_DBL " sec.", __func__, update_sec);
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() reindex    : prepare:" ZBX_FS_DBL " sync:" ZBX_FS_DBL " sec.", __func__,
+				update_prep_sec, update_sec);
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() total sql  : " ZBX_FS_DBL " sec.", __func__, total);
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() total sync : " ZBX_FS_DBL " sec.", __func__, total2);
@@ -6406,6 +6763,8 @@ void	DCsync_configuration(unsigned char mode, const struct zbx_json_parse *jp_kv
 
 		zbx_mem_dump_stats(LOG_LEVEL_DEBUG, config_mem);
 	}
+
+	ret = SUCCEED;
 out:
 	if (0 == sync_in_progress)
 	{
@@ -6417,8 +6776,17 @@ out:
 	config->status->last_update = 0;
 	config->sync_ts = time(NULL);
 
+	/* publish write lock statistics while the cache is still locked, including the current hold */
+	dc_sync_lock_update();
+	sync_lock_ts = zbx_time();
+	config->sync_lock_sec = sync_lock_sec;
+	config->sync_lock_max = sync_lock_max;
+
 	FINISH_SYNC;
 
+	if (SUCCEED == ret)
+		zbx_dbsync_env_flush_changelog();
+
 	zbx_dbsync_clear(&config_sync);
 	zbx_dbsync_clear(&autoreg_config_sync);
 	zbx_dbsync_clear(&hosts_sync);
@@ -6457,6 +6825,9 @@ out:
 
 	zbx_dbsync_free_env();
 skip:
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() write lock : " ZBX_FS_DBL " sec (longest " ZBX_FS_DBL " sec).", __func__,
+			sync_lock_sec, sync_lock_max);
+
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE))
 		DCdump_configuration();
 
@@ -6614,6 +6985,27 @@ static int	__config_snmp_item_compare(const ZBX_DC_ITEM *i1, const ZBX_DC_ITEM *
 	return 0;
 }
 
+static int	__config_agent_item_compare(const ZBX_DC_ITEM *i1, const ZBX_DC_ITEM *i2)
+{
+	ZBX_RETURN_IF_NOT_EQUAL(i1->interfaceid, i2->interfaceid);
+	ZBX_RETURN_IF_NOT_EQUAL(i1->type, i2->type);
+
+	return 0;
+}
+
+static int	__config_heap_elem_type_rank(const ZBX_DC_ITEM *item)
+{
+	switch (item->type)
+	{
+		case ITEM_TYPE_ZABBIX:
+			return 1;
+		case ITEM_TYPE_SNMP:
+			return 2;
+		default:
+			return 0;
+	}
+}
+
 static int	__config_heap_elem_compare(const void *d1, const void *d2)
 {
 	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
@@ -6625,19 +7017,17 @@ static int	__config_heap_elem_compare(const void *d1, const void *d2)
 	ZBX_RETURN_IF_NOT_EQUAL(i1->nextcheck, i2->nextcheck);
 	ZBX_RETURN_IF_NOT_EQUAL(i1->queue_priority, i2->queue_priority);
 
-	if (ITEM_TYPE_SNMP != i1->type)
-	{
-		if (ITEM_TYPE_SNMP != i2->type)
-			return 0;
+	/* keep SNMP and agent items of the same interface together so they can be checked in one batch */
+	ZBX_RETURN_IF_NOT_EQUAL(__config_heap_elem_type_rank(i1), __config_heap_elem_type_rank(i2));
 
-		return -1;
-	}
-	else
+	switch (i1->type)
 	{
-		if (ITEM_TYPE_SNMP != i2->type)
-			return +1;
-
-		return __config_snmp_item_compare(i1, i2);
+		case ITEM_TYPE_SNMP:
+			return __config_snmp_item_compare(i1, i2);
+		case ITEM_TYPE_ZABBIX:
+			return __config_agent_item_compare(i1, i2);
+		default:
+			return 0;
 	}
 }
 
@@ -6793,6 +7183,9 @@ int	init_configuration_cache(char **error)
 	if (SUCCEED != (ret = zbx_rwlock_create(&config_lock, ZBX_RWLOCK_CONFIG, error)))
 		goto out;
 
+	if (SUCCEED != (ret = zbx_mutex_create(&config_eval_lock, ZBX_MUTEX_CONFIG_EVAL, error)))
+		goto out;
+
 	if (SUCCEED != (ret = zbx_mem_create(&config_mem, CONFIG_CONF_CACHE_SIZE, "configuration cache",
 			"CacheSize", 0, error)))
 	{
@@ -6859,6 +7252,8 @@ int	init_configuration_cache(char **error)
 			__config_mem_free_func);
 	zbx_vector_ptr_create_ext(&config->kvs_paths, __config_mem_malloc_func, __config_mem_realloc_func,
 			__config_mem_free_func);
+	zbx_vector_ptr_create_ext(&config->eval_released, __config_mem_malloc_func, __config_mem_realloc_func,
+			__config_mem_free_func);
 
 	CREATE_HASHSET(config->preprocops, 0);
 
@@ -6937,6 +7332,8 @@ int	init_configuration_cache(char **error)
 	config->sync_ts = 0;
 	config->item_sync_ts = 0;
 	config->sync_start_ts = 0;
+	config->sync_lock_sec = 0;
+	config->sync_lock_max = 0;
 
 	config->internal_actions = 0;
 
@@ -6991,6 +7388,7 @@ void	free_configuration_cache(void)
 	UNLOCK_CACHE;
 
 	zbx_rwlock_destroy(&config_lock);
+	zbx_mutex_destroy(&config_eval_lock);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -7371,6 +7769,14 @@ static void	DCget_interface(DC_INTERFACE *dst_interface, const ZBX_DC_INTERFACE
 		dst_interface->useip = src_interface->useip;
 		dst_interface->type = src_interface->type;
 		dst_interface->main = src_interface->main;
+		dst_interface->version = src_interface->version;
+
+		/* agent might have been upgraded since it was found not to support multiple keys per request */
+		if (ZBX_AGENT_VERSION_LEGACY == dst_interface->version &&
+				ZBX_AGENT_VERSION_LEGACY_TTL <= time(NULL) - src_interface->version_lastcheck)
+		{
+			dst_interface->version = ZBX_AGENT_VERSION_UNKNOWN;
+		}
 	}
 	else
 	{
@@ -7381,6 +7787,7 @@ static void	DCget_interface(DC_INTERFACE *dst_interface, const ZBX_DC_INTERFACE
 		dst_interface->useip = 1;
 		dst_interface->type = INTERFACE_TYPE_UNKNOWN;
 		dst_interface->main = 0;
+		dst_interface->version = ZBX_AGENT_VERSION_UNKNOWN;
 	}
 
 	dst_interface->addr = (1 == dst_interface->useip ? dst_interface->ip_orig : dst_interface->dns_orig);
@@ -7742,6 +8149,48 @@ static void	DCget_function(DC_FUNCTION *dst_function, const ZBX_DC_FUNCTION *src
 	memcpy(dst_function->parameter, src_function->parameter, sz_parameter);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCget_eval_bin                                                   *
+ *                                                                            *
+ * Purpose: gets reference to compiled expression in configuration cache      *
+ *                                                                            *
+ * Comments: The expression is shared read-only and must be released with     *
+ *           DCrelease_eval_bin().                                            *
+ *                                                                            *
+ ******************************************************************************/
+static const unsigned char	*DCget_eval_bin(const unsigned char *src)
+{
+	if (NULL != src)
+	{
+		zbx_mutex_lock(config_eval_lock);
+		ZBX_DC_EVAL_BIN(src)->refcount++;
+		zbx_mutex_unlock(config_eval_lock);
+	}
+
+	return src;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCrelease_eval_bin                                               *
+ *                                                                            *
+ * Purpose: releases reference to compiled expression in configuration cache  *
+ *                                                                            *
+ * Comments: The configuration cache lock is not required, released          *
+ *           expressions are freed during configuration cache sync.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	DCrelease_eval_bin(const unsigned char *bin)
+{
+	if (NULL != bin)
+	{
+		zbx_mutex_lock(config_eval_lock);
+		ZBX_DC_EVAL_BIN(bin)->refcount--;
+		zbx_mutex_unlock(config_eval_lock);
+	}
+}
+
 static void	DCget_trigger(DC_TRIGGER *dst_trigger, const ZBX_DC_TRIGGER *src_trigger)
 {
 	int	i;
@@ -7774,6 +8223,8 @@ static void	DCget_trigger(DC_TRIGGER *dst_trigger, const ZBX_DC_TRIGGER *src_tri
 
 	dst_trigger->expression = zbx_strdup(NULL, src_trigger->expression);
 	dst_trigger->recovery_expression = zbx_strdup(NULL, src_trigger->recovery_expression);
+	dst_trigger->expression_bin = DCget_eval_bin(src_trigger->expression_bin);
+	dst_trigger->recovery_expression_bin = DCget_eval_bin(src_trigger->recovery_expression_bin);
 
 	zbx_vector_ptr_create(&dst_trigger->tags);
 
@@ -7817,6 +8268,8 @@ static void	DCclean_trigger(DC_TRIGGER *trigger)
 	zbx_free(trigger->recovery_expression_orig);
 	zbx_free(trigger->expression);
 	zbx_free(trigger->recovery_expression);
+	DCrelease_eval_bin(trigger->expression_bin);
+	DCrelease_eval_bin(trigger->recovery_expression_bin);
 	zbx_free(trigger->description);
 	zbx_free(trigger->correlation_tag);
 	zbx_free(trigger->opdata);
@@ -7924,6 +8377,129 @@ void	DCconfig_get_items_by_itemids(DC_ITEM *items, const zbx_uint64_t *itemids,
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_get_hist_item                                                 *
+ *                                                                            *
+ * Purpose: copies item data required by history syncers                      *
+ *                                                                            *
+ * Parameters: dst_item - [OUT] the history syncer item                       *
+ *             src_item - [IN] the cached item                                *
+ *             src_host - [IN] the cached item host                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_get_hist_item(zbx_dc_item_hist_t *dst_item, const ZBX_DC_ITEM *src_item,
+		const ZBX_DC_HOST *src_host)
+{
+	const ZBX_DC_NUMITEM		*numitem;
+	const ZBX_DC_HOST_INVENTORY	*host_inventory;
+
+	dst_item->itemid = src_item->itemid;
+	dst_item->hostid = src_host->hostid;
+	dst_item->proxy_hostid = src_host->proxy_hostid;
+	dst_item->lastlogsize = src_item->lastlogsize;
+	dst_item->valuemapid = src_item->valuemapid;
+	strscpy(dst_item->host, src_host->host);
+	dst_item->key_orig = zbx_strdup(NULL, src_item->key);
+	dst_item->error = zbx_strdup(NULL, src_item->error);
+	dst_item->history_sec = src_item->history_sec;
+	dst_item->mtime = src_item->mtime;
+	dst_item->type = src_item->type;
+	dst_item->value_type = src_item->value_type;
+	dst_item->state = src_item->state;
+	dst_item->status = src_item->status;
+	dst_item->flags = src_item->flags;
+	dst_item->history = src_item->history;
+	dst_item->inventory_link = src_item->inventory_link;
+	dst_item->host_status = src_host->status;
+
+	if (ITEM_VALUE_TYPE_FLOAT == src_item->value_type || ITEM_VALUE_TYPE_UINT64 == src_item->value_type)
+	{
+		numitem = (ZBX_DC_NUMITEM *)zbx_hashset_search(&config->numitems, &src_item->itemid);
+
+		dst_item->trends = numitem->trends;
+		dst_item->trends_sec = numitem->trends_sec;
+		dst_item->units = zbx_strdup(NULL, numitem->units);
+	}
+	else
+	{
+		dst_item->trends = 0;
+		dst_item->trends_sec = 0;
+		dst_item->units = NULL;
+	}
+
+	if (NULL != (host_inventory = (ZBX_DC_HOST_INVENTORY *)zbx_hashset_search(&config->host_inventories,
+			&src_host->hostid)))
+	{
+		dst_item->host_inventory_mode = (char)host_inventory->inventory_mode;
+	}
+	else
+		dst_item->host_inventory_mode = HOST_INVENTORY_DISABLED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dc_get_hist_items_by_itemids                                 *
+ *                                                                            *
+ * Purpose: get item data required by history syncers                         *
+ *                                                                            *
+ * Parameters: items    - [OUT] the history syncer items                      *
+ *             itemids  - [IN] array of item IDs                              *
+ *             errcodes - [OUT] SUCCEED if item found, otherwise FAIL         *
+ *             num      - [IN] number of elements                             *
+ *                                                                            *
+ * Comments: Unlike DCconfig_get_items_by_itemids() only the fields needed    *
+ *           to process item values are copied, skipping item type specific   *
+ *           and host connection data.                                        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_get_hist_items_by_itemids(zbx_dc_item_hist_t *items, const zbx_uint64_t *itemids, int *errcodes,
+		size_t num)
+{
+	size_t			i;
+	const ZBX_DC_ITEM	*dc_item;
+	const ZBX_DC_HOST	*dc_host;
+
+	RDLOCK_CACHE;
+
+	for (i = 0; i < num; i++)
+	{
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])) ||
+				NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
+		{
+			errcodes[i] = FAIL;
+			continue;
+		}
+
+		dc_get_hist_item(&items[i], dc_item, dc_host);
+		errcodes[i] = SUCCEED;
+	}
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dc_clean_hist_items                                          *
+ *                                                                            *
+ * Purpose: frees resources allocated by zbx_dc_get_hist_items_by_itemids()   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dc_clean_hist_items(zbx_dc_item_hist_t *items, const int *errcodes, size_t num)
+{
+	size_t	i;
+
+	for (i = 0; i < num; i++)
+	{
+		if (NULL != errcodes && SUCCEED != errcodes[i])
+			continue;
+
+		zbx_free(items[i].key_orig);
+		zbx_free(items[i].units);
+		zbx_free(items[i].error);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_preproc_item_init                                             *
@@ -8766,6 +9342,35 @@ void	DCconfig_update_interface_snmp_stats(zbx_uint64_t interfaceid, int max_snmp
 	UNLOCK_CACHE;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_update_interface_version                                *
+ *                                                                            *
+ * Purpose: store agent version learned from passive checks                   *
+ *                                                                            *
+ * Parameters: interfaceid - [IN] the agent interface identifier              *
+ *             version     - [IN] the agent version or                        *
+ *                                ZBX_AGENT_VERSION_LEGACY                    *
+ *                                                                            *
+ * Comments: The version is shared by all pollers, so only one of them has to *
+ *           negotiate whether agent supports multiple keys per request.      *
+ *                                                                            *
+ ******************************************************************************/
+void	DCconfig_update_interface_version(zbx_uint64_t interfaceid, int version)
+{
+	ZBX_DC_INTERFACE	*dc_interface;
+
+	WRLOCK_CACHE;
+
+	if (NULL != (dc_interface = (ZBX_DC_INTERFACE *)zbx_hashset_search(&config->interfaces, &interfaceid)))
+	{
+		dc_interface->version = version;
+		dc_interface->version_lastcheck = (int)time(NULL);
+	}
+
+	UNLOCK_CACHE;
+}
+
 static int	DCconfig_get_suggested_snmp_vars_nolock(zbx_uint64_t interfaceid, int *bulk)
 {
 	int				num;
@@ -9038,9 +9643,9 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
  *           always return the items they have taken using DCrequeue_items()  *
  *           or DCpoller_requeue_items().                                     *
  *                                                                            *
- *           Currently batch polling is supported only for JMX, SNMP and      *
- *           icmpping* simple checks. In other cases only single item is      *
- *           retrieved.                                                       *
+ *           Currently batch polling is supported only for JMX, SNMP, Zabbix  *
+ *           agent and icmpping* simple checks. In other cases only single    *
+ *           item is retrieved.                                               *
  *                                                                            *
  *           IPMI poller queue are handled by DCconfig_get_ipmi_poller_items()*
  *           function.                                                        *
@@ -9065,6 +9670,12 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 		case ZBX_POLLER_TYPE_PINGER:
 			max_items = MAX_PINGER_ITEMS;
 			break;
+		case ZBX_POLLER_TYPE_AGENT:
+			max_items = MAX_AGENT_ITEMS;
+			break;
+		case ZBX_POLLER_TYPE_SNMP:
+			max_items = MAX_SNMP_ASYNC_ITEMS;
+			break;
 		default:
 			max_items = 1;
 	}
@@ -9087,7 +9698,7 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 
 		if (0 != num)
 		{
-			if (ITEM_TYPE_SNMP == dc_item_prev->type)
+			if (ITEM_TYPE_SNMP == dc_item_prev->type && ZBX_POLLER_TYPE_SNMP != poller_type)
 			{
 				if (0 != __config_snmp_item_compare(dc_item_prev, dc_item))
 					break;
@@ -9097,6 +9708,11 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 				if (0 != __config_java_item_compare(dc_item_prev, dc_item))
 					break;
 			}
+			else if (ITEM_TYPE_ZABBIX == dc_item_prev->type && ZBX_POLLER_TYPE_AGENT != poller_type)
+			{
+				if (0 != __config_agent_item_compare(dc_item_prev, dc_item))
+					break;
+			}
 		}
 
 		zbx_binary_heap_remove_min(queue);
@@ -9133,6 +9749,7 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 				/* postpone checks on hosts that have been checked recently and */
 				/* are still unreachable                                        */
 				if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_JAVA == poller_type ||
+						ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_SNMP == poller_type ||
 						disable_until > now)
 				{
 					dc_requeue_item(dc_item, dc_host, ZBX_ITEM_COLLECTED | ZBX_HOST_UNREACHABLE,
@@ -9150,6 +9767,12 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 		DCget_item(&items[num], dc_item);
 		num++;
 
+		if (1 == num && ZBX_POLLER_TYPE_NORMAL == poller_type && ITEM_TYPE_ZABBIX == dc_item->type &&
+				ZBX_AGENT_MULTIKEY_REQUEST(items[0].interface.version))
+		{
+			max_items = MAX_AGENT_REQUEST_KEYS;
+		}
+
 		if (1 == num && ZBX_POLLER_TYPE_NORMAL == poller_type && ITEM_TYPE_SNMP == dc_item->type &&
 				0 == (ZBX_FLAG_DISCOVERY_RULE & dc_item->flags))
 		{
@@ -10250,6 +10873,12 @@ void	*DCconfig_get_stats(int request)
 		case ZBX_CONFSTATS_BUFFER_PFREE:
 			value_double = 100 * (double)config_mem->free_size / config_mem->orig_size;
 			return &value_double;
+		case ZBX_CONFSTATS_SYNC_LOCK:
+			value_double = config->sync_lock_sec;
+			return &value_double;
+		case ZBX_CONFSTATS_SYNC_LOCK_MAX:
+			value_double = config->sync_lock_max;
+			return &value_double;
 		default:
 			return NULL;
 	}
@@ -34,6 +34,8 @@ typedef struct
 	const char		*correlation_tag;
 	const char		*opdata;
 	const char		*event_name;
+	const unsigned char	*expression_bin;		/* compiled expression, NULL if not compiled */
+	const unsigned char	*recovery_expression_bin;
 	int			lastchange;
 	unsigned char		topoindex;
 	unsigned char		priority;
@@ -480,6 +482,8 @@ typedef struct
 	unsigned char	type;
 	unsigned char	main;
 	unsigned char	useip;
+	int		version;		/* agent version learned by pollers */
+	int		version_lastcheck;	/* when the agent version was learned */
 }
 ZBX_DC_INTERFACE;
 
@@ -785,6 +789,10 @@ typedef struct
 	int			item_sync_ts;
 	int			sync_start_ts;
 
+	/* configuration cache write lock hold time during the last configuration sync */
+	double			sync_lock_sec;			/* total */
+	double			sync_lock_max;			/* longest single lock */
+
 	unsigned int		internal_actions;		/* number of enabled internal actions */
 
 	/* maintenance processing management */
@@ -851,6 +859,7 @@ typedef struct
 	zbx_hashset_t		hostgroups;
 	zbx_vector_ptr_t	hostgroups_name;	/* host groups sorted by name */
 	zbx_vector_ptr_t	kvs_paths;
+	zbx_vector_ptr_t	eval_released;		/* compiled expressions still used by trigger copies */
 	zbx_hashset_t		preprocops;
 	zbx_hashset_t		itemscript_params;
 	zbx_hashset_t		maintenances;
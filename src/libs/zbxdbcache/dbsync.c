@@ -27,15 +27,51 @@
 #include "dbconfig.h"
 #include "dbsync.h"
 
+/* changelog object types, must match the changelog triggers in database schema */
+#define ZBX_DBSYNC_OBJ_HOST		1
+#define ZBX_DBSYNC_OBJ_ITEM		2
+#define ZBX_DBSYNC_OBJ_TRIGGER		3
+#define ZBX_DBSYNC_OBJ_FUNCTION		4
+#define ZBX_DBSYNC_OBJ_ITEM_PREPROC	5
+
 typedef struct
 {
-	zbx_hashset_t	strpool;
-	ZBX_DC_CONFIG	*cache;
+	zbx_hashset_t		strpool;
+	ZBX_DC_CONFIG		*cache;
+
+	/* SUCCEED - only objects listed in changelog are compared, FAIL - whole tables are compared */
+	int			changelog;
+
+	/* the read changelog records, removed from database after successful synchronization */
+	zbx_vector_uint64_t	changelogids;
+
+	/* the changed objects listed in changelog */
+	zbx_vector_uint64_t	hostids;
+	zbx_vector_uint64_t	itemids;
+	zbx_vector_uint64_t	triggerids;
+	zbx_vector_uint64_t	functionids;
+	zbx_vector_uint64_t	item_preprocids;
+
+	/* the hosts with changed proxy or status, all items of such hosts must be compared */
+	zbx_vector_uint64_t	update_hostids;
+
+	/* the items and triggers changed during synchronization, their dependent objects must be compared */
+	zbx_vector_uint64_t	update_itemids;
+	zbx_vector_uint64_t	update_triggerids;
 }
 zbx_dbsync_env_t;
 
 static zbx_dbsync_env_t	dbsync_env;
 
+/* the tables with triggers recording their changes in changelog */
+static const char	*dbsync_changelog_tables[] = {"hosts", "items", "triggers", "functions", "item_preproc"};
+
+/* SUCCEED - changelog table exists, FAIL - otherwise */
+static int	dbsync_changelog_table = FAIL;
+
+/* SUCCEED - all changelog triggers exist, FAIL - otherwise */
+static int	dbsync_changelog_triggers = FAIL;
+
 /* string pool support */
 
 #define REFCOUNT_FIELD_SIZE	sizeof(zbx_uint32_t)
@@ -277,6 +313,17 @@ void	zbx_dbsync_init_env(ZBX_DC_CONFIG *cache)
 {
 	dbsync_env.cache = cache;
 	zbx_hashset_create(&dbsync_env.strpool, 100, dbsync_strpool_hash_func, dbsync_strpool_compare_func);
+
+	dbsync_env.changelog = FAIL;
+	zbx_vector_uint64_create(&dbsync_env.changelogids);
+	zbx_vector_uint64_create(&dbsync_env.hostids);
+	zbx_vector_uint64_create(&dbsync_env.itemids);
+	zbx_vector_uint64_create(&dbsync_env.triggerids);
+	zbx_vector_uint64_create(&dbsync_env.functionids);
+	zbx_vector_uint64_create(&dbsync_env.item_preprocids);
+	zbx_vector_uint64_create(&dbsync_env.update_hostids);
+	zbx_vector_uint64_create(&dbsync_env.update_itemids);
+	zbx_vector_uint64_create(&dbsync_env.update_triggerids);
 }
 
 /******************************************************************************
@@ -286,9 +333,265 @@ void	zbx_dbsync_init_env(ZBX_DC_CONFIG *cache)
  ******************************************************************************/
 void	zbx_dbsync_free_env(void)
 {
+	zbx_vector_uint64_destroy(&dbsync_env.update_triggerids);
+	zbx_vector_uint64_destroy(&dbsync_env.update_itemids);
+	zbx_vector_uint64_destroy(&dbsync_env.update_hostids);
+	zbx_vector_uint64_destroy(&dbsync_env.item_preprocids);
+	zbx_vector_uint64_destroy(&dbsync_env.functionids);
+	zbx_vector_uint64_destroy(&dbsync_env.triggerids);
+	zbx_vector_uint64_destroy(&dbsync_env.itemids);
+	zbx_vector_uint64_destroy(&dbsync_env.hostids);
+	zbx_vector_uint64_destroy(&dbsync_env.changelogids);
+
 	zbx_hashset_destroy(&dbsync_env.strpool);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_check_changelog                                           *
+ *                                                                            *
+ * Purpose: checks if changelog table and triggers writing it exist           *
+ *                                                                            *
+ * Comments: The changelog is created by optional database patches, which do  *
+ *           not create triggers if database user lacks privileges.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_check_changelog(void)
+{
+	const char	*operations[] = {"insert", "update", "delete"};
+	char		name[ZBX_TABLENAME_LEN + 8];
+	int		i, j;
+
+	dbsync_changelog_triggers = FAIL;
+
+	if (SUCCEED != (dbsync_changelog_table = DBtable_exists("changelog")))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "changelog table does not exist, configuration cache will be"
+				" synchronized by comparing whole tables");
+		return;
+	}
+
+	for (i = 0; i < (int)ARRSIZE(dbsync_changelog_tables); i++)
+	{
+		for (j = 0; j < (int)ARRSIZE(operations); j++)
+		{
+			zbx_snprintf(name, sizeof(name), "%s_%s", dbsync_changelog_tables[i], operations[j]);
+
+			if (SUCCEED != DBtrigger_exists(dbsync_changelog_tables[i], name))
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "changelog trigger \"%s\" does not exist, configuration cache"
+						" will be synchronized by comparing whole tables", name);
+				return;
+			}
+		}
+	}
+
+	dbsync_changelog_triggers = SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_env_prepare                                           *
+ *                                                                            *
+ * Purpose: reads changelog records written by database triggers since the   *
+ *          last synchronization                                              *
+ *                                                                            *
+ * Parameter: mode - [IN] the synchronization mode                            *
+ *                                                                            *
+ * Comments: In ZBX_DBSYNC_UPDATE mode hosts, items, triggers, functions and  *
+ *           item preprocessing steps are compared only if listed in          *
+ *           changelog. Other modes compare whole tables and only record the  *
+ *           changelog records to remove them afterwards.                     *
+ *           If changelog cannot be read or some of its triggers are missing  *
+ *           whole tables are compared. Changelog existence is checked during *
+ *           initial and forced synchronization.                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_prepare(unsigned char mode)
+{
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_uint64_t		changelogid, objectid;
+	zbx_vector_uint64_t	*objectids;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() mode:%d", __func__, (int)mode);
+
+	if (ZBX_DBSYNC_INIT == mode || ZBX_SYNC_FULL == mode)
+		dbsync_check_changelog();
+
+	/* records written by the existing triggers are still removed to keep changelog from growing */
+	if (SUCCEED != dbsync_changelog_table)
+		goto out;
+
+	if (NULL == (result = DBselect("select changelogid,object,objectid from changelog")))
+		goto out;
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		ZBX_STR2UINT64(changelogid, row[0]);
+		zbx_vector_uint64_append(&dbsync_env.changelogids, changelogid);
+
+		if (ZBX_DBSYNC_UPDATE != mode || SUCCEED != dbsync_changelog_triggers)
+			continue;
+
+		switch (atoi(row[1]))
+		{
+			case ZBX_DBSYNC_OBJ_HOST:
+				objectids = &dbsync_env.hostids;
+				break;
+			case ZBX_DBSYNC_OBJ_ITEM:
+				objectids = &dbsync_env.itemids;
+				break;
+			case ZBX_DBSYNC_OBJ_TRIGGER:
+				objectids = &dbsync_env.triggerids;
+				break;
+			case ZBX_DBSYNC_OBJ_FUNCTION:
+				objectids = &dbsync_env.functionids;
+				break;
+			case ZBX_DBSYNC_OBJ_ITEM_PREPROC:
+				objectids = &dbsync_env.item_preprocids;
+				break;
+			default:
+				continue;
+		}
+
+		ZBX_STR2UINT64(objectid, row[2]);
+		zbx_vector_uint64_append(objectids, objectid);
+	}
+	DBfree_result(result);
+
+	if (ZBX_DBSYNC_UPDATE == mode && SUCCEED == dbsync_changelog_triggers)
+	{
+		zbx_vector_uint64_sort(&dbsync_env.hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&dbsync_env.hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort(&dbsync_env.itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&dbsync_env.itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort(&dbsync_env.triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&dbsync_env.triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort(&dbsync_env.functionids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&dbsync_env.functionids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_sort(&dbsync_env.item_preprocids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&dbsync_env.item_preprocids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		dbsync_env.changelog = SUCCEED;
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() changelog:%d hosts:%d items:%d triggers:%d functions:%d"
+			" preprocessing:%d", __func__, dbsync_env.changelogids.values_num,
+			dbsync_env.hostids.values_num, dbsync_env.itemids.values_num,
+			dbsync_env.triggerids.values_num, dbsync_env.functionids.values_num,
+			dbsync_env.item_preprocids.values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_env_disable_changelog                                 *
+ *                                                                            *
+ * Purpose: forces comparison of whole tables during the rest of              *
+ *          synchronization                                                   *
+ *                                                                            *
+ * Comments: Used when changes not tracked by changelog (for example user     *
+ *           macros expanded in item and trigger rows) can affect the         *
+ *           changelog tracked objects.                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_disable_changelog(void)
+{
+	dbsync_env.changelog = FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_env_flush_changelog                                   *
+ *                                                                            *
+ * Purpose: removes the processed changelog records from database             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_flush_changelog(void)
+{
+	if (0 == dbsync_env.changelogids.values_num)
+		return;
+
+	zbx_vector_uint64_sort(&dbsync_env.changelogids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	DBbegin();
+	DBexecute_multiple_query("delete from changelog where", "changelogid", &dbsync_env.changelogids);
+	DBcommit();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_get_changelog_filter                                      *
+ *                                                                            *
+ * Purpose: prepares condition to select only the rows of objects changed    *
+ *          according to changelog                                            *
+ *                                                                            *
+ * Parameters: sync   - [IN] the changeset                                    *
+ *             fields - [IN] the object identifier fields                     *
+ *             ids    - [IN] the sorted object identifiers for each field     *
+ *             num    - [IN] the number of fields                             *
+ *             filter - [OUT] the condition to append to query, NULL if       *
+ *                            the whole table must be compared                *
+ *                                                                            *
+ * Return value: SUCCEED - the rows must be selected from database            *
+ *               FAIL    - there are no changed objects                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_get_changelog_filter(const zbx_dbsync_t *sync, const char **fields, zbx_vector_uint64_t **ids,
+		int num, char **filter)
+{
+	size_t	filter_alloc = 0, filter_offset = 0;
+	int	i, conditions = 0;
+
+	if (ZBX_DBSYNC_UPDATE != sync->mode || SUCCEED != dbsync_env.changelog)
+		return SUCCEED;
+
+	for (i = 0; i < num; i++)
+	{
+		if (0 == ids[i]->values_num)
+			continue;
+
+		zbx_strcpy_alloc(filter, &filter_alloc, &filter_offset, 0 == conditions++ ? " and (" : " or");
+		DBadd_condition_alloc(filter, &filter_alloc, &filter_offset, fields[i], ids[i]->values,
+				ids[i]->values_num);
+	}
+
+	if (0 == conditions)
+		return FAIL;
+
+	zbx_chrcpy_alloc(filter, &filter_alloc, &filter_offset, ')');
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_remove_changed_rows                                       *
+ *                                                                            *
+ * Purpose: adds removal rows for changed cached objects that were not        *
+ *          selected from database                                            *
+ *                                                                            *
+ * Parameters: sync      - [IN/OUT] the changeset                             *
+ *             objectids - [IN] the changed object identifiers                *
+ *             objects   - [IN] the cached objects                            *
+ *             ids       - [IN] the identifiers of selected rows              *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_remove_changed_rows(zbx_dbsync_t *sync, const zbx_vector_uint64_t *objectids,
+		zbx_hashset_t *objects, zbx_hashset_t *ids)
+{
+	int	i;
+
+	for (i = 0; i < objectids->values_num; i++)
+	{
+		if (NULL != zbx_hashset_search(ids, &objectids->values[i]))
+			continue;
+
+		if (NULL != zbx_hashset_search(objects, &objectids->values[i]))
+			dbsync_add_row(sync, objectids->values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_dbsync_init                                                  *
@@ -677,6 +980,15 @@ int	zbx_dbsync_compare_hosts(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	ZBX_DC_HOST		*host;
+	char			*filter = NULL;
+	const char		*fields[] = {"hostid"};
+	zbx_vector_uint64_t	*objectids[] = {&dbsync_env.hostids};
+
+	if (FAIL == dbsync_get_changelog_filter(sync, fields, objectids, ARRSIZE(fields), &filter))
+	{
+		dbsync_prepare(sync, 34 + ZBX_HOST_TLS_OFFSET, NULL);
+		return SUCCEED;
+	}
 
 #if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	if (NULL == (result = DBselect(
@@ -690,11 +1002,12 @@ int	zbx_dbsync_compare_hosts(zbx_dbsync_t *sync)
 				"maintenanceid"
 			" from hosts"
 			" where status in (%d,%d,%d,%d)"
-				" and flags<>%d",
+				" and flags<>%d%s",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
 			HOST_STATUS_PROXY_ACTIVE, HOST_STATUS_PROXY_PASSIVE,
-			ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			ZBX_FLAG_DISCOVERY_PROTOTYPE, ZBX_NULL2EMPTY_STR(filter))))
 	{
+		zbx_free(filter);
 		return FAIL;
 	}
 
@@ -710,11 +1023,12 @@ int	zbx_dbsync_compare_hosts(zbx_dbsync_t *sync)
 				"proxy_address,auto_compress,maintenanceid"
 			" from hosts"
 			" where status in (%d,%d,%d,%d)"
-				" and flags<>%d",
+				" and flags<>%d%s",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
 			HOST_STATUS_PROXY_ACTIVE, HOST_STATUS_PROXY_PASSIVE,
-			ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			ZBX_FLAG_DISCOVERY_PROTOTYPE, ZBX_NULL2EMPTY_STR(filter))))
 	{
+		zbx_free(filter);
 		return FAIL;
 	}
 
@@ -727,8 +1041,8 @@ int	zbx_dbsync_compare_hosts(zbx_dbsync_t *sync)
 		return SUCCEED;
 	}
 
-	zbx_hashset_create(&ids, dbsync_env.cache->hosts.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&ids, NULL == filter ? dbsync_env.cache->hosts.num_data : dbsync_env.hostids.values_num,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	while (NULL != (dbrow = DBfetch(result)))
 	{
@@ -738,19 +1052,47 @@ int	zbx_dbsync_compare_hosts(zbx_dbsync_t *sync)
 		zbx_hashset_insert(&ids, &rowid, sizeof(rowid));
 
 		if (NULL == (host = (ZBX_DC_HOST *)zbx_hashset_search(&dbsync_env.cache->hosts, &rowid)))
+		{
 			tag = ZBX_DBSYNC_ROW_ADD;
+		}
 		else if (FAIL == dbsync_compare_host(host, dbrow))
+		{
 			tag = ZBX_DBSYNC_ROW_UPDATE;
 
+			if (NULL != filter && 0 != host->update_items)
+				zbx_vector_uint64_append(&dbsync_env.update_hostids, rowid);
+		}
+
 		if (ZBX_DBSYNC_ROW_NONE != tag)
 			dbsync_add_row(sync, rowid, tag, dbrow);
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->hosts, &iter);
-	while (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_iter_next(&iter)))
+	if (NULL == filter)
+	{
+		zbx_hashset_iter_reset(&dbsync_env.cache->hosts, &iter);
+		while (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &host->hostid))
+				dbsync_add_row(sync, host->hostid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
+	}
+	else
 	{
-		if (NULL == zbx_hashset_search(&ids, &host->hostid))
-			dbsync_add_row(sync, host->hostid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		int	i;
+
+		dbsync_remove_changed_rows(sync, &dbsync_env.hostids, &dbsync_env.cache->hosts, &ids);
+
+		/* items of removed hosts must be removed too */
+		for (i = 0; i < sync->rows.values_num; i++)
+		{
+			zbx_dbsync_row_t	*row = (zbx_dbsync_row_t *)sync->rows.values[i];
+
+			if (ZBX_DBSYNC_ROW_REMOVE == row->tag)
+				zbx_vector_uint64_append(&dbsync_env.update_hostids, row->rowid);
+		}
+
+		zbx_vector_uint64_sort(&dbsync_env.update_hostids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_free(filter);
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -1820,7 +2162,15 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	ZBX_DC_ITEM		*item;
-	char			**row;
+	char			**row, *filter = NULL;
+	const char		*fields[] = {"i.itemid", "i.hostid"};
+	zbx_vector_uint64_t	*objectids[] = {&dbsync_env.itemids, &dbsync_env.update_hostids};
+
+	if (FAIL == dbsync_get_changelog_filter(sync, fields, objectids, ARRSIZE(fields), &filter))
+	{
+		dbsync_prepare(sync, 50, dbsync_item_preproc_row);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = DBselect(
 			"select i.itemid,i.hostid,i.status,i.type,i.value_type,i.key_,i.snmp_oid,i.ipmi_sensor,i.delay,"
@@ -1835,10 +2185,11 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 			" inner join hosts h on i.hostid=h.hostid"
 			" left join item_discovery id on i.itemid=id.itemid"
 			" join item_rtdata ir on i.itemid=ir.itemid"
-			" where h.status in (%d,%d) and i.flags<>%d",
-			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED, ZBX_FLAG_DISCOVERY_PROTOTYPE)))
-
+			" where h.status in (%d,%d) and i.flags<>%d%s",
+			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED, ZBX_FLAG_DISCOVERY_PROTOTYPE,
+			ZBX_NULL2EMPTY_STR(filter))))
 	{
+		zbx_free(filter);
 		return FAIL;
 	}
 
@@ -1850,8 +2201,8 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 		return SUCCEED;
 	}
 
-	zbx_hashset_create(&ids, dbsync_env.cache->items.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&ids, NULL == filter ? dbsync_env.cache->items.num_data : dbsync_env.itemids.values_num,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	while (NULL != (dbrow = DBfetch(result)))
 	{
@@ -1871,11 +2222,62 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 			dbsync_add_row(sync, rowid, tag, row);
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->items, &iter);
-	while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+	if (NULL == filter)
 	{
-		if (NULL == zbx_hashset_search(&ids, &item->itemid))
-			dbsync_add_row(sync, item->itemid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		zbx_hashset_iter_reset(&dbsync_env.cache->items, &iter);
+		while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &item->itemid))
+				dbsync_add_row(sync, item->itemid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
+	}
+	else
+	{
+		zbx_vector_uint64_t	itemids;
+		ZBX_DC_HOST		*host;
+		int			i;
+
+		zbx_vector_uint64_create(&itemids);
+		zbx_vector_uint64_append_array(&itemids, dbsync_env.itemids.values, dbsync_env.itemids.values_num);
+
+		if (0 != dbsync_env.update_hostids.values_num)
+		{
+			zbx_hashset_iter_reset(&dbsync_env.cache->items, &iter);
+			while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+			{
+				if (FAIL != zbx_vector_uint64_bsearch(&dbsync_env.update_hostids, item->hostid,
+						ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+				{
+					zbx_vector_uint64_append(&itemids, item->itemid);
+				}
+			}
+
+			/* the host items are compared, reset the flag forcing their update */
+			for (i = 0; i < dbsync_env.update_hostids.values_num; i++)
+			{
+				if (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_search(&dbsync_env.cache->hosts,
+						&dbsync_env.update_hostids.values[i])))
+				{
+					host->update_items = 0;
+				}
+			}
+
+			zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_uniq(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		}
+
+		dbsync_remove_changed_rows(sync, &itemids, &dbsync_env.cache->items, &ids);
+		zbx_vector_uint64_destroy(&itemids);
+
+		/* remember the changed items to compare their preprocessing steps and functions */
+		for (i = 0; i < sync->rows.values_num; i++)
+		{
+			zbx_vector_uint64_append(&dbsync_env.update_itemids,
+					((zbx_dbsync_row_t *)sync->rows.values[i])->rowid);
+		}
+
+		zbx_vector_uint64_sort(&dbsync_env.update_itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_free(filter);
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -2178,7 +2580,15 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	ZBX_DC_TRIGGER		*trigger;
-	char			**row;
+	char			**row, *filter = NULL;
+	const char		*fields[] = {"t.triggerid"};
+	zbx_vector_uint64_t	*objectids[] = {&dbsync_env.update_triggerids};
+
+	if (FAIL == dbsync_get_changelog_filter(sync, fields, objectids, ARRSIZE(fields), &filter))
+	{
+		dbsync_prepare(sync, 16, dbsync_trigger_preproc_row);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = DBselect(
 			"select distinct t.triggerid,t.description,t.expression,t.error,t.priority,t.type,t.value,"
@@ -2189,10 +2599,11 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 				" and i.itemid=f.itemid"
 				" and f.triggerid=t.triggerid"
 				" and h.status in (%d,%d)"
-				" and t.flags<>%d",
+				" and t.flags<>%d%s",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			ZBX_FLAG_DISCOVERY_PROTOTYPE, ZBX_NULL2EMPTY_STR(filter))))
 	{
+		zbx_free(filter);
 		return FAIL;
 	}
 
@@ -2204,7 +2615,8 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 		return SUCCEED;
 	}
 
-	zbx_hashset_create(&ids, dbsync_env.cache->triggers.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
+	zbx_hashset_create(&ids, NULL == filter ? dbsync_env.cache->triggers.num_data :
+			dbsync_env.update_triggerids.values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
 			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	while (NULL != (dbrow = DBfetch(result)))
@@ -2225,11 +2637,19 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 		}
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->triggers, &iter);
-	while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
+	if (NULL == filter)
 	{
-		if (NULL == zbx_hashset_search(&ids, &trigger->triggerid))
-			dbsync_add_row(sync, trigger->triggerid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		zbx_hashset_iter_reset(&dbsync_env.cache->triggers, &iter);
+		while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &trigger->triggerid))
+				dbsync_add_row(sync, trigger->triggerid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
+	}
+	else
+	{
+		dbsync_remove_changed_rows(sync, &dbsync_env.update_triggerids, &dbsync_env.cache->triggers, &ids);
+		zbx_free(filter);
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -2407,7 +2827,16 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	ZBX_DC_FUNCTION		*function;
-	char			**row;
+	char			**row, *filter = NULL;
+	const char		*fields[] = {"f.functionid", "f.itemid", "f.triggerid"};
+	zbx_vector_uint64_t	*objectids[] = {&dbsync_env.functionids, &dbsync_env.update_itemids,
+						&dbsync_env.triggerids};
+
+	if (FAIL == dbsync_get_changelog_filter(sync, fields, objectids, ARRSIZE(fields), &filter))
+	{
+		dbsync_prepare(sync, 6, dbsync_function_preproc_row);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = DBselect(
 			"select i.itemid,f.functionid,f.name,f.parameter,t.triggerid,i.hostid"
@@ -2416,10 +2845,11 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 				" and i.itemid=f.itemid"
 				" and f.triggerid=t.triggerid"
 				" and h.status in (%d,%d)"
-				" and t.flags<>%d",
+				" and t.flags<>%d%s",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			ZBX_FLAG_DISCOVERY_PROTOTYPE, ZBX_NULL2EMPTY_STR(filter))))
 	{
+		zbx_free(filter);
 		return FAIL;
 	}
 
@@ -2431,8 +2861,8 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 		return SUCCEED;
 	}
 
-	zbx_hashset_create(&ids, dbsync_env.cache->functions.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&ids, NULL == filter ? dbsync_env.cache->functions.num_data :
+			dbsync_env.functionids.values_num, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	while (NULL != (dbrow = DBfetch(result)))
 	{
@@ -2452,11 +2882,73 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 			dbsync_add_row(sync, rowid, tag, row);
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->functions, &iter);
-	while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
+	if (NULL == filter)
 	{
-		if (NULL == zbx_hashset_search(&ids, &function->functionid))
-			dbsync_add_row(sync, function->functionid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		zbx_hashset_iter_reset(&dbsync_env.cache->functions, &iter);
+		while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &function->functionid))
+				dbsync_add_row(sync, function->functionid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
+	}
+	else
+	{
+		zbx_vector_uint64_t	functionids;
+		zbx_dbsync_row_t	*sync_row;
+		zbx_uint64_t		triggerid;
+		int			i;
+
+		zbx_vector_uint64_create(&functionids);
+		zbx_vector_uint64_append_array(&functionids, dbsync_env.functionids.values,
+				dbsync_env.functionids.values_num);
+
+		if (0 != dbsync_env.update_itemids.values_num || 0 != dbsync_env.triggerids.values_num)
+		{
+			zbx_hashset_iter_reset(&dbsync_env.cache->functions, &iter);
+			while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
+			{
+				if (FAIL != zbx_vector_uint64_bsearch(&dbsync_env.update_itemids, function->itemid,
+						ZBX_DEFAULT_UINT64_COMPARE_FUNC) ||
+						FAIL != zbx_vector_uint64_bsearch(&dbsync_env.triggerids,
+						function->triggerid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+				{
+					zbx_vector_uint64_append(&functionids, function->functionid);
+				}
+			}
+
+			zbx_vector_uint64_sort(&functionids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+			zbx_vector_uint64_uniq(&functionids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		}
+
+		dbsync_remove_changed_rows(sync, &functionids, &dbsync_env.cache->functions, &ids);
+		zbx_vector_uint64_destroy(&functionids);
+
+		/* triggers of the changed functions must be compared together with triggers listed in changelog */
+		zbx_vector_uint64_append_array(&dbsync_env.update_triggerids, dbsync_env.triggerids.values,
+				dbsync_env.triggerids.values_num);
+
+		for (i = 0; i < sync->rows.values_num; i++)
+		{
+			sync_row = (zbx_dbsync_row_t *)sync->rows.values[i];
+
+			if (NULL != sync_row->row)
+			{
+				ZBX_STR2UINT64(triggerid, sync_row->row[4]);
+			}
+			else if (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_search(&dbsync_env.cache->functions,
+					&sync_row->rowid)))
+			{
+				triggerid = function->triggerid;
+			}
+			else
+				continue;
+
+			zbx_vector_uint64_append(&dbsync_env.update_triggerids, triggerid);
+		}
+
+		zbx_vector_uint64_sort(&dbsync_env.update_triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&dbsync_env.update_triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_free(filter);
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -3605,7 +4097,15 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	zbx_dc_preproc_op_t	*preproc;
-	char			**row;
+	char			**row, *filter = NULL;
+	const char		*fields[] = {"pp.item_preprocid", "pp.itemid"};
+	zbx_vector_uint64_t	*objectids[] = {&dbsync_env.item_preprocids, &dbsync_env.update_itemids};
+
+	if (FAIL == dbsync_get_changelog_filter(sync, fields, objectids, ARRSIZE(fields), &filter))
+	{
+		dbsync_prepare(sync, 8, dbsync_item_pp_preproc_row);
+		return SUCCEED;
+	}
 
 	if (NULL == (result = DBselect(
 			"select pp.item_preprocid,pp.itemid,pp.type,pp.params,pp.step,i.hostid,pp.error_handler,"
@@ -3616,12 +4116,13 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 				" and (h.proxy_hostid is null"
 					" or i.type in (%d,%d,%d,%d))"
 				" and h.status in (%d,%d)"
-				" and i.flags<>%d"
+				" and i.flags<>%d%s"
 			" order by pp.itemid",
 			ITEM_TYPE_INTERNAL, ITEM_TYPE_AGGREGATE, ITEM_TYPE_CALCULATED, ITEM_TYPE_DEPENDENT,
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			ZBX_FLAG_DISCOVERY_PROTOTYPE, ZBX_NULL2EMPTY_STR(filter))))
 	{
+		zbx_free(filter);
 		return FAIL;
 	}
 
@@ -3668,12 +4169,48 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 			dbsync_add_row(sync, rowid, tag, row);
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->preprocops, &iter);
+	if (NULL == filter)
+	{
+		zbx_hashset_iter_reset(&dbsync_env.cache->preprocops, &iter);
 
-	while (NULL != (preproc = (zbx_dc_preproc_op_t *)zbx_hashset_iter_next(&iter)))
+		while (NULL != (preproc = (zbx_dc_preproc_op_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &preproc->item_preprocid))
+				dbsync_add_row(sync, preproc->item_preprocid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
+	}
+	else
 	{
-		if (NULL == zbx_hashset_search(&ids, &preproc->item_preprocid))
-			dbsync_add_row(sync, preproc->item_preprocid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		zbx_vector_uint64_t	item_preprocids;
+		ZBX_DC_PREPROCITEM	*pp_item;
+		int			i, j;
+
+		zbx_vector_uint64_create(&item_preprocids);
+		zbx_vector_uint64_append_array(&item_preprocids, dbsync_env.item_preprocids.values,
+				dbsync_env.item_preprocids.values_num);
+
+		for (i = 0; i < dbsync_env.update_itemids.values_num; i++)
+		{
+			if (NULL == (pp_item = (ZBX_DC_PREPROCITEM *)zbx_hashset_search(&dbsync_env.cache->preprocitems,
+					&dbsync_env.update_itemids.values[i])))
+			{
+				continue;
+			}
+
+			for (j = 0; j < pp_item->preproc_ops.values_num; j++)
+			{
+				preproc = (zbx_dc_preproc_op_t *)pp_item->preproc_ops.values[j];
+				zbx_vector_uint64_append(&item_preprocids, preproc->item_preprocid);
+			}
+		}
+
+		zbx_vector_uint64_sort(&item_preprocids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&item_preprocids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		dbsync_remove_changed_rows(sync, &item_preprocids, &dbsync_env.cache->preprocops, &ids);
+
+		zbx_vector_uint64_destroy(&item_preprocids);
+		zbx_free(filter);
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -110,6 +110,9 @@ struct zbx_dbsync
 
 void	zbx_dbsync_init_env(ZBX_DC_CONFIG *cache);
 void	zbx_dbsync_free_env(void);
+void	zbx_dbsync_env_prepare(unsigned char mode);
+void	zbx_dbsync_env_disable_changelog(void);
+void	zbx_dbsync_env_flush_changelog(void);
 
 void	zbx_dbsync_init(zbx_dbsync_t *sync, unsigned char mode);
 void	zbx_dbsync_clear(zbx_dbsync_t *sync);
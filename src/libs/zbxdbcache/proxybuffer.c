@@ -0,0 +1,916 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "log.h"
+#include "mutexs.h"
+#include "zbxalgo.h"
+#include "dbcache.h"
+
+#include <sys/mman.h>
+
+/*
+ * The proxy history buffer is a ring buffer of history records in shared memory, optionally mapped from
+ * a file to survive proxy restarts.
+ *
+ * History syncers append records after the write position and the data sender (or trappers of a passive
+ * proxy, serialized by the proxy history lock) reads records from the read position. The read position is
+ * advanced only after the data was accepted by server, so the reader can access records between read and
+ * write positions without locking - writers never touch that area.
+ *
+ * Positions are logical byte offsets that only grow; the physical offset is position modulo data size.
+ * A record never wraps around the end of data area, padding record fills the tail instead.
+ *
+ * Each record holds its sequence number and data checksum. The write position in the header is updated
+ * only after the records are written, and when the buffer file is opened the records between read and
+ * write positions are validated. The buffer is truncated at the first invalid record, so values partially
+ * written before a crash are discarded instead of being sent to server.
+ *
+ * When a batch of values does not fit into free space the buffer switches to overflow mode - values are
+ * written to proxy_history table. The data sender switches writers back to the buffer as soon as there is
+ * room for the rejected batch and no history syncer is writing to the database. At that moment it records
+ * the write position and the last proxy_history id, so the records written before the switch are sent
+ * first, then the database history up to that id and then the rest of buffer. This also applies after
+ * start, so history left in the database is sent before the values buffered after start.
+ *
+ * Values older than ProxyOfflineBuffer are discarded from the buffer the same way housekeeper removes
+ * them from proxy_history table.
+ */
+
+#define ZBX_PB_MAGIC		0x5a425042
+#define ZBX_PB_VERSION		2
+
+#define ZBX_PB_HEADER_SIZE	4096
+
+#define ZBX_PB_ALIGN_SIZE	16
+#define ZBX_PB_ALIGN(size)	(((size) + ZBX_PB_ALIGN_SIZE - 1) & ~(zbx_uint64_t)(ZBX_PB_ALIGN_SIZE - 1))
+
+typedef struct
+{
+	zbx_uint32_t	magic;
+	zbx_uint32_t	version;
+	zbx_uint64_t	size;		/* the data area size */
+	zbx_uint64_t	read_pos;	/* position of the first record not yet sent to server */
+	zbx_uint64_t	write_pos;	/* position after the last written record */
+	zbx_uint64_t	write_seq;	/* sequence number of the next record */
+	zbx_uint64_t	valueid;	/* the last value identifier sent to server */
+	zbx_uint64_t	db_pos;		/* position of the first record to send after database history */
+	zbx_uint64_t	db_maxid;	/* the last database history id to send before db_pos record */
+	zbx_uint64_t	db_batches;	/* the number of batches rejected to database */
+	zbx_uint64_t	overflow_size;	/* the space required by the largest rejected batch, at most the buffer size */
+	int		db_writers;	/* the number of processes writing rejected batches to database */
+	int		db_pending;	/* 1 - database history up to db_maxid is not sent yet */
+	int		overflow;	/* 1 - values are written to database */
+}
+zbx_pb_header_t;
+
+/* record header, sequence number 0 marks padding till the end of data area */
+typedef struct
+{
+	zbx_uint64_t	seq;
+	zbx_uint32_t	size;		/* record size including header and alignment */
+	zbx_uint32_t	checksum;	/* checksum of record data */
+}
+zbx_pb_record_t;
+
+/* record data, followed by zero terminated source and value strings */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_uint64_t	lastlogsize;
+	int		clock;
+	int		ns;
+	int		timestamp;
+	int		severity;
+	int		logeventid;
+	int		mtime;
+	int		write_clock;
+	zbx_uint32_t	source_len;	/* including terminating zero */
+	zbx_uint32_t	value_len;	/* including terminating zero */
+	unsigned char	state;
+	unsigned char	flags;
+}
+zbx_pb_value_t;
+
+static zbx_mutex_t	pb_lock = ZBX_MUTEX_NULL;
+static zbx_pb_header_t	*pb_header = NULL;
+static unsigned char	*pb_data;
+static size_t		pb_map_size;
+static int		pb_mapped_file;
+static int		pb_max_age;
+
+#define LOCK_PB		zbx_mutex_lock(pb_lock)
+#define UNLOCK_PB	zbx_mutex_unlock(pb_lock)
+
+static zbx_pb_record_t	*pb_record(zbx_uint64_t pos)
+{
+	return (zbx_pb_record_t *)(pb_data + pos % pb_header->size);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_record_pos                                                    *
+ *                                                                            *
+ * Purpose: gets position where record of the specified size can be written  *
+ *          without wrapping around the end of data area                      *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	pb_record_pos(zbx_uint64_t pos, zbx_uint64_t size)
+{
+	zbx_uint64_t	left = pb_header->size - pos % pb_header->size;
+
+	return size <= left ? pos : pos + left;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_record_check                                                  *
+ *                                                                            *
+ * Purpose: validates record written at the specified position                *
+ *                                                                            *
+ * Parameters: pos - [IN] the record position                                 *
+ *             seq - [IN] the expected sequence number, 0 - any               *
+ *                                                                            *
+ * Return value: SUCCEED - the record is valid                                *
+ *               FAIL    - the record is incomplete or corrupted              *
+ *                                                                            *
+ ******************************************************************************/
+static int	pb_record_check(zbx_uint64_t pos, zbx_uint64_t seq)
+{
+	const zbx_pb_record_t	*rec = pb_record(pos);
+	const zbx_pb_value_t	*value = (const zbx_pb_value_t *)(rec + 1);
+	const char		*str;
+	zbx_uint64_t		left = pb_header->size - pos % pb_header->size, size;
+
+	if (sizeof(zbx_pb_record_t) > rec->size || left < rec->size || 0 != rec->size % ZBX_PB_ALIGN_SIZE)
+		return FAIL;
+
+	if (0 == rec->seq)
+		return left == rec->size ? SUCCEED : FAIL;
+
+	if (0 != seq && seq != rec->seq)
+		return FAIL;
+
+	if (sizeof(zbx_pb_record_t) + sizeof(zbx_pb_value_t) > rec->size)
+		return FAIL;
+
+	size = sizeof(zbx_pb_value_t) + (zbx_uint64_t)value->source_len + value->value_len;
+
+	if (0 == value->source_len || 0 == value->value_len || sizeof(zbx_pb_record_t) + size > rec->size)
+		return FAIL;
+
+	if (rec->checksum != zbx_hash_modfnv(value, size, (zbx_hash_t)rec->seq))
+		return FAIL;
+
+	str = (const char *)(value + 1);
+
+	if ('\0' != str[value->source_len - 1] || '\0' != str[value->source_len + value->value_len - 1])
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_recover                                                       *
+ *                                                                            *
+ * Purpose: truncates buffer loaded from file at the first invalid record     *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_recover(void)
+{
+	zbx_uint64_t	pos = pb_header->read_pos, seq = 0;
+	int		records_num = 0;
+
+	while (pos < pb_header->write_pos && SUCCEED == pb_record_check(pos, seq))
+	{
+		const zbx_pb_record_t	*rec = pb_record(pos);
+
+		if (pb_header->write_pos - pos < rec->size)
+			break;
+
+		if (0 != rec->seq)
+		{
+			seq = rec->seq + 1;
+			records_num++;
+		}
+
+		pos += rec->size;
+	}
+
+	if (pos != pb_header->write_pos)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "discarded " ZBX_FS_UI64 " bytes of incomplete proxy history buffer"
+				" records", pb_header->write_pos - pos);
+
+		pb_header->write_pos = pos;
+
+		if (0 != seq)
+			pb_header->write_seq = seq;
+	}
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "loaded %d values from proxy history buffer", records_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_init                                                      *
+ *                                                                            *
+ * Purpose: initializes proxy history buffer                                  *
+ *                                                                            *
+ * Parameters: filename - [IN] the buffer file, NULL - memory only buffer     *
+ *             size     - [IN] the buffer data size, 0 - buffer is disabled   *
+ *             max_age  - [IN] the maximum age of buffered values in seconds  *
+ *             error    - [OUT] the error message                             *
+ *                                                                            *
+ * Return value: SUCCEED - the buffer was initialized successfully            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_init(const char *filename, zbx_uint64_t size, int max_age, char **error)
+{
+	void		*addr;
+	int		fd = -1, ret = FAIL, rc;
+	struct stat	st;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() size:" ZBX_FS_UI64, __func__, size);
+
+	if (0 == size)
+	{
+		ret = SUCCEED;
+		goto out;
+	}
+
+	size -= size % ZBX_PB_ALIGN_SIZE;
+	pb_map_size = (size_t)(ZBX_PB_HEADER_SIZE + size);
+	pb_max_age = max_age;
+
+	if (SUCCEED != zbx_mutex_create(&pb_lock, ZBX_MUTEX_PROXY_BUFFER, error))
+		goto out;
+
+	if (NULL != filename)
+	{
+		if (-1 == (fd = open(filename, O_RDWR | O_CREAT, 0640)))
+		{
+			*error = zbx_dsprintf(*error, "cannot open \"%s\": %s", filename, zbx_strerror(errno));
+			goto out;
+		}
+
+		if (0 != fstat(fd, &st))
+		{
+			*error = zbx_dsprintf(*error, "cannot stat \"%s\": %s", filename, zbx_strerror(errno));
+			goto out;
+		}
+
+		/* allocate disk space now, writing to a hole of mapped file fails with SIGBUS if disk is full */
+		if (0 != (rc = posix_fallocate(fd, 0, (off_t)pb_map_size)))
+		{
+			*error = zbx_dsprintf(*error, "cannot allocate \"%s\": %s", filename, zbx_strerror(rc));
+			goto out;
+		}
+
+		addr = mmap(NULL, pb_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	else
+		addr = mmap(NULL, pb_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	if (MAP_FAILED == addr)
+	{
+		*error = zbx_dsprintf(*error, "cannot map buffer memory: %s", zbx_strerror(errno));
+		goto out;
+	}
+
+	pb_header = (zbx_pb_header_t *)addr;
+	pb_data = (unsigned char *)addr + ZBX_PB_HEADER_SIZE;
+	pb_mapped_file = (NULL != filename ? 1 : 0);
+
+	if (NULL != filename && ZBX_PB_MAGIC == pb_header->magic && ZBX_PB_VERSION == pb_header->version &&
+			size == pb_header->size && pb_header->read_pos <= pb_header->write_pos &&
+			pb_header->write_pos - pb_header->read_pos <= size)
+	{
+		pb_recover();
+	}
+	else
+	{
+		if (NULL != filename && 0 != st.st_size)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "proxy history buffer file \"%s\" has different size or format,"
+					" discarding its contents", filename);
+		}
+
+		memset(pb_header, 0, sizeof(zbx_pb_header_t));
+		pb_header->magic = ZBX_PB_MAGIC;
+		pb_header->version = ZBX_PB_VERSION;
+		pb_header->size = size;
+		pb_header->write_seq = 1;
+	}
+
+	/* history left in database must be accounted by data sender before the buffer can be used */
+	pb_header->overflow = 1;
+	pb_header->overflow_size = 0;
+	pb_header->db_writers = 0;
+
+	ret = SUCCEED;
+out:
+	if (-1 != fd)
+		close(fd);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_destroy                                                   *
+ *                                                                            *
+ * Purpose: flushes buffer file and releases proxy history buffer             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_destroy(void)
+{
+	if (NULL == pb_header)
+		return;
+
+	if (0 != pb_mapped_file && 0 != msync(pb_header, pb_map_size, MS_SYNC))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot flush proxy history buffer: %s", zbx_strerror(errno));
+
+	munmap(pb_header, pb_map_size);
+	pb_header = NULL;
+
+	zbx_mutex_destroy(&pb_lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_enabled                                                   *
+ *                                                                            *
+ * Return value: SUCCEED - proxy history buffer is enabled                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_enabled(void)
+{
+	return NULL != pb_header ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_write_value                                                   *
+ *                                                                            *
+ * Purpose: writes value record at the specified position                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_write_value(zbx_uint64_t pos, zbx_uint64_t seq, zbx_uint32_t size, const zbx_pb_history_t *h)
+{
+	zbx_pb_record_t	*rec = pb_record(pos);
+	zbx_pb_value_t	*value = (zbx_pb_value_t *)(rec + 1);
+	char		*str = (char *)(value + 1);
+
+	value->itemid = h->itemid;
+	value->lastlogsize = h->lastlogsize;
+	value->clock = h->clock;
+	value->ns = h->ns;
+	value->timestamp = h->timestamp;
+	value->severity = h->severity;
+	value->logeventid = h->logeventid;
+	value->mtime = h->mtime;
+	value->write_clock = h->write_clock;
+	value->source_len = (zbx_uint32_t)strlen(h->source) + 1;
+	value->value_len = (zbx_uint32_t)strlen(h->value) + 1;
+	value->state = h->state;
+	value->flags = h->flags;
+
+	memcpy(str, h->source, value->source_len);
+	memcpy(str + value->source_len, h->value, value->value_len);
+
+	rec->seq = seq;
+	rec->size = size;
+	rec->checksum = zbx_hash_modfnv(value, sizeof(zbx_pb_value_t) + value->source_len + value->value_len,
+			(zbx_hash_t)seq);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_add                                               *
+ *                                                                            *
+ * Purpose: writes history values to proxy history buffer                     *
+ *                                                                            *
+ * Parameters: values     - [IN] the values to write                          *
+ *             values_num - [IN] the number of values                         *
+ *                                                                            *
+ * Return value: SUCCEED - all values were written                            *
+ *               FAIL    - the buffer is disabled, full or in overflow mode,  *
+ *                         no values were written                             *
+ *                                                                            *
+ * Comments: When the buffer is enabled and values were not written, the      *
+ *           caller must write them to database and then call                 *
+ *           zbx_pb_history_db_written().                                     *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_add(const zbx_pb_history_t *values, int values_num)
+{
+	int		i, ret = FAIL;
+	zbx_uint32_t	*sizes;
+	zbx_uint64_t	pos, start, size;
+
+	if (NULL == pb_header)
+		return FAIL;
+
+	sizes = (zbx_uint32_t *)zbx_malloc(NULL, sizeof(zbx_uint32_t) * values_num);
+
+	for (i = 0; i < values_num; i++)
+	{
+		sizes[i] = (zbx_uint32_t)ZBX_PB_ALIGN(sizeof(zbx_pb_record_t) + sizeof(zbx_pb_value_t) +
+				strlen(values[i].source) + strlen(values[i].value) + 2);
+	}
+
+	LOCK_PB;
+
+	for (pos = pb_header->write_pos, i = 0; i < values_num; i++)
+		pos = pb_record_pos(pos, sizes[i]) + sizes[i];
+
+	size = pos - pb_header->write_pos;
+
+	if (0 == pb_header->overflow && pos - pb_header->read_pos > pb_header->size)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "proxy history buffer is full, history will be stored in database"
+				" until there is enough free space in the buffer");
+		pb_header->overflow = 1;
+	}
+
+	if (0 != pb_header->overflow)
+	{
+		/* batches larger than the buffer never fit, waiting for an empty buffer is enough to switch back */
+		if (size > pb_header->overflow_size)
+			pb_header->overflow_size = MIN(size, pb_header->size);
+
+		pb_header->db_writers++;
+		pb_header->db_batches++;
+		goto unlock;
+	}
+
+	for (pos = pb_header->write_pos, i = 0; i < values_num; i++)
+	{
+		if (pos != (start = pb_record_pos(pos, sizes[i])))
+		{
+			zbx_pb_record_t	*rec = pb_record(pos);
+
+			rec->seq = 0;
+			rec->size = (zbx_uint32_t)(start - pos);
+			rec->checksum = 0;
+		}
+
+		pb_write_value(start, pb_header->write_seq + i, sizes[i], &values[i]);
+		pos = start + sizes[i];
+	}
+
+	/* publish the records only after they are completely written */
+	pb_header->write_seq += values_num;
+	pb_header->write_pos = pos;
+
+	ret = SUCCEED;
+unlock:
+	UNLOCK_PB;
+
+	zbx_free(sizes);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_db_written                                        *
+ *                                                                            *
+ * Purpose: notifies that values rejected by zbx_pb_history_add() have been   *
+ *          written to database                                               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_history_db_written(void)
+{
+	if (NULL == pb_header)
+		return;
+
+	LOCK_PB;
+
+	if (0 < pb_header->db_writers)
+		pb_header->db_writers--;
+
+	UNLOCK_PB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_get                                               *
+ *                                                                            *
+ * Purpose: reads history values from proxy history buffer                    *
+ *                                                                            *
+ * Parameters: lastid     - [IN] the position after the last read value, 0 -  *
+ *                               read from the first value not sent to server *
+ *             values     - [OUT] the values                                  *
+ *             values_max - [IN] the maximum number of values to read         *
+ *                                                                            *
+ * Return value: The number of values read.                                   *
+ *                                                                            *
+ * Comments: The value strings point to the buffer memory and stay valid till *
+ *           the read position is moved past them.                            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_get(zbx_uint64_t lastid, zbx_pb_history_t *values, int values_max)
+{
+	zbx_uint64_t	pos, end;
+	int		values_num = 0;
+
+	if (NULL == pb_header)
+		return 0;
+
+	LOCK_PB;
+
+	pos = MAX(lastid, pb_header->read_pos);
+
+	/* records written after switching back from database are sent after the database history */
+	if (0 != pb_header->db_pending && pos <= pb_header->db_pos)
+		end = pb_header->db_pos;
+	else
+		end = pb_header->write_pos;
+
+	UNLOCK_PB;
+
+	while (pos < end && values_num < values_max)
+	{
+		const zbx_pb_record_t	*rec = pb_record(pos);
+		const zbx_pb_value_t	*value;
+		zbx_pb_history_t	*h;
+
+		if (sizeof(zbx_pb_record_t) > rec->size || end - pos < rec->size)
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			break;
+		}
+
+		if (0 == rec->seq)
+		{
+			pos += rec->size;
+			continue;
+		}
+
+		value = (const zbx_pb_value_t *)(rec + 1);
+		h = &values[values_num++];
+
+		h->id = pos + rec->size;
+		h->itemid = value->itemid;
+		h->lastlogsize = value->lastlogsize;
+		h->source = (const char *)(value + 1);
+		h->value = h->source + value->source_len;
+		h->clock = value->clock;
+		h->ns = value->ns;
+		h->timestamp = value->timestamp;
+		h->severity = value->severity;
+		h->logeventid = value->logeventid;
+		h->mtime = value->mtime;
+		h->write_clock = value->write_clock;
+		h->state = value->state;
+		h->flags = value->flags;
+
+		pos += rec->size;
+	}
+
+	return values_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_set_lastid                                        *
+ *                                                                            *
+ * Purpose: moves read position after values accepted by server               *
+ *                                                                            *
+ * Parameters: lastid - [IN] the position after the last sent value           *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_history_set_lastid(zbx_uint64_t lastid)
+{
+	if (NULL == pb_header)
+		return;
+
+	LOCK_PB;
+
+	if (lastid > pb_header->read_pos && lastid <= pb_header->write_pos)
+		pb_header->read_pos = lastid;
+
+	UNLOCK_PB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_get_delay                                         *
+ *                                                                            *
+ * Purpose: gets age of the oldest value not sent to server                   *
+ *                                                                            *
+ * Parameters: lastid - [IN] the position after the last sent value           *
+ *                                                                            *
+ * Return value: The number of seconds since the value was written or 0 if    *
+ *               there are no more values.                                    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_get_delay(zbx_uint64_t lastid)
+{
+	zbx_uint64_t	pos;
+	int		delay = 0;
+
+	if (NULL == pb_header)
+		return 0;
+
+	LOCK_PB;
+
+	for (pos = MAX(lastid, pb_header->read_pos); pos < pb_header->write_pos; pos += pb_record(pos)->size)
+	{
+		const zbx_pb_record_t	*rec = pb_record(pos);
+
+		if (0 != rec->seq)
+		{
+			delay = (int)time(NULL) - ((const zbx_pb_value_t *)(rec + 1))->write_clock;
+			break;
+		}
+	}
+
+	UNLOCK_PB;
+
+	return delay;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_count                                             *
+ *                                                                            *
+ * Purpose: gets the number of values not sent to server                      *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_pb_history_count(void)
+{
+	zbx_uint64_t	pos, count = 0;
+
+	if (NULL == pb_header)
+		return 0;
+
+	LOCK_PB;
+
+	for (pos = pb_header->read_pos; pos < pb_header->write_pos; pos += pb_record(pos)->size)
+	{
+		const zbx_pb_record_t	*rec = pb_record(pos);
+
+		if (0 != rec->seq)
+		{
+			count = pb_header->write_seq - rec->seq;
+			break;
+		}
+	}
+
+	UNLOCK_PB;
+
+	return count;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_discard_expired                                               *
+ *                                                                            *
+ * Purpose: moves read position past values older than the maximum age        *
+ *                                                                            *
+ * Comments: Values are discarded in the order they were written, up to the   *
+ *           first value that is not expired.                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_discard_expired(void)
+{
+	zbx_uint64_t	pos;
+	int		min_clock, values_num = 0;
+
+	min_clock = (int)time(NULL) - pb_max_age;
+
+	for (pos = pb_header->read_pos; pos < pb_header->write_pos; pos += pb_record(pos)->size)
+	{
+		const zbx_pb_record_t	*rec = pb_record(pos);
+
+		if (0 == rec->seq)
+			continue;
+
+		if (((const zbx_pb_value_t *)(rec + 1))->clock >= min_clock)
+			break;
+
+		values_num++;
+	}
+
+	if (0 != values_num)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "discarded %d values older than %d hours from proxy history buffer",
+				values_num, pb_max_age / SEC_PER_HOUR);
+		pb_header->read_pos = pos;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_get_source                                        *
+ *                                                                            *
+ * Purpose: selects the source of history to send to server                   *
+ *                                                                            *
+ * Parameters: db_maxid - [OUT] the last database history id to send, 0 - no  *
+ *                              limit                                         *
+ *                                                                            *
+ * Return value: SUCCEED - history must be read from the buffer               *
+ *               FAIL    - history must be read from database                 *
+ *                                                                            *
+ * Comments: Expired values are discarded from the buffer, so this function   *
+ *           must be called only by the buffer reader.                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_get_source(zbx_uint64_t *db_maxid)
+{
+	int	ret = FAIL;
+
+	*db_maxid = 0;
+
+	if (NULL == pb_header)
+		return FAIL;
+
+	LOCK_PB;
+
+	pb_discard_expired();
+
+	if (0 != pb_header->db_pending)
+	{
+		if (pb_header->read_pos < pb_header->db_pos)
+			ret = SUCCEED;
+		else
+			*db_maxid = pb_header->db_maxid;
+	}
+	else if (pb_header->read_pos < pb_header->write_pos)
+		ret = SUCCEED;
+
+	UNLOCK_PB;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_set_db_sent                                       *
+ *                                                                            *
+ * Purpose: marks database history written before switching back to buffer    *
+ *          as sent, so the rest of buffer can be sent                        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_history_set_db_sent(void)
+{
+	if (NULL == pb_header)
+		return;
+
+	LOCK_PB;
+	pb_header->db_pending = 0;
+	UNLOCK_PB;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_check_overflow                                    *
+ *                                                                            *
+ * Purpose: checks if history writing can be switched back to buffer          *
+ *                                                                            *
+ * Parameters: db_batches - [OUT] the number of batches written to database,  *
+ *                                to detect writes after the check            *
+ *                                                                            *
+ * Return value: SUCCEED - the buffer is in overflow mode, there is room for  *
+ *                         the rejected batch and no process is writing to    *
+ *                         database                                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The database history of previous switch must be sent first,      *
+ *           otherwise it would be sent after newer buffer records.           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_check_overflow(zbx_uint64_t *db_batches)
+{
+	int	ret = FAIL;
+
+	if (NULL == pb_header)
+		return FAIL;
+
+	LOCK_PB;
+
+	if (0 != pb_header->overflow && 0 == pb_header->db_writers && 0 == pb_header->db_pending &&
+			pb_header->size - (pb_header->write_pos - pb_header->read_pos) >= pb_header->overflow_size)
+	{
+		*db_batches = pb_header->db_batches;
+		ret = SUCCEED;
+	}
+
+	UNLOCK_PB;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_history_reset_overflow                                    *
+ *                                                                            *
+ * Purpose: switches history writing back to buffer                           *
+ *                                                                            *
+ * Parameters: db_batches - [IN] the number of batches written to database    *
+ *                               returned by zbx_pb_history_check_overflow()  *
+ *             db_maxid   - [IN] the last history id in database              *
+ *                                                                            *
+ * Return value: SUCCEED - history is written to buffer                       *
+ *               FAIL    - values were written to database after the check,   *
+ *                         the last history id might be outdated              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_pb_history_reset_overflow(zbx_uint64_t db_batches, zbx_uint64_t db_maxid)
+{
+	int	ret = FAIL;
+
+	if (NULL == pb_header)
+		return FAIL;
+
+	LOCK_PB;
+
+	if (0 != pb_header->overflow && 0 == pb_header->db_writers && db_batches == pb_header->db_batches)
+	{
+		pb_header->overflow = 0;
+		pb_header->overflow_size = 0;
+		pb_header->db_pos = pb_header->write_pos;
+		pb_header->db_maxid = db_maxid;
+		pb_header->db_pending = (0 != db_maxid ? 1 : 0);
+
+		zabbix_log(LOG_LEVEL_DEBUG, "history is stored in proxy history buffer, database history up to"
+				" id " ZBX_FS_UI64 " is sent first", db_maxid);
+		ret = SUCCEED;
+	}
+
+	UNLOCK_PB;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_get_valueid                                               *
+ *                                                                            *
+ * Purpose: gets the last history value identifier sent to server             *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint64_t	zbx_pb_get_valueid(void)
+{
+	zbx_uint64_t	valueid;
+
+	if (NULL == pb_header)
+		return 0;
+
+	LOCK_PB;
+	valueid = pb_header->valueid;
+	UNLOCK_PB;
+
+	return valueid;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_pb_set_valueid                                               *
+ *                                                                            *
+ * Purpose: stores the last history value identifier sent to server, so       *
+ *          identifiers keep growing across data sender sessions and restarts *
+ *                                                                            *
+ * Parameters: valueid - [IN] the value identifier                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_pb_set_valueid(zbx_uint64_t valueid)
+{
+	if (NULL == pb_header)
+		return;
+
+	LOCK_PB;
+
+	if (valueid > pb_header->valueid)
+		pb_header->valueid = valueid;
+
+	UNLOCK_PB;
+}
+
+#ifdef HAVE_TESTS
+#	include "../../../tests/libs/zbxdbcache/zbx_pb_history_test.c"
+#endif
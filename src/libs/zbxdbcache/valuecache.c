@@ -78,6 +78,7 @@ static int	vc_state = ZBX_VC_DISABLED;
 
 /* the value cache size */
 extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+extern int		CONFIG_VALUE_CACHE_WINDOWS;
 
 ZBX_MEM_FUNC_IMPL(__vc, vc_mem)
 
@@ -93,6 +94,12 @@ ZBX_MEM_FUNC_IMPL(__vc, vc_mem)
 
 #define ZBX_VC_ITEM_EXPIRE_PERIOD	SEC_PER_DAY
 
+/* the maximum number of items prefetched with one history request */
+#define ZBX_VC_PREFETCH_BATCH_SIZE	1000
+
+/* the maximum number of values read by one prefetch history request */
+#define ZBX_VC_PREFETCH_BATCH_VALUES	100000
+
 /* the data chunk used to store data fragment */
 typedef struct zbx_vc_chunk
 {
@@ -124,6 +131,92 @@ zbx_vc_chunk_t;
 #define ZBX_VC_MAX_CHUNK_RECORDS	((64 * ZBX_KIBIBYTE - sizeof(zbx_vc_chunk_t)) / \
 		sizeof(zbx_history_record_t) + 1)
 
+/* the running window states */
+#define ZBX_VC_WINDOW_PENDING		0
+#define ZBX_VC_WINDOW_ACTIVE		1
+#define ZBX_VC_WINDOW_DISABLED		2
+
+/* the number of identical requests after which running window is built */
+#define ZBX_VC_WINDOW_MIN_REQUESTS	2
+
+/* running windows not accessed during this period are removed */
+#define ZBX_VC_WINDOW_EXPIRE_PERIOD	SEC_PER_HOUR
+
+/* the monotonic deque of running window value sequence numbers */
+typedef struct
+{
+	zbx_uint64_t	*seq;
+	int		first;
+	int		num;
+}
+zbx_vc_deque_t;
+
+/* the binary heap of running window value ring indexes */
+typedef struct
+{
+	int	*index;
+	int	num;
+}
+zbx_vc_heap_t;
+
+/* the running summary of aggregate function over a sliding range of item values */
+typedef struct zbx_vc_window
+{
+	struct zbx_vc_window	*next;
+
+	/* the aggregate function (ZBX_VC_AGGREGATE_*) */
+	int			op;
+
+	/* the window range - either time period in seconds or number of values */
+	int			seconds;
+	int			count;
+
+	/* the percentile to calculate */
+	double			percentage;
+
+	/* the window state (ZBX_VC_WINDOW_*) */
+	int			state;
+
+	/* the number of requests while the window is pending */
+	int			requests;
+
+	/* the last time the window was accessed */
+	int			last_accessed;
+
+	/* the window covers values in range (start, end] */
+	zbx_timespec_t		start;
+	zbx_timespec_t		end;
+
+	/* The window values ring buffer. Values are numbered with increasing  */
+	/* sequence numbers, value with sequence number seq is referenced by   */
+	/* values[seq % values_alloc] index. The window always ends with the   */
+	/* newest cached value, so it references item cache slots directly.    */
+	const zbx_history_record_t	**values;
+	int			values_alloc;
+	int			values_num;
+	zbx_uint64_t		first_seq;
+
+	/* the running sum of values with compensation term for floating */
+	/* point sums and the number of values removed since the sum was */
+	/* recalculated                                                  */
+	history_value_t		sum;
+	double			sum_comp;
+	int			removed;
+
+	/* the deques of minimum and maximum value candidates */
+	zbx_vc_deque_t		min;
+	zbx_vc_deque_t		max;
+
+	/* The lower (max) heap holds values up to the percentile rank and the */
+	/* upper (min) heap holds the rest, so the percentile is at the lower  */
+	/* heap top. The heap positions are indexed by value ring index, the   */
+	/* negative positions -(pos + 1) refer to the upper heap.              */
+	zbx_vc_heap_t		lower;
+	zbx_vc_heap_t		upper;
+	int			*heap_pos;
+}
+zbx_vc_window_t;
+
 /* the item operational state flags */
 #define ZBX_ITEM_STATE_CLEAN_PENDING	1
 #define ZBX_ITEM_STATE_REMOVE_PENDING	2
@@ -197,6 +290,9 @@ typedef struct
 
 	/* the first (oldest) chunk of item history data              */
 	zbx_vc_chunk_t	*tail;
+
+	/* the running windows of repeated aggregate requests         */
+	zbx_vc_window_t	*windows;
 }
 zbx_vc_item_t;
 
@@ -254,6 +350,9 @@ static size_t	vch_item_free_cache(zbx_vc_item_t *item);
 static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk);
 static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num);
 static void	vch_item_clean_cache(zbx_vc_item_t *item);
+static void	vch_item_reset_windows(zbx_vc_item_t *item);
+static void	vch_item_update_windows(zbx_vc_item_t *item, const zbx_history_record_t *record);
+static void	vch_item_release_windows(zbx_vc_item_t *item, const zbx_history_record_t *values, int first, int last);
 
 /******************************************************************************
  *                                                                            *
@@ -1191,6 +1290,9 @@ static size_t	vc_item_free_values(zbx_vc_item_t *item, zbx_history_record_t *val
 			break;
 	}
 
+	if (NULL != item->windows)
+		vch_item_release_windows(item, values, first, last);
+
 	item->values_total -= (last - first + 1);
 
 	return freed;
@@ -1839,7 +1941,7 @@ static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
  ******************************************************************************/
 static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_record_t *value)
 {
-	int		ret = FAIL, index, sindex, nslots = 0;
+	int		ret = FAIL, index, sindex, nslots = 0, appended = 0;
 	zbx_vc_chunk_t	*head = item->head, *chunk, *schunk;
 
 	if (NULL != item->head &&
@@ -1901,6 +2003,8 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 	}
 	else
 	{
+		appended = 1;
+
 		/* find the number of free slots on the right side in last (head) chunk */
 		if (NULL != item->head)
 			nslots = item->head->slots_num - item->head->last_value - 1;
@@ -1928,6 +2032,15 @@ static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_rec
 
 	ret = SUCCEED;
 out:
+	/* running windows reference cached values, so they are reset when values are moved */
+	if (NULL != item->windows)
+	{
+		if (0 == appended)
+			vch_item_reset_windows(item);
+		else if (SUCCEED == ret)
+			vch_item_update_windows(item, &chunk->slots[index]);
+	}
+
 	return ret;
 }
 
@@ -2383,186 +2496,1643 @@ out:
 	return ret;
 }
 
+/* the value cache aggregation state */
+typedef struct
+{
+	/* the aggregate function (ZBX_VC_AGGREGATE_*) */
+	int		op;
+
+	/* the item value type */
+	int		value_type;
+
+	/* the number of aggregated values */
+	int		values_num;
+
+	/* the sum of aggregated values */
+	history_value_t	sum;
+
+	/* the minimum and maximum of aggregated values */
+	history_value_t	min;
+	history_value_t	max;
+
+	/* the running average of aggregated values */
+	double		avg;
+
+	/* the percentile to calculate */
+	double		percentage;
+
+	/* the percentile value, calculated either from running window or from collected values */
+	history_value_t	percentile;
+
+	/* the collected values for percentile calculation */
+	history_value_t	*values;
+	int		values_alloc;
+
+	/* the timestamp of the oldest aggregated value */
+	zbx_timespec_t	oldest;
+}
+vc_aggregate_t;
+
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_free_cache                                              *
+ * Function: vc_aggregate_init                                                *
  *                                                                            *
- * Purpose: frees resources allocated for item history data                   *
+ * Purpose: initializes aggregation state                                     *
  *                                                                            *
- * Parameters: item    - [IN] the item                                        *
+ ******************************************************************************/
+static void	vc_aggregate_init(vc_aggregate_t *agg, int op, int value_type)
+{
+	memset(agg, 0, sizeof(vc_aggregate_t));
+	agg->op = op;
+	agg->value_type = value_type;
+}
+
+/******************************************************************************
  *                                                                            *
- * Return value: the size of freed memory (bytes)                             *
+ * Function: vc_aggregate_clear                                               *
+ *                                                                            *
+ * Purpose: frees resources allocated by aggregation state                    *
  *                                                                            *
  ******************************************************************************/
-static size_t	vch_item_free_cache(zbx_vc_item_t *item)
+static void	vc_aggregate_clear(vc_aggregate_t *agg)
 {
-	size_t	freed = 0;
+	zbx_free(agg->values);
+}
 
-	zbx_vc_chunk_t	*chunk = item->tail;
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_aggregate_records                                             *
+ *                                                                            *
+ * Purpose: aggregates history records from last to first index               *
+ *                                                                            *
+ * Parameters: agg     - [IN/OUT] the aggregation state                       *
+ *             records - [IN] the history records                             *
+ *             first   - [IN] the index of the first record to aggregate      *
+ *             last    - [IN] the index of the last record to aggregate       *
+ *                                                                            *
+ * Comments: The records are processed from the newest to the oldest, in the  *
+ *           same order as zbx_vc_get_values() returns them, so floating      *
+ *           point results do not depend on the way values were retrieved.    *
+ *           The loops work directly on cache chunk slots without copying     *
+ *           values.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_aggregate_records(vc_aggregate_t *agg, const zbx_history_record_t *records, int first, int last)
+{
+	int	i, n;
 
-	while (NULL != chunk)
+	if (last < first)
+		return;
+
+	n = agg->values_num;
+
+	switch (agg->op)
 	{
-		zbx_vc_chunk_t	*next = chunk->next;
+		case ZBX_VC_AGGREGATE_SUM:
+			if (ITEM_VALUE_TYPE_FLOAT == agg->value_type)
+			{
+				for (i = last; i >= first; i--)
+					agg->sum.dbl += records[i].value.dbl;
+			}
+			else
+			{
+				for (i = last; i >= first; i--)
+					agg->sum.ui64 += records[i].value.ui64;
+			}
+			break;
+		case ZBX_VC_AGGREGATE_AVG:
+			if (ITEM_VALUE_TYPE_FLOAT == agg->value_type)
+			{
+				for (i = last; i >= first; i--, n++)
+					agg->avg += records[i].value.dbl / (n + 1) - agg->avg / (n + 1);
+			}
+			else
+			{
+				for (i = last; i >= first; i--)
+					agg->avg += records[i].value.ui64;
+			}
+			break;
+		case ZBX_VC_AGGREGATE_MIN:
+		case ZBX_VC_AGGREGATE_MAX:
+		case ZBX_VC_AGGREGATE_DELTA:
+			if (0 == n)
+				agg->min = agg->max = records[last].value;
 
-		freed += vch_item_free_chunk(item, chunk);
-		chunk = next;
+			if (ITEM_VALUE_TYPE_FLOAT == agg->value_type)
+			{
+				for (i = last; i >= first; i--)
+				{
+					if (records[i].value.dbl < agg->min.dbl)
+						agg->min.dbl = records[i].value.dbl;
+					if (records[i].value.dbl > agg->max.dbl)
+						agg->max.dbl = records[i].value.dbl;
+				}
+			}
+			else
+			{
+				for (i = last; i >= first; i--)
+				{
+					if (records[i].value.ui64 < agg->min.ui64)
+						agg->min.ui64 = records[i].value.ui64;
+					if (records[i].value.ui64 > agg->max.ui64)
+						agg->max.ui64 = records[i].value.ui64;
+				}
+			}
+			break;
+		case ZBX_VC_AGGREGATE_PERCENTILE:
+			if (agg->values_alloc < n + last - first + 1)
+			{
+				while (agg->values_alloc < n + last - first + 1)
+					agg->values_alloc = (0 == agg->values_alloc ? 64 : agg->values_alloc * 2);
+
+				agg->values = (history_value_t *)zbx_realloc(agg->values,
+						agg->values_alloc * sizeof(history_value_t));
+			}
+
+			for (i = last; i >= first; i--)
+				agg->values[n++] = records[i].value;
+			break;
 	}
-	item->values_total = 0;
-	item->head = NULL;
-	item->tail = NULL;
 
-	return freed;
+	agg->values_num += last - first + 1;
+	agg->oldest = records[first].timestamp;
 }
 
-/******************************************************************************************************************
- *                                                                                                                *
- * Public API                                                                                                     *
- *                                                                                                                *
- ******************************************************************************************************************/
+static int	vc_history_value_compare_dbl(const void *d1, const void *d2)
+{
+	const history_value_t	*v1 = (const history_value_t *)d1, *v2 = (const history_value_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(v1->dbl, v2->dbl);
+
+	return 0;
+}
+
+static int	vc_history_value_compare_ui64(const void *d1, const void *d2)
+{
+	const history_value_t	*v1 = (const history_value_t *)d1, *v2 = (const history_value_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(v1->ui64, v2->ui64);
+
+	return 0;
+}
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_init                                                      *
+ * Function: vc_history_value_compare                                         *
  *                                                                            *
- * Purpose: initializes value cache                                           *
+ * Purpose: compares two numeric history values                               *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_init(char **error)
+static int	vc_history_value_compare(const history_value_t *v1, const history_value_t *v2, int value_type)
 {
-	zbx_uint64_t	size_reserved;
-	int		ret = FAIL;
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		return vc_history_value_compare_dbl(v1, v2);
 
-	if (0 == CONFIG_VALUE_CACHE_SIZE)
-		return SUCCEED;
+	return vc_history_value_compare_ui64(v1, v2);
+}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_percentile_index                                              *
+ *                                                                            *
+ * Purpose: gets the index of percentile value in sorted values               *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_percentile_index(int values_num, double percentage)
+{
+	if (0 == percentage)
+		return 0;
 
-	if (SUCCEED != zbx_mutex_create(&vc_lock, ZBX_MUTEX_VALUECACHE, error))
-		goto out;
+	return (int)ceil(values_num * (percentage / 100)) - 1;
+}
 
-	size_reserved = zbx_mem_required_size(1, "value cache size", "ValueCacheSize");
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_aggregate_result                                              *
+ *                                                                            *
+ * Purpose: gets the aggregation result                                       *
+ *                                                                            *
+ * Parameters: agg   - [IN] the aggregation state                             *
+ *             value - [OUT] the aggregated value                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_aggregate_result(vc_aggregate_t *agg, history_value_t *value)
+{
+	switch (agg->op)
+	{
+		case ZBX_VC_AGGREGATE_COUNT:
+			value->ui64 = (zbx_uint64_t)agg->values_num;
+			break;
+		case ZBX_VC_AGGREGATE_SUM:
+			*value = agg->sum;
+			break;
+		case ZBX_VC_AGGREGATE_AVG:
+			if (ITEM_VALUE_TYPE_FLOAT == agg->value_type || 0 == agg->values_num)
+				value->dbl = agg->avg;
+			else
+				value->dbl = agg->avg / agg->values_num;
+			break;
+		case ZBX_VC_AGGREGATE_MIN:
+			*value = agg->min;
+			break;
+		case ZBX_VC_AGGREGATE_MAX:
+			*value = agg->max;
+			break;
+		case ZBX_VC_AGGREGATE_DELTA:
+			if (ITEM_VALUE_TYPE_FLOAT == agg->value_type)
+				value->dbl = agg->max.dbl - agg->min.dbl;
+			else
+				value->ui64 = agg->max.ui64 - agg->min.ui64;
+			break;
+		case ZBX_VC_AGGREGATE_PERCENTILE:
+			if (NULL != agg->values && 0 != agg->values_num)
+			{
+				qsort(agg->values, agg->values_num, sizeof(history_value_t),
+						ITEM_VALUE_TYPE_FLOAT == agg->value_type ?
+						vc_history_value_compare_dbl : vc_history_value_compare_ui64);
 
-	if (SUCCEED != zbx_mem_create(&vc_mem, CONFIG_VALUE_CACHE_SIZE, "value cache size", "ValueCacheSize", 1, error))
-		goto out;
+				agg->percentile = agg->values[vc_percentile_index(agg->values_num, agg->percentage)];
+			}
 
-	CONFIG_VALUE_CACHE_SIZE -= size_reserved;
+			*value = agg->percentile;
+			break;
+	}
+}
 
-	vc_cache = (zbx_vc_cache_t *)__vc_mem_malloc_func(vc_cache, sizeof(zbx_vc_cache_t));
+/******************************************************************************************************************
+ *                                                                                                                *
+ * Running window summaries                                                                                       *
+ *                                                                                                                *
+ * When the same aggregate function with the same range is requested repeatedly for an item (a trigger evaluating *
+ * avg(5m) on every new value) the value cache creates a running window for it. The window always covers the      *
+ * newest cached item values, so instead of copying values it references the item cache slots and keeps running   *
+ * sum, monotonic deques for minimum/maximum and a pair of heaps for percentile. New values are added to windows  *
+ * in vch_item_add_value_at_head() and old values are expired as the window moves, so the requests are answered   *
+ * without scanning the item history. Windows are reset when the referenced values are moved or removed from      *
+ * cache.                                                                                                         *
+ *                                                                                                                *
+ ******************************************************************************************************************/
 
-	if (NULL == vc_cache)
-	{
-		*error = zbx_strdup(*error, "cannot allocate value cache header");
-		goto out;
-	}
-	memset(vc_cache, 0, sizeof(zbx_vc_cache_t));
+#define VC_WINDOW_HAS_SUM(op)		(ZBX_VC_AGGREGATE_SUM == (op) || ZBX_VC_AGGREGATE_AVG == (op))
+#define VC_WINDOW_HAS_MIN(op)		(ZBX_VC_AGGREGATE_MIN == (op) || ZBX_VC_AGGREGATE_DELTA == (op))
+#define VC_WINDOW_HAS_MAX(op)		(ZBX_VC_AGGREGATE_MAX == (op) || ZBX_VC_AGGREGATE_DELTA == (op))
+#define VC_WINDOW_HAS_HEAPS(op)		(ZBX_VC_AGGREGATE_PERCENTILE == (op))
 
-	zbx_hashset_create_ext(&vc_cache->items, VC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
+#define VC_WINDOW_VALUE(window, seq)	((window)->values[(seq) % (window)->values_alloc])
 
-	if (NULL == vc_cache->items.slots)
+#define VC_WINDOW_HEAP_VALUE(window, heap, i)	(&(window)->values[(heap)->index[i]]->value)
+
+/* the lower heap is max-heap and the upper heap is min-heap */
+#define VC_WINDOW_HEAP_SIGN(window, heap)	(&(window)->lower == (heap) ? -1 : 1)
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_free_data                                              *
+ *                                                                            *
+ * Purpose: frees running window data and resets its state                    *
+ *                                                                            *
+ * Parameters: window - [IN] the running window                               *
+ *             state  - [IN] the new window state (ZBX_VC_WINDOW_*)           *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vc_window_free_data(zbx_vc_window_t *window, int state)
+{
+	size_t	freed = 0;
+
+	if (NULL != window->values)
 	{
-		*error = zbx_strdup(*error, "cannot allocate value cache data storage");
-		goto out;
+		freed += window->values_alloc * sizeof(zbx_history_record_t *);
+		__vc_mem_free_func(window->values);
 	}
 
-	zbx_hashset_create_ext(&vc_cache->strpool, VC_STRPOOL_INIT_SIZE,
-			vc_strpool_hash_func, vc_strpool_compare_func, NULL,
-			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
+	if (NULL != window->min.seq)
+	{
+		freed += window->values_alloc * sizeof(zbx_uint64_t);
+		__vc_mem_free_func(window->min.seq);
+	}
 
-	if (NULL == vc_cache->strpool.slots)
+	if (NULL != window->max.seq)
 	{
-		*error = zbx_strdup(*error, "cannot allocate string pool for value cache data storage");
-		goto out;
+		freed += window->values_alloc * sizeof(zbx_uint64_t);
+		__vc_mem_free_func(window->max.seq);
 	}
 
-	/* the free space request should be 5% of cache size, but no more than 128KB */
-	vc_cache->min_free_request = (CONFIG_VALUE_CACHE_SIZE / 100) * 5;
-	if (vc_cache->min_free_request > 128 * ZBX_KIBIBYTE)
-		vc_cache->min_free_request = 128 * ZBX_KIBIBYTE;
+	if (NULL != window->heap_pos)
+	{
+		freed += window->values_alloc * sizeof(int) * 3;
+		__vc_mem_free_func(window->lower.index);
+		__vc_mem_free_func(window->upper.index);
+		__vc_mem_free_func(window->heap_pos);
+	}
 
-	ret = SUCCEED;
-out:
-	zbx_vc_disable();
+	memset(&window->start, 0, sizeof(zbx_vc_window_t) - offsetof(zbx_vc_window_t, start));
+	window->state = state;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	if (ZBX_VC_WINDOW_PENDING == state)
+		window->requests = 0;
 
-	return ret;
+	return freed;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_destroy                                                   *
+ * Function: vch_item_free_windows                                            *
  *                                                                            *
- * Purpose: destroys value cache                                              *
+ * Purpose: frees item running windows                                        *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_destroy(void)
+static size_t	vch_item_free_windows(zbx_vc_item_t *item)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	size_t		freed = 0;
+	zbx_vc_window_t	*window;
 
-	if (NULL != vc_cache)
+	while (NULL != (window = item->windows))
 	{
-		zbx_mutex_destroy(&vc_lock);
-
-		zbx_hashset_destroy(&vc_cache->items);
-		zbx_hashset_destroy(&vc_cache->strpool);
-
-		__vc_mem_free_func(vc_cache);
-		vc_cache = NULL;
+		item->windows = window->next;
+		freed += vc_window_free_data(window, ZBX_VC_WINDOW_PENDING) + sizeof(zbx_vc_window_t);
+		__vc_mem_free_func(window);
 	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	return freed;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_reset                                                     *
+ * Function: vch_item_reset_windows                                           *
  *                                                                            *
- * Purpose: resets value cache                                                *
+ * Purpose: resets active item running windows, they will be rebuilt on       *
+ *          subsequent requests                                               *
  *                                                                            *
- * Comments: All items and their historical data are removed,                 *
- *           cache working mode, statistics reset.                            *
+ * Parameters: item - [IN] the item                                           *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_reset(void)
+static void	vch_item_reset_windows(zbx_vc_item_t *item)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zbx_vc_window_t	*window;
 
-	if (NULL != vc_cache)
+	for (window = item->windows; NULL != window; window = window->next)
 	{
-		zbx_vc_item_t		*item;
-		zbx_hashset_iter_t	iter;
-
-		vc_try_lock();
-
-		zbx_hashset_iter_reset(&vc_cache->items, &iter);
-		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
-		{
-			vch_item_free_cache(item);
-			zbx_hashset_iter_remove(&iter);
-		}
-
-		vc_cache->hits = 0;
-		vc_cache->misses = 0;
-		vc_cache->min_free_request = 0;
-		vc_cache->mode = ZBX_VC_MODE_NORMAL;
-		vc_cache->mode_time = 0;
-		vc_cache->last_warning_time = 0;
-
-		vc_try_unlock();
+		if (ZBX_VC_WINDOW_ACTIVE == window->state)
+			vc_window_free_data(window, ZBX_VC_WINDOW_PENDING);
 	}
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_add_values                                                *
+ * Function: vch_item_release_windows                                         *
  *                                                                            *
- * Purpose: adds item values to the history and value cache                   *
+ * Purpose: resets running windows referencing item values that are being     *
+ *          removed from cache                                                *
  *                                                                            *
- * Parameters: history - [IN] item history values                             *
+ * Parameters: item   - [IN] the item                                         *
+ *             values - [IN] the chunk slots                                  *
+ *             first  - [IN] the first removed value                          *
+ *             last   - [IN] the last removed value                           *
+ *                                                                            *
+ * Comments: Values are removed starting with the oldest and windows cover    *
+ *           the newest values, so it is enough to check if the oldest window *
+ *           value is being removed.                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_release_windows(zbx_vc_item_t *item, const zbx_history_record_t *values, int first, int last)
+{
+	zbx_vc_window_t			*window;
+	const zbx_history_record_t	*oldest;
+
+	for (window = item->windows; NULL != window; window = window->next)
+	{
+		if (ZBX_VC_WINDOW_ACTIVE != window->state || 0 == window->values_num)
+			continue;
+
+		oldest = VC_WINDOW_VALUE(window, window->first_seq);
+
+		if (oldest >= &values[first] && oldest <= &values[last])
+			vc_window_free_data(window, ZBX_VC_WINDOW_PENDING);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_ring_index                                             *
+ *                                                                            *
+ * Purpose: converts value ring index to the index in resized ring buffer     *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_window_ring_index(const zbx_vc_window_t *window, int index, int alloc)
+{
+	int		first = (int)(window->first_seq % window->values_alloc);
+	zbx_uint64_t	seq;
+
+	seq = window->first_seq + (index - first + window->values_alloc) % window->values_alloc;
+
+	return (int)(seq % alloc);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_reserve                                                *
+ *                                                                            *
+ * Purpose: ensures that running window has space for the specified number of *
+ *          values                                                            *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             window - [IN] the running window                               *
+ *             num    - [IN] the number of values                             *
+ *                                                                            *
+ * Return value: SUCCEED - the window has enough space                        *
+ *               FAIL    - there was not enough memory                        *
+ *                                                                            *
+ * Comments: The window size is limited only by the number of cached values,  *
+ *           windows are disabled when the value cache runs out of memory.    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_window_reserve(zbx_vc_item_t *item, zbx_vc_window_t *window, int num)
+{
+	int				alloc, i, index;
+	const zbx_history_record_t	**values;
+	zbx_uint64_t			*min_seq = NULL, *max_seq = NULL;
+	int				*lower = NULL, *upper = NULL, *heap_pos = NULL;
+
+	if (num <= window->values_alloc)
+		return SUCCEED;
+
+	for (alloc = MAX(window->values_alloc * 2, 16); alloc < num; alloc *= 2)
+		;
+
+	if (NULL == (values = (const zbx_history_record_t **)vc_item_malloc(item,
+			alloc * sizeof(zbx_history_record_t *))))
+	{
+		return FAIL;
+	}
+
+	if (VC_WINDOW_HAS_MIN(window->op) &&
+			NULL == (min_seq = (zbx_uint64_t *)vc_item_malloc(item, alloc * sizeof(zbx_uint64_t))))
+	{
+		goto fail;
+	}
+
+	if (VC_WINDOW_HAS_MAX(window->op) &&
+			NULL == (max_seq = (zbx_uint64_t *)vc_item_malloc(item, alloc * sizeof(zbx_uint64_t))))
+	{
+		goto fail;
+	}
+
+	if (VC_WINDOW_HAS_HEAPS(window->op) && (
+			NULL == (lower = (int *)vc_item_malloc(item, alloc * sizeof(int))) ||
+			NULL == (upper = (int *)vc_item_malloc(item, alloc * sizeof(int))) ||
+			NULL == (heap_pos = (int *)vc_item_malloc(item, alloc * sizeof(int)))))
+	{
+		goto fail;
+	}
+
+	/* relocate ring buffer value references, deques and heaps to the new buffers */
+
+	for (i = 0; i < window->values_num; i++)
+		values[(window->first_seq + i) % alloc] = VC_WINDOW_VALUE(window, window->first_seq + i);
+
+	if (NULL != min_seq)
+	{
+		for (i = 0; i < window->min.num; i++)
+			min_seq[i] = window->min.seq[(window->min.first + i) % window->values_alloc];
+
+		window->min.first = 0;
+	}
+
+	if (NULL != max_seq)
+	{
+		for (i = 0; i < window->max.num; i++)
+			max_seq[i] = window->max.seq[(window->max.first + i) % window->values_alloc];
+
+		window->max.first = 0;
+	}
+
+	if (NULL != heap_pos)
+	{
+		for (i = 0; i < window->lower.num; i++)
+		{
+			index = vc_window_ring_index(window, window->lower.index[i], alloc);
+			lower[i] = index;
+			heap_pos[index] = i;
+		}
+
+		for (i = 0; i < window->upper.num; i++)
+		{
+			index = vc_window_ring_index(window, window->upper.index[i], alloc);
+			upper[i] = index;
+			heap_pos[index] = -(i + 1);
+		}
+	}
+
+	if (NULL != window->values)
+		__vc_mem_free_func(window->values);
+
+	if (NULL != window->min.seq)
+		__vc_mem_free_func(window->min.seq);
+
+	if (NULL != window->max.seq)
+		__vc_mem_free_func(window->max.seq);
+
+	if (NULL != window->heap_pos)
+	{
+		__vc_mem_free_func(window->lower.index);
+		__vc_mem_free_func(window->upper.index);
+		__vc_mem_free_func(window->heap_pos);
+	}
+
+	window->values = values;
+	window->min.seq = min_seq;
+	window->max.seq = max_seq;
+	window->lower.index = lower;
+	window->upper.index = upper;
+	window->heap_pos = heap_pos;
+	window->values_alloc = alloc;
+
+	return SUCCEED;
+fail:
+	__vc_mem_free_func(values);
+
+	if (NULL != min_seq)
+		__vc_mem_free_func(min_seq);
+
+	if (NULL != max_seq)
+		__vc_mem_free_func(max_seq);
+
+	if (NULL != lower)
+		__vc_mem_free_func(lower);
+
+	if (NULL != upper)
+		__vc_mem_free_func(upper);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_deque_push                                             *
+ *                                                                            *
+ * Purpose: adds value to the back of monotonic deque                         *
+ *                                                                            *
+ * Parameters: window     - [IN] the running window                           *
+ *             deque      - [IN] the deque                                    *
+ *             seq        - [IN] the sequence number of added value           *
+ *             value_type - [IN] the item value type                          *
+ *             sign       - [IN] 1 - for minimum deque, -1 - for maximum      *
+ *                                                                            *
+ * Comments: Values that cannot become minimum (maximum) any more are dropped *
+ *           from the back, so the front of deque always holds the sequence   *
+ *           number of the window minimum (maximum) value.                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_window_deque_push(zbx_vc_window_t *window, zbx_vc_deque_t *deque, zbx_uint64_t seq, int value_type,
+		int sign)
+{
+	const history_value_t	*value = &VC_WINDOW_VALUE(window, seq)->value, *back;
+
+	while (0 != deque->num)
+	{
+		back = &VC_WINDOW_VALUE(window, deque->seq[(deque->first + deque->num - 1) % window->values_alloc])->value;
+
+		if (0 > sign * vc_history_value_compare(back, value, value_type))
+			break;
+
+		deque->num--;
+	}
+
+	deque->seq[(deque->first + deque->num++) % window->values_alloc] = seq;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_deque_pop                                              *
+ *                                                                            *
+ * Purpose: removes expired value from the front of monotonic deque           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_window_deque_pop(zbx_vc_window_t *window, zbx_vc_deque_t *deque, zbx_uint64_t seq)
+{
+	if (0 != deque->num && deque->seq[deque->first] == seq)
+	{
+		deque->first = (deque->first + 1) % window->values_alloc;
+		deque->num--;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_heap_set                                               *
+ *                                                                            *
+ * Purpose: stores value ring index at the specified heap position            *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_window_heap_set(zbx_vc_window_t *window, zbx_vc_heap_t *heap, int i, int index)
+{
+	heap->index[i] = index;
+	window->heap_pos[index] = (&window->lower == heap ? i : -(i + 1));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_heap_up                                                *
+ *                                                                            *
+ * Purpose: moves heap element up until the heap property is restored         *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_window_heap_up(zbx_vc_window_t *window, zbx_vc_heap_t *heap, int i, int value_type)
+{
+	int	index = heap->index[i], parent, sign = VC_WINDOW_HEAP_SIGN(window, heap);
+
+	for (; 0 < i; i = parent)
+	{
+		parent = (i - 1) / 2;
+
+		if (0 <= sign * vc_history_value_compare(&window->values[index]->value,
+				VC_WINDOW_HEAP_VALUE(window, heap, parent), value_type))
+		{
+			break;
+		}
+
+		vc_window_heap_set(window, heap, i, heap->index[parent]);
+	}
+
+	vc_window_heap_set(window, heap, i, index);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_heap_down                                              *
+ *                                                                            *
+ * Purpose: moves heap element down until the heap property is restored       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_window_heap_down(zbx_vc_window_t *window, zbx_vc_heap_t *heap, int i, int value_type)
+{
+	int	index = heap->index[i], child, sign = VC_WINDOW_HEAP_SIGN(window, heap);
+
+	for (; (child = i * 2 + 1) < heap->num; i = child)
+	{
+		if (child + 1 < heap->num && 0 < sign * vc_history_value_compare(VC_WINDOW_HEAP_VALUE(window, heap, child),
+				VC_WINDOW_HEAP_VALUE(window, heap, child + 1), value_type))
+		{
+			child++;
+		}
+
+		if (0 >= sign * vc_history_value_compare(&window->values[index]->value,
+				VC_WINDOW_HEAP_VALUE(window, heap, child), value_type))
+		{
+			break;
+		}
+
+		vc_window_heap_set(window, heap, i, heap->index[child]);
+	}
+
+	vc_window_heap_set(window, heap, i, index);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_heap_push                                              *
+ *                                                                            *
+ * Purpose: adds value ring index to heap                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_window_heap_push(zbx_vc_window_t *window, zbx_vc_heap_t *heap, int index, int value_type)
+{
+	heap->index[heap->num++] = index;
+	vc_window_heap_up(window, heap, heap->num - 1, value_type);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_heap_remove                                            *
+ *                                                                            *
+ * Purpose: removes element at the specified position from heap               *
+ *                                                                            *
+ * Return value: the removed value ring index                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_window_heap_remove(zbx_vc_window_t *window, zbx_vc_heap_t *heap, int i, int value_type)
+{
+	int	index = heap->index[i];
+
+	if (i == --heap->num)
+		return index;
+
+	vc_window_heap_set(window, heap, i, heap->index[heap->num]);
+
+	if (0 < i && 0 > VC_WINDOW_HEAP_SIGN(window, heap) * vc_history_value_compare(
+			VC_WINDOW_HEAP_VALUE(window, heap, i), VC_WINDOW_HEAP_VALUE(window, heap, (i - 1) / 2),
+			value_type))
+	{
+		vc_window_heap_up(window, heap, i, value_type);
+	}
+	else
+		vc_window_heap_down(window, heap, i, value_type);
+
+	return index;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_heaps_balance                                          *
+ *                                                                            *
+ * Purpose: moves values between percentile heaps so the lower heap holds     *
+ *          exactly the values up to the percentile rank                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_window_heaps_balance(zbx_vc_window_t *window, int value_type)
+{
+	int	num = 0;
+
+	if (0 != window->values_num)
+		num = vc_percentile_index(window->values_num, window->percentage) + 1;
+
+	while (window->lower.num > num)
+	{
+		vc_window_heap_push(window, &window->upper, vc_window_heap_remove(window, &window->lower, 0, value_type),
+				value_type);
+	}
+
+	while (window->lower.num < num)
+	{
+		vc_window_heap_push(window, &window->lower, vc_window_heap_remove(window, &window->upper, 0, value_type),
+				value_type);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_sum_add                                                *
+ *                                                                            *
+ * Purpose: adds value to (or subtracts from) the running window sum          *
+ *                                                                            *
+ * Comments: Integer sums of sum() function are calculated exactly. Other     *
+ *           sums are calculated as floating point values using Neumaier      *
+ *           compensated summation to avoid error accumulation when values    *
+ *           are added and removed.                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_window_sum_add(zbx_vc_window_t *window, const history_value_t *value, int value_type, int sign)
+{
+	double	v, t;
+
+	if (ITEM_VALUE_TYPE_UINT64 == value_type && ZBX_VC_AGGREGATE_SUM == window->op)
+	{
+		if (0 < sign)
+			window->sum.ui64 += value->ui64;
+		else
+			window->sum.ui64 -= value->ui64;
+
+		return;
+	}
+
+	v = (ITEM_VALUE_TYPE_FLOAT == value_type ? value->dbl : (double)value->ui64) * sign;
+	t = window->sum.dbl + v;
+
+	if (fabs(window->sum.dbl) >= fabs(v))
+		window->sum_comp += (window->sum.dbl - t) + v;
+	else
+		window->sum_comp += (v - t) + window->sum.dbl;
+
+	window->sum.dbl = t;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_push                                                   *
+ *                                                                            *
+ * Purpose: adds the newest value to running window                           *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             window - [IN] the running window                               *
+ *             record - [IN] the value in item cache slot                     *
+ *                                                                            *
+ * Return value: SUCCEED - the value was added                                *
+ *               FAIL    - there was not enough memory                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_window_push(zbx_vc_item_t *item, zbx_vc_window_t *window, const zbx_history_record_t *record)
+{
+	zbx_uint64_t	seq;
+	int		index;
+
+	if (FAIL == vc_window_reserve(item, window, window->values_num + 1))
+		return FAIL;
+
+	seq = window->first_seq + window->values_num;
+	index = (int)(seq % window->values_alloc);
+	window->values[index] = record;
+
+	if (VC_WINDOW_HAS_SUM(window->op))
+		vc_window_sum_add(window, &record->value, item->value_type, 1);
+
+	if (VC_WINDOW_HAS_MIN(window->op))
+		vc_window_deque_push(window, &window->min, seq, item->value_type, 1);
+
+	if (VC_WINDOW_HAS_MAX(window->op))
+		vc_window_deque_push(window, &window->max, seq, item->value_type, -1);
+
+	window->values_num++;
+	window->end = record->timestamp;
+
+	if (VC_WINDOW_HAS_HEAPS(window->op))
+	{
+		if (0 != window->lower.num && 0 >= vc_history_value_compare(&record->value,
+				VC_WINDOW_HEAP_VALUE(window, &window->lower, 0), item->value_type))
+		{
+			vc_window_heap_push(window, &window->lower, index, item->value_type);
+		}
+		else
+			vc_window_heap_push(window, &window->upper, index, item->value_type);
+
+		vc_window_heaps_balance(window, item->value_type);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_pop                                                    *
+ *                                                                            *
+ * Purpose: removes the oldest value from running window                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_window_pop(zbx_vc_window_t *window, int value_type)
+{
+	const zbx_history_record_t	*record;
+	int				pos, i;
+
+	record = VC_WINDOW_VALUE(window, window->first_seq);
+
+	if (VC_WINDOW_HAS_MIN(window->op))
+		vc_window_deque_pop(window, &window->min, window->first_seq);
+
+	if (VC_WINDOW_HAS_MAX(window->op))
+		vc_window_deque_pop(window, &window->max, window->first_seq);
+
+	if (VC_WINDOW_HAS_HEAPS(window->op))
+	{
+		pos = window->heap_pos[window->first_seq % window->values_alloc];
+
+		if (0 <= pos)
+			vc_window_heap_remove(window, &window->lower, pos, value_type);
+		else
+			vc_window_heap_remove(window, &window->upper, -pos - 1, value_type);
+	}
+
+	window->first_seq++;
+	window->values_num--;
+
+	if (VC_WINDOW_HAS_HEAPS(window->op))
+		vc_window_heaps_balance(window, value_type);
+
+	if (VC_WINDOW_HAS_SUM(window->op))
+	{
+		vc_window_sum_add(window, &record->value, value_type, -1);
+
+		/* recalculate floating point sum once the window has been fully replaced */
+		/* to keep the rounding error bounded, amortized cost is O(1) per value  */
+		if (++window->removed > window->values_num && (ITEM_VALUE_TYPE_FLOAT == value_type ||
+				ZBX_VC_AGGREGATE_AVG == window->op))
+		{
+			memset(&window->sum, 0, sizeof(window->sum));
+			window->sum_comp = 0;
+
+			for (i = 0; i < window->values_num; i++)
+			{
+				vc_window_sum_add(window, &VC_WINDOW_VALUE(window, window->first_seq + i)->value,
+						value_type, 1);
+			}
+
+			window->removed = 0;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_window_expire                                                 *
+ *                                                                            *
+ * Purpose: removes values that are out of running window range               *
+ *                                                                            *
+ * Parameters: window     - [IN] the running window                           *
+ *             value_type - [IN] the item value type                          *
+ *             ts         - [IN] the window end timestamp                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_window_expire(zbx_vc_window_t *window, int value_type, const zbx_timespec_t *ts)
+{
+	if (0 != window->seconds)
+	{
+		zbx_timespec_t	start = {ts->sec - window->seconds, ts->ns};
+
+		if (0 < zbx_timespec_compare(&start, &window->start))
+			window->start = start;
+
+		while (0 != window->values_num &&
+				0 >= zbx_timespec_compare(&VC_WINDOW_VALUE(window, window->first_seq)->timestamp,
+				&window->start))
+		{
+			vc_window_pop(window, value_type);
+		}
+	}
+	else
+	{
+		while (window->values_num > window->count)
+			vc_window_pop(window, value_type);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_update_windows                                          *
+ *                                                                            *
+ * Purpose: updates item running windows with a value appended to cache       *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             record - [IN] the appended value in item cache slot            *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_update_windows(zbx_vc_item_t *item, const zbx_history_record_t *record)
+{
+	zbx_vc_window_t	*window;
+
+	for (window = item->windows; NULL != window; window = window->next)
+	{
+		if (ZBX_VC_WINDOW_ACTIVE != window->state)
+			continue;
+
+		if (0 > zbx_timespec_compare(&record->timestamp, &window->end))
+		{
+			vc_window_free_data(window, ZBX_VC_WINDOW_PENDING);
+			continue;
+		}
+
+		if (FAIL == vc_window_push(item, window, record))
+		{
+			vc_window_free_data(window, ZBX_VC_WINDOW_DISABLED);
+			continue;
+		}
+
+		vc_window_expire(window, item->value_type, &record->timestamp);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_build_window                                            *
+ *                                                                            *
+ * Purpose: fills running window with cached values                           *
+ *                                                                            *
+ * Parameters: item   - [IN] the item                                         *
+ *             window - [IN] the running window                               *
+ *             ts     - [IN] the request end timestamp                        *
+ *                                                                            *
+ * Return value: SUCCEED - the window was built                               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The cache must contain all values of the requested range and     *
+ *           there must be no cached values newer than the request end.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_build_window(zbx_vc_item_t *item, zbx_vc_window_t *window, const zbx_timespec_t *ts)
+{
+	zbx_vc_chunk_t	*chunk;
+	int		index, num = 0;
+	zbx_timespec_t	start = {0, 0};
+
+	if (0 != window->seconds)
+	{
+		start.sec = ts->sec - window->seconds;
+		start.ns = ts->ns;
+	}
+
+	window->start = start;
+
+	if (NULL == (chunk = item->head))
+		goto out;
+
+	/* find the oldest value in window range */
+	for (index = chunk->last_value;; index--)
+	{
+		if (index < chunk->first_value)
+		{
+			if (NULL == chunk->prev)
+				break;
+
+			chunk = chunk->prev;
+			index = chunk->last_value;
+		}
+
+		if (0 >= zbx_timespec_compare(&chunk->slots[index].timestamp, &start) ||
+				(0 != window->count && num == window->count))
+		{
+			break;
+		}
+
+		num++;
+	}
+
+	if (FAIL == vc_window_reserve(item, window, num))
+		return FAIL;
+
+	/* move to the oldest value in range and add values to the window */
+	for (; 0 < num; num--)
+	{
+		if (++index > chunk->last_value)
+		{
+			chunk = chunk->next;
+			index = chunk->first_value;
+		}
+
+		if (FAIL == vc_window_push(item, window, &chunk->slots[index]))
+			return FAIL;
+	}
+
+	window->end = item->head->slots[item->head->last_value].timestamp;
+out:
+	window->state = ZBX_VC_WINDOW_ACTIVE;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_window                                              *
+ *                                                                            *
+ * Purpose: finds running window matching the request, creating pending      *
+ *          window if necessary                                               *
+ *                                                                            *
+ * Parameters: item       - [IN] the item                                     *
+ *             op         - [IN] the aggregate function (ZBX_VC_AGGREGATE_*)  *
+ *             seconds    - [IN] the time period                              *
+ *             count      - [IN] the number of values                         *
+ *             percentage - [IN] the percentile to calculate                  *
+ *             now        - [IN] the current time                             *
+ *                                                                            *
+ * Return value: the running window or NULL if it cannot be created          *
+ *                                                                            *
+ * Comments: Windows not accessed during ZBX_VC_WINDOW_EXPIRE_PERIOD are      *
+ *           removed. The number of windows per item is limited by            *
+ *           ValueCacheWindows configuration parameter.                       *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vc_window_t	*vch_item_get_window(zbx_vc_item_t *item, int op, int seconds, int count,
+		double percentage, int now)
+{
+	zbx_vc_window_t	*window, *found = NULL, **pnext = &item->windows;
+	int		windows_num = 0;
+
+	while (NULL != (window = *pnext))
+	{
+		if (window->op == op && window->seconds == seconds && window->count == count &&
+				window->percentage == percentage)
+		{
+			found = window;
+		}
+		else if (window->last_accessed < now - ZBX_VC_WINDOW_EXPIRE_PERIOD)
+		{
+			*pnext = window->next;
+			vc_window_free_data(window, ZBX_VC_WINDOW_PENDING);
+			__vc_mem_free_func(window);
+			continue;
+		}
+
+		windows_num++;
+		pnext = &window->next;
+	}
+
+	if (NULL == found && CONFIG_VALUE_CACHE_WINDOWS > windows_num && ZBX_VC_MODE_NORMAL == vc_cache->mode)
+	{
+		if (NULL == (found = (zbx_vc_window_t *)vc_item_malloc(item, sizeof(zbx_vc_window_t))))
+			return NULL;
+
+		memset(found, 0, sizeof(zbx_vc_window_t));
+		found->op = op;
+		found->seconds = seconds;
+		found->count = count;
+		found->percentage = percentage;
+		found->state = ZBX_VC_WINDOW_PENDING;
+		found->next = item->windows;
+		item->windows = found;
+	}
+
+	return found;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_window_aggregate                                        *
+ *                                                                            *
+ * Purpose: aggregates item values using running window                       *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             agg     - [IN/OUT] the aggregation state                       *
+ *             seconds - [IN] the time period to aggregate data for           *
+ *             count   - [IN] the number of history values to aggregate       *
+ *             ts      - [IN] the target timestamp                            *
+ *                                                                            *
+ * Return value: SUCCEED - the values were aggregated using running window    *
+ *               FAIL    - running window cannot be used for this request     *
+ *                                                                            *
+ * Comments: Running windows are used for numeric items only and for either  *
+ *           time or count based ranges, not both. A window can serve         *
+ *           requests ending at or after its newest value, so windows are     *
+ *           effective for triggers evaluated on new values and by timer.     *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_window_aggregate(zbx_vc_item_t *item, vc_aggregate_t *agg, int seconds, int count,
+		const zbx_timespec_t *ts)
+{
+	zbx_vc_window_t	*window;
+	zbx_timespec_t	start;
+
+	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
+		return FAIL;
+
+	if ((0 == seconds) == (0 == count))
+		return FAIL;
+
+	if (NULL == (window = vch_item_get_window(item, agg->op, seconds, count, agg->percentage, time(NULL))))
+		return FAIL;
+
+	window->last_accessed = time(NULL);
+
+	if (ZBX_VC_WINDOW_PENDING == window->state)
+	{
+		if (ZBX_VC_WINDOW_MIN_REQUESTS > ++window->requests)
+			return FAIL;
+
+		if (NULL != item->head &&
+				0 < zbx_timespec_compare(&item->head->slots[item->head->last_value].timestamp, ts))
+		{
+			return FAIL;
+		}
+
+		if (FAIL == vch_item_build_window(item, window, ts))
+		{
+			vc_window_free_data(window, ZBX_VC_WINDOW_DISABLED);
+			return FAIL;
+		}
+	}
+
+	if (ZBX_VC_WINDOW_ACTIVE != window->state || 0 > zbx_timespec_compare(ts, &window->end))
+		return FAIL;
+
+	if (0 != seconds)
+	{
+		start.sec = ts->sec - seconds;
+		start.ns = ts->ns;
+
+		/* the window does not contain values older than its start */
+		if (0 > zbx_timespec_compare(&start, &window->start))
+			return FAIL;
+
+		vc_window_expire(window, item->value_type, ts);
+	}
+
+	agg->values_num = window->values_num;
+
+	if (0 == window->values_num)
+		return SUCCEED;
+
+	agg->oldest = VC_WINDOW_VALUE(window, window->first_seq)->timestamp;
+
+	switch (agg->op)
+	{
+		case ZBX_VC_AGGREGATE_SUM:
+			if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+				agg->sum.dbl = window->sum.dbl + window->sum_comp;
+			else
+				agg->sum.ui64 = window->sum.ui64;
+			break;
+		case ZBX_VC_AGGREGATE_AVG:
+			agg->avg = window->sum.dbl + window->sum_comp;
+
+			if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
+				agg->avg /= window->values_num;
+			break;
+		case ZBX_VC_AGGREGATE_MIN:
+		case ZBX_VC_AGGREGATE_MAX:
+		case ZBX_VC_AGGREGATE_DELTA:
+			if (VC_WINDOW_HAS_MIN(agg->op))
+				agg->min = VC_WINDOW_VALUE(window, window->min.seq[window->min.first])->value;
+
+			if (VC_WINDOW_HAS_MAX(agg->op))
+				agg->max = VC_WINDOW_VALUE(window, window->max.seq[window->max.first])->value;
+			break;
+		case ZBX_VC_AGGREGATE_PERCENTILE:
+			agg->percentile = *VC_WINDOW_HEAP_VALUE(window, &window->lower, 0);
+			break;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_update_request_range                                    *
+ *                                                                            *
+ * Purpose: updates item range with time based request range                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_update_request_range(zbx_vc_item_t *item, int seconds, const zbx_timespec_t *ts)
+{
+	int	now;
+
+	/* Check if maximum request range is not set and all data are cached.  */
+	/* Because that indicates there was a count based request with unknown */
+	/* range which might be greater than the current request range.        */
+	if (0 != item->active_range || ZBX_ITEM_STATUS_CACHED_ALL != item->status)
+	{
+		now = time(NULL);
+		/* add another second to include nanosecond shifts */
+		vch_item_update_range(item, seconds + now - ts->sec + 1, now);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_update_aggregate_range                                  *
+ *                                                                            *
+ * Purpose: updates item range after count based aggregation                  *
+ *                                                                            *
+ * Comments: The range is updated in the same way as                          *
+ *           vch_item_get_values_by_time_and_count() does.                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_update_aggregate_range(zbx_vc_item_t *item, const vc_aggregate_t *agg, int seconds,
+		int count, const zbx_timespec_t *ts)
+{
+	int	now, range_timestamp;
+
+	if (count > agg->values_num)
+	{
+		if (0 == seconds)
+		{
+			/* not enough data in db to fulfill a count based request request */
+			item->active_range = 0;
+			item->daily_range = 0;
+			item->status = ZBX_ITEM_STATUS_CACHED_ALL;
+			return;
+		}
+		/* not enough data in the requested period, set the range equal to the period plus */
+		/* one second to include nanosecond shifts                                         */
+		range_timestamp = ts->sec - seconds;
+	}
+	else
+	{
+		/* the requested number of values was aggregated, set the range to the oldest value timestamp */
+		range_timestamp = agg->oldest.sec - 1;
+	}
+
+	now = time(NULL);
+	vch_item_update_range(item, now - range_timestamp, now);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_aggregate_values_by_time                                *
+ *                                                                            *
+ * Purpose: aggregates cached item history data                               *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             agg     - [IN/OUT] the aggregation state                       *
+ *             seconds - [IN] the time period to aggregate data for           *
+ *             ts      - [IN] the requested period end timestamp              *
+ *                                                                            *
+ * Comments: This function walks cache chunks in the same way as              *
+ *           vch_item_get_values_by_time() does.                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_aggregate_values_by_time(zbx_vc_item_t *item, vc_aggregate_t *agg, int seconds,
+		const zbx_timespec_t *ts)
+{
+	int		index, first;
+	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
+	zbx_vc_chunk_t	*chunk;
+
+	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
+		return;
+
+	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
+	{
+		for (first = index; first >= chunk->first_value &&
+				0 < zbx_timespec_compare(&chunk->slots[first].timestamp, &start); first--)
+			;
+
+		vc_aggregate_records(agg, chunk->slots, first + 1, index);
+
+		if (first >= chunk->first_value || NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_aggregate_values_by_time_and_count                      *
+ *                                                                            *
+ * Purpose: aggregates cached item history data                               *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             agg     - [IN/OUT] the aggregation state                       *
+ *             seconds - [IN] the time period                                 *
+ *             count   - [IN] the number of history values to aggregate       *
+ *             ts      - [IN] the target timestamp                            *
+ *                                                                            *
+ * Comments: This function walks cache chunks in the same way as              *
+ *           vch_item_get_values_by_time_and_count() does.                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_aggregate_values_by_time_and_count(zbx_vc_item_t *item, vc_aggregate_t *agg, int seconds,
+		int count, const zbx_timespec_t *ts)
+{
+	int		index, first;
+	zbx_vc_chunk_t	*chunk;
+	zbx_timespec_t	start;
+
+	if (0 != seconds)
+	{
+		start.sec = ts->sec - seconds;
+		start.ns = ts->ns;
+	}
+	else
+	{
+		start.sec = 0;
+		start.ns = 0;
+	}
+
+	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
+		return;
+
+	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
+	{
+		for (first = index; first >= chunk->first_value && index - first < count - agg->values_num &&
+				0 < zbx_timespec_compare(&chunk->slots[first].timestamp, &start); first--)
+			;
+
+		vc_aggregate_records(agg, chunk->slots, first + 1, index);
+
+		if (agg->values_num == count || first >= chunk->first_value || NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_aggregate_values                                        *
+ *                                                                            *
+ * Purpose: aggregates item values for the specified range                    *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             agg     - [IN/OUT] the aggregation state                       *
+ *             seconds - [IN] the time period to aggregate data for           *
+ *             count   - [IN] the number of history values to aggregate       *
+ *             ts      - [IN] the target timestamp                            *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was aggregated successfully *
+ *                FAIL    - the item history data was not cached              *
+ *                                                                            *
+ * Comments: This function works like vch_item_get_values(), but aggregates   *
+ *           cached values in place instead of copying them. Repeated         *
+ *           requests are served from running windows.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_aggregate_values(zbx_vc_item_t *item, vc_aggregate_t *agg, int seconds, int count,
+		const zbx_timespec_t *ts)
+{
+	int	ret, records_read, range_start;
+
+	if (0 == count)
+	{
+		if (0 > (range_start = ts->sec - seconds))
+			range_start = 0;
+
+		if (FAIL == (ret = vch_item_cache_values_by_time(item, range_start)))
+			return FAIL;
+
+		records_read = ret;
+
+		vch_item_update_request_range(item, seconds, ts);
+
+		if (FAIL == vch_item_window_aggregate(item, agg, seconds, count, ts))
+			vch_item_aggregate_values_by_time(item, agg, seconds, ts);
+	}
+	else
+	{
+		range_start = (0 == seconds ? 0 : ts->sec - seconds);
+
+		if (FAIL == (ret = vch_item_cache_values_by_time_and_count(item, range_start, count, ts)))
+			return FAIL;
+
+		records_read = ret;
+
+		if (FAIL == vch_item_window_aggregate(item, agg, seconds, count, ts))
+			vch_item_aggregate_values_by_time_and_count(item, agg, seconds, count, ts);
+
+		vch_item_update_aggregate_range(item, agg, seconds, count, ts);
+	}
+
+	if (records_read > agg->values_num)
+		records_read = agg->values_num;
+
+	vc_update_statistics(item, agg->values_num - records_read, records_read);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_free_cache                                              *
+ *                                                                            *
+ * Purpose: frees resources allocated for item history data                   *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_cache(zbx_vc_item_t *item)
+{
+	size_t	freed = 0;
+
+	zbx_vc_chunk_t	*chunk = item->tail;
+
+	freed += vch_item_free_windows(item);
+
+	while (NULL != chunk)
+	{
+		zbx_vc_chunk_t	*next = chunk->next;
+
+		freed += vch_item_free_chunk(item, chunk);
+		chunk = next;
+	}
+	item->values_total = 0;
+	item->head = NULL;
+	item->tail = NULL;
+
+	return freed;
+}
+
+/******************************************************************************************************************
+ *                                                                                                                *
+ * Public API                                                                                                     *
+ *                                                                                                                *
+ ******************************************************************************************************************/
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_init                                                      *
+ *                                                                            *
+ * Purpose: initializes value cache                                           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_init(char **error)
+{
+	zbx_uint64_t	size_reserved;
+	int		ret = FAIL;
+
+	if (0 == CONFIG_VALUE_CACHE_SIZE)
+		return SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (SUCCEED != zbx_mutex_create(&vc_lock, ZBX_MUTEX_VALUECACHE, error))
+		goto out;
+
+	size_reserved = zbx_mem_required_size(1, "value cache size", "ValueCacheSize");
+
+	if (SUCCEED != zbx_mem_create(&vc_mem, CONFIG_VALUE_CACHE_SIZE, "value cache size", "ValueCacheSize", 1, error))
+		goto out;
+
+	CONFIG_VALUE_CACHE_SIZE -= size_reserved;
+
+	vc_cache = (zbx_vc_cache_t *)__vc_mem_malloc_func(vc_cache, sizeof(zbx_vc_cache_t));
+
+	if (NULL == vc_cache)
+	{
+		*error = zbx_strdup(*error, "cannot allocate value cache header");
+		goto out;
+	}
+	memset(vc_cache, 0, sizeof(zbx_vc_cache_t));
+
+	zbx_hashset_create_ext(&vc_cache->items, VC_ITEMS_INIT_SIZE,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
+
+	if (NULL == vc_cache->items.slots)
+	{
+		*error = zbx_strdup(*error, "cannot allocate value cache data storage");
+		goto out;
+	}
+
+	zbx_hashset_create_ext(&vc_cache->strpool, VC_STRPOOL_INIT_SIZE,
+			vc_strpool_hash_func, vc_strpool_compare_func, NULL,
+			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
+
+	if (NULL == vc_cache->strpool.slots)
+	{
+		*error = zbx_strdup(*error, "cannot allocate string pool for value cache data storage");
+		goto out;
+	}
+
+	/* the free space request should be 5% of cache size, but no more than 128KB */
+	vc_cache->min_free_request = (CONFIG_VALUE_CACHE_SIZE / 100) * 5;
+	if (vc_cache->min_free_request > 128 * ZBX_KIBIBYTE)
+		vc_cache->min_free_request = 128 * ZBX_KIBIBYTE;
+
+	ret = SUCCEED;
+out:
+	zbx_vc_disable();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_destroy                                                   *
+ *                                                                            *
+ * Purpose: destroys value cache                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_destroy(void)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != vc_cache)
+	{
+		zbx_mutex_destroy(&vc_lock);
+
+		zbx_hashset_destroy(&vc_cache->items);
+		zbx_hashset_destroy(&vc_cache->strpool);
+
+		__vc_mem_free_func(vc_cache);
+		vc_cache = NULL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_reset                                                     *
+ *                                                                            *
+ * Purpose: resets value cache                                                *
+ *                                                                            *
+ * Comments: All items and their historical data are removed,                 *
+ *           cache working mode, statistics reset.                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_reset(void)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (NULL != vc_cache)
+	{
+		zbx_vc_item_t		*item;
+		zbx_hashset_iter_t	iter;
+
+		vc_try_lock();
+
+		zbx_hashset_iter_reset(&vc_cache->items, &iter);
+		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			vch_item_free_cache(item);
+			zbx_hashset_iter_remove(&iter);
+		}
+
+		vc_cache->hits = 0;
+		vc_cache->misses = 0;
+		vc_cache->min_free_request = 0;
+		vc_cache->mode = ZBX_VC_MODE_NORMAL;
+		vc_cache->mode_time = 0;
+		vc_cache->last_warning_time = 0;
+
+		vc_try_unlock();
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_add_values                                                *
+ *                                                                            *
+ * Purpose: adds item values to the history and value cache                   *
+ *                                                                            *
+ * Parameters: history - [IN] item history values                             *
  *                                                                            *
  * Return value: SUCCEED - the values were added successfully                 *
  *               FAIL    - otherwise                                          *
@@ -2689,23 +4259,241 @@ out:
 
 		cache_used = 0;
 
-		vc_try_unlock();
+		vc_try_unlock();
+
+		ret = vc_db_get_values(itemid, value_type, values, seconds, count, ts);
+
+		vc_try_lock();
+
+		if (SUCCEED == ret)
+			vc_update_statistics(NULL, 0, values->values_num);
+	}
+
+	if (NULL != item)
+		vc_item_release(item);
+
+	vc_try_unlock();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
+			__func__, zbx_result_string(ret), values->values_num, cache_used);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_aggregate_item_values                                         *
+ *                                                                            *
+ * Purpose: aggregates item history data from cache or database               *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             agg        - [IN/OUT] the aggregation state                    *
+ *             seconds    - [IN] the time period to aggregate data for        *
+ *             count      - [IN] the number of history values to aggregate    *
+ *             ts         - [IN] the period end timestamp                     *
+ *             cache_used - [OUT] 1 - the values were aggregated in cache,    *
+ *                                0 - the values were read from database      *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was aggregated successfully *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_aggregate_item_values(zbx_uint64_t itemid, vc_aggregate_t *agg, int seconds, int count,
+		const zbx_timespec_t *ts, int *cache_used)
+{
+	zbx_vc_item_t	*item = NULL;
+	int		ret = FAIL;
+
+	*cache_used = 1;
+
+	vc_try_lock();
+
+	if (ZBX_VC_DISABLED == vc_state)
+		goto out;
+
+	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+		vc_warn_low_memory();
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
+	{
+		if (ZBX_VC_MODE_NORMAL == vc_cache->mode)
+		{
+			zbx_vc_item_t   new_item = {.itemid = itemid, .value_type = agg->value_type};
+
+			if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(zbx_vc_item_t))))
+				goto out;
+		}
+		else
+			goto out;
+	}
+
+	vc_item_addref(item);
+
+	if (0 != (item->state & ZBX_ITEM_STATE_REMOVE_PENDING) || item->value_type != agg->value_type)
+		goto out;
+
+	ret = vch_item_aggregate_values(item, agg, seconds, count, ts);
+out:
+	if (FAIL == ret)
+	{
+		zbx_vector_history_record_t	values;
+		int				i;
+
+		if (NULL != item)
+			item->state |= ZBX_ITEM_STATE_REMOVE_PENDING;
+
+		*cache_used = 0;
+
+		vc_try_unlock();
+
+		zbx_history_record_vector_create(&values);
+
+		/* the values are returned in descending order, aggregate them one by one to keep the order */
+		if (SUCCEED == (ret = vc_db_get_values(itemid, agg->value_type, &values, seconds, count, ts)))
+		{
+			for (i = 0; i < values.values_num; i++)
+				vc_aggregate_records(agg, values.values, i, i);
+		}
+
+		zbx_history_record_vector_destroy(&values, agg->value_type);
+
+		vc_try_lock();
+
+		if (SUCCEED == ret)
+			vc_update_statistics(NULL, 0, agg->values_num);
+	}
+
+	if (NULL != item)
+		vc_item_release(item);
+
+	vc_try_unlock();
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_aggregate                                                 *
+ *                                                                            *
+ * Purpose: aggregates item history data for the specified time period        *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             op         - [IN] the aggregate function (ZBX_VC_AGGREGATE_*)  *
+ *             seconds    - [IN] the time period to aggregate data for        *
+ *             count      - [IN] the number of history values to aggregate    *
+ *             ts         - [IN] the period end timestamp                     *
+ *             value      - [OUT] the aggregated value, see comments          *
+ *             values_num - [OUT] the number of aggregated values             *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was aggregated successfully *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: Cached values are aggregated in place while holding the cache    *
+ *           lock, without copying them into a vector. Values are read from   *
+ *           database only if they are not cached.                            *
+ *                                                                            *
+ *           The request range is defined in the same way as for              *
+ *           zbx_vc_get_values() function.                                    *
+ *                                                                            *
+ *           When the same numeric aggregate is requested repeatedly the      *
+ *           running window summary is maintained for the request range and  *
+ *           following requests are calculated without scanning history.     *
+ *           In this case floating point sums are calculated with             *
+ *           compensated summation and might differ in the least significant  *
+ *           digits from sums calculated by scanning values.                  *
+ *                                                                            *
+ *           The aggregated value type depends on function:                   *
+ *             COUNT           - ui64, can be used with any value type        *
+ *             AVG             - dbl                                          *
+ *             SUM, MIN, MAX,                                                 *
+ *             DELTA           - item value type (dbl or ui64)                *
+ *           MIN, MAX, AVG and DELTA results are undefined if no values were  *
+ *           aggregated.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_aggregate(zbx_uint64_t itemid, int value_type, int op, int seconds, int count,
+		const zbx_timespec_t *ts, history_value_t *value, int *values_num)
+{
+	int		ret, cache_used;
+	vc_aggregate_t	agg;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d op:%d seconds:%d count:%d"
+			" sec:%d ns:%d", __func__, itemid, value_type, op, seconds, count, ts->sec, ts->ns);
+
+	if ((ZBX_VC_AGGREGATE_COUNT != op && ITEM_VALUE_TYPE_FLOAT != value_type &&
+			ITEM_VALUE_TYPE_UINT64 != value_type) || ZBX_VC_AGGREGATE_PERCENTILE == op)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		*values_num = 0;
+		return FAIL;
+	}
+
+	vc_aggregate_init(&agg, op, value_type);
+
+	ret = vc_aggregate_item_values(itemid, &agg, seconds, count, ts, &cache_used);
+
+	vc_aggregate_result(&agg, value);
+	*values_num = agg.values_num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
+			__func__, zbx_result_string(ret), agg.values_num, cache_used);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_get_percentile                                            *
+ *                                                                            *
+ * Purpose: calculates percentile of item history data for the specified      *
+ *          time period                                                       *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             seconds    - [IN] the time period                              *
+ *             count      - [IN] the number of history values                 *
+ *             ts         - [IN] the period end timestamp                     *
+ *             percentage - [IN] the percentage (0-100)                       *
+ *             value      - [OUT] the percentile value                        *
+ *             values_num - [OUT] the number of values in range               *
+ *                                                                            *
+ * Return value:  SUCCEED - the percentile was calculated successfully        *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: The percentile is calculated using nearest rank method. The      *
+ *           result is undefined if there are no values in range.            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_get_percentile(zbx_uint64_t itemid, int value_type, int seconds, int count, const zbx_timespec_t *ts,
+		double percentage, history_value_t *value, int *values_num)
+{
+	int		ret, cache_used;
+	vc_aggregate_t	agg;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d seconds:%d count:%d"
+			" sec:%d ns:%d percentage:" ZBX_FS_DBL, __func__, itemid, value_type, seconds, count, ts->sec,
+			ts->ns, percentage);
 
-		ret = vc_db_get_values(itemid, value_type, values, seconds, count, ts);
+	if (ITEM_VALUE_TYPE_FLOAT != value_type && ITEM_VALUE_TYPE_UINT64 != value_type)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		*values_num = 0;
+		return FAIL;
+	}
 
-		vc_try_lock();
+	vc_aggregate_init(&agg, ZBX_VC_AGGREGATE_PERCENTILE, value_type);
+	agg.percentage = percentage;
 
-		if (SUCCEED == ret)
-			vc_update_statistics(NULL, 0, values->values_num);
-	}
+	ret = vc_aggregate_item_values(itemid, &agg, seconds, count, ts, &cache_used);
 
-	if (NULL != item)
-		vc_item_release(item);
+	vc_aggregate_result(&agg, value);
+	*values_num = agg.values_num;
 
-	vc_try_unlock();
+	vc_aggregate_clear(&agg);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
-			__func__, zbx_result_string(ret), values->values_num, cache_used);
+			__func__, zbx_result_string(ret), agg.values_num, cache_used);
 
 	return ret;
 }
@@ -2928,6 +4716,474 @@ void	zbx_vc_get_item_stats(zbx_vector_ptr_t *stats)
 	vc_try_unlock();
 }
 
+ZBX_VECTOR_IMPL(vc_prefetch_item, zbx_vc_prefetch_item_t)
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_get_working_set                                               *
+ *                                                                            *
+ * Purpose: gets the value cache working set                                  *
+ *                                                                            *
+ * Parameters: items - [OUT] the items accessed during the item expire period *
+ *             now   - [IN] the current timestamp                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_get_working_set(zbx_vector_vc_prefetch_item_t *items, int now)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_vc_item_t		*item;
+	zbx_vc_prefetch_item_t	pitem;
+	int			expire_timestamp;
+
+	expire_timestamp = now - ZBX_VC_ITEM_EXPIRE_PERIOD;
+
+	vc_try_lock();
+
+	zbx_vector_vc_prefetch_item_reserve(items, vc_cache->items.num_data);
+
+	zbx_hashset_iter_reset(&vc_cache->items, &iter);
+	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (item->last_accessed < expire_timestamp || 0 != (item->state & ZBX_ITEM_STATE_REMOVE_PENDING))
+			continue;
+
+		pitem.itemid = item->itemid;
+		pitem.value_type = item->value_type;
+		pitem.range = MAX(item->active_range, item->daily_range);
+		pitem.values_num = item->values_total;
+		zbx_vector_vc_prefetch_item_append_ptr(items, &pitem);
+	}
+
+	vc_try_unlock();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_dump_working_set                                          *
+ *                                                                            *
+ * Purpose: writes the value cache working set into file                      *
+ *                                                                            *
+ * Parameters: path - [IN] the working set file path                          *
+ *                                                                            *
+ * Comments: Items accessed during the item expire period are written as      *
+ *           '<itemid> <value type> <active range> <cached values>' lines, so *
+ *           the cache could be prefetched with zbx_vc_prefetch_working_set() *
+ *           after restart.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_dump_working_set(const char *path)
+{
+	zbx_vector_vc_prefetch_item_t	items;
+	zbx_vc_prefetch_item_t		*pitem;
+	char				*path_tmp;
+	FILE				*f;
+	int				i;
+
+	if (NULL == path || '\0' == *path || ZBX_VC_DISABLED == vc_state)
+		return;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() path:%s", __func__, path);
+
+	zbx_vector_vc_prefetch_item_create(&items);
+	path_tmp = zbx_dsprintf(NULL, "%s.tmp", path);
+
+	if (NULL == (f = fopen(path_tmp, "w")))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open value cache working set file \"%s\": %s", path_tmp,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	vc_get_working_set(&items, time(NULL));
+
+	for (i = 0; i < items.values_num; i++)
+	{
+		pitem = &items.values[i];
+		fprintf(f, ZBX_FS_UI64 " %d %d %d\n", pitem->itemid, pitem->value_type, pitem->range,
+				pitem->values_num);
+	}
+
+	if (0 != fclose(f) || 0 != rename(path_tmp, path))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write value cache working set file \"%s\": %s", path,
+				zbx_strerror(errno));
+		unlink(path_tmp);
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "saved value cache working set of %d items", items.values_num);
+out:
+	zbx_free(path_tmp);
+	zbx_vector_vc_prefetch_item_destroy(&items);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+static int	vc_prefetch_item_compare(const void *d1, const void *d2)
+{
+	const zbx_vc_prefetch_item_t	*i1 = (const zbx_vc_prefetch_item_t *)d1;
+	const zbx_vc_prefetch_item_t	*i2 = (const zbx_vc_prefetch_item_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->value_type, i2->value_type);
+	ZBX_RETURN_IF_NOT_EQUAL(i1->range, i2->range);
+
+	return 0;
+}
+
+static void	vc_history_item_values_clean(void *data)
+{
+	zbx_history_item_values_t	*item = (zbx_history_item_values_t *)data;
+
+	zbx_vector_history_record_destroy(&item->values);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_prefetch_items                                                *
+ *                                                                            *
+ * Purpose: caches history of items with the same value type                  *
+ *                                                                            *
+ * Parameters: items      - [IN] the items, sorted by range                   *
+ *             first      - [IN] the first item to cache                      *
+ *             last       - [IN] the last item to cache                       *
+ *             now        - [IN] the current timestamp                        *
+ *             items_num  - [IN/OUT] the number of cached items               *
+ *             values_num - [IN/OUT] the number of cached values              *
+ *                                                                            *
+ * Return value: SUCCEED - the items were processed                           *
+ *               FAIL    - the items have more than                           *
+ *                         ZBX_VC_PREFETCH_BATCH_VALUES values in range,      *
+ *                         nothing was cached                                 *
+ *                                                                            *
+ * Comments: Only items not yet cached are prefetched. Their values are read  *
+ *           from history storage with a single request and added to cache    *
+ *           the same way as by time based requests.                          *
+ *           The items are left for on demand requests if history storage     *
+ *           cannot be read.                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_prefetch_items(const zbx_vector_vc_prefetch_item_t *items, int first, int last, int now,
+		int *items_num, int *values_num)
+{
+	zbx_hashset_t			history;
+	zbx_hashset_iter_t		iter;
+	zbx_history_item_values_t	*hitem, hitem_local;
+	zbx_vc_item_t			*item;
+	zbx_vector_ptr_t		pitems;
+	const zbx_vc_prefetch_item_t	*pitem;
+	int				i, value_type, start, read_num = 0, ret = SUCCEED, read_ret;
+
+	value_type = items->values[first].value_type;
+	start = now - items->values[last].range;
+
+	zbx_vector_ptr_create(&pitems);
+	zbx_hashset_create_ext(&history, last - first + 1, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC, vc_history_item_values_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC,
+			ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	vc_try_lock();
+
+	for (i = first; i <= last && ZBX_VC_MODE_NORMAL == vc_cache->mode; i++)
+	{
+		zbx_vc_item_t	new_item = {.itemid = items->values[i].itemid, .value_type = value_type};
+
+		if (NULL != zbx_hashset_search(&vc_cache->items, &new_item.itemid))
+			continue;
+
+		/* mark item as accessed so the values added by history syncers are not rejected */
+		new_item.last_accessed = now;
+
+		if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item,
+				sizeof(zbx_vc_item_t))))
+		{
+			break;
+		}
+
+		vc_item_addref(item);
+
+		hitem_local.itemid = item->itemid;
+		hitem = (zbx_history_item_values_t *)zbx_hashset_insert(&history, &hitem_local, sizeof(hitem_local));
+		zbx_vector_history_record_create(&hitem->values);
+
+		zbx_vector_ptr_append(&pitems, (void *)&items->values[i]);
+	}
+
+	vc_try_unlock();
+
+	if (0 == pitems.values_num)
+		goto out;
+
+	/* The range start is not included in the cached range, read one more second. */
+	/* One value over the limit is requested to detect that the limit is reached. */
+	if (SUCCEED == (read_ret = zbx_history_get_values_multi(value_type, start - 1,
+			ZBX_VC_PREFETCH_BATCH_VALUES + 1, now, &history)))
+	{
+		zbx_hashset_iter_reset(&history, &iter);
+		while (NULL != (hitem = (zbx_history_item_values_t *)zbx_hashset_iter_next(&iter)))
+			read_num += hitem->values.values_num;
+
+		if (ZBX_VC_PREFETCH_BATCH_VALUES < read_num)
+			ret = read_ret = FAIL;
+	}
+
+	vc_try_lock();
+
+	for (i = 0; i < pitems.values_num; i++)
+	{
+		int	offset = 0, item_start;
+
+		pitem = (const zbx_vc_prefetch_item_t *)pitems.values[i];
+
+		if (NULL == (hitem = (zbx_history_item_values_t *)zbx_hashset_search(&history, &pitem->itemid)) ||
+				NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &pitem->itemid)))
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			continue;
+		}
+
+		if (SUCCEED == read_ret)
+		{
+			zbx_vector_history_record_sort(&hitem->values,
+					(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+
+			/* drop values read for items with longer ranges in the same request */
+			item_start = now - pitem->range;
+			while (offset < hitem->values.values_num &&
+					hitem->values.values[offset].timestamp.sec < item_start)
+			{
+				offset++;
+			}
+
+			if (offset == hitem->values.values_num || SUCCEED == vch_item_add_values_at_tail(item,
+					hitem->values.values + offset, hitem->values.values_num - offset))
+			{
+				item->status = 0;
+				vc_item_update_db_cached_from(item, item_start);
+				vch_item_update_range(item, pitem->range, now);
+				item->last_accessed = now;
+
+				*values_num += hitem->values.values_num - offset;
+				(*items_num)++;
+			}
+			else
+				item->state |= ZBX_ITEM_STATE_REMOVE_PENDING;
+		}
+		else
+			item->state |= ZBX_ITEM_STATE_REMOVE_PENDING;
+
+		vc_item_release(item);
+	}
+
+	vc_try_unlock();
+
+	zbx_hashset_iter_reset(&history, &iter);
+	while (NULL != (hitem = (zbx_history_item_values_t *)zbx_hashset_iter_next(&iter)))
+		zbx_history_record_vector_clean(&hitem->values, value_type);
+out:
+	zbx_hashset_destroy(&history);
+	zbx_vector_ptr_destroy(&pitems);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_prefetch_range                                                *
+ *                                                                            *
+ * Purpose: caches history of items with the same value type, splitting them  *
+ *          until the values of each part fit into one history request       *
+ *                                                                            *
+ * Parameters: items      - [IN] the items, sorted by range                   *
+ *             first      - [IN] the first item to cache                      *
+ *             last       - [IN] the last item to cache                       *
+ *             now        - [IN] the current timestamp                        *
+ *             items_num  - [IN/OUT] the number of cached items               *
+ *             values_num - [IN/OUT] the number of cached values              *
+ *                                                                            *
+ * Comments: Items having more values than fit into one request are left for  *
+ *           on demand requests.                                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_prefetch_range(const zbx_vector_vc_prefetch_item_t *items, int first, int last, int now,
+		int *items_num, int *values_num)
+{
+	int	middle;
+
+	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+		return;
+
+	if (SUCCEED == vc_prefetch_items(items, first, last, now, items_num, values_num))
+		return;
+
+	if (first == last)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "item " ZBX_FS_UI64 " has too many values to be prefetched",
+				items->values[first].itemid);
+		return;
+	}
+
+	middle = first + (last - first) / 2;
+	vc_prefetch_range(items, first, middle, now, items_num, values_num);
+	vc_prefetch_range(items, middle + 1, last, now, items_num, values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_prefetch                                                  *
+ *                                                                            *
+ * Purpose: caches history of multiple items with batched history requests    *
+ *                                                                            *
+ * Parameters: items      - [IN/OUT] the items to cache, each item listed     *
+ *                                   once (sorted by the function)            *
+ *             now        - [IN] the current timestamp                        *
+ *             values_num - [OUT] the number of cached values, optional       *
+ *                                                                            *
+ * Return value: the number of cached items                                   *
+ *                                                                            *
+ * Comments: The items are grouped by value type and requested range and are  *
+ *           read from history storage in batches of up to                    *
+ *           ZBX_VC_PREFETCH_BATCH_SIZE items. A batch is further limited by  *
+ *           the estimated item values to ZBX_VC_PREFETCH_BATCH_VALUES, and   *
+ *           is split if it turns out to have more values, so the memory used *
+ *           by one request stays bounded.                                    *
+ *           Items already cached are skipped. Prefetching stops when the     *
+ *           cache switches to low memory mode.                               *
+ *           This function must be called with database connection opened.   *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_prefetch(zbx_vector_vc_prefetch_item_t *items, int now, int *values_num)
+{
+	int	i, first, batch_values, items_num = 0, values_local = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() items:%d", __func__, items->values_num);
+
+	if (ZBX_VC_DISABLED == vc_state || 0 == items->values_num)
+		goto out;
+
+	zbx_vector_vc_prefetch_item_sort(items, vc_prefetch_item_compare);
+
+	for (first = 0, batch_values = items->values[0].values_num, i = 1; i <= items->values_num; i++)
+	{
+		if (i != items->values_num && items->values[first].value_type == items->values[i].value_type &&
+				ZBX_VC_PREFETCH_BATCH_SIZE > i - first &&
+				ZBX_VC_PREFETCH_BATCH_VALUES - batch_values >= items->values[i].values_num)
+		{
+			batch_values += items->values[i].values_num;
+			continue;
+		}
+
+		vc_prefetch_range(items, first, i - 1, now, &items_num, &values_local);
+
+		if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "value cache is full, stopped prefetching");
+			break;
+		}
+
+		if (i != items->values_num)
+			batch_values = items->values[i].values_num;
+
+		first = i;
+	}
+out:
+	if (NULL != values_num)
+		*values_num = values_local;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() items:%d values:%d", __func__, items_num, values_local);
+
+	return items_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_read_working_set                                              *
+ *                                                                            *
+ * Purpose: reads the value cache working set from file                       *
+ *                                                                            *
+ * Parameters: f     - [IN] the working set file                              *
+ *             items - [OUT] the working set items                            *
+ *                                                                            *
+ * Comments: Invalid lines are skipped. The number of cached values is        *
+ *           optional to accept files written by older versions.              *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_read_working_set(FILE *f, zbx_vector_vc_prefetch_item_t *items)
+{
+	char			line[MAX_STRING_LEN];
+	zbx_vc_prefetch_item_t	pitem;
+	int			fields_num;
+
+	while (NULL != fgets(line, sizeof(line), f))
+	{
+		pitem.values_num = 0;
+
+		if (3 > (fields_num = sscanf(line, ZBX_FS_UI64 " %d %d %d", &pitem.itemid, &pitem.value_type,
+				&pitem.range, &pitem.values_num)))
+		{
+			continue;
+		}
+
+		if (ITEM_VALUE_TYPE_FLOAT > pitem.value_type || ITEM_VALUE_TYPE_TEXT < pitem.value_type ||
+				0 >= pitem.range)
+		{
+			continue;
+		}
+
+		if (0 > pitem.values_num)
+			pitem.values_num = 0;
+
+		zbx_vector_vc_prefetch_item_append_ptr(items, &pitem);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_prefetch_working_set                                      *
+ *                                                                            *
+ * Purpose: caches history of the items saved in working set file            *
+ *                                                                            *
+ * Parameters: path - [IN] the working set file path                          *
+ *                                                                            *
+ * Comments: This function must be called with database connection opened.   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_prefetch_working_set(const char *path)
+{
+	FILE				*f;
+	zbx_vector_vc_prefetch_item_t	items;
+	int				items_num, values_num;
+	double				sec;
+
+	if (NULL == path || '\0' == *path || ZBX_VC_DISABLED == vc_state)
+		return;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() path:%s", __func__, path);
+
+	if (NULL == (f = fopen(path, "r")))
+	{
+		if (ENOENT != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot open value cache working set file \"%s\": %s", path,
+					zbx_strerror(errno));
+		}
+		goto out;
+	}
+
+	zbx_vector_vc_prefetch_item_create(&items);
+	vc_read_working_set(f, &items);
+	fclose(f);
+
+	sec = zbx_time();
+	items_num = zbx_vc_prefetch(&items, time(NULL), &values_num);
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "prefetched %d values of %d out of %d value cache working set items in "
+			ZBX_FS_DBL " sec", values_num, items_num, items.values_num, zbx_time() - sec);
+
+	zbx_vector_vc_prefetch_item_destroy(&items);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 #ifdef HAVE_TESTS
 #	include "../../../tests/libs/zbxdbcache/valuecache_test.c"
 #endif
@@ -50,6 +50,11 @@
  *   either zbx_history_record_vector_destroy() function (free the zbx_vc_get_values()
  *   call output) or zbx_history_record_clear() function (free the zbx_vc_get_value() call output).
  *
+ *   Numeric aggregates (count, sum, avg, min, max, delta) can be calculated with
+ *   zbx_vc_aggregate() function and percentiles with zbx_vc_get_percentile() function
+ *   without copying the history data. Repeated requests of the same aggregate are served
+ *   from running window summaries, updated as new values are added to cache.
+ *
  * Locking
  *
  *   The cache ensures synchronization between processes by using automatic locks whenever
@@ -61,6 +66,15 @@
 #define ZBX_VC_MODE_NORMAL	0
 #define ZBX_VC_MODE_LOWMEM	1
 
+/* value cache aggregate functions, see zbx_vc_aggregate() */
+#define ZBX_VC_AGGREGATE_COUNT		0
+#define ZBX_VC_AGGREGATE_SUM		1
+#define ZBX_VC_AGGREGATE_AVG		2
+#define ZBX_VC_AGGREGATE_MIN		3
+#define ZBX_VC_AGGREGATE_MAX		4
+#define ZBX_VC_AGGREGATE_DELTA		5
+#define ZBX_VC_AGGREGATE_PERCENTILE	6
+
 /* indicates that all values from database are cached */
 #define ZBX_ITEM_STATUS_CACHED_ALL	1
 
@@ -111,6 +125,12 @@ int	zbx_vc_get_values(zbx_uint64_t itemid, int value_type, zbx_vector_history_re
 
 int	zbx_vc_get_value(zbx_uint64_t itemid, int value_type, const zbx_timespec_t *ts, zbx_history_record_t *value);
 
+int	zbx_vc_aggregate(zbx_uint64_t itemid, int value_type, int op, int seconds, int count,
+		const zbx_timespec_t *ts, history_value_t *value, int *values_num);
+
+int	zbx_vc_get_percentile(zbx_uint64_t itemid, int value_type, int seconds, int count, const zbx_timespec_t *ts,
+		double percentage, history_value_t *value, int *values_num);
+
 int	zbx_vc_add_values(zbx_vector_ptr_t *history);
 
 int	zbx_vc_get_statistics(zbx_vc_stats_t *stats);
@@ -121,4 +141,24 @@ void	zbx_vc_get_diag_stats(zbx_uint64_t *items_num, zbx_uint64_t *values_num, in
 void	zbx_vc_get_mem_stats(zbx_mem_stats_t *mem);
 void	zbx_vc_get_item_stats(zbx_vector_ptr_t *stats);
 
+/* the item history to be cached by zbx_vc_prefetch() */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	int		value_type;
+
+	/* the time range to cache in seconds */
+	int		range;
+
+	/* the estimated number of values in the range, 0 if not known */
+	int		values_num;
+}
+zbx_vc_prefetch_item_t;
+
+ZBX_VECTOR_DECL(vc_prefetch_item, zbx_vc_prefetch_item_t)
+
+int	zbx_vc_prefetch(zbx_vector_vc_prefetch_item_t *items, int now, int *values_num);
+void	zbx_vc_dump_working_set(const char *path);
+void	zbx_vc_prefetch_working_set(const char *path);
+
 #endif	/* ZABBIX_VALUECACHE_H */
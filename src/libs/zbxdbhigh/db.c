@@ -55,6 +55,7 @@ zbx_autoreg_host_t;
 
 #if defined(HAVE_POSTGRESQL)
 extern char	ZBX_PG_ESCAPE_BACKSLASH;
+extern int	CONFIG_DOUBLE_PRECISION;
 #endif
 
 static int	connection_failure;
@@ -339,7 +340,7 @@ int	DBend(int ret)
 	return FAIL;
 }
 
-#ifdef HAVE_ORACLE
+#if defined(HAVE_ORACLE) || defined(HAVE_MYSQL)
 /******************************************************************************
  *                                                                            *
  * Function: DBstatement_prepare                                              *
@@ -2256,6 +2257,59 @@ int	DBindex_exists(const char *table_name, const char *index_name)
 }
 #endif
 
+int	DBtrigger_exists(const char *table_name, const char *trigger_name)
+{
+	char		*table_name_esc, *trigger_name_esc;
+	DB_RESULT	result;
+	int		ret;
+
+	table_name_esc = DBdyn_escape_string(table_name);
+	trigger_name_esc = DBdyn_escape_string(trigger_name);
+
+#if defined(HAVE_MYSQL)
+	result = DBselect(
+			"select 1"
+			" from information_schema.triggers"
+			" where trigger_schema=database()"
+				" and event_object_table='%s'"
+				" and trigger_name='%s'",
+			table_name_esc, trigger_name_esc);
+#elif defined(HAVE_ORACLE)
+	result = DBselect(
+			"select 1"
+			" from user_triggers"
+			" where lower(table_name)='%s'"
+				" and lower(trigger_name)='%s'",
+			table_name_esc, trigger_name_esc);
+#elif defined(HAVE_POSTGRESQL)
+	result = DBselect(
+			"select 1"
+			" from pg_trigger t,pg_class c"
+			" where t.tgrelid=c.oid"
+				" and c.relname='%s'"
+				" and t.tgname='%s'"
+				" and pg_table_is_visible(c.oid)",
+			table_name_esc, trigger_name_esc);
+#elif defined(HAVE_SQLITE3)
+	result = DBselect(
+			"select 1"
+			" from sqlite_master"
+			" where tbl_name='%s'"
+				" and name='%s'"
+				" and type='trigger'",
+			table_name_esc, trigger_name_esc);
+#endif
+
+	ret = (NULL == DBfetch(result) ? FAIL : SUCCEED);
+
+	DBfree_result(result);
+
+	zbx_free(table_name_esc);
+	zbx_free(trigger_name_esc);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DBselect_uint64                                                  *
@@ -2540,7 +2594,7 @@ out:
 #endif
 }
 
-#ifdef HAVE_ORACLE
+#if defined(HAVE_ORACLE) || defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_format_values                                             *
@@ -2599,6 +2653,457 @@ static char	*zbx_db_format_values(ZBX_FIELD **fields, const zbx_db_value_t *valu
 }
 #endif
 
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_insert_bulk_supported                                     *
+ *                                                                            *
+ * Purpose: checks if rows can be bulk loaded into the target table           *
+ *                                                                            *
+ * Parameters: table      - [IN] the target table                             *
+ *             fields     - [IN] the fields to insert                         *
+ *             fields_num - [IN] the number of fields                         *
+ *                                                                            *
+ * Return value: 1 - the rows are loaded with COPY (PostgreSQL) or prepared   *
+ *                   statement (MySQL)                                        *
+ *               0 - the rows are inserted with SQL statement text            *
+ *                                                                            *
+ * Comments: Only the high volume history and trend tables are bulk loaded.   *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	zbx_db_insert_bulk_supported(const ZBX_TABLE *table, const ZBX_FIELD **fields,
+		int fields_num)
+{
+	const char	*tables[] = {"history", "history_uint", "history_str", "history_text", "history_log", "trends",
+			"trends_uint", "proxy_history", NULL};
+	const char	**name;
+	int		i;
+
+	for (name = tables; NULL != *name; name++)
+	{
+		if (0 == strcmp(table->table, *name))
+			break;
+	}
+
+	if (NULL == *name)
+		return 0;
+
+	for (i = 0; i < fields_num; i++)
+	{
+		switch (fields[i]->type)
+		{
+			case ZBX_TYPE_ID:
+			case ZBX_TYPE_INT:
+			case ZBX_TYPE_UINT:
+			case ZBX_TYPE_CHAR:
+			case ZBX_TYPE_TEXT:
+			case ZBX_TYPE_SHORTTEXT:
+			case ZBX_TYPE_LONGTEXT:
+				break;
+			case ZBX_TYPE_FLOAT:
+#ifdef HAVE_POSTGRESQL
+				/* binary format of numeric(16,4) columns of not upgraded database is not supported */
+				if (ZBX_DB_DBL_PRECISION_ENABLED != CONFIG_DOUBLE_PRECISION)
+					return 0;
+#endif
+				break;
+			default:
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_insert_log_rows                                           *
+ *                                                                            *
+ * Purpose: logs bulk loaded rows at debug level                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_db_insert_log_rows(const zbx_db_insert_t *self, int rows_start, int rows_end)
+{
+	int	i;
+	char	*str;
+
+	if (SUCCEED != ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+		return;
+
+	for (i = rows_start; i < rows_end; i++)
+	{
+		str = zbx_db_format_values((ZBX_FIELD **)self->fields.values, (zbx_db_value_t *)self->rows.values[i],
+				self->fields.values_num);
+		zabbix_log(LOG_LEVEL_DEBUG, "insert [txnlev:%d] [%s]", zbx_db_txn_level(), str);
+		zbx_free(str);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_insert_retry                                              *
+ *                                                                            *
+ * Purpose: reconnects to database after bulk load failed because database    *
+ *          was down                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_db_insert_retry(int *tries)
+{
+	if (0 < (*tries)++)
+	{
+		zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+		connection_failure = 1;
+		sleep(ZBX_DB_WAIT_DOWN);
+	}
+
+	DBclose();
+	DBconnect(ZBX_DB_CONNECT_NORMAL);
+}
+#endif
+
+#ifdef HAVE_MYSQL
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_insert_add_text_defaults                                  *
+ *                                                                            *
+ * Purpose: MySQL workaround - explicitly add missing text fields with ''     *
+ *          default value                                                     *
+ *                                                                            *
+ * Parameters: self       - [IN] the bulk insert data                         *
+ *             sql        - [IN/OUT] the insert statement field list          *
+ *             sql_alloc  - [IN/OUT]                                          *
+ *             sql_offset - [IN/OUT]                                          *
+ *             values     - [IN/OUT] the values of added fields               *
+ *             values_alloc  - [IN/OUT]                                       *
+ *             values_offset - [IN/OUT]                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_db_insert_add_text_defaults(const zbx_db_insert_t *self, char **sql, size_t *sql_alloc,
+		size_t *sql_offset, char **values, size_t *values_alloc, size_t *values_offset)
+{
+	const ZBX_FIELD	*field;
+
+	for (field = (const ZBX_FIELD *)self->table->fields; NULL != field->name; field++)
+	{
+		switch (field->type)
+		{
+			case ZBX_TYPE_BLOB:
+			case ZBX_TYPE_TEXT:
+			case ZBX_TYPE_SHORTTEXT:
+			case ZBX_TYPE_LONGTEXT:
+				if (FAIL != zbx_vector_ptr_search(&self->fields, (void *)field,
+						ZBX_DEFAULT_PTR_COMPARE_FUNC))
+				{
+					continue;
+				}
+
+				zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, ',');
+				zbx_strcpy_alloc(sql, sql_alloc, sql_offset, field->name);
+
+				zbx_strcpy_alloc(values, values_alloc, values_offset, ",''");
+				break;
+		}
+	}
+}
+
+#define ZBX_DB_INSERT_BULK_ROWS		1000
+#define ZBX_DB_INSERT_BULK_PARAMS	65535
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_insert_execute_bulk                                       *
+ *                                                                            *
+ * Purpose: inserts rows with multi-row prepared statement                    *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: SUCCEED - the rows were inserted                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The values are bound as parameters instead of being formatted    *
+ *           and escaped into statement text. Rows are inserted in chunks of  *
+ *           equal size, so the statement is prepared by server only once for *
+ *           all full chunks.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_db_insert_execute_bulk(zbx_db_insert_t *self)
+{
+	int			ret = SUCCEED, i, j, rc, tries = 0, rows_max, rows_start, rows_num;
+	char			*sql_fields = NULL, *sql_values = NULL, *sql = NULL;
+	size_t			sql_fields_alloc = 0, sql_fields_offset = 0, sql_values_alloc = 0,
+				sql_values_offset = 0, sql_alloc = 0, sql_offset;
+	zbx_db_bind_context_t	*contexts;
+
+	zbx_snprintf_alloc(&sql_fields, &sql_fields_alloc, &sql_fields_offset, "insert into %s (",
+			self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		if (0 != i)
+			zbx_chrcpy_alloc(&sql_fields, &sql_fields_alloc, &sql_fields_offset, ',');
+
+		zbx_strcpy_alloc(&sql_fields, &sql_fields_alloc, &sql_fields_offset,
+				((ZBX_FIELD *)self->fields.values[i])->name);
+	}
+
+	zbx_db_insert_add_text_defaults(self, &sql_fields, &sql_fields_alloc, &sql_fields_offset, &sql_values,
+			&sql_values_alloc, &sql_values_offset);
+	zbx_strcpy_alloc(&sql_fields, &sql_fields_alloc, &sql_fields_offset, ") values ");
+
+	rows_max = MIN(ZBX_DB_INSERT_BULK_ROWS, ZBX_DB_INSERT_BULK_PARAMS / self->fields.values_num);
+	contexts = (zbx_db_bind_context_t *)zbx_malloc(NULL, sizeof(zbx_db_bind_context_t) * self->fields.values_num);
+
+	for (rows_start = 0; rows_start < self->rows.values_num; rows_start += rows_num)
+	{
+		size_t	data_size = 0;
+
+		/* limit the amount of data sent with single statement */
+		for (rows_num = 0; rows_num < rows_max && rows_start + rows_num < self->rows.values_num &&
+				ZBX_MAX_SQL_SIZE > data_size; rows_num++)
+		{
+			zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[rows_start + rows_num];
+
+			for (j = 0; j < self->fields.values_num; j++)
+			{
+				switch (((ZBX_FIELD *)self->fields.values[j])->type)
+				{
+					case ZBX_TYPE_CHAR:
+					case ZBX_TYPE_TEXT:
+					case ZBX_TYPE_SHORTTEXT:
+					case ZBX_TYPE_LONGTEXT:
+						data_size += strlen(values[j].str);
+						break;
+					default:
+						data_size += sizeof(zbx_db_value_t);
+				}
+			}
+		}
+
+		sql_offset = 0;
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, sql_fields);
+
+		for (i = 0; i < rows_num; i++)
+		{
+			if (0 != i)
+				zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+			for (j = 0; j < self->fields.values_num; j++)
+				zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, 0 == j ? "(?" : ",?");
+
+			if (NULL != sql_values)
+				zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, sql_values);
+
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
+		}
+retry:
+		DBstatement_prepare(sql);
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			if (ZBX_DB_OK > zbx_db_bind_parameter_dyn(&contexts[j], j,
+					((ZBX_FIELD *)self->fields.values[j])->type,
+					(zbx_db_value_t **)self->rows.values + rows_start, rows_num))
+			{
+				for (i = 0; i < j; i++)
+					zbx_db_clean_bind_context(&contexts[i]);
+
+				ret = FAIL;
+				goto out;
+			}
+		}
+
+		zbx_db_insert_log_rows(self, rows_start, rows_start + rows_num);
+
+		rc = zbx_db_statement_execute(rows_num);
+
+		for (j = 0; j < self->fields.values_num; j++)
+			zbx_db_clean_bind_context(&contexts[j]);
+
+		if (ZBX_DB_DOWN == rc)
+		{
+			zbx_db_insert_retry(&tries);
+			goto retry;
+		}
+
+		if (ZBX_DB_OK > rc)
+		{
+			ret = FAIL;
+			break;
+		}
+	}
+out:
+	zbx_free(contexts);
+	zbx_free(sql);
+	zbx_free(sql_values);
+	zbx_free(sql_fields);
+
+	return ret;
+}
+
+#undef ZBX_DB_INSERT_BULK_ROWS
+#undef ZBX_DB_INSERT_BULK_PARAMS
+#endif
+
+#ifdef HAVE_POSTGRESQL
+/* PostgreSQL binary COPY format header - signature, flags and header extension length */
+static const char	copy_header[] = {'P', 'G', 'C', 'O', 'P', 'Y', '\n', '\377', '\r', '\n', '\0',
+				0, 0, 0, 0, 0, 0, 0, 0};
+
+/******************************************************************************
+ *                                                                            *
+ * Function: copy_append_uint                                                 *
+ *                                                                            *
+ * Purpose: appends unsigned integer in network byte order to COPY data       *
+ *                                                                            *
+ * Parameters: data        - [IN/OUT] the COPY data                           *
+ *             data_alloc  - [IN/OUT]                                         *
+ *             data_offset - [IN/OUT]                                         *
+ *             value       - [IN] the value to append                         *
+ *             size        - [IN] the value size in bytes                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	copy_append_uint(char **data, size_t *data_alloc, size_t *data_offset, zbx_uint64_t value, int size)
+{
+	char	buf[8];
+	int	i;
+
+	for (i = size - 1; 0 <= i; i--)
+	{
+		buf[i] = (char)(value & 0xff);
+		value >>= 8;
+	}
+
+	zbx_str_memcpy_alloc(data, data_alloc, data_offset, buf, (size_t)size);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: copy_append_numeric                                              *
+ *                                                                            *
+ * Purpose: appends unsigned integer to COPY data in binary format of numeric *
+ *          type                                                              *
+ *                                                                            *
+ * Comments: numeric is sent as number of base 10000 digits, weight of the    *
+ *           first digit, sign, display scale and the digits themselves,      *
+ *           starting with the most significant one                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	copy_append_numeric(char **data, size_t *data_alloc, size_t *data_offset, zbx_uint64_t value)
+{
+	int	digits[5], digits_num = 0, i;
+
+	for (; 0 != value; value /= 10000)
+		digits[digits_num++] = (int)(value % 10000);
+
+	copy_append_uint(data, data_alloc, data_offset, (zbx_uint64_t)(8 + digits_num * 2), 4);
+	copy_append_uint(data, data_alloc, data_offset, (zbx_uint64_t)digits_num, 2);
+	copy_append_uint(data, data_alloc, data_offset, (zbx_uint64_t)(0 != digits_num ? digits_num - 1 : 0), 2);
+	copy_append_uint(data, data_alloc, data_offset, 0, 2);	/* positive sign */
+	copy_append_uint(data, data_alloc, data_offset, 0, 2);	/* display scale */
+
+	for (i = digits_num - 1; 0 <= i; i--)
+		copy_append_uint(data, data_alloc, data_offset, (zbx_uint64_t)digits[i], 2);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_insert_execute_bulk                                       *
+ *                                                                            *
+ * Purpose: loads rows with COPY FROM STDIN statement                         *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: SUCCEED - the rows were loaded                               *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The rows are sent in binary format, which spares formatting and  *
+ *           escaping of values as well as parsing of the statement text by   *
+ *           server.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_db_insert_execute_bulk(zbx_db_insert_t *self)
+{
+	int		i, j, rc, tries = 0;
+	char		*sql = NULL, *data = NULL;
+	size_t		sql_alloc = 0, sql_offset = 0, data_alloc = 0, data_offset = 0, len;
+	zbx_uint64_t	dbl_bits;
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "copy %s (", self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		if (0 != i)
+			zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ((ZBX_FIELD *)self->fields.values[i])->name);
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") from stdin (format binary)");
+
+	zbx_str_memcpy_alloc(&data, &data_alloc, &data_offset, copy_header, sizeof(copy_header));
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
+
+		copy_append_uint(&data, &data_alloc, &data_offset, (zbx_uint64_t)self->fields.values_num, 2);
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			switch (((ZBX_FIELD *)self->fields.values[j])->type)
+			{
+				case ZBX_TYPE_ID:
+					/* handle 0 -> NULL conversion */
+					if (0 == values[j].ui64)
+					{
+						copy_append_uint(&data, &data_alloc, &data_offset, 0xffffffff, 4);
+						break;
+					}
+					copy_append_uint(&data, &data_alloc, &data_offset, 8, 4);
+					copy_append_uint(&data, &data_alloc, &data_offset, values[j].ui64, 8);
+					break;
+				case ZBX_TYPE_INT:
+					copy_append_uint(&data, &data_alloc, &data_offset, 4, 4);
+					copy_append_uint(&data, &data_alloc, &data_offset, (zbx_uint32_t)values[j].i32, 4);
+					break;
+				case ZBX_TYPE_UINT:
+					copy_append_numeric(&data, &data_alloc, &data_offset, values[j].ui64);
+					break;
+				case ZBX_TYPE_FLOAT:
+					memcpy(&dbl_bits, &values[j].dbl, sizeof(dbl_bits));
+					copy_append_uint(&data, &data_alloc, &data_offset, 8, 4);
+					copy_append_uint(&data, &data_alloc, &data_offset, dbl_bits, 8);
+					break;
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+					len = strlen(values[j].str);
+					copy_append_uint(&data, &data_alloc, &data_offset, (zbx_uint64_t)len, 4);
+					zbx_str_memcpy_alloc(&data, &data_alloc, &data_offset, values[j].str, len);
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	/* file trailer */
+	copy_append_uint(&data, &data_alloc, &data_offset, 0xffff, 2);
+
+	zbx_db_insert_log_rows(self, 0, self->rows.values_num);
+
+	while (ZBX_DB_DOWN == (rc = zbx_db_copy(sql, data, data_offset)))
+		zbx_db_insert_retry(&tries);
+
+	zbx_free(data);
+	zbx_free(sql);
+
+	return ZBX_DB_OK <= rc ? SUCCEED : FAIL;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_insert_clean                                              *
@@ -2682,6 +3187,12 @@ void	zbx_db_insert_prepare_dyn(zbx_db_insert_t *self, const ZBX_TABLE *table, co
 
 	for (i = 0; i < fields_num; i++)
 		zbx_vector_ptr_append(&self->fields, (ZBX_FIELD *)fields[i]);
+
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	self->bulk = zbx_db_insert_bulk_supported(table, fields, fields_num);
+#else
+	self->bulk = 0;
+#endif
 }
 
 /******************************************************************************
@@ -2778,7 +3289,9 @@ void	zbx_db_insert_add_values_dyn(zbx_db_insert_t *self, const zbx_db_value_t **
 #ifdef HAVE_ORACLE
 				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_OFF);
 #else
-				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_ON);
+				/* bulk loaded values are passed to database as is */
+				row[i].str = DBdyn_escape_field_len(field, value->str,
+						0 != self->bulk ? ESCAPE_SEQUENCE_OFF : ESCAPE_SEQUENCE_ON);
 #endif
 				break;
 			default:
@@ -2907,6 +3420,11 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 		}
 	}
 
+#if defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL)
+	if (0 != self->bulk)
+		return zbx_db_insert_execute_bulk(self);
+#endif
+
 #ifndef HAVE_ORACLE
 	sql = (char *)zbx_malloc(NULL, sql_alloc);
 #endif
@@ -2927,28 +3445,8 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 	}
 
 #ifdef HAVE_MYSQL
-	/* MySQL workaround - explicitly add missing text fields with '' default value */
-	for (field = (const ZBX_FIELD *)self->table->fields; NULL != field->name; field++)
-	{
-		switch (field->type)
-		{
-			case ZBX_TYPE_BLOB:
-			case ZBX_TYPE_TEXT:
-			case ZBX_TYPE_SHORTTEXT:
-			case ZBX_TYPE_LONGTEXT:
-				if (FAIL != zbx_vector_ptr_search(&self->fields, (void *)field,
-						ZBX_DEFAULT_PTR_COMPARE_FUNC))
-				{
-					continue;
-				}
-
-				zbx_chrcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, ',');
-				zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, field->name);
-
-				zbx_strcpy_alloc(&sql_values, &sql_values_alloc, &sql_values_offset, ",''");
-				break;
-		}
-	}
+	zbx_db_insert_add_text_defaults(self, &sql_command, &sql_command_alloc, &sql_command_offset, &sql_values,
+			&sql_values_alloc, &sql_values_offset);
 #endif
 	zbx_strcpy_alloc(&sql_command, &sql_command_alloc, &sql_command_offset, ") values ");
 
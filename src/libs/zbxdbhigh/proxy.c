@@ -46,6 +46,40 @@ extern char	*CONFIG_VAULTDBPATH;
 /* the maximum number of values processed in one batch */
 #define ZBX_HISTORY_VALUES_MAX		256
 
+/* the average number of rows in proxy configuration revision bucket */
+#define ZBX_PROXYCONFIG_BUCKET_ROWS	64
+/* the maximum number of proxy configuration revision buckets per table */
+#define ZBX_PROXYCONFIG_BUCKETS_MAX	4096
+
+/* the tables synchronized from server to proxy, in the order of dependencies */
+static const char	*proxyconfig_tables[] =
+{
+	"globalmacro",
+	"hosts",
+	"interface",
+	"interface_snmp",
+	"hosts_templates",
+	"hostmacro",
+	"items",
+	"item_rtdata",
+	"item_preproc",
+	"item_parameter",
+	"drules",
+	"dchecks",
+	"regexps",
+	"expressions",
+	"hstgrp",
+	"config",
+	"httptest",
+	"httptestitem",
+	"httptest_field",
+	"httpstep",
+	"httpstepitem",
+	"httpstep_field",
+	"config_autoreg_tls",
+	NULL
+};
+
 typedef struct
 {
 	zbx_uint64_t		druleid;
@@ -126,6 +160,17 @@ static zbx_history_table_t	areg = {
 		}
 };
 
+#define ZBX_PROXY_HISTORY_DATABASE	0
+#define ZBX_PROXY_HISTORY_BUFFER	1
+
+/* source and last sent value identifier of history read by the last proxy_get_hist_data() call, */
+/* used to acknowledge the history when proxy history buffer is enabled                         */
+static unsigned char	history_source = ZBX_PROXY_HISTORY_DATABASE;
+static zbx_uint64_t	history_valueid;
+
+/* the last database history id to read, 0 - no limit */
+static zbx_uint64_t	history_maxid;
+
 static const char	*availability_tag_available[ZBX_AGENT_MAX] = {ZBX_PROTO_TAG_AVAILABLE,
 					ZBX_PROTO_TAG_SNMP_AVAILABLE, ZBX_PROTO_TAG_IPMI_AVAILABLE,
 					ZBX_PROTO_TAG_JMX_AVAILABLE};
@@ -483,6 +528,72 @@ static void	proxyconfig_add_row(struct zbx_json *j, const DB_ROW row, const ZBX_
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_is_local_field                                       *
+ *                                                                            *
+ * Purpose: check if the field value is maintained by proxy and must not be   *
+ *          included in the configuration revision                            *
+ *                                                                            *
+ * Parameters: table - [IN] the table name                                    *
+ *             field - [IN] the field name                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the field value is maintained by proxy             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_is_local_field(const char *table, const char *field)
+{
+	if (0 == strcmp(table, "hosts"))
+		return str_in_list("available,snmp_available,ipmi_available,jmx_available", field, ',');
+
+	/* log item position is updated by proxy when gathering log values */
+	if (0 == strcmp(table, "item_rtdata"))
+		return str_in_list("lastlogsize,mtime", field, ',');
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_digest_add                                           *
+ *                                                                            *
+ * Purpose: add field value to the row digest                                 *
+ *                                                                            *
+ * Comments: NULL values are digested as empty strings, because the same      *
+ *           value can be represented differently by server and proxy         *
+ *           databases                                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxyconfig_digest_add(md5_state_t *state, const char *value)
+{
+	if (NULL == value)
+		value = "";
+
+	zbx_md5_append(state, (const md5_byte_t *)value, (int)strlen(value) + 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_digest_get                                           *
+ *                                                                            *
+ * Purpose: get the 64 bit row digest independently of platform byte order    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	proxyconfig_digest_get(md5_state_t *state)
+{
+	md5_byte_t	md5[MD5_DIGEST_SIZE];
+	zbx_uint64_t	digest = 0;
+	int		i;
+
+	zbx_md5_finish(state, md5);
+
+	for (i = 0; i < (int)sizeof(digest); i++)
+		digest = (digest << 8) | md5[i];
+
+	return digest;
+}
+
 typedef struct
 {
 	zbx_uint64_t	itemid;
@@ -1097,82 +1208,290 @@ static void	get_macro_secrets(const zbx_vector_ptr_t *keys_paths, struct zbx_jso
 	zbx_hashset_destroy(&kvs);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_add_raw                                              *
+ *                                                                            *
+ * Purpose: copy json element to the output json                              *
+ *                                                                            *
+ * Parameters: j         - [OUT] the output json                              *
+ *             name      - [IN] the element name, NULL for array elements     *
+ *             jp        - [IN] the element to copy                           *
+ *             buf       - [IN/OUT] the copy buffer                           *
+ *             buf_alloc - [IN/OUT] the copy buffer size                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxyconfig_add_raw(struct zbx_json *j, const char *name, const struct zbx_json_parse *jp,
+		char **buf, size_t *buf_alloc)
+{
+	size_t	buf_offset = 0;
+
+	zbx_strncpy_alloc(buf, buf_alloc, &buf_offset, jp->start, (size_t)(jp->end - jp->start + 1));
+	zbx_json_addraw(j, name, *buf);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxyconfig_add_table_changes                                    *
+ *                                                                            *
+ * Purpose: add the table rows changed since proxy configuration revision to  *
+ *          the proxy config json data                                        *
+ *                                                                            *
+ * Parameters: j           - [OUT] the output json                            *
+ *             jp_table    - [IN] the full table data                         *
+ *             table       - [IN] the table                                   *
+ *             jp_revision - [IN] the configuration revision received from    *
+ *                                proxy                                       *
+ *                                                                            *
+ * Return value: SUCCEED - the changes were added (nothing is added if table  *
+ *                         has not been changed)                              *
+ *               FAIL    - proxy revision of the table is missing or invalid  *
+ *                                                                            *
+ * Comments: Proxy configuration revision contains digests of the table rows  *
+ *           split into buckets by record identifier. All rows of the buckets *
+ *           with different digests are sent together with the list of those  *
+ *           buckets, so proxy can also remove its rows missing in the data.  *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxyconfig_add_table_changes(struct zbx_json *j, const struct zbx_json_parse *jp_table,
+		const ZBX_TABLE *table, const struct zbx_json_parse *jp_revision)
+{
+	struct zbx_json_parse	jp_rev, jp_fields, jp_data, jp_row;
+	char			tmp[MAX_ID_LEN + 1], *buf = NULL;
+	size_t			buf_alloc = 0;
+	const char		*p, *pf;
+	int			f, fields_num, buckets_num, changed_num = 0, ret = FAIL;
+	unsigned char		local[ZBX_MAX_FIELDS], *changed = NULL;
+	zbx_uint64_t		*digests = NULL, *proxy_digests = NULL, fields_digest, recid;
+	md5_state_t		state;
+
+	if (SUCCEED != zbx_json_brackets_by_name(jp_revision, table->table, &jp_rev))
+		goto out;
+
+	if (SUCCEED != zbx_json_value_by_name(&jp_rev, ZBX_PROTO_TAG_BUCKETS, tmp, sizeof(tmp), NULL) ||
+			SUCCEED != is_uint_range(tmp, &buckets_num, 1, ZBX_PROXYCONFIG_BUCKETS_MAX))
+	{
+		goto out;
+	}
+
+	if (SUCCEED != zbx_json_brackets_by_name(&jp_rev, ZBX_PROTO_TAG_DIGESTS, &jp_data))
+		goto out;
+
+	proxy_digests = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)buckets_num);
+
+	for (f = 0, p = NULL; NULL != (p = zbx_json_next_value(&jp_data, p, tmp, sizeof(tmp), NULL)); f++)
+	{
+		if (f == buckets_num || SUCCEED != is_uint64(tmp, &proxy_digests[f]))
+			goto out;
+	}
+
+	if (f != buckets_num)
+		goto out;
+
+	if (SUCCEED != zbx_json_brackets_by_name(jp_table, "fields", &jp_fields) ||
+			SUCCEED != zbx_json_brackets_by_name(jp_table, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		goto out;
+	}
+
+	/* the field list is part of the digest to detect schema differences between server and proxy */
+	zbx_md5_init(&state);
+
+	for (fields_num = 0, p = NULL; NULL != (p = zbx_json_next_value_dyn(&jp_fields, p, &buf, &buf_alloc, NULL));
+			fields_num++)
+	{
+		if (ZBX_MAX_FIELDS == fields_num)
+			goto out;
+
+		if (SUCCEED == proxyconfig_is_local_field(table->table, buf))
+		{
+			local[fields_num] = 1;
+			continue;
+		}
+
+		local[fields_num] = 0;
+		proxyconfig_digest_add(&state, buf);
+	}
+
+	fields_digest = proxyconfig_digest_get(&state);
+
+	digests = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)buckets_num);
+	changed = (unsigned char *)zbx_malloc(NULL, (size_t)buckets_num);
+
+	for (f = 0; f < buckets_num; f++)
+		digests[f] = fields_digest;
+
+	for (p = NULL; NULL != (p = zbx_json_next(&jp_data, p));)
+	{
+		zbx_json_type_t	type;
+
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row) ||
+				NULL == (pf = zbx_json_next_value_dyn(&jp_row, NULL, &buf, &buf_alloc, NULL)) ||
+				SUCCEED != is_uint64(buf, &recid))
+		{
+			goto out;
+		}
+
+		zbx_md5_init(&state);
+		proxyconfig_digest_add(&state, buf);
+
+		for (f = 1; NULL != (pf = zbx_json_next_value_dyn(&jp_row, pf, &buf, &buf_alloc, &type)); f++)
+		{
+			if (f == fields_num)
+				goto out;
+
+			if (0 == local[f])
+				proxyconfig_digest_add(&state, ZBX_JSON_TYPE_NULL == type ? NULL : buf);
+		}
+
+		digests[recid % (zbx_uint64_t)buckets_num] += proxyconfig_digest_get(&state);
+	}
+
+	for (f = 0; f < buckets_num; f++)
+	{
+		if (digests[f] != proxy_digests[f])
+		{
+			changed[f] = 1;
+			changed_num++;
+		}
+		else
+			changed[f] = 0;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() table:%s buckets:%d changed:%d", __func__, table->table, buckets_num,
+			changed_num);
+
+	ret = SUCCEED;
+
+	if (0 == changed_num)
+		goto out;
+
+	zbx_json_addobject(j, table->table);
+	proxyconfig_add_raw(j, "fields", &jp_fields, &buf, &buf_alloc);
+	zbx_json_addarray(j, ZBX_PROTO_TAG_DATA);
+
+	for (p = NULL; NULL != (p = zbx_json_next(&jp_data, p));)
+	{
+		zbx_json_brackets_open(p, &jp_row);
+		zbx_json_next_value(&jp_row, NULL, tmp, sizeof(tmp), NULL);
+		ZBX_STR2UINT64(recid, tmp);
+
+		if (0 != changed[recid % (zbx_uint64_t)buckets_num])
+			proxyconfig_add_raw(j, NULL, &jp_row, &buf, &buf_alloc);
+	}
+
+	zbx_json_close(j);	/* data */
+
+	zbx_json_adduint64(j, ZBX_PROTO_TAG_BUCKETS, (zbx_uint64_t)buckets_num);
+	zbx_json_addarray(j, ZBX_PROTO_TAG_CHANGED);
+
+	for (f = 0; f < buckets_num; f++)
+	{
+		if (0 != changed[f])
+			zbx_json_adduint64(j, NULL, (zbx_uint64_t)f);
+	}
+
+	zbx_json_close(j);	/* changed */
+	zbx_json_close(j);	/* table->table */
+out:
+	zbx_free(changed);
+	zbx_free(digests);
+	zbx_free(proxy_digests);
+	zbx_free(buf);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_proxyconfig_data                                             *
  *                                                                            *
  * Purpose: prepare proxy configuration data                                  *
  *                                                                            *
+ * Parameters: proxy_hostid - [IN] the proxy identifier                       *
+ *             jp_revision  - [IN] the configuration revision received from   *
+ *                                 proxy, NULL to send full configuration     *
+ *             j            - [OUT] the proxy configuration data              *
+ *             error        - [OUT] the error message                         *
+ *                                                                            *
+ * Return value: SUCCEED - the configuration data was prepared                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: All proxy tables are selected from database regardless of the    *
+ *           revision. The revision only reduces the data sent to proxy and   *
+ *           the changes applied by proxy, not the server database load.      *
+ *                                                                            *
  ******************************************************************************/
-int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, char **error)
+int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, const struct zbx_json_parse *jp_revision,
+		struct zbx_json *j, char **error)
 {
-	static const char	*proxytable[] =
-	{
-		"globalmacro",
-		"hosts",
-		"interface",
-		"interface_snmp",
-		"hosts_templates",
-		"hostmacro",
-		"items",
-		"item_rtdata",
-		"item_preproc",
-		"item_parameter",
-		"drules",
-		"dchecks",
-		"regexps",
-		"expressions",
-		"hstgrp",
-		"config",
-		"httptest",
-		"httptestitem",
-		"httptest_field",
-		"httpstep",
-		"httpstepitem",
-		"httpstep_field",
-		"config_autoreg_tls",
-		NULL
-	};
-
 	int			i, ret = FAIL;
 	const ZBX_TABLE		*table;
 	zbx_vector_uint64_t	hosts, httptests;
 	zbx_hashset_t		itemids;
 	zbx_vector_ptr_t	keys_paths;
+	struct zbx_json		jt, *jtable = j;
+	struct zbx_json_parse	jp, jp_table;
+	char			*buf = NULL;
+	size_t			buf_alloc = 0;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxy_hostid:" ZBX_FS_UI64, __func__, proxy_hostid);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() proxy_hostid:" ZBX_FS_UI64 " revision:%s", __func__, proxy_hostid,
+			(NULL == jp_revision ? "no" : "yes"));
 
 	zbx_hashset_create(&itemids, 1000, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 	zbx_vector_uint64_create(&hosts);
 	zbx_vector_uint64_create(&httptests);
 	zbx_vector_ptr_create(&keys_paths);
 
+	/* with proxy configuration revision the tables are prepared separately and only the changes are sent */
+	if (NULL != jp_revision)
+	{
+		zbx_json_init(&jt, ZBX_JSON_STAT_BUF_LEN);
+		jtable = &jt;
+	}
+
 	DBbegin();
 	get_proxy_monitored_hosts(proxy_hostid, &hosts);
 	get_proxy_monitored_httptests(proxy_hostid, &httptests);
 
-	for (i = 0; NULL != proxytable[i]; i++)
+	for (i = 0; NULL != proxyconfig_tables[i]; i++)
 	{
-		table = DBget_table(proxytable[i]);
+		table = DBget_table(proxyconfig_tables[i]);
 
-		if (0 == strcmp(proxytable[i], "items"))
+		if (NULL != jp_revision)
+			zbx_json_clean(&jt);
+
+		if (0 == strcmp(proxyconfig_tables[i], "items"))
 		{
-			ret = get_proxyconfig_table_items(proxy_hostid, j, table, &itemids);
+			ret = get_proxyconfig_table_items(proxy_hostid, jtable, table, &itemids);
 		}
-		else if (0 == strcmp(proxytable[i], "item_preproc") || 0 == strcmp(proxytable[i], "item_rtdata") ||
-				0 == strcmp(proxytable[i], "item_parameter"))
+		else if (0 == strcmp(proxyconfig_tables[i], "item_preproc") ||
+				0 == strcmp(proxyconfig_tables[i], "item_rtdata") ||
+				0 == strcmp(proxyconfig_tables[i], "item_parameter"))
 		{
 			if (0 != itemids.num_data)
-				ret = get_proxyconfig_table_items_ext(proxy_hostid, &itemids, j, table);
+				ret = get_proxyconfig_table_items_ext(proxy_hostid, &itemids, jtable, table);
 		}
 		else
-			ret = get_proxyconfig_table(proxy_hostid, j, table, &hosts, &httptests, &keys_paths);
+			ret = get_proxyconfig_table(proxy_hostid, jtable, table, &hosts, &httptests, &keys_paths);
 
 		if (SUCCEED != ret)
 		{
 			*error = zbx_dsprintf(*error, "failed to get data from table \"%s\"", table->table);
 			goto out;
 		}
+
+		if (NULL == jp_revision || SUCCEED != zbx_json_open(jt.buffer, &jp) ||
+				SUCCEED != zbx_json_brackets_by_name(&jp, table->table, &jp_table))
+		{
+			continue;
+		}
+
+		if (SUCCEED != proxyconfig_add_table_changes(j, &jp_table, table, jp_revision))
+		{
+			/* proxy revision of the table is missing or invalid - send the whole table */
+			proxyconfig_add_raw(j, table->table, &jp_table, &buf, &buf_alloc);
+		}
 	}
 
 	get_macro_secrets(&keys_paths, j);
@@ -1180,6 +1499,11 @@ int	get_proxyconfig_data(zbx_uint64_t proxy_hostid, struct zbx_json *j, char **e
 	ret = SUCCEED;
 out:
 	DBcommit();
+	zbx_free(buf);
+
+	if (NULL != jp_revision)
+		zbx_json_free(&jt);
+
 	zbx_vector_ptr_clear_ext(&keys_paths, key_path_free);
 	zbx_vector_ptr_destroy(&keys_paths);
 	zbx_vector_uint64_destroy(&httptests);
@@ -1191,6 +1515,139 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: get_proxyconfig_table_revision                                   *
+ *                                                                            *
+ * Purpose: add revision of the local proxy configuration table               *
+ *                                                                            *
+ * Parameters: j     - [OUT] the output json                                  *
+ *             table - [IN] the table                                         *
+ *                                                                            *
+ * Comments: The rows are split into buckets by record identifier and the     *
+ *           bucket digest is a sum of the field list digest and its row      *
+ *           digests, so it does not depend on the order of rows.             *
+ *                                                                            *
+ ******************************************************************************/
+static void	get_proxyconfig_table_revision(struct zbx_json *j, const ZBX_TABLE *table)
+{
+	char			*sql = NULL;
+	size_t			sql_alloc = 4 * ZBX_KIBIBYTE, sql_offset = 0;
+	int			f, fields_num = 1, buckets_num, i;
+	unsigned char		local[ZBX_MAX_FIELDS];
+	DB_RESULT		result;
+	DB_ROW			row;
+	md5_state_t		state;
+	zbx_uint64_t		fields_digest, *digests;
+	zbx_uint64_pair_t	pair;
+	zbx_vector_uint64_pair_t	rows;
+
+	zbx_vector_uint64_pair_create(&rows);
+	sql = (char *)zbx_malloc(sql, sql_alloc);
+
+	zbx_md5_init(&state);
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "select %s", table->recid);
+	proxyconfig_digest_add(&state, table->recid);
+	local[0] = 0;
+
+	for (f = 0; 0 != table->fields[f].name; f++)
+	{
+		if (0 == (table->fields[f].flags & ZBX_PROXY))
+			continue;
+
+		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ',');
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, table->fields[f].name);
+
+		if (SUCCEED == proxyconfig_is_local_field(table->table, table->fields[f].name))
+		{
+			local[fields_num++] = 1;
+			continue;
+		}
+
+		local[fields_num++] = 0;
+		proxyconfig_digest_add(&state, table->fields[f].name);
+	}
+
+	fields_digest = proxyconfig_digest_get(&state);
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " from %s", table->table);
+
+	result = DBselect("%s", sql);
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		ZBX_STR2UINT64(pair.first, row[0]);
+
+		zbx_md5_init(&state);
+
+		for (i = 0; i < fields_num; i++)
+		{
+			if (0 == local[i])
+				proxyconfig_digest_add(&state, SUCCEED == DBis_null(row[i]) ? NULL : row[i]);
+		}
+
+		pair.second = proxyconfig_digest_get(&state);
+		zbx_vector_uint64_pair_append(&rows, pair);
+	}
+	DBfree_result(result);
+
+	if (ZBX_PROXYCONFIG_BUCKETS_MAX < (buckets_num = rows.values_num / ZBX_PROXYCONFIG_BUCKET_ROWS + 1))
+		buckets_num = ZBX_PROXYCONFIG_BUCKETS_MAX;
+
+	digests = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)buckets_num);
+
+	for (i = 0; i < buckets_num; i++)
+		digests[i] = fields_digest;
+
+	for (i = 0; i < rows.values_num; i++)
+		digests[rows.values[i].first % (zbx_uint64_t)buckets_num] += rows.values[i].second;
+
+	zbx_json_addobject(j, table->table);
+	zbx_json_adduint64(j, ZBX_PROTO_TAG_BUCKETS, (zbx_uint64_t)buckets_num);
+	zbx_json_addarray(j, ZBX_PROTO_TAG_DIGESTS);
+
+	for (i = 0; i < buckets_num; i++)
+		zbx_json_adduint64(j, NULL, digests[i]);
+
+	zbx_json_close(j);
+	zbx_json_close(j);
+
+	zbx_free(digests);
+	zbx_free(sql);
+	zbx_vector_uint64_pair_destroy(&rows);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_proxyconfig_revision                                         *
+ *                                                                            *
+ * Purpose: add revision of the configuration applied by proxy to the proxy   *
+ *          configuration request                                             *
+ *                                                                            *
+ * Parameters: j - [OUT] the output json                                      *
+ *                                                                            *
+ * Comments: The revision is calculated from the proxy database contents, so  *
+ *           any difference from server data (including failed updates)       *
+ *           results in the affected rows being sent again.                   *
+ *                                                                            *
+ ******************************************************************************/
+void	get_proxyconfig_revision(struct zbx_json *j)
+{
+	int	i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_json_addobject(j, ZBX_PROTO_TAG_CONFIG_REVISION);
+
+	for (i = 0; NULL != proxyconfig_tables[i]; i++)
+		get_proxyconfig_table_revision(j, DBget_table(proxyconfig_tables[i]));
+
+	zbx_json_close(j);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: remember_record                                                  *
@@ -1370,11 +1827,12 @@ static int	process_proxyconfig_table(const ZBX_TABLE *table, struct zbx_json_par
 		zbx_vector_uint64_t *del, char **error)
 {
 	int			f, fields_count, ret = FAIL, id_field_nr = 0, move_out = 0,
-				move_field_nr = 0;
+				move_field_nr = 0, buckets_num = 0;
 	const ZBX_FIELD		*fields[ZBX_MAX_FIELDS];
 	struct zbx_json_parse	jp_data, jp_row;
 	const char		*p, *pf;
-	zbx_uint64_t		recid, *p_recid = NULL;
+	zbx_uint64_t		recid, *p_recid = NULL, bucket;
+	unsigned char		*changed = NULL;
 	zbx_vector_uint64_t	ins, moves, availability_hostids;
 	char			*buf = NULL, *esc, *sql = NULL, *recs = NULL;
 	size_t			sql_alloc = 4 * ZBX_KIBIBYTE, sql_offset,
@@ -1480,6 +1938,31 @@ static int	process_proxyconfig_table(const ZBX_TABLE *table, struct zbx_json_par
 		goto out;
 	}
 
+	/* get the changed buckets if only the changes since proxy configuration revision are received */
+	if (SUCCEED == zbx_json_value_by_name_dyn(jp_obj, ZBX_PROTO_TAG_BUCKETS, &buf, &buf_alloc, NULL))
+	{
+		if (SUCCEED != is_uint_range(buf, &buckets_num, 1, ZBX_PROXYCONFIG_BUCKETS_MAX) ||
+				FAIL == zbx_json_brackets_by_name(jp_obj, ZBX_PROTO_TAG_CHANGED, &jp_data))
+		{
+			*error = zbx_dsprintf(*error, "invalid revision buckets of table \"%s\"", table->table);
+			goto out;
+		}
+
+		changed = (unsigned char *)zbx_calloc(NULL, (size_t)buckets_num, 1);
+
+		for (p = NULL; NULL != (p = zbx_json_next_value_dyn(&jp_data, p, &buf, &buf_alloc, NULL));)
+		{
+			if (SUCCEED != is_uint64(buf, &bucket) || bucket >= (zbx_uint64_t)buckets_num)
+			{
+				*error = zbx_dsprintf(*error, "invalid revision bucket \"%s\" of table \"%s\"", buf,
+						table->table);
+				goto out;
+			}
+
+			changed[bucket] = 1;
+		}
+	}
+
 	/* get the entries (line 8 in T1) */
 	if (FAIL == zbx_json_brackets_by_name(jp_obj, ZBX_PROTO_TAG_DATA, &jp_data))
 	{
@@ -1522,6 +2005,10 @@ static int	process_proxyconfig_table(const ZBX_TABLE *table, struct zbx_json_par
 	{
 		ZBX_STR2UINT64(recid, row[id_field_nr]);
 
+		/* records of unchanged buckets are neither received nor must be removed */
+		if (NULL != changed && 0 == changed[recid % (zbx_uint64_t)buckets_num])
+			continue;
+
 		id_offset.id = recid;
 		id_offset.offset = recs_offset;
 
@@ -1987,6 +2474,7 @@ clean2:
 	zbx_free(sql);
 	zbx_free(recs);
 out:
+	zbx_free(changed);
 	zbx_free(buf);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
@@ -2381,6 +2869,17 @@ static void	proxy_set_lastid(const char *table_name, const char *lastidfield, co
 
 void	proxy_set_hist_lastid(const zbx_uint64_t lastid)
 {
+	if (SUCCEED == zbx_pb_enabled())
+	{
+		zbx_pb_set_valueid(history_valueid);
+
+		if (ZBX_PROXY_HISTORY_BUFFER == history_source)
+		{
+			zbx_pb_history_set_lastid(lastid);
+			return;
+		}
+	}
+
 	proxy_set_lastid("proxy_history", "history_lastid", lastid);
 }
 
@@ -2403,6 +2902,12 @@ int	proxy_get_delay(const zbx_uint64_t lastid)
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() [lastid=" ZBX_FS_UI64 "]", __func__, lastid);
 
+	if (SUCCEED == zbx_pb_enabled() && ZBX_PROXY_HISTORY_BUFFER == history_source)
+	{
+		ts = zbx_pb_history_get_delay(lastid);
+		goto out;
+	}
+
 	sql = zbx_dsprintf(sql, "select write_clock from proxy_history where id>" ZBX_FS_UI64 " order by id asc",
 			lastid);
 
@@ -2413,7 +2918,7 @@ int	proxy_get_delay(const zbx_uint64_t lastid)
 		ts = (int)time(NULL) - atoi(row[0]);
 
 	DBfree_result(result);
-
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
 	return ts;
@@ -2529,6 +3034,42 @@ typedef struct
 }
 zbx_history_data_t;
 
+typedef int (*zbx_get_history_data_func_t)(zbx_uint64_t lastid, zbx_history_data_t **data, size_t *data_alloc,
+		char **string_buffer, size_t *string_buffer_alloc, int *more);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_history_data_add_strings                                   *
+ *                                                                            *
+ * Purpose: copy log source and value of proxy history record to the string  *
+ *          buffer                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_history_data_add_strings(zbx_history_data_t *hd, const char *source, const char *value,
+		char **string_buffer, size_t *string_buffer_alloc, size_t *string_buffer_offset)
+{
+	size_t	len1, len2;
+
+	len1 = strlen(source) + 1;
+	len2 = strlen(value) + 1;
+
+	if (*string_buffer_alloc < *string_buffer_offset + len1 + len2)
+	{
+		while (*string_buffer_alloc < *string_buffer_offset + len1 + len2)
+			*string_buffer_alloc += ZBX_KIBIBYTE;
+
+		*string_buffer = (char *)zbx_realloc(*string_buffer, *string_buffer_alloc);
+	}
+
+	hd->source_offset = *string_buffer_offset;
+	memcpy(*string_buffer + hd->source_offset, source, len1);
+	*string_buffer_offset += len1;
+
+	hd->value_offset = *string_buffer_offset;
+	memcpy(*string_buffer + hd->value_offset, value, len2);
+	*string_buffer_offset += len2;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: proxy_get_history_data                                           *
@@ -2547,6 +3088,8 @@ zbx_history_data_t;
  *                                                                            *
  * Return value: The number of records read.                                  *
  *                                                                            *
+ * Comments: Records after history_maxid are not read if it is set.           *
+ *                                                                            *
  ******************************************************************************/
 static int	proxy_get_history_data(zbx_uint64_t lastid, zbx_history_data_t **data, size_t *data_alloc,
 		char **string_buffer, size_t *string_buffer_alloc, int *more)
@@ -2569,10 +3112,14 @@ try_again:
 			"select id,itemid,clock,ns,timestamp,source,severity,"
 				"value,logeventid,state,lastlogsize,mtime,flags"
 			" from proxy_history"
-			" where id>" ZBX_FS_UI64
-			" order by id",
+			" where id>" ZBX_FS_UI64,
 			lastid);
 
+	if (0 != history_maxid)
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and id<=" ZBX_FS_UI64, history_maxid);
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " order by id");
+
 	result = DBselectN(sql, ZBX_MAX_HRECORDS - data_num);
 
 	zbx_free(sql);
@@ -2628,30 +3175,12 @@ try_again:
 
 			if (0 == (hd->flags & PROXY_HISTORY_FLAG_NOVALUE))
 			{
-				size_t	len1, len2;
-
 				hd->timestamp = atoi(row[4]);
 				hd->severity = atoi(row[6]);
 				hd->logeventid = atoi(row[8]);
 
-				len1 = strlen(row[5]) + 1;
-				len2 = strlen(row[7]) + 1;
-
-				if (*string_buffer_alloc < string_buffer_offset + len1 + len2)
-				{
-					while (*string_buffer_alloc < string_buffer_offset + len1 + len2)
-						*string_buffer_alloc += ZBX_KIBIBYTE;
-
-					*string_buffer = (char *)zbx_realloc(*string_buffer, *string_buffer_alloc);
-				}
-
-				hd->source_offset = string_buffer_offset;
-				memcpy(*string_buffer + hd->source_offset, row[5], len1);
-				string_buffer_offset += len1;
-
-				hd->value_offset = string_buffer_offset;
-				memcpy(*string_buffer + hd->value_offset, row[7], len2);
-				string_buffer_offset += len2;
+				proxy_history_data_add_strings(hd, row[5], row[7], string_buffer, string_buffer_alloc,
+						&string_buffer_offset);
 			}
 
 			if (0 != (hd->flags & PROXY_HISTORY_FLAG_META))
@@ -2673,6 +3202,88 @@ try_again:
 	return data_num;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_get_history_buffer_data                                    *
+ *                                                                            *
+ * Purpose: read proxy history data from the proxy history buffer             *
+ *                                                                            *
+ * Parameters: lastid             - [IN] the buffer position after the last   *
+ *                                       processed record, 0 - start from the *
+ *                                       first record not sent to server      *
+ *             data               - [IN/OUT] the proxy history data buffer    *
+ *             data_alloc         - [IN/OUT] the size of proxy history data   *
+ *                                           buffer                           *
+ *             string_buffer      - [IN/OUT] the string buffer                *
+ *             string_buffer_size - [IN/OUT] the size of string buffer        *
+ *             more               - [OUT] set to ZBX_PROXY_DATA_MORE if there *
+ *                                        might be more data to read          *
+ *                                                                            *
+ * Return value: The number of records read.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	proxy_get_history_buffer_data(zbx_uint64_t lastid, zbx_history_data_t **data, size_t *data_alloc,
+		char **string_buffer, size_t *string_buffer_alloc, int *more)
+{
+	int			i, values_num;
+	size_t			string_buffer_offset = 0;
+	zbx_pb_history_t	*values;
+	zbx_history_data_t	*hd;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() lastid:" ZBX_FS_UI64, __func__, lastid);
+
+	values = (zbx_pb_history_t *)zbx_malloc(NULL, sizeof(zbx_pb_history_t) * ZBX_MAX_HRECORDS);
+	values_num = zbx_pb_history_get(lastid, values, ZBX_MAX_HRECORDS);
+
+	if (*data_alloc < (size_t)values_num)
+	{
+		*data_alloc = (size_t)values_num;
+		*data = (zbx_history_data_t *)zbx_realloc(*data, sizeof(zbx_history_data_t) * *data_alloc);
+	}
+
+	for (i = 0; i < values_num; i++)
+	{
+		const zbx_pb_history_t	*value = &values[i];
+
+		hd = *data + i;
+		hd->id = value->id;
+		hd->itemid = value->itemid;
+		hd->flags = value->flags;
+		hd->clock = value->clock;
+		hd->ns = value->ns;
+
+		if (PROXY_HISTORY_FLAG_NOVALUE != (hd->flags & PROXY_HISTORY_MASK_NOVALUE))
+		{
+			hd->state = value->state;
+
+			if (0 == (hd->flags & PROXY_HISTORY_FLAG_NOVALUE))
+			{
+				hd->timestamp = value->timestamp;
+				hd->severity = value->severity;
+				hd->logeventid = value->logeventid;
+
+				proxy_history_data_add_strings(hd, value->source, value->value, string_buffer,
+						string_buffer_alloc, &string_buffer_offset);
+			}
+
+			if (0 != (hd->flags & PROXY_HISTORY_FLAG_META))
+			{
+				hd->lastlogsize = value->lastlogsize;
+				hd->mtime = value->mtime;
+			}
+		}
+	}
+
+	zbx_free(values);
+
+	if (ZBX_MAX_HRECORDS != values_num)
+		*more = ZBX_PROXY_DATA_DONE;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() values_num:%d", __func__, values_num);
+
+	return values_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: proxy_add_hist_data                                              *
@@ -2686,12 +3297,14 @@ try_again:
  *             records       - [IN] the records to add                        *
  *             string_buffer - [IN] the string buffer holding string values   *
  *             lastid        - [OUT] the id of last added record              *
+ *             valueid       - [IN/OUT] the last value identifier sent to     *
+ *                                      server, NULL - record ids are sent    *
  *                                                                            *
  * Return value: The total number of records added.                           *
  *                                                                            *
  ******************************************************************************/
 static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const DC_ITEM *dc_items, const int *errcodes,
-		const zbx_vector_ptr_t *records, const char *string_buffer, zbx_uint64_t *lastid)
+		const zbx_vector_ptr_t *records, const char *string_buffer, zbx_uint64_t *lastid, zbx_uint64_t *valueid)
 {
 	int				i;
 	const zbx_history_data_t	*hd;
@@ -2720,7 +3333,7 @@ static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const DC_ITE
 			zbx_json_addarray(j, ZBX_PROTO_TAG_HISTORY_DATA);
 
 		zbx_json_addobject(j, NULL);
-		zbx_json_adduint64(j, ZBX_PROTO_TAG_ID, hd->id);
+		zbx_json_adduint64(j, ZBX_PROTO_TAG_ID, NULL == valueid ? hd->id : ++(*valueid));
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_ITEMID, hd->itemid);
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_CLOCK, hd->clock);
 		zbx_json_adduint64(j, ZBX_PROTO_TAG_NS, hd->ns);
@@ -2769,17 +3382,49 @@ static int	proxy_add_hist_data(struct zbx_json *j, int records_num, const DC_ITE
 	return records_num;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: proxy_reset_history_overflow                                     *
+ *                                                                            *
+ * Purpose: switches history writing back to proxy history buffer when there  *
+ *          is room for it                                                    *
+ *                                                                            *
+ * Comments: The last history id is read after all history syncers writing to *
+ *           database have committed, so it covers all history written to     *
+ *           database before the switch.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	proxy_reset_history_overflow(void)
+{
+	DB_RESULT	result;
+	DB_ROW		row;
+	zbx_uint64_t	db_batches, maxid = 0;
+
+	if (SUCCEED != zbx_pb_history_check_overflow(&db_batches))
+		return;
+
+	result = DBselect("select max(id) from proxy_history");
+
+	if (NULL != (row = DBfetch(result)) && SUCCEED != DBis_null(row[0]))
+		ZBX_STR2UINT64(maxid, row[0]);
+
+	DBfree_result(result);
+
+	zbx_pb_history_reset_overflow(db_batches, maxid);
+}
+
 int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 {
-	int			records_num = 0, data_num, i, *errcodes = NULL, items_alloc = 0;
-	zbx_uint64_t		id;
-	zbx_hashset_t		itemids_added;
-	zbx_history_data_t	*data;
-	char			*string_buffer;
-	size_t			data_alloc = 16, string_buffer_alloc = ZBX_KIBIBYTE;
-	zbx_vector_uint64_t	itemids;
-	zbx_vector_ptr_t	records;
-	DC_ITEM			*dc_items = 0;
+	int				records_num = 0, data_num, i, *errcodes = NULL, items_alloc = 0, read_num = 0;
+	zbx_uint64_t			id, valueid = 0, *pvalueid = NULL;
+	zbx_hashset_t			itemids_added;
+	zbx_history_data_t		*data;
+	char				*string_buffer;
+	size_t				data_alloc = 16, string_buffer_alloc = ZBX_KIBIBYTE;
+	zbx_vector_uint64_t		itemids;
+	zbx_vector_ptr_t		records;
+	DC_ITEM				*dc_items = 0;
+	zbx_get_history_data_func_t	get_history_data;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -2789,7 +3434,30 @@ int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 	string_buffer = (char *)zbx_malloc(NULL, string_buffer_alloc);
 
 	*more = ZBX_PROXY_DATA_MORE;
-	proxy_get_lastid("proxy_history", "history_lastid", &id);
+
+	history_maxid = 0;
+
+	if (SUCCEED == zbx_pb_enabled())
+	{
+		/* value identifiers must grow across buffer and database history sent within the same session */
+		valueid = zbx_pb_get_valueid();
+		pvalueid = &valueid;
+
+		proxy_reset_history_overflow();
+	}
+
+	if (NULL != pvalueid && SUCCEED == zbx_pb_history_get_source(&history_maxid))
+	{
+		history_source = ZBX_PROXY_HISTORY_BUFFER;
+		get_history_data = proxy_get_history_buffer_data;
+		id = 0;
+	}
+	else
+	{
+		history_source = ZBX_PROXY_HISTORY_DATABASE;
+		get_history_data = proxy_get_history_data;
+		proxy_get_lastid("proxy_history", "history_lastid", &id);
+	}
 
 	zbx_hashset_create(&itemids_added, data_alloc, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
@@ -2798,9 +3466,11 @@ int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 	/*   2) we have retrieved more than the total maximum number of records */
 	/*   3) we have gathered more than half of the maximum packet size      */
 	while (ZBX_DATA_JSON_BATCH_LIMIT > j->buffer_offset && ZBX_MAX_HRECORDS_TOTAL > records_num &&
-			0 != (data_num = proxy_get_history_data(id, &data, &data_alloc, &string_buffer,
+			0 != (data_num = get_history_data(id, &data, &data_alloc, &string_buffer,
 					&string_buffer_alloc, more)))
 	{
+		read_num += data_num;
+
 		zbx_vector_uint64_reserve(&itemids, data_num);
 		zbx_vector_ptr_reserve(&records, data_num);
 
@@ -2830,7 +3500,8 @@ int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 
 		DCconfig_get_items_by_itemids(dc_items, itemids.values, errcodes, itemids.values_num);
 
-		records_num = proxy_add_hist_data(j, records_num, dc_items, errcodes, &records, string_buffer, lastid);
+		records_num = proxy_add_hist_data(j, records_num, dc_items, errcodes, &records, string_buffer, lastid,
+				pvalueid);
 		DCconfig_clean_items(dc_items, errcodes, itemids.values_num);
 
 		/* got less data than requested - either no more data to read or the history is full of */
@@ -2847,6 +3518,15 @@ int	proxy_get_hist_data(struct zbx_json *j, zbx_uint64_t *lastid, int *more)
 	if (0 != records_num)
 		zbx_json_close(j);
 
+	if (NULL != pvalueid)
+	{
+		history_valueid = valueid;
+
+		/* database history written before switching back to buffer has been sent */
+		if (ZBX_PROXY_HISTORY_DATABASE == history_source && 0 != history_maxid && 0 == read_num)
+			zbx_pb_history_set_db_sent();
+	}
+
 	zbx_hashset_destroy(&itemids_added);
 
 	zbx_free(dc_items);
@@ -4611,7 +5291,7 @@ int	proxy_get_history_count(void)
 
 	DBfree_result(result);
 
-	return count;
+	return count + (int)zbx_pb_history_count();
 }
 
 /******************************************************************************
@@ -5074,3 +5754,7 @@ int	zbx_check_protocol_version(DC_PROXY *proxy, int version)
 out:
 	return ret;
 }
+
+#ifdef HAVE_TESTS
+#	include "../../../tests/libs/zbxdbhigh/proxyconfig_add_table_changes_test.c"
+#endif
@@ -782,7 +782,7 @@ extern zbx_dbpatch_t	DBPATCH_VERSION(4050)[];
 extern zbx_dbpatch_t	DBPATCH_VERSION(5000)[];
 extern zbx_dbpatch_t	DBPATCH_VERSION(5010)[];
 extern zbx_dbpatch_t	DBPATCH_VERSION(5020)[];
-/*extern zbx_dbpatch_t	DBPATCH_VERSION(5030)[];*/
+extern zbx_dbpatch_t	DBPATCH_VERSION(5030)[];
 
 static zbx_db_version_t dbversions[] = {
 	{DBPATCH_VERSION(2010), "2.2 development"},
@@ -805,7 +805,7 @@ static zbx_db_version_t dbversions[] = {
 	{DBPATCH_VERSION(5000), "5.0 maintenance"},
 	{DBPATCH_VERSION(5010), "5.2 development"},
 	{DBPATCH_VERSION(5020), "5.2 maintenance"},
-/*	{DBPATCH_VERSION(5030), "5.4 development"},*/
+	{DBPATCH_VERSION(5030), "5.4 development"},
 	{NULL}
 };
 
@@ -19,6 +19,7 @@
 
 #include "common.h"
 #include "db.h"
+#include "log.h"
 #include "dbupgrade.h"
 
 /*
@@ -29,10 +30,343 @@
 
 extern unsigned char	program_type;
 
-/*static int	DBpatch_5030000(void)
+static int	DBpatch_5030000(void)
 {
-	*** put the first upgrade patch here ***
-}*/
+#if defined(HAVE_MYSQL)
+	if (ZBX_DB_OK > DBexecute(
+			"create table changelog ("
+				"changelogid bigint unsigned not null auto_increment,"
+				"object integer default '0' not null,"
+				"objectid bigint unsigned not null,"
+				"operation integer default '0' not null,"
+				"clock integer default '0' not null,"
+				"primary key (changelogid)"
+			") engine=innodb"))
+	{
+		return FAIL;
+	}
+#elif defined(HAVE_POSTGRESQL)
+	if (ZBX_DB_OK > DBexecute(
+			"create table changelog ("
+				"changelogid bigserial not null,"
+				"object integer default '0' not null,"
+				"objectid bigint not null,"
+				"operation integer default '0' not null,"
+				"clock integer default '0' not null,"
+				"primary key (changelogid)"
+			")"))
+	{
+		return FAIL;
+	}
+#elif defined(HAVE_ORACLE)
+	if (ZBX_DB_OK > DBexecute(
+			"create table changelog ("
+				"changelogid number(20) not null,"
+				"object number(10) default '0' not null,"
+				"objectid number(20) not null,"
+				"operation number(10) default '0' not null,"
+				"clock number(10) default '0' not null,"
+				"primary key (changelogid)"
+			")"))
+	{
+		return FAIL;
+	}
+
+	if (ZBX_DB_OK > DBexecute("create sequence changelog_seq start with 1 increment by 1 nomaxvalue"))
+		return FAIL;
+
+	if (ZBX_DB_OK > DBexecute(
+			"create trigger changelog_tr"
+			" before insert on changelog"
+			" for each row"
+			" begin"
+				" select changelog_seq.nextval into :new.changelogid from dual;"
+			" end;"))
+	{
+		return FAIL;
+	}
+#endif
+	return SUCCEED;
+}
+
+static int	DBpatch_5030001(void)
+{
+	return DBcreate_index("changelog", "changelog_1", "clock", 0);
+}
+
+#if defined(HAVE_MYSQL)
+/******************************************************************************
+ *                                                                            *
+ * Function: DBpatch_5030002_triggers_allowed                                 *
+ *                                                                            *
+ * Purpose: checks if database user can create triggers                       *
+ *                                                                            *
+ * Return value: SUCCEED - triggers can be created                            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: With binary logging enabled MySQL requires SUPER privilege to    *
+ *           create triggers unless log_bin_trust_function_creators is set.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	DBpatch_5030002_triggers_allowed(void)
+{
+	DB_RESULT	result;
+	DB_ROW		row;
+	int		ret = FAIL;
+
+	result = DBselect("select @@log_bin,@@log_bin_trust_function_creators");
+
+	if (NULL != (row = DBfetch(result)) && (0 == atoi(row[0]) || 0 != atoi(row[1])))
+		ret = SUCCEED;
+
+	DBfree_result(result);
+
+	if (SUCCEED == ret)
+		return SUCCEED;
+
+	result = DBselect(
+			"select 1"
+			" from information_schema.user_privileges"
+			" where privilege_type='SUPER'"
+				" and grantee=concat('''',replace(current_user(),'@','''@'''),'''')");
+
+	if (NULL != DBfetch(result))
+		ret = SUCCEED;
+
+	DBfree_result(result);
+
+	return ret;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DBpatch_5030002_add_changelog_triggers                           *
+ *                                                                            *
+ * Purpose: creates insert, update and delete triggers recording changes of   *
+ *          the specified table in changelog                                  *
+ *                                                                            *
+ * Parameters: table  - [IN] the table name                                   *
+ *             field  - [IN] the table primary key field                      *
+ *             object - [IN] the changelog object type                        *
+ *                                                                            *
+ * Return value: SUCCEED - the triggers were created successfully or cannot  *
+ *                         be created by database user                        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Without triggers configuration cache is synchronized by          *
+ *           comparing whole tables.                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	DBpatch_5030002_add_changelog_triggers(const char *table, const char *field, int object)
+{
+	const char	*operations[] = {"insert", "update", "delete"};
+	int		i, ret = SUCCEED;
+	char		*sql = NULL;
+	size_t		sql_alloc = 0, sql_offset;
+
+#if defined(HAVE_MYSQL)
+	if (SUCCEED != DBpatch_5030002_triggers_allowed())
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot create changelog triggers on table \"%s\": SUPER privilege or"
+				" log_bin_trust_function_creators is required with binary logging enabled", table);
+		return SUCCEED;
+	}
+#endif
+
+	for (i = 0; i < (int)ARRSIZE(operations) && SUCCEED == ret; i++)
+	{
+		const char	*row = (2 == i ? "old" : "new");
+
+		sql_offset = 0;
+#if defined(HAVE_MYSQL)
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				"create trigger %s_%s after %s on %s"
+				" for each row"
+				" insert into changelog (object,objectid,operation,clock)"
+				" values (%d,%s.%s,%d,unix_timestamp())",
+				table, operations[i], operations[i], table, object, row, field, i + 1);
+#elif defined(HAVE_POSTGRESQL)
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				"create function changelog_%s_%s() returns trigger language plpgsql as $$"
+				" begin"
+					" insert into changelog (object,objectid,operation,clock)"
+					" values (%d,%s.%s,%d,cast(extract(epoch from now()) as int));"
+					" return null;"
+				" end $$",
+				table, operations[i], object, row, field, i + 1);
+
+		if (ZBX_DB_OK > DBexecute("%s", sql))
+		{
+			ret = FAIL;
+			break;
+		}
+
+		sql_offset = 0;
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				"create trigger %s_%s after %s on %s"
+				" for each row execute procedure changelog_%s_%s()",
+				table, operations[i], operations[i], table, table, operations[i]);
+#elif defined(HAVE_ORACLE)
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+				"create trigger %s_%s after %s on %s"
+				" for each row"
+				" begin"
+					" insert into changelog (object,objectid,operation,clock)"
+					" values (%d,:%s.%s,%d,"
+						"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);"
+				" end;",
+				table, operations[i], operations[i], table, object, row, field, i + 1);
+#endif
+		if (ZBX_DB_OK > DBexecute("%s", sql))
+			ret = FAIL;
+	}
+
+	zbx_free(sql);
+
+	return ret;
+}
+
+static int	DBpatch_5030002(void)
+{
+	return DBpatch_5030002_add_changelog_triggers("hosts", "hostid", 1);
+}
+
+static int	DBpatch_5030003(void)
+{
+	return DBpatch_5030002_add_changelog_triggers("items", "itemid", 2);
+}
+
+static int	DBpatch_5030004(void)
+{
+	return DBpatch_5030002_add_changelog_triggers("triggers", "triggerid", 3);
+}
+
+static int	DBpatch_5030005(void)
+{
+	return DBpatch_5030002_add_changelog_triggers("functions", "functionid", 4);
+}
+
+static int	DBpatch_5030006(void)
+{
+	return DBpatch_5030002_add_changelog_triggers("item_preproc", "item_preprocid", 5);
+}
+
+static int	DBpatch_5030007(void)
+{
+	const ZBX_FIELD	field = {"trends_owned_from", "0", NULL, NULL, 0, ZBX_TYPE_INT, ZBX_NOTNULL, 0};
+
+	return DBadd_field("config", &field);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DBpatch_5030008_update_changelog_trigger                         *
+ *                                                                            *
+ * Purpose: recreates update trigger to record in changelog only changes of   *
+ *          the specified configuration fields                                *
+ *                                                                            *
+ * Parameters: table  - [IN] the table name                                   *
+ *             field  - [IN] the table primary key field                      *
+ *             object - [IN] the changelog object type                        *
+ *             fields - [IN] the configuration fields, NULL terminated        *
+ *                                                                            *
+ * Return value: SUCCEED - the trigger was recreated or does not exist        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Runtime fields (host availability, trigger value and state) are  *
+ *           updated by server itself and must not cause resynchronization.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	DBpatch_5030008_update_changelog_trigger(const char *table, const char *field, int object,
+		const char **fields)
+{
+	char	name[ZBX_TABLENAME_LEN + 8], *sql = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	i, ret = FAIL;
+
+	zbx_snprintf(name, sizeof(name), "%s_update", table);
+
+	/* the triggers are not created if database user lacks privileges */
+	if (SUCCEED != DBtrigger_exists(table, name))
+		return SUCCEED;
+
+#if defined(HAVE_MYSQL)
+	/* MySQL has no column list for update triggers, so old and new rows are compared instead */
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"create trigger %s after update on %s"
+			" for each row"
+			" insert into changelog (object,objectid,operation,clock)"
+			" select %d,new.%s,2,unix_timestamp() from dual"
+			" where not (",
+			name, table, object, field);
+
+	for (i = 0; NULL != fields[i]; i++)
+	{
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%sold.%s<=>new.%s", 0 == i ? "" : " and ",
+				fields[i], fields[i]);
+	}
+
+	zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
+
+	if (ZBX_DB_OK > DBexecute("drop trigger %s", name))
+		goto out;
+#else
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "create trigger %s after update of ", name);
+
+	for (i = 0; NULL != fields[i]; i++)
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%s%s", 0 == i ? "" : ",", fields[i]);
+#	if defined(HAVE_POSTGRESQL)
+	ZBX_UNUSED(field);
+	ZBX_UNUSED(object);
+
+	/* the trigger function recording changes is kept */
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " on %s for each row execute procedure changelog_%s()",
+			table, name);
+
+	if (ZBX_DB_OK > DBexecute("drop trigger %s on %s", name, table))
+		goto out;
+#	elif defined(HAVE_ORACLE)
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			" on %s"
+			" for each row"
+			" begin"
+				" insert into changelog (object,objectid,operation,clock)"
+				" values (%d,:new.%s,2,"
+					"(cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400);"
+			" end;",
+			table, object, field);
+
+	if (ZBX_DB_OK > DBexecute("drop trigger %s", name))
+		goto out;
+#	endif
+#endif
+	if (ZBX_DB_OK <= DBexecute("%s", sql))
+		ret = SUCCEED;
+out:
+	zbx_free(sql);
+
+	return ret;
+}
+
+static int	DBpatch_5030008(void)
+{
+	const char	*fields[] = {"proxy_hostid", "host", "status", "ipmi_authtype", "ipmi_privilege",
+				"ipmi_username", "ipmi_password", "name", "flags", "templateid", "description",
+				"tls_connect", "tls_accept", "tls_issuer", "tls_subject", "tls_psk_identity", "tls_psk",
+				"proxy_address", "auto_compress", "discover", "custom_interfaces", NULL};
+
+	return DBpatch_5030008_update_changelog_trigger("hosts", "hostid", 1, fields);
+}
+
+static int	DBpatch_5030009(void)
+{
+	const char	*fields[] = {"expression", "description", "url", "status", "priority", "comments",
+				"templateid", "type", "flags", "recovery_mode", "recovery_expression", "correlation_mode",
+				"correlation_tag", "manual_close", "opdata", "discover", "event_name", NULL};
+
+	return DBpatch_5030008_update_changelog_trigger("triggers", "triggerid", 3, fields);
+}
 
 #endif
 
@@ -40,6 +374,15 @@ DBPATCH_START(5030)
 
 /* version, duplicates flag, mandatory flag */
 
-/*DBPATCH_ADD(5030000, 0, 1)*/
+DBPATCH_ADD(5030000, 0, 0)
+DBPATCH_ADD(5030001, 0, 0)
+DBPATCH_ADD(5030002, 0, 0)
+DBPATCH_ADD(5030003, 0, 0)
+DBPATCH_ADD(5030004, 0, 0)
+DBPATCH_ADD(5030005, 0, 0)
+DBPATCH_ADD(5030006, 0, 0)
+DBPATCH_ADD(5030007, 0, 1)
+DBPATCH_ADD(5030008, 0, 0)
+DBPATCH_ADD(5030009, 0, 0)
 
 DBPATCH_END()
@@ -399,9 +399,11 @@ int	diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json
 	double			time1, time2, time_total = 0;
 	zbx_uint64_t		fields;
 	zbx_diag_map_t		field_map[] = {
-					{"", ZBX_DIAG_PREPROC_VALUES | ZBX_DIAG_PREPROC_VALUES_PREPROC},
+					{"", ZBX_DIAG_PREPROC_SIMPLE},
 					{"values", ZBX_DIAG_PREPROC_VALUES},
 					{"preproc.values", ZBX_DIAG_PREPROC_VALUES_PREPROC},
+					{"regexp.hits", ZBX_DIAG_PREPROC_REGEXP_HITS},
+					{"regexp.misses", ZBX_DIAG_PREPROC_REGEXP_MISSES},
 					{NULL, 0}
 					};
 
@@ -413,11 +415,15 @@ int	diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json
 
 		if (0 != (fields & ZBX_DIAG_PREPROC_SIMPLE))
 		{
-			int	values_num, values_preproc_num;
+			int		values_num, values_preproc_num;
+			zbx_uint64_t	regexp_hits, regexp_misses;
 
 			time1 = zbx_time();
-			if (FAIL == (ret = zbx_preprocessor_get_diag_stats(&values_num, &values_preproc_num, error)))
+			if (FAIL == (ret = zbx_preprocessor_get_diag_stats(&values_num, &values_preproc_num,
+					&regexp_hits, &regexp_misses, error)))
+			{
 				goto out;
+			}
 
 			time2 = zbx_time();
 			time_total += time2 - time1;
@@ -426,6 +432,10 @@ int	diag_add_preproc_info(const struct zbx_json_parse *jp, struct zbx_json *json
 				zbx_json_addint64(json, "values", values_num);
 			if (0 != (fields & ZBX_DIAG_PREPROC_VALUES_PREPROC))
 				zbx_json_addint64(json, "preproc.values", values_preproc_num);
+			if (0 != (fields & ZBX_DIAG_PREPROC_REGEXP_HITS))
+				zbx_json_adduint64(json, "regexp.hits", regexp_hits);
+			if (0 != (fields & ZBX_DIAG_PREPROC_REGEXP_MISSES))
+				zbx_json_adduint64(json, "regexp.misses", regexp_misses);
 		}
 
 		if (0 != tops.values_num)
@@ -502,13 +512,21 @@ void	diag_add_locks_info(struct zbx_json *json)
 				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
 				"ZBX_MUTEX_ITSERVICES", "ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_KSTAT", "ZBX_MUTEX_MODBUS",
-				"ZBX_MUTEX_TREND_FUNC"};
+				"ZBX_MUTEX_TREND_FUNC", "ZBX_MUTEX_HISTORY_STORAGE", "ZBX_MUTEX_PROXY_BUFFER",
+				"ZBX_MUTEX_CONFIG_EVAL", "ZBX_MUTEX_IPC_SHM",
+				"ZBX_MUTEX_CACHE_STRIPE_0", "ZBX_MUTEX_CACHE_STRIPE_1", "ZBX_MUTEX_CACHE_STRIPE_2",
+				"ZBX_MUTEX_CACHE_STRIPE_3", "ZBX_MUTEX_CACHE_STRIPE_4", "ZBX_MUTEX_CACHE_STRIPE_5",
+				"ZBX_MUTEX_CACHE_STRIPE_6", "ZBX_MUTEX_CACHE_STRIPE_7"};
 #else
 	const char	*names[ZBX_MUTEX_COUNT] = {"ZBX_MUTEX_LOG", "ZBX_MUTEX_CACHE", "ZBX_MUTEX_TRENDS",
 				"ZBX_MUTEX_CACHE_IDS", "ZBX_MUTEX_SELFMON", "ZBX_MUTEX_CPUSTATS", "ZBX_MUTEX_DISKSTATS",
 				"ZBX_MUTEX_ITSERVICES", "ZBX_MUTEX_VALUECACHE", "ZBX_MUTEX_VMWARE", "ZBX_MUTEX_SQLITE3",
 				"ZBX_MUTEX_PROCSTAT", "ZBX_MUTEX_PROXY_HISTORY", "ZBX_MUTEX_MODBUS",
-				"ZBX_MUTEX_TREND_FUNC"};
+				"ZBX_MUTEX_TREND_FUNC", "ZBX_MUTEX_HISTORY_STORAGE", "ZBX_MUTEX_PROXY_BUFFER",
+				"ZBX_MUTEX_CONFIG_EVAL", "ZBX_MUTEX_IPC_SHM",
+				"ZBX_MUTEX_CACHE_STRIPE_0", "ZBX_MUTEX_CACHE_STRIPE_1", "ZBX_MUTEX_CACHE_STRIPE_2",
+				"ZBX_MUTEX_CACHE_STRIPE_3", "ZBX_MUTEX_CACHE_STRIPE_4", "ZBX_MUTEX_CACHE_STRIPE_5",
+				"ZBX_MUTEX_CACHE_STRIPE_6", "ZBX_MUTEX_CACHE_STRIPE_7"};
 #endif
 	zbx_json_addarray(json, ZBX_DIAG_LOCKS);
 
@@ -629,6 +647,9 @@ static void	diag_prepare_default_request(struct zbx_json *j, unsigned int flags)
 
 	if (0 != (flags & (1 << ZBX_DIAGINFO_LOCKS)))
 		diag_add_section_request(j, ZBX_DIAG_LOCKS, NULL);
+
+	if (0 != (flags & (1 << ZBX_DIAGINFO_HISTORYSTORAGE)))
+		diag_add_section_request(j, ZBX_DIAG_HISTORYSTORAGE, NULL);
 }
 
 /******************************************************************************
@@ -876,6 +897,34 @@ static void	diag_log_alerting(struct zbx_json_parse *jp)
 	zabbix_log(LOG_LEVEL_INFORMATION, "==");
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: diag_log_history_storage                                         *
+ *                                                                            *
+ * Purpose: log history storage writer diagnostic information                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	diag_log_history_storage(struct zbx_json_parse *jp)
+{
+	char			*msg = NULL;
+	struct zbx_json_parse	jp_latency;
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "== history storage diagnostic information ==");
+
+	diag_get_simple_values(jp, &msg);
+	zabbix_log(LOG_LEVEL_INFORMATION, "%s", msg);
+	zbx_free(msg);
+
+	if (SUCCEED == zbx_json_brackets_by_name(jp, "latency", &jp_latency))
+	{
+		diag_get_simple_values(&jp_latency, &msg);
+		zabbix_log(LOG_LEVEL_INFORMATION, "latency: %s", msg);
+		zbx_free(msg);
+	}
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "==");
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_diag_log_info                                                *
@@ -930,6 +979,8 @@ void	zbx_diag_log_info(unsigned int flags)
 				diag_log_lld(&jp_section);
 			else if (0 == strcmp(section, ZBX_DIAG_ALERTING))
 				diag_log_alerting(&jp_section);
+			else if (0 == strcmp(section, ZBX_DIAG_HISTORYSTORAGE))
+				diag_log_history_storage(&jp_section);
 			else if (0 == strcmp(section, ZBX_DIAG_LOCKS))
 			{
 				zabbix_log(LOG_LEVEL_INFORMATION, "== locks diagnostic information ==");
@@ -51,9 +51,13 @@
 
 #define ZBX_DIAG_PREPROC_VALUES			0x00000001
 #define ZBX_DIAG_PREPROC_VALUES_PREPROC		0x00000002
+#define ZBX_DIAG_PREPROC_REGEXP_HITS		0x00000004
+#define ZBX_DIAG_PREPROC_REGEXP_MISSES		0x00000008
 
 #define ZBX_DIAG_PREPROC_SIMPLE		(ZBX_DIAG_PREPROC_VALUES | \
-					ZBX_DIAG_PREPROC_VALUES_PREPROC)
+					ZBX_DIAG_PREPROC_VALUES_PREPROC | \
+					ZBX_DIAG_PREPROC_REGEXP_HITS | \
+					ZBX_DIAG_PREPROC_REGEXP_MISSES)
 
 #define ZBX_DIAG_LLD_RULES		0x00000001
 #define ZBX_DIAG_LLD_VALUES		0x00000002
@@ -65,6 +69,22 @@
 
 #define ZBX_DIAG_ALERTING_SIMPLE	(ZBX_DIAG_ALERTING_ALERTS)
 
+#define ZBX_DIAG_HISTORYSTORAGE_REQUESTS	0x00000001
+#define ZBX_DIAG_HISTORYSTORAGE_VALUES		0x00000002
+#define ZBX_DIAG_HISTORYSTORAGE_BYTES		0x00000004
+#define ZBX_DIAG_HISTORYSTORAGE_RETRIED		0x00000008
+#define ZBX_DIAG_HISTORYSTORAGE_REJECTED	0x00000010
+#define ZBX_DIAG_HISTORYSTORAGE_THROTTLED	0x00000020
+#define ZBX_DIAG_HISTORYSTORAGE_LATENCY		0x00000040
+
+#define ZBX_DIAG_HISTORYSTORAGE_SIMPLE	(ZBX_DIAG_HISTORYSTORAGE_REQUESTS | \
+					ZBX_DIAG_HISTORYSTORAGE_VALUES | \
+					ZBX_DIAG_HISTORYSTORAGE_BYTES | \
+					ZBX_DIAG_HISTORYSTORAGE_RETRIED | \
+					ZBX_DIAG_HISTORYSTORAGE_REJECTED | \
+					ZBX_DIAG_HISTORYSTORAGE_THROTTLED | \
+					ZBX_DIAG_HISTORYSTORAGE_LATENCY)
+
 typedef struct
 {
 	char		*name;
@@ -502,6 +502,93 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: diag_add_historystorage_info                                     *
+ *                                                                            *
+ * Purpose: add requested history storage writer diagnostic information to    *
+ *          json data                                                         *
+ *                                                                            *
+ * Parameters: jp    - [IN] the request                                       *
+ *             json  - [IN/OUT] the json to update                            *
+ *             error - [OUT] error message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the information was added successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	diag_add_historystorage_info(const struct zbx_json_parse *jp, struct zbx_json *json, char **error)
+{
+	zbx_vector_ptr_t	tops;
+	int			ret;
+	double			time1, time2, time_total = 0;
+	zbx_uint64_t		fields;
+	zbx_diag_map_t		field_map[] = {
+					{"", ZBX_DIAG_HISTORYSTORAGE_SIMPLE},
+					{"requests", ZBX_DIAG_HISTORYSTORAGE_REQUESTS},
+					{"values", ZBX_DIAG_HISTORYSTORAGE_VALUES},
+					{"bytes", ZBX_DIAG_HISTORYSTORAGE_BYTES},
+					{"retried", ZBX_DIAG_HISTORYSTORAGE_RETRIED},
+					{"rejected", ZBX_DIAG_HISTORYSTORAGE_REJECTED},
+					{"throttled", ZBX_DIAG_HISTORYSTORAGE_THROTTLED},
+					{"latency", ZBX_DIAG_HISTORYSTORAGE_LATENCY},
+					{NULL, 0}
+					};
+
+	zbx_vector_ptr_create(&tops);
+
+	if (SUCCEED == (ret = diag_parse_request(jp, field_map, &fields, &tops, error)))
+	{
+		zbx_json_addobject(json, ZBX_DIAG_HISTORYSTORAGE);
+
+		if (0 != (fields & ZBX_DIAG_HISTORYSTORAGE_SIMPLE))
+		{
+			zbx_history_storage_stats_t	stats;
+
+			time1 = zbx_time();
+			zbx_history_get_storage_stats(&stats);
+			time2 = zbx_time();
+			time_total += time2 - time1;
+
+			if (0 != (fields & ZBX_DIAG_HISTORYSTORAGE_REQUESTS))
+				zbx_json_adduint64(json, "requests", stats.requests);
+			if (0 != (fields & ZBX_DIAG_HISTORYSTORAGE_VALUES))
+				zbx_json_adduint64(json, "values", stats.values);
+			if (0 != (fields & ZBX_DIAG_HISTORYSTORAGE_BYTES))
+				zbx_json_adduint64(json, "bytes", stats.bytes);
+			if (0 != (fields & ZBX_DIAG_HISTORYSTORAGE_RETRIED))
+				zbx_json_adduint64(json, "retried", stats.retried);
+			if (0 != (fields & ZBX_DIAG_HISTORYSTORAGE_REJECTED))
+				zbx_json_adduint64(json, "rejected", stats.rejected);
+			if (0 != (fields & ZBX_DIAG_HISTORYSTORAGE_THROTTLED))
+				zbx_json_adduint64(json, "throttled", stats.throttled);
+
+			if (0 != (fields & ZBX_DIAG_HISTORYSTORAGE_LATENCY))
+			{
+				zbx_json_addobject(json, "latency");
+				zbx_json_addfloat(json, "avg", 0 != stats.requests ? stats.time / stats.requests : 0);
+				zbx_json_addfloat(json, "max", stats.time_max);
+				zbx_json_close(json);
+			}
+		}
+
+		if (0 != tops.values_num)
+		{
+			*error = zbx_strdup(*error, "Unsupported top field");
+			ret = FAIL;
+			goto out;
+		}
+
+		zbx_json_addfloat(json, "time", time_total);
+		zbx_json_close(json);
+	}
+out:
+	zbx_vector_ptr_clear_ext(&tops, (zbx_ptr_free_func_t)diag_map_free);
+	zbx_vector_ptr_destroy(&tops);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: diag_add_section_info                                            *
@@ -532,6 +619,8 @@ int	diag_add_section_info(const char *section, const struct zbx_json_parse *jp,
 		ret = diag_add_lld_info(jp, json, error);
 	else if (0 == strcmp(section, ZBX_DIAG_ALERTING))
 		ret = diag_add_alerting_info(jp, json, error);
+	else if (0 == strcmp(section, ZBX_DIAG_HISTORYSTORAGE))
+		ret = diag_add_historystorage_info(jp, json, error);
 	else if (0 == strcmp(section, ZBX_DIAG_LOCKS))
 	{
 		diag_add_locks_info(json);
@@ -29,6 +29,8 @@ ZBX_VECTOR_IMPL(history_record, zbx_history_record_t)
 
 extern char	*CONFIG_HISTORY_STORAGE_URL;
 extern char	*CONFIG_HISTORY_STORAGE_OPTS;
+extern char	*CONFIG_HISTORY_STORAGE_LOCAL_PATH;
+extern int	CONFIG_HISTORY_STORAGE_LOCAL_RETENTION;
 
 zbx_history_iface_t	history_ifaces[ITEM_VALUE_TYPE_MAX];
 
@@ -40,7 +42,8 @@ zbx_history_iface_t	history_ifaces[ITEM_VALUE_TYPE_MAX];
  *                                                                                  *
  * Comments: History interfaces are created for all values types based on           *
  *           configuration. Every value type can have different history storage     *
- *           backend.                                                               *
+ *           backend. Numeric value types not sent to Elasticsearch are stored in   *
+ *           local segment files when local history storage path is configured.     *
  *                                                                                  *
  ************************************************************************************/
 int	zbx_history_init(char **error)
@@ -53,10 +56,16 @@ int	zbx_history_init(char **error)
 
 	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
 	{
-		if (NULL == CONFIG_HISTORY_STORAGE_URL || NULL == strstr(CONFIG_HISTORY_STORAGE_OPTS, opts[i]))
-			ret = zbx_history_sql_init(&history_ifaces[i], i, error);
-		else
+		if (NULL != CONFIG_HISTORY_STORAGE_URL && NULL != strstr(CONFIG_HISTORY_STORAGE_OPTS, opts[i]))
 			ret = zbx_history_elastic_init(&history_ifaces[i], i, error);
+		else if (NULL != CONFIG_HISTORY_STORAGE_LOCAL_PATH && (ITEM_VALUE_TYPE_FLOAT == i ||
+				ITEM_VALUE_TYPE_UINT64 == i))
+		{
+			ret = zbx_history_local_init(&history_ifaces[i], i, CONFIG_HISTORY_STORAGE_LOCAL_PATH,
+					CONFIG_HISTORY_STORAGE_LOCAL_RETENTION, error);
+		}
+		else
+			ret = zbx_history_sql_init(&history_ifaces[i], i, error);
 
 		if (FAIL == ret)
 			return FAIL;
@@ -177,6 +186,75 @@ int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int c
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: zbx_history_get_values_multi                                           *
+ *                                                                                  *
+ * Purpose: gets values of multiple items from history storage                      *
+ *                                                                                  *
+ * Parameters:  value_type - [IN] the items value type                              *
+ *              start      - [IN] the period start timestamp                        *
+ *              count      - [IN] the maximum number of values to read for all      *
+ *                                items, 0 - unlimited                              *
+ *              end        - [IN] the period end timestamp                          *
+ *              items      - [IN/OUT] the items to read (zbx_history_item_values_t) *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: This function reads values from ]<start>,<end>] interval in undefined  *
+ *           order. If <count> values were read the period might have more values,  *
+ *           so callers needing all values must request one value more than they    *
+ *           can accept and discard the result when it is reached.                  *
+ *           Backends not supporting multiple item requests are queried item by     *
+ *           item.                                                                  *
+ *                                                                                  *
+ ************************************************************************************/
+int	zbx_history_get_values_multi(int value_type, int start, int count, int end, zbx_hashset_t *items)
+{
+	int				ret = SUCCEED, values_num = 0;
+	zbx_history_iface_t		*writer = &history_ifaces[value_type];
+	zbx_hashset_iter_t		iter;
+	zbx_history_item_values_t	*item;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() value_type:%d start:%d count:%d end:%d items:%d", __func__, value_type,
+			start, count, end, items->num_data);
+
+	if (0 == items->num_data)
+		goto out;
+
+	if (NULL != writer->get_values_multi)
+	{
+		ret = writer->get_values_multi(writer, start, count, end, items);
+	}
+	else
+	{
+		zbx_hashset_iter_reset(items, &iter);
+
+		while (SUCCEED == ret && (0 == count || values_num < count) &&
+				NULL != (item = (zbx_history_item_values_t *)zbx_hashset_iter_next(&iter)))
+		{
+			ret = writer->get_values(writer, item->itemid, start, 0 == count ? 0 : count - values_num, end,
+					&item->values);
+			values_num += item->values.values_num;
+		}
+
+		values_num = 0;
+	}
+
+	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+	{
+		zbx_hashset_iter_reset(items, &iter);
+
+		while (NULL != (item = (zbx_history_item_values_t *)zbx_hashset_iter_next(&iter)))
+			values_num += item->values.values_num;
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s values:%d", __func__, zbx_result_string(ret), values_num);
+
+	return ret;
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: zbx_history_requires_trends                                            *
@@ -29,6 +29,8 @@ typedef void (*zbx_history_destroy_func_t)(struct zbx_history_iface *hist);
 typedef int (*zbx_history_add_values_func_t)(struct zbx_history_iface *hist, const zbx_vector_ptr_t *history);
 typedef int (*zbx_history_get_values_func_t)(struct zbx_history_iface *hist, zbx_uint64_t itemid, int start,
 		int count, int end, zbx_vector_history_record_t *values);
+typedef int (*zbx_history_get_values_multi_func_t)(struct zbx_history_iface *hist, int start, int count,
+		int end, zbx_hashset_t *items);
 typedef int (*zbx_history_flush_func_t)(struct zbx_history_iface *hist);
 
 struct zbx_history_iface
@@ -41,6 +43,9 @@ struct zbx_history_iface
 	zbx_history_add_values_func_t	add_values;
 	zbx_history_get_values_func_t	get_values;
 	zbx_history_flush_func_t	flush;
+
+	/* optional, reads values of multiple items with a single request */
+	zbx_history_get_values_multi_func_t	get_values_multi;
 };
 
 /* SQL hist */
@@ -49,4 +54,8 @@ int	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, ch
 /* elastic hist */
 int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
 
+/* local hist */
+int	zbx_history_local_init(zbx_history_iface_t *hist, unsigned char value_type, const char *path, int retention,
+		char **error);
+
 #endif
@@ -24,6 +24,7 @@
 #include "dbcache.h"
 #include "zbxhistory.h"
 #include "zbxself.h"
+#include "mutexs.h"
 #include "history.h"
 
 /* curl_multi_wait() is supported starting with version 7.28.0 (0x071c00) */
@@ -34,50 +35,94 @@
 #define		ZBX_IDX_JSON_ALLOCATE		256
 #define		ZBX_JSON_ALLOCATE		2048
 
+/* bulk request body size limit, larger batches are split into several requests */
+#define		ZBX_ELASTIC_BULK_SIZE		(5 * ZBX_MEBIBYTE)
+
+/* initial delay in milliseconds before resending throttled documents, doubled while throttling continues */
+#define		ZBX_ELASTIC_BACKOFF_MIN		100
+
+/* the number of documents returned by one page of multiple item search */
+#define		ZBX_ELASTIC_SCROLL_SIZE		10000
+
+#define		ZBX_ELASTIC_RETRY_THROTTLED	0x01
+#define		ZBX_ELASTIC_RETRY_DOWN		0x02
 
 const char	*value_type_str[] = {"dbl", "str", "log", "uint", "text"};
 
 extern char	*CONFIG_HISTORY_STORAGE_URL;
 extern int	CONFIG_HISTORY_STORAGE_PIPELINES;
+extern int	CONFIG_HISTORY_STORAGE_CONCURRENCY;
 
 typedef struct
 {
-	char	*base_url;
-	char	*post_url;
-	char	*buf;
-	CURL	*handle;
+	char	*data;
+	size_t	alloc;
+	size_t	offset;
 }
-zbx_elastic_data_t;
+zbx_httppage_t;
+
+static zbx_httppage_t	page_r;
 
+/* NDJSON documents (action and source line pairs) waiting to be sent */
 typedef struct
 {
-	unsigned char		initialized;
-	zbx_vector_ptr_t	ifaces;
-
-	CURLM			*handle;
+	char			*data;
+	size_t			alloc;
+	size_t			offset;
+	zbx_vector_uint64_t	docs;	/* offsets of the documents in data */
 }
-zbx_elastic_writer_t;
-
-static zbx_elastic_writer_t	writer;
+zbx_elastic_spool_t;
 
+/* bulk request sending a range of spooled documents */
 typedef struct
 {
-	char	*data;
-	size_t	alloc;
-	size_t	offset;
+	CURL			*handle;
+	zbx_history_iface_t	*hist;
+	unsigned char		active;
+	int			doc_first;
+	int			doc_num;
+	double			time_start;
+	zbx_httppage_t		page;
+	char			errbuf[CURL_ERROR_SIZE];
 }
-zbx_httppage_t;
+zbx_elastic_request_t;
 
-static zbx_httppage_t	page_r;
+typedef struct
+{
+	char			*base_url;
+	char			*post_url;
+	char			*bulk_url;
+	CURL			*handle;
+
+	zbx_elastic_spool_t	spool;
+	zbx_elastic_spool_t	retry;
+
+	/* bulk request slots, up to concurrency requests are sent in parallel */
+	zbx_elastic_request_t	*requests;
+	int			requests_num;
+	int			concurrency;
+	int			requests_active;
+	int			next_doc;
+}
+zbx_elastic_data_t;
 
 typedef struct
 {
-	zbx_httppage_t	page;
-	char		errbuf[CURL_ERROR_SIZE];
+	unsigned char		initialized;
+	zbx_vector_ptr_t	ifaces;
+
+	CURLM			*handle;
+	struct curl_slist	*headers;
+
+	/* delay before resending throttled documents in milliseconds */
+	int			backoff;
 }
-zbx_curlpage_t;
+zbx_elastic_writer_t;
+
+static zbx_elastic_writer_t	writer;
 
-static zbx_curlpage_t	page_w[ITEM_VALUE_TYPE_MAX];
+static zbx_history_storage_stats_t	*elastic_stats = NULL;
+static zbx_mutex_t			elastic_stats_lock = ZBX_MUTEX_NULL;
 
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
@@ -232,87 +277,136 @@ static void	elastic_close(zbx_history_iface_t *hist)
 {
 	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
 
-	zbx_free(data->buf);
 	zbx_free(data->post_url);
 
 	if (NULL != data->handle)
 	{
-		if (NULL != writer.handle)
-			curl_multi_remove_handle(writer.handle, data->handle);
-
 		curl_easy_cleanup(data->handle);
 		data->handle = NULL;
 	}
 }
 
-/******************************************************************************
- *                                                                            *
- * Function: elastic_is_error_present                                         *
- *                                                                            *
- * Purpose: check a error from Elastic json response                          *
- *                                                                            *
- * Parameters: page - [IN]  the buffer with json response                     *
- *             err  - [OUT] the parse error message. If the error value is    *
- *                           set it must be freed by caller after it has      *
- *                           been used.                                       *
- *                                                                            *
- * Return value: SUCCEED - the response contains an error                     *
- *               FAIL    - otherwise                                          *
- *                                                                            *
- ******************************************************************************/
-static int	elastic_is_error_present(zbx_httppage_t *page, char **err)
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_stats_init                                                     *
+ *                                                                                  *
+ * Purpose: allocates shared memory for bulk writer statistics                      *
+ *                                                                                  *
+ * Comments: The statistics are updated by history syncers and read by diagnostic   *
+ *           requests, so they must be allocated before forking.                    *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_stats_init(char **error)
 {
-	struct zbx_json_parse	jp, jp_values, jp_index, jp_error, jp_items, jp_item;
-	const char		*errors, *p = NULL;
-	char			*index = NULL, *status = NULL, *type = NULL, *reason = NULL;
-	size_t			index_alloc = 0, status_alloc = 0, type_alloc = 0, reason_alloc = 0;
-	int			rc_js = SUCCEED;
+	int	shm_id;
+	void	*ptr;
 
-	zabbix_log(LOG_LEVEL_TRACE, "%s() raw json: %s", __func__, ZBX_NULL2EMPTY_STR(page->data));
+	if (NULL != elastic_stats)
+		return SUCCEED;
 
-	if (SUCCEED != zbx_json_open(page->data, &jp) || SUCCEED != zbx_json_brackets_open(jp.start, &jp_values))
+	if (SUCCEED != zbx_mutex_create(&elastic_stats_lock, ZBX_MUTEX_HISTORY_STORAGE, error))
 		return FAIL;
 
-	if (NULL == (errors = zbx_json_pair_by_name(&jp_values, "errors")) || 0 != strncmp("true", errors, 4))
+	if (-1 == (shm_id = shmget(IPC_PRIVATE, sizeof(zbx_history_storage_stats_t), 0600)))
+	{
+		*error = zbx_dsprintf(*error, "cannot allocate shared memory for history storage statistics: %s",
+				zbx_strerror(errno));
 		return FAIL;
+	}
 
-	if (SUCCEED == zbx_json_brackets_by_name(&jp, "items", &jp_items))
+	if ((void *)(-1) == (ptr = shmat(shm_id, NULL, 0)))
 	{
-		while (NULL != (p = zbx_json_next(&jp_items, p)))
-		{
-			if (SUCCEED == zbx_json_brackets_open(p, &jp_item) &&
-					SUCCEED == zbx_json_brackets_by_name(&jp_item, "index", &jp_index) &&
-					SUCCEED == zbx_json_brackets_by_name(&jp_index, "error", &jp_error))
-			{
-				if (SUCCEED != zbx_json_value_by_name_dyn(&jp_error, "type", &type, &type_alloc, NULL))
-					rc_js = FAIL;
-				if (SUCCEED != zbx_json_value_by_name_dyn(&jp_error, "reason", &reason, &reason_alloc, NULL))
-					rc_js = FAIL;
-			}
-			else
-				continue;
+		*error = zbx_dsprintf(*error, "cannot attach shared memory for history storage statistics: %s",
+				zbx_strerror(errno));
+		return FAIL;
+	}
 
-			if (SUCCEED != zbx_json_value_by_name_dyn(&jp_index, "status", &status, &status_alloc, NULL))
-				rc_js = FAIL;
-			if (SUCCEED != zbx_json_value_by_name_dyn(&jp_index, "_index", &index, &index_alloc, NULL))
-				rc_js = FAIL;
+	if (-1 == shmctl(shm_id, IPC_RMID, NULL))
+		zbx_error("cannot mark shared memory %d for destruction: %s", shm_id, zbx_strerror(errno));
 
-			break;
-		}
+	elastic_stats = (zbx_history_storage_stats_t *)ptr;
+	memset(elastic_stats, 0, sizeof(zbx_history_storage_stats_t));
+
+	return SUCCEED;
+}
+
+static void	elastic_stats_update(const zbx_history_storage_stats_t *stats)
+{
+	if (NULL == elastic_stats || 0 == stats->requests)
+		return;
+
+	zbx_mutex_lock(elastic_stats_lock);
+
+	elastic_stats->requests += stats->requests;
+	elastic_stats->values += stats->values;
+	elastic_stats->bytes += stats->bytes;
+	elastic_stats->retried += stats->retried;
+	elastic_stats->rejected += stats->rejected;
+	elastic_stats->throttled += stats->throttled;
+	elastic_stats->time += stats->time;
+
+	if (elastic_stats->time_max < stats->time_max)
+		elastic_stats->time_max = stats->time_max;
+
+	zbx_mutex_unlock(elastic_stats_lock);
+}
+
+static void	elastic_spool_init(zbx_elastic_spool_t *spool)
+{
+	spool->data = NULL;
+	spool->alloc = 0;
+	spool->offset = 0;
+	zbx_vector_uint64_create(&spool->docs);
+}
+
+static void	elastic_spool_destroy(zbx_elastic_spool_t *spool)
+{
+	zbx_free(spool->data);
+	zbx_vector_uint64_destroy(&spool->docs);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_spool_reset                                                    *
+ *                                                                                  *
+ * Purpose: removes spooled documents keeping the buffer for reuse unless it has    *
+ *          grown over the bulk request size limit                                  *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_spool_reset(zbx_elastic_spool_t *spool)
+{
+	spool->offset = 0;
+	zbx_vector_uint64_clear(&spool->docs);
+
+	if (2 * ZBX_ELASTIC_BULK_SIZE < spool->alloc)
+	{
+		zbx_free(spool->data);
+		spool->alloc = 0;
+		zbx_vector_uint64_destroy(&spool->docs);
+		zbx_vector_uint64_create(&spool->docs);
 	}
-	else
-		rc_js = FAIL;
+}
+
+static void	elastic_spool_add(zbx_elastic_spool_t *spool, const char *data, size_t size)
+{
+	zbx_vector_uint64_append(&spool->docs, spool->offset);
+	zbx_strncpy_alloc(&spool->data, &spool->alloc, &spool->offset, data, size);
+}
 
-	*err = zbx_dsprintf(NULL,"index:%s status:%s type:%s reason:%s%s", ZBX_NULL2EMPTY_STR(index),
-			ZBX_NULL2EMPTY_STR(status), ZBX_NULL2EMPTY_STR(type), ZBX_NULL2EMPTY_STR(reason),
-			FAIL == rc_js ? " / elasticsearch version is not fully compatible with zabbix server" : "");
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_spool_docs_size                                                *
+ *                                                                                  *
+ * Purpose: returns size of the specified document range                            *
+ *                                                                                  *
+ ************************************************************************************/
+static size_t	elastic_spool_docs_size(const zbx_elastic_spool_t *spool, int first, int num)
+{
+	size_t	end;
 
-	zbx_free(status);
-	zbx_free(type);
-	zbx_free(reason);
-	zbx_free(index);
+	end = (first + num < spool->docs.values_num ? spool->docs.values[first + num] : spool->offset);
 
-	return SUCCEED;
+	return end - spool->docs.values[first];
 }
 
 /******************************************************************************************************************
@@ -321,13 +415,14 @@ static int	elastic_is_error_present(zbx_httppage_t *page, char **err)
  *                                                                                                                *
  ******************************************************************************************************************/
 
-
-
 /************************************************************************************
  *                                                                                  *
  * Function: elastic_writer_init                                                    *
  *                                                                                  *
- * Purpose: initializes elastic writer for a new batch of history values            *
+ * Purpose: initializes elastic writer                                              *
+ *                                                                                  *
+ * Comments: The writer with its multi handle and request handles is kept between   *
+ *           flushes, so connections to the storage are reused.                     *
  *                                                                                  *
  ************************************************************************************/
 static void	elastic_writer_init(void)
@@ -343,6 +438,9 @@ static void	elastic_writer_init(void)
 		exit(EXIT_FAILURE);
 	}
 
+	writer.headers = curl_slist_append(NULL, "Content-Type: application/x-ndjson");
+	writer.backoff = 0;
+
 	writer.initialized = 1;
 }
 
@@ -356,14 +454,15 @@ static void	elastic_writer_init(void)
  ************************************************************************************/
 static void	elastic_writer_release(void)
 {
-	int	i;
-
-	for (i = 0; i < writer.ifaces.values_num; i++)
-		elastic_close((zbx_history_iface_t *)writer.ifaces.values[i]);
+	if (0 == writer.initialized)
+		return;
 
 	curl_multi_cleanup(writer.handle);
 	writer.handle = NULL;
 
+	curl_slist_free_all(writer.headers);
+	writer.headers = NULL;
+
 	zbx_vector_ptr_destroy(&writer.ifaces);
 
 	writer.initialized = 0;
@@ -375,223 +474,463 @@ static void	elastic_writer_release(void)
  *                                                                                  *
  * Purpose: adds history storage interface to be flushed later                      *
  *                                                                                  *
- * Parameters: db_insert - [IN] bulk insert data                                    *
+ * Parameters: hist - [IN] the history storage interface                            *
  *                                                                                  *
  ************************************************************************************/
 static void	elastic_writer_add_iface(zbx_history_iface_t *hist)
+{
+	elastic_writer_init();
+
+	if (FAIL == zbx_vector_ptr_search(&writer.ifaces, hist, ZBX_DEFAULT_PTR_COMPARE_FUNC))
+		zbx_vector_ptr_append(&writer.ifaces, hist);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_request_start                                                  *
+ *                                                                                  *
+ * Purpose: starts bulk request with the next range of spooled documents            *
+ *                                                                                  *
+ * Parameters: hist    - [IN] the history storage interface                         *
+ *             request - [IN] a free request slot                                   *
+ *                                                                                  *
+ * Return value: SUCCEED - the request was started                                  *
+ *               FAIL    - otherwise                                                *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_request_start(zbx_history_iface_t *hist, zbx_elastic_request_t *request)
 {
 	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
+	zbx_elastic_spool_t	*spool = &data->spool;
 	CURLoption		opt;
 	CURLcode		err;
+	CURLMcode		code;
+	int			num;
 
-	elastic_writer_init();
+	if (NULL == request->handle)
+	{
+		if (NULL == (request->handle = curl_easy_init()))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
+			return FAIL;
+		}
 
-	if (NULL == (data->handle = curl_easy_init()))
+		if (CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_URL, data->bulk_url)) ||
+				CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_POST, 1L)) ||
+				CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_HTTPHEADER,
+						writer.headers)) ||
+				CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_WRITEFUNCTION,
+						curl_write_cb)) ||
+				CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_WRITEDATA,
+						&request->page)) ||
+				CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_ERRORBUFFER,
+						request->errbuf)) ||
+				CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_PRIVATE, request)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
+			curl_easy_cleanup(request->handle);
+			request->handle = NULL;
+			return FAIL;
+		}
+	}
+
+	/* add documents while the request body fits the size limit, but at least one */
+	for (num = 1; data->next_doc + num < spool->docs.values_num; num++)
 	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
-		return;
+		if (ZBX_ELASTIC_BULK_SIZE < elastic_spool_docs_size(spool, data->next_doc, num + 1))
+			break;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POST, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, data->buf)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEFUNCTION,
-					curl_write_cb)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEDATA,
-					&page_w[hist->value_type].page)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_ERRORBUFFER,
-					page_w[hist->value_type].errbuf)))
+	request->doc_first = data->next_doc;
+	request->doc_num = num;
+
+	if (CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_POSTFIELDSIZE,
+			(long)elastic_spool_docs_size(spool, request->doc_first, num))) ||
+			CURLE_OK != (err = curl_easy_setopt(request->handle, opt = CURLOPT_POSTFIELDS,
+			spool->data + spool->docs.values[request->doc_first])))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
-		goto out;
+		return FAIL;
 	}
 
-	*page_w[hist->value_type].errbuf = '\0';
+	request->page.offset = 0;
+	*request->errbuf = '\0';
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_PRIVATE, &page_w[hist->value_type])))
+	if (CURLM_OK != (code = curl_multi_add_handle(writer.handle, request->handle)))
 	{
-		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
-		goto out;
+		zabbix_log(LOG_LEVEL_ERR, "cannot add handle to curl multi handle: %s", curl_multi_strerror(code));
+		return FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "sending %d %s values in bulk request", num, value_type_str[hist->value_type]);
+
+	request->hist = hist;
+	request->active = 1;
+	request->time_start = zbx_time();
+	data->next_doc += num;
+	data->requests_active++;
+
+	return SUCCEED;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_request_requeue                                                *
+ *                                                                                  *
+ * Purpose: copies request documents to the retry spool                             *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_request_requeue(zbx_elastic_data_t *data, int first, int num)
+{
+	int	i;
+
+	for (i = first; i < first + num; i++)
+	{
+		elastic_spool_add(&data->retry, data->spool.data + data->spool.docs.values[i],
+				elastic_spool_docs_size(&data->spool, i, 1));
 	}
+}
 
-	page_w[hist->value_type].page.offset = 0;
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_request_check_items                                            *
+ *                                                                                  *
+ * Purpose: checks per document results of bulk request with errors and queues      *
+ *          the failed documents that can succeed later for resending               *
+ *                                                                                  *
+ * Parameters: data    - [IN] the history storage interface data                    *
+ *             request - [IN] the completed request                                 *
+ *             stats   - [IN/OUT] the writer statistics                             *
+ *                                                                                  *
+ * Return value: ZBX_ELASTIC_RETRY_THROTTLED if documents were queued or 0          *
+ *                                                                                  *
+ * Comments: Documents rejected with 429 or 5xx status are resent, other errors     *
+ *           (for example mapping errors) will not succeed on resending.            *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_request_check_items(zbx_elastic_data_t *data, const zbx_elastic_request_t *request,
+		zbx_history_storage_stats_t *stats)
+{
+	struct zbx_json_parse	jp, jp_items, jp_item, jp_action, jp_error;
+	const char		*p = NULL, *errors;
+	char			name[MAX_STRING_LEN], *value = NULL;
+	size_t			value_alloc = 0;
+	int			i = 0, status, logged = 0, ret = 0;
+
+	if (SUCCEED != zbx_json_open(request->page.data, &jp) ||
+			NULL == (errors = zbx_json_pair_by_name(&jp, "errors")) || 0 != strncmp("true", errors, 4))
+	{
+		stats->values += request->doc_num;
+		return 0;
+	}
 
-	if (0 < page_w[hist->value_type].page.alloc)
-		*page_w[hist->value_type].page.data = '\0';
+	if (SUCCEED != zbx_json_brackets_by_name(&jp, "items", &jp_items))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: elasticsearch version is not fully"
+				" compatible with zabbix server");
+		stats->rejected += request->doc_num;
+		return 0;
+	}
 
-	curl_multi_add_handle(writer.handle, data->handle);
+	for (; i < request->doc_num && NULL != (p = zbx_json_next(&jp_items, p)); i++)
+	{
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_item) ||
+				NULL == zbx_json_pair_next(&jp_item, NULL, name, sizeof(name)) ||
+				SUCCEED != zbx_json_brackets_by_name(&jp_item, name, &jp_action) ||
+				SUCCEED != zbx_json_value_by_name_dyn(&jp_action, "status", &value, &value_alloc, NULL))
+		{
+			stats->rejected++;
+			continue;
+		}
 
-	zbx_vector_ptr_append(&writer.ifaces, hist);
+		if (300 > (status = atoi(value)))
+		{
+			stats->values++;
+			continue;
+		}
 
-	return;
-out:
-	elastic_close(hist);
+		if (429 == status || 500 <= status)
+		{
+			/* both indicate overloaded storage, resend after backoff */
+			elastic_request_requeue(data, request->doc_first + i, 1);
+			stats->retried++;
+			ret = ZBX_ELASTIC_RETRY_THROTTLED;
+
+			if (429 == status)
+				stats->throttled++;
+
+			continue;
+		}
+
+		stats->rejected++;
+
+		if (0 == logged && SUCCEED == zbx_json_brackets_by_name(&jp_action, "error", &jp_error))
+		{
+			char	*type = NULL, *reason = NULL;
+			size_t	type_alloc = 0, reason_alloc = 0;
+
+			zbx_json_value_by_name_dyn(&jp_error, "type", &type, &type_alloc, NULL);
+			zbx_json_value_by_name_dyn(&jp_error, "reason", &reason, &reason_alloc, NULL);
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: index:%s status:%d type:%s"
+					" reason:%s", value_type_str[request->hist->value_type], status,
+					ZBX_NULL2EMPTY_STR(type), ZBX_NULL2EMPTY_STR(reason));
+
+			zbx_free(type);
+			zbx_free(reason);
+			logged = 1;
+		}
+	}
+
+	/* the response has less items than documents sent */
+	stats->rejected += request->doc_num - i;
+
+	zbx_free(value);
+
+	return ret;
 }
 
 /************************************************************************************
  *                                                                                  *
- * Function: elastic_writer_flush                                                   *
+ * Function: elastic_request_finish                                                 *
  *                                                                                  *
- * Purpose: posts historical data to elastic storage                                *
+ * Purpose: processes completed bulk request                                        *
+ *                                                                                  *
+ * Parameters: request - [IN] the completed request                                 *
+ *             result  - [IN] the transfer result                                   *
+ *             stats   - [IN/OUT] the writer statistics                             *
+ *                                                                                  *
+ * Return value: ZBX_ELASTIC_RETRY_* flags describing why documents were queued     *
+ *               for resending                                                      *
  *                                                                                  *
  ************************************************************************************/
-static int	elastic_writer_flush(void)
+static int	elastic_request_finish(zbx_elastic_request_t *request, CURLcode result,
+		zbx_history_storage_stats_t *stats)
 {
-	struct curl_slist	*curl_headers = NULL;
-	int			i, running, previous, msgnum;
-	CURLMsg			*msg;
-	zbx_vector_ptr_t	retries;
-	CURLcode		err;
-	int			ret = SUCCEED;
+	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)request->hist->data;
+	double			time_spent;
+	long int		response_code;
+	int			ret = 0;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	curl_multi_remove_handle(writer.handle, request->handle);
 
-	/* The writer might be uninitialized only if the history */
-	/* was already flushed. In that case, return SUCCEED */
-	if (0 == writer.initialized)
-		goto end;
+	request->active = 0;
+	data->requests_active--;
+
+	time_spent = zbx_time() - request->time_start;
+	stats->requests++;
+	stats->time += time_spent;
 
-	zbx_vector_ptr_create(&retries);
+	if (stats->time_max < time_spent)
+		stats->time_max = time_spent;
+
+	if (CURLE_OK != result)
+	{
+		/* transport errors - the storage is down or unreachable */
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: %s",
+				'\0' != *request->errbuf ? request->errbuf : curl_easy_strerror(result));
 
-	curl_headers = curl_slist_append(curl_headers, "Content-Type: application/x-ndjson");
+		elastic_request_requeue(data, request->doc_first, request->doc_num);
+		stats->retried += request->doc_num;
+
+		return ZBX_ELASTIC_RETRY_DOWN;
+	}
+
+	stats->bytes += elastic_spool_docs_size(&data->spool, request->doc_first, request->doc_num);
+
+	if (CURLE_OK != curl_easy_getinfo(request->handle, CURLINFO_RESPONSE_CODE, &response_code))
+		response_code = 0;
+
+	if (429 == response_code || 500 <= response_code)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch, HTTP status code: %ld",
+				response_code);
+
+		elastic_request_requeue(data, request->doc_first, request->doc_num);
+		stats->retried += request->doc_num;
+
+		if (429 != response_code)
+			return ZBX_ELASTIC_RETRY_DOWN;
+
+		stats->throttled += request->doc_num;
+		ret = ZBX_ELASTIC_RETRY_THROTTLED;
+	}
+	else if (300 <= response_code)
+	{
+		/* if the error is due to malformed data, there is no sense on re-trying to send */
+		zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, HTTP status code: %ld, message: %s",
+				response_code, 0 != request->page.offset ? request->page.data : "");
+
+		stats->rejected += request->doc_num;
+	}
+	else
+	{
+		zabbix_log(LOG_LEVEL_TRACE, "%s() raw json: %s", __func__, ZBX_NULL2EMPTY_STR(request->page.data));
+		ret = elastic_request_check_items(data, request, stats);
+	}
+
+	/* adjust the number of parallel requests - halve on throttling, grow back by one on success */
+	if (0 != (ret & ZBX_ELASTIC_RETRY_THROTTLED))
+		data->concurrency = MAX(1, data->concurrency / 2);
+	else if (data->concurrency < data->requests_num)
+		data->concurrency++;
+
+	return ret;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_writer_start_requests                                          *
+ *                                                                                  *
+ * Purpose: fills free request slots with the spooled documents                     *
+ *                                                                                  *
+ * Return value: the number of requests in progress                                 *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_writer_start_requests(void)
+{
+	int	i, j, active = 0;
 
 	for (i = 0; i < writer.ifaces.values_num; i++)
 	{
 		zbx_history_iface_t	*hist = (zbx_history_iface_t *)writer.ifaces.values[i];
 		zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_HTTPHEADER, curl_headers)))
+		for (j = 0; j < data->requests_num && data->requests_active < data->concurrency &&
+				data->next_doc < data->spool.docs.values_num; j++)
 		{
-			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_HTTPHEADER,
-					curl_easy_strerror(err));
-			ret = FAIL;
-			goto clean;
+			zbx_elastic_request_t	*request = &data->requests[j];
+
+			if (0 != request->active)
+				continue;
+
+			if (SUCCEED != elastic_request_start(hist, request))
+			{
+				/* keep the documents for the next attempt */
+				elastic_request_requeue(data, data->next_doc, data->spool.docs.values_num -
+						data->next_doc);
+				data->next_doc = data->spool.docs.values_num;
+				break;
+			}
 		}
 
-		zabbix_log(LOG_LEVEL_DEBUG, "sending %s", data->buf);
+		active += data->requests_active;
 	}
 
-try_again:
-	previous = 0;
+	return active;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_writer_flush                                                   *
+ *                                                                                  *
+ * Purpose: posts historical data to elastic storage                                *
+ *                                                                                  *
+ * Comments: Spooled documents are streamed in bulk requests of limited size with   *
+ *           several requests per index in progress. Only the documents that failed *
+ *           because of throttling or storage unavailability are resent.            *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_writer_flush(void)
+{
+	int				i, running, msgnum, retry, pending;
+	CURLMsg				*msg;
+	CURLMcode			code;
+	zbx_history_storage_stats_t	stats;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	/* The writer might be uninitialized only if the history */
+	/* was already flushed. In that case, return SUCCEED */
+	if (0 == writer.initialized)
+		goto end;
 
 	do
 	{
-		int		fds;
-		CURLMcode	code;
-		char 		*error;
-		zbx_curlpage_t	*curl_page;
+		memset(&stats, 0, sizeof(stats));
+		retry = 0;
 
-		if (CURLM_OK != (code = curl_multi_perform(writer.handle, &running)))
-		{
-			zabbix_log(LOG_LEVEL_ERR, "cannot perform on curl multi handle: %s", curl_multi_strerror(code));
-			break;
-		}
+		for (i = 0; i < writer.ifaces.values_num; i++)
+			((zbx_elastic_data_t *)((zbx_history_iface_t *)writer.ifaces.values[i])->data)->next_doc = 0;
 
-		if (CURLM_OK != (code = curl_multi_wait(writer.handle, NULL, 0, ZBX_HISTORY_STORAGE_DOWN, &fds)))
+		while (0 != elastic_writer_start_requests())
 		{
-			zabbix_log(LOG_LEVEL_ERR, "cannot wait on curl multi handle: %s", curl_multi_strerror(code));
-			break;
-		}
+			int	fds;
 
-		if (previous == running)
-			continue;
-
-		while (NULL != (msg = curl_multi_info_read(writer.handle, &msgnum)))
-		{
-			/* If the error is due to malformed data, there is no sense on re-trying to send. */
-			/* That's why we actually check for transport and curl errors separately */
-			if (CURLE_HTTP_RETURNED_ERROR == msg->data.result)
-			{
-				if (CURLE_OK == curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE,
-						(char **)&curl_page) && '\0' != *curl_page->errbuf)
-				{
-					zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, HTTP error"
-							" message: %s", curl_page->errbuf);
-				}
-				else
-				{
-					char		http_status[MAX_STRING_LEN];
-					long int	response_code;
-
-					if (CURLE_OK == curl_easy_getinfo(msg->easy_handle,
-							CURLINFO_RESPONSE_CODE, &response_code))
-					{
-						zbx_snprintf(http_status, sizeof(http_status), "HTTP status code: %ld",
-								response_code);
-					}
-					else
-					{
-						zbx_strlcpy(http_status, "unknown HTTP status code",
-								sizeof(http_status));
-					}
-
-					zabbix_log(LOG_LEVEL_ERR, "cannot send data to elasticsearch, %s", http_status);
-				}
+			if (CURLM_OK != (code = curl_multi_perform(writer.handle, &running)))
+			{
+				zabbix_log(LOG_LEVEL_ERR, "cannot perform on curl multi handle: %s",
+						curl_multi_strerror(code));
 			}
-			else if (CURLE_OK != msg->data.result)
+			else if (CURLM_OK != (code = curl_multi_wait(writer.handle, NULL, 0, ZBX_HISTORY_STORAGE_DOWN,
+					&fds)))
 			{
-				if (CURLE_OK == curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE,
-						(char **)&curl_page) && '\0' != *curl_page->errbuf)
-				{
-					zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: %s",
-							curl_page->errbuf);
-				}
-				else
+				zabbix_log(LOG_LEVEL_ERR, "cannot wait on curl multi handle: %s",
+						curl_multi_strerror(code));
+			}
+
+			while (NULL != (msg = curl_multi_info_read(writer.handle, &msgnum)))
+			{
+				zbx_elastic_request_t	*request;
+
+				if (CURLMSG_DONE != msg->msg || CURLE_OK != curl_easy_getinfo(msg->easy_handle,
+						CURLINFO_PRIVATE, (char **)&request))
 				{
-					zabbix_log(LOG_LEVEL_WARNING, "cannot send data to elasticsearch: %s",
-							curl_easy_strerror(msg->data.result));
+					continue;
 				}
 
-				/* If the error is due to curl internal problems or unrelated */
-				/* problems with HTTP, we put the handle in a retry list and */
-				/* remove it from the current execution loop */
-				zbx_vector_ptr_append(&retries, msg->easy_handle);
-				curl_multi_remove_handle(writer.handle, msg->easy_handle);
-			}
-			else if (CURLE_OK == curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&curl_page)
-					&& SUCCEED == elastic_is_error_present(&curl_page->page, &error))
-			{
-				zabbix_log(LOG_LEVEL_WARNING, "%s() cannot send data to elasticsearch: %s",
-						__func__, error);
-				zbx_free(error);
-
-				/* If the error is due to elastic internal problems (for example an index */
-				/* became read-only), we put the handle in a retry list and */
-				/* remove it from the current execution loop */
-				zbx_vector_ptr_append(&retries, msg->easy_handle);
-				curl_multi_remove_handle(writer.handle, msg->easy_handle);
+				retry |= elastic_request_finish(request, msg->data.result, &stats);
 			}
 		}
 
-		previous = running;
-	}
-	while (running);
+		/* documents to resend become the spool of the next round */
+		for (i = 0, pending = 0; i < writer.ifaces.values_num; i++)
+		{
+			zbx_elastic_data_t	*data = (zbx_elastic_data_t *)
+					((zbx_history_iface_t *)writer.ifaces.values[i])->data;
+			zbx_elastic_spool_t	spool;
 
-	/* We check if we have handles to retry. If yes, we put them back in the multi */
-	/* handle and go to the beginning of the do while() for try sending the data again */
-	/* after sleeping for ZBX_HISTORY_STORAGE_DOWN / 1000 (seconds) */
-	if (0 < retries.values_num)
-	{
-		for (i = 0; i < retries.values_num; i++)
-			curl_multi_add_handle(writer.handle, retries.values[i]);
+			elastic_spool_reset(&data->spool);
 
-		zbx_vector_ptr_clear(&retries);
+			spool = data->spool;
+			data->spool = data->retry;
+			data->retry = spool;
 
-		sleep(ZBX_HISTORY_STORAGE_DOWN / 1000);
-		goto try_again;
-	}
-clean:
-	curl_slist_free_all(curl_headers);
+			pending += data->spool.docs.values_num;
+		}
 
-	zbx_vector_ptr_destroy(&retries);
+		elastic_stats_update(&stats);
 
-	elastic_writer_release();
+		if (0 != (retry & ZBX_ELASTIC_RETRY_THROTTLED))
+			writer.backoff = MIN(MAX(writer.backoff * 2, ZBX_ELASTIC_BACKOFF_MIN), ZBX_HISTORY_STORAGE_DOWN);
+		else
+			writer.backoff /= 2;
+
+		if (0 == pending)
+			break;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() resending %d values", __func__, pending);
+
+		if (0 != (retry & ZBX_ELASTIC_RETRY_DOWN))
+		{
+			sleep(ZBX_HISTORY_STORAGE_DOWN / 1000);
+		}
+		else if (0 != writer.backoff)
+		{
+			struct timespec	ts;
 
+			ts.tv_sec = writer.backoff / 1000;
+			ts.tv_nsec = writer.backoff % 1000 * 1000000;
+			nanosleep(&ts, NULL);
+		}
+	}
+	while (1);
+
+	zbx_vector_ptr_clear(&writer.ifaces);
 end:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
-	return ret;
+	return SUCCEED;
 }
 
 /******************************************************************************************************************
@@ -612,47 +951,57 @@ end:
 static void	elastic_destroy(zbx_history_iface_t *hist)
 {
 	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
+	int			i;
 
 	elastic_close(hist);
+	elastic_writer_release();
+
+	for (i = 0; i < data->requests_num; i++)
+	{
+		if (NULL != data->requests[i].handle)
+			curl_easy_cleanup(data->requests[i].handle);
 
+		zbx_free(data->requests[i].page.data);
+	}
+
+	zbx_free(data->requests);
+
+	elastic_spool_destroy(&data->spool);
+	elastic_spool_destroy(&data->retry);
+
+	zbx_free(data->bulk_url);
 	zbx_free(data->base_url);
 	zbx_free(data);
 }
 
 /************************************************************************************
  *                                                                                  *
- * Function: elastic_get_values                                                     *
+ * Function: elastic_search_values                                                  *
  *                                                                                  *
- * Purpose: gets item history data from history storage                             *
+ * Purpose: reads history data matching the search query with scrolling requests    *
  *                                                                                  *
  * Parameters:  hist    - [IN] the history storage interface                        *
- *              itemid  - [IN] the itemid                                           *
- *              start   - [IN] the period start timestamp                           *
- *              count   - [IN] the number of values to read                         *
- *              end     - [IN] the period end timestamp                             *
- *              values  - [OUT] the item history data values                        *
+ *              query   - [IN] the search query                                     *
+ *              count   - [IN] the number of values to read, 0 - all values         *
+ *              values  - [OUT] the history data values, used when items is NULL    *
+ *              items   - [IN/OUT] the items to read (zbx_history_item_values_t),   *
+ *                                 optional                                         *
  *                                                                                  *
  * Return value: SUCCEED - the history data were read successfully                  *
  *               FAIL - otherwise                                                   *
  *                                                                                  *
- * Comments: This function reads <count> values from ]<start>,<end>] interval or    *
- *           all values from the specified interval if count is zero.               *
- *                                                                                  *
  ************************************************************************************/
-static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int start, int count, int end,
-		zbx_vector_history_record_t *values)
+static int	elastic_search_values(zbx_history_iface_t *hist, const struct zbx_json *query, int count,
+		zbx_vector_history_record_t *values, zbx_hashset_t *items)
 {
 	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
 	size_t			url_alloc = 0, url_offset = 0, id_alloc = 0, scroll_alloc = 0, scroll_offset = 0;
 	int			total, empty, ret;
 	CURLcode		err;
-	struct zbx_json		query;
 	struct curl_slist	*curl_headers = NULL;
 	char			*scroll_id = NULL, *scroll_query = NULL, errbuf[CURL_ERROR_SIZE];
 	CURLoption		opt;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
 	ret = FAIL;
 
 	if (NULL == (data->handle = curl_easy_init()))
@@ -665,53 +1014,10 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 	zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/%s*/_search?scroll=10s", data->base_url,
 			value_type_str[hist->value_type]);
 
-	/* prepare the json query for elasticsearch, apply ranges if needed */
-	zbx_json_init(&query, ZBX_JSON_ALLOCATE);
-
-	if (0 < count)
-	{
-		zbx_json_adduint64(&query, "size", count);
-		zbx_json_addarray(&query, "sort");
-		zbx_json_addobject(&query, NULL);
-		zbx_json_addobject(&query, "clock");
-		zbx_json_addstring(&query, "order", "desc", ZBX_JSON_TYPE_STRING);
-		zbx_json_close(&query);
-		zbx_json_close(&query);
-		zbx_json_close(&query);
-	}
-
-	zbx_json_addobject(&query, "query");
-	zbx_json_addobject(&query, "bool");
-	zbx_json_addarray(&query, "must");
-	zbx_json_addobject(&query, NULL);
-	zbx_json_addobject(&query, "match");
-	zbx_json_adduint64(&query, "itemid", itemid);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_addarray(&query, "filter");
-	zbx_json_addobject(&query, NULL);
-	zbx_json_addobject(&query, "range");
-	zbx_json_addobject(&query, "clock");
-
-	if (0 < start)
-		zbx_json_adduint64(&query, "gt", start);
-
-	if (0 < end)
-		zbx_json_adduint64(&query, "lte", end);
-
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-
 	curl_headers = curl_slist_append(curl_headers, "Content-Type: application/json");
 
 	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, query.buffer)) ||
+			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, query->buffer)) ||
 			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEFUNCTION,
 					curl_write_cb)) ||
 			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEDATA, &page_r)) ||
@@ -723,7 +1029,7 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 		goto out;
 	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "sending query to %s; post data: %s", data->post_url, query.buffer);
+	zabbix_log(LOG_LEVEL_DEBUG, "sending query to %s; post data: %s", data->post_url, query->buffer);
 
 	page_r.offset = 0;
 	*errbuf = '\0';
@@ -750,9 +1056,10 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 	/* the total reach zero, we terminate the scrolling query and return what we currently have. */
 	do
 	{
-		struct zbx_json_parse	jp, jp_values, jp_item, jp_sub, jp_hits, jp_source;
-		zbx_history_record_t	hr;
-		const char		*p = NULL;
+		struct zbx_json_parse		jp, jp_values, jp_item, jp_sub, jp_hits, jp_source;
+		zbx_history_record_t		hr;
+		zbx_history_item_values_t	*item = NULL;
+		const char			*p = NULL;
 
 		empty = 1;
 
@@ -781,10 +1088,24 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 			if (SUCCEED != zbx_json_brackets_by_name(&jp_item, "_source", &jp_source))
 				continue;
 
+			if (NULL != items)
+			{
+				char		buf[MAX_ID_LEN + 1];
+				zbx_uint64_t	itemid;
+
+				if (SUCCEED != zbx_json_value_by_name(&jp_source, "itemid", buf, sizeof(buf), NULL) ||
+						SUCCEED != is_uint64(buf, &itemid) ||
+						NULL == (item = (zbx_history_item_values_t *)zbx_hashset_search(items,
+						&itemid)))
+				{
+					continue;
+				}
+			}
+
 			if (SUCCEED != history_parse_value(&jp_source, hist->value_type, &hr))
 				continue;
 
-			zbx_vector_history_record_append_ptr(values, &hr);
+			zbx_vector_history_record_append_ptr(NULL != item ? &item->values : values, &hr);
 
 			if (-1 != total)
 				--total;
@@ -855,11 +1176,87 @@ out:
 
 	curl_slist_free_all(curl_headers);
 
-	zbx_json_free(&query);
-
 	zbx_free(scroll_id);
 	zbx_free(scroll_query);
 
+	return ret;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_get_values                                                     *
+ *                                                                                  *
+ * Purpose: gets item history data from history storage                             *
+ *                                                                                  *
+ * Parameters:  hist    - [IN] the history storage interface                        *
+ *              itemid  - [IN] the itemid                                           *
+ *              start   - [IN] the period start timestamp                           *
+ *              count   - [IN] the number of values to read                         *
+ *              end     - [IN] the period end timestamp                             *
+ *              values  - [OUT] the item history data values                        *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: This function reads <count> values from ]<start>,<end>] interval or    *
+ *           all values from the specified interval if count is zero.               *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int start, int count, int end,
+		zbx_vector_history_record_t *values)
+{
+	int		ret;
+	struct zbx_json	query;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	/* prepare the json query for elasticsearch, apply ranges if needed */
+	zbx_json_init(&query, ZBX_JSON_ALLOCATE);
+
+	if (0 < count)
+	{
+		zbx_json_adduint64(&query, "size", count);
+		zbx_json_addarray(&query, "sort");
+		zbx_json_addobject(&query, NULL);
+		zbx_json_addobject(&query, "clock");
+		zbx_json_addstring(&query, "order", "desc", ZBX_JSON_TYPE_STRING);
+		zbx_json_close(&query);
+		zbx_json_close(&query);
+		zbx_json_close(&query);
+	}
+
+	zbx_json_addobject(&query, "query");
+	zbx_json_addobject(&query, "bool");
+	zbx_json_addarray(&query, "must");
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "match");
+	zbx_json_adduint64(&query, "itemid", itemid);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_addarray(&query, "filter");
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "range");
+	zbx_json_addobject(&query, "clock");
+
+	if (0 < start)
+		zbx_json_adduint64(&query, "gt", start);
+
+	if (0 < end)
+		zbx_json_adduint64(&query, "lte", end);
+
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+
+	ret = elastic_search_values(hist, &query, count, values, NULL);
+
+	zbx_json_free(&query);
+
 	zbx_vector_history_record_sort(values, (zbx_compare_func_t)zbx_history_record_compare_desc_func);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -867,6 +1264,78 @@ out:
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_get_values_multi                                               *
+ *                                                                                  *
+ * Purpose: gets history data of multiple items from history storage                *
+ *                                                                                  *
+ * Parameters:  hist    - [IN] the history storage interface                        *
+ *              start   - [IN] the period start timestamp                           *
+ *              count   - [IN] the maximum number of values to read, 0 - unlimited  *
+ *              end     - [IN] the period end timestamp                             *
+ *              items   - [IN/OUT] the items to read (zbx_history_item_values_t)    *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: This function reads values from ]<start>,<end>] interval with a single *
+ *           terms query, scrolling stops when <count> values are read.             *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_get_values_multi(zbx_history_iface_t *hist, int start, int count, int end,
+		zbx_hashset_t *items)
+{
+	int				ret;
+	struct zbx_json			query;
+	zbx_hashset_iter_t		iter;
+	zbx_history_item_values_t	*item;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_json_init(&query, ZBX_JSON_ALLOCATE);
+
+	zbx_json_adduint64(&query, "size", ZBX_ELASTIC_SCROLL_SIZE);
+	zbx_json_addobject(&query, "query");
+	zbx_json_addobject(&query, "bool");
+	zbx_json_addarray(&query, "filter");
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "terms");
+	zbx_json_addarray(&query, "itemid");
+
+	zbx_hashset_iter_reset(items, &iter);
+	while (NULL != (item = (zbx_history_item_values_t *)zbx_hashset_iter_next(&iter)))
+		zbx_json_adduint64(&query, NULL, item->itemid);
+
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "range");
+	zbx_json_addobject(&query, "clock");
+
+	if (0 < start)
+		zbx_json_adduint64(&query, "gt", start);
+
+	if (0 < end)
+		zbx_json_adduint64(&query, "lte", end);
+
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+
+	ret = elastic_search_values(hist, &query, count, NULL, items);
+
+	zbx_json_free(&query);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+
+	return ret;
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: elastic_add_values                                                     *
@@ -876,6 +1345,8 @@ out:
  * Parameters:  hist    - [IN] the history storage interface                        *
  *              history - [IN] the history data vector (may have mixed value types) *
  *                                                                                  *
+ * Comments: The values are spooled as bulk request documents and sent by flush.    *
+ *                                                                                  *
  ************************************************************************************/
 static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t *history)
 {
@@ -883,7 +1354,6 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t
 	int			i, num = 0;
 	ZBX_DC_HISTORY		*h;
 	struct zbx_json		json_idx, json;
-	size_t			buf_alloc = 0, buf_offset = 0;
 	char			pipeline[14]; /* index name length + suffix "-pipeline" */
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -902,6 +1372,8 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t
 	zbx_json_close(&json_idx);
 	zbx_json_close(&json_idx);
 
+	zbx_json_init(&json, ZBX_JSON_ALLOCATE);
+
 	for (i = 0; i < history->values_num; i++)
 	{
 		h = (ZBX_DC_HISTORY *)history->values[i];
@@ -909,7 +1381,7 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t
 		if (hist->value_type != h->value_type)
 			continue;
 
-		zbx_json_init(&json, ZBX_JSON_ALLOCATE);
+		zbx_json_clean(&json);
 
 		zbx_json_adduint64(&json, "itemid", h->itemid);
 
@@ -933,19 +1405,20 @@ static int	elastic_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t
 
 		zbx_json_close(&json);
 
-		zbx_snprintf_alloc(&data->buf, &buf_alloc, &buf_offset, "%s\n%s\n", json_idx.buffer, json.buffer);
-
-		zbx_json_free(&json);
+		/* NDJSON document - the action and source lines */
+		elastic_spool_add(&data->spool, json_idx.buffer, json_idx.buffer_size);
+		zbx_chrcpy_alloc(&data->spool.data, &data->spool.alloc, &data->spool.offset, '\n');
+		zbx_strncpy_alloc(&data->spool.data, &data->spool.alloc, &data->spool.offset, json.buffer,
+				json.buffer_size);
+		zbx_chrcpy_alloc(&data->spool.data, &data->spool.alloc, &data->spool.offset, '\n');
 
 		num++;
 	}
 
 	if (num > 0)
-	{
-		data->post_url = zbx_dsprintf(NULL, "%s/_bulk?refresh=true", data->base_url);
 		elastic_writer_add_iface(hist);
-	}
 
+	zbx_json_free(&json);
 	zbx_json_free(&json_idx);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -996,25 +1469,64 @@ int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type
 		return FAIL;
 	}
 
+	if (SUCCEED != elastic_stats_init(error))
+		return FAIL;
+
 	data = (zbx_elastic_data_t *)zbx_malloc(NULL, sizeof(zbx_elastic_data_t));
 	memset(data, 0, sizeof(zbx_elastic_data_t));
 	data->base_url = zbx_strdup(NULL, CONFIG_HISTORY_STORAGE_URL);
 	zbx_rtrim(data->base_url, "/");
-	data->buf = NULL;
+	data->bulk_url = zbx_dsprintf(NULL, "%s/_bulk?refresh=true", data->base_url);
 	data->post_url = NULL;
 	data->handle = NULL;
 
+	elastic_spool_init(&data->spool);
+	elastic_spool_init(&data->retry);
+
+	data->requests_num = CONFIG_HISTORY_STORAGE_CONCURRENCY;
+	data->requests = (zbx_elastic_request_t *)zbx_malloc(NULL, sizeof(zbx_elastic_request_t) *
+			data->requests_num);
+	memset(data->requests, 0, sizeof(zbx_elastic_request_t) * data->requests_num);
+	data->concurrency = data->requests_num;
+
 	hist->value_type = value_type;
 	hist->data = data;
 	hist->destroy = elastic_destroy;
 	hist->add_values = elastic_add_values;
 	hist->flush = elastic_flush;
 	hist->get_values = elastic_get_values;
+	hist->get_values_multi = elastic_get_values_multi;
 	hist->requires_trends = 0;
 
 	return SUCCEED;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: zbx_history_get_storage_stats                                          *
+ *                                                                                  *
+ * Purpose: gets history storage bulk writer statistics                             *
+ *                                                                                  *
+ * Parameters:  stats - [OUT] the statistics                                        *
+ *                                                                                  *
+ ************************************************************************************/
+void	zbx_history_get_storage_stats(zbx_history_storage_stats_t *stats)
+{
+	if (NULL == elastic_stats)
+	{
+		memset(stats, 0, sizeof(zbx_history_storage_stats_t));
+		return;
+	}
+
+	zbx_mutex_lock(elastic_stats_lock);
+	*stats = *elastic_stats;
+	zbx_mutex_unlock(elastic_stats_lock);
+}
+
+#ifdef HAVE_TESTS
+#	include "../../../tests/libs/zbxhistory/history_elastic_test.c"
+#endif
+
 #else
 
 int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error)
@@ -1026,4 +1538,9 @@ int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type
 	return FAIL;
 }
 
+void	zbx_history_get_storage_stats(zbx_history_storage_stats_t *stats)
+{
+	memset(stats, 0, sizeof(zbx_history_storage_stats_t));
+}
+
 #endif
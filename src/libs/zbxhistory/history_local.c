@@ -0,0 +1,1199 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "log.h"
+#include "zbxalgo.h"
+#include "dbcache.h"
+#include "zbxhistory.h"
+#include "history.h"
+
+#include <sys/mman.h>
+
+#include "../zbxalgo/vectorimpl.h"
+
+/*
+ * Local history storage keeps numeric history in append-only segment files:
+ *
+ *   <HistoryStorageLocalPath>/<dbl|uint>/<partition>/<itemid>
+ *
+ * where partition is the start of the day the values belong to. Every flush appends one self-contained
+ * block per item and partition. A block is a bit stream with the following layout:
+ *
+ *   magic:32 size:32 count:32 sec:32 ns:32 last:32 value:64 <timestamps column> <values column>
+ *
+ * The size is the length of the stream following the header in bytes, the header holds the first value
+ * and seconds of the last value timestamp, so blocks outside of requested period are skipped without
+ * decoding. The timestamps column contains count-1 delta-of-delta encoded seconds, each followed by
+ * nanoseconds - either a single 0 bit (same as previous) or 1 bit and the 30 bit value. The values column
+ * contains count-1 Gorilla XOR encoded floats or delta-of-delta encoded unsigned integers.
+ *
+ * Partitions older than HistoryStorageLocalRetention days are removed by the processes using the storage.
+ */
+
+#define ZBX_HISTORY_LOCAL_MAGIC		0x5a484c32
+#define ZBX_HISTORY_LOCAL_MAGIC_SIZE	4
+#define ZBX_HISTORY_LOCAL_HEADER_SIZE	32
+#define ZBX_HISTORY_LOCAL_PARTITION	SEC_PER_DAY
+
+/* how often expired partitions are removed and the oldest partition is looked up */
+#define ZBX_HISTORY_LOCAL_HOUSEKEEPING_PERIOD	SEC_PER_HOUR
+
+/* the maximum number of values kept queued for the next flush after failed writes */
+#define ZBX_HISTORY_LOCAL_QUEUE_MAX		100000
+
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	zbx_timespec_t	ts;
+	history_value_t	value;
+}
+zbx_local_value_t;
+
+ZBX_VECTOR_DECL(local_value, zbx_local_value_t)
+ZBX_VECTOR_IMPL(local_value, zbx_local_value_t)
+
+typedef struct
+{
+	char				*path;
+	zbx_vector_local_value_t	values;
+	int				retention;
+	int				oldest;
+	int				housekeeping_time;
+}
+zbx_local_data_t;
+
+typedef struct
+{
+	zbx_uint64_t	size;
+	zbx_uint64_t	num;
+	zbx_uint64_t	sec;
+	zbx_uint64_t	ns;
+	zbx_uint64_t	last;
+	zbx_uint64_t	value;
+}
+zbx_local_header_t;
+
+typedef struct
+{
+	unsigned char	*data;
+	size_t		alloc;
+	size_t		bits;
+}
+zbx_local_writer_t;
+
+typedef struct
+{
+	const unsigned char	*data;
+	size_t			size;
+	size_t			pos;
+}
+zbx_local_reader_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_write_bits                                                 *
+ *                                                                            *
+ * Purpose: appends the lowest nbits of value to the bit stream, most         *
+ *          significant bit first                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	local_write_bits(zbx_local_writer_t *writer, zbx_uint64_t value, int nbits)
+{
+	size_t	size = (writer->bits + nbits + 7) / 8;
+
+	if (size > writer->alloc)
+	{
+		size_t	alloc = writer->alloc;
+
+		while (size > writer->alloc)
+			writer->alloc = (0 == writer->alloc ? 256 : writer->alloc * 2);
+
+		writer->data = (unsigned char *)zbx_realloc(writer->data, writer->alloc);
+		memset(writer->data + alloc, 0, writer->alloc - alloc);
+	}
+
+	while (0 < nbits)
+	{
+		int	left = 8 - (int)(writer->bits % 8), take = MIN(left, nbits);
+
+		nbits -= take;
+		writer->data[writer->bits / 8] |= (unsigned char)(((value >> nbits) & ((1 << take) - 1)) <<
+				(left - take));
+		writer->bits += take;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_read_bits                                                  *
+ *                                                                            *
+ * Purpose: reads nbits value from the bit stream                             *
+ *                                                                            *
+ * Return value: SUCCEED - the value was read                                 *
+ *               FAIL    - the stream is exhausted                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	local_read_bits(zbx_local_reader_t *reader, int nbits, zbx_uint64_t *value)
+{
+	if (reader->pos + nbits > reader->size * 8)
+		return FAIL;
+
+	*value = 0;
+
+	while (0 < nbits)
+	{
+		int	left = 8 - (int)(reader->pos % 8), take = MIN(left, nbits);
+
+		*value = (*value << take) | ((reader->data[reader->pos / 8] >> (left - take)) & ((1 << take) - 1));
+		reader->pos += take;
+		nbits -= take;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_write_signed                                               *
+ *                                                                            *
+ * Purpose: writes zigzag encoded signed value using variable bit length      *
+ *          buckets - small values (the common delta-of-delta case) take      *
+ *          only a few bits                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	local_write_signed(zbx_local_writer_t *writer, zbx_uint64_t value)
+{
+	zbx_uint64_t	zz;
+
+	zz = (value << 1) ^ (0 != (value >> 63) ? ~__UINT64_C(0) : 0);
+
+	if (0 == zz)
+	{
+		local_write_bits(writer, 0, 1);
+	}
+	else if (zz < __UINT64_C(1) << 7)
+	{
+		local_write_bits(writer, 2, 2);
+		local_write_bits(writer, zz, 7);
+	}
+	else if (zz < __UINT64_C(1) << 12)
+	{
+		local_write_bits(writer, 6, 3);
+		local_write_bits(writer, zz, 12);
+	}
+	else if (zz < __UINT64_C(1) << 20)
+	{
+		local_write_bits(writer, 14, 4);
+		local_write_bits(writer, zz, 20);
+	}
+	else if (zz < __UINT64_C(1) << 32)
+	{
+		local_write_bits(writer, 30, 5);
+		local_write_bits(writer, zz, 32);
+	}
+	else
+	{
+		local_write_bits(writer, 31, 5);
+		local_write_bits(writer, zz >> 32, 32);
+		local_write_bits(writer, zz, 32);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_read_signed                                                *
+ *                                                                            *
+ * Purpose: reads value written by local_write_signed()                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	local_read_signed(zbx_local_reader_t *reader, zbx_uint64_t *value)
+{
+	const int	widths[] = {7, 12, 20, 32, 64};
+	int		i;
+	zbx_uint64_t	bit, zz, low;
+
+	for (i = 0; i < 5; i++)
+	{
+		if (SUCCEED != local_read_bits(reader, 1, &bit))
+			return FAIL;
+
+		if (0 == bit)
+			break;
+	}
+
+	if (0 == i)
+	{
+		*value = 0;
+		return SUCCEED;
+	}
+
+	if (5 == i)
+	{
+		if (SUCCEED != local_read_bits(reader, 32, &zz) || SUCCEED != local_read_bits(reader, 32, &low))
+			return FAIL;
+
+		zz = (zz << 32) | low;
+	}
+	else if (SUCCEED != local_read_bits(reader, widths[i - 1], &zz))
+		return FAIL;
+
+	*value = (zz >> 1) ^ (0 != (zz & 1) ? ~__UINT64_C(0) : 0);
+
+	return SUCCEED;
+}
+
+static int	local_leading_zeros(zbx_uint64_t value)
+{
+	int	n = 0;
+
+	while (n < 64 && 0 == (value & (__UINT64_C(1) << 63)))
+	{
+		value <<= 1;
+		n++;
+	}
+
+	return n;
+}
+
+static int	local_trailing_zeros(zbx_uint64_t value)
+{
+	int	n = 0;
+
+	while (n < 64 && 0 == (value & 1))
+	{
+		value >>= 1;
+		n++;
+	}
+
+	return n;
+}
+
+static zbx_uint64_t	local_value_bits(unsigned char value_type, const history_value_t *value)
+{
+	zbx_uint64_t	bits;
+
+	if (ITEM_VALUE_TYPE_UINT64 == value_type)
+		return value->ui64;
+
+	memcpy(&bits, &value->dbl, sizeof(bits));
+
+	return bits;
+}
+
+static void	local_set_value_bits(unsigned char value_type, history_value_t *value, zbx_uint64_t bits)
+{
+	if (ITEM_VALUE_TYPE_UINT64 == value_type)
+		value->ui64 = bits;
+	else
+		memcpy(&value->dbl, &bits, sizeof(bits));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_encode_block                                               *
+ *                                                                            *
+ * Purpose: encodes values into a segment block                               *
+ *                                                                            *
+ * Parameters: writer     - [IN/OUT] the output stream, must be empty         *
+ *             value_type - [IN] the value type                               *
+ *             values     - [IN] the values, sorted by timestamps             *
+ *             num        - [IN] the number of values                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	local_encode_block(zbx_local_writer_t *writer, unsigned char value_type,
+		const zbx_local_value_t *values, int num)
+{
+	int		i, lead = 65, trail = 0;
+	size_t		size;
+	zbx_uint64_t	prev, delta, prev_delta = 0;
+
+	local_write_bits(writer, ZBX_HISTORY_LOCAL_MAGIC, 32);
+	local_write_bits(writer, 0, 32);
+	local_write_bits(writer, (zbx_uint64_t)num, 32);
+	local_write_bits(writer, (zbx_uint64_t)values[0].ts.sec, 32);
+	local_write_bits(writer, (zbx_uint64_t)values[0].ts.ns, 32);
+	local_write_bits(writer, (zbx_uint64_t)values[num - 1].ts.sec, 32);
+	local_write_bits(writer, local_value_bits(value_type, &values[0].value), 64);
+
+	/* timestamps column */
+	for (i = 1; i < num; i++)
+	{
+		delta = (zbx_uint64_t)values[i].ts.sec - (zbx_uint64_t)values[i - 1].ts.sec;
+		local_write_signed(writer, delta - prev_delta);
+		prev_delta = delta;
+
+		if (values[i].ts.ns == values[i - 1].ts.ns)
+		{
+			local_write_bits(writer, 0, 1);
+		}
+		else
+		{
+			local_write_bits(writer, 1, 1);
+			local_write_bits(writer, (zbx_uint64_t)values[i].ts.ns, 30);
+		}
+	}
+
+	/* values column */
+	prev = local_value_bits(value_type, &values[0].value);
+	prev_delta = 0;
+
+	for (i = 1; i < num; i++)
+	{
+		zbx_uint64_t	value, xor;
+		int		l, t;
+
+		value = local_value_bits(value_type, &values[i].value);
+
+		if (ITEM_VALUE_TYPE_UINT64 == value_type)
+		{
+			delta = value - prev;
+			local_write_signed(writer, delta - prev_delta);
+			prev_delta = delta;
+			prev = value;
+			continue;
+		}
+
+		if (0 == (xor = value ^ prev))
+		{
+			local_write_bits(writer, 0, 1);
+			continue;
+		}
+
+		local_write_bits(writer, 1, 1);
+
+		if (31 < (l = local_leading_zeros(xor)))
+			l = 31;
+
+		t = local_trailing_zeros(xor);
+
+		if (lead <= l && trail <= t)
+		{
+			/* meaningful bits fit into the previous window */
+			local_write_bits(writer, 0, 1);
+			local_write_bits(writer, xor >> trail, 64 - lead - trail);
+		}
+		else
+		{
+			lead = l;
+			trail = t;
+			local_write_bits(writer, 1, 1);
+			local_write_bits(writer, (zbx_uint64_t)lead, 5);
+			local_write_bits(writer, (zbx_uint64_t)(64 - lead - trail - 1), 6);
+			local_write_bits(writer, xor >> trail, 64 - lead - trail);
+		}
+
+		prev = value;
+	}
+
+	/* store stream size following the header */
+	size = (writer->bits + 7) / 8 - ZBX_HISTORY_LOCAL_HEADER_SIZE;
+	writer->data[4] = (unsigned char)(size >> 24);
+	writer->data[5] = (unsigned char)(size >> 16);
+	writer->data[6] = (unsigned char)(size >> 8);
+	writer->data[7] = (unsigned char)size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_read_header                                                *
+ *                                                                            *
+ * Purpose: reads segment block header                                        *
+ *                                                                            *
+ * Parameters: data   - [IN] the block data                                   *
+ *             size   - [IN] the available data size                          *
+ *             header - [OUT] the block header                                *
+ *                                                                            *
+ * Return value: SUCCEED - the header is valid and the block is complete      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	local_read_header(const unsigned char *data, size_t size, zbx_local_header_t *header)
+{
+	zbx_local_reader_t	reader;
+	zbx_uint64_t		magic, low;
+
+	if (ZBX_HISTORY_LOCAL_HEADER_SIZE > size)
+		return FAIL;
+
+	reader.data = data;
+	reader.size = ZBX_HISTORY_LOCAL_HEADER_SIZE;
+	reader.pos = 0;
+
+	local_read_bits(&reader, 32, &magic);
+	local_read_bits(&reader, 32, &header->size);
+	local_read_bits(&reader, 32, &header->num);
+	local_read_bits(&reader, 32, &header->sec);
+	local_read_bits(&reader, 32, &header->ns);
+	local_read_bits(&reader, 32, &header->last);
+	local_read_bits(&reader, 32, &header->value);
+	local_read_bits(&reader, 32, &low);
+	header->value = (header->value << 32) | low;
+
+	if (ZBX_HISTORY_LOCAL_MAGIC != magic || 0 == header->num ||
+			size - ZBX_HISTORY_LOCAL_HEADER_SIZE < header->size)
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_decode_block                                               *
+ *                                                                            *
+ * Purpose: decodes segment block                                             *
+ *                                                                            *
+ * Parameters: value_type - [IN] the value type                               *
+ *             data       - [IN] the block data                               *
+ *             size       - [IN] the available data size                      *
+ *             records    - [OUT] the decoded values                          *
+ *                                                                            *
+ * Return value: the block size or 0 if the block is incomplete or corrupted  *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	local_decode_block(unsigned char value_type, const unsigned char *data, size_t size,
+		zbx_vector_history_record_t *records)
+{
+	zbx_local_reader_t	reader;
+	zbx_local_header_t	header;
+	zbx_uint64_t		ns, value, delta = 0, bit;
+	int			i, base, lead = 0, trail = 0;
+	zbx_history_record_t	record;
+
+	if (SUCCEED != local_read_header(data, size, &header))
+		return 0;
+
+	reader.data = data + ZBX_HISTORY_LOCAL_HEADER_SIZE;
+	reader.size = (size_t)header.size;
+	reader.pos = 0;
+
+	base = records->values_num;
+	value = header.value;
+	record.timestamp.sec = (int)header.sec;
+	record.timestamp.ns = (int)header.ns;
+	local_set_value_bits(value_type, &record.value, value);
+	zbx_vector_history_record_append_ptr(records, &record);
+
+	for (i = 1; i < (int)header.num; i++)
+	{
+		zbx_uint64_t	dod;
+
+		if (SUCCEED != local_read_signed(&reader, &dod) || SUCCEED != local_read_bits(&reader, 1, &bit))
+			goto fail;
+
+		delta += dod;
+		record.timestamp.sec += (int)delta;
+
+		if (0 != bit)
+		{
+			if (SUCCEED != local_read_bits(&reader, 30, &ns))
+				goto fail;
+
+			record.timestamp.ns = (int)ns;
+		}
+
+		zbx_vector_history_record_append_ptr(records, &record);
+	}
+
+	delta = 0;
+
+	for (i = 1; i < (int)header.num; i++)
+	{
+		zbx_uint64_t	xor;
+
+		if (ITEM_VALUE_TYPE_UINT64 == value_type)
+		{
+			zbx_uint64_t	dod;
+
+			if (SUCCEED != local_read_signed(&reader, &dod))
+				goto fail;
+
+			delta += dod;
+			value += delta;
+		}
+		else
+		{
+			if (SUCCEED != local_read_bits(&reader, 1, &bit))
+				goto fail;
+
+			if (0 != bit)
+			{
+				if (SUCCEED != local_read_bits(&reader, 1, &bit))
+					goto fail;
+
+				if (0 != bit)
+				{
+					zbx_uint64_t	len;
+
+					if (SUCCEED != local_read_bits(&reader, 5, &xor) ||
+							SUCCEED != local_read_bits(&reader, 6, &len))
+					{
+						goto fail;
+					}
+
+					lead = (int)xor;
+					trail = 64 - lead - (int)len - 1;
+				}
+
+				if (0 > trail || SUCCEED != local_read_bits(&reader, 64 - lead - trail, &xor))
+					goto fail;
+
+				value ^= xor << trail;
+			}
+		}
+
+		local_set_value_bits(value_type, &records->values[base + i].value, value);
+	}
+
+	return ZBX_HISTORY_LOCAL_HEADER_SIZE + (size_t)header.size;
+fail:
+	records->values_num = base;
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_is_magic                                                   *
+ *                                                                            *
+ * Purpose: checks if data starts with block magic or, when less data is      *
+ *          available, with its prefix                                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	local_is_magic(const unsigned char *data, size_t size)
+{
+	zbx_local_reader_t	reader;
+	zbx_uint64_t		magic;
+	int			nbits;
+
+	reader.data = data;
+	reader.size = MIN(size, ZBX_HISTORY_LOCAL_MAGIC_SIZE);
+	reader.pos = 0;
+
+	nbits = (int)reader.size * 8;
+
+	if (SUCCEED != local_read_bits(&reader, nbits, &magic))
+		return FAIL;
+
+	return magic == (ZBX_HISTORY_LOCAL_MAGIC >> (ZBX_HISTORY_LOCAL_MAGIC_SIZE * 8 - nbits)) ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_check_block                                                *
+ *                                                                            *
+ * Purpose: checks that segment block is intact                               *
+ *                                                                            *
+ * Parameters: data   - [IN] the block data                                   *
+ *             size   - [IN] the available data size                          *
+ *             header - [OUT] the block header                                *
+ *                                                                            *
+ * Return value: the block size or 0 if the block is torn or corrupted        *
+ *                                                                            *
+ * Comments: A block torn by crash is followed by blocks appended after       *
+ *           restart, so its size points inside the next block instead of     *
+ *           the next block start or segment end.                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	local_check_block(const unsigned char *data, size_t size, zbx_local_header_t *header)
+{
+	size_t	block_size;
+
+	if (SUCCEED != local_read_header(data, size, header))
+		return 0;
+
+	block_size = ZBX_HISTORY_LOCAL_HEADER_SIZE + (size_t)header->size;
+
+	if (block_size != size && SUCCEED != local_is_magic(data + block_size, size - block_size))
+		return 0;
+
+	return block_size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_decode_segment                                             *
+ *                                                                            *
+ * Purpose: decodes segment blocks overlapping ]start,end] period             *
+ *                                                                            *
+ * Parameters: value_type - [IN] the value type                               *
+ *             data       - [IN] the segment data                             *
+ *             size       - [IN] the segment size                             *
+ *             start      - [IN] the period start timestamp                   *
+ *             end        - [IN] the period end timestamp                     *
+ *             records    - [OUT] the decoded values, not sorted              *
+ *                                                                            *
+ * Comments: Blocks outside of the period are skipped using header timestamps.*
+ *           Torn or corrupted blocks are skipped up to the next block magic, *
+ *           an incomplete trailing block (appended concurrently) is ignored. *
+ *                                                                            *
+ ******************************************************************************/
+static void	local_decode_segment(unsigned char value_type, const unsigned char *data, size_t size, int start,
+		int end, zbx_vector_history_record_t *records)
+{
+	zbx_local_header_t	header;
+	size_t			offset = 0, block_size;
+
+	while (offset < size)
+	{
+		if (0 != (block_size = local_check_block(data + offset, size - offset, &header)))
+		{
+			if ((zbx_uint64_t)start >= header.last || (zbx_uint64_t)end < header.sec ||
+					0 != local_decode_block(value_type, data + offset, size - offset, records))
+			{
+				offset += block_size;
+				continue;
+			}
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "skipping incomplete history segment block at offset " ZBX_FS_SIZE_T,
+				(zbx_fs_size_t)offset);
+
+		for (offset++; offset + ZBX_HISTORY_LOCAL_MAGIC_SIZE <= size; offset++)
+		{
+			if (SUCCEED == local_is_magic(data + offset, size - offset))
+				break;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_read_segment                                               *
+ *                                                                            *
+ * Purpose: reads values of ]start,end] period from item segment file        *
+ *                                                                            *
+ * Parameters: value_type - [IN] the value type                               *
+ *             filename   - [IN] the segment file name                        *
+ *             start      - [IN] the period start timestamp                   *
+ *             end        - [IN] the period end timestamp                     *
+ *             records    - [OUT] the values, sorted by timestamps in         *
+ *                                descending order                            *
+ *                                                                            *
+ * Return value: SUCCEED - the segment was read or does not exist             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The segment is memory mapped and only blocks overlapping the     *
+ *           period are decoded. Values of decoded blocks outside of the      *
+ *           period are returned too.                                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	local_read_segment(unsigned char value_type, const char *filename, int start, int end,
+		zbx_vector_history_record_t *records)
+{
+	int			fd;
+	struct stat		st;
+	const unsigned char	*data;
+
+	if (-1 == (fd = open(filename, O_RDONLY)))
+	{
+		if (ENOENT == errno)
+			return SUCCEED;
+
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open history segment \"%s\": %s", filename, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if (0 != fstat(fd, &st))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot stat history segment \"%s\": %s", filename, zbx_strerror(errno));
+		close(fd);
+		return FAIL;
+	}
+
+	if (0 == st.st_size)
+	{
+		close(fd);
+		return SUCCEED;
+	}
+
+	data = (const unsigned char *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (MAP_FAILED == data)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot map history segment \"%s\": %s", filename, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	local_decode_segment(value_type, data, (size_t)st.st_size, start, end, records);
+
+	munmap((void *)data, (size_t)st.st_size);
+
+	zbx_vector_history_record_sort(records, (zbx_compare_func_t)zbx_history_record_compare_desc_func);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_remove_partition                                           *
+ *                                                                            *
+ * Purpose: removes partition directory with all item segments                *
+ *                                                                            *
+ ******************************************************************************/
+static void	local_remove_partition(const char *dirname)
+{
+	DIR		*dir;
+	struct dirent	*d;
+	char		*filename;
+
+	if (NULL == (dir = opendir(dirname)))
+	{
+		if (ENOENT != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot open history partition \"%s\": %s", dirname,
+					zbx_strerror(errno));
+		}
+
+		return;
+	}
+
+	while (NULL != (d = readdir(dir)))
+	{
+		if ('.' == *d->d_name)
+			continue;
+
+		filename = zbx_dsprintf(NULL, "%s/%s", dirname, d->d_name);
+
+		if (0 != unlink(filename) && ENOENT != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot remove history segment \"%s\": %s", filename,
+					zbx_strerror(errno));
+		}
+
+		zbx_free(filename);
+	}
+
+	closedir(dir);
+
+	if (0 != rmdir(dirname) && ENOENT != errno)
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove history partition \"%s\": %s", dirname, zbx_strerror(errno));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_housekeeping                                               *
+ *                                                                            *
+ * Purpose: removes partitions older than retention period and finds the      *
+ *          oldest remaining partition                                        *
+ *                                                                            *
+ * Parameters: data - [IN/OUT] the local history storage data                 *
+ *             now  - [IN] the current time                                   *
+ *                                                                            *
+ * Comments: Runs once per housekeeping period in every process using the     *
+ *           storage. Partitions are not listed on reads, the oldest          *
+ *           partition limits the partitions checked by count based reads.    *
+ *                                                                            *
+ ******************************************************************************/
+static void	local_housekeeping(zbx_local_data_t *data, int now)
+{
+	DIR		*dir;
+	struct dirent	*d;
+	zbx_uint64_t	partition;
+	int		expired, oldest;
+	char		*dirname;
+
+	if (data->housekeeping_time + ZBX_HISTORY_LOCAL_HOUSEKEEPING_PERIOD > now)
+		return;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	data->housekeeping_time = now;
+
+	expired = now - data->retention;
+	expired -= expired % ZBX_HISTORY_LOCAL_PARTITION;
+	oldest = now - now % ZBX_HISTORY_LOCAL_PARTITION;
+
+	if (NULL == (dir = opendir(data->path)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open history storage directory \"%s\": %s", data->path,
+				zbx_strerror(errno));
+		data->oldest = expired;
+		goto out;
+	}
+
+	while (NULL != (d = readdir(dir)))
+	{
+		if (SUCCEED != is_uint64(d->d_name, &partition) || (zbx_uint64_t)oldest < partition)
+			continue;
+
+		if (partition < (zbx_uint64_t)expired)
+		{
+			dirname = zbx_dsprintf(NULL, "%s/%s", data->path, d->d_name);
+			local_remove_partition(dirname);
+			zbx_free(dirname);
+			continue;
+		}
+
+		oldest = (int)partition;
+	}
+
+	closedir(dir);
+
+	data->oldest = oldest;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() oldest:%d", __func__, data->oldest);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_get_values                                                 *
+ *                                                                            *
+ * Purpose: gets item history data from local storage                         *
+ *                                                                            *
+ * Parameters:  hist    - [IN] the history storage interface                  *
+ *              itemid  - [IN] the itemid                                     *
+ *              start   - [IN] the period start timestamp                     *
+ *              count   - [IN] the number of values to read                   *
+ *              end     - [IN] the period end timestamp                       *
+ *              values  - [OUT] the item history data values                  *
+ *                                                                            *
+ * Return value: SUCCEED - the history data were read successfully            *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Comments: This function reads <count> values from ]<start>,<end>] interval *
+ *           or all values from the specified interval if count is zero.      *
+ *           When count is reached the rest of the last second values are     *
+ *           read too, so the data can be cached by seconds.                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	local_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int start, int count, int end,
+		zbx_vector_history_record_t *values)
+{
+	zbx_local_data_t		*data = (zbx_local_data_t *)hist->data;
+	zbx_vector_history_record_t	records;
+	int				i, partition, first, last_sec = -1, ret = FAIL;
+	char				*filename = NULL;
+	size_t				filename_alloc = 0, filename_offset;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_history_record_vector_create(&records);
+
+	local_housekeeping(data, (int)time(NULL));
+
+	/* the partition of the first value after period start */
+	first = start + 1 - (start + 1) % ZBX_HISTORY_LOCAL_PARTITION;
+
+	if (first < data->oldest)
+		first = data->oldest;
+
+	for (partition = end - end % ZBX_HISTORY_LOCAL_PARTITION; partition >= first;
+			partition -= ZBX_HISTORY_LOCAL_PARTITION)
+	{
+		filename_offset = 0;
+		zbx_snprintf_alloc(&filename, &filename_alloc, &filename_offset, "%s/%d/" ZBX_FS_UI64, data->path,
+				partition, itemid);
+
+		zbx_vector_history_record_clear(&records);
+
+		if (SUCCEED != local_read_segment(hist->value_type, filename, start, end, &records))
+			goto out;
+
+		for (i = 0; i < records.values_num; i++)
+		{
+			zbx_history_record_t	*record = &records.values[i];
+
+			if (record->timestamp.sec > end)
+				continue;
+
+			if (record->timestamp.sec <= start)
+				break;
+
+			if (0 != count && 0 == --count)
+				last_sec = record->timestamp.sec;
+
+			if (-1 != last_sec && record->timestamp.sec != last_sec)
+				break;
+
+			zbx_vector_history_record_append_ptr(values, record);
+		}
+
+		/* a second cannot span several partitions */
+		if (-1 != last_sec)
+			break;
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_free(filename);
+	zbx_vector_history_record_destroy(&records);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+static int	local_value_compare_func(const void *d1, const void *d2)
+{
+	const zbx_local_value_t	*v1 = (const zbx_local_value_t *)d1;
+	const zbx_local_value_t	*v2 = (const zbx_local_value_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(v1->itemid, v2->itemid);
+	ZBX_RETURN_IF_NOT_EQUAL(v1->ts.sec, v2->ts.sec);
+	ZBX_RETURN_IF_NOT_EQUAL(v1->ts.ns, v2->ts.ns);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_append_block                                               *
+ *                                                                            *
+ * Purpose: appends block to item segment file, creating partition directory  *
+ *          if necessary                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	local_append_block(const char *path, zbx_uint64_t itemid, int partition,
+		const zbx_local_writer_t *writer)
+{
+	char	*filename;
+	int	fd, ret = FAIL;
+	size_t	size = (writer->bits + 7) / 8;
+	ssize_t	written;
+
+	filename = zbx_dsprintf(NULL, "%s/%d/" ZBX_FS_UI64, path, partition, itemid);
+
+	if (-1 == (fd = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0640)) && ENOENT == errno)
+	{
+		char	*dirname;
+
+		dirname = zbx_dsprintf(NULL, "%s/%d", path, partition);
+
+		if (0 != mkdir(dirname, 0750) && EEXIST != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot create history partition \"%s\": %s", dirname,
+					zbx_strerror(errno));
+		}
+
+		zbx_free(dirname);
+
+		fd = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0640);
+	}
+
+	if (-1 == fd)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open history segment \"%s\": %s", filename, zbx_strerror(errno));
+		goto out;
+	}
+
+	/* single write keeps concurrent appends from different history syncers intact */
+	if ((ssize_t)size != (written = write(fd, writer->data, size)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write history segment \"%s\": %s", filename,
+				-1 == written ? zbx_strerror(errno) : "short write");
+	}
+	else
+		ret = SUCCEED;
+
+	close(fd);
+out:
+	zbx_free(filename);
+
+	return ret;
+}
+
+static void	local_destroy(zbx_history_iface_t *hist)
+{
+	zbx_local_data_t	*data = (zbx_local_data_t *)hist->data;
+
+	zbx_vector_local_value_destroy(&data->values);
+	zbx_free(data->path);
+	zbx_free(data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_add_values                                                 *
+ *                                                                            *
+ * Purpose: queues item history values of interface value type for writing   *
+ *                                                                            *
+ * Return value: the number of queued values                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	local_add_values(zbx_history_iface_t *hist, const zbx_vector_ptr_t *history)
+{
+	zbx_local_data_t	*data = (zbx_local_data_t *)hist->data;
+	int			i, num = 0;
+
+	for (i = 0; i < history->values_num; i++)
+	{
+		const ZBX_DC_HISTORY	*h = (ZBX_DC_HISTORY *)history->values[i];
+		zbx_local_value_t	value;
+
+		if (hist->value_type != h->value_type)
+			continue;
+
+		value.itemid = h->itemid;
+		value.ts = h->ts;
+		value.value = h->value;
+		zbx_vector_local_value_append(&data->values, value);
+		num++;
+	}
+
+	return num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: local_flush                                                      *
+ *                                                                            *
+ * Purpose: writes queued values to segment files                             *
+ *                                                                            *
+ * Comments: Values are grouped by item and partition, every group is         *
+ *           appended as a single block. Groups that failed to be written are *
+ *           kept queued and retried during the next flush.                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	local_flush(zbx_history_iface_t *hist)
+{
+	zbx_local_data_t	*data = (zbx_local_data_t *)hist->data;
+	zbx_local_writer_t	writer = {NULL, 0, 0};
+	int			i, j, partition, failed_num = 0, ret = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() values:%d", __func__, data->values.values_num);
+
+	local_housekeeping(data, (int)time(NULL));
+
+	zbx_vector_local_value_sort(&data->values, local_value_compare_func);
+
+	for (i = 0; i < data->values.values_num; i = j)
+	{
+		const zbx_local_value_t	*value = &data->values.values[i];
+
+		partition = value->ts.sec - value->ts.sec % ZBX_HISTORY_LOCAL_PARTITION;
+
+		for (j = i + 1; j < data->values.values_num; j++)
+		{
+			if (data->values.values[j].itemid != value->itemid ||
+					data->values.values[j].ts.sec >= partition + ZBX_HISTORY_LOCAL_PARTITION)
+			{
+				break;
+			}
+		}
+
+		if (0 != writer.alloc)
+			memset(writer.data, 0, writer.alloc);
+		writer.bits = 0;
+
+		local_encode_block(&writer, hist->value_type, value, j - i);
+
+		if (SUCCEED != local_append_block(data->path, value->itemid, partition, &writer))
+		{
+			/* failed groups are moved to the beginning of the queue, preserving their order */
+			if (failed_num != i)
+				memmove(&data->values.values[failed_num], value, sizeof(zbx_local_value_t) * (j - i));
+
+			failed_num += j - i;
+			ret = FAIL;
+		}
+	}
+
+	zbx_free(writer.data);
+
+	if (ZBX_HISTORY_LOCAL_QUEUE_MAX < failed_num)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write history to local storage, %d values were dropped",
+				failed_num);
+		failed_num = 0;
+	}
+
+	data->values.values_num = failed_num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: zbx_history_local_init                                                 *
+ *                                                                                  *
+ * Purpose: initializes history storage interface                                   *
+ *                                                                                  *
+ * Parameters:  hist       - [IN] the history storage interface                     *
+ *              value_type - [IN] the target value type                             *
+ *              path       - [IN] the storage root directory                        *
+ *              retention  - [IN] the history retention period in days              *
+ *              error      - [OUT] the error message                                *
+ *                                                                                  *
+ * Return value: SUCCEED - the history storage interface was initialized            *
+ *               FAIL    - otherwise                                                *
+ *                                                                                  *
+ * Comments: Only numeric value types are supported. Trends are still calculated    *
+ *           and stored in database.                                                *
+ *                                                                                  *
+ ************************************************************************************/
+int	zbx_history_local_init(zbx_history_iface_t *hist, unsigned char value_type, const char *path, int retention,
+		char **error)
+{
+	zbx_local_data_t	*data;
+	struct stat		st;
+	char			*root, *dirname;
+
+	if (ITEM_VALUE_TYPE_FLOAT != value_type && ITEM_VALUE_TYPE_UINT64 != value_type)
+	{
+		*error = zbx_dsprintf(*error, "local history storage supports only numeric value types");
+		return FAIL;
+	}
+
+	root = zbx_strdup(NULL, path);
+	zbx_rtrim(root, "/");
+	dirname = zbx_dsprintf(NULL, "%s/%s", root, ITEM_VALUE_TYPE_FLOAT == value_type ? "dbl" : "uint");
+	zbx_free(root);
+
+	if (0 != mkdir(dirname, 0750) && EEXIST != errno)
+	{
+		*error = zbx_dsprintf(*error, "cannot create directory \"%s\": %s", dirname, zbx_strerror(errno));
+		zbx_free(dirname);
+		return FAIL;
+	}
+
+	if (0 != stat(dirname, &st) || 0 == S_ISDIR(st.st_mode) || 0 != access(dirname, W_OK | R_OK))
+	{
+		*error = zbx_dsprintf(*error, "cannot access directory \"%s\"", dirname);
+		zbx_free(dirname);
+		return FAIL;
+	}
+
+	data = (zbx_local_data_t *)zbx_malloc(NULL, sizeof(zbx_local_data_t));
+	data->path = dirname;
+	data->retention = retention * SEC_PER_DAY;
+	data->oldest = 0;
+	data->housekeeping_time = 0;
+	zbx_vector_local_value_create(&data->values);
+
+	hist->value_type = value_type;
+	hist->data = data;
+	hist->destroy = local_destroy;
+	hist->add_values = local_add_values;
+	hist->flush = local_flush;
+	hist->get_values = local_get_values;
+	hist->get_values_multi = NULL;
+	hist->requires_trends = 1;
+
+	return SUCCEED;
+}
+
+#ifdef HAVE_TESTS
+#	include "../../../tests/libs/zbxhistory/history_local_test.c"
+#endif
@@ -602,6 +602,99 @@ out:
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: db_read_values_multi                                                   *
+ *                                                                                  *
+ * Purpose: reads history data of multiple items from database                      *
+ *                                                                                  *
+ * Parameters:  value_type - [IN] the value type (see ITEM_VALUE_TYPE_* defs)       *
+ *              start      - [IN] the period start timestamp                        *
+ *              count      - [IN] the maximum number of values to read for all      *
+ *                                items, 0 - unlimited                              *
+ *              end        - [IN] the period end timestamp                          *
+ *              items      - [IN/OUT] the items to read (zbx_history_item_values_t) *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: This function reads values with timestamps in range:                   *
+ *             start < <value timestamp> <= end                                     *
+ *           The database client buffers the whole result, so the count limit is    *
+ *           applied in the query.                                                  *
+ *                                                                                  *
+ ************************************************************************************/
+static int	db_read_values_multi(int value_type, int start, int count, int end, zbx_hashset_t *items)
+{
+	char				*sql = NULL;
+	size_t				sql_alloc = 0, sql_offset = 0;
+	int				ret = FAIL, values_num = 0;
+	DB_RESULT			result;
+	DB_ROW				row;
+	zbx_vc_history_table_t		*table = &vc_history_tables[value_type];
+	zbx_vector_uint64_t		itemids;
+	zbx_hashset_iter_t		iter;
+	zbx_history_item_values_t	*item = NULL;
+
+	zbx_vector_uint64_create(&itemids);
+	zbx_vector_uint64_reserve(&itemids, items->num_data);
+
+	zbx_hashset_iter_reset(items, &iter);
+	while (NULL != (item = (zbx_history_item_values_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_uint64_append(&itemids, item->itemid);
+
+	zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"select itemid,clock,ns,%s"
+			" from %s"
+			" where clock>%d"
+				" and clock<=%d"
+				" and",
+			table->fields, table->name, start, end);
+
+	DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids.values, itemids.values_num);
+
+	if (0 < count)
+		result = DBselectN(sql, count);
+	else
+		result = DBselect("%s", sql);
+
+	zbx_free(sql);
+
+	if (NULL == result)
+		goto out;
+
+	while ((0 == count || values_num < count) && NULL != (row = DBfetch(result)))
+	{
+		zbx_uint64_t		itemid;
+		zbx_history_record_t	value;
+
+		ZBX_STR2UINT64(itemid, row[0]);
+
+		/* rows are usually grouped by itemid, so check the last item first */
+		if (NULL == item || item->itemid != itemid)
+		{
+			if (NULL == (item = (zbx_history_item_values_t *)zbx_hashset_search(items, &itemid)))
+				continue;
+		}
+
+		value.timestamp.sec = atoi(row[1]);
+		value.timestamp.ns = atoi(row[2]);
+		table->rtov(&value.value, row + 3);
+
+		zbx_vector_history_record_append_ptr(&item->values, &value);
+		values_num++;
+	}
+	DBfree_result(result);
+
+	ret = SUCCEED;
+out:
+	zbx_vector_uint64_destroy(&itemids);
+
+	return ret;
+}
+
 /******************************************************************************************************************
  *                                                                                                                *
  * history interface support                                                                                      *
@@ -654,6 +747,27 @@ static int	sql_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int st
 	return db_read_values_by_time_and_count(itemid, hist->value_type, values, end - start, count, end);
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_get_values_multi                                                   *
+ *                                                                                  *
+ * Purpose: gets history data of multiple items from history storage                *
+ *                                                                                  *
+ * Parameters:  hist    - [IN] the history storage interface                        *
+ *              start   - [IN] the period start timestamp                           *
+ *              count   - [IN] the maximum number of values to read, 0 - unlimited  *
+ *              end     - [IN] the period end timestamp                             *
+ *              items   - [IN/OUT] the items to read (zbx_history_item_values_t)    *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_get_values_multi(zbx_history_iface_t *hist, int start, int count, int end, zbx_hashset_t *items)
+{
+	return db_read_values_multi(hist->value_type, start, count, end, items);
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: sql_add_values                                                         *
@@ -728,6 +842,7 @@ int	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, ch
 	hist->add_values = sql_add_values;
 	hist->flush = sql_flush;
 	hist->get_values = sql_get_values;
+	hist->get_values_multi = sql_get_values_multi;
 
 	switch (value_type)
 	{
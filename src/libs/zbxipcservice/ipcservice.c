@@ -9,6 +9,7 @@
 #include "zbxtypes.h"
 #include "zbxalgo.h"
 #include "log.h"
+#include "mutexs.h"
 #include "zbxipcservice.h"
 
 #define ZBX_IPC_PATH_MAX	sizeof(((struct sockaddr_un *)0)->sun_path)
@@ -25,6 +26,63 @@ static size_t	ipc_path_root_len = 0;
 #define ZBX_IPC_ASYNC_SOCKET_STATE_TIMEOUT	1
 #define ZBX_IPC_ASYNC_SOCKET_STATE_ERROR	2
 
+/* reserved message code, used by client to pass shared memory rings to service */
+#define ZBX_IPC_MESSAGE_SHM_ATTACH	0xffffffff
+
+#define ZBX_IPC_SHM_RING_CLIENT		0	/* the ring written by client */
+#define ZBX_IPC_SHM_RING_SERVICE	1	/* the ring written by service */
+
+#define ZBX_IPC_SHM_DOORBELL_SIZE	64
+#define ZBX_IPC_SHM_HEADER_SIZE		ZBX_SIZE_T_ALIGN8(sizeof(zbx_ipc_shm_header_t))
+
+#ifdef HAVE_FUNCTION_SYNC_SYNCHRONIZE
+#	define ZBX_IPC_SHM_BARRIER()	__sync_synchronize()
+#else
+#	define ZBX_IPC_SHM_BARRIER()	ipc_shm_barrier()
+#endif
+
+/* Single producer single consumer ring buffer in shared memory. The head and tail */
+/* positions are running counters, the ring size is a power of 2.                   */
+typedef struct
+{
+	volatile zbx_uint32_t	head;		/* the read position */
+	volatile zbx_uint32_t	tail;		/* the write position */
+	volatile int		reader_waiting;	/* set by reader before waiting for data */
+	volatile int		writer_waiting;	/* set by writer before waiting for free space */
+}
+zbx_ipc_shm_ring_t;
+
+/* shared memory segment header, followed by client and service ring data */
+typedef struct
+{
+	zbx_uint32_t		size;		/* the size of each ring data */
+	volatile int		attached;	/* set by service after attaching the segment */
+	zbx_ipc_shm_ring_t	rings[2];
+}
+zbx_ipc_shm_header_t;
+
+/* Shared memory transport. Data is exchanged through rings, while the socket is */
+/* used only to wake the peer (doorbell) and to detect closed connection.        */
+struct zbx_ipc_shm
+{
+	int			shmid;
+	zbx_ipc_shm_header_t	*header;
+	zbx_uint32_t		size;
+
+	zbx_ipc_shm_ring_t	*rx;
+	unsigned char		*rx_data;
+
+	zbx_ipc_shm_ring_t	*tx;
+	unsigned char		*tx_data;
+
+	/* the segment was created by this side of connection */
+	unsigned char		owner;
+
+	/* The socket is polled by service event loop, which must never wait */
+	/* for doorbell - doorbells are processed by ipc_client_shm_event().  */
+	unsigned char		nonblocking;
+};
+
 extern unsigned char	program_type;
 
 /* IPC client, providing nonblocking connections through socket */
@@ -252,13 +310,454 @@ static int	ipc_read_data(int fd, unsigned char *buffer, zbx_uint32_t size, zbx_u
 	return SUCCEED;
 }
 
+#ifndef HAVE_FUNCTION_SYNC_SYNCHRONIZE
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_barrier                                                  *
+ *                                                                            *
+ * Purpose: orders shared memory ring accesses when the memory barrier        *
+ *          builtin is not available                                          *
+ *                                                                            *
+ * Comments: Locking and unlocking mutex synchronizes memory.                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_shm_barrier(void)
+{
+	zbx_mutex_t	lock;
+
+	lock = zbx_mutex_addr_get(ZBX_MUTEX_IPC_SHM);
+
+	zbx_mutex_lock(lock);
+	zbx_mutex_unlock(lock);
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_doorbell                                                 *
+ *                                                                            *
+ * Purpose: wakes up the peer waiting on shared memory ring                   *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket                                  *
+ *                                                                            *
+ * Comments: Write errors are ignored - closed connection is detected by      *
+ *           reading the socket.                                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_shm_doorbell(zbx_ipc_socket_t *csocket)
+{
+	unsigned char	doorbell = 0;
+
+	while (-1 == write(csocket->fd, &doorbell, 1) && EINTR == errno)
+		;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_wait                                                     *
+ *                                                                            *
+ * Purpose: waits for the peer to ring the doorbell                           *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket                                  *
+ *             rung    - [OUT] 1 - the doorbell was rung                      *
+ *                             0 - non-blocking socket would block            *
+ *                                                                            *
+ * Return value: SUCCEED - the wait was successful                            *
+ *               FAIL    - socket error or connection was closed              *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_wait(zbx_ipc_socket_t *csocket, int *rung)
+{
+	unsigned char	doorbell[ZBX_IPC_SHM_DOORBELL_SIZE];
+	int		n;
+
+	*rung = 0;
+
+	while (-1 == (n = read(csocket->fd, doorbell, sizeof(doorbell))))
+	{
+		if (EINTR == errno)
+			continue;
+
+		if (EWOULDBLOCK == errno || EAGAIN == errno)
+			return SUCCEED;
+
+		return FAIL;
+	}
+
+	if (0 == n)
+		return FAIL;
+
+	*rung = 1;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_ring_read                                                *
+ *                                                                            *
+ * Purpose: reads available data from the incoming ring                       *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket                                  *
+ *             buffer  - [OUT] the data buffer                                *
+ *             size    - [IN] the buffer size                                 *
+ *                                                                            *
+ * Return value: The number of bytes read.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	ipc_shm_ring_read(zbx_ipc_socket_t *csocket, unsigned char *buffer, zbx_uint32_t size)
+{
+	zbx_ipc_shm_t		*shm = csocket->shm;
+	zbx_ipc_shm_ring_t	*ring = shm->rx;
+	zbx_uint32_t		head, offset, chunk, len;
+
+	head = ring->head;
+	len = ring->tail - head;
+
+	/* data must be read only after it has been published by writer */
+	ZBX_IPC_SHM_BARRIER();
+
+	if (0 == len)
+		return 0;
+
+	if (len > size)
+		len = size;
+
+	offset = head & (shm->size - 1);
+	chunk = MIN(len, shm->size - offset);
+	memcpy(buffer, shm->rx_data + offset, chunk);
+	memcpy(buffer + chunk, shm->rx_data, len - chunk);
+
+	/* space must be released only after data has been copied */
+	ZBX_IPC_SHM_BARRIER();
+	ring->head = head + len;
+	ZBX_IPC_SHM_BARRIER();
+
+	if (0 != ring->writer_waiting)
+	{
+		ring->writer_waiting = 0;
+		ipc_shm_doorbell(csocket);
+	}
+
+	return len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_ring_write                                               *
+ *                                                                            *
+ * Purpose: writes data to the outgoing ring as much as free space allows     *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket                                  *
+ *             data    - [IN] the data                                        *
+ *             size    - [IN] the data size                                   *
+ *                                                                            *
+ * Return value: The number of bytes written.                                 *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	ipc_shm_ring_write(zbx_ipc_socket_t *csocket, const unsigned char *data, zbx_uint32_t size)
+{
+	zbx_ipc_shm_t		*shm = csocket->shm;
+	zbx_ipc_shm_ring_t	*ring = shm->tx;
+	zbx_uint32_t		tail, offset, chunk, len;
+
+	tail = ring->tail;
+	len = shm->size - (tail - ring->head);
+
+	/* space must be reused only after reader has released it */
+	ZBX_IPC_SHM_BARRIER();
+
+	if (0 == len)
+		return 0;
+
+	if (len > size)
+		len = size;
+
+	offset = tail & (shm->size - 1);
+	chunk = MIN(len, shm->size - offset);
+	memcpy(shm->tx_data + offset, data, chunk);
+	memcpy(shm->tx_data, data + chunk, len - chunk);
+
+	/* data must be published only after it has been copied */
+	ZBX_IPC_SHM_BARRIER();
+	ring->tail = tail + len;
+	ZBX_IPC_SHM_BARRIER();
+
+	if (0 != ring->reader_waiting)
+	{
+		ring->reader_waiting = 0;
+		ipc_shm_doorbell(csocket);
+	}
+
+	return len;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_read                                                     *
+ *                                                                            *
+ * Purpose: reads data from shared memory transport                           *
+ *                                                                            *
+ * Parameters: csocket   - [IN] the IPC socket                                *
+ *             buffer    - [OUT] the data buffer                              *
+ *             size      - [IN] the buffer size                               *
+ *             read_size - [OUT] the number of bytes read                     *
+ *                                                                            *
+ * Return value: SUCCEED - the data was successfully read                     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Has the same semantics as ipc_read_data() - blocking sockets     *
+ *           wait for data while non-blocking sockets return SUCCEED with     *
+ *           nothing read when the ring is empty.                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_read(zbx_ipc_socket_t *csocket, unsigned char *buffer, zbx_uint32_t size,
+		zbx_uint32_t *read_size)
+{
+	int	rung;
+
+	while (1)
+	{
+		if (0 != (*read_size = ipc_shm_ring_read(csocket, buffer, size)))
+			return SUCCEED;
+
+		/* announce waiting and check again to avoid missing data written meanwhile */
+		csocket->shm->rx->reader_waiting = 1;
+		ZBX_IPC_SHM_BARRIER();
+
+		if (0 != (*read_size = ipc_shm_ring_read(csocket, buffer, size)))
+			return SUCCEED;
+
+		if (FAIL == ipc_shm_wait(csocket, &rung))
+			return FAIL;
+
+		if (0 == rung)
+			return SUCCEED;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_write                                                    *
+ *                                                                            *
+ * Purpose: writes data to shared memory transport                            *
+ *                                                                            *
+ * Parameters: csocket   - [IN] the IPC socket                                *
+ *             data      - [IN] the data                                      *
+ *             size      - [IN] the data size                                 *
+ *             size_sent - [OUT] the number of bytes written                  *
+ *                                                                            *
+ * Return value: SUCCEED - no errors were detected. Either the data or a part *
+ *                         of it was written or a write to non-blocking       *
+ *                         socket would block                                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Messages larger than the ring are written in parts as the reader *
+ *           frees space. Non-blocking sockets return after filling the ring, *
+ *           the rest is written from ipc_client_shm_event() when the reader  *
+ *           rings the doorbell. Reading the doorbell here would consume the  *
+ *           incoming data notifications and stall the service event loop.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_write(zbx_ipc_socket_t *csocket, const unsigned char *data, zbx_uint32_t size,
+		zbx_uint32_t *size_sent)
+{
+	int	rung;
+
+	*size_sent = 0;
+
+	while (*size_sent != size)
+	{
+		*size_sent += ipc_shm_ring_write(csocket, data + *size_sent, size - *size_sent);
+
+		if (*size_sent == size)
+			break;
+
+		/* announce waiting and check again to avoid missing space released meanwhile */
+		csocket->shm->tx->writer_waiting = 1;
+		ZBX_IPC_SHM_BARRIER();
+
+		if (csocket->shm->size != csocket->shm->tx->tail - csocket->shm->tx->head)
+			continue;
+
+		if (0 != csocket->shm->nonblocking)
+			break;
+
+		if (FAIL == ipc_shm_wait(csocket, &rung))
+			return FAIL;
+
+		if (0 == rung)
+			break;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_free                                                     *
+ *                                                                            *
+ * Purpose: detaches shared memory transport from socket                      *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_shm_free(zbx_ipc_socket_t *csocket)
+{
+	zbx_ipc_shm_t	*shm = csocket->shm;
+
+	/* the segment is removed by service after attaching, otherwise it must be removed by owner */
+	if (0 != shm->owner && 0 == shm->header->attached && -1 == shmctl(shm->shmid, IPC_RMID, NULL))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove IPC shared memory: %s", zbx_strerror(errno));
+
+	if (-1 == shmdt((void *)shm->header))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot detach IPC shared memory: %s", zbx_strerror(errno));
+
+	zbx_free(csocket->shm);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_init                                                     *
+ *                                                                            *
+ * Purpose: initializes shared memory transport of socket                     *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket                                  *
+ *             shmid   - [IN] the shared memory segment identifier            *
+ *             header  - [IN] the attached shared memory segment              *
+ *             owner   - [IN] 1 - client side, segment creator, blocking      *
+ *                            0 - service side, polled by event loop          *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_shm_init(zbx_ipc_socket_t *csocket, int shmid, zbx_ipc_shm_header_t *header, unsigned char owner)
+{
+	zbx_ipc_shm_t	*shm;
+	unsigned char	*data;
+	int		rx, tx;
+
+	shm = (zbx_ipc_shm_t *)zbx_malloc(NULL, sizeof(zbx_ipc_shm_t));
+	shm->shmid = shmid;
+	shm->header = header;
+	shm->size = header->size;
+	shm->owner = owner;
+	shm->nonblocking = (0 == owner ? 1 : 0);
+
+	rx = (0 != owner ? ZBX_IPC_SHM_RING_SERVICE : ZBX_IPC_SHM_RING_CLIENT);
+	tx = (0 != owner ? ZBX_IPC_SHM_RING_CLIENT : ZBX_IPC_SHM_RING_SERVICE);
+
+	data = (unsigned char *)header + ZBX_IPC_SHM_HEADER_SIZE;
+
+	shm->rx = &header->rings[rx];
+	shm->rx_data = data + rx * header->size;
+	shm->tx = &header->rings[tx];
+	shm->tx_data = data + tx * header->size;
+
+	csocket->shm = shm;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_attach                                                   *
+ *                                                                            *
+ * Purpose: attaches shared memory transport created by client                *
+ *                                                                            *
+ * Parameters: csocket - [IN] the service side IPC socket                     *
+ *             data    - [IN] the attach message data                         *
+ *             size    - [IN] the attach message data size                    *
+ *                                                                            *
+ * Return value: SUCCEED - the shared memory transport was attached           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_attach(zbx_ipc_socket_t *csocket, const unsigned char *data, zbx_uint32_t size)
+{
+	int			shmid;
+	struct shmid_ds		ds;
+	zbx_ipc_shm_header_t	*header;
+
+	if (sizeof(shmid) != size || NULL != csocket->shm)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid IPC shared memory attach request");
+		return FAIL;
+	}
+
+	memcpy(&shmid, data, sizeof(shmid));
+
+	if (-1 == shmctl(shmid, IPC_STAT, &ds))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot obtain IPC shared memory status: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if ((void *)(-1) == (header = (zbx_ipc_shm_header_t *)shmat(shmid, NULL, 0)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot attach IPC shared memory: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if (0 == header->size || 0 != (header->size & (header->size - 1)) ||
+			ds.shm_segsz < ZBX_IPC_SHM_HEADER_SIZE + (size_t)header->size * 2)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "invalid IPC shared memory ring size %u", header->size);
+		(void)shmdt((void *)header);
+		return FAIL;
+	}
+
+	/* both sides are attached, the segment will be destroyed after both sides detach */
+	header->attached = 1;
+	ZBX_IPC_SHM_BARRIER();
+
+	if (-1 == shmctl(shmid, IPC_RMID, NULL))
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove IPC shared memory: %s", zbx_strerror(errno));
+
+	ipc_shm_init(csocket, shmid, header, 0);
+
+	/* the socket is used only for doorbells from now on, drop the buffered ones */
+	csocket->rx_buffer_bytes = 0;
+	csocket->rx_buffer_offset = 0;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_socket_write_data                                            *
+ *                                                                            *
+ * Purpose: writes data to IPC socket using its transport                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_socket_write_data(zbx_ipc_socket_t *csocket, const unsigned char *data, zbx_uint32_t size,
+		zbx_uint32_t *size_sent)
+{
+	if (NULL != csocket->shm)
+		return ipc_shm_write(csocket, data, size, size_sent);
+
+	return ipc_write_data(csocket->fd, data, size, size_sent);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_socket_read_data                                             *
+ *                                                                            *
+ * Purpose: reads data from IPC socket using its transport                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_socket_read_data(zbx_ipc_socket_t *csocket, unsigned char *buffer, zbx_uint32_t size,
+		zbx_uint32_t *read_size)
+{
+	if (NULL != csocket->shm)
+		return ipc_shm_read(csocket, buffer, size, read_size);
+
+	return ipc_read_data(csocket->fd, buffer, size, read_size);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: ipc_read_data_full                                               *
  *                                                                            *
  * Purpose: reads data from a socket until the requested data has been read   *
  *                                                                            *
- * Parameters: fd        - [IN] the socket file descriptor                    *
+ * Parameters: csocket   - [IN] the IPC socket                                *
  *             buffer    - [IN] the data                                      *
  *             size      - [IN] the data size                                 *
  *             read_size - [IN] the actual size read from socket              *
@@ -271,7 +770,8 @@ static int	ipc_read_data(int fd, unsigned char *buffer, zbx_uint32_t size, zbx_u
  *           the requested data has been read.                                *
  *                                                                            *
  ******************************************************************************/
-static int	ipc_read_data_full(int fd, unsigned char *buffer, zbx_uint32_t size, zbx_uint32_t *read_size)
+static int	ipc_read_data_full(zbx_ipc_socket_t *csocket, unsigned char *buffer, zbx_uint32_t size,
+		zbx_uint32_t *read_size)
 {
 	int		ret = FAIL;
 	zbx_uint32_t	offset = 0, chunk_size;
@@ -280,7 +780,7 @@ static int	ipc_read_data_full(int fd, unsigned char *buffer, zbx_uint32_t size,
 
 	while (offset < size)
 	{
-		if (FAIL == ipc_read_data(fd, buffer + offset, size - offset, &chunk_size))
+		if (FAIL == ipc_socket_read_data(csocket, buffer + offset, size - offset, &chunk_size))
 			goto out;
 
 		if (0 == chunk_size)
@@ -332,17 +832,17 @@ static int	ipc_socket_write_message(zbx_ipc_socket_t *csocket, zbx_uint32_t code
 		if (0 != size)
 			memcpy(buffer + 2, data, size);
 
-		return ipc_write_data(csocket->fd, (unsigned char *)buffer, size + ZBX_IPC_HEADER_SIZE, tx_size);
+		return ipc_socket_write_data(csocket, (unsigned char *)buffer, size + ZBX_IPC_HEADER_SIZE, tx_size);
 	}
 
-	if (FAIL == ipc_write_data(csocket->fd, (unsigned char *)buffer, ZBX_IPC_HEADER_SIZE, tx_size))
+	if (FAIL == ipc_socket_write_data(csocket, (unsigned char *)buffer, ZBX_IPC_HEADER_SIZE, tx_size))
 		return FAIL;
 
 	/* in the case of non-blocking sockets only a part of the header might be sent */
 	if (ZBX_IPC_HEADER_SIZE != *tx_size)
 		return SUCCEED;
 
-	ret = ipc_write_data(csocket->fd, data, size, &size_data);
+	ret = ipc_socket_write_data(csocket, data, size, &size_data);
 	*tx_size += size_data;
 
 	return ret;
@@ -482,13 +982,13 @@ static int	ipc_socket_read_message(zbx_ipc_socket_t *csocket, zbx_uint32_t *head
 			/* long messages will be read directly into message buffer */
 			if (ZBX_IPC_SOCKET_BUFFER_SIZE * 0.75 < data_size)
 			{
-				ret = ipc_read_data_full(csocket->fd, *data + offset, data_size, &read_size);
+				ret = ipc_read_data_full(csocket, *data + offset, data_size, &read_size);
 				*rx_bytes += read_size;
 				goto out;
 			}
 		}
 
-		if (FAIL == ipc_read_data(csocket->fd, csocket->rx_buffer, ZBX_IPC_SOCKET_BUFFER_SIZE, &read_size))
+		if (FAIL == ipc_socket_read_data(csocket, csocket->rx_buffer, ZBX_IPC_SOCKET_BUFFER_SIZE, &read_size))
 			goto out;
 
 		/* it's possible that nothing will be read on non-blocking sockets, return success */
@@ -627,7 +1127,8 @@ static void	ipc_client_pop_tx_message(zbx_ipc_client_t *client)
  * Return value:  FAIL - read error/connection was closed                     *
  *                                                                            *
  * Comments: This function reads data from socket, parses it and adds         *
- *           parsed messages to received messages queue.                      *
+ *           parsed messages to received messages queue. Shared memory        *
+ *           attach requests are processed here and are not queued.           *
  *                                                                            *
  ******************************************************************************/
 static int	ipc_client_read(zbx_ipc_client_t *client)
@@ -644,8 +1145,30 @@ static int	ipc_client_read(zbx_ipc_client_t *client)
 			return FAIL;
 		}
 
-		if (SUCCEED == (rc = ipc_message_is_completed(client->rx_header, client->rx_bytes)))
-			ipc_client_push_rx_message(client);
+		if (SUCCEED != (rc = ipc_message_is_completed(client->rx_header, client->rx_bytes)))
+			continue;
+
+		if (ZBX_IPC_MESSAGE_SHM_ATTACH == client->rx_header[ZBX_IPC_MESSAGE_CODE])
+		{
+			rc = ipc_shm_attach(&client->csocket, client->rx_data, client->rx_header[ZBX_IPC_MESSAGE_SIZE]);
+
+			zbx_free(client->rx_data);
+			client->rx_bytes = 0;
+
+			if (SUCCEED != rc)
+				return FAIL;
+
+			/* data is written to shared memory, socket write events are not used anymore */
+			if (NULL != client->tx_event)
+			{
+				event_free(client->tx_event);
+				client->tx_event = NULL;
+			}
+
+			continue;
+		}
+
+		ipc_client_push_rx_message(client);
 	}
 
 	while (SUCCEED == rc);
@@ -678,7 +1201,7 @@ static int	ipc_client_write(zbx_ipc_client_t *client)
 		size = client->tx_bytes - data_size;
 		offset = ZBX_IPC_HEADER_SIZE - size;
 
-		if (SUCCEED != ipc_write_data(client->csocket.fd, (unsigned char *)client->tx_header + offset, size,
+		if (SUCCEED != ipc_socket_write_data(&client->csocket, (unsigned char *)client->tx_header + offset, size,
 				&write_size))
 		{
 			return FAIL;
@@ -692,7 +1215,7 @@ static int	ipc_client_write(zbx_ipc_client_t *client)
 
 	while (0 < client->tx_bytes)
 	{
-		if (SUCCEED != ipc_write_data(client->csocket.fd, client->tx_data + data_size - client->tx_bytes,
+		if (SUCCEED != ipc_socket_write_data(&client->csocket, client->tx_data + data_size - client->tx_bytes,
 				client->tx_bytes, &write_size))
 		{
 			return FAIL;
@@ -793,6 +1316,7 @@ static void	ipc_service_add_client(zbx_ipc_service_t *service, int fd)
 	client->csocket.fd = fd;
 	client->csocket.rx_buffer_bytes = 0;
 	client->csocket.rx_buffer_offset = 0;
+	client->csocket.shm = NULL;
 	client->id = next_clientid++;
 	client->state = ZBX_IPC_CLIENT_STATE_NONE;
 	client->refcount = 1;
@@ -859,6 +1383,46 @@ zbx_ipc_client_t	*zbx_ipc_client_by_id(const zbx_ipc_service_t *service, zbx_uin
 	return NULL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_client_shm_event                                             *
+ *                                                                            *
+ * Purpose: processes doorbell of service client using shared memory          *
+ *                                                                            *
+ * Parameters: client - [IN] the client                                       *
+ *                                                                            *
+ * Comments: The doorbell can signal both incoming data and freed outgoing    *
+ *           space. Reading and writing might consume doorbells of each       *
+ *           other, so both rings are processed until no progress can be     *
+ *           made.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_client_shm_event(zbx_ipc_client_t *client)
+{
+	zbx_ipc_shm_t	*shm = client->csocket.shm;
+
+	do
+	{
+		if (0 != client->tx_bytes && SUCCEED != ipc_client_write(client))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot send data to IPC client");
+			zbx_ipc_client_close(client);
+			return;
+		}
+
+		if (SUCCEED != ipc_client_read(client))
+		{
+			ipc_client_free_events(client);
+			ipc_service_remove_client(client->service, client);
+			break;
+		}
+	}
+	while (shm->rx->tail != shm->rx->head ||
+			(0 != client->tx_bytes && shm->size != shm->tx->tail - shm->tx->head));
+
+	ipc_service_push_client(client->service, client);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: ipc_client_read_event_cb                                         *
@@ -873,6 +1437,12 @@ static void	ipc_client_read_event_cb(evutil_socket_t fd, short what, void *arg)
 	ZBX_UNUSED(fd);
 	ZBX_UNUSED(what);
 
+	if (NULL != client->csocket.shm)
+	{
+		ipc_client_shm_event(client);
+		return;
+	}
+
 	if (SUCCEED != ipc_client_read(client))
 	{
 		ipc_client_free_events(client);
@@ -1205,6 +1775,7 @@ int	zbx_ipc_socket_open(zbx_ipc_socket_t *csocket, const char *service_name, int
 
 	csocket->rx_buffer_bytes = 0;
 	csocket->rx_buffer_offset = 0;
+	csocket->shm = NULL;
 
 	ret = SUCCEED;
 out:
@@ -1212,6 +1783,79 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_socket_attach_shm                                        *
+ *                                                                            *
+ * Purpose: switches data transfer of connected IPC socket to shared memory   *
+ *                                                                            *
+ * Parameters: csocket - [IN] the IPC socket                                  *
+ *             size    - [IN] the size of each direction ring, rounded up to  *
+ *                            the nearest power of 2                          *
+ *             error   - [OUT] the error message                              *
+ *                                                                            *
+ * Return value: SUCCEED - the shared memory transport was attached           *
+ *               FAIL    - an error occurred, the socket can still be used    *
+ *                         for data transfer                                  *
+ *                                                                            *
+ * Comments: A shared memory segment with two single producer/single consumer *
+ *           rings is created and passed to the service, which attaches it    *
+ *           when processing the request. Afterwards messages are copied      *
+ *           through the rings and the socket is used only to wake up the     *
+ *           other side and to detect closed connection.                      *
+ *           Must be called right after the socket is opened, before any      *
+ *           other messages are exchanged.                                    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_socket_attach_shm(zbx_ipc_socket_t *csocket, zbx_uint32_t size, char **error)
+{
+	int			shmid, ret = FAIL;
+	zbx_uint32_t		ring_size = ZBX_IPC_SOCKET_BUFFER_SIZE;
+	zbx_ipc_shm_header_t	*header;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() size:%u", __func__, size);
+
+	while (ring_size < size)
+		ring_size <<= 1;
+
+	if (-1 == (shmid = shmget(IPC_PRIVATE, ZBX_IPC_SHM_HEADER_SIZE + (size_t)ring_size * 2,
+			IPC_CREAT | IPC_EXCL | 0600)))
+	{
+		*error = zbx_dsprintf(*error, "cannot create IPC shared memory: %s", zbx_strerror(errno));
+		goto out;
+	}
+
+	if ((void *)(-1) == (header = (zbx_ipc_shm_header_t *)shmat(shmid, NULL, 0)))
+	{
+		*error = zbx_dsprintf(*error, "cannot attach IPC shared memory: %s", zbx_strerror(errno));
+		(void)shmctl(shmid, IPC_RMID, NULL);
+		goto out;
+	}
+
+	memset(header, 0, ZBX_IPC_SHM_HEADER_SIZE);
+	header->size = ring_size;
+
+	/* service will be woken up by the first message */
+	header->rings[ZBX_IPC_SHM_RING_CLIENT].reader_waiting = 1;
+
+	if (FAIL == zbx_ipc_socket_write(csocket, ZBX_IPC_MESSAGE_SHM_ATTACH, (unsigned char *)&shmid,
+			sizeof(shmid)))
+	{
+		*error = zbx_strdup(*error, "cannot send IPC shared memory attach request");
+		(void)shmctl(shmid, IPC_RMID, NULL);
+		(void)shmdt((void *)header);
+		goto out;
+	}
+
+	ipc_shm_init(csocket, shmid, header, 1);
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_ipc_socket_close                                             *
@@ -1225,6 +1869,9 @@ void	zbx_ipc_socket_close(zbx_ipc_socket_t *csocket)
 {
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	if (NULL != csocket->shm)
+		ipc_shm_free(csocket);
+
 	if (-1 != csocket->fd)
 	{
 		close(csocket->fd);
@@ -1752,7 +2399,9 @@ int	zbx_ipc_client_send(zbx_ipc_client_t *client, zbx_uint32_t code, const unsig
 		client->tx_data = (unsigned char *)zbx_malloc(NULL, size);
 		memcpy(client->tx_data, data, size);
 		client->tx_bytes = ZBX_IPC_HEADER_SIZE + size - tx_size;
-		event_add(client->tx_event, NULL);
+		/* shared memory clients are flushed when peer rings the doorbell */
+		if (NULL != client->tx_event)
+			event_add(client->tx_event, NULL);
 	}
 
 	ret = SUCCEED;
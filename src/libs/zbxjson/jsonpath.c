@@ -41,9 +41,55 @@ zbx_json_element_t;
 ZBX_VECTOR_DECL(json, zbx_json_element_t)
 ZBX_VECTOR_IMPL(json, zbx_json_element_t)
 
-static int	jsonpath_query_object(const struct zbx_json_parse *jp_root, const struct zbx_json_parse *jp,
+/* object/array location in json document */
+typedef struct
+{
+	const char	*start;		/* opening bracket */
+	const char	*end;		/* matching closing bracket */
+}
+zbx_jsonpath_bracket_t;
+
+/* Structural index of json document - the locations of all objects and arrays sorted by their start. */
+/* It allows to skip nested objects/arrays without scanning them when the same document is queried  */
+/* by multiple paths.                                                                                */
+struct zbx_jsonpath_index
+{
+	struct zbx_json_parse	jp;
+	zbx_jsonpath_bracket_t	*brackets;
+	int			brackets_num;
+};
+
+/* jsonpath query context */
+typedef struct
+{
+	const struct zbx_json_parse	*root;	/* the document root */
+	const zbx_jsonpath_index_t	*index;	/* the document index, optional */
+}
+zbx_jsonpath_context_t;
+
+#define ZBX_JSONPATH_CACHE_SIZE	1024	/* the maximum number of compiled jsonpaths cached per thread */
+
+typedef struct
+{
+	char		*path;
+	zbx_jsonpath_t	jsonpath;
+	zbx_uint64_t	lastaccess;
+}
+zbx_jsonpath_cache_entry_t;
+
+typedef struct
+{
+	zbx_hashset_t	entries;
+	zbx_uint64_t	lastaccess;	/* access counter, used to find the least recently used jsonpaths */
+	int		initialized;
+}
+zbx_jsonpath_cache_t;
+
+static ZBX_THREAD_LOCAL zbx_jsonpath_cache_t	jsonpath_cache;
+
+static int	jsonpath_query_object(const zbx_jsonpath_context_t *ctx, const struct zbx_json_parse *jp,
 		const zbx_jsonpath_t *jsonpath, int path_depth, zbx_vector_json_t *objects);
-static int	jsonpath_query_array(const struct zbx_json_parse *jp_root, const struct zbx_json_parse *jp,
+static int	jsonpath_query_array(const zbx_jsonpath_context_t *ctx, const struct zbx_json_parse *jp,
 		const zbx_jsonpath_t *jsonpath, int path_depth, zbx_vector_json_t *objects);
 
 typedef struct
@@ -1302,6 +1348,122 @@ static int	jsonpath_parse_name_reference(const char *start, zbx_jsonpath_t *json
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_index_find                                              *
+ *                                                                            *
+ * Purpose: find closing bracket of the specified object/array in document    *
+ *          index                                                             *
+ *                                                                            *
+ * Parameters: index - [IN] the document index                                *
+ *             p     - [IN] the object/array opening bracket                  *
+ *                                                                            *
+ * Return value: the closing bracket or NULL if the location is not indexed   *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*jsonpath_index_find(const zbx_jsonpath_index_t *index, const char *p)
+{
+	int	lo = 0, hi = index->brackets_num - 1, mid;
+
+	while (lo <= hi)
+	{
+		mid = lo + (hi - lo) / 2;
+
+		if (index->brackets[mid].start == p)
+			return index->brackets[mid].end;
+
+		if (index->brackets[mid].start < p)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_brackets_open                                           *
+ *                                                                            *
+ * Purpose: open object/array, using document index if available              *
+ *                                                                            *
+ * Parameters: ctx - [IN] the query context                                   *
+ *             p   - [IN] the object/array opening bracket                    *
+ *             jp  - [OUT] json parse data with start/end set                 *
+ *                                                                            *
+ * Return value: SUCCEED - the object/array was opened successfully           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	jsonpath_brackets_open(const zbx_jsonpath_context_t *ctx, const char *p, struct zbx_json_parse *jp)
+{
+	if (NULL != ctx->index && NULL != (jp->end = jsonpath_index_find(ctx->index, p)))
+	{
+		jp->start = p;
+		return SUCCEED;
+	}
+
+	return zbx_json_brackets_open(p, jp);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_skip_element                                            *
+ *                                                                            *
+ * Purpose: skip object/array element, using document index to jump over      *
+ *          nested objects/arrays                                             *
+ *                                                                            *
+ * Parameters: ctx - [IN] the query context                                   *
+ *             jp  - [IN] the parent object/array                             *
+ *             p   - [IN] the element (object member value or array element)  *
+ *                                                                            *
+ * Return value: The delimiter after element or the parent closing bracket.   *
+ *               If index is not available the element itself is returned, so *
+ *               it can be passed to zbx_json_next() and zbx_json_pair_next() *
+ *               in both cases.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*jsonpath_skip_element(const zbx_jsonpath_context_t *ctx, const struct zbx_json_parse *jp,
+		const char *p)
+{
+	const char	*ptr, *end;
+	int		state = 0;	/* 0 - outside string; 1 - inside string */
+
+	if (NULL == ctx->index || NULL == p)
+		return p;
+
+	for (ptr = p; ptr <= jp->end; ptr++)
+	{
+		switch (*ptr)
+		{
+			case '"':
+				state = (0 == state) ? 1 : 0;
+				break;
+			case '\\':
+				if (1 == state)
+					ptr++;
+				break;
+			case '[':
+			case '{':
+				if (0 == state)
+				{
+					if (NULL == (end = jsonpath_index_find(ctx->index, ptr)))
+						return p;
+					ptr = end;
+				}
+				break;
+			case ']':
+			case '}':
+			case ',':
+				if (0 == state)
+					return ptr;
+				break;
+		}
+	}
+
+	return p;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: jsonpath_pointer_to_jp                                           *
@@ -1309,18 +1471,19 @@ static int	jsonpath_parse_name_reference(const char *start, zbx_jsonpath_t *json
  * Purpose: convert a pointer to an object/array/value in json data to        *
  *          json parse structure                                              *
  *                                                                            *
- * Parameters: pnext - [IN] a pointer to object/array/value data              *
+ * Parameters: ctx   - [IN] the query context                                 *
+ *             pnext - [IN] a pointer to object/array/value data              *
  *             jp    - [OUT] json parse data with start/end set               *
  *                                                                            *
  * Return value: SUCCEED - pointer was converted successfully                 *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_pointer_to_jp(const char *pnext, struct zbx_json_parse *jp)
+static int	jsonpath_pointer_to_jp(const zbx_jsonpath_context_t *ctx, const char *pnext, struct zbx_json_parse *jp)
 {
 	if ('[' == *pnext || '{' == *pnext)
 	{
-		return zbx_json_brackets_open(pnext, jp);
+		return jsonpath_brackets_open(ctx, pnext, jp);
 	}
 	else
 	{
@@ -1336,7 +1499,7 @@ static int	jsonpath_pointer_to_jp(const char *pnext, struct zbx_json_parse *jp)
  *                                                                            *
  * Purpose: perform the rest of jsonpath query on json data                   *
  *                                                                            *
- * Parameters: jp_root    - [IN] the document root                            *
+ * Parameters: ctx        - [IN] the query context                            *
  *             pnext      - [IN] a pointer to object/array/value in json data *
  *             jsonpath   - [IN] the jsonpath                                 *
  *             path_depth - [IN] the jsonpath segment to match                *
@@ -1346,7 +1509,7 @@ static int	jsonpath_pointer_to_jp(const char *pnext, struct zbx_json_parse *jp)
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_query_contents(const struct zbx_json_parse *jp_root, const char *pnext,
+static int	jsonpath_query_contents(const zbx_jsonpath_context_t *ctx, const char *pnext,
 		const zbx_jsonpath_t *jsonpath, int path_depth, zbx_vector_json_t *objects)
 {
 	struct zbx_json_parse	jp_child;
@@ -1354,15 +1517,15 @@ static int	jsonpath_query_contents(const struct zbx_json_parse *jp_root, const c
 	switch (*pnext)
 	{
 		case '{':
-			if (FAIL == zbx_json_brackets_open(pnext, &jp_child))
+			if (FAIL == jsonpath_brackets_open(ctx, pnext, &jp_child))
 				return FAIL;
 
-			return jsonpath_query_object(jp_root, &jp_child, jsonpath, path_depth, objects);
+			return jsonpath_query_object(ctx, &jp_child, jsonpath, path_depth, objects);
 		case '[':
-			if (FAIL == zbx_json_brackets_open(pnext, &jp_child))
+			if (FAIL == jsonpath_brackets_open(ctx, pnext, &jp_child))
 				return FAIL;
 
-			return jsonpath_query_array(jp_root, &jp_child, jsonpath, path_depth, objects);
+			return jsonpath_query_array(ctx, &jp_child, jsonpath, path_depth, objects);
 	}
 	return SUCCEED;
 }
@@ -1373,7 +1536,7 @@ static int	jsonpath_query_contents(const struct zbx_json_parse *jp_root, const c
  *                                                                            *
  * Purpose: query next segment                                                *
  *                                                                            *
- * Parameters: jp_root    - [IN] the document root                            *
+ * Parameters: ctx        - [IN] the query context                            *
  *             name       - [IN] name or index of the next json element       *
  *             pnext      - [IN] a pointer to object/array/value in json data *
  *             jsonpath   - [IN] the jsonpath                                 *
@@ -1384,7 +1547,7 @@ static int	jsonpath_query_contents(const struct zbx_json_parse *jp_root, const c
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_query_next_segment(const struct zbx_json_parse *jp_root, const char *name, const char *pnext,
+static int	jsonpath_query_next_segment(const zbx_jsonpath_context_t *ctx, const char *name, const char *pnext,
 		const zbx_jsonpath_t *jsonpath, int path_depth, zbx_vector_json_t *objects)
 {
 	/* check if jsonpath end has been reached, so we have found matching data */
@@ -1397,7 +1560,7 @@ static int	jsonpath_query_next_segment(const struct zbx_json_parse *jp_root, con
 	}
 
 	/* continue by matching found data against the rest of jsonpath segments */
-	return jsonpath_query_contents(jp_root, pnext, jsonpath, path_depth, objects);
+	return jsonpath_query_contents(ctx, pnext, jsonpath, path_depth, objects);
 }
 
 /******************************************************************************
@@ -1406,7 +1569,7 @@ static int	jsonpath_query_next_segment(const struct zbx_json_parse *jp_root, con
  *                                                                            *
  * Purpose: match object value name against jsonpath segment name list        *
  *                                                                            *
- * Parameters: jp_root    - [IN] the document root                            *
+ * Parameters: ctx        - [IN] the query context                            *
  *             name       - [IN] name or index of the next json element       *
  *             pnext      - [IN] a pointer to object value with the specified *
  *                               name                                         *
@@ -1418,7 +1581,7 @@ static int	jsonpath_query_next_segment(const struct zbx_json_parse *jp_root, con
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_match_name(const struct zbx_json_parse *jp_root, const char *name, const char *pnext,
+static int	jsonpath_match_name(const zbx_jsonpath_context_t *ctx, const char *name, const char *pnext,
 		const zbx_jsonpath_t *jsonpath, int path_depth, zbx_vector_json_t *objects)
 {
 	const zbx_jsonpath_segment_t	*segment = &jsonpath->segments[path_depth];
@@ -1432,7 +1595,7 @@ static int	jsonpath_match_name(const struct zbx_json_parse *jp_root, const char
 	{
 		if (0 == strcmp(name, node->data))
 		{
-			if (FAIL == jsonpath_query_next_segment(jp_root, name, pnext, jsonpath, path_depth, objects))
+			if (FAIL == jsonpath_query_next_segment(ctx, name, pnext, jsonpath, path_depth, objects))
 				return FAIL;
 			break;
 		}
@@ -1660,13 +1823,13 @@ static int	jsonpath_regexp_match(const char *text, const char *pattern, double *
 	zbx_regexp_t	*rxp;
 	const char	*error = NULL;
 
-	if (FAIL == zbx_regexp_compile(pattern, &rxp, &error))
+	if (FAIL == zbx_regexp_compile_cached(pattern, &rxp, &error))
 	{
 		zbx_set_json_strerror("invalid regular expression in JSON path: %s", error);
 		return FAIL;
 	}
 	*result = (0 == zbx_regexp_match_precompiled(text, rxp) ? 1.0 : 0.0);
-	zbx_regexp_free(rxp);
+	zbx_regexp_release(rxp);
 
 	return SUCCEED;
 }
@@ -1677,7 +1840,7 @@ static int	jsonpath_regexp_match(const char *text, const char *pattern, double *
  *                                                                            *
  * Purpose: match json array element/object value against jsonpath expression *
  *                                                                            *
- * Parameters: jp_root    - [IN] the document root                            *
+ * Parameters: ctx        - [IN] the query context                            *
  *             name       - [IN] name or index of the next json element       *
  *             pnext      - [IN] a pointer to array element/object value      *
  *             jsonpath   - [IN] the jsonpath                                 *
@@ -1688,7 +1851,7 @@ static int	jsonpath_regexp_match(const char *text, const char *pattern, double *
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_match_expression(const struct zbx_json_parse *jp_root, const char *name, const char *pnext,
+static int	jsonpath_match_expression(const zbx_jsonpath_context_t *ctx, const char *name, const char *pnext,
 		const zbx_jsonpath_t *jsonpath, int path_depth, zbx_vector_json_t *objects)
 {
 	struct zbx_json_parse	jp;
@@ -1698,7 +1861,7 @@ static int	jsonpath_match_expression(const struct zbx_json_parse *jp_root, const
 	zbx_variant_t		value, *right;
 	double			res;
 
-	if (SUCCEED != jsonpath_pointer_to_jp(pnext, &jp))
+	if (SUCCEED != jsonpath_pointer_to_jp(ctx, pnext, &jp))
 		return FAIL;
 
 	zbx_vector_var_create(&stack);
@@ -1840,7 +2003,7 @@ static int	jsonpath_match_expression(const struct zbx_json_parse *jp_root, const
 		switch (token->type)
 		{
 			case ZBX_JSONPATH_TOKEN_PATH_ABSOLUTE:
-				if (FAIL == jsonpath_extract_value(jp_root, token->data, &value))
+				if (FAIL == jsonpath_extract_value(ctx->root, token->data, &value))
 					zbx_variant_set_none(&value);
 				zbx_vector_var_append_ptr(&stack, &value);
 				break;
@@ -1885,7 +2048,7 @@ static int	jsonpath_match_expression(const struct zbx_json_parse *jp_root, const
 
 	jsonpath_variant_to_boolean(&stack.values[0]);
 	if (SUCCEED != zbx_double_compare(stack.values[0].data.dbl, 0.0))
-		ret = jsonpath_query_next_segment(jp_root, name, pnext, jsonpath, path_depth, objects);
+		ret = jsonpath_query_next_segment(ctx, name, pnext, jsonpath, path_depth, objects);
 out:
 	for (i = 0; i < stack.values_num; i++)
 		zbx_variant_clear(&stack.values[i]);
@@ -1900,7 +2063,7 @@ out:
  *                                                                            *
  * Purpose: query object fields for jsonpath segment match                    *
  *                                                                            *
- * Parameters: jp_root    - [IN] the document root                            *
+ * Parameters: ctx        - [IN] the query context                            *
  *             jp         - [IN] the json object to query                     *
  *             jsonpath   - [IN] the jsonpath                                 *
  *             path_depth - [IN] the jsonpath segment to match                *
@@ -1910,7 +2073,7 @@ out:
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_query_object(const struct zbx_json_parse *jp_root, const struct zbx_json_parse *jp,
+static int	jsonpath_query_object(const zbx_jsonpath_context_t *ctx, const struct zbx_json_parse *jp,
 		const zbx_jsonpath_t *jsonpath, int path_depth, zbx_vector_json_t *objects)
 {
 	const char			*pnext = NULL;
@@ -1920,25 +2083,26 @@ static int	jsonpath_query_object(const struct zbx_json_parse *jp_root, const str
 
 	segment = &jsonpath->segments[path_depth];
 
-	while (NULL != (pnext = zbx_json_pair_next(jp, pnext, name, sizeof(name))) && SUCCEED == ret)
+	while (NULL != (pnext = zbx_json_pair_next(jp, jsonpath_skip_element(ctx, jp, pnext), name, sizeof(name))) &&
+			SUCCEED == ret)
 	{
 		switch (segment->type)
 		{
 			case ZBX_JSONPATH_SEGMENT_MATCH_ALL:
-				ret = jsonpath_query_next_segment(jp_root, name, pnext, jsonpath, path_depth, objects);
+				ret = jsonpath_query_next_segment(ctx, name, pnext, jsonpath, path_depth, objects);
 				break;
 			case ZBX_JSONPATH_SEGMENT_MATCH_LIST:
-				ret = jsonpath_match_name(jp_root, name, pnext, jsonpath, path_depth, objects);
+				ret = jsonpath_match_name(ctx, name, pnext, jsonpath, path_depth, objects);
 				break;
 			case ZBX_JSONPATH_SEGMENT_MATCH_EXPRESSION:
-				ret = jsonpath_match_expression(jp_root, name, pnext, jsonpath, path_depth, objects);
+				ret = jsonpath_match_expression(ctx, name, pnext, jsonpath, path_depth, objects);
 				break;
 			default:
 				break;
 		}
 
 		if (1 == segment->detached)
-			ret = jsonpath_query_contents(jp_root, pnext, jsonpath, path_depth, objects);
+			ret = jsonpath_query_contents(ctx, pnext, jsonpath, path_depth, objects);
 	}
 
 	return ret;
@@ -1950,7 +2114,7 @@ static int	jsonpath_query_object(const struct zbx_json_parse *jp_root, const str
  *                                                                            *
  * Purpose: match array element against segment index list                    *
  *                                                                            *
- * Parameters: jp_root      - [IN] the document root                          *
+ * Parameters: ctx          - [IN] the query context                          *
  *             name         - [IN] the json element name (index)              *
  *             pnext        - [IN] a pointer to an array element              *
  *             jsonpath     - [IN] the jsonpath                               *
@@ -1963,7 +2127,7 @@ static int	jsonpath_query_object(const struct zbx_json_parse *jp_root, const str
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_match_index(const struct zbx_json_parse *jp_root, const char *name, const char *pnext,
+static int	jsonpath_match_index(const zbx_jsonpath_context_t *ctx, const char *name, const char *pnext,
 		const zbx_jsonpath_t *jsonpath, int path_depth, int index, int elements_num, zbx_vector_json_t *objects)
 {
 	const zbx_jsonpath_segment_t	*segment = &jsonpath->segments[path_depth];
@@ -1981,7 +2145,7 @@ static int	jsonpath_match_index(const struct zbx_json_parse *jp_root, const char
 
 		if ((query_index >= 0 && index == query_index) || index == elements_num + query_index)
 		{
-			if (FAIL == jsonpath_query_next_segment(jp_root, name, pnext, jsonpath, path_depth, objects))
+			if (FAIL == jsonpath_query_next_segment(ctx, name, pnext, jsonpath, path_depth, objects))
 				return FAIL;
 			break;
 		}
@@ -1996,7 +2160,7 @@ static int	jsonpath_match_index(const struct zbx_json_parse *jp_root, const char
  *                                                                            *
  * Purpose: match array element against segment index range                   *
  *                                                                            *
- * Parameters: jp_root      - [IN] the document root                          *
+ * Parameters: ctx          - [IN] the query context                          *
  *             name         - [IN] the json element name (index)              *
  *             pnext        - [IN] a pointer to an array element              *
  *             jsonpath     - [IN] the jsonpath                               *
@@ -2009,7 +2173,7 @@ static int	jsonpath_match_index(const struct zbx_json_parse *jp_root, const char
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_match_range(const struct zbx_json_parse *jp_root, const char *name, const char *pnext,
+static int	jsonpath_match_range(const zbx_jsonpath_context_t *ctx, const char *name, const char *pnext,
 		const zbx_jsonpath_t *jsonpath, int path_depth, int index, int elements_num, zbx_vector_json_t *objects)
 {
 	int				start_index, end_index;
@@ -2025,7 +2189,7 @@ static int	jsonpath_match_range(const struct zbx_json_parse *jp_root, const char
 
 	if (start_index <= index && end_index > index)
 	{
-		if (FAIL == jsonpath_query_next_segment(jp_root, name, pnext, jsonpath, path_depth, objects))
+		if (FAIL == jsonpath_query_next_segment(ctx, name, pnext, jsonpath, path_depth, objects))
 			return FAIL;
 	}
 
@@ -2038,7 +2202,7 @@ static int	jsonpath_match_range(const struct zbx_json_parse *jp_root, const char
  *                                                                            *
  * Purpose: query array elements for jsonpath segment match                   *
  *                                                                            *
- * Parameters: jp_root    - [IN] the document root                            *
+ * Parameters: ctx        - [IN] the query context                            *
  *             jp         - [IN] the json array to query                      *
  *             jsonpath   - [IN] the jsonpath                                 *
  *             path_depth - [IN] the jsonpath segment to match                *
@@ -2048,7 +2212,7 @@ static int	jsonpath_match_range(const struct zbx_json_parse *jp_root, const char
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_query_array(const struct zbx_json_parse *jp_root, const struct zbx_json_parse *jp,
+static int	jsonpath_query_array(const zbx_jsonpath_context_t *ctx, const struct zbx_json_parse *jp,
 		const zbx_jsonpath_t *jsonpath, int path_depth, zbx_vector_json_t *objects)
 {
 	const char		*pnext = NULL;
@@ -2057,10 +2221,10 @@ static int	jsonpath_query_array(const struct zbx_json_parse *jp_root, const stru
 
 	segment = &jsonpath->segments[path_depth];
 
-	while (NULL != (pnext = zbx_json_next(jp, pnext)))
+	while (NULL != (pnext = zbx_json_next(jp, jsonpath_skip_element(ctx, jp, pnext))))
 		elements_num++;
 
-	while (NULL != (pnext = zbx_json_next(jp, pnext)) && SUCCEED == ret)
+	while (NULL != (pnext = zbx_json_next(jp, jsonpath_skip_element(ctx, jp, pnext))) && SUCCEED == ret)
 	{
 		char	name[MAX_ID_LEN + 1];
 
@@ -2068,25 +2232,25 @@ static int	jsonpath_query_array(const struct zbx_json_parse *jp_root, const stru
 		switch (segment->type)
 		{
 			case ZBX_JSONPATH_SEGMENT_MATCH_ALL:
-				ret = jsonpath_query_next_segment(jp_root, name, pnext, jsonpath, path_depth, objects);
+				ret = jsonpath_query_next_segment(ctx, name, pnext, jsonpath, path_depth, objects);
 				break;
 			case ZBX_JSONPATH_SEGMENT_MATCH_LIST:
-				ret = jsonpath_match_index(jp_root, name, pnext, jsonpath, path_depth, index,
+				ret = jsonpath_match_index(ctx, name, pnext, jsonpath, path_depth, index,
 						elements_num, objects);
 				break;
 			case ZBX_JSONPATH_SEGMENT_MATCH_RANGE:
-				ret = jsonpath_match_range(jp_root, name, pnext, jsonpath, path_depth, index,
+				ret = jsonpath_match_range(ctx, name, pnext, jsonpath, path_depth, index,
 						elements_num, objects);
 				break;
 			case ZBX_JSONPATH_SEGMENT_MATCH_EXPRESSION:
-				ret = jsonpath_match_expression(jp_root, name, pnext, jsonpath, path_depth, objects);
+				ret = jsonpath_match_expression(ctx, name, pnext, jsonpath, path_depth, objects);
 				break;
 			default:
 				break;
 		}
 
 		if (1 == segment->detached)
-			ret = jsonpath_query_contents(jp_root, pnext, jsonpath, path_depth, objects);
+			ret = jsonpath_query_contents(ctx, pnext, jsonpath, path_depth, objects);
 
 		index++;
 	}
@@ -2378,7 +2542,8 @@ static int	jsonpath_apply_functions(const struct zbx_json_parse *jp_root, const
  *                                                                            *
  * Purpose: format query result, depending on jsonpath type                   *
  *                                                                            *
- * Parameters: objects  - [IN] the matched json elements (name, value)        *
+ * Parameters: ctx      - [IN] the query context                              *
+ *             objects  - [IN] the matched json elements (name, value)        *
  *             jsonpath - [IN] the jsonpath used to acquire result            *
  *             output   - [OUT] the output value                              *
  *                                                                            *
@@ -2386,7 +2551,8 @@ static int	jsonpath_apply_functions(const struct zbx_json_parse *jp_root, const
  *               FAIL    - invalid result data (internal json error)          *
  *                                                                            *
  ******************************************************************************/
-static int	jsonpath_format_query_result(const zbx_vector_json_t *objects, zbx_jsonpath_t *jsonpath, char **output)
+static int	jsonpath_format_query_result(const zbx_jsonpath_context_t *ctx, const zbx_vector_json_t *objects,
+		const zbx_jsonpath_t *jsonpath, char **output)
 {
 	size_t	output_offset = 0, output_alloc;
 	int	i;
@@ -2409,7 +2575,7 @@ static int	jsonpath_format_query_result(const zbx_vector_json_t *objects, zbx_js
 	{
 		struct zbx_json_parse	jp;
 
-		if (FAIL == jsonpath_pointer_to_jp(objects->values[i].value, &jp))
+		if (FAIL == jsonpath_pointer_to_jp(ctx, objects->values[i].value, &jp))
 		{
 			zbx_set_json_strerror("cannot format query result, unrecognized json part starting with: %s",
 					objects->values[i].value);
@@ -2548,11 +2714,130 @@ int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath)
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_jsonpath_query                                               *
+ * Function: jsonpath_cache_hash_func                                         *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_hash_t	jsonpath_cache_hash_func(const void *data)
+{
+	const zbx_jsonpath_cache_entry_t	*entry = (const zbx_jsonpath_cache_entry_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(entry->path);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_cache_compare_func                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	jsonpath_cache_compare_func(const void *d1, const void *d2)
+{
+	const zbx_jsonpath_cache_entry_t	*e1 = (const zbx_jsonpath_cache_entry_t *)d1;
+	const zbx_jsonpath_cache_entry_t	*e2 = (const zbx_jsonpath_cache_entry_t *)d2;
+
+	return strcmp(e1->path, e2->path);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_cache_compare_lastaccess                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	jsonpath_cache_compare_lastaccess(const void *d1, const void *d2)
+{
+	const zbx_jsonpath_cache_entry_t	*e1 = *(const zbx_jsonpath_cache_entry_t * const *)d1;
+	const zbx_jsonpath_cache_entry_t	*e2 = *(const zbx_jsonpath_cache_entry_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->lastaccess, e2->lastaccess);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_cache_evict                                             *
+ *                                                                            *
+ * Purpose: remove the least recently used half of compiled jsonpaths         *
+ *                                                                            *
+ ******************************************************************************/
+static void	jsonpath_cache_evict(void)
+{
+	zbx_vector_ptr_t		entries;
+	zbx_hashset_iter_t		iter;
+	zbx_jsonpath_cache_entry_t	*entry;
+	int				i;
+
+	zbx_vector_ptr_create(&entries);
+	zbx_vector_ptr_reserve(&entries, (size_t)jsonpath_cache.entries.num_data);
+
+	zbx_hashset_iter_reset(&jsonpath_cache.entries, &iter);
+	while (NULL != (entry = (zbx_jsonpath_cache_entry_t *)zbx_hashset_iter_next(&iter)))
+		zbx_vector_ptr_append(&entries, entry);
+
+	zbx_vector_ptr_sort(&entries, jsonpath_cache_compare_lastaccess);
+
+	for (i = 0; i < entries.values_num / 2; i++)
+	{
+		entry = (zbx_jsonpath_cache_entry_t *)entries.values[i];
+		zbx_jsonpath_clear(&entry->jsonpath);
+		zbx_free(entry->path);
+		zbx_hashset_remove_direct(&jsonpath_cache.entries, entry);
+	}
+
+	zbx_vector_ptr_destroy(&entries);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_compile_cached                                          *
+ *                                                                            *
+ * Purpose: get compiled jsonpath from the thread local cache, compiling and  *
+ *          caching it if necessary                                           *
+ *                                                                            *
+ * Parameters: path - [IN] the jsonpath                                       *
+ *                                                                            *
+ * Return value: The compiled jsonpath or NULL in the case of compilation     *
+ *               error. The returned jsonpath is owned by cache.              *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_jsonpath_t	*jsonpath_compile_cached(const char *path)
+{
+	zbx_jsonpath_cache_entry_t	entry_local, *entry;
+
+	if (0 == jsonpath_cache.initialized)
+	{
+		zbx_hashset_create(&jsonpath_cache.entries, ZBX_JSONPATH_CACHE_SIZE, jsonpath_cache_hash_func,
+				jsonpath_cache_compare_func);
+		jsonpath_cache.initialized = 1;
+	}
+
+	entry_local.path = (char *)path;
+
+	if (NULL == (entry = (zbx_jsonpath_cache_entry_t *)zbx_hashset_search(&jsonpath_cache.entries, &entry_local)))
+	{
+		if (FAIL == zbx_jsonpath_compile(path, &entry_local.jsonpath))
+			return NULL;
+
+		if (ZBX_JSONPATH_CACHE_SIZE <= jsonpath_cache.entries.num_data)
+			jsonpath_cache_evict();
+
+		entry_local.path = zbx_strdup(NULL, path);
+		entry = (zbx_jsonpath_cache_entry_t *)zbx_hashset_insert(&jsonpath_cache.entries, &entry_local,
+				sizeof(entry_local));
+	}
+
+	entry->lastaccess = ++jsonpath_cache.lastaccess;
+
+	return &entry->jsonpath;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_query                                                   *
  *                                                                            *
  * Purpose: perform jsonpath query on the specified json data                 *
  *                                                                            *
  * Parameters: jp     - [IN] the json data                                    *
+ *             index  - [IN] the json data index (optional)                   *
  *             path   - [IN] the jsonpath                                     *
  *             output - [OUT] the output value                                *
  *                                                                            *
@@ -2561,37 +2846,172 @@ int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath)
  *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output)
+static int	jsonpath_query(const struct zbx_json_parse *jp, const zbx_jsonpath_index_t *index, const char *path,
+		char **output)
 {
-	zbx_jsonpath_t		jsonpath;
+	const zbx_jsonpath_t	*jsonpath;
 	int			path_depth = 0, ret = SUCCEED;
 	zbx_vector_json_t	objects;
+	zbx_jsonpath_context_t	ctx;
 
-	if (FAIL == zbx_jsonpath_compile(path, &jsonpath))
+	if (NULL == (jsonpath = jsonpath_compile_cached(path)))
 		return FAIL;
 
+	ctx.root = jp;
+	ctx.index = index;
+
 	zbx_vector_json_create(&objects);
 
 	if ('{' == *jp->start)
-		ret = jsonpath_query_object(jp, jp, &jsonpath, path_depth, &objects);
+		ret = jsonpath_query_object(&ctx, jp, jsonpath, path_depth, &objects);
 	else if ('[' == *jp->start)
-		ret = jsonpath_query_array(jp, jp, &jsonpath, path_depth, &objects);
+		ret = jsonpath_query_array(&ctx, jp, jsonpath, path_depth, &objects);
 
 	if (SUCCEED == ret)
 	{
-		path_depth = jsonpath.segments_num;
-		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath.segments[path_depth - 1].type)
+		path_depth = jsonpath->segments_num;
+		while (0 < path_depth && ZBX_JSONPATH_SEGMENT_FUNCTION == jsonpath->segments[path_depth - 1].type)
 			path_depth--;
 
-		if (path_depth < jsonpath.segments_num)
-			ret = jsonpath_apply_functions(jp, &objects, &jsonpath, path_depth, output);
+		if (path_depth < jsonpath->segments_num)
+			ret = jsonpath_apply_functions(jp, &objects, jsonpath, path_depth, output);
 		else
-			ret = jsonpath_format_query_result(&objects, &jsonpath, output);
+			ret = jsonpath_format_query_result(&ctx, &objects, jsonpath, output);
 	}
 
 	zbx_vector_json_clear_ext(&objects);
 	zbx_vector_json_destroy(&objects);
-	zbx_jsonpath_clear(&jsonpath);
 
 	return ret;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_jsonpath_query                                               *
+ *                                                                            *
+ * Purpose: perform jsonpath query on the specified json data                 *
+ *                                                                            *
+ * Parameters: jp     - [IN] the json data                                    *
+ *             path   - [IN] the jsonpath                                     *
+ *             output - [OUT] the output value                                *
+ *                                                                            *
+ * Return value: SUCCEED - the query was performed successfully (empty result *
+ *                         being counted as successful query)                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Compiled jsonpaths are cached and reused by subsequent queries.  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonpath_query(const struct zbx_json_parse *jp, const char *path, char **output)
+{
+	return jsonpath_query(jp, NULL, path, output);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_jsonpath_index_create                                        *
+ *                                                                            *
+ * Purpose: create structural index of json document                          *
+ *                                                                            *
+ * Parameters: jp - [IN] the json document, must be validated with            *
+ *                       zbx_json_open()                                      *
+ *                                                                            *
+ * Return value: The created index, must be freed with                        *
+ *               zbx_jsonpath_index_free().                                   *
+ *                                                                            *
+ * Comments: The index refers to json document data, so the data must stay   *
+ *           valid and unchanged while the index is used.                     *
+ *                                                                            *
+ ******************************************************************************/
+zbx_jsonpath_index_t	*zbx_jsonpath_index_create(const struct zbx_json_parse *jp)
+{
+	zbx_jsonpath_index_t	*index;
+	const char		*ptr;
+	int			state = 0, brackets_alloc = 16, *stack, stack_num = 0, stack_alloc = 16;
+
+	index = (zbx_jsonpath_index_t *)zbx_malloc(NULL, sizeof(zbx_jsonpath_index_t));
+	index->jp = *jp;
+	index->brackets_num = 0;
+	index->brackets = (zbx_jsonpath_bracket_t *)zbx_malloc(NULL, sizeof(zbx_jsonpath_bracket_t) *
+			(size_t)brackets_alloc);
+	stack = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)stack_alloc);
+
+	for (ptr = jp->start; ptr <= jp->end; ptr++)
+	{
+		switch (*ptr)
+		{
+			case '"':
+				state = (0 == state) ? 1 : 0;
+				break;
+			case '\\':
+				if (1 == state)
+					ptr++;
+				break;
+			case '[':
+			case '{':
+				if (0 != state)
+					break;
+
+				if (brackets_alloc == index->brackets_num)
+				{
+					brackets_alloc *= 2;
+					index->brackets = (zbx_jsonpath_bracket_t *)zbx_realloc(index->brackets,
+							sizeof(zbx_jsonpath_bracket_t) * (size_t)brackets_alloc);
+				}
+
+				if (stack_alloc == stack_num)
+				{
+					stack_alloc *= 2;
+					stack = (int *)zbx_realloc(stack, sizeof(int) * (size_t)stack_alloc);
+				}
+
+				index->brackets[index->brackets_num].start = ptr;
+				index->brackets[index->brackets_num].end = NULL;
+				stack[stack_num++] = index->brackets_num++;
+				break;
+			case ']':
+			case '}':
+				if (0 == state && 0 != stack_num)
+					index->brackets[stack[--stack_num]].end = ptr;
+				break;
+		}
+	}
+
+	zbx_free(stack);
+
+	return index;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_jsonpath_index_free                                          *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_jsonpath_index_free(zbx_jsonpath_index_t *index)
+{
+	zbx_free(index->brackets);
+	zbx_free(index);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_jsonpath_query_index                                         *
+ *                                                                            *
+ * Purpose: perform jsonpath query on indexed json data                       *
+ *                                                                            *
+ * Parameters: index  - [IN] the json data index                              *
+ *             path   - [IN] the jsonpath                                     *
+ *             output - [OUT] the output value                                *
+ *                                                                            *
+ * Return value: SUCCEED - the query was performed successfully (empty result *
+ *                         being counted as successful query)                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Use this function instead of zbx_jsonpath_query() when the same  *
+ *           document is queried multiple times.                              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonpath_query_index(const zbx_jsonpath_index_t *index, const char *path, char **output)
+{
+	return jsonpath_query(&index->jp, index, path, output);
+}
@@ -199,6 +199,8 @@ int	parse_rtc_options(const char *opt, unsigned char program_type, int *message)
 					scope = ZBX_DIAGINFO_LLD;
 				else if (0 == strcmp(section, ZBX_DIAG_ALERTING))
 					scope = ZBX_DIAGINFO_ALERTING;
+				else if (0 == strcmp(section, ZBX_DIAG_HISTORYSTORAGE))
+					scope = ZBX_DIAGINFO_HISTORYSTORAGE;
 			}
 
 			if (0 == scope)
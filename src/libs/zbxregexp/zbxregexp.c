@@ -25,6 +25,7 @@ struct zbx_regexp
 {
 	pcre			*pcre_regexp;
 	struct pcre_extra	*extra;
+	int			refcount;	/* the number of zbx_regexp_compile_cached() users */
 };
 
 /* maps to ovector of pcre_exec() */
@@ -39,6 +40,41 @@ zbx_regmatch_t;
 					/* Group \0 contains the matching part of string, groups \1 ...\9 */
 					/* contain captured groups (substrings).                          */
 
+#define ZBX_REGEXP_CACHE_SIZE	128	/* the maximum number of compiled regular expressions cached per thread */
+
+/* compile regular expressions to machine code when pcre is built with JIT support */
+#ifdef PCRE_STUDY_JIT_COMPILE
+#	define ZBX_REGEXP_STUDY_OPTIONS	PCRE_STUDY_JIT_COMPILE
+#else
+#	define ZBX_REGEXP_STUDY_OPTIONS	0
+#endif
+
+typedef struct zbx_regexp_cache_entry
+{
+	char				*pattern;
+	int				flags;
+	zbx_regexp_t			*regexp;
+	const char			*error;		/* static compilation error if regexp is NULL */
+
+	/* least recently used list, the most recently used entry is at the head */
+	struct zbx_regexp_cache_entry	*prev;
+	struct zbx_regexp_cache_entry	*next;
+}
+zbx_regexp_cache_entry_t;
+
+typedef struct
+{
+	zbx_hashset_t			entries;
+	zbx_regexp_cache_entry_t	*head;
+	zbx_regexp_cache_entry_t	*tail;
+	zbx_uint64_t			hits;
+	zbx_uint64_t			misses;
+	int				initialized;
+}
+zbx_regexp_cache_t;
+
+static ZBX_THREAD_LOCAL zbx_regexp_cache_t	regexp_cache;
+
 /******************************************************************************
  *                                                                            *
  * Function: regexp_compile                                                   *
@@ -51,6 +87,7 @@ zbx_regmatch_t;
  *                      NULL is not allowed.                                  *
  *     flags     - [IN] regexp compilation parameters passed to pcre_compile. *
  *                      PCRE_CASELESS, PCRE_NO_AUTO_CAPTURE, PCRE_MULTILINE.  *
+ *     study_options - [IN] options passed to pcre_study                      *
  *     regexp    - [OUT] output regexp.                                       *
  *     err_msg_static - [OUT] error message if any. Do not deallocate with    *
  *                            zbx_free().                                     *
@@ -58,7 +95,8 @@ zbx_regmatch_t;
  * Return value: SUCCEED or FAIL                                              *
  *                                                                            *
  ******************************************************************************/
-static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp, const char **err_msg_static)
+static int	regexp_compile(const char *pattern, int flags, int study_options, zbx_regexp_t **regexp,
+		const char **err_msg_static)
 {
 	int			error_offset = -1;
 	pcre			*pcre_regexp;
@@ -94,7 +132,7 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 
 	if (NULL != regexp)
 	{
-		if (NULL == (extra = pcre_study(pcre_regexp, 0, err_msg_static)) && NULL != *err_msg_static)
+		if (NULL == (extra = pcre_study(pcre_regexp, study_options, err_msg_static)) && NULL != *err_msg_static)
 		{
 			pcre_free(pcre_regexp);
 			return FAIL;
@@ -103,6 +141,7 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 		*regexp = (zbx_regexp_t *)zbx_malloc(NULL, sizeof(zbx_regexp_t));
 		(*regexp)->pcre_regexp = pcre_regexp;
 		(*regexp)->extra = extra;
+		(*regexp)->refcount = 0;
 	}
 	else
 		pcre_free(pcre_regexp);
@@ -120,9 +159,9 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 int	zbx_regexp_compile(const char *pattern, zbx_regexp_t **regexp, const char **err_msg_static)
 {
 #ifdef PCRE_NO_AUTO_CAPTURE
-	return regexp_compile(pattern, PCRE_MULTILINE | PCRE_NO_AUTO_CAPTURE, regexp, err_msg_static);
+	return regexp_compile(pattern, PCRE_MULTILINE | PCRE_NO_AUTO_CAPTURE, 0, regexp, err_msg_static);
 #else
-	return regexp_compile(pattern, PCRE_MULTILINE, regexp, err_msg_static);
+	return regexp_compile(pattern, PCRE_MULTILINE, 0, regexp, err_msg_static);
 #endif
 }
 
@@ -135,46 +174,264 @@ int	zbx_regexp_compile(const char *pattern, zbx_regexp_t **regexp, const char **
  *******************************************************/
 int	zbx_regexp_compile_ext(const char *pattern, zbx_regexp_t **regexp, int flags, const char **err_msg_static)
 {
-	return regexp_compile(pattern, flags, regexp, err_msg_static);
+	return regexp_compile(pattern, flags, 0, regexp, err_msg_static);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: regexp_cache_hash_func                                           *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_hash_t	regexp_cache_hash_func(const void *data)
+{
+	const zbx_regexp_cache_entry_t	*entry = (const zbx_regexp_cache_entry_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_FUNC(entry->pattern);
+	return ZBX_DEFAULT_HASH_ALGO(&entry->flags, sizeof(entry->flags), hash);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: regexp_cache_compare_func                                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	regexp_cache_compare_func(const void *d1, const void *d2)
+{
+	const zbx_regexp_cache_entry_t	*e1 = (const zbx_regexp_cache_entry_t *)d1;
+	const zbx_regexp_cache_entry_t	*e2 = (const zbx_regexp_cache_entry_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->flags, e2->flags);
+
+	return strcmp(e1->pattern, e2->pattern);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: regexp_cache_lru_unlink                                          *
+ *                                                                            *
+ * Purpose: removes cache entry from the least recently used list             *
+ *                                                                            *
+ ******************************************************************************/
+static void	regexp_cache_lru_unlink(zbx_regexp_cache_entry_t *entry)
+{
+	if (NULL != entry->prev)
+		entry->prev->next = entry->next;
+	else
+		regexp_cache.head = entry->next;
+
+	if (NULL != entry->next)
+		entry->next->prev = entry->prev;
+	else
+		regexp_cache.tail = entry->prev;
+
+	entry->prev = entry->next = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: regexp_cache_lru_push                                            *
+ *                                                                            *
+ * Purpose: marks cache entry as the most recently used one                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	regexp_cache_lru_push(zbx_regexp_cache_entry_t *entry)
+{
+	entry->prev = NULL;
+
+	if (NULL != (entry->next = regexp_cache.head))
+		regexp_cache.head->prev = entry;
+	else
+		regexp_cache.tail = entry;
+
+	regexp_cache.head = entry;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: regexp_cache_evict                                               *
+ *                                                                            *
+ * Purpose: removes the least recently used regular expression that is not    *
+ *          in use from cache                                                 *
+ *                                                                            *
+ * Comments: If all cached regexps are in use nothing is removed and the      *
+ *           cache grows over ZBX_REGEXP_CACHE_SIZE until they are released.  *
+ *                                                                            *
+ ******************************************************************************/
+static void	regexp_cache_evict(void)
+{
+	zbx_regexp_cache_entry_t	*entry;
+
+	for (entry = regexp_cache.tail; NULL != entry; entry = entry->prev)
+	{
+		if (NULL == entry->regexp || 0 == entry->regexp->refcount)
+			break;
+	}
+
+	if (NULL == entry)
+		return;
+
+	regexp_cache_lru_unlink(entry);
+
+	if (NULL != entry->regexp)
+		zbx_regexp_free(entry->regexp);
+
+	zbx_free(entry->pattern);
+	zbx_hashset_remove_direct(&regexp_cache.entries, entry);
 }
 
 /****************************************************************************************************
  *                                                                                                  *
  * Function: regexp_prepare                                                                         *
  *                                                                                                  *
- * Purpose: wrapper for zbx_regexp_compile. Caches and reuses the last used regexp.                 *
+ * Purpose: wrapper for regexp_compile. Caches and reuses the recently used regexps.                *
+ *                                                                                                  *
+ * Parameters:                                                                                      *
+ *     pattern        - [IN] regular expression as a text string                                    *
+ *     flags          - [IN] regexp compilation parameters passed to pcre_compile                   *
+ *     regexp         - [OUT] the compiled regular expression, owned by cache                       *
+ *     err_msg_static - [OUT] error message if any. Do not deallocate with zbx_free().              *
+ *                                                                                                  *
+ * Return value: SUCCEED or FAIL                                                                    *
+ *                                                                                                  *
+ * Comments: Compilation failures are cached too, so invalid patterns are not recompiled for every  *
+ *           matched value. Unless pinned by increasing its reference counter the returned regexp   *
+ *           stays valid only until other patterns are prepared by the same thread.                 *
  *                                                                                                  *
  ****************************************************************************************************/
 static int	regexp_prepare(const char *pattern, int flags, zbx_regexp_t **regexp, const char **err_msg_static)
 {
-	static ZBX_THREAD_LOCAL zbx_regexp_t	*curr_regexp = NULL;
-	static ZBX_THREAD_LOCAL char		*curr_pattern = NULL;
-	static ZBX_THREAD_LOCAL int		curr_flags = 0;
-	int					ret = SUCCEED;
+	zbx_regexp_cache_entry_t	entry_local, *entry;
 
-	if (NULL == curr_regexp || 0 != strcmp(curr_pattern, pattern) || curr_flags != flags)
+	if (0 == regexp_cache.initialized)
 	{
-		if (NULL != curr_regexp)
+		zbx_hashset_create(&regexp_cache.entries, ZBX_REGEXP_CACHE_SIZE, regexp_cache_hash_func,
+				regexp_cache_compare_func);
+		regexp_cache.initialized = 1;
+	}
+
+	entry_local.pattern = (char *)pattern;
+	entry_local.flags = flags;
+
+	if (NULL != (entry = (zbx_regexp_cache_entry_t *)zbx_hashset_search(&regexp_cache.entries, &entry_local)))
+	{
+		regexp_cache.hits++;
+
+		if (entry != regexp_cache.head)
 		{
-			zbx_regexp_free(curr_regexp);
-			zbx_free(curr_pattern);
+			regexp_cache_lru_unlink(entry);
+			regexp_cache_lru_push(entry);
 		}
+	}
+	else
+	{
+		regexp_cache.misses++;
 
-		curr_regexp = NULL;
-		curr_pattern = NULL;
-		curr_flags = 0;
+		if (ZBX_REGEXP_CACHE_SIZE <= regexp_cache.entries.num_data)
+			regexp_cache_evict();
 
-		if (SUCCEED == regexp_compile(pattern, flags, &curr_regexp, err_msg_static))
+		entry_local.regexp = NULL;
+		entry_local.error = NULL;
+
+		if (SUCCEED != regexp_compile(pattern, flags, ZBX_REGEXP_STUDY_OPTIONS, &entry_local.regexp,
+				&entry_local.error) && NULL == entry_local.error)
 		{
-			curr_pattern = zbx_strdup(curr_pattern, pattern);
-			curr_flags = flags;
+			entry_local.error = "cannot compile regular expression";
 		}
-		else
-			ret = FAIL;
+
+		entry_local.pattern = zbx_strdup(NULL, pattern);
+		entry = (zbx_regexp_cache_entry_t *)zbx_hashset_insert(&regexp_cache.entries, &entry_local,
+				sizeof(entry_local));
+		regexp_cache_lru_push(entry);
 	}
 
-	*regexp = curr_regexp;
-	return ret;
+	if (NULL == (*regexp = entry->regexp))
+	{
+		*err_msg_static = entry->error;
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_regexp_compile_cached                                        *
+ *                                                                            *
+ * Purpose: gets compiled regular expression from the thread local cache,     *
+ *          compiling it if necessary                                         *
+ *                                                                            *
+ * Parameters: pattern        - [IN] regular expression as a text string      *
+ *             regexp         - [OUT] the compiled regular expression         *
+ *             err_msg_static - [OUT] error message if any. Do not deallocate *
+ *                                    with zbx_free().                        *
+ *                                                                            *
+ * Return value: SUCCEED or FAIL                                              *
+ *                                                                            *
+ * Comments: The returned regexp is owned by cache and is pinned in it, so    *
+ *           it stays valid while other regexps are compiled or matched in    *
+ *           the same thread. It must be released with zbx_regexp_release()   *
+ *           instead of freeing.                                              *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_regexp_compile_cached(const char *pattern, zbx_regexp_t **regexp, const char **err_msg_static)
+{
+#ifdef PCRE_NO_AUTO_CAPTURE
+	return zbx_regexp_compile_cached_ext(pattern, regexp, PCRE_MULTILINE | PCRE_NO_AUTO_CAPTURE,
+			err_msg_static);
+#else
+	return zbx_regexp_compile_cached_ext(pattern, regexp, PCRE_MULTILINE, err_msg_static);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_regexp_compile_cached_ext                                    *
+ *                                                                            *
+ * Purpose: zbx_regexp_compile_cached() with custom compilation flags         *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_regexp_compile_cached_ext(const char *pattern, zbx_regexp_t **regexp, int flags,
+		const char **err_msg_static)
+{
+	if (FAIL == regexp_prepare(pattern, flags, regexp, err_msg_static))
+		return FAIL;
+
+	(*regexp)->refcount++;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_regexp_release                                               *
+ *                                                                            *
+ * Purpose: releases regular expression returned by                           *
+ *          zbx_regexp_compile_cached(), allowing cache to evict it           *
+ *                                                                            *
+ * Parameters: regexp - [IN] the compiled regular expression                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_regexp_release(zbx_regexp_t *regexp)
+{
+	regexp->refcount--;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_regexp_cache_get_stats                                       *
+ *                                                                            *
+ * Purpose: gets compiled regular expression cache statistics of the calling  *
+ *          thread                                                            *
+ *                                                                            *
+ * Parameters: hits   - [OUT] the number of regexps found in cache            *
+ *             misses - [OUT] the number of regexps compiled                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_regexp_cache_get_stats(zbx_uint64_t *hits, zbx_uint64_t *misses)
+{
+	*hits = regexp_cache.hits;
+	*misses = regexp_cache.misses;
 }
 
 /***********************************************************************************
@@ -245,7 +502,17 @@ static int	regexp_exec(const char *string, const zbx_regexp_t *regexp, int flags
 #endif
 #endif
 	/* see "man pcreapi" about pcre_exec() return value and 'ovector' size and layout */
-	if (0 <= (r = pcre_exec(regexp->pcre_regexp, pextra, string, strlen(string), flags, 0, ovector, ovecsize)))
+	r = pcre_exec(regexp->pcre_regexp, pextra, string, strlen(string), flags, 0, ovector, ovecsize);
+#ifdef PCRE_ERROR_JIT_STACKLIMIT
+	/* the default JIT stack is small, fall back to the interpreter which is limited by process stack */
+	if (PCRE_ERROR_JIT_STACKLIMIT == r)
+	{
+		extra = *pextra;
+		extra.flags &= ~PCRE_EXTRA_EXECUTABLE_JIT;
+		r = pcre_exec(regexp->pcre_regexp, &extra, string, strlen(string), flags, 0, ovector, ovecsize);
+	}
+#endif
+	if (0 <= r)
 	{
 		if (NULL != matches)
 			memcpy(matches, ovector, (size_t)((0 < r) ? MIN(r, count) : count) * sizeof(zbx_regmatch_t));
@@ -92,6 +92,8 @@ extern int	CONFIG_UNREACHABLE_POLLER_FORKS;
 extern int	CONFIG_IPMIPOLLER_FORKS;
 extern int	CONFIG_PINGER_FORKS;
 extern int	CONFIG_JAVAPOLLER_FORKS;
+extern int	CONFIG_AGENTPOLLER_FORKS;
+extern int	CONFIG_SNMPPOLLER_FORKS;
 extern int	CONFIG_HTTPPOLLER_FORKS;
 extern int	CONFIG_TRAPPER_FORKS;
 extern int	CONFIG_SNMPTRAPPER_FORKS;
@@ -201,6 +203,10 @@ int	get_process_type_forks(unsigned char proc_type)
 			return CONFIG_LLDWORKER_FORKS;
 		case ZBX_PROCESS_TYPE_ALERTSYNCER:
 			return CONFIG_ALERTDB_FORKS;
+		case ZBX_PROCESS_TYPE_AGENTPOLLER:
+			return CONFIG_AGENTPOLLER_FORKS;
+		case ZBX_PROCESS_TYPE_SNMPPOLLER:
+			return CONFIG_SNMPPOLLER_FORKS;
 	}
 
 	THIS_SHOULD_NEVER_HAPPEN;
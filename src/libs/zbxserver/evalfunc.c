@@ -188,6 +188,36 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: history_value_to_variant                                         *
+ *                                                                            *
+ * Purpose: store history value in variant                                    *
+ *                                                                            *
+ * Parameters: value         - [OUT] the variant                              *
+ *             history_value - [IN] the history value                         *
+ *             value_type    - [IN] the history value type                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	history_value_to_variant(zbx_variant_t *value, const history_value_t *history_value, int value_type)
+{
+	switch (value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			zbx_variant_set_dbl(value, history_value->dbl);
+			break;
+		case ITEM_VALUE_TYPE_UINT64:
+			zbx_variant_set_ui64(value, history_value->ui64);
+			break;
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			zbx_variant_set_str(value, zbx_strdup(NULL, history_value->str));
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			zbx_variant_set_str(value, zbx_strdup(NULL, history_value->log->value));
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: evaluate_LOGEVENTID                                              *
@@ -201,7 +231,7 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_LOGEVENTID(char **value, DC_ITEM *item, const char *parameters,
+static int	evaluate_LOGEVENTID(zbx_variant_t *value, DC_ITEM *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
 	char			*arg1 = NULL;
@@ -256,9 +286,9 @@ static int	evaluate_LOGEVENTID(char **value, DC_ITEM *item, const char *paramete
 		else
 		{
 			if (ZBX_REGEXP_MATCH == regexp_ret)
-				*value = zbx_strdup(*value, "1");
+				zbx_variant_set_ui64(value, 1);
 			else if (ZBX_REGEXP_NO_MATCH == regexp_ret)
-				*value = zbx_strdup(*value, "0");
+				zbx_variant_set_ui64(value, 0);
 
 			ret = SUCCEED;
 		}
@@ -294,7 +324,7 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_LOGSOURCE(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
+static int	evaluate_LOGSOURCE(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		char **error)
 {
 	char			*arg1 = NULL;
@@ -340,11 +370,11 @@ static int	evaluate_LOGSOURCE(char **value, DC_ITEM *item, const char *parameter
 		switch (regexp_match_ex(&regexps, vc_value.value.log->source, arg1, ZBX_CASE_SENSITIVE))
 		{
 			case ZBX_REGEXP_MATCH:
-				*value = zbx_strdup(*value, "1");
+				zbx_variant_set_ui64(value, 1);
 				ret = SUCCEED;
 				break;
 			case ZBX_REGEXP_NO_MATCH:
-				*value = zbx_strdup(*value, "0");
+				zbx_variant_set_ui64(value, 0);
 				ret = SUCCEED;
 				break;
 			case FAIL:
@@ -381,7 +411,7 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_LOGSEVERITY(char **value, DC_ITEM *item, const zbx_timespec_t *ts, char **error)
+static int	evaluate_LOGSEVERITY(zbx_variant_t *value, DC_ITEM *item, const zbx_timespec_t *ts, char **error)
 {
 	int			ret = FAIL;
 	zbx_history_record_t	vc_value;
@@ -396,9 +426,7 @@ static int	evaluate_LOGSEVERITY(char **value, DC_ITEM *item, const zbx_timespec_
 
 	if (SUCCEED == zbx_vc_get_value(item->itemid, item->value_type, ts, &vc_value))
 	{
-		size_t	value_alloc = 0, value_offset = 0;
-
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, "%d", vc_value.value.log->severity);
+		zbx_variant_set_ui64(value, (zbx_uint64_t)vc_value.value.log->severity);
 		zbx_history_record_clear(&vc_value, item->value_type);
 
 		ret = SUCCEED;
@@ -546,7 +574,7 @@ static void	count_one_str(int *count, int op, const char *value, const char *pat
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_COUNT(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
+static int	evaluate_COUNT(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		char **error)
 {
 	int				arg1, op = OP_UNKNOWN, numeric_search, nparams, count = 0, i, ret = FAIL;
@@ -558,7 +586,6 @@ static int	evaluate_COUNT(char **value, DC_ITEM *item, const char *parameters, c
 	zbx_vector_ptr_t		regexps;
 	zbx_vector_history_record_t	values;
 	zbx_timespec_t			ts_end = *ts;
-	size_t				value_alloc = 0, value_offset = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -742,16 +769,16 @@ static int	evaluate_COUNT(char **value, DC_ITEM *item, const char *parameters, c
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
-	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
-	}
-
 	/* skip counting values one by one if both pattern and operator are empty or "" is searched in text values */
 	if ((NULL != arg2 && '\0' != *arg2) || (NULL != arg3 && '\0' != *arg3 &&
 			OP_LIKE != op && OP_REGEXP != op && OP_IREGEXP != op))
 	{
+		if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
+		}
+
 		switch (item->value_type)
 		{
 			case ITEM_VALUE_TYPE_UINT64:
@@ -805,9 +832,19 @@ static int	evaluate_COUNT(char **value, DC_ITEM *item, const char *parameters, c
 		}
 	}
 	else
-		count = values.values_num;
+	{
+		history_value_t	result;
+
+		/* the values are only counted, aggregate them in value cache without copying */
+		if (FAIL == zbx_vc_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_COUNT, seconds, nvalues,
+				&ts_end, &result, &count))
+		{
+			*error = zbx_strdup(*error, "cannot get values from value cache");
+			goto out;
+		}
+	}
 
-	zbx_snprintf_alloc(value, &value_alloc, &value_offset, "%d", count);
+	zbx_variant_set_ui64(value, (zbx_uint64_t)count);
 
 	ret = SUCCEED;
 out:
@@ -850,18 +887,15 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_SUM(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
+static int	evaluate_SUM(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, i, ret = FAIL, seconds = 0, nvalues = 0;
+	int				nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0, values_num;
 	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
 	history_value_t			result;
 	zbx_timespec_t			ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -907,32 +941,16 @@ static int	evaluate_SUM(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_SUM, seconds, nvalues, &ts_end,
+			&result, &values_num))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-	{
-		result.dbl = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.dbl += values.values[i].value.dbl;
-	}
-	else
-	{
-		result.ui64 = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.ui64 += values.values[i].value.ui64;
-	}
-
-	*value = zbx_history_value2str_dyn(&result, item->value_type);
+	history_value_to_variant(value, &result, item->value_type);
 	ret = SUCCEED;
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -951,17 +969,15 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
+static int	evaluate_AVG(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, ret = FAIL, i, seconds = 0, nvalues = 0;
+	int				nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0, values_num;
 	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
+	history_value_t			result;
 	zbx_timespec_t			ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1007,31 +1023,16 @@ static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_AVG, seconds, nvalues, &ts_end,
+			&result, &values_num))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < values_num)
 	{
-		double	avg = 0;
-		size_t	value_alloc = 0, value_offset = 0;
-
-		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.dbl / (i + 1) - avg / (i + 1);
-		}
-		else
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.ui64;
-
-			avg = avg / values.values_num;
-		}
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64, avg);
-
+		zbx_variant_set_dbl(value, result.dbl);
 		ret = SUCCEED;
 	}
 	else
@@ -1040,8 +1041,6 @@ static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, con
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1053,7 +1052,7 @@ out:
  *                                                                            *
  * Purpose: evaluate functions 'last' and 'prev' for the item                 *
  *                                                                            *
- * Parameters: value - dynamic buffer                                         *
+ * Parameters: value - [OUT] the function result                              *
  *             item - item (performance metric)                               *
  *             parameters - Nth last value and time shift (optional)          *
  *                                                                            *
@@ -1061,7 +1060,7 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_LAST(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
+static int	evaluate_LAST(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		char **error)
 {
 	int				arg1 = 1, ret = FAIL;
@@ -1101,29 +1100,7 @@ static int	evaluate_LAST(char **value, DC_ITEM *item, const char *parameters, co
 	{
 		if (arg1 <= values.values_num)
 		{
-			char	*tmp;
-
-			tmp = zbx_history_value2str_dyn(&values.values[arg1 - 1].value, item->value_type);
-
-			if (ITEM_VALUE_TYPE_STR == item->value_type ||
-					ITEM_VALUE_TYPE_TEXT == item->value_type ||
-					ITEM_VALUE_TYPE_LOG == item->value_type)
-			{
-				size_t	len;
-				char	*ptr;
-
-				len = zbx_get_escape_string_len(tmp, "\"\\");
-				ptr = *value = zbx_malloc(NULL, len + 3);
-				*ptr++ = '"';
-				zbx_escape_string(ptr, len + 1, tmp, "\"\\");
-				ptr += len;
-				*ptr++ = '"';
-				*ptr = '\0';
-				zbx_free(tmp);
-			}
-			else
-				*value = tmp;
-
+			history_value_to_variant(value, &values.values[arg1 - 1].value, item->value_type);
 			ret = SUCCEED;
 		}
 		else
@@ -1157,17 +1134,15 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
+static int	evaluate_MIN(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, i, ret = FAIL, seconds = 0, nvalues = 0;
+	int				nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0, values_num;
 	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
+	history_value_t			result;
 	zbx_timespec_t			ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1213,34 +1188,16 @@ static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_MIN, seconds, nvalues, &ts_end,
+			&result, &values_num))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < values_num)
 	{
-		int	index = 0;
-
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.ui64 < values.values[index].value.ui64)
-					index = i;
-			}
-		}
-		else
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.dbl < values.values[index].value.dbl)
-					index = i;
-			}
-		}
-
-		*value = zbx_history_value2str_dyn(&values.values[index].value, item->value_type);
+		history_value_to_variant(value, &result, item->value_type);
 		ret = SUCCEED;
 	}
 	else
@@ -1249,8 +1206,6 @@ static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, con
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1269,17 +1224,15 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
+static int	evaluate_MAX(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, ret = FAIL, i, seconds = 0, nvalues = 0;
+	int				nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0, values_num;
 	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
+	history_value_t			result;
 	zbx_timespec_t			ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1325,35 +1278,16 @@ static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_MAX, seconds, nvalues, &ts_end,
+			&result, &values_num))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < values_num)
 	{
-		int	index = 0;
-
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.ui64 > values.values[index].value.ui64)
-					index = i;
-			}
-		}
-		else
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.dbl > values.values[index].value.dbl)
-					index = i;
-			}
-		}
-
-		*value = zbx_history_value2str_dyn(&values.values[index].value, item->value_type);
-
+		history_value_to_variant(value, &result, item->value_type);
 		ret = SUCCEED;
 	}
 	else
@@ -1362,27 +1296,11 @@ static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, con
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
 }
 
-static int	__history_record_float_compare(const zbx_history_record_t *d1, const zbx_history_record_t *d2)
-{
-	ZBX_RETURN_IF_NOT_EQUAL(d1->value.dbl, d2->value.dbl);
-
-	return 0;
-}
-
-static int	__history_record_uint64_compare(const zbx_history_record_t *d1, const zbx_history_record_t *d2)
-{
-	ZBX_RETURN_IF_NOT_EQUAL(d1->value.ui64, d2->value.ui64);
-
-	return 0;
-}
-
 /******************************************************************************
  *                                                                            *
  * Function: evaluate_PERCENTILE                                              *
@@ -1398,19 +1316,17 @@ static int	__history_record_uint64_compare(const zbx_history_record_t *d1, const
  *               FAIL    - failed to evaluate function                        *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_PERCENTILE(char **value, DC_ITEM *item, const char *parameters,
+static int	evaluate_PERCENTILE(zbx_variant_t *value, DC_ITEM *item, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, time_shift = 0, ret = FAIL, seconds = 0, nvalues = 0;
-	zbx_value_type_t		arg1_type, time_shift_type = ZBX_VALUE_SECONDS;
-	double				percentage;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			nparams, arg1, time_shift = 0, ret = FAIL, seconds = 0, nvalues = 0, values_num;
+	zbx_value_type_t	arg1_type, time_shift_type = ZBX_VALUE_SECONDS;
+	double			percentage;
+	history_value_t		result;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1457,27 +1373,16 @@ static int	evaluate_PERCENTILE(char **value, DC_ITEM *item, const char *paramete
 		goto out;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_get_percentile(item->itemid, item->value_type, seconds, nvalues, &ts_end, percentage,
+			&result, &values_num))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < values_num)
 	{
-		int	index;
-
-		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-			zbx_vector_history_record_sort(&values, (zbx_compare_func_t)__history_record_float_compare);
-		else
-			zbx_vector_history_record_sort(&values, (zbx_compare_func_t)__history_record_uint64_compare);
-
-		if (0 == percentage)
-			index = 1;
-		else
-			index = (int)ceil(values.values_num * (percentage / 100));
-
-		*value = zbx_history_value2str_dyn(&values.values[index - 1].value, item->value_type);
+		history_value_to_variant(value, &result, item->value_type);
 
 		ret = SUCCEED;
 	}
@@ -1487,8 +1392,6 @@ static int	evaluate_PERCENTILE(char **value, DC_ITEM *item, const char *paramete
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1507,18 +1410,16 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_DELTA(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
+static int	evaluate_DELTA(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		char **error)
 {
-	int				nparams, arg1, ret = FAIL, i, seconds = 0, nvalues = 0;
+	int				nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0, values_num;
 	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
+	history_value_t			result;
 	zbx_timespec_t			ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1564,46 +1465,16 @@ static int	evaluate_DELTA(char **value, DC_ITEM *item, const char *parameters, c
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (FAIL == zbx_vc_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_DELTA, seconds, nvalues, &ts_end,
+			&result, &values_num))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < values_num)
 	{
-		history_value_t		result;
-		int			index_min = 0, index_max = 0;
-
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.ui64 > values.values[index_max].value.ui64)
-					index_max = i;
-
-				if (values.values[i].value.ui64 < values.values[index_min].value.ui64)
-					index_min = i;
-			}
-
-			result.ui64 = values.values[index_max].value.ui64 - values.values[index_min].value.ui64;
-		}
-		else
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.dbl > values.values[index_max].value.dbl)
-					index_max = i;
-
-				if (values.values[i].value.dbl < values.values[index_min].value.dbl)
-					index_min = i;
-			}
-
-			result.dbl = values.values[index_max].value.dbl - values.values[index_min].value.dbl;
-		}
-
-		*value = zbx_history_value2str_dyn(&result, item->value_type);
-
+		history_value_to_variant(value, &result, item->value_type);
 		ret = SUCCEED;
 	}
 	else
@@ -1612,8 +1483,6 @@ static int	evaluate_DELTA(char **value, DC_ITEM *item, const char *parameters, c
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1632,7 +1501,7 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_NODATA(char **value, DC_ITEM *item, const char *parameters, char **error)
+static int	evaluate_NODATA(zbx_variant_t *value, DC_ITEM *item, const char *parameters, char **error)
 {
 	int				arg1, num, period, lazy = 1, ret = FAIL;
 	zbx_value_type_t		arg1_type;
@@ -1688,7 +1557,7 @@ static int	evaluate_NODATA(char **value, DC_ITEM *item, const char *parameters,
 			(SUCCEED == zbx_vc_get_values(item->itemid, item->value_type, &values, period, 1, &ts) &&
 			1 == values.values_num))
 	{
-		*value = zbx_strdup(*value, "0");
+		zbx_variant_set_ui64(value, 0);
 	}
 	else
 	{
@@ -1707,7 +1576,7 @@ static int	evaluate_NODATA(char **value, DC_ITEM *item, const char *parameters,
 			goto out;
 		}
 
-		*value = zbx_strdup(*value, "1");
+		zbx_variant_set_ui64(value, 1);
 
 		if (0 != item->host.proxy_hostid && 0 != lazy)
 		{
@@ -1739,10 +1608,9 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_ABSCHANGE(char **value, DC_ITEM *item, const zbx_timespec_t *ts, char **error)
+static int	evaluate_ABSCHANGE(zbx_variant_t *value, DC_ITEM *item, const zbx_timespec_t *ts, char **error)
 {
 	int				ret = FAIL;
-	size_t				value_alloc = 0, value_offset = 0;
 	zbx_vector_history_record_t	values;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -1759,35 +1627,28 @@ static int	evaluate_ABSCHANGE(char **value, DC_ITEM *item, const zbx_timespec_t
 	switch (item->value_type)
 	{
 		case ITEM_VALUE_TYPE_FLOAT:
-			zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64,
-					fabs(values.values[0].value.dbl - values.values[1].value.dbl));
+			zbx_variant_set_dbl(value, fabs(values.values[0].value.dbl - values.values[1].value.dbl));
 			break;
 		case ITEM_VALUE_TYPE_UINT64:
 			/* to avoid overflow */
 			if (values.values[0].value.ui64 >= values.values[1].value.ui64)
-			{
-				zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_UI64,
-						values.values[0].value.ui64 - values.values[1].value.ui64);
-			}
+				zbx_variant_set_ui64(value, values.values[0].value.ui64 - values.values[1].value.ui64);
 			else
-			{
-				zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_UI64,
-						values.values[1].value.ui64 - values.values[0].value.ui64);
-			}
+				zbx_variant_set_ui64(value, values.values[1].value.ui64 - values.values[0].value.ui64);
 			break;
 		case ITEM_VALUE_TYPE_LOG:
 			if (0 == strcmp(values.values[0].value.log->value, values.values[1].value.log->value))
-				*value = zbx_strdup(*value, "0");
+				zbx_variant_set_ui64(value, 0);
 			else
-				*value = zbx_strdup(*value, "1");
+				zbx_variant_set_ui64(value, 1);
 			break;
 
 		case ITEM_VALUE_TYPE_STR:
 		case ITEM_VALUE_TYPE_TEXT:
 			if (0 == strcmp(values.values[0].value.str, values.values[1].value.str))
-				*value = zbx_strdup(*value, "0");
+				zbx_variant_set_ui64(value, 0);
 			else
-				*value = zbx_strdup(*value, "1");
+				zbx_variant_set_ui64(value, 1);
 			break;
 		default:
 			*error = zbx_strdup(*error, "invalid value type");
@@ -1815,10 +1676,9 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_CHANGE(char **value, DC_ITEM *item, const zbx_timespec_t *ts, char **error)
+static int	evaluate_CHANGE(zbx_variant_t *value, DC_ITEM *item, const zbx_timespec_t *ts, char **error)
 {
 	int				ret = FAIL;
-	size_t				value_alloc = 0, value_offset = 0;
 	zbx_vector_history_record_t	values;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -1835,31 +1695,28 @@ static int	evaluate_CHANGE(char **value, DC_ITEM *item, const zbx_timespec_t *ts
 	switch (item->value_type)
 	{
 		case ITEM_VALUE_TYPE_FLOAT:
-			zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64,
-					values.values[0].value.dbl - values.values[1].value.dbl);
+			zbx_variant_set_dbl(value, values.values[0].value.dbl - values.values[1].value.dbl);
 			break;
 		case ITEM_VALUE_TYPE_UINT64:
-			/* to avoid overflow */
+			/* change can be negative, calculate it without overflow */
 			if (values.values[0].value.ui64 >= values.values[1].value.ui64)
-				zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_UI64,
-						values.values[0].value.ui64 - values.values[1].value.ui64);
+				zbx_variant_set_dbl(value, (double)(values.values[0].value.ui64 - values.values[1].value.ui64));
 			else
-				zbx_snprintf_alloc(value, &value_alloc, &value_offset, "-" ZBX_FS_UI64,
-						values.values[1].value.ui64 - values.values[0].value.ui64);
+				zbx_variant_set_dbl(value, -(double)(values.values[1].value.ui64 - values.values[0].value.ui64));
 			break;
 		case ITEM_VALUE_TYPE_LOG:
 			if (0 == strcmp(values.values[0].value.log->value, values.values[1].value.log->value))
-				*value = zbx_strdup(*value, "0");
+				zbx_variant_set_ui64(value, 0);
 			else
-				*value = zbx_strdup(*value, "1");
+				zbx_variant_set_ui64(value, 1);
 			break;
 
 		case ITEM_VALUE_TYPE_STR:
 		case ITEM_VALUE_TYPE_TEXT:
 			if (0 == strcmp(values.values[0].value.str, values.values[1].value.str))
-				*value = zbx_strdup(*value, "0");
+				zbx_variant_set_ui64(value, 0);
 			else
-				*value = zbx_strdup(*value, "1");
+				zbx_variant_set_ui64(value, 1);
 			break;
 		default:
 			*error = zbx_strdup(*error, "invalid value type");
@@ -1888,7 +1745,7 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_DIFF(char **value, DC_ITEM *item, const zbx_timespec_t *ts, char **error)
+static int	evaluate_DIFF(zbx_variant_t *value, DC_ITEM *item, const zbx_timespec_t *ts, char **error)
 {
 	int				ret = FAIL;
 	zbx_vector_history_record_t	values;
@@ -1907,28 +1764,28 @@ static int	evaluate_DIFF(char **value, DC_ITEM *item, const zbx_timespec_t *ts,
 	{
 		case ITEM_VALUE_TYPE_FLOAT:
 			if (SUCCEED == zbx_double_compare(values.values[0].value.dbl, values.values[1].value.dbl))
-				*value = zbx_strdup(*value, "0");
+				zbx_variant_set_ui64(value, 0);
 			else
-				*value = zbx_strdup(*value, "1");
+				zbx_variant_set_ui64(value, 1);
 			break;
 		case ITEM_VALUE_TYPE_UINT64:
 			if (values.values[0].value.ui64 == values.values[1].value.ui64)
-				*value = zbx_strdup(*value, "0");
+				zbx_variant_set_ui64(value, 0);
 			else
-				*value = zbx_strdup(*value, "1");
+				zbx_variant_set_ui64(value, 1);
 			break;
 		case ITEM_VALUE_TYPE_LOG:
 			if (0 == strcmp(values.values[0].value.log->value, values.values[1].value.log->value))
-				*value = zbx_strdup(*value, "0");
+				zbx_variant_set_ui64(value, 0);
 			else
-				*value = zbx_strdup(*value, "1");
+				zbx_variant_set_ui64(value, 1);
 			break;
 		case ITEM_VALUE_TYPE_STR:
 		case ITEM_VALUE_TYPE_TEXT:
 			if (0 == strcmp(values.values[0].value.str, values.values[1].value.str))
-				*value = zbx_strdup(*value, "0");
+				zbx_variant_set_ui64(value, 0);
 			else
-				*value = zbx_strdup(*value, "1");
+				zbx_variant_set_ui64(value, 1);
 			break;
 		default:
 			*error = zbx_strdup(*error, "invalid value type");
@@ -1994,7 +1851,7 @@ static int	evaluate_STR_one(int func, zbx_vector_ptr_t *regexps, const char *val
 	return FAIL;
 }
 
-static int	evaluate_STR(char **value, DC_ITEM *item, const char *function, const char *parameters,
+static int	evaluate_STR(zbx_variant_t *value, DC_ITEM *item, const char *function, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
 	char				*arg1 = NULL;
@@ -2003,7 +1860,6 @@ static int	evaluate_STR(char **value, DC_ITEM *item, const char *function, const
 	zbx_value_type_t		arg2_type = ZBX_VALUE_NVALUES;
 	zbx_vector_ptr_t		regexps;
 	zbx_vector_history_record_t	values;
-	size_t				value_alloc = 0, value_offset = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -2118,7 +1974,7 @@ static int	evaluate_STR(char **value, DC_ITEM *item, const char *function, const
 		}
 	}
 
-	zbx_snprintf_alloc(value, &value_alloc, &value_offset, "%d", found);
+	zbx_variant_set_ui64(value, (zbx_uint64_t)found);
 	ret = SUCCEED;
 out:
 	zbx_regexp_clean_expressions(&regexps);
@@ -2143,7 +1999,7 @@ out:
  *                                                                            *
  * Purpose: evaluate function 'strlen' for the item                           *
  *                                                                            *
- * Parameters: value - dynamic buffer                                         *
+ * Parameters: value - [OUT] the function result                              *
  *             item - item (performance metric)                               *
  *             parameters - Nth last value and time shift (optional)          *
  *                                                                            *
@@ -2151,7 +2007,7 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_STRLEN(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
+static int	evaluate_STRLEN(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		char **error)
 {
 	int				arg1 = 1, ret = FAIL;
@@ -2198,14 +2054,14 @@ static int	evaluate_STRLEN(char **value, DC_ITEM *item, const char *parameters,
 	{
 		if (arg1 <= values.values_num)
 		{
-			size_t	sz, value_alloc = 0, value_offset = 0;
+			size_t	sz;
 
 			if (ITEM_VALUE_TYPE_LOG == item->value_type)
 				sz = zbx_strlen_utf8(values.values[0].value.log->value);
 			else
 				sz = zbx_strlen_utf8(values.values[0].value.str);
 
-			zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_SIZE_T, sz);
+			zbx_variant_set_ui64(value, (zbx_uint64_t)sz);
 			ret = SUCCEED;
 		}
 		else
@@ -2239,7 +2095,7 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_FUZZYTIME(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
+static int	evaluate_FUZZYTIME(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		char **error)
 {
 	int			arg1, ret = FAIL;
@@ -2285,16 +2141,16 @@ static int	evaluate_FUZZYTIME(char **value, DC_ITEM *item, const char *parameter
 	if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
 	{
 		if (vc_value.value.ui64 >= fuzlow && vc_value.value.ui64 <= fuzhig)
-			*value = zbx_strdup(*value, "1");
+			zbx_variant_set_ui64(value, 1);
 		else
-			*value = zbx_strdup(*value, "0");
+			zbx_variant_set_ui64(value, 0);
 	}
 	else
 	{
 		if (vc_value.value.dbl >= fuzlow && vc_value.value.dbl <= fuzhig)
-			*value = zbx_strdup(*value, "1");
+			zbx_variant_set_ui64(value, 1);
 		else
-			*value = zbx_strdup(*value, "0");
+			zbx_variant_set_ui64(value, 0);
 	}
 
 	zbx_history_record_clear(&vc_value, item->value_type);
@@ -2312,7 +2168,7 @@ out:
  *                                                                            *
  * Purpose: evaluate logical bitwise function 'and' for the item              *
  *                                                                            *
- * Parameters: value - dynamic buffer                                         *
+ * Parameters: value - [OUT] the function result                              *
  *             item - item (performance metric)                               *
  *             parameters - up to 3 comma-separated fields:                   *
  *                            (1) same as the 1st parameter for function      *
@@ -2327,12 +2183,12 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_BAND(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
+static int	evaluate_BAND(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		char **error)
 {
 	char		*last_parameters = NULL;
 	int		nparams, ret = FAIL;
-	zbx_uint64_t	last_uint64, mask;
+	zbx_uint64_t	mask;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -2360,10 +2216,7 @@ static int	evaluate_BAND(char **value, DC_ITEM *item, const char *parameters, co
 
 	if (SUCCEED == evaluate_LAST(value, item, last_parameters, ts, error))
 	{
-		ZBX_STR2UINT64(last_uint64, *value);
-		/* 'and' bit operation cannot be larger than the source value, */
-		/* so the result can just be copied in value buffer            */
-		zbx_snprintf(*value, strlen(*value) + 1, ZBX_FS_UI64, last_uint64 & (zbx_uint64_t)mask);
+		value->data.ui64 &= mask;
 		ret = SUCCEED;
 	}
 
@@ -2387,7 +2240,7 @@ clean:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_FORECAST(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
+static int	evaluate_FORECAST(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		char **error)
 {
 	char				*fit_str = NULL, *mode_str = NULL;
@@ -2400,7 +2253,6 @@ static int	evaluate_FORECAST(char **value, DC_ITEM *item, const char *parameters
 	zbx_fit_t			fit;
 	zbx_mode_t			mode;
 	zbx_timespec_t			ts_end = *ts;
-	size_t				value_alloc = 0, value_offset = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -2513,14 +2365,13 @@ static int	evaluate_FORECAST(char **value, DC_ITEM *item, const char *parameters
 			}
 		}
 
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64, zbx_forecast(t, x,
-				values.values_num, ts->sec - zero_time.sec - 1.0e-9 * (zero_time.ns + 1), time, fit, k,
-				mode));
+		zbx_variant_set_dbl(value, zbx_forecast(t, x, values.values_num,
+				ts->sec - zero_time.sec - 1.0e-9 * (zero_time.ns + 1), time, fit, k, mode));
 	}
 	else
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "no data available");
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64, ZBX_MATH_ERROR);
+		zbx_variant_set_dbl(value, ZBX_MATH_ERROR);
 	}
 
 	ret = SUCCEED;
@@ -2551,7 +2402,7 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_TIMELEFT(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
+static int	evaluate_TIMELEFT(zbx_variant_t *value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts,
 		char **error)
 {
 	char				*fit_str = NULL;
@@ -2563,7 +2414,6 @@ static int	evaluate_TIMELEFT(char **value, DC_ITEM *item, const char *parameters
 	zbx_timespec_t			zero_time;
 	zbx_fit_t			fit;
 	zbx_timespec_t			ts_end = *ts;
-	size_t				value_alloc = 0, value_offset = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -2667,14 +2517,13 @@ static int	evaluate_TIMELEFT(char **value, DC_ITEM *item, const char *parameters
 			}
 		}
 
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64, zbx_timeleft(t, x,
-				values.values_num, ts->sec - zero_time.sec - 1.0e-9 * (zero_time.ns + 1), threshold,
-				fit, k));
+		zbx_variant_set_dbl(value, zbx_timeleft(t, x, values.values_num,
+				ts->sec - zero_time.sec - 1.0e-9 * (zero_time.ns + 1), threshold, fit, k));
 	}
 	else
 	{
 		zabbix_log(LOG_LEVEL_DEBUG, "no data available");
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64, ZBX_MATH_ERROR);
+		zbx_variant_set_dbl(value, ZBX_MATH_ERROR);
 	}
 
 	ret = SUCCEED;
@@ -2709,7 +2558,7 @@ out:
  *               FAIL - failed to evaluate function                           *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_TREND(char **value, DC_ITEM *item, const char *func, const char *parameters,
+static int	evaluate_TREND(zbx_variant_t *value, DC_ITEM *item, const char *func, const char *parameters,
 		const zbx_timespec_t *ts, char **error)
 {
 	int		ret = FAIL, start, end;
@@ -2778,7 +2627,7 @@ static int	evaluate_TREND(char **value, DC_ITEM *item, const char *func, const c
 	}
 
 	if (SUCCEED == ret)
-		*value = zbx_dsprintf(*value, ZBX_FS_DBL64, value_dbl);
+		zbx_variant_set_dbl(value, value_dbl);
 out:
 	zbx_free(period);
 	zbx_free(period_shift);
@@ -2790,19 +2639,26 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Function: evaluate_function                                                *
+ * Function: evaluate_function_variant                                        *
  *                                                                            *
  * Purpose: evaluate function                                                 *
  *                                                                            *
- * Parameters: item      - item to calculate function for                     *
- *             function  - function (for example, 'max')                      *
- *             parameter - parameter of the function                          *
+ * Parameters: value     - [OUT] the function result: double or unsigned      *
+ *                               integer for numeric results, unquoted string *
+ *                               for string values returned by last()/prev()  *
+ *             item      - [IN] item to calculate function for                *
+ *             function  - [IN] function (for example, 'max')                 *
+ *             parameter - [IN] parameter of the function                     *
+ *             ts        - [IN] the function evaluation time                  *
+ *             error     - [OUT] the error message                            *
  *                                                                            *
  * Return value: SUCCEED - evaluated successfully, value contains its value   *
  *               FAIL - evaluation failed                                     *
  *                                                                            *
+ * Comments: The value must be cleared with zbx_variant_clear() after use.    *
+ *                                                                            *
  ******************************************************************************/
-int	evaluate_function(char **value, DC_ITEM *item, const char *function, const char *parameter,
+int	evaluate_function_variant(zbx_variant_t *value, DC_ITEM *item, const char *function, const char *parameter,
 		const zbx_timespec_t *ts, char **error)
 {
 	int		ret;
@@ -2811,6 +2667,8 @@ int	evaluate_function(char **value, DC_ITEM *item, const char *function, const c
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() function:'%s:%s.%s(%s)' ts:'%s\'", __func__,
 			item->host.host, item->key_orig, function, parameter, zbx_timespec_str(ts));
 
+	zbx_variant_set_none(value);
+
 	if (0 == strcmp(function, "last"))
 	{
 		ret = evaluate_LAST(value, item, parameter, ts, error);
@@ -2853,40 +2711,35 @@ int	evaluate_function(char **value, DC_ITEM *item, const char *function, const c
 	}
 	else if (0 == strcmp(function, "date"))
 	{
-		size_t	value_alloc = 0, value_offset = 0;
 		time_t	now = ts->sec;
 
 		tm = localtime(&now);
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, "%.4d%.2d%.2d",
-				tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday);
+		zbx_variant_set_ui64(value, (zbx_uint64_t)((tm->tm_year + 1900) * 10000 + (tm->tm_mon + 1) * 100 +
+				tm->tm_mday));
 		ret = SUCCEED;
 	}
 	else if (0 == strcmp(function, "dayofweek"))
 	{
-		size_t	value_alloc = 0, value_offset = 0;
 		time_t	now = ts->sec;
 
 		tm = localtime(&now);
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, "%d", 0 == tm->tm_wday ? 7 : tm->tm_wday);
+		zbx_variant_set_ui64(value, (zbx_uint64_t)(0 == tm->tm_wday ? 7 : tm->tm_wday));
 		ret = SUCCEED;
 	}
 	else if (0 == strcmp(function, "dayofmonth"))
 	{
-		size_t	value_alloc = 0, value_offset = 0;
 		time_t	now = ts->sec;
 
 		tm = localtime(&now);
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, "%d", tm->tm_mday);
+		zbx_variant_set_ui64(value, (zbx_uint64_t)tm->tm_mday);
 		ret = SUCCEED;
 	}
 	else if (0 == strcmp(function, "time"))
 	{
-		size_t	value_alloc = 0, value_offset = 0;
 		time_t	now = ts->sec;
 
 		tm = localtime(&now);
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, "%.2d%.2d%.2d", tm->tm_hour, tm->tm_min,
-				tm->tm_sec);
+		zbx_variant_set_ui64(value, (zbx_uint64_t)(tm->tm_hour * 10000 + tm->tm_min * 100 + tm->tm_sec));
 		ret = SUCCEED;
 	}
 	else if (0 == strcmp(function, "abschange"))
@@ -2911,9 +2764,7 @@ int	evaluate_function(char **value, DC_ITEM *item, const char *function, const c
 	}
 	else if (0 == strcmp(function, "now"))
 	{
-		size_t	value_alloc = 0, value_offset = 0;
-
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, "%d", ts->sec);
+		zbx_variant_set_ui64(value, (zbx_uint64_t)ts->sec);
 		ret = SUCCEED;
 	}
 	else if (0 == strcmp(function, "fuzzytime"))
@@ -2950,16 +2801,74 @@ int	evaluate_function(char **value, DC_ITEM *item, const char *function, const c
 	}
 	else
 	{
-		*value = zbx_malloc(*value, 1);
-		(*value)[0] = '\0';
 		*error = zbx_strdup(*error, "function is not supported");
 		ret = FAIL;
 	}
 
-	if (SUCCEED == ret)
-		del_zeros(*value);
+	if (SUCCEED != ret)
+		zbx_variant_clear(value);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s value:'%s'", __func__, zbx_result_string(ret), ZBX_NULL2STR(*value));
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s value:'%s' of type '%s'", __func__, zbx_result_string(ret),
+			zbx_variant_value_desc(value), zbx_variant_type_desc(value));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: evaluate_function                                                *
+ *                                                                            *
+ * Purpose: evaluate function                                                 *
+ *                                                                            *
+ * Parameters: item      - item to calculate function for                     *
+ *             function  - function (for example, 'max')                      *
+ *             parameter - parameter of the function                          *
+ *                                                                            *
+ * Return value: SUCCEED - evaluated successfully, value contains its value   *
+ *               FAIL - evaluation failed                                     *
+ *                                                                            *
+ * Comments: Text representation of the result is kept compatible with       *
+ *           older versions - string values of last() and prev() are quoted   *
+ *           and escaped, values of history based functions are printed with  *
+ *           ZBX_FS_DBL precision.                                            *
+ *                                                                            *
+ ******************************************************************************/
+int	evaluate_function(char **value, DC_ITEM *item, const char *function, const char *parameter,
+		const zbx_timespec_t *ts, char **error)
+{
+	int		ret;
+	char		*tmp;
+	zbx_variant_t	value_var;
+
+	if (SUCCEED != (ret = evaluate_function_variant(&value_var, item, function, parameter, ts, error)))
+		return ret;
+
+	switch (value_var.type)
+	{
+		case ZBX_VARIANT_DBL:
+			if (SUCCEED == str_in_list("last,prev,min,max,sum,percentile,delta", function, ','))
+				*value = zbx_dsprintf(*value, ZBX_FS_DBL, value_var.data.dbl);
+			else
+				*value = zbx_dsprintf(*value, ZBX_FS_DBL64, value_var.data.dbl);
+			break;
+		case ZBX_VARIANT_UI64:
+			if (0 == strcmp(function, "time"))
+				*value = zbx_dsprintf(*value, "%.6d", (int)value_var.data.ui64);
+			else
+				*value = zbx_dsprintf(*value, ZBX_FS_UI64, value_var.data.ui64);
+			break;
+		case ZBX_VARIANT_STR:
+			tmp = zbx_dyn_escape_string(value_var.data.str, "\"\\");
+			*value = zbx_dsprintf(*value, "\"%s\"", tmp);
+			zbx_free(tmp);
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			*value = zbx_strdup(*value, "");
+	}
+
+	zbx_variant_clear(&value_var);
+	del_zeros(*value);
 
 	return ret;
 }
@@ -3502,3 +3411,58 @@ int	evaluatable_for_notsupported(const char *fn)
 
 	return FAIL;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_function_history_range                                       *
+ *                                                                            *
+ * Purpose: get the history period read by time based trigger function        *
+ *                                                                            *
+ * Parameters: function   - [IN] the function name                            *
+ *             parameters - [IN] the function parameters                      *
+ *             seconds    - [OUT] the period length including time shift      *
+ *                                                                            *
+ * Return value: SUCCEED - the function reads item history for the period     *
+ *               FAIL    - the function does not read history by time or the  *
+ *                         parameters are invalid                             *
+ *                                                                            *
+ ******************************************************************************/
+int	get_function_history_range(const char *function, const char *parameters, int *seconds)
+{
+	int			arg1, time_shift = 0, shift_param;
+	zbx_value_type_t	arg1_type, time_shift_type = ZBX_VALUE_SECONDS;
+
+	if (0 == strcmp(function, "count"))
+	{
+		shift_param = 4;
+	}
+	else if (0 == strcmp(function, "avg") || 0 == strcmp(function, "min") || 0 == strcmp(function, "max") ||
+			0 == strcmp(function, "sum") || 0 == strcmp(function, "delta") ||
+			0 == strcmp(function, "percentile") || 0 == strcmp(function, "forecast") ||
+			0 == strcmp(function, "timeleft"))
+	{
+		shift_param = 2;
+	}
+	else
+		return FAIL;
+
+	if (SUCCEED != get_function_parameter_int(parameters, 1, ZBX_PARAM_MANDATORY, &arg1, &arg1_type) ||
+			ZBX_VALUE_SECONDS != arg1_type || 0 >= arg1)
+	{
+		return FAIL;
+	}
+
+	if (shift_param <= num_param(parameters) && (SUCCEED != get_function_parameter_int(parameters, shift_param,
+			ZBX_PARAM_OPTIONAL, &time_shift, &time_shift_type) || ZBX_VALUE_SECONDS != time_shift_type ||
+			0 > time_shift))
+	{
+		return FAIL;
+	}
+
+	if (INT_MAX - arg1 < time_shift)
+		return FAIL;
+
+	*seconds = arg1 + time_shift;
+
+	return SUCCEED;
+}
@@ -30,5 +30,6 @@ zbx_output_format_t;
 int	evaluate_macro_function(char **result, const char *host, const char *key, const char *function,
 		const char *parameter, zbx_output_format_t format);
 int	evaluatable_for_notsupported(const char *fn);
+int	get_function_history_range(const char *function, const char *parameters, int *seconds);
 
 #endif
@@ -4906,6 +4906,16 @@ static void	zbx_extract_functionids(zbx_vector_uint64_t *functionids, zbx_vector
 		if (NULL != tr->new_error)
 			continue;
 
+		if (NULL != tr->expression_bin)
+		{
+			zbx_eval_get_functionids(tr->expression_bin, functionids);
+
+			if (NULL != tr->recovery_expression_bin)
+				zbx_eval_get_functionids(tr->recovery_expression_bin, functionids);
+
+			continue;
+		}
+
 		values_num_save = functionids->values_num;
 
 		if (SUCCEED != extract_expression_functionids(functionids, tr->expression))
@@ -5009,11 +5019,21 @@ static void	zbx_link_triggers_with_functions(zbx_vector_ptr_t *triggers_func_pos
 		if (NULL != tr->new_error)
 			continue;
 
-		ev.value = tr->value;
+		if (NULL != tr->expression_bin)
+		{
+			zbx_eval_get_functionids(tr->expression_bin, &funcids);
+		}
+		else
+		{
+			ev.value = tr->value;
+
+			expand_trigger_macros(&ev, tr, NULL, 0);
 
-		expand_trigger_macros(&ev, tr, NULL, 0);
+			if (SUCCEED != extract_expression_functionids(&funcids, tr->expression))
+				zbx_vector_uint64_clear(&funcids);
+		}
 
-		if (SUCCEED == extract_expression_functionids(&funcids, tr->expression))
+		if (0 != funcids.values_num)
 		{
 			tr_func_pos = (zbx_trigger_func_position_t *)zbx_malloc(NULL, sizeof(zbx_trigger_func_position_t));
 			tr_func_pos->trigger = tr;
@@ -5106,7 +5126,8 @@ typedef struct
 	zbx_timespec_t	timespec;
 
 	/* output data */
-	char		*value;
+	zbx_variant_t	value;
+	int		unknown_idx;	/* index of message in unknown messages vector if the value is Unknown */
 	char		*error;
 }
 zbx_func_t;
@@ -5158,10 +5179,82 @@ static void	func_clean(void *ptr)
 
 	zbx_free(func->function);
 	zbx_free(func->parameter);
-	zbx_free(func->value);
+	zbx_variant_clear(&func->value);
 	zbx_free(func->error);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_prefetch_item_functions                                      *
+ *                                                                            *
+ * Purpose: caches history read by time based functions of items that are    *
+ *          not in value cache yet with batched history requests              *
+ *                                                                            *
+ * Parameters: funcs    - [IN] the functions to evaluate                      *
+ *             items    - [IN] the function items                             *
+ *             errcodes - [IN] the function item error codes                  *
+ *             itemids  - [IN] the function item identifiers, sorted          *
+ *                                                                            *
+ * Comments: Otherwise the history of each item missing in value cache would  *
+ *           be read with a separate request during function evaluation.      *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_prefetch_item_functions(zbx_hashset_t *funcs, const DC_ITEM *items, const int *errcodes,
+		const zbx_vector_uint64_t *itemids)
+{
+	zbx_vector_vc_prefetch_item_t	pitems;
+	zbx_vc_prefetch_item_t		pitem;
+	zbx_func_t			*func;
+	zbx_hashset_iter_t		iter;
+	int				i, seconds, now, *ranges;
+
+	now = (int)time(NULL);
+	ranges = (int *)zbx_calloc(NULL, (size_t)itemids->values_num, sizeof(int));
+
+	zbx_hashset_iter_reset(funcs, &iter);
+	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
+	{
+		i = zbx_vector_uint64_bsearch(itemids, func->itemid, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		if (SUCCEED != errcodes[i] || ITEM_STATUS_ACTIVE != items[i].status ||
+				HOST_STATUS_MONITORED != items[i].host.status || ITEM_STATE_NOTSUPPORTED == items[i].state)
+		{
+			continue;
+		}
+
+		if (SUCCEED != get_function_history_range(func->function, func->parameter, &seconds))
+			continue;
+
+		/* the period is counted back from the function evaluation time */
+		if (func->timespec.sec < now && INT_MAX - seconds > now - func->timespec.sec)
+			seconds += now - func->timespec.sec;
+
+		if (ranges[i] < seconds)
+			ranges[i] = seconds;
+	}
+
+	zbx_vector_vc_prefetch_item_create(&pitems);
+
+	for (i = 0; i < itemids->values_num; i++)
+	{
+		if (0 == ranges[i])
+			continue;
+
+		pitem.itemid = itemids->values[i];
+		pitem.value_type = items[i].value_type;
+		pitem.range = ranges[i];
+		pitem.values_num = 0;
+		zbx_vector_vc_prefetch_item_append_ptr(&pitems, &pitem);
+	}
+
+	/* a single item is read by function evaluation with the same single request */
+	if (1 < pitems.values_num)
+		zbx_vc_prefetch(&pitems, now, NULL);
+
+	zbx_vector_vc_prefetch_item_destroy(&pitems);
+	zbx_free(ranges);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_populate_function_items                                      *
@@ -5187,7 +5280,8 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() functionids_num:%d", __func__, functionids->values_num);
 
-	func_local.value = NULL;
+	zbx_variant_set_none(&func_local.value);
+	func_local.unknown_idx = -1;
 	func_local.error = NULL;
 
 	functions = (DC_FUNCTION *)zbx_malloc(functions, sizeof(DC_FUNCTION) * functionids->values_num);
@@ -5264,6 +5358,8 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *
 
 	DCconfig_get_items_by_itemids(items, itemids.values, errcodes, itemids.values_num);
 
+	zbx_prefetch_item_functions(funcs, items, errcodes, &itemids);
+
 	zbx_hashset_iter_reset(funcs, &iter);
 	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
 	{
@@ -5315,7 +5411,7 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *
 			ret_unknown = 1;
 		}
 
-		if (0 == ret_unknown && SUCCEED != evaluate_function(&func->value, &items[i], func->function,
+		if (0 == ret_unknown && SUCCEED != evaluate_function_variant(&func->value, &items[i], func->function,
 				func->parameter, &func->timespec, &error))
 		{
 			/* compose and store error message for future use */
@@ -5345,11 +5441,10 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *
 
 		if (0 != ret_unknown)
 		{
-			char	buffer[MAX_ID_LEN + 1];
-			/* write a special token of unknown value with 'unknown' message number, like */
-			/* ZBX_UNKNOWN0, ZBX_UNKNOWN1 etc. not wrapped in () */
-			zbx_snprintf(buffer, sizeof(buffer), ZBX_UNKNOWN_STR "%d", unknown_msgs->values_num - 1);
-			func->value = zbx_strdup(func->value, buffer);
+			/* remember 'unknown' message number to write a special token of unknown value */
+			/* like ZBX_UNKNOWN0, ZBX_UNKNOWN1 etc. or to pass it with Unknown value       */
+			zbx_variant_set_dbl(&func->value, ZBX_UNKNOWN);
+			func->unknown_idx = unknown_msgs->values_num - 1;
 		}
 	}
 
@@ -5362,6 +5457,53 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: substitute_function_value                                        *
+ *                                                                            *
+ * Purpose: write function value into expression text                         *
+ *                                                                            *
+ * Comments: Plain numbers are written as is, negative numbers and quoted     *
+ *           strings are wrapped in parentheses, Unknown values are written   *
+ *           as ZBX_UNKNOWN<N> tokens with 'unknown' message number.          *
+ *                                                                            *
+ ******************************************************************************/
+static void	substitute_function_value(const zbx_func_t *func, char **out, size_t *out_alloc, size_t *out_offset)
+{
+	char	buffer[MAX_BUFFER_LEN], *value;
+
+	switch (func->value.type)
+	{
+		case ZBX_VARIANT_STR:
+			value = zbx_dyn_escape_string(func->value.data.str, "\"\\");
+			zbx_snprintf_alloc(out, out_alloc, out_offset, "(\"%s\")", value);
+			zbx_free(value);
+			return;
+		case ZBX_VARIANT_UI64:
+			zbx_snprintf(buffer, sizeof(buffer), ZBX_FS_UI64, func->value.data.ui64);
+			break;
+		case ZBX_VARIANT_DBL:
+			if (ZBX_UNKNOWN == func->value.data.dbl)
+			{
+				zbx_snprintf(buffer, sizeof(buffer), ZBX_UNKNOWN_STR "%d", func->unknown_idx);
+				zbx_strcpy_alloc(out, out_alloc, out_offset, buffer);
+				return;
+			}
+
+			zbx_snprintf(buffer, sizeof(buffer), ZBX_FS_DBL64, func->value.data.dbl);
+			del_zeros(buffer);
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			return;
+	}
+
+	if (SUCCEED != is_double_suffix(buffer, ZBX_FLAG_DOUBLE_SUFFIX) || '-' == *buffer)
+		zbx_snprintf_alloc(out, out_alloc, out_offset, "(%s)", buffer);
+	else
+		zbx_strcpy_alloc(out, out_alloc, out_offset, buffer);
+}
+
 static int	substitute_expression_functions_results(zbx_hashset_t *ifuncs, char *expression, char **out,
 		size_t *out_alloc, char **error)
 {
@@ -5405,20 +5547,13 @@ static int	substitute_expression_functions_results(zbx_hashset_t *ifuncs, char *
 			return FAIL;
 		}
 
-		if (NULL == func->value)
+		if (ZBX_VARIANT_NONE == func->value.type)
 		{
 			*error = zbx_strdup(*error, "Unexpected error while processing a trigger expression");
 			return FAIL;
 		}
 
-		if (SUCCEED != is_double_suffix(func->value, ZBX_FLAG_DOUBLE_SUFFIX) || '-' == *func->value)
-		{
-			zbx_chrcpy_alloc(out, out_alloc, &out_offset, '(');
-			zbx_strcpy_alloc(out, out_alloc, &out_offset, func->value);
-			zbx_chrcpy_alloc(out, out_alloc, &out_offset, ')');
-		}
-		else
-			zbx_strcpy_alloc(out, out_alloc, &out_offset, func->value);
+		substitute_function_value(func, out, out_alloc, &out_offset);
 	}
 
 	zbx_strcpy_alloc(out, out_alloc, &out_offset, br);
@@ -5426,17 +5561,73 @@ static int	substitute_expression_functions_results(zbx_hashset_t *ifuncs, char *
 	return SUCCEED;
 }
 
-static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_ptr_t *triggers)
+/******************************************************************************
+ *                                                                            *
+ * Function: check_expression_functions_results                               *
+ *                                                                            *
+ * Purpose: check that values of all functions used in compiled expression    *
+ *          are available                                                     *
+ *                                                                            *
+ * Parameters: ifuncs      - [IN] function index by functionid                *
+ *             bin         - [IN] the compiled expression                     *
+ *             functionids - [IN] a temporary vector for function ids         *
+ *             error       - [OUT] the error message                          *
+ *                                                                            *
+ * Return value: SUCCEED - the expression can be evaluated                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Reports the same errors in the same order as                     *
+ *           substitute_expression_functions_results() does for expression    *
+ *           text.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	check_expression_functions_results(zbx_hashset_t *ifuncs, const unsigned char *bin,
+		zbx_vector_uint64_t *functionids, char **error)
 {
-	DC_TRIGGER	*tr;
-	char		*out = NULL;
-	size_t		out_alloc = TRIGGER_EXPRESSION_LEN_MAX;
 	int		i;
+	zbx_ifunc_t	*ifunc;
+
+	zbx_vector_uint64_clear(functionids);
+	zbx_eval_get_functionids(bin, functionids);
+
+	for (i = 0; i < functionids->values_num; i++)
+	{
+		if (NULL == (ifunc = (zbx_ifunc_t *)zbx_hashset_search(ifuncs, &functionids->values[i])))
+		{
+			*error = zbx_dsprintf(*error, "Cannot obtain function"
+					" and item for functionid: " ZBX_FS_UI64, functionids->values[i]);
+			return FAIL;
+		}
+
+		if (NULL != ifunc->func->error)
+		{
+			*error = zbx_strdup(*error, ifunc->func->error);
+			return FAIL;
+		}
+
+		if (ZBX_VARIANT_NONE == ifunc->func->value.type)
+		{
+			*error = zbx_strdup(*error, "Unexpected error while processing a trigger expression");
+			return FAIL;
+		}
+	}
+
+	return SUCCEED;
+}
+
+static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_ptr_t *triggers)
+{
+	DC_TRIGGER		*tr;
+	char			*out = NULL;
+	size_t			out_alloc = TRIGGER_EXPRESSION_LEN_MAX;
+	int			i;
+	zbx_vector_uint64_t	functionids;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() ifuncs_num:%d tr_num:%d",
 			__func__, ifuncs->num_data, triggers->values_num);
 
 	out = (char *)zbx_malloc(out, out_alloc);
+	zbx_vector_uint64_create(&functionids);
 
 	for (i = 0; i < triggers->values_num; i++)
 	{
@@ -5445,6 +5636,20 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
 		if (NULL != tr->new_error)
 			continue;
 
+		/* compiled expressions are evaluated directly on function values */
+		if (NULL != tr->expression_bin)
+		{
+			if (SUCCEED != check_expression_functions_results(ifuncs, tr->expression_bin, &functionids,
+					&tr->new_error) || (NULL != tr->recovery_expression_bin &&
+					SUCCEED != check_expression_functions_results(ifuncs,
+					tr->recovery_expression_bin, &functionids, &tr->new_error)))
+			{
+				tr->new_value = TRIGGER_VALUE_UNKNOWN;
+			}
+
+			continue;
+		}
+
 		if( SUCCEED != substitute_expression_functions_results(ifuncs, tr->expression, &out, &out_alloc,
 				&tr->new_error))
 		{
@@ -5472,6 +5677,7 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
 		}
 	}
 
+	zbx_vector_uint64_destroy(&functionids);
 	zbx_free(out);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -5485,6 +5691,10 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
  *                                                                            *
  * Parameters: triggers - [IN] vector of DC_TRIGGER pointers, sorted by      *
  *                             triggerids                                     *
+ *             funcs    - [OUT] functions indexed by itemid, name,            *
+ *                              parameter, timestamp                          *
+ *             ifuncs   - [OUT] function index by functionid, used to         *
+ *                              evaluate compiled expressions                 *
  *             unknown_msgs - vector for storing messages for NOTSUPPORTED    *
  *                            items and failed functions                      *
  *                                                                            *
@@ -5493,10 +5703,10 @@ static void	zbx_substitute_functions_results(zbx_hashset_t *ifuncs, zbx_vector_p
  * Comments: example: "({15}>10) or ({123}=1)" => "(26.416>10) or (0=1)"      *
  *                                                                            *
  ******************************************************************************/
-static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_vector_ptr_t *unknown_msgs)
+static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_hashset_t *funcs, zbx_hashset_t *ifuncs,
+		zbx_vector_ptr_t *unknown_msgs)
 {
 	zbx_vector_uint64_t	functionids;
-	zbx_hashset_t		ifuncs, funcs;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -5506,28 +5716,56 @@ static void	substitute_functions(zbx_vector_ptr_t *triggers, zbx_vector_ptr_t *u
 	if (0 == functionids.values_num)
 		goto empty;
 
-	zbx_hashset_create(&ifuncs, triggers->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_populate_function_items(&functionids, funcs, ifuncs, triggers);
 
-	zbx_hashset_create_ext(&funcs, triggers->values_num, func_hash_func, func_compare_func, func_clean,
-				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
-
-	zbx_populate_function_items(&functionids, &funcs, &ifuncs, triggers);
-
-	if (0 != ifuncs.num_data)
+	if (0 != ifuncs->num_data)
 	{
-		zbx_evaluate_item_functions(&funcs, unknown_msgs);
-		zbx_substitute_functions_results(&ifuncs, triggers);
+		zbx_evaluate_item_functions(funcs, unknown_msgs);
+		zbx_substitute_functions_results(ifuncs, triggers);
 	}
-
-	zbx_hashset_destroy(&ifuncs);
-	zbx_hashset_destroy(&funcs);
 empty:
 	zbx_vector_uint64_destroy(&functionids);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: expression_function_value                                        *
+ *                                                                            *
+ * Purpose: get function value for compiled expression evaluation             *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_variant_t	*expression_function_value(zbx_uint64_t functionid, void *data, int *unknown_idx)
+{
+	zbx_ifunc_t	*ifunc;
+
+	if (NULL == (ifunc = (zbx_ifunc_t *)zbx_hashset_search((zbx_hashset_t *)data, &functionid)))
+		return NULL;
+
+	*unknown_idx = ifunc->func->unknown_idx;
+
+	return &ifunc->func->value;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: evaluate_trigger_expression                                      *
+ *                                                                            *
+ * Purpose: evaluate trigger problem or recovery expression, either compiled  *
+ *          or with substituted function values                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	evaluate_trigger_expression(const DC_TRIGGER *tr, const char *expression, const unsigned char *bin,
+		zbx_hashset_t *ifuncs, double *result, char *error, size_t max_error_len, zbx_vector_ptr_t *unknown_msgs)
+{
+	if (NULL == bin)
+		return evaluate(result, expression, error, max_error_len, unknown_msgs);
+
+	return zbx_eval_execute(bin, tr->value, expression_function_value, ifuncs, result, error, max_error_len,
+			unknown_msgs);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: evaluate_expressions                                             *
@@ -5548,6 +5786,7 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 	double			expr_result;
 	zbx_vector_ptr_t	unknown_msgs;	    /* pointers to messages about origins of 'unknown' values */
 	char			err[MAX_STRING_LEN];
+	zbx_hashset_t		ifuncs, funcs;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() tr_num:%d", __func__, triggers->values_num);
 
@@ -5557,6 +5796,10 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 	{
 		tr = (DC_TRIGGER *)triggers->values[i];
 
+		/* compiled expressions have user macros expanded and resolve {TRIGGER.VALUE} during evaluation */
+		if (NULL != tr->expression_bin)
+			continue;
+
 		event.value = tr->value;
 
 		if (SUCCEED != expand_trigger_macros(&event, tr, err, sizeof(err)))
@@ -5570,7 +5813,13 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 	/* Therefore initialize error messages vector but do not reserve any space. */
 	zbx_vector_ptr_create(&unknown_msgs);
 
-	substitute_functions(triggers, &unknown_msgs);
+	zbx_hashset_create(&ifuncs, triggers->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_hashset_create_ext(&funcs, triggers->values_num, func_hash_func, func_compare_func, func_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	substitute_functions(triggers, &funcs, &ifuncs, &unknown_msgs);
 
 	/* calculate new trigger values based on their recovery modes and expression evaluations */
 	for (i = 0; i < triggers->values_num; i++)
@@ -5580,7 +5829,8 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 		if (NULL != tr->new_error)
 			continue;
 
-		if (SUCCEED != evaluate(&expr_result, tr->expression, err, sizeof(err), &unknown_msgs))
+		if (SUCCEED != evaluate_trigger_expression(tr, tr->expression, tr->expression_bin, &ifuncs,
+				&expr_result, err, sizeof(err), &unknown_msgs))
 		{
 			tr->new_error = zbx_strdup(tr->new_error, err);
 			tr->new_value = TRIGGER_VALUE_UNKNOWN;
@@ -5613,7 +5863,9 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 			}
 
 			/* processing recovery expression mode */
-			if (SUCCEED != evaluate(&expr_result, tr->recovery_expression, err, sizeof(err), &unknown_msgs))
+			if (SUCCEED != evaluate_trigger_expression(tr, tr->recovery_expression,
+					tr->recovery_expression_bin, &ifuncs, &expr_result, err, sizeof(err),
+					&unknown_msgs))
 			{
 				tr->new_error = zbx_strdup(tr->new_error, err);
 				tr->new_value = TRIGGER_VALUE_UNKNOWN;
@@ -5631,6 +5883,9 @@ void	evaluate_expressions(zbx_vector_ptr_t *triggers)
 		tr->new_value = TRIGGER_VALUE_NONE;
 	}
 
+	zbx_hashset_destroy(&ifuncs);
+	zbx_hashset_destroy(&funcs);
+
 	zbx_vector_ptr_clear_ext(&unknown_msgs, zbx_ptr_free);
 	zbx_vector_ptr_destroy(&unknown_msgs);
 
@@ -26,6 +26,7 @@
 #include "stats.h"
 #include "sysinfo.h"
 #include "log.h"
+#include "zbxjson.h"
 
 extern unsigned char			program_type;
 extern ZBX_THREAD_LOCAL unsigned char	process_type;
@@ -40,11 +41,97 @@ extern ZBX_THREAD_LOCAL int		server_num, process_num;
 #include "zbxcrypto.h"
 #include "../libs/zbxcrypto/tls_tcp_active.h"
 
+/******************************************************************************
+ *                                                                            *
+ * Function: process_passive_checks                                           *
+ *                                                                            *
+ * Purpose: process multiple passive checks requested over one connection     *
+ *                                                                            *
+ * Parameters: s  - [IN] the connection socket                                *
+ *             jp - [IN] the request                                          *
+ *                                                                            *
+ * Return value: SUCCEED - the response was sent                              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Request:                                                         *
+ *             {"request":"passive checks","data":[{"key":"agent.ping"},...]} *
+ *           Response has one entry for every requested key, in order:        *
+ *             {"version":"5.4.0","data":[{"value":"1"},{"error":"..."},...]} *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_passive_checks(zbx_socket_t *s, const struct zbx_json_parse *jp)
+{
+	struct zbx_json_parse	jp_data, jp_row;
+	struct zbx_json		j;
+	const char		*p = NULL;
+	char			*key = NULL, **value;
+	size_t			key_alloc = 0;
+	int			ret;
+	AGENT_RESULT		result;
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&j, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
+
+	if (SUCCEED != zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, zbx_json_strerror(), ZBX_JSON_TYPE_STRING);
+		goto out;
+	}
+
+	zbx_json_addarray(&j, ZBX_PROTO_TAG_DATA);
+
+	while (NULL != (p = zbx_json_next(&jp_data, p)))
+	{
+		zbx_json_addobject(&j, NULL);
+
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row) ||
+				SUCCEED != zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_KEY, &key, &key_alloc,
+				NULL))
+		{
+			zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, "Invalid passive check request.",
+					ZBX_JSON_TYPE_STRING);
+			zbx_json_close(&j);
+			continue;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", key);
+
+		init_result(&result);
+
+		if (SUCCEED == process(key, PROCESS_WITH_ALIAS, &result) && NULL != (value = GET_TEXT_RESULT(&result)))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending back [%s]", *value);
+			zbx_json_addstring(&j, ZBX_PROTO_TAG_VALUE, *value, ZBX_JSON_TYPE_STRING);
+		}
+		else
+		{
+			value = GET_MSG_RESULT(&result);
+
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending back [" ZBX_NOTSUPPORTED ": %s]",
+					NULL != value ? *value : ZBX_NOTSUPPORTED_MSG);
+			zbx_json_addstring(&j, ZBX_PROTO_TAG_ERROR, NULL != value ? *value : ZBX_NOTSUPPORTED_MSG,
+					ZBX_JSON_TYPE_STRING);
+		}
+
+		free_result(&result);
+		zbx_json_close(&j);
+	}
+out:
+	ret = zbx_tcp_send_to(s, j.buffer, CONFIG_TIMEOUT);
+
+	zbx_free(key);
+	zbx_json_free(&j);
+
+	return ret;
+}
+
 static void	process_listener(zbx_socket_t *s)
 {
-	AGENT_RESULT	result;
-	char		**value = NULL;
-	int		ret;
+	AGENT_RESULT		result;
+	char			**value = NULL;
+	int			ret;
+	struct zbx_json_parse	jp;
+	char			value_request[MAX_STRING_LEN];
 
 	if (SUCCEED == (ret = zbx_tcp_recv_to(s, CONFIG_TIMEOUT)))
 	{
@@ -52,6 +139,16 @@ static void	process_listener(zbx_socket_t *s)
 
 		zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", s->buffer);
 
+		/* item keys cannot start with '{', so JSON requests do not clash with single key requests */
+		if ('{' == *s->buffer && SUCCEED == zbx_json_open(s->buffer, &jp) &&
+				SUCCEED == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_REQUEST, value_request,
+				sizeof(value_request), NULL) &&
+				0 == strcmp(value_request, ZBX_PROTO_VALUE_PASSIVE_CHECKS))
+		{
+			ret = process_passive_checks(s, &jp);
+			goto out;
+		}
+
 		init_result(&result);
 
 		if (SUCCEED == process(s->buffer, PROCESS_WITH_ALIAS, &result))
@@ -94,7 +191,7 @@ static void	process_listener(zbx_socket_t *s)
 
 		free_result(&result);
 	}
-
+out:
 	if (FAIL == ret)
 		zabbix_log(LOG_LEVEL_DEBUG, "Process listener error: %s", zbx_socket_strerror());
 }
@@ -273,6 +273,8 @@ int	CONFIG_TIMER_FORKS		= 0;
 int	CONFIG_TRAPPER_FORKS		= 0;
 int	CONFIG_SNMPTRAPPER_FORKS	= 0;
 int	CONFIG_JAVAPOLLER_FORKS		= 0;
+int	CONFIG_AGENTPOLLER_FORKS	= 0;
+int	CONFIG_SNMPPOLLER_FORKS		= 0;
 int	CONFIG_ESCALATOR_FORKS		= 0;
 int	CONFIG_SELFMON_FORKS		= 0;
 int	CONFIG_DATASENDER_FORKS		= 0;
@@ -165,6 +165,8 @@ int	CONFIG_IPMIPOLLER_FORKS		= 0;
 int	CONFIG_TRAPPER_FORKS		= 5;
 int	CONFIG_SNMPTRAPPER_FORKS	= 0;
 int	CONFIG_JAVAPOLLER_FORKS		= 0;
+int	CONFIG_AGENTPOLLER_FORKS	= 0;
+int	CONFIG_SNMPPOLLER_FORKS		= 0;
 int	CONFIG_SELFMON_FORKS		= 1;
 int	CONFIG_PROXYPOLLER_FORKS	= 0;
 int	CONFIG_ESCALATOR_FORKS		= 0;
@@ -192,6 +194,9 @@ int	CONFIG_HOUSEKEEPING_FREQUENCY	= 1;
 int	CONFIG_PROXY_LOCAL_BUFFER	= 0;
 int	CONFIG_PROXY_OFFLINE_BUFFER	= 1;
 
+zbx_uint64_t	CONFIG_PROXY_HISTORY_BUFFER_SIZE	= 0;
+char		*CONFIG_PROXY_HISTORY_BUFFER_FILE	= NULL;
+
 int	CONFIG_HEARTBEAT_FREQUENCY	= 60;
 
 int	CONFIG_PROXYCONFIG_FREQUENCY	= SEC_PER_HOUR;
@@ -209,12 +214,17 @@ int	CONFIG_VMWARE_TIMEOUT		= 10;
 zbx_uint64_t	CONFIG_CONF_CACHE_SIZE		= 8 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE	= 16 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
+int		CONFIG_HISTORY_CACHE_STRIPES	= 1;
 zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 0;
 zbx_uint64_t	CONFIG_TREND_FUNC_CACHE_SIZE	= 0;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 0;
+char		*CONFIG_VALUE_CACHE_WORKING_SET_FILE	= NULL;
+int		CONFIG_VALUE_CACHE_WINDOWS	= 0;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE;
 
+int	CONFIG_SNMPPOLLER_HOST_REQUESTS	= 1;	/* requests in flight per SNMP interface */
+
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
 int	CONFIG_UNAVAILABLE_DELAY	= 60;
@@ -300,6 +310,9 @@ static char	*CONFIG_SOCKET_PATH	= NULL;
 char	*CONFIG_HISTORY_STORAGE_URL		= NULL;
 char	*CONFIG_HISTORY_STORAGE_OPTS		= NULL;
 int	CONFIG_HISTORY_STORAGE_PIPELINES	= 0;
+int	CONFIG_HISTORY_STORAGE_CONCURRENCY	= 1;
+char	*CONFIG_HISTORY_STORAGE_LOCAL_PATH	= NULL;
+int	CONFIG_HISTORY_STORAGE_LOCAL_RETENTION	= 90;
 
 char	*CONFIG_STATS_ALLOWED_IP	= NULL;
 
@@ -375,6 +388,16 @@ int	get_process_info_by_thread(int local_server_num, unsigned char *local_proces
 		*local_process_type = ZBX_PROCESS_TYPE_JAVAPOLLER;
 		*local_process_num = local_server_num - server_count + CONFIG_JAVAPOLLER_FORKS;
 	}
+	else if (local_server_num <= (server_count += CONFIG_AGENTPOLLER_FORKS))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_AGENTPOLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_AGENTPOLLER_FORKS;
+	}
+	else if (local_server_num <= (server_count += CONFIG_SNMPPOLLER_FORKS))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_SNMPPOLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_SNMPPOLLER_FORKS;
+	}
 	else if (local_server_num <= (server_count += CONFIG_SNMPTRAPPER_FORKS))
 	{
 		*local_process_type = ZBX_PROCESS_TYPE_SNMPTRAPPER;
@@ -551,10 +574,11 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
-	if (0 == CONFIG_UNREACHABLE_POLLER_FORKS && 0 != CONFIG_POLLER_FORKS + CONFIG_JAVAPOLLER_FORKS)
+	if (0 == CONFIG_UNREACHABLE_POLLER_FORKS && 0 != CONFIG_POLLER_FORKS + CONFIG_JAVAPOLLER_FORKS +
+			CONFIG_AGENTPOLLER_FORKS + CONFIG_SNMPPOLLER_FORKS)
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "\"StartPollersUnreachable\" configuration parameter must not be 0"
-				" if regular or Java pollers are started");
+				" if regular, agent, SNMP or Java pollers are started");
 		err = 1;
 	}
 
@@ -564,6 +588,14 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (128 * ZBX_KIBIBYTE > CONFIG_HISTORY_CACHE_SIZE / CONFIG_HISTORY_CACHE_STRIPES ||
+			128 * ZBX_KIBIBYTE > CONFIG_HISTORY_INDEX_CACHE_SIZE / CONFIG_HISTORY_CACHE_STRIPES)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"HistoryCacheSize\" and \"HistoryIndexCacheSize\" configuration parameters"
+				" must be at least 128KB per \"HistoryCacheStripes\" stripe");
+		err = 1;
+	}
+
 	if (ZBX_PROXYMODE_ACTIVE == CONFIG_PROXYMODE && FAIL == is_supported_ip(CONFIG_SERVER) &&
 			FAIL == zbx_validate_hostname(CONFIG_SERVER))
 	{
@@ -577,6 +609,34 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (CONFIG_PREPROCMAN_FORKS > CONFIG_PREPROCESSOR_FORKS)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"StartPreprocessingManagers\" configuration parameter must not be greater"
+				" than \"StartPreprocessors\"");
+		err = 1;
+	}
+
+	if (NULL != CONFIG_PROXY_HISTORY_BUFFER_FILE && 0 == CONFIG_PROXY_HISTORY_BUFFER_SIZE)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"ProxyHistoryBufferFile\" configuration parameter requires"
+				" \"ProxyHistoryBufferSize\" to be set");
+		err = 1;
+	}
+
+	if (0 != CONFIG_PROXY_HISTORY_BUFFER_SIZE && 128 * ZBX_KIBIBYTE > CONFIG_PROXY_HISTORY_BUFFER_SIZE)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"ProxyHistoryBufferSize\" configuration parameter must be either 0"
+				" or greater than 128KB");
+		err = 1;
+	}
+
+	if (0 != CONFIG_PROXY_HISTORY_BUFFER_SIZE && 0 != CONFIG_PROXY_LOCAL_BUFFER)
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "\"ProxyLocalBuffer\" configuration parameter cannot be used together"
+				" with \"ProxyHistoryBufferSize\"");
+		err = 1;
+	}
+
 	if (NULL != CONFIG_SOURCE_IP && SUCCEED != is_supported_ip(CONFIG_SOURCE_IP))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "invalid \"SourceIP\" configuration parameter: '%s'", CONFIG_SOURCE_IP);
@@ -687,6 +747,12 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			1000},
 		{"StartJavaPollers",		&CONFIG_JAVAPOLLER_FORKS,		TYPE_INT,
 			PARM_OPT,	0,			1000},
+		{"StartAgentPollers",		&CONFIG_AGENTPOLLER_FORKS,		TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"StartSNMPPollers",		&CONFIG_SNMPPOLLER_FORKS,		TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"SNMPPollerHostRequests",	&CONFIG_SNMPPOLLER_HOST_REQUESTS,	TYPE_INT,
+			PARM_OPT,	1,			64},
 		{"JavaGateway",			&CONFIG_JAVA_GATEWAY,			TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"JavaGatewayPort",		&CONFIG_JAVA_GATEWAY_PORT,		TYPE_INT,
@@ -701,12 +767,18 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&CONFIG_HISTORY_INDEX_CACHE_SIZE,	TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"HistoryCacheStripes",		&CONFIG_HISTORY_CACHE_STRIPES,		TYPE_INT,
+			PARM_OPT,	1,			ZBX_HC_STRIPES_MAX},
 		{"HousekeepingFrequency",	&CONFIG_HOUSEKEEPING_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	0,			24},
 		{"ProxyLocalBuffer",		&CONFIG_PROXY_LOCAL_BUFFER,		TYPE_INT,
 			PARM_OPT,	0,			720},
 		{"ProxyOfflineBuffer",		&CONFIG_PROXY_OFFLINE_BUFFER,		TYPE_INT,
 			PARM_OPT,	1,			720},
+		{"ProxyHistoryBufferSize",	&CONFIG_PROXY_HISTORY_BUFFER_SIZE,	TYPE_UINT64,
+			PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"ProxyHistoryBufferFile",	&CONFIG_PROXY_HISTORY_BUFFER_FILE,	TYPE_STRING,
+			PARM_OPT,	0,			0},
 		{"HeartbeatFrequency",		&CONFIG_HEARTBEAT_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	0,			ZBX_PROXY_HEARTBEAT_FREQUENCY_MAX},
 		{"ConfigFrequency",		&CONFIG_PROXYCONFIG_FREQUENCY,		TYPE_INT,
@@ -849,6 +921,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"StartPreprocessors",		&CONFIG_PREPROCESSOR_FORKS,		TYPE_INT,
 			PARM_OPT,	1,			1000},
+		{"StartPreprocessingManagers",	&CONFIG_PREPROCMAN_FORKS,		TYPE_INT,
+			PARM_OPT,	1,			100},
 		{NULL}
 	};
 
@@ -1103,6 +1177,14 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		exit(EXIT_FAILURE);
 	}
 
+	if (SUCCEED != zbx_pb_init(CONFIG_PROXY_HISTORY_BUFFER_FILE, CONFIG_PROXY_HISTORY_BUFFER_SIZE,
+			CONFIG_PROXY_OFFLINE_BUFFER * SEC_PER_HOUR, &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize proxy history buffer: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
 	if (SUCCEED != init_proxy_history_lock(&error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize lock for passive proxy history: %s", error);
@@ -1177,7 +1259,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 			+ CONFIG_DISCOVERER_FORKS + CONFIG_HISTSYNCER_FORKS + CONFIG_IPMIPOLLER_FORKS
 			+ CONFIG_JAVAPOLLER_FORKS + CONFIG_SNMPTRAPPER_FORKS + CONFIG_SELFMON_FORKS
 			+ CONFIG_VMWARE_FORKS + CONFIG_IPMIMANAGER_FORKS + CONFIG_TASKMANAGER_FORKS
-			+ CONFIG_PREPROCMAN_FORKS + CONFIG_PREPROCESSOR_FORKS;
+			+ CONFIG_PREPROCMAN_FORKS + CONFIG_PREPROCESSOR_FORKS + CONFIG_AGENTPOLLER_FORKS
+			+ CONFIG_SNMPPOLLER_FORKS;
 
 	threads = (pid_t *)zbx_calloc(threads, threads_num, sizeof(pid_t));
 	threads_flags = (int *)zbx_calloc(threads_flags, threads_num, sizeof(int));
@@ -1259,6 +1342,16 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 				thread_args.args = &poller_type;
 				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
 				break;
+			case ZBX_PROCESS_TYPE_AGENTPOLLER:
+				poller_type = ZBX_POLLER_TYPE_AGENT;
+				thread_args.args = &poller_type;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
+			case ZBX_PROCESS_TYPE_SNMPPOLLER:
+				poller_type = ZBX_POLLER_TYPE_SNMP;
+				thread_args.args = &poller_type;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
 			case ZBX_PROCESS_TYPE_SNMPTRAPPER:
 				zbx_thread_start(snmptrapper_thread, &thread_args, &threads[i]);
 				break;
@@ -1335,6 +1428,8 @@ void	zbx_on_exit(int ret)
 	free_configuration_cache();
 	DBclose();
 
+	zbx_pb_destroy();
+
 	DBdeinit();
 
 	/* free vmware support */
@@ -33,10 +33,15 @@
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
+/* set when configuration cache reload is requested, forcing full configuration sync */
+static volatile sig_atomic_t	full_sync;
+
 static void	zbx_proxyconfig_sigusr_handler(int flags)
 {
 	if (ZBX_RTC_CONFIG_CACHE_RELOAD == ZBX_RTC_GET_MSG(flags))
 	{
+		full_sync = 1;
+
 		if (0 < zbx_sleep_get_remainder())
 		{
 			zabbix_log(LOG_LEVEL_WARNING, "forced reloading of the configuration cache");
@@ -56,6 +61,7 @@ static void	process_configuration_sync(size_t *data_size)
 {
 	zbx_socket_t	sock;
 	struct		zbx_json_parse jp;
+	struct zbx_json	j;
 	char		value[16], *error = NULL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -63,10 +69,18 @@ static void	process_configuration_sync(size_t *data_size)
 	/* reset the performance metric */
 	*data_size = 0;
 
+	init_request_to_server(&j, ZBX_PROTO_VALUE_PROXY_CONFIG);
+
+	/* without configuration revision server sends full configuration */
+	if (0 == full_sync)
+		get_proxyconfig_revision(&j);
+	else
+		full_sync = 0;
+
 	if (FAIL == connect_to_server(&sock, 600, CONFIG_PROXYCONFIG_RETRY))	/* retry till have a connection */
 		goto out;
 
-	if (SUCCEED != get_data_from_server(&sock, ZBX_PROTO_VALUE_PROXY_CONFIG, &error))
+	if (SUCCEED != get_data_from_server(&sock, &j, &error))
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "cannot obtain configuration data from server at \"%s\": %s",
 				sock.peer, error);
@@ -115,6 +129,8 @@ error:
 
 	zbx_free(error);
 out:
+	zbx_json_free(&j);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
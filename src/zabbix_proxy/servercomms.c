@@ -109,29 +109,46 @@ void	disconnect_server(zbx_socket_t *sock)
 	zbx_tcp_close(sock);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: init_request_to_server                                           *
+ *                                                                            *
+ * Purpose: initialize request to server with the common proxy attributes     *
+ *                                                                            *
+ * Parameters: j       - [OUT] the request                                    *
+ *             request - [IN] the request type                                *
+ *                                                                            *
+ ******************************************************************************/
+void	init_request_to_server(struct zbx_json *j, const char *request)
+{
+	zbx_json_init(j, 128);
+	zbx_json_addstring(j, "request", request, ZBX_JSON_TYPE_STRING);
+	zbx_json_addstring(j, "host", CONFIG_HOSTNAME, ZBX_JSON_TYPE_STRING);
+	zbx_json_addstring(j, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_data_from_server                                             *
  *                                                                            *
  * Purpose: get configuration and other data from server                      *
  *                                                                            *
+ * Parameters: sock  - [IN] the connection to server                          *
+ *             j     - [IN] the request, prepared with                        *
+ *                          init_request_to_server() function                 *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
  * Return value: SUCCEED - processed successfully                             *
  *               FAIL - an error occurred                                     *
  *                                                                            *
  ******************************************************************************/
-int	get_data_from_server(zbx_socket_t *sock, const char *request, char **error)
+int	get_data_from_server(zbx_socket_t *sock, struct zbx_json *j, char **error)
 {
-	int		ret = FAIL;
-	struct zbx_json	j;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() request:'%s'", __func__, request);
+	int	ret = FAIL;
 
-	zbx_json_init(&j, 128);
-	zbx_json_addstring(&j, "request", request, ZBX_JSON_TYPE_STRING);
-	zbx_json_addstring(&j, "host", CONFIG_HOSTNAME, ZBX_JSON_TYPE_STRING);
-	zbx_json_addstring(&j, ZBX_PROTO_TAG_VERSION, ZABBIX_VERSION, ZBX_JSON_TYPE_STRING);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() datalen:" ZBX_FS_SIZE_T, __func__, (zbx_fs_size_t)j->buffer_size);
 
-	if (SUCCEED != zbx_tcp_send_ext(sock, j.buffer, strlen(j.buffer), ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS, 0))
+	if (SUCCEED != zbx_tcp_send_ext(sock, j->buffer, strlen(j->buffer), ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS, 0))
 	{
 		*error = zbx_strdup(*error, zbx_socket_strerror());
 		goto exit;
@@ -147,8 +164,6 @@ int	get_data_from_server(zbx_socket_t *sock, const char *request, char **error)
 
 	ret = SUCCEED;
 exit:
-	zbx_json_free(&j);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
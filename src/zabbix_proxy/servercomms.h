@@ -30,7 +30,8 @@ extern char	*CONFIG_HOSTNAME;
 int	connect_to_server(zbx_socket_t *sock, int timeout, int retry_interval);
 void	disconnect_server(zbx_socket_t *sock);
 
-int	get_data_from_server(zbx_socket_t *sock, const char *request, char **error);
+void	init_request_to_server(struct zbx_json *j, const char *request);
+int	get_data_from_server(zbx_socket_t *sock, struct zbx_json *j, char **error);
 int	put_data_to_server(zbx_socket_t *sock, struct zbx_json *j, char **error);
 
 #endif
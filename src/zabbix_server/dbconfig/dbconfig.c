@@ -31,6 +31,7 @@ extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
 static volatile sig_atomic_t	secrets_reload;
+static volatile sig_atomic_t	cache_reload;
 
 static void	zbx_dbconfig_sigusr_handler(int flags)
 {
@@ -41,6 +42,7 @@ static void	zbx_dbconfig_sigusr_handler(int flags)
 	{
 		if (0 < zbx_sleep_get_remainder())
 		{
+			cache_reload = 1;
 			zabbix_log(LOG_LEVEL_WARNING, "forced reloading of the configuration cache");
 			zbx_wakeup();
 		}
@@ -117,7 +119,9 @@ ZBX_THREAD_ENTRY(dbconfig_thread, args)
 		}
 		else
 		{
-			DCsync_configuration(ZBX_DBSYNC_UPDATE, NULL);
+			/* forced reload compares whole configuration, regular sync only the changelog objects */
+			DCsync_configuration(1 == cache_reload ? ZBX_SYNC_FULL : ZBX_DBSYNC_UPDATE, NULL);
+			cache_reload = 0;
 			DCupdate_hosts_availability();
 			nextcheck = time(NULL) + CONFIG_CONFSYNCER_FREQUENCY;
 		}
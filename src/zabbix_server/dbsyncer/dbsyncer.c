@@ -27,8 +27,10 @@
 #include "dbcache.h"
 #include "dbsyncer.h"
 #include "export.h"
+#include "../../libs/zbxdbcache/valuecache.h"
 
 extern int		CONFIG_HISTSYNCER_FREQUENCY;
+extern char		*CONFIG_VALUE_CACHE_WORKING_SET_FILE;
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 static sigset_t		orig_mask;
@@ -163,6 +165,13 @@ ZBX_THREAD_ENTRY(dbsyncer_thread, args)
 		zbx_problems_export_init("history-syncer", process_num);
 	}
 
+	/* other history syncers keep syncing while the first one fills value cache after restart */
+	if (1 == process_num && NULL != CONFIG_VALUE_CACHE_WORKING_SET_FILE)
+	{
+		zbx_setproctitle("%s #%d [prefetching value cache working set]", process_name, process_num);
+		zbx_vc_prefetch_working_set(CONFIG_VALUE_CACHE_WORKING_SET_FILE);
+	}
+
 	for (;;)
 	{
 		sec = zbx_time();
@@ -0,0 +1,598 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "db.h"
+#include "zbxdb.h"
+#include "log.h"
+#include "history_partition.h"
+
+extern int	CONFIG_HOUSEKEEPING_PARTITION_DAYS;
+
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+
+#define ZBX_HK_PARTITION_MINVALUE	0
+#define ZBX_HK_PARTITION_MAXVALUE	INT_MAX
+
+/* <table name>_pYYYYMMDD */
+#define ZBX_HK_PARTITION_NAME_LEN	(ZBX_TABLENAME_LEN + 11)
+
+/* the first PostgreSQL version supporting concurrent partition detaching */
+#define ZBX_HK_DETACH_CONCURRENTLY_VERSION	140000
+
+/* range partition of a table partitioned by clock, holding values in [from, to) range */
+typedef struct
+{
+	char	*name;
+	int	from;
+	int	to;
+
+	/* 1 - concurrent detaching of the partition was interrupted and must be finalized */
+	int	detach_pending;
+}
+zbx_hk_partition_t;
+
+static void	hk_partition_free(zbx_hk_partition_t *partition)
+{
+	zbx_free(partition->name);
+	zbx_free(partition);
+}
+
+static int	hk_partition_compare(const void *d1, const void *d2)
+{
+	const zbx_hk_partition_t	*p1 = *(const zbx_hk_partition_t * const *)d1;
+	const zbx_hk_partition_t	*p2 = *(const zbx_hk_partition_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(p1->to, p2->to);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hk_partition_name                                                *
+ *                                                                            *
+ * Purpose: formats name of the daily partition starting at the specified     *
+ *          timestamp                                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_partition_name(char *name, size_t size, const char *table, int from)
+{
+	time_t		clock = (time_t)from;
+	struct tm	*tm;
+
+	tm = gmtime(&clock);
+
+#if defined(HAVE_POSTGRESQL)
+	/* PostgreSQL partitions are tables, the name must be unique in schema */
+	zbx_snprintf(name, size, "%s_p%04d%02d%02d", table, tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday);
+#else
+	ZBX_UNUSED(table);
+	zbx_snprintf(name, size, "p%04d%02d%02d", tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday);
+#endif
+}
+
+#if defined(HAVE_POSTGRESQL)
+/******************************************************************************
+ *                                                                            *
+ * Function: hk_partition_parse_bound                                         *
+ *                                                                            *
+ * Purpose: parses partition bound value of 'FOR VALUES FROM (x) TO (y)'      *
+ *          partition bound expression                                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partition_parse_bound(const char *expr, const char *prefix, int *value)
+{
+	const char	*ptr;
+
+	if (NULL == (ptr = strstr(expr, prefix)))
+		return FAIL;
+
+	ptr += strlen(prefix);
+
+	if (0 == strncmp(ptr, "MINVALUE", ZBX_CONST_STRLEN("MINVALUE")))
+		*value = ZBX_HK_PARTITION_MINVALUE;
+	else if (0 == strncmp(ptr, "MAXVALUE", ZBX_CONST_STRLEN("MAXVALUE")))
+		*value = ZBX_HK_PARTITION_MAXVALUE;
+	else if (0 != isdigit((unsigned char)*ptr) || '-' == *ptr)
+		*value = atoi(ptr);
+	else
+		return FAIL;
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hk_partitions_get                                                *
+ *                                                                            *
+ * Purpose: reads range partitions of a table                                 *
+ *                                                                            *
+ * Parameters: table      - [IN] the table name                               *
+ *             partitions - [OUT] the partitions, sorted by range             *
+ *             complete   - [OUT] 1 - all table rows are stored in the range  *
+ *                                    partitions, 0 - there is a default      *
+ *                                    partition                               *
+ *                                                                            *
+ * Return value: SUCCEED - the table is range partitioned by clock            *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partitions_get(const char *table, zbx_vector_ptr_t *partitions, int *complete)
+{
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_hk_partition_t	*partition;
+	int			ret = FAIL;
+
+	*complete = 1;
+
+#if defined(HAVE_POSTGRESQL)
+	result = DBselect(
+			"select pg_get_partkeydef(c.oid)"
+			" from pg_class c"
+			" where c.relname='%s'"
+				" and c.relkind='p'"
+				" and pg_table_is_visible(c.oid)",
+			table);
+
+	if (NULL != (row = DBfetch(result)) && 0 == strcmp(row[0], "RANGE (clock)"))
+		ret = SUCCEED;
+
+	DBfree_result(result);
+
+	if (SUCCEED != ret)
+		return FAIL;
+
+	result = DBselect(
+			"select c.relname,pg_get_expr(c.relpartbound,c.oid),%s"
+			" from pg_inherits i,pg_class c,pg_class p"
+			" where i.inhrelid=c.oid"
+				" and i.inhparent=p.oid"
+				" and p.relname='%s'"
+				" and pg_table_is_visible(p.oid)",
+			ZBX_HK_DETACH_CONCURRENTLY_VERSION <= zbx_dbms_get_version() ? "i.inhdetachpending" : "false",
+			table);
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		int	from, to;
+
+		if (0 == strcmp(row[1], "DEFAULT"))
+		{
+			*complete = 0;
+			continue;
+		}
+
+		if (SUCCEED != hk_partition_parse_bound(row[1], "FROM (", &from) ||
+				SUCCEED != hk_partition_parse_bound(row[1], "TO (", &to))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot parse bound of partition \"%s\": %s", row[0], row[1]);
+			*complete = 0;
+			continue;
+		}
+
+		partition = (zbx_hk_partition_t *)zbx_malloc(NULL, sizeof(zbx_hk_partition_t));
+		partition->name = zbx_strdup(NULL, row[0]);
+		partition->from = from;
+		partition->to = to;
+		partition->detach_pending = ('t' == *row[2] ? 1 : 0);
+		zbx_vector_ptr_append(partitions, partition);
+	}
+	DBfree_result(result);
+
+	zbx_vector_ptr_sort(partitions, hk_partition_compare);
+#else
+	result = DBselect(
+			"select partition_name,partition_description"
+			" from information_schema.partitions"
+			" where table_schema=database()"
+				" and table_name='%s'"
+				" and partition_method='RANGE'"
+				" and partition_expression in ('clock','`clock`')"
+			" order by partition_ordinal_position",
+			table);
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		partition = (zbx_hk_partition_t *)zbx_malloc(NULL, sizeof(zbx_hk_partition_t));
+		partition->name = zbx_strdup(NULL, row[0]);
+		partition->detach_pending = 0;
+
+		/* MySQL range partitions start where the previous partition ends */
+		if (0 == partitions->values_num)
+			partition->from = ZBX_HK_PARTITION_MINVALUE;
+		else
+			partition->from = ((zbx_hk_partition_t *)partitions->values[partitions->values_num - 1])->to;
+
+		if (0 == strcmp(row[1], "MAXVALUE"))
+			partition->to = ZBX_HK_PARTITION_MAXVALUE;
+		else
+			partition->to = atoi(row[1]);
+
+		zbx_vector_ptr_append(partitions, partition);
+		ret = SUCCEED;
+	}
+	DBfree_result(result);
+#endif
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hk_partitions_create                                             *
+ *                                                                            *
+ * Purpose: creates daily partitions for the configured number of days ahead  *
+ *                                                                            *
+ * Parameters: table      - [IN] the table name                               *
+ *             partitions - [IN] the existing table partitions                *
+ *             now        - [IN] the current timestamp                        *
+ *                                                                            *
+ * Comments: Days already covered by existing partitions are skipped, so      *
+ *           partitions created by other means are left as they are.          *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_partitions_create(const char *table, const zbx_vector_ptr_t *partitions, int now)
+{
+	char	name[ZBX_HK_PARTITION_NAME_LEN];
+	int	day, from, i, created = 0;
+#if defined(HAVE_POSTGRESQL)
+	zbx_hk_partition_t	*partition;
+#else
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	zbx_hk_partition_t	*last, *maxvalue = NULL;
+	int			upper;
+
+	/* the table partitioned by range always has at least one partition in MySQL */
+	if (0 == partitions->values_num)
+		return;
+
+	/* only partitions above the highest bound can be added, unless the last partition */
+	/* is MAXVALUE partition which then must be split                                 */
+	last = (zbx_hk_partition_t *)partitions->values[partitions->values_num - 1];
+
+	if (ZBX_HK_PARTITION_MAXVALUE == last->to)
+	{
+		maxvalue = last;
+		upper = last->from;
+	}
+	else
+		upper = last->to;
+#endif
+	day = now - now % SEC_PER_DAY;
+
+	for (from = day; from <= day + CONFIG_HOUSEKEEPING_PARTITION_DAYS * SEC_PER_DAY; from += SEC_PER_DAY)
+	{
+#if defined(HAVE_POSTGRESQL)
+		for (i = 0; i < partitions->values_num; i++)
+		{
+			partition = (zbx_hk_partition_t *)partitions->values[i];
+
+			if (from < partition->to && partition->from < from + SEC_PER_DAY)
+				break;
+		}
+
+		if (i != partitions->values_num)
+			continue;
+
+		hk_partition_name(name, sizeof(name), table, from);
+
+		if (ZBX_DB_OK > DBexecute("create table %s partition of %s for values from (%d) to (%d)", name, table,
+				from, from + SEC_PER_DAY))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot create partition \"%s\" of table \"%s\"", name, table);
+			continue;
+		}
+
+		created++;
+#else
+		ZBX_UNUSED(i);
+
+		if (from < upper)
+			continue;
+
+		hk_partition_name(name, sizeof(name), table, from);
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%spartition %s values less than (%d)",
+				0 == sql_offset ? "" : ",", name, from + SEC_PER_DAY);
+		created++;
+#endif
+	}
+
+#if defined(HAVE_MYSQL)
+	if (0 != created)
+	{
+		int	rc;
+
+		if (NULL != maxvalue)
+		{
+			rc = DBexecute("alter table %s reorganize partition %s into (%s,partition %s values less than"
+					" maxvalue)", table, maxvalue->name, sql, maxvalue->name);
+		}
+		else
+			rc = DBexecute("alter table %s add partition (%s)", table, sql);
+
+		if (ZBX_DB_OK > rc)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot create partitions of table \"%s\"", table);
+			created = 0;
+		}
+	}
+
+	zbx_free(sql);
+#endif
+	if (0 != created)
+		zabbix_log(LOG_LEVEL_WARNING, "created %d partitions of table \"%s\"", created, table);
+}
+
+#if defined(HAVE_POSTGRESQL)
+/* concurrently detached partitions which could not be dropped, dropping is retried during the next update */
+static zbx_vector_str_t	hk_detached_partitions;
+static int		hk_detached_partitions_init = 0;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hk_partitions_drop_detached                                      *
+ *                                                                            *
+ * Purpose: retries dropping of detached partitions                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_partitions_drop_detached(void)
+{
+	int	i;
+
+	if (0 == hk_detached_partitions_init)
+		return;
+
+	for (i = 0; i < hk_detached_partitions.values_num;)
+	{
+		if (ZBX_DB_OK > DBexecute("drop table %s", hk_detached_partitions.values[i]))
+		{
+			i++;
+			continue;
+		}
+
+		zabbix_log(LOG_LEVEL_WARNING, "dropped detached partition \"%s\"", hk_detached_partitions.values[i]);
+		zbx_free(hk_detached_partitions.values[i]);
+		zbx_vector_str_remove(&hk_detached_partitions, i);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hk_partition_drop                                                *
+ *                                                                            *
+ * Purpose: detaches partition from the partitioned table and drops it        *
+ *                                                                            *
+ * Parameters: table      - [IN] the partitioned table name                   *
+ *             partition  - [IN] the partition to drop                        *
+ *             concurrent - [IN] 1 - the table has no default partition, so   *
+ *                                   the partition can be detached            *
+ *                                   concurrently                             *
+ *                                                                            *
+ * Return value: SUCCEED - the partition was dropped or detached with         *
+ *                         dropping to be retried later                       *
+ *               FAIL    - otherwise, the partition is still attached         *
+ *                                                                            *
+ * Comments: Dropping an attached partition locks the partitioned table in    *
+ *           access exclusive mode until the partition files are removed,     *
+ *           blocking history syncers. Detaching concurrently takes only      *
+ *           share update exclusive lock on the partitioned table. Concurrent *
+ *           detaching cannot be rolled back, if it is interrupted the next   *
+ *           attempt finalizes it.                                            *
+ *           Concurrent detaching cannot be done in transaction, so if the    *
+ *           detached partition cannot be dropped its name is remembered and  *
+ *           dropping is retried later. Otherwise the partition is detached   *
+ *           and dropped in one transaction.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	hk_partition_drop(const char *table, const zbx_hk_partition_t *partition, int concurrent)
+{
+	const char	*mode;
+
+	if (0 != partition->detach_pending)
+		mode = " finalize";
+	else if (0 != concurrent && ZBX_HK_DETACH_CONCURRENTLY_VERSION <= zbx_dbms_get_version())
+		mode = " concurrently";
+	else
+		mode = NULL;
+
+	if (NULL == mode)
+	{
+		DBbegin();
+
+		if (ZBX_DB_OK > DBexecute("alter table %s detach partition %s", table, partition->name) ||
+				ZBX_DB_OK > DBexecute("drop table %s", partition->name))
+		{
+			DBrollback();
+			return FAIL;
+		}
+
+		return ZBX_DB_OK == DBcommit() ? SUCCEED : FAIL;
+	}
+
+	if (ZBX_DB_OK > DBexecute("alter table %s detach partition %s%s", table, partition->name, mode))
+		return FAIL;
+
+	if (ZBX_DB_OK > DBexecute("drop table %s", partition->name))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot drop detached partition \"%s\" of table \"%s\", dropping will be"
+				" retried", partition->name, table);
+
+		if (0 == hk_detached_partitions_init)
+		{
+			zbx_vector_str_create(&hk_detached_partitions);
+			hk_detached_partitions_init = 1;
+		}
+
+		zbx_vector_str_append(&hk_detached_partitions, zbx_strdup(NULL, partition->name));
+	}
+
+	return SUCCEED;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hk_partitions_drop                                               *
+ *                                                                            *
+ * Purpose: drops partitions holding only values older than the specified     *
+ *          timestamp                                                         *
+ *                                                                            *
+ * Parameters: table      - [IN] the table name                               *
+ *             partitions - [IN/OUT] the table partitions                     *
+ *             keep_from  - [IN] the oldest timestamp to keep                 *
+ *             complete   - [IN] 1 - the table has no default partition       *
+ *                                                                            *
+ * Comments: PostgreSQL partitions are detached before being dropped. MySQL   *
+ *           has no detaching, dropping partition there does not block        *
+ *           access to the other partitions.                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	hk_partitions_drop(const char *table, zbx_vector_ptr_t *partitions, int keep_from, int complete)
+{
+	zbx_hk_partition_t	*partition;
+	int			dropped = 0;
+#if defined(HAVE_MYSQL)
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+
+	ZBX_UNUSED(complete);
+
+	/* MySQL table must keep at least one partition */
+	while (dropped < partitions->values_num - 1)
+	{
+		partition = (zbx_hk_partition_t *)partitions->values[dropped];
+
+		if (partition->to > keep_from)
+			break;
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "%s%s", 0 == dropped ? "" : ",", partition->name);
+		dropped++;
+	}
+
+	if (0 != dropped && ZBX_DB_OK > DBexecute("alter table %s drop partition %s", table, sql))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot drop partitions of table \"%s\"", table);
+		dropped = 0;
+	}
+
+	zbx_free(sql);
+
+	if (0 != dropped)
+	{
+		/* values older than the dropped partitions can get into the first remaining */
+		/* partition only if they are inserted after the drop                         */
+		((zbx_hk_partition_t *)partitions->values[dropped])->from =
+				((zbx_hk_partition_t *)partitions->values[dropped - 1])->to;
+	}
+#else
+	while (dropped < partitions->values_num)
+	{
+		partition = (zbx_hk_partition_t *)partitions->values[dropped];
+
+		if (partition->to > keep_from)
+			break;
+
+		if (SUCCEED != hk_partition_drop(table, partition, complete))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot drop partition \"%s\" of table \"%s\"", partition->name,
+					table);
+			break;
+		}
+
+		dropped++;
+	}
+#endif
+	if (0 == dropped)
+		return;
+
+	zabbix_log(LOG_LEVEL_WARNING, "dropped %d expired partitions of table \"%s\"", dropped, table);
+
+	for (; 0 < dropped; dropped--)
+	{
+		hk_partition_free((zbx_hk_partition_t *)partitions->values[0]);
+		zbx_vector_ptr_remove(partitions, 0);
+	}
+}
+
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hk_history_partitions_update                                     *
+ *                                                                            *
+ * Purpose: manages daily partitions of history or trends table               *
+ *                                                                            *
+ * Parameters: table     - [IN] the table name                                *
+ *             keep_from - [IN] the oldest timestamp to keep, 0 - do not drop *
+ *                              partitions                                    *
+ *             now       - [IN] the current timestamp                         *
+ *                                                                            *
+ * Return value: the timestamp before which the table has no values or 0 if   *
+ *               it cannot be determined                                      *
+ *                                                                            *
+ * Comments: Only tables range partitioned by clock column on PostgreSQL and  *
+ *           MySQL are managed. Future partitions are created for the         *
+ *           configured number of days ahead and partitions holding only      *
+ *           expired values are dropped. Items with shorter history period    *
+ *           still must be housekept by deleting their records.               *
+ *                                                                            *
+ ******************************************************************************/
+int	hk_history_partitions_update(const char *table, int keep_from, int now)
+{
+	int	clock_min = 0;
+#if defined(HAVE_POSTGRESQL) || defined(HAVE_MYSQL)
+	zbx_vector_ptr_t	partitions;
+	int			complete;
+
+	if (0 == CONFIG_HOUSEKEEPING_PARTITION_DAYS)
+		return 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() table:%s keep_from:%d", __func__, table, keep_from);
+
+	zbx_vector_ptr_create(&partitions);
+
+#if defined(HAVE_POSTGRESQL)
+	hk_partitions_drop_detached();
+#endif
+	if (SUCCEED != hk_partitions_get(table, &partitions, &complete))
+		goto out;
+
+	hk_partitions_create(table, &partitions, now);
+
+	if (0 < keep_from)
+		hk_partitions_drop(table, &partitions, keep_from, complete);
+
+	if (0 != complete && 0 != partitions.values_num)
+		clock_min = ((zbx_hk_partition_t *)partitions.values[0])->from;
+out:
+	zbx_vector_ptr_clear_ext(&partitions, (zbx_clean_func_t)hk_partition_free);
+	zbx_vector_ptr_destroy(&partitions);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%d", __func__, clock_min);
+#else
+	ZBX_UNUSED(table);
+	ZBX_UNUSED(keep_from);
+	ZBX_UNUSED(now);
+#endif
+	return clock_min;
+}
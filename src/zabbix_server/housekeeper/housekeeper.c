@@ -28,6 +28,7 @@
 
 #include "zbxhistory.h"
 #include "history_compress.h"
+#include "history_partition.h"
 #include "housekeeper.h"
 #include "../../libs/zbxdbcache/valuecache.h"
 
@@ -155,6 +156,9 @@ typedef struct
 
 	/* the item delete queue */
 	zbx_vector_ptr_t	delete_queue;
+
+	/* the longest history period of items stored in the table, used to drop expired partitions */
+	int			history_max;
 }
 zbx_hk_history_rule_t;
 
@@ -384,6 +388,9 @@ static void	hk_history_item_update(zbx_hk_history_rule_t *rules, zbx_hk_history_
 		}
 
 		hk_history_delete_queue_append(rule, now, item_record, history);
+
+		if (rule->history_max < history)
+			rule->history_max = history;
 	}
 }
 
@@ -400,9 +407,13 @@ static void	hk_history_item_update(zbx_hk_history_rule_t *rules, zbx_hk_history_
  ******************************************************************************/
 static void	hk_history_update(zbx_hk_history_rule_t *rules, int now)
 {
-	DB_RESULT	result;
-	DB_ROW		row;
-	char		*tmp = NULL;
+	DB_RESULT		result;
+	DB_ROW			row;
+	char			*tmp = NULL;
+	zbx_hk_history_rule_t	*rule;
+
+	for (rule = rules; NULL != rule->table; rule++)
+		rule->history_max = 0;
 
 	result = DBselect(
 			"select i.itemid,i.value_type,i.history,i.trends,h.hostid"
@@ -415,9 +426,8 @@ static void	hk_history_update(zbx_hk_history_rule_t *rules, int now)
 
 	while (NULL != (row = DBfetch(result)))
 	{
-		zbx_uint64_t		itemid, hostid;
-		int			history, trends, value_type;
-		zbx_hk_history_rule_t	*rule;
+		zbx_uint64_t	itemid, hostid;
+		int		history, trends, value_type;
 
 		ZBX_STR2UINT64(itemid, row[0]);
 		value_type = atoi(row[1]);
@@ -434,12 +444,14 @@ static void	hk_history_update(zbx_hk_history_rule_t *rules, int now)
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "invalid history storage period '%s' for itemid '%s'",
 						tmp, row[0]);
+				rule->history_max = ZBX_HK_PERIOD_MAX;
 				continue;
 			}
 
 			if (0 != history && (ZBX_HK_HISTORY_MIN > history || ZBX_HK_PERIOD_MAX < history))
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "invalid history storage period for itemid '%s'", row[0]);
+				rule->history_max = ZBX_HK_PERIOD_MAX;
 				continue;
 			}
 
@@ -465,11 +477,13 @@ static void	hk_history_update(zbx_hk_history_rule_t *rules, int now)
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "invalid trends storage period '%s' for itemid '%s'",
 						tmp, row[0]);
+				rule->history_max = ZBX_HK_PERIOD_MAX;
 				continue;
 			}
 			else if (0 != trends && (ZBX_HK_TRENDS_MIN > trends || ZBX_HK_PERIOD_MAX < trends))
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "invalid trends storage period for itemid '%s'", row[0]);
+				rule->history_max = ZBX_HK_PERIOD_MAX;
 				continue;
 			}
 
@@ -603,7 +617,7 @@ static void	hk_drop_partition_for_rule(zbx_hk_history_rule_t *rule, int now)
  ******************************************************************************/
 static int	housekeeping_history_and_trends(int now)
 {
-	int			deleted = 0, i, rc;
+	int			deleted = 0, i, rc, clock_min;
 	zbx_hk_history_rule_t	*rule;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() now:%d", __func__, now);
@@ -615,9 +629,6 @@ static int	housekeeping_history_and_trends(int now)
 	/* we need to clear records from */
 	for (rule = hk_history_rules; NULL != rule->table; rule++)
 	{
-		if (ZBX_HK_MODE_DISABLED == *rule->poption_mode)
-			continue;
-
 		/* If partitioning enabled for history and/or trends then drop partitions with expired history.  */
 		/* ZBX_HK_MODE_PARTITION is set during configuration sync based on the following: */
 		/* 1. "Override item history (or trend) period" must be on 2. DB must be PostgreSQL */
@@ -628,6 +639,30 @@ static int	housekeeping_history_and_trends(int now)
 			continue;
 		}
 
+		/* Tables range partitioned by clock get future partitions created even with housekeeping */
+		/* disabled. Expired partitions are dropped when no item keeps history for that long.    */
+		if (ZBX_HK_MODE_DISABLED == *rule->poption_mode)
+		{
+			hk_history_partitions_update(rule->table, 0, now);
+			continue;
+		}
+
+		clock_min = hk_history_partitions_update(rule->table,
+				ZBX_HK_PERIOD_MAX > rule->history_max ? now - rule->history_max : 0, now);
+
+		if (0 != clock_min)
+		{
+			zbx_hashset_iter_t	iter;
+			zbx_hk_item_cache_t	*item_record;
+
+			zbx_hashset_iter_reset(&rule->item_cache, &iter);
+			while (NULL != (item_record = (zbx_hk_item_cache_t *)zbx_hashset_iter_next(&iter)))
+			{
+				if (item_record->min_clock < clock_min)
+					item_record->min_clock = clock_min;
+			}
+		}
+
 		/* process delete queue for the housekeeping rule */
 
 		zbx_vector_ptr_sort(&rule->delete_queue, hk_item_update_cache_compare);
@@ -636,6 +671,10 @@ static int	housekeeping_history_and_trends(int now)
 		{
 			zbx_hk_delete_queue_t	*item_record = (zbx_hk_delete_queue_t *)rule->delete_queue.values[i];
 
+			/* the records were removed by dropping partitions */
+			if (item_record->min_clock <= clock_min)
+				continue;
+
 			rc = DBexecute("delete from %s where itemid=" ZBX_FS_UI64 " and clock<%d",
 					rule->table, item_record->itemid, item_record->min_clock);
 			if (ZBX_DB_OK < rc)
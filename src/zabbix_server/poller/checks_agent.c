@@ -18,8 +18,16 @@
 **/
 
 #include "common.h"
+
+#ifdef HAVE_LIBEVENT
+#	include <event.h>
+#endif
+
 #include "comms.h"
 #include "log.h"
+#include "zbxalgo.h"
+#include "zbxjson.h"
+#include "version.h"
 #include "../../libs/zbxcrypto/tls_tcp_active.h"
 
 #include "checks_agent.h"
@@ -28,6 +36,310 @@
 extern unsigned char	program_type;
 #endif
 
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_interface_set_version                                      *
+ *                                                                            *
+ * Purpose: share agent version learned from passive checks with other        *
+ *          pollers                                                           *
+ *                                                                            *
+ * Parameters: item    - [IN] an item of the interface                        *
+ *             version - [IN] the agent version or ZBX_AGENT_VERSION_LEGACY   *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_interface_set_version(const DC_ITEM *item, int version)
+{
+	if (item->interface.version == version)
+		return;
+
+	if (ZBX_AGENT_VERSION_LEGACY == version)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "agent at [%s]:%hu does not support multiple keys per request",
+				item->interface.addr, item->interface.port);
+	}
+
+	DCconfig_update_interface_version(item->interface.interfaceid, version);
+}
+
+static int	agent_item_compare(const void *d1, const void *d2)
+{
+	const DC_ITEM	*i1 = *(const DC_ITEM * const *)d1;
+	const DC_ITEM	*i2 = *(const DC_ITEM * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->interface.interfaceid, i2->interface.interfaceid);
+	ZBX_RETURN_IF_NOT_EQUAL(i1, i2);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_group_size                                                 *
+ *                                                                            *
+ * Purpose: get the number of items that can be requested over one connection *
+ *                                                                            *
+ * Parameters: items    - [IN] the items                                      *
+ *             indexes  - [IN] the indexes of items to check, sorted by       *
+ *                             interface                                      *
+ *             num      - [IN] the number of indexes                          *
+ *             max_keys - [IN] the maximum number of keys per request         *
+ *                                                                            *
+ * Return value: the number of leading indexes referring to items of the same *
+ *               interface, limited by max_keys                               *
+ *                                                                            *
+ * Comments: Agents known not to support multiple keys per request are asked  *
+ *           one key per connection.                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_group_size(const DC_ITEM *items, const int *indexes, int num, int max_keys)
+{
+	zbx_uint64_t	interfaceid = items[indexes[0]].interface.interfaceid;
+	int		i;
+
+	if (!ZBX_AGENT_MULTIKEY_REQUEST(items[indexes[0]].interface.version))
+		return 1;
+
+	for (i = 1; i < num && i < max_keys; i++)
+	{
+		if (items[indexes[i]].interface.interfaceid != interfaceid)
+			break;
+	}
+
+	return i;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_keys_request                                               *
+ *                                                                            *
+ * Purpose: prepare request for multiple passive checks                       *
+ *                                                                            *
+ * Parameters: items   - [IN] the items                                       *
+ *             indexes - [IN] the indexes of items to request                 *
+ *             num     - [IN] the number of indexes                           *
+ *                                                                            *
+ * Return value: the request, must be freed by caller                         *
+ *                                                                            *
+ ******************************************************************************/
+static char	*agent_keys_request(const DC_ITEM *items, const int *indexes, int num)
+{
+	struct zbx_json	j;
+	char		*request;
+	int		i;
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PASSIVE_CHECKS, ZBX_JSON_TYPE_STRING);
+	zbx_json_addarray(&j, ZBX_PROTO_TAG_DATA);
+
+	for (i = 0; i < num; i++)
+	{
+		zbx_json_addobject(&j, NULL);
+		zbx_json_addstring(&j, ZBX_PROTO_TAG_KEY, items[indexes[i]].key, ZBX_JSON_TYPE_STRING);
+		zbx_json_close(&j);
+	}
+
+	request = zbx_strdup(NULL, j.buffer);
+	zbx_json_free(&j);
+
+	return request;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_parse_value                                                *
+ *                                                                            *
+ * Purpose: convert passive agent response into item value or error          *
+ *                                                                            *
+ * Parameters: item         - [IN] the item                                   *
+ *             buffer       - [IN] the received data without protocol header, *
+ *                                 terminated with '\0'                       *
+ *             read_bytes   - [IN] the size of received data                  *
+ *             received_len - [IN] the number of bytes received from socket   *
+ *             result       - [OUT] the item value or error message           *
+ *                                                                            *
+ * Return value: SUCCEED - the value was stored in result                     *
+ *               NETWORK_ERROR - agent dropped connection without response    *
+ *               NOTSUPPORTED - item not supported by the agent               *
+ *               AGENT_ERROR - uncritical error on agent side occurred        *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_parse_value(const DC_ITEM *item, char *buffer, size_t read_bytes, size_t received_len,
+		AGENT_RESULT *result)
+{
+	zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", buffer);
+
+	if (0 == strcmp(buffer, ZBX_NOTSUPPORTED))
+	{
+		/* 'ZBX_NOTSUPPORTED\0<error message>' */
+		if (sizeof(ZBX_NOTSUPPORTED) < read_bytes)
+			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", buffer + sizeof(ZBX_NOTSUPPORTED)));
+		else
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+
+		return NOTSUPPORTED;
+	}
+
+	if (0 == strcmp(buffer, ZBX_ERROR))
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
+		return AGENT_ERROR;
+	}
+
+	if (0 == received_len)
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.",
+				item->interface.addr));
+		return NETWORK_ERROR;
+	}
+
+	set_result_type(result, ITEM_VALUE_TYPE_TEXT, buffer);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_parse_values                                               *
+ *                                                                            *
+ * Purpose: convert passive agent response to multiple keys request into      *
+ *          item values or errors                                             *
+ *                                                                            *
+ * Parameters: items    - [IN] the items                                      *
+ *             results  - [OUT] the item values or error messages             *
+ *             errcodes - [OUT] the item error codes                          *
+ *             indexes  - [IN] the indexes of requested items                 *
+ *             num      - [IN] the number of indexes                          *
+ *             data     - [IN] the received data without protocol header      *
+ *                                                                            *
+ * Return value: SUCCEED - the results of all requested items were set        *
+ *               FAIL    - the agent does not support multiple keys per       *
+ *                         request, results were not changed                  *
+ *                                                                            *
+ * Comments: The agent version from response is stored in configuration      *
+ *           cache, so other pollers know how to request the agent.           *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_parse_values(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, const int *indexes,
+		int num, const char *data)
+{
+	struct zbx_json_parse	jp, jp_data, jp_row;
+	const char		*p = NULL;
+	char			*value = NULL, version[MAX_STRING_LEN];
+	size_t			value_alloc = 0;
+	int			i, version_num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "get values from agent result: '%s'", data);
+
+	/* agents not supporting the request respond with ZBX_NOTSUPPORTED as for invalid key */
+	if (SUCCEED != zbx_json_open(data, &jp) || SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA,
+			&jp_data))
+	{
+		agent_interface_set_version(&items[indexes[0]], ZBX_AGENT_VERSION_LEGACY);
+		return FAIL;
+	}
+
+	/* agent that has responded supports multiple keys per request whatever its version format */
+	if (SUCCEED != zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_VERSION, version, sizeof(version), NULL) ||
+			ZBX_AGENT_VERSION_MULTIKEY > (version_num = zbx_get_component_version(version)))
+	{
+		version_num = ZBX_AGENT_VERSION_MULTIKEY;
+	}
+
+	agent_interface_set_version(&items[indexes[0]], version_num);
+
+	for (i = 0; i < num; i++)
+	{
+		int	index = indexes[i];
+
+		if (NULL == (p = zbx_json_next(&jp_data, p)))
+			break;
+
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row))
+		{
+			SET_MSG_RESULT(&results[index], zbx_dsprintf(NULL, "Invalid Zabbix Agent response: %s",
+					zbx_json_strerror()));
+			errcodes[index] = NOTSUPPORTED;
+		}
+		else if (SUCCEED == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_VALUE, &value, &value_alloc,
+				NULL))
+		{
+			set_result_type(&results[index], ITEM_VALUE_TYPE_TEXT, value);
+			errcodes[index] = SUCCEED;
+		}
+		else if (SUCCEED == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_ERROR, &value, &value_alloc,
+				NULL))
+		{
+			SET_MSG_RESULT(&results[index], zbx_strdup(NULL, value));
+			errcodes[index] = NOTSUPPORTED;
+		}
+		else
+		{
+			SET_MSG_RESULT(&results[index], zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+			errcodes[index] = NOTSUPPORTED;
+		}
+	}
+
+	for (; i < num; i++)
+	{
+		SET_MSG_RESULT(&results[indexes[i]], zbx_strdup(NULL, "Value is missing in Zabbix Agent response."));
+		errcodes[indexes[i]] = NOTSUPPORTED;
+	}
+
+	zbx_free(value);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_get_tls_args                                               *
+ *                                                                            *
+ * Purpose: get TLS connection parameters of item host                        *
+ *                                                                            *
+ * Parameters: item     - [IN] the item                                       *
+ *             tls_arg1 - [OUT] the certificate issuer or PSK identity        *
+ *             tls_arg2 - [OUT] the certificate subject or PSK                *
+ *             error    - [OUT] the error message                             *
+ *                                                                            *
+ * Return value: SUCCEED - the parameters were retrieved                      *
+ *               CONFIG_ERROR - the connection cannot be established          *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_get_tls_args(const DC_ITEM *item, const char **tls_arg1, const char **tls_arg2, char **error)
+{
+	switch (item->host.tls_connect)
+	{
+		case ZBX_TCP_SEC_UNENCRYPTED:
+			*tls_arg1 = NULL;
+			*tls_arg2 = NULL;
+			break;
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		case ZBX_TCP_SEC_TLS_CERT:
+			*tls_arg1 = item->host.tls_issuer;
+			*tls_arg2 = item->host.tls_subject;
+			break;
+		case ZBX_TCP_SEC_TLS_PSK:
+			*tls_arg1 = item->host.tls_psk_identity;
+			*tls_arg2 = item->host.tls_psk;
+			break;
+#else
+		case ZBX_TCP_SEC_TLS_CERT:
+		case ZBX_TCP_SEC_TLS_PSK:
+			*error = zbx_dsprintf(*error, "A TLS connection is configured to be used with agent"
+					" but support for TLS was not compiled into %s.",
+					get_program_type_string(program_type));
+			return CONFIG_ERROR;
+#endif
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			*error = zbx_strdup(*error, "Invalid TLS connection parameters.");
+			return CONFIG_ERROR;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_value_agent                                                  *
@@ -52,41 +364,17 @@ int	get_value_agent(const DC_ITEM *item, AGENT_RESULT *result)
 {
 	zbx_socket_t	s;
 	const char	*tls_arg1, *tls_arg2;
+	char		*error = NULL;
 	int		ret = SUCCEED;
 	ssize_t		received_len;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' key:'%s' conn:'%s'", __func__, item->host.host,
 			item->interface.addr, item->key, zbx_tcp_connection_type_name(item->host.tls_connect));
 
-	switch (item->host.tls_connect)
+	if (SUCCEED != (ret = agent_get_tls_args(item, &tls_arg1, &tls_arg2, &error)))
 	{
-		case ZBX_TCP_SEC_UNENCRYPTED:
-			tls_arg1 = NULL;
-			tls_arg2 = NULL;
-			break;
-#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-		case ZBX_TCP_SEC_TLS_CERT:
-			tls_arg1 = item->host.tls_issuer;
-			tls_arg2 = item->host.tls_subject;
-			break;
-		case ZBX_TCP_SEC_TLS_PSK:
-			tls_arg1 = item->host.tls_psk_identity;
-			tls_arg2 = item->host.tls_psk;
-			break;
-#else
-		case ZBX_TCP_SEC_TLS_CERT:
-		case ZBX_TCP_SEC_TLS_PSK:
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "A TLS connection is configured to be used with agent"
-					" but support for TLS was not compiled into %s.",
-					get_program_type_string(program_type)));
-			ret = CONFIG_ERROR;
-			goto out;
-#endif
-		default:
-			THIS_SHOULD_NEVER_HAPPEN;
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid TLS connection parameters."));
-			ret = CONFIG_ERROR;
-			goto out;
+		SET_MSG_RESULT(result, error);
+		goto out;
 	}
 
 	if (SUCCEED == (ret = zbx_tcp_connect(&s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, 0,
@@ -107,40 +395,697 @@ int	get_value_agent(const DC_ITEM *item, AGENT_RESULT *result)
 		ret = NETWORK_ERROR;
 
 	if (SUCCEED == ret)
+		ret = agent_parse_value(item, s.buffer, s.read_bytes, (size_t)received_len, result);
+	else
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
+
+	zbx_tcp_close(&s);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_get_values_sync                                            *
+ *                                                                            *
+ * Purpose: retrieve values of items on the same interface over one           *
+ *          blocking connection                                               *
+ *                                                                            *
+ * Parameters: items    - [IN] the items                                      *
+ *             results  - [OUT] the check results                             *
+ *             errcodes - [OUT] the item error codes                          *
+ *             indexes  - [IN] the indexes of items to check                  *
+ *             num      - [IN] the number of indexes                          *
+ *                                                                            *
+ * Comments: Falls back to one connection per item if the agent does not      *
+ *           support multiple keys per request or did not respond to all keys *
+ *           within Timeout, so every key is given its own Timeout.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_get_values_sync(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, const int *indexes,
+		int num)
+{
+	const DC_ITEM	*item = &items[indexes[0]];
+	zbx_socket_t	s;
+	const char	*tls_arg1, *tls_arg2;
+	char		*request, *error = NULL;
+	int		i, ret;
+	ssize_t		received_len;
+
+	if (1 == num)
+	{
+		zbx_alarm_on(CONFIG_TIMEOUT);
+		errcodes[indexes[0]] = get_value_agent(item, &results[indexes[0]]);
+		zbx_alarm_off();
+		return;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' num:%d conn:'%s'", __func__, item->host.host,
+			item->interface.addr, num, zbx_tcp_connection_type_name(item->host.tls_connect));
+
+	if (SUCCEED != (ret = agent_get_tls_args(item, &tls_arg1, &tls_arg2, &error)))
+		goto out;
+
+	request = agent_keys_request(items, indexes, num);
+
+	zbx_alarm_on(CONFIG_TIMEOUT);
+
+	if (SUCCEED == (ret = zbx_tcp_connect(&s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, 0,
+			item->host.tls_connect, tls_arg1, tls_arg2)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s]", request);
+
+		if (SUCCEED != zbx_tcp_send(&s, request))
+			ret = NETWORK_ERROR;
+		else if (FAIL != (received_len = zbx_tcp_recv_ext(&s, 0)))
+			ret = SUCCEED;
+		else if (SUCCEED == zbx_alarm_timed_out())
+			ret = TIMEOUT_ERROR;
+		else
+			ret = NETWORK_ERROR;
+	}
+	else
+		ret = NETWORK_ERROR;
+
+	if (TIMEOUT_ERROR == ret)
+	{
+		/* agent is reachable, but the keys did not fit in one Timeout */
+		zabbix_log(LOG_LEVEL_DEBUG, "multiple keys request to [%s]:%hu timed out, checking keys one by one",
+				item->interface.addr, item->interface.port);
+		ret = FAIL;
+	}
+	else if (SUCCEED != ret)
+	{
+		error = zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror());
+	}
+	else if (0 == received_len)
+	{
+		error = zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.",
+				item->interface.addr);
+		ret = NETWORK_ERROR;
+	}
+	else if (SUCCEED != agent_parse_values(items, results, errcodes, indexes, num, s.buffer))
+		ret = FAIL;
+
+	zbx_tcp_close(&s);
+	zbx_alarm_off();
+	zbx_free(request);
+
+	if (FAIL == ret)
+	{
+		for (i = 0; i < num; i++)
+		{
+			zbx_alarm_on(CONFIG_TIMEOUT);
+			errcodes[indexes[i]] = get_value_agent(&items[indexes[i]], &results[indexes[i]]);
+			zbx_alarm_off();
+		}
+	}
+out:
+	if (NULL != error)
+	{
+		for (i = 0; i < num; i++)
+		{
+			SET_MSG_RESULT(&results[indexes[i]], zbx_strdup(NULL, error));
+			errcodes[indexes[i]] = ret;
+		}
+
+		zbx_free(error);
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+}
+
+#ifdef HAVE_LIBEVENT
+
+#define ZBX_AGENT_STEP_CONNECT	0
+#define ZBX_AGENT_STEP_SEND	1
+#define ZBX_AGENT_STEP_RECV	2
+
+#if !defined(LIBEVENT_VERSION_NUMBER) || LIBEVENT_VERSION_NUMBER < 0x2000000
+typedef int evutil_socket_t;
+
+static struct event	*event_new(struct event_base *ev, evutil_socket_t fd, short what,
+		void(*cb_func)(int, short, void *), void *cb_arg)
+{
+	struct event	*event;
+
+	event = zbx_malloc(NULL, sizeof(struct event));
+	event_set(event, fd, what, cb_func, cb_arg);
+	event_base_set(ev, event);
+
+	return event;
+}
+
+static void	event_free(struct event *event)
+{
+	event_del(event);
+	zbx_free(event);
+}
+#endif
+
+/* passive checks of one interface being processed by asynchronous agent poller */
+typedef struct
+{
+	const DC_ITEM		*items;
+	AGENT_RESULT		*results;
+	int			*errcodes;
+	const int		*indexes;	/* indexes of items requested over the connection */
+	int			indexes_num;
+	const DC_ITEM		*item;		/* the first requested item, its interface is shared by others */
+	unsigned char		retry;		/* requested items must be checked again one by one */
+	struct event_base	*base;
+	struct event		*event;
+	short			event_what;
+	unsigned char		step;
+	double			deadline;
+	char			*request;	/* multiple keys request, single item key is sent as is */
+	zbx_socket_t		s;
+	zbx_tcp_send_context_t	send;
+	zbx_tcp_recv_context_t	recv;
+}
+zbx_agent_context_t;
+
+static void	agent_event_cb(evutil_socket_t fd, short what, void *arg);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_context_release                                            *
+ *                                                                            *
+ * Purpose: release passive check connection resources                        *
+ *                                                                            *
+ * Parameters: context - [IN] the passive check context                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_context_release(zbx_agent_context_t *context)
+{
+	if (NULL != context->event)
+	{
+		event_free(context->event);
+		context->event = NULL;
+	}
+
+	if (ZBX_SOCKET_ERROR != context->s.socket)
+	{
+		zbx_tcp_close(&context->s);
+		context->s.socket = ZBX_SOCKET_ERROR;
+	}
+
+	zbx_tcp_send_context_clear(&context->send);
+	zbx_free(context->request);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_context_finish                                             *
+ *                                                                            *
+ * Purpose: complete passive checks and release their resources               *
+ *                                                                            *
+ * Parameters: context - [IN] the passive check context                       *
+ *             errcode - [IN] the check result code                           *
+ *             error   - [IN] the error message, NULL on success              *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_context_finish(zbx_agent_context_t *context, int errcode, const char *error)
+{
+	int	i;
+
+	for (i = 0; i < context->indexes_num; i++)
 	{
-		zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", s.buffer);
+		int	index = context->indexes[i];
 
-		if (0 == strcmp(s.buffer, ZBX_NOTSUPPORTED))
+		if (NULL != error)
 		{
-			/* 'ZBX_NOTSUPPORTED\0<error message>' */
-			if (sizeof(ZBX_NOTSUPPORTED) < s.read_bytes)
-				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", s.buffer + sizeof(ZBX_NOTSUPPORTED)));
-			else
-				SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+			SET_MSG_RESULT(&context->results[index], zbx_dsprintf(NULL, "Get value from agent failed: %s",
+					error));
+		}
+
+		context->errcodes[index] = errcode;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "passive check host:'%s' key:'%s' completed:%s", context->item->host.host,
+				context->items[index].key, zbx_result_string(errcode));
+	}
+
+	agent_context_release(context);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_context_wait                                               *
+ *                                                                            *
+ * Purpose: wait until the socket becomes ready for the next step             *
+ *                                                                            *
+ * Parameters: context - [IN] the passive check context                       *
+ *             what    - [IN] EV_READ or EV_WRITE                             *
+ *                                                                            *
+ * Comments: All steps of a check share the deadline set when its connection  *
+ *           was started, so a check takes no longer than Timeout regardless  *
+ *           how the peer splits its data.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_context_wait(zbx_agent_context_t *context, short what)
+{
+	struct timeval	tv;
+	double		left;
+
+	if (0 > (left = context->deadline - zbx_time()))
+		left = 0;
+
+	tv.tv_sec = (time_t)left;
+	tv.tv_usec = (suseconds_t)((left - (double)tv.tv_sec) * 1000000);
+
+	if (NULL != context->event && what != context->event_what)
+	{
+		event_free(context->event);
+		context->event = NULL;
+	}
+
+	if (NULL == context->event)
+	{
+		context->event = event_new(context->base, context->s.socket, what, agent_event_cb, context);
+		context->event_what = what;
+	}
+
+	event_add(context->event, &tv);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_context_connect                                            *
+ *                                                                            *
+ * Purpose: start non-blocking connection to the item interface               *
+ *                                                                            *
+ * Parameters: context - [IN] the passive check context                       *
+ *                                                                            *
+ * Return value: SUCCEED - the connection is in progress                      *
+ *               FAIL    - the check was completed with network error         *
+ *                                                                            *
+ * Comments: Host name resolution is synchronous, so each check is given      *
+ *           Timeout seconds from the start of its own connection.            *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_context_connect(zbx_agent_context_t *context)
+{
+	struct addrinfo	hints, *ai = NULL, *ai_bind = NULL;
+	char		service[8], *error = NULL;
+	const DC_ITEM	*item = context->item;
+	int		flags;
+
+	context->deadline = zbx_time() + CONFIG_TIMEOUT;
+	context->s.connection_type = ZBX_TCP_SEC_UNENCRYPTED;
+	zbx_strlcpy(context->s.peer, item->interface.addr, sizeof(context->s.peer));
+
+	zbx_snprintf(service, sizeof(service), "%hu", item->interface.port);
+	memset(&hints, 0x00, sizeof(struct addrinfo));
+	hints.ai_family = PF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if (0 != getaddrinfo(item->interface.addr, service, &hints, &ai))
+	{
+		error = zbx_dsprintf(error, "cannot resolve [%s]", item->interface.addr);
+		goto out;
+	}
+
+	if (ZBX_SOCKET_ERROR == (context->s.socket = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+			ai->ai_protocol)))
+	{
+		error = zbx_dsprintf(error, "cannot create socket [[%s]:%hu]: %s", item->interface.addr,
+				item->interface.port, zbx_strerror(errno));
+		goto out;
+	}
+
+#if !SOCK_CLOEXEC
+	fcntl(context->s.socket, F_SETFD, FD_CLOEXEC);
+#endif
+	if (-1 == (flags = fcntl(context->s.socket, F_GETFL, 0)) ||
+			-1 == fcntl(context->s.socket, F_SETFL, flags | O_NONBLOCK))
+	{
+		error = zbx_dsprintf(error, "cannot set non-blocking mode [[%s]:%hu]: %s", item->interface.addr,
+				item->interface.port, zbx_strerror(errno));
+		goto out;
+	}
+
+	if (NULL != CONFIG_SOURCE_IP)
+	{
+		memset(&hints, 0x00, sizeof(struct addrinfo));
+		hints.ai_family = PF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_NUMERICHOST;
+
+		if (0 != getaddrinfo(CONFIG_SOURCE_IP, NULL, &hints, &ai_bind))
+		{
+			error = zbx_dsprintf(error, "invalid source IP address [%s]", CONFIG_SOURCE_IP);
+			goto out;
+		}
+
+		if (-1 == bind(context->s.socket, ai_bind->ai_addr, ai_bind->ai_addrlen))
+		{
+			error = zbx_dsprintf(error, "bind() failed: %s", zbx_strerror(errno));
+			goto out;
+		}
+	}
+
+	if (-1 == connect(context->s.socket, ai->ai_addr, (socklen_t)ai->ai_addrlen) && EINPROGRESS != errno)
+	{
+		error = zbx_dsprintf(error, "cannot connect to [[%s]:%hu]: %s", item->interface.addr,
+				item->interface.port, zbx_strerror(errno));
+		goto out;
+	}
+
+	context->step = ZBX_AGENT_STEP_CONNECT;
+	agent_context_wait(context, EV_WRITE);
+out:
+	if (NULL != ai)
+		freeaddrinfo(ai);
+
+	if (NULL != ai_bind)
+		freeaddrinfo(ai_bind);
+
+	if (NULL != error)
+	{
+		agent_context_finish(context, NETWORK_ERROR, error);
+		zbx_free(error);
+
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_context_prepare_request                                    *
+ *                                                                            *
+ * Purpose: prepare item key or multiple keys request to be sent              *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_context_prepare_request(zbx_agent_context_t *context)
+{
+	const char	*key;
+
+	if (1 == context->indexes_num)
+		key = context->item->key;
+	else
+		key = context->request = agent_keys_request(context->items, context->indexes, context->indexes_num);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s]", key);
+
+	zbx_tcp_send_context_init(key, strlen(key), ZBX_TCP_PROTOCOL, &context->send);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_context_complete                                           *
+ *                                                                            *
+ * Purpose: convert received response into item values                        *
+ *                                                                            *
+ * Parameters: context - [IN] the passive check context                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_context_complete(zbx_agent_context_t *context)
+{
+	size_t	received_len = context->s.read_bytes + context->recv.offset;
+	int	ret;
 
-			ret = NOTSUPPORTED;
+	if (1 == context->indexes_num)
+	{
+		ret = agent_parse_value(context->item, context->s.buffer, context->s.read_bytes, received_len,
+				&context->results[context->indexes[0]]);
+		agent_context_finish(context, ret, NULL);
+	}
+	else if (0 == received_len)
+	{
+		char	*error;
+
+		error = zbx_dsprintf(NULL, "received empty response from Zabbix Agent at [%s], assuming that"
+				" agent dropped connection because of access permissions",
+				context->item->interface.addr);
+		agent_context_finish(context, NETWORK_ERROR, error);
+		zbx_free(error);
+	}
+	else
+	{
+		/* items of legacy agent are checked again one by one after the event loop exits */
+		if (SUCCEED != agent_parse_values(context->items, context->results, context->errcodes,
+				context->indexes, context->indexes_num, context->s.buffer))
+		{
+			context->retry = 1;
 		}
-		else if (0 == strcmp(s.buffer, ZBX_ERROR))
+
+		agent_context_release(context);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_event_cb                                                   *
+ *                                                                            *
+ * Purpose: advance passive check when its socket is ready or timed out       *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_event_cb(evutil_socket_t fd, short what, void *arg)
+{
+	zbx_agent_context_t	*context = (zbx_agent_context_t *)arg;
+	char			*error = NULL;
+	int			ret;
+
+	if (0 != (what & EV_TIMEOUT))
+	{
+		if (ZBX_AGENT_STEP_CONNECT == context->step)
 		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
-			ret = AGENT_ERROR;
+			error = zbx_dsprintf(NULL, "cannot connect to [[%s]:%hu]: %s", context->item->interface.addr,
+					context->item->interface.port, zbx_strerror(ETIMEDOUT));
+			agent_context_finish(context, NETWORK_ERROR, error);
 		}
-		else if (0 == received_len)
+		else if (1 < context->indexes_num)
 		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
-					" Assuming that agent dropped connection because of access permissions.",
-					item->interface.addr));
-			ret = NETWORK_ERROR;
+			/* agent is reachable, give each key its own Timeout instead of failing them all */
+			zabbix_log(LOG_LEVEL_DEBUG, "multiple keys request to [%s]:%hu timed out, checking keys one"
+					" by one", context->item->interface.addr, context->item->interface.port);
+			context->retry = 1;
+			agent_context_release(context);
 		}
 		else
-			set_result_type(result, ITEM_VALUE_TYPE_TEXT, s.buffer);
+		{
+			agent_context_finish(context, TIMEOUT_ERROR, ZBX_AGENT_STEP_SEND == context->step ?
+					"ZBX_TCP_WRITE() timed out" : "ZBX_TCP_READ() timed out");
+		}
+
+		goto out;
 	}
-	else
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
 
-	zbx_tcp_close(&s);
+	switch (context->step)
+	{
+		case ZBX_AGENT_STEP_CONNECT:
+		{
+			int		socket_error = 0;
+			socklen_t	socket_error_len = sizeof(socket_error);
+
+			if (0 != getsockopt(fd, SOL_SOCKET, SO_ERROR, &socket_error, &socket_error_len))
+				socket_error = errno;
+
+			if (0 != socket_error)
+			{
+				error = zbx_dsprintf(NULL, "cannot connect to [[%s]:%hu]: %s",
+						context->item->interface.addr, context->item->interface.port,
+						zbx_strerror(socket_error));
+				agent_context_finish(context, NETWORK_ERROR, error);
+				goto out;
+			}
+
+			agent_context_prepare_request(context);
+			context->step = ZBX_AGENT_STEP_SEND;
+		}
+			ZBX_FALLTHROUGH;
+		case ZBX_AGENT_STEP_SEND:
+			if (ZBX_TCP_AGAIN == (ret = zbx_tcp_send_context(&context->s, &context->send)))
+			{
+				agent_context_wait(context, EV_WRITE);
+				break;
+			}
+
+			if (SUCCEED != ret)
+			{
+				agent_context_finish(context, NETWORK_ERROR, zbx_socket_strerror());
+				break;
+			}
+
+			context->step = ZBX_AGENT_STEP_RECV;
+			zbx_tcp_recv_context_init(&context->s, &context->recv);
+			ZBX_FALLTHROUGH;
+		case ZBX_AGENT_STEP_RECV:
+			if (ZBX_TCP_AGAIN == (ret = zbx_tcp_recv_context(&context->s, &context->recv)))
+			{
+				agent_context_wait(context, EV_READ);
+				break;
+			}
+
+			if (SUCCEED != ret)
+			{
+				agent_context_finish(context, NETWORK_ERROR, zbx_socket_strerror());
+				break;
+			}
+
+			agent_context_complete(context);
+			break;
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			agent_context_finish(context, NETWORK_ERROR, "invalid passive check state");
+	}
 out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+	zbx_free(error);
+}
 
-	return ret;
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_agent                                                 *
+ *                                                                            *
+ * Purpose: retrieve values of a batch of passive agent checks                *
+ *                                                                            *
+ * Parameters: items    - [IN] the items to check                             *
+ *             results  - [OUT] the check results                             *
+ *             errcodes - [IN/OUT] the item error codes, only items with      *
+ *                                 SUCCEED error code are checked             *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: Items of the same interface are requested over one connection,   *
+ *           up to MAX_AGENT_REQUEST_KEYS keys per request. Agent versions    *
+ *           are kept in configuration cache, agents that do not support      *
+ *           multiple keys per request are asked one key per connection.      *
+ *           Keys of timed out multiple keys request are checked again one by *
+ *           one without affecting interface availability.                    *
+ *           Unencrypted checks are performed concurrently over non-blocking  *
+ *           sockets multiplexed by a single event loop, each connection is   *
+ *           given Timeout seconds from its start to complete. Encrypted      *
+ *           checks are synchronous as TLS handshake is blocking.             *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_agent(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+#ifdef HAVE_LIBEVENT
+	zbx_agent_context_t	*contexts = NULL;
+	struct event_base	*base;
+	int			async_num = 0, contexts_num, j, k;
+#endif
+	zbx_vector_ptr_t	checks;
+	int			*indexes = NULL, indexes_num, i, group_num, max_keys = MAX_AGENT_REQUEST_KEYS;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	zbx_vector_ptr_create(&checks);
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED == errcodes[i])
+			zbx_vector_ptr_append(&checks, (void *)&items[i]);
+	}
+
+	if (0 == (indexes_num = checks.values_num))
+		goto out;
+
+	zbx_vector_ptr_sort(&checks, agent_item_compare);
+
+	indexes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)indexes_num);
+
+	for (i = 0; i < indexes_num; i++)
+		indexes[i] = (int)((const DC_ITEM *)checks.values[i] - items);
+
+	/* perform the blocking checks first so they do not eat into the timeouts of asynchronous checks */
+	for (i = 0; i < indexes_num; i += group_num)
+	{
+		group_num = agent_group_size(items, indexes + i, indexes_num - i, max_keys);
+#ifdef HAVE_LIBEVENT
+		if (ZBX_TCP_SEC_UNENCRYPTED == items[indexes[i]].host.tls_connect)
+			continue;
+#endif
+		agent_get_values_sync(items, results, errcodes, indexes + i, group_num);
+	}
+
+#ifdef HAVE_LIBEVENT
+	if (NULL == (base = event_base_new()))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot initialize event base, falling back to synchronous checks");
+
+		for (i = 0; i < indexes_num; i += group_num)
+		{
+			group_num = agent_group_size(items, indexes + i, indexes_num - i, max_keys);
+
+			if (ZBX_TCP_SEC_UNENCRYPTED == items[indexes[i]].host.tls_connect)
+				agent_get_values_sync(items, results, errcodes, indexes + i, group_num);
+		}
+
+		goto out;
+	}
+
+	contexts = (zbx_agent_context_t *)zbx_malloc(NULL, sizeof(zbx_agent_context_t) * (size_t)indexes_num);
+
+	/* the second round checks one by one items of agents found not to support multiple keys per request */
+	/* and items of timed out multiple keys requests                                                    */
+	while (0 != indexes_num)
+	{
+		memset(contexts, 0, sizeof(zbx_agent_context_t) * (size_t)indexes_num);
+		contexts_num = 0;
+
+		for (i = 0; i < indexes_num; i += group_num)
+		{
+			zbx_agent_context_t	*context;
+
+			group_num = agent_group_size(items, indexes + i, indexes_num - i, max_keys);
+
+			if (ZBX_TCP_SEC_UNENCRYPTED != items[indexes[i]].host.tls_connect)
+				continue;
+
+			context = &contexts[contexts_num++];
+			context->items = items;
+			context->results = results;
+			context->errcodes = errcodes;
+			context->indexes = indexes + i;
+			context->indexes_num = group_num;
+			context->item = &items[indexes[i]];
+			context->base = base;
+			context->s.socket = ZBX_SOCKET_ERROR;
+
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() host:'%s' addr:'%s' key:'%s' num:%d", __func__,
+					context->item->host.host, context->item->interface.addr, context->item->key,
+					group_num);
+
+			if (SUCCEED == agent_context_connect(context))
+				async_num++;
+		}
+
+		if (0 != contexts_num)
+			event_base_dispatch(base);
+
+		/* compact indexes of items to check again in place, contexts are processed in index order */
+		for (indexes_num = 0, j = 0; j < contexts_num; j++)
+		{
+			/* event loop exits only when all checks are completed, but be defensive */
+			if (NULL != contexts[j].event)
+				agent_context_finish(&contexts[j], TIMEOUT_ERROR, "ZBX_TCP_READ() timed out");
+
+			if (0 == contexts[j].retry)
+				continue;
+
+			for (k = 0; k < contexts[j].indexes_num; k++)
+				indexes[indexes_num++] = contexts[j].indexes[k];
+		}
+
+		max_keys = 1;
+	}
+
+	zbx_free(contexts);
+	event_base_free(base);
+#endif
+out:
+	zbx_free(indexes);
+	zbx_vector_ptr_destroy(&checks);
+#ifdef HAVE_LIBEVENT
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() async:%d", __func__, async_num);
+#else
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+#endif
 }
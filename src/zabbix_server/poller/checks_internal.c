@@ -656,6 +656,18 @@ int	get_value_internal(const DC_ITEM *item, AGENT_RESULT *result)
 				goto out;
 			}
 		}
+		else if (0 == strcmp(tmp, "sync"))
+		{
+			if (NULL == tmp1 || '\0' == *tmp1 || 0 == strcmp(tmp1, "lock"))
+				SET_DBL_RESULT(result, *(double *)DCconfig_get_stats(ZBX_CONFSTATS_SYNC_LOCK));
+			else if (0 == strcmp(tmp1, "lockmax"))
+				SET_DBL_RESULT(result, *(double *)DCconfig_get_stats(ZBX_CONFSTATS_SYNC_LOCK_MAX));
+			else
+			{
+				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+				goto out;
+			}
+		}
 		else
 		{
 			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
@@ -70,18 +70,68 @@
  * (OID, host, <v2c: community|v3: (context, security name)>)           (index, value)
  */
 
+/* index and value found by zbx_snmp_walk(), shared by walk cache, dynamic index cache and discovery */
+typedef struct
+{
+	char		*index;
+	char		*value;
+	zbx_uint32_t	refcount;
+}
+zbx_snmp_walk_value_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_walk_value_create                                       *
+ *                                                                            *
+ * Purpose: store walked index and value in one reference counted allocation  *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_snmp_walk_value_t	*zbx_snmp_walk_value_create(const char *index, const char *value)
+{
+	zbx_snmp_walk_value_t	*walk_value;
+	size_t			index_size, value_size;
+
+	index_size = strlen(index) + 1;
+	value_size = strlen(value) + 1;
+
+	walk_value = (zbx_snmp_walk_value_t *)zbx_malloc(NULL, sizeof(zbx_snmp_walk_value_t) + index_size +
+			value_size);
+	walk_value->index = (char *)(walk_value + 1);
+	walk_value->value = walk_value->index + index_size;
+	memcpy(walk_value->index, index, index_size);
+	memcpy(walk_value->value, value, value_size);
+	walk_value->refcount = 1;
+
+	return walk_value;
+}
+
+static zbx_snmp_walk_value_t	*zbx_snmp_walk_value_acquire(zbx_snmp_walk_value_t *walk_value)
+{
+	walk_value->refcount++;
+
+	return walk_value;
+}
+
+static void	zbx_snmp_walk_value_release(zbx_snmp_walk_value_t *walk_value)
+{
+	if (0 == --walk_value->refcount)
+		zbx_free(walk_value);
+}
+
 /******************************************************************************
  *                                                                            *
  * This is zbx_snmp_walk() callback function prototype.                       *
  *                                                                            *
- * Parameters: arg   - [IN] an user argument passed to zbx_snmp_walk()        *
- *                          function                                          *
- *             snmp_oid - [IN] the OID the walk function is looking for       *
- *             index    - [IN] the index of found OID                         *
- *             value    - [IN] the OID value                                  *
+ * Parameters: arg        - [IN] an user argument passed to zbx_snmp_walk()   *
+ *                               function                                     *
+ *             num        - [IN] position of the walked OID in the list       *
+ *                               passed to zbx_snmp_walk() function           *
+ *             snmp_oid   - [IN] the OID the walk function is looking for     *
+ *             walk_value - [IN] the index of found OID and its value, the    *
+ *                               callback must acquire it to keep it          *
  *                                                                            *
  ******************************************************************************/
-typedef void (zbx_snmp_walk_cb_func)(void *arg, const char *snmp_oid, const char *index, const char *value);
+typedef void (zbx_snmp_walk_cb_func)(void *arg, int num, const char *snmp_oid, zbx_snmp_walk_value_t *walk_value);
 
 typedef struct
 {
@@ -96,8 +146,9 @@ zbx_snmpidx_main_key_t;
 
 typedef struct
 {
-	char		*value;
-	char		*index;
+	const char		*value;		/* must be the first member, points to walk_value */
+	const char		*index;		/* points to walk_value */
+	zbx_snmp_walk_value_t	*walk_value;
 }
 zbx_snmpidx_mapping_t;
 
@@ -170,8 +221,7 @@ static void	__snmpidx_mapping_clean(void *data)
 {
 	zbx_snmpidx_mapping_t	*mapping = (zbx_snmpidx_mapping_t *)data;
 
-	zbx_free(mapping->value);
-	zbx_free(mapping->index);
+	zbx_snmp_walk_value_release(mapping->walk_value);
 }
 
 static char	*get_item_community_context(const DC_ITEM *item)
@@ -255,20 +305,20 @@ end:
  *                                                                            *
  * Purpose: store the index-value pair in the relevant index cache            *
  *                                                                            *
- * Parameters: item      - [IN] configuration of Zabbix item, contains        *
- *                              IP address, port, community string, context,  *
- *                              security name                                 *
- *             snmp_oid  - [IN] OID of the table which contains the indexes   *
- *             index     - [IN] index part of the index-value pair            *
- *             value     - [IN] value part of the index-value pair            *
+ * Parameters: item       - [IN] configuration of Zabbix item, contains       *
+ *                               IP address, port, community string,          *
+ *                               context, security name                       *
+ *             snmp_oid   - [IN] OID of the table which contains the indexes  *
+ *             walk_value - [IN] the index-value pair, referenced by cache    *
  *                                                                            *
  ******************************************************************************/
-static void	cache_put_snmp_index(const DC_ITEM *item, const char *snmp_oid, const char *index, const char *value)
+static void	cache_put_snmp_index(const DC_ITEM *item, const char *snmp_oid, zbx_snmp_walk_value_t *walk_value)
 {
 	zbx_snmpidx_main_key_t	*main_key, main_key_local;
 	zbx_snmpidx_mapping_t	*mapping, mapping_local;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() OID:'%s' index:'%s' value:'%s'", __func__, snmp_oid, index, value);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() OID:'%s' index:'%s' value:'%s'", __func__, snmp_oid, walk_value->index,
+			walk_value->value);
 
 	if (NULL == snmpidx.slots)
 	{
@@ -300,17 +350,20 @@ static void	cache_put_snmp_index(const DC_ITEM *item, const char *snmp_oid, cons
 		main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_insert(&snmpidx, &main_key_local, sizeof(main_key_local));
 	}
 
-	if (NULL == (mapping = (zbx_snmpidx_mapping_t *)zbx_hashset_search(main_key->mappings, &value)))
+	if (NULL == (mapping = (zbx_snmpidx_mapping_t *)zbx_hashset_search(main_key->mappings, &walk_value->value)))
 	{
-		mapping_local.value = zbx_strdup(NULL, value);
-		mapping_local.index = zbx_strdup(NULL, index);
+		mapping_local.value = walk_value->value;
+		mapping_local.index = walk_value->index;
+		mapping_local.walk_value = zbx_snmp_walk_value_acquire(walk_value);
 
 		zbx_hashset_insert(main_key->mappings, &mapping_local, sizeof(mapping_local));
 	}
-	else if (0 != strcmp(mapping->index, index))
+	else if (0 != strcmp(mapping->index, walk_value->index))
 	{
-		zbx_free(mapping->index);
-		mapping->index = zbx_strdup(NULL, index);
+		zbx_snmp_walk_value_release(mapping->walk_value);
+		mapping->value = walk_value->value;
+		mapping->index = walk_value->index;
+		mapping->walk_value = zbx_snmp_walk_value_acquire(walk_value);
 	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -981,15 +1034,393 @@ static int	zbx_oid_is_new(zbx_hashset_t *hs, size_t root_len, const oid *p_oid,
 #undef ZBX_OIDS_MAX_NUM
 }
 
+/* OID subtree walked by zbx_snmp_walk() */
+typedef struct
+{
+	char			*snmp_oid;
+	int			num;			/* position in the list of walked OIDs */
+	oid			root_oid[MAX_OID_LEN];
+	size_t			root_oid_len;
+	oid			last_oid[MAX_OID_LEN];	/* the last OID received, next request starts from it */
+	size_t			last_oid_len;
+	size_t			root_string_len;
+	size_t			root_numeric_len;
+	int			check_oid_increase;
+	zbx_hashset_t		oids_seen;
+	zbx_vector_ptr_t	values;			/* walked index and value pairs */
+	int			ret;
+	char			*error;
+	unsigned char		running;
+	unsigned char		cached;			/* values were taken from walk cache */
+}
+zbx_snmp_walk_oid_t;
+
+static zbx_snmp_walk_oid_t	*zbx_snmp_walk_oid_create(const char *snmp_oid)
+{
+	zbx_snmp_walk_oid_t	*walk_oid;
+
+	walk_oid = (zbx_snmp_walk_oid_t *)zbx_malloc(NULL, sizeof(zbx_snmp_walk_oid_t));
+	memset(walk_oid, 0, sizeof(zbx_snmp_walk_oid_t));
+
+	walk_oid->snmp_oid = zbx_strdup(NULL, snmp_oid);
+	walk_oid->root_oid_len = MAX_OID_LEN;
+	walk_oid->check_oid_increase = 1;
+	walk_oid->ret = SUCCEED;
+	walk_oid->running = 1;
+	zbx_vector_ptr_create(&walk_oid->values);
+
+	return walk_oid;
+}
+
+static void	zbx_snmp_walk_values_clear(zbx_vector_ptr_t *values)
+{
+	zbx_vector_ptr_clear_ext(values, (zbx_clean_func_t)zbx_snmp_walk_value_release);
+}
+
+static void	zbx_snmp_walk_oid_free(zbx_snmp_walk_oid_t *walk_oid)
+{
+	if (0 == walk_oid->check_oid_increase)
+		zbx_hashset_destroy(&walk_oid->oids_seen);
+
+	zbx_snmp_walk_values_clear(&walk_oid->values);
+	zbx_vector_ptr_destroy(&walk_oid->values);
+	zbx_free(walk_oid->error);
+	zbx_free(walk_oid->snmp_oid);
+	zbx_free(walk_oid);
+}
+
+static void	zbx_snmp_walk_oid_stop(zbx_snmp_walk_oid_t *walk_oid, int ret, const char *error)
+{
+	walk_oid->running = 0;
+
+	if (SUCCEED != (walk_oid->ret = ret))
+		walk_oid->error = zbx_strdup(walk_oid->error, error);
+}
+
+/*
+ * SNMP Walk Cache
+ * ===============
+ *
+ * Results of successful walks are kept by poller process for ZBX_SNMPWALK_TTL seconds and until the poller goes idle,
+ * so that discovery rules and dynamic index items of the same agent/user walking the same OID within one poll cycle
+ * share a single walk. The cache is identified in the same way as Dynamic Index Cache. Walked values are reference
+ * counted and shared with Dynamic Index Cache and discovery instead of being copied.
+ */
+
+#define ZBX_SNMPWALK_TTL	10
+
+typedef struct
+{
+	zbx_snmpidx_main_key_t	main_key;	/* must be the first member, mappings are not used */
+	int			lastwalk;
+	zbx_vector_ptr_t	values;		/* walked values, see zbx_snmp_walk_value_t */
+}
+zbx_snmpwalk_t;
+
+static zbx_hashset_t	snmpwalks;		/* Walk Cache */
+
+static void	__snmpwalk_clean(void *data)
+{
+	zbx_snmpwalk_t	*walk = (zbx_snmpwalk_t *)data;
+
+	zbx_free(walk->main_key.addr);
+	zbx_free(walk->main_key.oid);
+	zbx_free(walk->main_key.community_context);
+	zbx_free(walk->main_key.security_name);
+	zbx_snmp_walk_values_clear(&walk->values);
+	zbx_vector_ptr_destroy(&walk->values);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: cache_get_snmp_walk                                              *
+ *                                                                            *
+ * Purpose: pass values of recently walked OID to the walk callback function  *
+ *                                                                            *
+ * Parameters: item         - [IN] configuration of Zabbix item               *
+ *             walk_oid     - [IN] the OID to walk                            *
+ *             walk_cb_func - [IN] callback function to process the values    *
+ *             walk_cb_arg  - [IN] argument to pass to the callback function  *
+ *                                                                            *
+ * Return value: SUCCEED - the values were found in walk cache                *
+ *               FAIL    - the OID must be walked                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	cache_get_snmp_walk(const DC_ITEM *item, const zbx_snmp_walk_oid_t *walk_oid,
+		zbx_snmp_walk_cb_func walk_cb_func, void *walk_cb_arg)
+{
+	zbx_snmpidx_main_key_t	main_key_local;
+	zbx_snmpwalk_t		*walk;
+	int			i;
+
+	if (NULL == snmpwalks.slots)
+		return FAIL;
+
+	main_key_local.addr = item->interface.addr;
+	main_key_local.port = item->interface.port;
+	main_key_local.oid = walk_oid->snmp_oid;
+
+	main_key_local.community_context = get_item_community_context(item);
+	main_key_local.security_name = get_item_security_name(item);
+
+	if (NULL == (walk = (zbx_snmpwalk_t *)zbx_hashset_search(&snmpwalks, &main_key_local)))
+		return FAIL;
+
+	if (walk->lastwalk + ZBX_SNMPWALK_TTL <= (int)time(NULL))
+		return FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() OID:'%s' values:%d", __func__, walk_oid->snmp_oid, walk->values.values_num);
+
+	for (i = 0; i < walk->values.values_num; i++)
+	{
+		walk_cb_func(walk_cb_arg, walk_oid->num, walk_oid->snmp_oid,
+				(zbx_snmp_walk_value_t *)walk->values.values[i]);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: cache_put_snmp_walk                                              *
+ *                                                                            *
+ * Purpose: move values of walked OID to walk cache                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	cache_put_snmp_walk(const DC_ITEM *item, zbx_snmp_walk_oid_t *walk_oid)
+{
+	zbx_snmpidx_main_key_t	main_key_local;
+	zbx_snmpwalk_t		*walk, walk_local;
+
+	if (NULL == snmpwalks.slots)
+	{
+		zbx_hashset_create_ext(&snmpwalks, 100,
+				__snmpidx_main_key_hash, __snmpidx_main_key_compare, __snmpwalk_clean,
+				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+	}
+
+	main_key_local.addr = item->interface.addr;
+	main_key_local.port = item->interface.port;
+	main_key_local.oid = walk_oid->snmp_oid;
+
+	main_key_local.community_context = get_item_community_context(item);
+	main_key_local.security_name = get_item_security_name(item);
+
+	if (NULL == (walk = (zbx_snmpwalk_t *)zbx_hashset_search(&snmpwalks, &main_key_local)))
+	{
+		walk_local.main_key.addr = zbx_strdup(NULL, item->interface.addr);
+		walk_local.main_key.port = item->interface.port;
+		walk_local.main_key.oid = zbx_strdup(NULL, walk_oid->snmp_oid);
+		walk_local.main_key.community_context = zbx_strdup(NULL, get_item_community_context(item));
+		walk_local.main_key.security_name = zbx_strdup(NULL, get_item_security_name(item));
+		walk_local.main_key.mappings = NULL;
+		zbx_vector_ptr_create(&walk_local.values);
+
+		walk = (zbx_snmpwalk_t *)zbx_hashset_insert(&snmpwalks, &walk_local, sizeof(walk_local));
+	}
+	else
+		zbx_snmp_walk_values_clear(&walk->values);
+
+	walk->lastwalk = (int)time(NULL);
+	zbx_vector_ptr_append_array(&walk->values, walk_oid->values.values, walk_oid->values.values_num);
+	zbx_vector_ptr_clear(&walk_oid->values);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_clear_walk_cache_snmp                                        *
+ *                                                                            *
+ * Purpose: discard walk results at the end of poll cycle                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_clear_walk_cache_snmp(void)
+{
+	if (NULL != snmpwalks.slots && 0 != snmpwalks.num_data)
+		zbx_hashset_clear(&snmpwalks);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_walk_oid_prepare                                        *
+ *                                                                            *
+ * Purpose: parse root OID of the walk                                        *
+ *                                                                            *
+ * Return value: SUCCEED - the OID is ready to be walked                      *
+ *               FAIL    - the OID is invalid, walk is stopped with error     *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_snmp_walk_oid_prepare(zbx_snmp_walk_oid_t *walk_oid)
+{
+	char	oid_index[MAX_STRING_LEN], error[MAX_STRING_LEN];
+
+	/* create OID from string */
+	if (NULL == snmp_parse_oid(walk_oid->snmp_oid, walk_oid->root_oid, &walk_oid->root_oid_len))
+	{
+		zbx_snprintf(error, sizeof(error), "snmp_parse_oid(): cannot parse OID \"%s\".", walk_oid->snmp_oid);
+		goto fail;
+	}
+
+	if (-1 == zbx_snmp_print_oid(oid_index, sizeof(oid_index), walk_oid->root_oid, walk_oid->root_oid_len,
+			ZBX_OID_INDEX_STRING))
+	{
+		zbx_snprintf(error, sizeof(error), "zbx_snmp_print_oid(): cannot print OID \"%s\" with string indices.",
+				walk_oid->snmp_oid);
+		goto fail;
+	}
+
+	walk_oid->root_string_len = strlen(oid_index);
+
+	if (-1 == zbx_snmp_print_oid(oid_index, sizeof(oid_index), walk_oid->root_oid, walk_oid->root_oid_len,
+			ZBX_OID_INDEX_NUMERIC))
+	{
+		zbx_snprintf(error, sizeof(error), "zbx_snmp_print_oid(): cannot print OID \"%s\""
+				" with numeric indices.", walk_oid->snmp_oid);
+		goto fail;
+	}
+
+	walk_oid->root_numeric_len = strlen(oid_index);
+
+	memcpy(walk_oid->last_oid, walk_oid->root_oid, walk_oid->root_oid_len * sizeof(oid));
+	walk_oid->last_oid_len = walk_oid->root_oid_len;
+
+	return SUCCEED;
+fail:
+	zbx_snmp_walk_oid_stop(walk_oid, CONFIG_ERROR, error);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_walk_oid_process                                        *
+ *                                                                            *
+ * Purpose: process variable binding received while walking an OID tree      *
+ *                                                                            *
+ * Parameters: walk_oid     - [IN] the walked OID                             *
+ *             var          - [IN] the variable binding                       *
+ *             walk_cb_func - [IN] callback function to process the value     *
+ *             walk_cb_arg  - [IN] argument to pass to the callback function  *
+ *                                                                            *
+ * Comments: the walk is stopped when the end of subtree is reached or on     *
+ *           error                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_walk_oid_process(zbx_snmp_walk_oid_t *walk_oid, const struct variable_list *var,
+		zbx_snmp_walk_cb_func walk_cb_func, void *walk_cb_arg)
+{
+	char		oid_index[MAX_STRING_LEN], **str_res;
+	unsigned char	val_type;
+	AGENT_RESULT	snmp_result;
+
+	/* verify if we are in the same subtree */
+	if (SNMP_ENDOFMIBVIEW == var->type || var->name_length < walk_oid->root_oid_len ||
+			0 != memcmp(walk_oid->root_oid, var->name, walk_oid->root_oid_len * sizeof(oid)))
+	{
+		/* reached the end or past this subtree */
+		zbx_snmp_walk_oid_stop(walk_oid, SUCCEED, NULL);
+		return;
+	}
+
+	if (SNMP_NOSUCHOBJECT == var->type || SNMP_NOSUCHINSTANCE == var->type)
+	{
+		/* an exception value, so stop */
+		char	*errmsg;
+
+		errmsg = zbx_get_snmp_type_error(var->type);
+		zbx_snmp_walk_oid_stop(walk_oid, NOTSUPPORTED, errmsg);
+		zbx_free(errmsg);
+		return;
+	}
+
+	if (1 == walk_oid->check_oid_increase)	/* typical case */
+	{
+		int	res;
+
+		/* normally devices return OIDs in increasing order, */
+		/* snmp_oid_compare() will return -1 in this case */
+
+		if (-1 != (res = snmp_oid_compare(walk_oid->last_oid, walk_oid->last_oid_len, var->name,
+				var->name_length)))
+		{
+			if (0 == res)	/* got the same OID */
+			{
+				zbx_snmp_walk_oid_stop(walk_oid, NOTSUPPORTED, "OID not changing.");
+				return;
+			}
+
+			/* OID decreased. Disable further checks of increasing */
+			/* and set up a protection against endless looping. */
+
+			walk_oid->check_oid_increase = 0;
+			zbx_detect_loop_init(&walk_oid->oids_seen);
+		}
+	}
+
+	if (0 == walk_oid->check_oid_increase && FAIL == zbx_oid_is_new(&walk_oid->oids_seen, walk_oid->root_oid_len,
+			var->name, var->name_length))
+	{
+		zbx_snmp_walk_oid_stop(walk_oid, NOTSUPPORTED, "OID loop detected or too many OIDs.");
+		return;
+	}
+
+	if (SUCCEED != zbx_snmp_choose_index(oid_index, sizeof(oid_index), var->name, var->name_length,
+			walk_oid->root_string_len, walk_oid->root_numeric_len))
+	{
+		char	error[MAX_STRING_LEN];
+
+		zbx_snprintf(error, sizeof(error), "zbx_snmp_choose_index(): cannot choose appropriate index while"
+				" walking for OID \"%s\".", walk_oid->snmp_oid);
+		zbx_snmp_walk_oid_stop(walk_oid, NOTSUPPORTED, error);
+		return;
+	}
+
+	str_res = NULL;
+	init_result(&snmp_result);
+
+	if (SUCCEED == zbx_snmp_set_result(var, &snmp_result, &val_type))
+	{
+		if (ISSET_TEXT(&snmp_result) && ZBX_SNMP_STR_HEX == val_type)
+			zbx_remove_chars(snmp_result.text, "\r\n");
+
+		str_res = GET_STR_RESULT(&snmp_result);
+	}
+
+	if (NULL == str_res)
+	{
+		char	**msg;
+
+		msg = GET_MSG_RESULT(&snmp_result);
+
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot get index '%s' string value: %s",
+				oid_index, NULL != msg && NULL != *msg ? *msg : "(null)");
+	}
+	else
+	{
+		zbx_snmp_walk_value_t	*walk_value;
+
+		walk_value = zbx_snmp_walk_value_create(oid_index, snmp_result.str);
+		walk_cb_func(walk_cb_arg, walk_oid->num, walk_oid->snmp_oid, walk_value);
+		zbx_vector_ptr_append(&walk_oid->values, walk_value);
+	}
+
+	free_result(&snmp_result);
+
+	/* go to next variable */
+	memcpy(walk_oid->last_oid, var->name, var->name_length * sizeof(oid));
+	walk_oid->last_oid_len = var->name_length;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_snmp_walk                                                    *
  *                                                                            *
- * Purpose: retrieve information by walking an OID tree                       *
+ * Purpose: retrieve information by walking OID trees                         *
  *                                                                            *
  * Parameters: ss            - [IN] SNMP session handle                       *
  *             item          - [IN] configuration of Zabbix item              *
- *             OID           - [IN] OID of table with values of interest      *
+ *             walk_oids     - [IN/OUT] OIDs of tables with values of         *
+ *                                      interest (zbx_snmp_walk_oid_t), the   *
+ *                                      result of each walk is stored in it   *
  *             error         - [OUT] a buffer to store error message          *
  *             max_error_len - [IN] maximum error message length              *
  *             max_succeed   - [OUT] value of "max_repetitions" that succeeded*
@@ -1000,70 +1431,75 @@ static int	zbx_oid_is_new(zbx_hashset_t *hs, size_t root_len, const oid *p_oid,
  *                                  OIDs and their values                     *
  *             walk_cb_arg   - [IN] argument to pass to the callback function *
  *                                                                            *
- * Return value: NOTSUPPORTED - OID does not exist, any other critical error  *
+ * Return value: NOTSUPPORTED - SNMP error response                           *
  *               NETWORK_ERROR - recoverable network error                    *
- *               CONFIG_ERROR - item configuration error                      *
- *               SUCCEED - if function successfully completed                 *
+ *               CONFIG_ERROR - cannot create request                         *
+ *               SUCCEED - if function successfully completed, errors of      *
+ *                         particular OIDs are stored in walk_oids            *
+ *                                                                            *
+ * Comments: With GetBulkRequest-PDU all OIDs are walked at once, each        *
+ *           request asks for the next rows of every unfinished OID and       *
+ *           "max_repetitions" is shared between them. OIDs walked within the *
+ *           current poll cycle are taken from walk cache.                    *
  *                                                                            *
  * Author: Alexander Vladishev, Aleksandrs Saveljevs                          *
  *                                                                            *
  ******************************************************************************/
-static int	zbx_snmp_walk(struct snmp_session *ss, const DC_ITEM *item, const char *snmp_oid, char *error,
+static int	zbx_snmp_walk(struct snmp_session *ss, const DC_ITEM *item, zbx_vector_ptr_t *walk_oids, char *error,
 		size_t max_error_len, int *max_succeed, int *min_fail, int max_vars, int bulk,
 		zbx_snmp_walk_cb_func walk_cb_func, void *walk_cb_arg)
 {
 	struct snmp_pdu		*pdu, *response;
-	oid			anOID[MAX_OID_LEN], rootOID[MAX_OID_LEN];
-	size_t			anOID_len = MAX_OID_LEN, rootOID_len = MAX_OID_LEN, root_string_len, root_numeric_len;
-	char			oid_index[MAX_STRING_LEN];
 	struct variable_list	*var;
-	int			status, level, running, num_vars, check_oid_increase = 1, ret = SUCCEED;
-	AGENT_RESULT		snmp_result;
-	zbx_hashset_t		oids_seen;
+	zbx_snmp_walk_oid_t	*walk_oid;
+	zbx_vector_ptr_t	requested;
+	int			i, status, level = 0, num_vars, ret = SUCCEED;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() type:%d OID:'%s' bulk:%d", __func__, (int)item->type, snmp_oid, bulk);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() type:%d OIDs:%d bulk:%d", __func__, (int)item->type,
+			walk_oids->values_num, bulk);
 
 	if (ZBX_IF_SNMP_VERSION_1 == item->snmp_version)	/* GetBulkRequest-PDU available since SNMPv2 */
 		bulk = SNMP_BULK_DISABLED;
 
-	/* create OID from string */
-	if (NULL == snmp_parse_oid(snmp_oid, rootOID, &rootOID_len))
+	zbx_vector_ptr_create(&requested);
+
+	for (i = 0; i < walk_oids->values_num; i++)
 	{
-		zbx_snprintf(error, max_error_len, "snmp_parse_oid(): cannot parse OID \"%s\".", snmp_oid);
-		ret = CONFIG_ERROR;
-		goto out;
+		walk_oid = (zbx_snmp_walk_oid_t *)walk_oids->values[i];
+		walk_oid->num = i;
+
+		if (SUCCEED != zbx_snmp_walk_oid_prepare(walk_oid))
+			continue;
+
+		if (SUCCEED == cache_get_snmp_walk(item, walk_oid, walk_cb_func, walk_cb_arg))
+		{
+			walk_oid->cached = 1;
+			zbx_snmp_walk_oid_stop(walk_oid, SUCCEED, NULL);
+		}
 	}
 
-	if (-1 == zbx_snmp_print_oid(oid_index, sizeof(oid_index), rootOID, rootOID_len, ZBX_OID_INDEX_STRING))
+	while (1)
 	{
-		zbx_snprintf(error, max_error_len, "zbx_snmp_print_oid(): cannot print OID \"%s\" with string indices.",
-				snmp_oid);
-		ret = CONFIG_ERROR;
-		goto out;
-	}
+		zbx_vector_ptr_clear(&requested);
 
-	root_string_len = strlen(oid_index);
+		for (i = 0; i < walk_oids->values_num; i++)
+		{
+			walk_oid = (zbx_snmp_walk_oid_t *)walk_oids->values[i];
 
-	if (-1 == zbx_snmp_print_oid(oid_index, sizeof(oid_index), rootOID, rootOID_len, ZBX_OID_INDEX_NUMERIC))
-	{
-		zbx_snprintf(error, max_error_len, "zbx_snmp_print_oid(): cannot print OID \"%s\""
-				" with numeric indices.", snmp_oid);
-		ret = CONFIG_ERROR;
-		goto out;
-	}
+			if (0 == walk_oid->running)
+				continue;
 
-	root_numeric_len = strlen(oid_index);
+			zbx_vector_ptr_append(&requested, walk_oid);
 
-	/* copy rootOID to anOID */
-	memcpy(anOID, rootOID, rootOID_len * sizeof(oid));
-	anOID_len = rootOID_len;
+			/* with GetNextRequest-PDU OIDs are walked one by one as SNMPv1 rejects */
+			/* the whole request when one of the walks reaches the end of MIB view */
+			if (SNMP_BULK_ENABLED != bulk)
+				break;
+		}
 
-	/* initialize variables */
-	level = 0;
-	running = 1;
+		if (0 == requested.values_num)
+			break;
 
-	while (1 == running)
-	{
 		/* create PDU */
 		if (NULL == (pdu = snmp_pdu_create(SNMP_BULK_ENABLED == bulk ? SNMP_MSG_GETBULK : SNMP_MSG_GETNEXT)))
 		{
@@ -1072,10 +1508,21 @@ static int	zbx_snmp_walk(struct snmp_session *ss, const DC_ITEM *item, const cha
 			break;
 		}
 
-		if (NULL == snmp_add_null_var(pdu, anOID, anOID_len))	/* add OID as variable to PDU */
+		for (i = 0; i < requested.values_num; i++)
+		{
+			walk_oid = (zbx_snmp_walk_oid_t *)requested.values[i];
+
+			/* add OID as variable to PDU */
+			if (NULL == snmp_add_null_var(pdu, walk_oid->last_oid, walk_oid->last_oid_len))
+			{
+				zbx_strlcpy(error, "snmp_add_null_var(): cannot add null variable.", max_error_len);
+				ret = CONFIG_ERROR;
+				break;
+			}
+		}
+
+		if (SUCCEED != ret)
 		{
-			zbx_strlcpy(error, "snmp_add_null_var(): cannot add null variable.", max_error_len);
-			ret = CONFIG_ERROR;
 			snmp_free_pdu(pdu);
 			break;
 		}
@@ -1083,7 +1530,7 @@ static int	zbx_snmp_walk(struct snmp_session *ss, const DC_ITEM *item, const cha
 		if (SNMP_BULK_ENABLED == bulk)
 		{
 			pdu->non_repeaters = 0;
-			pdu->max_repetitions = max_vars;
+			pdu->max_repetitions = MAX(1, max_vars / requested.values_num);
 		}
 
 		ss->retries = (0 == bulk || (1 == max_vars && 0 == level) ? 1 : 0);
@@ -1092,8 +1539,8 @@ static int	zbx_snmp_walk(struct snmp_session *ss, const DC_ITEM *item, const cha
 		status = snmp_synch_response(ss, pdu, &response);
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() snmp_synch_response() status:%d s_snmp_errno:%d errstat:%ld"
-				" max_vars:%d", __func__, status, ss->s_snmp_errno,
-				NULL == response ? (long)-1 : response->errstat, max_vars);
+				" max_vars:%d OIDs:%d", __func__, status, ss->s_snmp_errno,
+				NULL == response ? (long)-1 : response->errstat, max_vars, requested.values_num);
 
 		if (1 < max_vars &&
 			((STAT_SUCCESS == status && SNMP_ERR_TOOBIG == response->errstat) || STAT_TIMEOUT == status))
@@ -1120,129 +1567,46 @@ static int	zbx_snmp_walk(struct snmp_session *ss, const DC_ITEM *item, const cha
 		else if (STAT_SUCCESS != status || SNMP_ERR_NOERROR != response->errstat)
 		{
 			ret = zbx_get_snmp_response_error(ss, &item->interface, status, response, error, max_error_len);
-			running = 0;
 			goto next;
 		}
 
-		/* process response */
+		/* process response, variable bindings of requested OIDs are repeated in the same order */
 		for (num_vars = 0, var = response->variables; NULL != var; num_vars++, var = var->next_variable)
 		{
-			char		**str_res;
-			unsigned char	val_type;
+			walk_oid = (zbx_snmp_walk_oid_t *)requested.values[num_vars % requested.values_num];
 
-			/* verify if we are in the same subtree */
-			if (SNMP_ENDOFMIBVIEW == var->type || var->name_length < rootOID_len ||
-					0 != memcmp(rootOID, var->name, rootOID_len * sizeof(oid)))
-			{
-				/* reached the end or past this subtree */
-				running = 0;
-				break;
-			}
-			else if (SNMP_NOSUCHOBJECT != var->type && SNMP_NOSUCHINSTANCE != var->type)
-			{
-				/* not an exception value */
+			if (0 != walk_oid->running)
+				zbx_snmp_walk_oid_process(walk_oid, var, walk_cb_func, walk_cb_arg);
+		}
 
-				if (1 == check_oid_increase)	/* typical case */
-				{
-					int	res;
-
-					/* normally devices return OIDs in increasing order, */
-					/* snmp_oid_compare() will return -1 in this case */
-
-					if (-1 != (res = snmp_oid_compare(anOID, anOID_len, var->name,
-							var->name_length)))
-					{
-						if (0 == res)	/* got the same OID */
-						{
-							zbx_strlcpy(error, "OID not changing.", max_error_len);
-							ret = NOTSUPPORTED;
-							running = 0;
-							break;
-						}
-						else	/* 1 == res */
-						{
-							/* OID decreased. Disable further checks of increasing */
-							/* and set up a protection against endless looping. */
-
-							check_oid_increase = 0;
-							zbx_detect_loop_init(&oids_seen);
-						}
-					}
-				}
+		if (0 == num_vars)
+		{
+			zbx_strlcpy(error, "Invalid SNMP response: too few variable bindings.", max_error_len);
+			ret = NOTSUPPORTED;
+		}
 
-				if (0 == check_oid_increase && FAIL == zbx_oid_is_new(&oids_seen, rootOID_len,
-						var->name, var->name_length))
-				{
-					zbx_strlcpy(error, "OID loop detected or too many OIDs.", max_error_len);
-					ret = NOTSUPPORTED;
-					running = 0;
-					break;
-				}
+		if (*max_succeed < num_vars)
+			*max_succeed = num_vars;
+next:
+		if (NULL != response)
+			snmp_free_pdu(response);
 
-				if (SUCCEED != zbx_snmp_choose_index(oid_index, sizeof(oid_index), var->name,
-						var->name_length, root_string_len, root_numeric_len))
-				{
-					zbx_snprintf(error, max_error_len, "zbx_snmp_choose_index():"
-							" cannot choose appropriate index while walking for"
-							" OID \"%s\".", snmp_oid);
-					ret = NOTSUPPORTED;
-					running = 0;
-					break;
-				}
-
-				str_res = NULL;
-				init_result(&snmp_result);
-
-				if (SUCCEED == zbx_snmp_set_result(var, &snmp_result, &val_type))
-				{
-					if (ISSET_TEXT(&snmp_result) && ZBX_SNMP_STR_HEX == val_type)
-						zbx_remove_chars(snmp_result.text, "\r\n");
-
-					str_res = GET_STR_RESULT(&snmp_result);
-				}
-
-				if (NULL == str_res)
-				{
-					char	**msg;
-
-					msg = GET_MSG_RESULT(&snmp_result);
-
-					zabbix_log(LOG_LEVEL_DEBUG, "cannot get index '%s' string value: %s",
-							oid_index, NULL != msg && NULL != *msg ? *msg : "(null)");
-				}
-				else
-					walk_cb_func(walk_cb_arg, snmp_oid, oid_index, snmp_result.str);
-
-				free_result(&snmp_result);
-
-				/* go to next variable */
-				memcpy((char *)anOID, (char *)var->name, var->name_length * sizeof(oid));
-				anOID_len = var->name_length;
-			}
-			else
-			{
-				/* an exception value, so stop */
-				char	*errmsg;
+		if (SUCCEED != ret)
+			break;
+	}
 
-				errmsg = zbx_get_snmp_type_error(var->type);
-				zbx_strlcpy(error, errmsg, max_error_len);
-				zbx_free(errmsg);
-				ret = NOTSUPPORTED;
-				running = 0;
-				break;
-			}
-		}
+	for (i = 0; i < walk_oids->values_num; i++)
+	{
+		walk_oid = (zbx_snmp_walk_oid_t *)walk_oids->values[i];
 
-		if (*max_succeed < num_vars)
-			*max_succeed = num_vars;
-next:
-		if (NULL != response)
-			snmp_free_pdu(response);
+		if (0 != walk_oid->running)
+			zbx_snmp_walk_oid_stop(walk_oid, ret, error);
+		else if (SUCCEED == walk_oid->ret && 0 == walk_oid->cached)
+			cache_put_snmp_walk(item, walk_oid);
 	}
 
-	if (0 == check_oid_increase)
-		zbx_hashset_destroy(&oids_seen);
-out:
+	zbx_vector_ptr_destroy(&requested);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1587,20 +1951,17 @@ static void	zbx_snmp_translate(char *oid_translated, const char *snmp_oid, size_
 /* discovered SNMP object, identified by its index */
 typedef struct
 {
-	/* object index returned by zbx_snmp_walk */
-	char	*index;
+	/* object index returned by zbx_snmp_walk, points to one of walked values */
+	const char		*index;
 
-	/* an array of OID values stored in the same order as defined in OID key */
-	char	**values;
+	/* an array of walked values stored in the same order as defined in OID key */
+	zbx_snmp_walk_value_t	**values;
 }
 zbx_snmp_dobject_t;
 
 /* helper data structure used by snmp discovery */
 typedef struct
 {
-	/* the index of OID being currently processed (walked) */
-	int			num;
-
 	/* the discovered SNMP objects */
 	zbx_hashset_t		objects;
 
@@ -1721,9 +2082,11 @@ static void	zbx_snmp_ddata_clean(zbx_snmp_ddata_t *data)
 	while (NULL != (obj = (zbx_snmp_dobject_t *)zbx_hashset_iter_next(&iter)))
 	{
 		for (i = 0; i < data->request.nparam / 2; i++)
-			zbx_free(obj->values[i]);
+		{
+			if (NULL != obj->values[i])
+				zbx_snmp_walk_value_release(obj->values[i]);
+		}
 
-		zbx_free(obj->index);
 		zbx_free(obj->values);
 	}
 
@@ -1732,26 +2095,29 @@ static void	zbx_snmp_ddata_clean(zbx_snmp_ddata_t *data)
 	free_request(&data->request);
 }
 
-static void	zbx_snmp_walk_discovery_cb(void *arg, const char *snmp_oid, const char *index, const char *value)
+static void	zbx_snmp_walk_discovery_cb(void *arg, int num, const char *snmp_oid, zbx_snmp_walk_value_t *walk_value)
 {
 	zbx_snmp_ddata_t	*data = (zbx_snmp_ddata_t *)arg;
 	zbx_snmp_dobject_t	*obj;
 
 	ZBX_UNUSED(snmp_oid);
 
-	if (NULL == (obj = (zbx_snmp_dobject_t *)zbx_hashset_search(&data->objects, &index)))
+	if (NULL == (obj = (zbx_snmp_dobject_t *)zbx_hashset_search(&data->objects, &walk_value->index)))
 	{
 		zbx_snmp_dobject_t	new_obj;
 
-		new_obj.index = zbx_strdup(NULL, index);
-		new_obj.values = (char **)zbx_malloc(NULL, sizeof(char *) * data->request.nparam / 2);
-		memset(new_obj.values, 0, sizeof(char *) * data->request.nparam / 2);
+		new_obj.index = walk_value->index;
+		new_obj.values = (zbx_snmp_walk_value_t **)zbx_malloc(NULL,
+				sizeof(zbx_snmp_walk_value_t *) * data->request.nparam / 2);
+		memset(new_obj.values, 0, sizeof(zbx_snmp_walk_value_t *) * data->request.nparam / 2);
 
 		obj = (zbx_snmp_dobject_t *)zbx_hashset_insert(&data->objects, &new_obj, sizeof(new_obj));
 		zbx_vector_ptr_append(&data->index, obj);
 	}
 
-	obj->values[data->num] = zbx_strdup(NULL, value);
+	/* the object index must stay valid, so value of the same OID is not replaced */
+	if (NULL == obj->values[num])
+		obj->values[num] = zbx_snmp_walk_value_acquire(walk_value);
 }
 
 static int	zbx_snmp_process_discovery(struct snmp_session *ss, const DC_ITEM *item, AGENT_RESULT *result,
@@ -1763,19 +2129,35 @@ static int	zbx_snmp_process_discovery(struct snmp_session *ss, const DC_ITEM *it
 	struct zbx_json		js;
 	zbx_snmp_ddata_t	data;
 	zbx_snmp_dobject_t	*obj;
+	zbx_snmp_walk_oid_t	*walk_oid;
+	zbx_vector_ptr_t	walk_oids;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	if (SUCCEED != (ret = zbx_snmp_ddata_init(&data, item->snmp_oid, error, max_error_len)))
 		goto out;
 
-	for (data.num = 0; data.num < data.request.nparam / 2; data.num++)
+	zbx_vector_ptr_create(&walk_oids);
+
+	for (i = 0; i < data.request.nparam / 2; i++)
 	{
-		zbx_snmp_translate(oid_translated, data.request.params[data.num * 2 + 1], sizeof(oid_translated));
+		zbx_snmp_translate(oid_translated, data.request.params[i * 2 + 1], sizeof(oid_translated));
+		zbx_vector_ptr_append(&walk_oids, zbx_snmp_walk_oid_create(oid_translated));
+	}
 
-		if (SUCCEED != (ret = zbx_snmp_walk(ss, item, oid_translated, error, max_error_len,
-				max_succeed, min_fail, max_vars, bulk, zbx_snmp_walk_discovery_cb, (void *)&data)))
+	if (SUCCEED != (ret = zbx_snmp_walk(ss, item, &walk_oids, error, max_error_len, max_succeed, min_fail,
+			max_vars, bulk, zbx_snmp_walk_discovery_cb, (void *)&data)))
+	{
+		goto clean;
+	}
+
+	for (i = 0; i < walk_oids.values_num; i++)
+	{
+		walk_oid = (zbx_snmp_walk_oid_t *)walk_oids.values[i];
+
+		if (SUCCEED != (ret = walk_oid->ret))
 		{
+			zbx_strlcpy(error, walk_oid->error, max_error_len);
 			goto clean;
 		}
 	}
@@ -1794,7 +2176,7 @@ static int	zbx_snmp_process_discovery(struct snmp_session *ss, const DC_ITEM *it
 			if (NULL == obj->values[j])
 				continue;
 
-			zbx_json_addstring(&js, data.request.params[j * 2], obj->values[j], ZBX_JSON_TYPE_STRING);
+			zbx_json_addstring(&js, data.request.params[j * 2], obj->values[j]->value, ZBX_JSON_TYPE_STRING);
 		}
 		zbx_json_close(&js);
 	}
@@ -1805,6 +2187,8 @@ static int	zbx_snmp_process_discovery(struct snmp_session *ss, const DC_ITEM *it
 
 	zbx_json_free(&js);
 clean:
+	zbx_vector_ptr_clear_ext(&walk_oids, (zbx_clean_func_t)zbx_snmp_walk_oid_free);
+	zbx_vector_ptr_destroy(&walk_oids);
 	zbx_snmp_ddata_clean(&data);
 out:
 	if (SUCCEED != (*errcode = ret))
@@ -1815,9 +2199,11 @@ out:
 	return ret;
 }
 
-static void	zbx_snmp_walk_cache_cb(void *arg, const char *snmp_oid, const char *index, const char *value)
+static void	zbx_snmp_walk_cache_cb(void *arg, int num, const char *snmp_oid, zbx_snmp_walk_value_t *walk_value)
 {
-	cache_put_snmp_index((const DC_ITEM *)arg, snmp_oid, index, value);
+	ZBX_UNUSED(num);
+
+	cache_put_snmp_index((const DC_ITEM *)arg, snmp_oid, walk_value);
 }
 
 static int	zbx_snmp_process_dynamic(struct snmp_session *ss, const DC_ITEM *items, AGENT_RESULT *results,
@@ -1930,13 +2316,15 @@ static int	zbx_snmp_process_dynamic(struct snmp_session *ss, const DC_ITEM *item
 
 	if (0 != to_walk_num)
 	{
+		zbx_vector_ptr_t	walk_oids;
+
+		zbx_vector_ptr_create(&walk_oids);
+
 		for (i = 0; i < to_walk_num; i++)
 		{
-			int	errcode;
-
 			j = to_walk[i];
 
-			/* see whether this OID tree was already walked for another item */
+			/* see whether this OID tree is already walked for another item */
 
 			for (k = 0; k < i; k++)
 			{
@@ -1947,38 +2335,46 @@ static int	zbx_snmp_process_dynamic(struct snmp_session *ss, const DC_ITEM *item
 			if (k != i)
 				continue;
 
-			/* walk */
-
 			cache_del_snmp_index_subtree(&items[j], oids_translated[j]);
+			zbx_vector_ptr_append(&walk_oids, zbx_snmp_walk_oid_create(oids_translated[j]));
+		}
 
-			errcode = zbx_snmp_walk(ss, &items[j], oids_translated[j], error, max_error_len, max_succeed,
-					min_fail, num, bulk, zbx_snmp_walk_cache_cb, (void *)&items[j]);
+		/* walk all OID trees at once */
 
-			if (NETWORK_ERROR == errcode)
-			{
-				/* consider a network error as relating to all items passed to */
-				/* this function, including those we did not just try to walk for */
+		if (NETWORK_ERROR == (ret = zbx_snmp_walk(ss, &items[to_walk[0]], &walk_oids, error, max_error_len,
+				max_succeed, min_fail, num, bulk, zbx_snmp_walk_cache_cb, (void *)&items[to_walk[0]])))
+		{
+			/* consider a network error as relating to all items passed to */
+			/* this function, including those we did not just try to walk for */
 
-				ret = NETWORK_ERROR;
-				goto exit;
-			}
+			zbx_vector_ptr_clear_ext(&walk_oids, (zbx_clean_func_t)zbx_snmp_walk_oid_free);
+			zbx_vector_ptr_destroy(&walk_oids);
+			goto exit;
+		}
 
-			if (CONFIG_ERROR == errcode || NOTSUPPORTED == errcode)
-			{
-				/* consider a configuration or "not supported" error as */
-				/* relating only to the items we have just tried to walk for */
+		for (i = 0; i < walk_oids.values_num; i++)
+		{
+			zbx_snmp_walk_oid_t	*walk_oid = (zbx_snmp_walk_oid_t *)walk_oids.values[i];
+
+			if (CONFIG_ERROR != walk_oid->ret && NOTSUPPORTED != walk_oid->ret)
+				continue;
 
-				for (k = i; k < to_walk_num; k++)
+			/* consider a configuration or "not supported" error as */
+			/* relating only to the items we have just tried to walk for */
+
+			for (k = 0; k < to_walk_num; k++)
+			{
+				if (0 == strcmp(oids_translated[to_walk[k]], walk_oid->snmp_oid))
 				{
-					if (0 == strcmp(oids_translated[to_walk[k]], oids_translated[j]))
-					{
-						SET_MSG_RESULT(&results[to_walk[k]], zbx_strdup(NULL, error));
-						errcodes[to_walk[k]] = errcode;
-					}
+					SET_MSG_RESULT(&results[to_walk[k]], zbx_strdup(NULL, walk_oid->error));
+					errcodes[to_walk[k]] = walk_oid->ret;
 				}
 			}
 		}
 
+		zbx_vector_ptr_clear_ext(&walk_oids, (zbx_clean_func_t)zbx_snmp_walk_oid_free);
+		zbx_vector_ptr_destroy(&walk_oids);
+
 		for (i = 0; i < to_walk_num; i++)
 		{
 			j = to_walk[i];
@@ -2055,6 +2451,635 @@ static int	zbx_snmp_process_standard(struct snmp_session *ss, const DC_ITEM *ite
 	return ret;
 }
 
+#define ZBX_SNMP_ASYNC_MAX_SESSIONS	256	/* interfaces polled concurrently, each session holds a socket */
+
+/* requests in flight per interface, SNMP agents usually process requests one by one and drop them when overloaded */
+extern int	CONFIG_SNMPPOLLER_HOST_REQUESTS;
+
+/* items of one interface checked by asynchronous SNMP poller */
+typedef struct
+{
+	AGENT_RESULT		*results;
+	int			*errcodes;
+	oid			(*oids)[MAX_OID_LEN];
+	size_t			*oid_lens;
+	const DC_ITEM		*item;		/* the first item, its interface is shared by others */
+	struct snmp_session	*ss;
+	zbx_vector_ptr_t	requests;	/* requests waiting to be sent */
+	zbx_vector_ptr_t	sent;		/* requests in flight */
+	int			*requests_total;	/* requests in flight on all interfaces */
+	int			max_succeed;
+	int			min_fail;
+	int			bulk;
+	int			max_vars;
+	int			err;		/* error code of failed interface */
+	unsigned char		closing;
+}
+zbx_snmp_async_host_t;
+
+/* GET request of asynchronous SNMP poller */
+typedef struct
+{
+	zbx_snmp_async_host_t	*host;
+	int			*indexes;	/* indexes of requested items */
+	int			indexes_num;
+	int			level;		/* see level of zbx_snmp_get_values() */
+}
+zbx_snmp_async_request_t;
+
+static zbx_snmp_async_request_t	*zbx_snmp_async_request_create(zbx_snmp_async_host_t *host, const int *indexes,
+		int indexes_num, int level)
+{
+	zbx_snmp_async_request_t	*request;
+
+	request = (zbx_snmp_async_request_t *)zbx_malloc(NULL, sizeof(zbx_snmp_async_request_t));
+	request->host = host;
+	request->indexes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)indexes_num);
+	memcpy(request->indexes, indexes, sizeof(int) * (size_t)indexes_num);
+	request->indexes_num = indexes_num;
+	request->level = level;
+
+	zbx_vector_ptr_append(&host->requests, request);
+
+	return request;
+}
+
+static void	zbx_snmp_async_request_free(zbx_snmp_async_request_t *request)
+{
+	zbx_free(request->indexes);
+	zbx_free(request);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_request_fail                                      *
+ *                                                                            *
+ * Purpose: set error for requested items that have not got a value yet      *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_async_request_fail(const zbx_snmp_async_request_t *request, int err, const char *error)
+{
+	const zbx_snmp_async_host_t	*host = request->host;
+	int				i;
+
+	for (i = 0; i < request->indexes_num; i++)
+	{
+		int	j = request->indexes[i];
+
+		if (SUCCEED != host->errcodes[j])
+			continue;
+
+		SET_MSG_RESULT(&host->results[j], zbx_strdup(NULL, error));
+		host->errcodes[j] = err;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_host_fail                                         *
+ *                                                                            *
+ * Purpose: set error for all items of the interface waiting to be requested  *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_async_host_fail(zbx_snmp_async_host_t *host, int err, const char *error)
+{
+	int	i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "getting SNMP values failed: %s", error);
+
+	for (i = 0; i < host->requests.values_num; i++)
+	{
+		zbx_snmp_async_request_t	*request = (zbx_snmp_async_request_t *)host->requests.values[i];
+
+		zbx_snmp_async_request_fail(request, err, error);
+		zbx_snmp_async_request_free(request);
+	}
+
+	zbx_vector_ptr_clear(&host->requests);
+	host->err = err;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_process                                           *
+ *                                                                            *
+ * Purpose: process response to asynchronous GET request                      *
+ *                                                                            *
+ * Parameters: request  - [IN] the request, freed or queued again             *
+ *             status   - [IN] the request status (STAT_*)                    *
+ *             response - [IN] the response, NULL if no response was received *
+ *                                                                            *
+ * Comments: Mirrors the synchronous zbx_snmp_get_values(). Requests that are *
+ *           too big for the device are split and queued again instead of     *
+ *           being retried in place.                                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_async_process(zbx_snmp_async_request_t *request, int status, struct snmp_pdu *response)
+{
+	zbx_snmp_async_host_t	*host = request->host;
+	struct variable_list	*var;
+	char			error[MAX_STRING_LEN];
+	int			i, j, ret = SUCCEED, num = request->indexes_num;
+	unsigned char		val_type;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' status:%d errstat:%ld num:%d level:%d", __func__,
+			host->item->host.host, status, NULL == response ? (long)-1 : response->errstat, num,
+			request->level);
+
+	if (STAT_SUCCESS == status && SNMP_ERR_NOERROR == response->errstat)
+	{
+		for (i = 0, var = response->variables;; i++, var = var->next_variable)
+		{
+			/* check that response variable binding matches the request variable binding */
+
+			if (i == num)
+			{
+				if (NULL != var)
+				{
+					zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains"
+							" too many variable bindings", host->item->host.host);
+
+					if (1 != num)	/* give device a chance to handle a smaller request */
+						goto halve;
+
+					zbx_strlcpy(error, "Invalid SNMP response: too many variable bindings.",
+							sizeof(error));
+
+					ret = NOTSUPPORTED;
+				}
+
+				break;
+			}
+
+			if (NULL == var)
+			{
+				zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains"
+						" too few variable bindings", host->item->host.host);
+
+				if (1 != num)	/* give device a chance to handle a smaller request */
+					goto halve;
+
+				zbx_strlcpy(error, "Invalid SNMP response: too few variable bindings.", sizeof(error));
+
+				ret = NOTSUPPORTED;
+				break;
+			}
+
+			j = request->indexes[i];
+
+			if (host->oid_lens[j] != var->name_length ||
+					0 != memcmp(host->oids[j], var->name, host->oid_lens[j] * sizeof(oid)))
+			{
+				char	sent_oid[ITEM_SNMP_OID_LEN_MAX], received_oid[ITEM_SNMP_OID_LEN_MAX];
+
+				zbx_snmp_dump_oid(sent_oid, sizeof(sent_oid), host->oids[j], host->oid_lens[j]);
+				zbx_snmp_dump_oid(received_oid, sizeof(received_oid), var->name, var->name_length);
+
+				if (1 != num)
+				{
+					zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains"
+							" variable bindings that do not match the request:"
+							" sent \"%s\", received \"%s\"",
+							host->item->host.host, sent_oid, received_oid);
+
+					goto halve;	/* give device a chance to handle a smaller request */
+				}
+				else
+				{
+					zabbix_log(LOG_LEVEL_DEBUG, "SNMP response from host \"%s\" contains"
+							" variable bindings that do not match the request:"
+							" sent \"%s\", received \"%s\"",
+							host->item->host.host, sent_oid, received_oid);
+				}
+			}
+
+			/* process received data */
+
+			host->errcodes[j] = zbx_snmp_set_result(var, &host->results[j], &val_type);
+
+			if (ISSET_TEXT(&host->results[j]) && ZBX_SNMP_STR_HEX == val_type)
+				zbx_remove_chars(host->results[j].text, "\r\n");
+		}
+
+		if (SUCCEED == ret && host->max_succeed < num)
+			host->max_succeed = num;
+	}
+	else if (STAT_SUCCESS == status && SNMP_ERR_NOSUCHNAME == response->errstat && 0 != response->errindex)
+	{
+		/* see zbx_snmp_get_values() for the reasoning, the bad variable is removed and the request is retried */
+
+		i = response->errindex - 1;
+
+		if (0 > i || i >= num)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains"
+					" an out of bounds error index: %ld", host->item->host.host, response->errindex);
+
+			zbx_strlcpy(error, "Invalid SNMP response: error index out of bounds.", sizeof(error));
+
+			ret = NOTSUPPORTED;
+		}
+		else
+		{
+			j = request->indexes[i];
+
+			host->errcodes[j] = zbx_get_snmp_response_error(host->ss, &host->item->interface, status,
+					response, error, sizeof(error));
+			SET_MSG_RESULT(&host->results[j], zbx_strdup(NULL, error));
+
+			if (1 < num)
+			{
+				memmove(request->indexes + i, request->indexes + i + 1, sizeof(int) * (num - i - 1));
+				zbx_snmp_async_request_create(host, request->indexes, num - 1, request->level);
+			}
+		}
+	}
+	else if (1 < num &&
+			((STAT_SUCCESS == status && SNMP_ERR_TOOBIG == response->errstat) || STAT_TIMEOUT == status ||
+			(STAT_ERROR == status && SNMPERR_TOO_LONG == host->ss->s_snmp_errno)))
+	{
+		/* see zbx_snmp_get_values() for the reasoning, the request is halved and then split into single */
+		/* variable requests */
+halve:
+		if (host->min_fail > num)
+			host->min_fail = num;
+
+		if (0 == request->level)
+		{
+			zbx_snmp_async_request_create(host, request->indexes, num / 2, request->level + 1);
+			zbx_snmp_async_request_create(host, request->indexes + num / 2, num - num / 2,
+					request->level + 1);
+		}
+		else
+		{
+			for (i = 0; i < num; i++)
+				zbx_snmp_async_request_create(host, request->indexes + i, 1, request->level + 1);
+		}
+	}
+	else
+	{
+		ret = zbx_get_snmp_response_error(host->ss, &host->item->interface, status, response, error,
+				sizeof(error));
+	}
+
+	if (SUCCEED != ret)
+	{
+		zbx_snmp_async_request_fail(request, ret, error);
+		zbx_snmp_async_host_fail(host, ret, error);
+	}
+
+	zbx_snmp_async_request_free(request);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+}
+
+static void	zbx_snmp_async_host_send(zbx_snmp_async_host_t *host);
+
+static int	zbx_snmp_async_cb(int operation, struct snmp_session *ss, int reqid, struct snmp_pdu *pdu, void *magic)
+{
+	zbx_snmp_async_request_t	*request = (zbx_snmp_async_request_t *)magic;
+	zbx_snmp_async_host_t		*host = request->host;
+	int				i, status;
+
+	ZBX_UNUSED(ss);
+	ZBX_UNUSED(reqid);
+
+	/* requests in flight are freed by zbx_snmp_async_get_values() when session is closed */
+	if (0 != host->closing)
+		return 1;
+
+	if (FAIL != (i = zbx_vector_ptr_search(&host->sent, request, ZBX_DEFAULT_PTR_COMPARE_FUNC)))
+		zbx_vector_ptr_remove_noorder(&host->sent, i);
+
+	(*host->requests_total)--;
+
+	switch (operation)
+	{
+		case NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE:
+			status = STAT_SUCCESS;
+			break;
+		case NETSNMP_CALLBACK_OP_TIMED_OUT:
+			status = STAT_TIMEOUT;
+			break;
+		default:
+			status = STAT_ERROR;
+	}
+
+	zbx_snmp_async_process(request, status, STAT_SUCCESS == status ? pdu : NULL);
+	zbx_snmp_async_host_send(host);
+
+	return 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_host_send                                         *
+ *                                                                            *
+ * Purpose: send queued requests of the interface within its concurrency      *
+ *          limit                                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_async_host_send(zbx_snmp_async_host_t *host)
+{
+	while (CONFIG_SNMPPOLLER_HOST_REQUESTS > host->sent.values_num && 0 != host->requests.values_num)
+	{
+		zbx_snmp_async_request_t	*request;
+		struct snmp_pdu			*pdu;
+		int				i;
+
+		request = (zbx_snmp_async_request_t *)host->requests.values[host->requests.values_num - 1];
+		zbx_vector_ptr_remove_noorder(&host->requests, host->requests.values_num - 1);
+
+		if (NULL == (pdu = snmp_pdu_create(SNMP_MSG_GET)))
+		{
+			zbx_snmp_async_request_fail(request, CONFIG_ERROR, "snmp_pdu_create(): cannot create PDU object.");
+			zbx_snmp_async_request_free(request);
+			continue;
+		}
+
+		for (i = 0; i < request->indexes_num; i++)
+		{
+			int	j = request->indexes[i];
+
+			if (NULL == snmp_add_null_var(pdu, host->oids[j], host->oid_lens[j]))
+			{
+				zbx_snmp_async_request_fail(request, CONFIG_ERROR,
+						"snmp_add_null_var(): cannot add null variable.");
+				snmp_free_pdu(pdu);
+				pdu = NULL;
+				break;
+			}
+		}
+
+		if (NULL == pdu)
+		{
+			zbx_snmp_async_request_free(request);
+			continue;
+		}
+
+		/* retries are per session, so they are only set when the request is the only one in flight */
+		host->ss->retries = (1 == CONFIG_SNMPPOLLER_HOST_REQUESTS && 1 == request->indexes_num &&
+				0 == request->level ? 1 : 0);
+
+		if (0 == snmp_async_send(host->ss, pdu, zbx_snmp_async_cb, request))
+		{
+			snmp_free_pdu(pdu);
+			zbx_snmp_async_process(request, STAT_ERROR, NULL);
+			continue;
+		}
+
+		zbx_vector_ptr_append(&host->sent, request);
+		(*host->requests_total)++;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_host_close                                        *
+ *                                                                            *
+ * Purpose: close session of the interface and update its SNMP statistics     *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_async_host_close(zbx_snmp_async_host_t *host)
+{
+	host->closing = 1;
+	zbx_snmp_close_session(host->ss);
+	host->ss = NULL;
+
+	if (SUCCEED == host->err && SNMP_BULK_ENABLED == host->bulk &&
+			(0 != host->max_succeed || MAX_SNMP_ITEMS + 1 != host->min_fail))
+	{
+		DCconfig_update_interface_snmp_stats(host->item->interface.interfaceid, host->max_succeed,
+				host->min_fail);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_item_supported                                    *
+ *                                                                            *
+ * Purpose: check if item value can be got by asynchronous SNMP poller        *
+ *                                                                            *
+ * Comments: discovery rules and dynamic indexes need walks, which are done   *
+ *           synchronously                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_snmp_async_item_supported(const DC_ITEM *item)
+{
+	if (0 != (ZBX_FLAG_DISCOVERY_RULE & item->flags) || 0 == strncmp(item->snmp_oid, "discovery[", 10))
+		return FAIL;
+
+	if (NULL != strchr(item->snmp_oid, '['))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+static int	zbx_snmp_async_item_compare(const void *d1, const void *d2)
+{
+	const DC_ITEM	*i1 = *(const DC_ITEM * const *)d1;
+	const DC_ITEM	*i2 = *(const DC_ITEM * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->interface.interfaceid, i2->interface.interfaceid);
+	ZBX_RETURN_IF_NOT_EQUAL(i1, i2);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_get_values                                        *
+ *                                                                            *
+ * Purpose: get values of static OIDs on many interfaces concurrently         *
+ *                                                                            *
+ * Parameters: items    - [IN] the items to check                             *
+ *             results  - [OUT] the check results                             *
+ *             errcodes - [IN/OUT] the item error codes, only items with      *
+ *                                 SUCCEED error code and static OID are      *
+ *                                 checked                                    *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: Sessions are opened by zbx_snmp_open_session() as for            *
+ *           synchronous checks and are multiplexed by Net-SNMP asynchronous  *
+ *           API. Up to ZBX_SNMP_ASYNC_MAX_SESSIONS interfaces are polled at  *
+ *           once, each with up to SNMPPollerHostRequests requests in flight. *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_async_get_values(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	oid			(*oids)[MAX_OID_LEN];
+	size_t			*oid_lens;
+	zbx_vector_ptr_t	checks, hosts;
+	int			i, j, *indexes, hosts_next = 0, sessions_num = 0, requests_total = 0;
+	char			error[MAX_STRING_LEN];
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __func__, num);
+
+	zbx_vector_ptr_create(&checks);
+	zbx_vector_ptr_create(&hosts);
+
+	oids = zbx_malloc(NULL, sizeof(oid) * MAX_OID_LEN * (size_t)num);
+	oid_lens = (size_t *)zbx_malloc(NULL, sizeof(size_t) * (size_t)num);
+	indexes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+
+	for (i = 0; i < num; i++)
+	{
+		char	oid_translated[ITEM_SNMP_OID_LEN_MAX];
+
+		if (SUCCEED != errcodes[i] || SUCCEED != zbx_snmp_async_item_supported(&items[i]))
+			continue;
+
+		if (0 != num_key_param(items[i].snmp_oid))
+		{
+			SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL, "OID \"%s\" contains unsupported parameters.",
+					items[i].snmp_oid));
+			errcodes[i] = CONFIG_ERROR;
+			continue;
+		}
+
+		zbx_snmp_translate(oid_translated, items[i].snmp_oid, sizeof(oid_translated));
+		oid_lens[i] = MAX_OID_LEN;
+
+		if (NULL == snmp_parse_oid(oid_translated, oids[i], &oid_lens[i]))
+		{
+			SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL, "snmp_parse_oid(): cannot parse OID \"%s\".",
+					oid_translated));
+			errcodes[i] = CONFIG_ERROR;
+			continue;
+		}
+
+		zbx_vector_ptr_append(&checks, (void *)&items[i]);
+	}
+
+	zbx_vector_ptr_sort(&checks, zbx_snmp_async_item_compare);
+
+	for (i = 0; i < checks.values_num; i++)
+		indexes[i] = (int)((const DC_ITEM *)checks.values[i] - items);
+
+	/* split items of each interface into requests of the suggested size */
+	for (i = 0; i < checks.values_num; i = j)
+	{
+		zbx_snmp_async_host_t	*host;
+		int			k;
+
+		host = (zbx_snmp_async_host_t *)zbx_malloc(NULL, sizeof(zbx_snmp_async_host_t));
+		memset(host, 0, sizeof(zbx_snmp_async_host_t));
+		host->results = results;
+		host->errcodes = errcodes;
+		host->oids = oids;
+		host->oid_lens = oid_lens;
+		host->item = &items[indexes[i]];
+		host->requests_total = &requests_total;
+		host->min_fail = MAX_SNMP_ITEMS + 1;
+		host->err = SUCCEED;
+		host->max_vars = DCconfig_get_suggested_snmp_vars(host->item->interface.interfaceid, &host->bulk);
+		zbx_vector_ptr_create(&host->requests);
+		zbx_vector_ptr_create(&host->sent);
+		zbx_vector_ptr_append(&hosts, host);
+
+		for (j = i; j < checks.values_num; j++)
+		{
+			if (items[indexes[j]].interface.interfaceid != host->item->interface.interfaceid)
+				break;
+		}
+
+		for (k = i; k < j; k += host->max_vars)
+		{
+			zbx_snmp_async_request_create(host, indexes + k, MIN(host->max_vars, j - k), 0);
+		}
+	}
+
+	while (1)
+	{
+		int		fds = 0, block = 1;
+		fd_set		fdset;
+		struct timeval	timeout;
+
+		/* close sessions of completed interfaces */
+		for (i = 0; i < hosts_next; i++)
+		{
+			zbx_snmp_async_host_t	*host = (zbx_snmp_async_host_t *)hosts.values[i];
+
+			if (NULL != host->ss && 0 == host->sent.values_num && 0 == host->requests.values_num)
+			{
+				zbx_snmp_async_host_close(host);
+				sessions_num--;
+			}
+		}
+
+		/* open sessions of waiting interfaces */
+		while (ZBX_SNMP_ASYNC_MAX_SESSIONS > sessions_num && hosts_next < hosts.values_num)
+		{
+			zbx_snmp_async_host_t	*host = (zbx_snmp_async_host_t *)hosts.values[hosts_next++];
+
+			if (NULL == (host->ss = zbx_snmp_open_session(host->item, error, sizeof(error))))
+			{
+				zbx_snmp_async_host_fail(host, NETWORK_ERROR, error);
+				continue;
+			}
+
+			sessions_num++;
+			zbx_snmp_async_host_send(host);
+		}
+
+		if (0 == requests_total)
+		{
+			if (hosts_next == hosts.values_num)
+				break;
+
+			continue;
+		}
+
+		FD_ZERO(&fdset);
+		snmp_select_info(&fds, &fdset, &timeout, &block);
+
+		if (-1 == (fds = select(fds, &fdset, NULL, NULL, 0 == block ? &timeout : NULL)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			zabbix_log(LOG_LEVEL_WARNING, "%s() select() failed: %s", __func__, zbx_strerror(errno));
+			break;
+		}
+
+		if (0 < fds)
+			snmp_read(&fdset);
+		else
+			snmp_timeout();
+	}
+
+	for (i = 0; i < hosts.values_num; i++)
+	{
+		zbx_snmp_async_host_t	*host = (zbx_snmp_async_host_t *)hosts.values[i];
+
+		/* items are left unchecked only if polling was interrupted by select() failure */
+		for (j = 0; j < host->sent.values_num; j++)
+		{
+			zbx_snmp_async_request_fail((zbx_snmp_async_request_t *)host->sent.values[j], NETWORK_ERROR,
+					"Cannot wait for SNMP response.");
+		}
+
+		if (0 != host->requests.values_num)
+			zbx_snmp_async_host_fail(host, NETWORK_ERROR, "Cannot wait for SNMP response.");
+
+		if (NULL != host->ss)
+			zbx_snmp_async_host_close(host);
+
+		zbx_vector_ptr_clear_ext(&host->sent, (zbx_clean_func_t)zbx_snmp_async_request_free);
+		zbx_vector_ptr_destroy(&host->sent);
+		zbx_vector_ptr_destroy(&host->requests);
+		zbx_free(host);
+	}
+
+	zbx_free(indexes);
+	zbx_free(oid_lens);
+	zbx_free(oids);
+	zbx_vector_ptr_destroy(&hosts);
+	zbx_vector_ptr_destroy(&checks);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 int	get_value_snmp(const DC_ITEM *item, AGENT_RESULT *result, unsigned char poller_type)
 {
 	int	errcode = SUCCEED;
@@ -2074,6 +3099,19 @@ void	get_values_snmp(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes,
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' num:%d",
 			__func__, items[0].host.host, items[0].interface.addr, num);
 
+	if (ZBX_POLLER_TYPE_SNMP == poller_type)
+	{
+		/* items that need walks are checked one by one before asynchronous polling is started */
+		for (i = 0; i < num; i++)
+		{
+			if (SUCCEED == errcodes[i] && SUCCEED != zbx_snmp_async_item_supported(&items[i]))
+				get_values_snmp(&items[i], &results[i], &errcodes[i], 1, ZBX_POLLER_TYPE_NORMAL);
+		}
+
+		zbx_snmp_async_get_values(items, results, errcodes, num);
+		goto out;
+	}
+
 	for (j = 0; j < num; j++)	/* locate first supported item to use as a reference */
 	{
 		if (SUCCEED == errcodes[j])
@@ -2175,4 +3213,8 @@ void	zbx_clear_cache_snmp(unsigned char process_type, int process_num)
 	zbx_init_snmp();
 }
 
+#ifdef HAVE_TESTS
+#	include "../../../tests/zabbix_server/poller/snmp_walk_cache_test.c"
+#endif
+
 #endif	/* HAVE_NETSNMP */
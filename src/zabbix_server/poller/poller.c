@@ -761,6 +761,11 @@ void	zbx_check_items(DC_ITEM *items, int *errcodes, int num, AGENT_RESULT *resul
 		get_values_java(ZBX_JAVA_GATEWAY_REQUEST_JMX, items, results, errcodes, num);
 		zbx_alarm_off();
 	}
+	else if (ZBX_POLLER_TYPE_AGENT == poller_type || (ITEM_TYPE_ZABBIX == items[0].type && 1 < num))
+	{
+		/* agent checks use their own timeouts */
+		get_values_agent(items, results, errcodes, num);
+	}
 	else if (1 == num)
 	{
 		if (SUCCEED == errcodes[0])
@@ -835,22 +840,25 @@ void	zbx_clean_items(DC_ITEM *items, int num, AGENT_RESULT *results)
  * Purpose: retrieve values of metrics from monitored hosts                   *
  *                                                                            *
  * Parameters: poller_type - [IN] poller type (ZBX_POLLER_TYPE_...)           *
+ *             items       - [IN] buffer for items taken from the queue       *
+ *             results     - [IN] buffer for item check results               *
+ *             errcodes    - [IN] buffer for item check error codes           *
+ *             nextcheck   - [OUT] the time of the next check in the queue    *
  *                                                                            *
  * Return value: number of items processed                                    *
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
- * Comments: processes single item at a time except for Java, SNMP items,     *
- *           see DCconfig_get_poller_items()                                  *
+ * Comments: processes single item at a time except for Java, SNMP and agent  *
+ *           items, see DCconfig_get_poller_items()                           *
  *                                                                            *
  ******************************************************************************/
-static int	get_values(unsigned char poller_type, int *nextcheck)
+static int	get_values(unsigned char poller_type, DC_ITEM *items, AGENT_RESULT *results, int *errcodes,
+		int *nextcheck)
 {
-	DC_ITEM			items[MAX_POLLER_ITEMS];
-	AGENT_RESULT		results[MAX_POLLER_ITEMS];
-	int			errcodes[MAX_POLLER_ITEMS];
 	zbx_timespec_t		timespec;
-	int			i, num, last_available = HOST_AVAILABLE_UNKNOWN;
+	int			i, num, *lastclocks, last_available = HOST_AVAILABLE_UNKNOWN;
+	zbx_uint64_t		*itemids;
 	zbx_vector_ptr_t	add_results;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
@@ -870,9 +878,16 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 
 	zbx_timespec(&timespec);
 
+	itemids = (zbx_uint64_t *)zbx_malloc(NULL, sizeof(zbx_uint64_t) * (size_t)num);
+	lastclocks = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)num);
+
 	/* process item values */
 	for (i = 0; i < num; i++)
 	{
+		/* agent and SNMP poller batches contain items of different hosts */
+		if (0 != i && items[i].host.hostid != items[i - 1].host.hostid)
+			last_available = HOST_AVAILABLE_UNKNOWN;
+
 		switch (errcodes[i])
 		{
 			case SUCCEED:
@@ -951,10 +966,15 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 					items[i].state, results[i].msg);
 		}
 
-		DCpoller_requeue_items(&items[i].itemid, &timespec.sec, &errcodes[i], 1, poller_type,
-				nextcheck);
+		itemids[i] = items[i].itemid;
+		lastclocks[i] = timespec.sec;
 	}
 
+	DCpoller_requeue_items(itemids, lastclocks, errcodes, (size_t)num, poller_type, nextcheck);
+
+	zbx_free(lastclocks);
+	zbx_free(itemids);
+
 	zbx_preprocessor_flush();
 	zbx_clean_items(items, num, results);
 	DCconfig_clean_items(items, NULL, num);
@@ -978,10 +998,12 @@ static void	zbx_poller_sigusr_handler(int flags)
 
 ZBX_THREAD_ENTRY(poller_thread, args)
 {
-	int		nextcheck, sleeptime = -1, processed = 0, old_processed = 0;
+	int		nextcheck, sleeptime = -1, processed = 0, old_processed = 0, max_items, *errcodes;
 	double		sec, total_sec = 0.0, old_total_sec = 0.0;
 	time_t		last_stat_time;
 	unsigned char	poller_type;
+	DC_ITEM		*items;
+	AGENT_RESULT	*results;
 
 #define	STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
 				/* once in STAT_INTERVAL seconds */
@@ -1013,6 +1035,22 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 
 	zbx_set_sigusr_handler(zbx_poller_sigusr_handler);
 
+	switch (poller_type)
+	{
+		case ZBX_POLLER_TYPE_AGENT:
+			max_items = MAX_AGENT_ITEMS;
+			break;
+		case ZBX_POLLER_TYPE_SNMP:
+			max_items = MAX_SNMP_ASYNC_ITEMS;
+			break;
+		default:
+			max_items = MAX_POLLER_ITEMS;
+	}
+
+	items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * (size_t)max_items);
+	results = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT) * (size_t)max_items);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)max_items);
+
 	while (ZBX_IS_RUNNING())
 	{
 		sec = zbx_time();
@@ -1033,11 +1071,15 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 					old_total_sec);
 		}
 
-		processed += get_values(poller_type, &nextcheck);
+		processed += get_values(poller_type, items, results, errcodes, &nextcheck);
 		total_sec += zbx_time() - sec;
 
 		sleeptime = calculate_sleeptime(nextcheck, POLLER_DELAY);
 
+#ifdef HAVE_NETSNMP
+		if (0 != sleeptime)	/* walk results are shared within poll cycle only */
+			zbx_clear_walk_cache_snmp();
+#endif
 		if (0 != sleeptime || STAT_INTERVAL <= time(NULL) - last_stat_time)
 		{
 			if (0 == sleeptime)
@@ -1061,6 +1103,10 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 		zbx_sleep_loop(sleeptime);
 	}
 
+	zbx_free(errcodes);
+	zbx_free(results);
+	zbx_free(items);
+
 	scriptitem_es_engine_destroy();
 
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
@@ -37,6 +37,23 @@
 
 extern zbx_es_t	es_engine;
 
+/* The minimum size of json document to be kept for subsequent JSONPath queries. Dependent items of */
+/* the same master item are preprocessed with the same input value, so the document is validated   */
+/* and indexed only once instead of parsing it again for every dependent item.                     */
+#define ZBX_PREPROC_JSON_CACHE_MIN_SIZE	ZBX_KIBIBYTE
+
+/* the last json document queried with JSONPath */
+typedef struct
+{
+	char			*data;
+	size_t			size;
+	struct zbx_json_parse	jp;
+	zbx_jsonpath_index_t	*index;		/* document index, created when the document is queried again */
+}
+zbx_preproc_json_cache_t;
+
+static zbx_preproc_json_cache_t	json_cache;
+
 /******************************************************************************
  *                                                                            *
  * Function: item_preproc_numeric_type_hint                                   *
@@ -786,10 +803,11 @@ static int	item_preproc_hex2dec(zbx_variant_t *value, char **errmsg)
  ******************************************************************************/
 static int	item_preproc_regsub_op(zbx_variant_t *value, const char *params, char **errmsg)
 {
-	char		pattern[ITEM_PREPROC_PARAMS_LEN * ZBX_MAX_BYTES_IN_UTF8_CHAR + 1];
-	char		*output, *new_value = NULL;
-	const char	*regex_error;
-	zbx_regexp_t	*regex = NULL;
+	char			pattern[ITEM_PREPROC_PARAMS_LEN * ZBX_MAX_BYTES_IN_UTF8_CHAR + 1];
+	char			*output, *new_value = NULL;
+	const char		*regex_error;
+	zbx_regexp_t		*regex = NULL;
+	int			ret;
 
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
@@ -804,24 +822,25 @@ static int	item_preproc_regsub_op(zbx_variant_t *value, const char *params, char
 
 	*output++ = '\0';
 
-	if (FAIL == zbx_regexp_compile_ext(pattern, &regex, 0, &regex_error))	/* PCRE_MULTILINE is not used here */
+	/* PCRE_MULTILINE is not used here */
+	if (FAIL == zbx_regexp_compile_cached_ext(pattern, &regex, 0, &regex_error))
 	{
 		*errmsg = zbx_dsprintf(*errmsg, "invalid regular expression: %s", regex_error);
 		return FAIL;
 	}
 
-	if (FAIL == zbx_mregexp_sub_precompiled(value->data.str, regex, output, ZBX_MAX_RECV_DATA_SIZE, &new_value))
+	ret = zbx_mregexp_sub_precompiled(value->data.str, regex, output, ZBX_MAX_RECV_DATA_SIZE, &new_value);
+	zbx_regexp_release(regex);
+
+	if (FAIL == ret)
 	{
 		*errmsg = zbx_strdup(*errmsg, "pattern does not match");
-		zbx_regexp_free(regex);
 		return FAIL;
 	}
 
 	zbx_variant_clear(value);
 	zbx_variant_set_str(value, new_value);
 
-	zbx_regexp_free(regex);
-
 	return SUCCEED;
 }
 
@@ -860,6 +879,34 @@ static int	item_preproc_regsub(zbx_variant_t *value, const char *params, char **
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_json_cache_set                                      *
+ *                                                                            *
+ * Purpose: keep copy of the validated json document for subsequent JSONPath  *
+ *          queries                                                           *
+ *                                                                            *
+ * Parameters: data - [IN] the json document                                  *
+ *             size - [IN] the document size                                  *
+ *             jp   - [IN] the opened document                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	item_preproc_json_cache_set(const char *data, size_t size, const struct zbx_json_parse *jp)
+{
+	if (NULL != json_cache.index)
+	{
+		zbx_jsonpath_index_free(json_cache.index);
+		json_cache.index = NULL;
+	}
+
+	json_cache.data = (char *)zbx_realloc(json_cache.data, size + 1);
+	memcpy(json_cache.data, data, size + 1);
+	json_cache.size = size;
+
+	json_cache.jp.start = json_cache.data + (jp->start - data);
+	json_cache.jp.end = json_cache.data + (jp->end - data);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: item_preproc_jsonpath_op                                         *
@@ -878,11 +925,30 @@ static int	item_preproc_jsonpath_op(zbx_variant_t *value, const char *params, ch
 {
 	struct zbx_json_parse	jp;
 	char			*data = NULL;
+	size_t			size;
+	int			ret;
 
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
 
-	if (FAIL == zbx_json_open(value->data.str, &jp) || FAIL == zbx_jsonpath_query(&jp, params, &data))
+	size = strlen(value->data.str);
+
+	if (NULL != json_cache.data && size == json_cache.size && 0 == memcmp(value->data.str, json_cache.data, size))
+	{
+		if (NULL == json_cache.index)
+			json_cache.index = zbx_jsonpath_index_create(&json_cache.jp);
+
+		ret = zbx_jsonpath_query_index(json_cache.index, params, &data);
+	}
+	else if (SUCCEED == (ret = zbx_json_open(value->data.str, &jp)))
+	{
+		if (ZBX_PREPROC_JSON_CACHE_MIN_SIZE <= size)
+			item_preproc_json_cache_set(value->data.str, size, &jp);
+
+		ret = zbx_jsonpath_query(&jp, params, &data);
+	}
+
+	if (FAIL == ret)
 	{
 		*errmsg = zbx_strdup(*errmsg, zbx_json_strerror());
 		return FAIL;
@@ -1160,11 +1226,11 @@ out:
  ******************************************************************************/
 static int	item_preproc_validate_regex(const zbx_variant_t *value, const char *params, char **error)
 {
-	zbx_variant_t	value_str;
-	int		ret = FAIL;
-	zbx_regexp_t	*regex;
-	const char	*errptr = NULL;
-	char		*errmsg;
+	zbx_variant_t		value_str;
+	int			ret = FAIL;
+	zbx_regexp_t		*regex;
+	const char		*errptr = NULL;
+	char			*errmsg;
 
 	zbx_variant_copy(&value_str, value);
 
@@ -1174,7 +1240,7 @@ static int	item_preproc_validate_regex(const zbx_variant_t *value, const char *p
 		goto out;
 	}
 
-	if (FAIL == zbx_regexp_compile(params, &regex, &errptr))
+	if (FAIL == zbx_regexp_compile_cached(params, &regex, &errptr))
 	{
 		errmsg = zbx_dsprintf(NULL, "invalid regular expression pattern: %s", errptr);
 		goto out;
@@ -1185,7 +1251,7 @@ static int	item_preproc_validate_regex(const zbx_variant_t *value, const char *p
 	else
 		ret = SUCCEED;
 
-	zbx_regexp_free(regex);
+	zbx_regexp_release(regex);
 out:
 	zbx_variant_clear(&value_str);
 
@@ -1216,11 +1282,11 @@ out:
  ******************************************************************************/
 static int	item_preproc_validate_not_regex(const zbx_variant_t *value, const char *params, char **error)
 {
-	zbx_variant_t	value_str;
-	int		ret = FAIL;
-	zbx_regexp_t	*regex;
-	const char	*errptr = NULL;
-	char		*errmsg;
+	zbx_variant_t		value_str;
+	int			ret = FAIL;
+	zbx_regexp_t		*regex;
+	const char		*errptr = NULL;
+	char			*errmsg;
 
 	zbx_variant_copy(&value_str, value);
 
@@ -1230,7 +1296,7 @@ static int	item_preproc_validate_not_regex(const zbx_variant_t *value, const cha
 		goto out;
 	}
 
-	if (FAIL == zbx_regexp_compile(params, &regex, &errptr))
+	if (FAIL == zbx_regexp_compile_cached(params, &regex, &errptr))
 	{
 		errmsg = zbx_dsprintf(NULL, "invalid regular expression pattern: %s", errptr);
 		goto out;
@@ -1243,7 +1309,7 @@ static int	item_preproc_validate_not_regex(const zbx_variant_t *value, const cha
 	else
 		ret = SUCCEED;
 
-	zbx_regexp_free(regex);
+	zbx_regexp_release(regex);
 out:
 	zbx_variant_clear(&value_str);
 
@@ -42,6 +42,9 @@ extern int		server_num, process_num, CONFIG_PREPROCESSOR_FORKS;
 #define ZBX_PREPROC_PRIORITY_NONE	0
 #define ZBX_PREPROC_PRIORITY_FIRST	1
 
+/* maximum number of dependent item values sharing master item value sent to worker in one task */
+#define ZBX_PREPROC_DEPENDENT_BATCH_MAX	256
+
 typedef enum
 {
 	REQUEST_STATE_QUEUED		= 0,		/* requires preprocessing */
@@ -94,6 +97,7 @@ typedef struct
 {
 	zbx_preprocessing_worker_t	*workers;	/* preprocessing worker array */
 	int				worker_count;	/* preprocessing worker count */
+	int				worker_max;	/* preprocessing workers serving this shard */
 	zbx_list_t			queue;		/* queue of item values */
 	zbx_hashset_t			item_config;	/* item configuration L2 cache */
 	zbx_hashset_t			history_cache;	/* item value history cache */
@@ -106,6 +110,8 @@ typedef struct
 
 	zbx_list_t			direct_queue;	/* Queue of external requests that have to be */
 							/* forwarded to workers for preprocessing.    */
+	zbx_uint64_t			regexp_hits;	/* regexps found in worker caches */
+	zbx_uint64_t			regexp_misses;	/* regexps compiled by workers */
 }
 zbx_preprocessing_manager_t;
 
@@ -199,6 +205,34 @@ static void	preprocessor_sync_configuration(zbx_preprocessing_manager_t *manager
 			manager->item_config.num_data, manager->history_cache.num_data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_get_request_value                                   *
+ *                                                                            *
+ * Purpose: get value to be preprocessed from request                         *
+ *                                                                            *
+ * Parameters: request - [IN] preprocessing request                           *
+ *             value   - [OUT] the value referencing request data             *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_get_request_value(const zbx_preprocessing_request_t *request, zbx_variant_t *value)
+{
+	if (ITEM_STATE_NOTSUPPORTED == request->value.state)
+		zbx_variant_set_str(value, "");
+	else if (ISSET_LOG(request->value.result_ptr->result))
+		zbx_variant_set_str(value, request->value.result_ptr->result->log->value);
+	else if (ISSET_UI64(request->value.result_ptr->result))
+		zbx_variant_set_ui64(value, request->value.result_ptr->result->ui64);
+	else if (ISSET_DBL(request->value.result_ptr->result))
+		zbx_variant_set_dbl(value, request->value.result_ptr->result->dbl);
+	else if (ISSET_STR(request->value.result_ptr->result))
+		zbx_variant_set_str(value, request->value.result_ptr->result->str);
+	else if (ISSET_TEXT(request->value.result_ptr->result))
+		zbx_variant_set_str(value, request->value.result_ptr->result->text);
+	else
+		THIS_SHOULD_NEVER_HAPPEN;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_create_task                                         *
@@ -217,20 +251,7 @@ static zbx_uint32_t	preprocessor_create_task(zbx_preprocessing_manager_t *manage
 	zbx_preproc_history_t	*vault;
 	zbx_vector_ptr_t	*phistory;
 
-	if (ITEM_STATE_NOTSUPPORTED == request->value.state)
-		zbx_variant_set_str(&value, "");
-	else if (ISSET_LOG(request->value.result_ptr->result))
-		zbx_variant_set_str(&value, request->value.result_ptr->result->log->value);
-	else if (ISSET_UI64(request->value.result_ptr->result))
-		zbx_variant_set_ui64(&value, request->value.result_ptr->result->ui64);
-	else if (ISSET_DBL(request->value.result_ptr->result))
-		zbx_variant_set_dbl(&value, request->value.result_ptr->result->dbl);
-	else if (ISSET_STR(request->value.result_ptr->result))
-		zbx_variant_set_str(&value, request->value.result_ptr->result->str);
-	else if (ISSET_TEXT(request->value.result_ptr->result))
-		zbx_variant_set_str(&value, request->value.result_ptr->result->text);
-	else
-		THIS_SHOULD_NEVER_HAPPEN;
+	preprocessor_get_request_value(request, &value);
 
 	if (NULL != (vault = (zbx_preproc_history_t *)zbx_hashset_search(&manager->history_cache,
 				&request->value.itemid)))
@@ -245,6 +266,126 @@ static zbx_uint32_t	preprocessor_create_task(zbx_preprocessing_manager_t *manage
 			phistory, request->steps, request->steps_num);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_create_dependent_task                               *
+ *                                                                            *
+ * Purpose: create batched preprocessing task for dependent item requests     *
+ *          sharing the same master item value                                *
+ *                                                                            *
+ * Parameters: manager     - [IN] preprocessing manager                       *
+ *             queue_items - [IN] queued requests                             *
+ *             task        - [OUT] preprocessing task data                    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	preprocessor_create_dependent_task(zbx_preprocessing_manager_t *manager,
+		const zbx_vector_ptr_t *queue_items, unsigned char **task)
+{
+	zbx_variant_t			value;
+	zbx_preproc_history_t		*vault;
+	zbx_preprocessing_request_t	*request;
+	zbx_preproc_dependent_t		*dependents;
+	int				i;
+	zbx_uint32_t			size;
+
+	dependents = (zbx_preproc_dependent_t *)zbx_malloc(NULL, sizeof(zbx_preproc_dependent_t) *
+			queue_items->values_num);
+
+	for (i = 0; i < queue_items->values_num; i++)
+	{
+		request = (zbx_preprocessing_request_t *)((zbx_list_item_t *)queue_items->values[i])->data;
+
+		dependents[i].itemid = request->value.itemid;
+		dependents[i].value_type = request->value_type;
+		dependents[i].steps = request->steps;
+		dependents[i].steps_num = request->steps_num;
+
+		if (NULL != (vault = (zbx_preproc_history_t *)zbx_hashset_search(&manager->history_cache,
+				&request->value.itemid)))
+		{
+			dependents[i].history = &vault->history;
+		}
+		else
+			dependents[i].history = NULL;
+	}
+
+	/* all requests share the same master item value, pack it only once */
+	request = (zbx_preprocessing_request_t *)((zbx_list_item_t *)queue_items->values[0])->data;
+	preprocessor_get_request_value(request, &value);
+
+	size = zbx_preprocessor_pack_dependent_task(task, request->value.ts, &value, dependents,
+			queue_items->values_num);
+
+	zbx_free(dependents);
+
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_is_batchable                                        *
+ *                                                                            *
+ * Purpose: check if request can be preprocessed in a batched task together   *
+ *          with other requests sharing the same value                        *
+ *                                                                            *
+ * Parameters: request - [IN] preprocessing request                           *
+ *                                                                            *
+ * Return value: SUCCEED - the request can be batched                         *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_is_batchable(const zbx_preprocessing_request_t *request)
+{
+	if (REQUEST_STATE_QUEUED != request->state || ITEM_STATE_NOTSUPPORTED == request->value.state)
+		return FAIL;
+
+	if (0 == request->steps_num || 1 >= request->value.result_ptr->refcount)
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_get_dependent_batch                                 *
+ *                                                                            *
+ * Purpose: collect queued requests sharing the same value with the specified *
+ *          request                                                           *
+ *                                                                            *
+ * Parameters: iterator    - [IN] queue iterator pointing at the request      *
+ *             queue_items - [OUT] queued requests, starting with the one     *
+ *                                 iterator is pointing at                    *
+ *                                                                            *
+ * Comments: Dependent item values are inserted into queue right after their  *
+ *           master item, so only the following sequence of requests sharing  *
+ *           the same value is checked.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_get_dependent_batch(zbx_list_iterator_t *iterator, zbx_vector_ptr_t *queue_items)
+{
+	zbx_preprocessing_request_t	*request, *next;
+	zbx_list_iterator_t		it;
+
+	zbx_list_iterator_peek(iterator, (void **)&request);
+	zbx_vector_ptr_append(queue_items, iterator->current);
+
+	if (SUCCEED != preprocessor_is_batchable(request))
+		return;
+
+	it = *iterator;
+
+	while (ZBX_PREPROC_DEPENDENT_BATCH_MAX > queue_items->values_num && SUCCEED == zbx_list_iterator_next(&it))
+	{
+		zbx_list_iterator_peek(&it, (void **)&next);
+
+		if (next->value.result_ptr != request->value.result_ptr)
+			break;
+
+		if (SUCCEED == preprocessor_is_batchable(next))
+			zbx_vector_ptr_append(queue_items, it.current);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_set_request_state_done                              *
@@ -292,6 +433,8 @@ static void	*preprocessor_get_next_task(zbx_preprocessing_manager_t *manager, zb
 	zbx_preprocessing_request_t		*request = NULL;
 	void					*task = NULL;
 	zbx_preprocessing_direct_request_t	*direct_request;
+	zbx_vector_ptr_t			*queue_items;
+	int					i;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -333,11 +476,35 @@ static void	*preprocessor_get_next_task(zbx_preprocessing_manager_t *manager, zb
 			continue;
 		}
 
-		task = iterator.current;
-		request->state = REQUEST_STATE_PROCESSING;
-		message->code = ZBX_IPC_PREPROCESSOR_REQUEST;
-		message->size = preprocessor_create_task(manager, request, &message->data);
-		request_free_steps(request);
+		queue_items = (zbx_vector_ptr_t *)zbx_malloc(NULL, sizeof(zbx_vector_ptr_t));
+		zbx_vector_ptr_create(queue_items);
+		preprocessor_get_dependent_batch(&iterator, queue_items);
+
+		if (1 == queue_items->values_num)
+		{
+			zbx_vector_ptr_destroy(queue_items);
+			zbx_free(queue_items);
+
+			task = iterator.current;
+			request->state = REQUEST_STATE_PROCESSING;
+			message->code = ZBX_IPC_PREPROCESSOR_REQUEST;
+			message->size = preprocessor_create_task(manager, request, &message->data);
+			request_free_steps(request);
+			break;
+		}
+
+		message->code = ZBX_IPC_PREPROCESSOR_DEPENDENT_REQUEST;
+		message->size = preprocessor_create_dependent_task(manager, queue_items, &message->data);
+
+		for (i = 0; i < queue_items->values_num; i++)
+		{
+			request = (zbx_preprocessing_request_t *)((zbx_list_item_t *)queue_items->values[i])->data;
+			request->state = REQUEST_STATE_PROCESSING;
+			request_free_steps(request);
+		}
+
+		/* batched task is tracked by the vector of its queue items */
+		task = queue_items;
 		break;
 	}
 out:
@@ -995,34 +1162,25 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Function: preprocessor_add_result                                          *
+ * Function: preprocessor_set_result                                          *
  *                                                                            *
- * Purpose: handle preprocessing result                                       *
+ * Purpose: apply preprocessing result to the queued request                  *
  *                                                                            *
- * Parameters: manager - [IN] preprocessing manager                           *
- *             client  - [IN] IPC client                                      *
- *             message - [IN] packed preprocessing result                     *
+ * Parameters: manager    - [IN] preprocessing manager                        *
+ *             queue_item - [IN] queued request                               *
+ *             value      - [IN/OUT] result value                             *
+ *             history    - [IN/OUT] new preprocessing history, history       *
+ *                                   records are moved to the history cache   *
+ *             error      - [IN] preprocessing error (if any)                 *
  *                                                                            *
  ******************************************************************************/
-static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ipc_client_t *client,
-		zbx_ipc_message_t *message)
+static void	preprocessor_set_result(zbx_preprocessing_manager_t *manager, zbx_list_item_t *queue_item,
+		zbx_variant_t *value, zbx_vector_ptr_t *history, char *error)
 {
-	zbx_preprocessing_worker_t	*worker;
 	zbx_preprocessing_request_t	*request;
-	zbx_variant_t			value;
-	char				*error;
-	zbx_vector_ptr_t		history;
 	zbx_preproc_history_t		*vault;
-	zbx_list_item_t			*node;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	worker = preprocessor_get_worker_by_client(manager, client);
-	node = (zbx_list_item_t *)worker->task;
-	request = (zbx_preprocessing_request_t *)node->data;
-
-	zbx_vector_ptr_create(&history);
-	zbx_preprocessor_unpack_result(&value, &history, &error, message->data);
+	request = (zbx_preprocessing_request_t *)queue_item->data;
 
 	if (NULL != (vault = (zbx_preproc_history_t *)zbx_hashset_search(&manager->history_cache,
 			&request->value.itemid)))
@@ -1030,7 +1188,7 @@ static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ip
 		zbx_vector_ptr_clear_ext(&vault->history, (zbx_clean_func_t)zbx_preproc_op_history_free);
 	}
 
-	if (0 != history.values_num)
+	if (0 != history->values_num)
 	{
 		if (NULL == vault)
 		{
@@ -1042,8 +1200,8 @@ static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ip
 			zbx_vector_ptr_create(&vault->history);
 		}
 
-		zbx_vector_ptr_append_array(&vault->history, history.values, history.values_num);
-		zbx_vector_ptr_clear(&history);
+		zbx_vector_ptr_append_array(&vault->history, history->values, history->values_num);
+		zbx_vector_ptr_clear(history);
 	}
 	else
 	{
@@ -1054,16 +1212,45 @@ static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ip
 		}
 	}
 
-	preprocessor_set_request_state_done(manager, request, worker->task);
+	preprocessor_set_request_state_done(manager, request, queue_item);
 
-	if (FAIL != preprocessor_set_variant_result(request, &value, error))
-		preprocessor_enqueue_dependent(manager, &request->value, worker->task);
+	if (FAIL != preprocessor_set_variant_result(request, value, error))
+		preprocessor_enqueue_dependent(manager, &request->value, queue_item);
+
+	manager->preproc_num--;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_add_result                                          *
+ *                                                                            *
+ * Purpose: handle preprocessing result                                       *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] IPC client                                      *
+ *             message - [IN] packed preprocessing result                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ipc_client_t *client,
+		zbx_ipc_message_t *message)
+{
+	zbx_preprocessing_worker_t	*worker;
+	zbx_variant_t			value;
+	char				*error;
+	zbx_vector_ptr_t		history;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	worker = preprocessor_get_worker_by_client(manager, client);
+
+	zbx_vector_ptr_create(&history);
+	zbx_preprocessor_unpack_result(&value, &history, &error, message->data);
+
+	preprocessor_set_result(manager, (zbx_list_item_t *)worker->task, &value, &history, error);
 
 	worker->task = NULL;
 	zbx_variant_clear(&value);
 
-	manager->preproc_num--;
-
 	preprocessor_assign_tasks(manager);
 	preprocessing_flush_queue(manager);
 
@@ -1072,6 +1259,60 @@ static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ip
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_add_dependent_result                                *
+ *                                                                            *
+ * Purpose: handle batched dependent item preprocessing results               *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] IPC client                                      *
+ *             message - [IN] packed preprocessing results                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_add_dependent_result(zbx_preprocessing_manager_t *manager, zbx_ipc_client_t *client,
+		zbx_ipc_message_t *message)
+{
+	zbx_preprocessing_worker_t	*worker;
+	zbx_vector_ptr_t		*queue_items;
+	zbx_preproc_dependent_result_t	*results;
+	int				i, results_num;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	worker = preprocessor_get_worker_by_client(manager, client);
+	queue_items = (zbx_vector_ptr_t *)worker->task;
+
+	zbx_preprocessor_unpack_dependent_result(&results, &results_num, message->data);
+
+	if (results_num != queue_items->values_num)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		exit(EXIT_FAILURE);
+	}
+
+	/* the worker stays busy until all results are applied, so that requests */
+	/* enqueued for nested dependent items are not assigned to it            */
+	for (i = 0; i < results_num; i++)
+	{
+		preprocessor_set_result(manager, (zbx_list_item_t *)queue_items->values[i], &results[i].value,
+				&results[i].history, results[i].error);
+
+		zbx_variant_clear(&results[i].value);
+		zbx_vector_ptr_destroy(&results[i].history);
+	}
+
+	zbx_free(results);
+	zbx_vector_ptr_destroy(queue_items);
+	zbx_free(queue_items);
+	worker->task = NULL;
+
+	preprocessor_assign_tasks(manager);
+	preprocessing_flush_queue(manager);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() results:%d", __func__, results_num);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_flush_test_result                                   *
@@ -1110,6 +1351,28 @@ static void	preprocessor_flush_test_result(zbx_preprocessing_manager_t *manager,
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_add_regexp_stats                                    *
+ *                                                                            *
+ * Purpose: accumulate regular expression cache statistics reported by worker *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             message - [IN] packed hit and miss counter increments          *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_add_regexp_stats(zbx_preprocessing_manager_t *manager, const zbx_ipc_message_t *message)
+{
+	const unsigned char	*offset = message->data;
+	zbx_uint64_t		hits, misses;
+
+	offset += zbx_deserialize_uint64(offset, &hits);
+	(void)zbx_deserialize_uint64(offset, &misses);
+
+	manager->regexp_hits += hits;
+	manager->regexp_misses += misses;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_get_diag_stats                                      *
@@ -1127,7 +1390,8 @@ static void	preprocessor_get_diag_stats(zbx_preprocessing_manager_t *manager, zb
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	data_len = zbx_preprocessor_pack_diag_stats(&data, manager->queued_num, manager->preproc_num);
+	data_len = zbx_preprocessor_pack_diag_stats(&data, manager->queued_num, manager->preproc_num,
+			manager->regexp_hits, manager->regexp_misses);
 	zbx_ipc_client_send(client, ZBX_IPC_PREPROCESSOR_DIAG_STATS_RESULT, data, data_len);
 	zbx_free(data);
 
@@ -1219,15 +1483,24 @@ static void	preprocessor_get_top_items(zbx_preprocessing_manager_t *manager, zbx
  * Purpose: initializes preprocessing manager                                 *
  *                                                                            *
  * Parameters: manager - [IN] the manager to initialize                       *
+ *             shard   - [IN] the index of manager shard                      *
  *                                                                            *
  ******************************************************************************/
-static void	preprocessor_init_manager(zbx_preprocessing_manager_t *manager)
+static void	preprocessor_init_manager(zbx_preprocessing_manager_t *manager, int shard)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() workers: %d", __func__, CONFIG_PREPROCESSOR_FORKS);
+	int	i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() shard:%d", __func__, shard);
 
 	memset(manager, 0, sizeof(zbx_preprocessing_manager_t));
 
-	manager->workers = (zbx_preprocessing_worker_t *)zbx_calloc(NULL, CONFIG_PREPROCESSOR_FORKS,
+	for (i = 1; i <= CONFIG_PREPROCESSOR_FORKS; i++)
+	{
+		if (shard == zbx_preprocessor_get_worker_shard(i))
+			manager->worker_max++;
+	}
+
+	manager->workers = (zbx_preprocessing_worker_t *)zbx_calloc(NULL, manager->worker_max,
 			sizeof(zbx_preprocessing_worker_t));
 	zbx_list_create(&manager->queue);
 	zbx_list_create(&manager->direct_queue);
@@ -1238,7 +1511,7 @@ static void	preprocessor_init_manager(zbx_preprocessing_manager_t *manager)
 	zbx_hashset_create(&manager->history_cache, 1000, ZBX_DEFAULT_UINT64_HASH_FUNC,
 			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() workers:%d", __func__, manager->worker_max);
 }
 
 /******************************************************************************
@@ -1269,7 +1542,7 @@ static void preprocessor_register_worker(zbx_preprocessing_manager_t *manager, z
 	}
 	else
 	{
-		if (CONFIG_PREPROCESSOR_FORKS == manager->worker_count)
+		if (manager->worker_max == manager->worker_count)
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
 			exit(EXIT_FAILURE);
@@ -1340,14 +1613,15 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 
 	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
 
-	if (FAIL == zbx_ipc_service_start(&service, ZBX_IPC_SERVICE_PREPROCESSING, &error))
+	/* each manager shard processes values of a subset of items with its own workers */
+	if (FAIL == zbx_ipc_service_start(&service, zbx_preprocessor_service_name(process_num - 1), &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot start preprocessing service: %s", error);
 		zbx_free(error);
 		exit(EXIT_FAILURE);
 	}
 
-	preprocessor_init_manager(&manager);
+	preprocessor_init_manager(&manager, process_num - 1);
 
 	/* initialize statistics */
 	time_stat = zbx_time();
@@ -1393,6 +1667,9 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 				case ZBX_IPC_PREPROCESSOR_RESULT:
 					preprocessor_add_result(&manager, client, message);
 					break;
+				case ZBX_IPC_PREPROCESSOR_DEPENDENT_RESULT:
+					preprocessor_add_dependent_result(&manager, client, message);
+					break;
 				case ZBX_IPC_PREPROCESSOR_QUEUE:
 					zbx_ipc_client_send(client, message->code, (unsigned char *)&manager.queued_num,
 							sizeof(zbx_uint64_t));
@@ -1409,6 +1686,9 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 				case ZBX_IPC_PREPROCESSOR_TOP_ITEMS:
 					preprocessor_get_top_items(&manager, client, message);
 					break;
+				case ZBX_IPC_PREPROCESSOR_REGEXP_STATS:
+					preprocessor_add_regexp_stats(&manager, message);
+					break;
 			}
 
 			zbx_ipc_message_free(message);
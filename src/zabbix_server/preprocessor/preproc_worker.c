@@ -25,6 +25,7 @@
 #include "zbxserialize.h"
 #include "preprocessing.h"
 #include "zbxembed.h"
+#include "zbxregexp.h"
 
 #include "sysinfo.h"
 #include "preproc_worker.h"
@@ -35,6 +36,7 @@ extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
 #define ZBX_PREPROC_VALUE_PREVIEW_LEN		100
+#define ZBX_PREPROC_REGEXP_STATS_INTERVAL	1	/* regexp cache statistics reporting interval */
 
 zbx_es_t	es_engine;
 
@@ -275,60 +277,98 @@ static int	worker_item_preproc_execute(unsigned char value_type, zbx_variant_t *
 
 /******************************************************************************
  *                                                                            *
- * Function: worker_preprocess_value                                          *
+ * Function: worker_preprocess_steps                                          *
  *                                                                            *
- * Purpose: handle item value preprocessing task                              *
+ * Purpose: execute preprocessing steps and format the error message          *
  *                                                                            *
- * Parameters: socket  - [IN] IPC socket                                      *
- *             message - [IN] packed preprocessing task                       *
+ * Parameters: value_type    - [IN] the item value type                       *
+ *             value         - [IN/OUT] the value to process                  *
+ *             ts            - [IN] the value timestamp                       *
+ *             steps         - [IN] the preprocessing steps to execute        *
+ *             steps_num     - [IN] the number of preprocessing steps         *
+ *             history_in    - [IN] the preprocessing history                 *
+ *             history_out   - [OUT] the new preprocessing history            *
+ *             error         - [OUT] error message                            *
+ *                                                                            *
+ * Return value: SUCCEED - the preprocessing steps finished successfully      *
+ *               FAIL - otherwise, error contains the error message           *
  *                                                                            *
  ******************************************************************************/
-static void	worker_preprocess_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t *message)
+static int	worker_preprocess_steps(unsigned char value_type, zbx_variant_t *value, const zbx_timespec_t *ts,
+		zbx_preproc_op_t *steps, int steps_num, zbx_vector_ptr_t *history_in, zbx_vector_ptr_t *history_out,
+		char **error)
 {
-	zbx_uint32_t		size = 0;
-	unsigned char		*data = NULL, value_type;
-	zbx_uint64_t		itemid;
-	zbx_variant_t		value, value_start;
-	int			i, steps_num, results_num, ret;
-	char			*errmsg = NULL, *error = NULL;
-	zbx_timespec_t		*ts;
-	zbx_preproc_op_t	*steps;
-	zbx_vector_ptr_t	history_in, history_out;
+	zbx_variant_t		value_start;
+	int			i, results_num, ret;
+	char			*errmsg = NULL;
 	zbx_preproc_result_t	*results;
 
-	zbx_vector_ptr_create(&history_in);
-	zbx_vector_ptr_create(&history_out);
-
-	zbx_preprocessor_unpack_task(&itemid, &value_type, &ts, &value, &history_in, &steps, &steps_num,
-			message->data);
-
-	zbx_variant_copy(&value_start, &value);
+	zbx_variant_copy(&value_start, value);
 	results = (zbx_preproc_result_t *)zbx_malloc(NULL, sizeof(zbx_preproc_result_t) * steps_num);
 	memset(results, 0, sizeof(zbx_preproc_result_t) * steps_num);
 
-	if (FAIL == (ret = worker_item_preproc_execute(value_type, &value, ts, steps, steps_num, &history_in,
-			&history_out, results, &results_num, &errmsg)) && 0 != results_num)
+	if (FAIL == (ret = worker_item_preproc_execute(value_type, value, ts, steps, steps_num, history_in,
+			history_out, results, &results_num, &errmsg)) && 0 != results_num)
 	{
 		int action = results[results_num - 1].action;
 
 		if (ZBX_PREPROC_FAIL_SET_ERROR != action && ZBX_PREPROC_FAIL_FORCE_ERROR != action)
 		{
-			worker_format_error(&value_start, results, results_num, errmsg, &error);
+			worker_format_error(&value_start, results, results_num, errmsg, error);
 			zbx_free(errmsg);
 		}
 		else
-			error = errmsg;
+			*error = errmsg;
 	}
 
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
 	{
 		const char	*result;
 
-		result = (SUCCEED == ret ? zbx_variant_value_desc(&value) : error);
+		result = (SUCCEED == ret ? zbx_variant_value_desc(value) : *error);
 		zabbix_log(LOG_LEVEL_DEBUG, "%s(): %s", __func__, zbx_variant_value_desc(&value_start));
 		zabbix_log(LOG_LEVEL_DEBUG, "%s: %s %s",__func__, zbx_result_string(ret), result);
 	}
 
+	zbx_variant_clear(&value_start);
+
+	for (i = 0; i < results_num; i++)
+		zbx_variant_clear(&results[i].value);
+	zbx_free(results);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: worker_preprocess_value                                          *
+ *                                                                            *
+ * Purpose: handle item value preprocessing task                              *
+ *                                                                            *
+ * Parameters: socket  - [IN] IPC socket                                      *
+ *             message - [IN] packed preprocessing task                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_preprocess_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t *message)
+{
+	zbx_uint32_t		size = 0;
+	unsigned char		*data = NULL, value_type;
+	zbx_uint64_t		itemid;
+	zbx_variant_t		value;
+	int			steps_num;
+	char			*error = NULL;
+	zbx_timespec_t		*ts;
+	zbx_preproc_op_t	*steps;
+	zbx_vector_ptr_t	history_in, history_out;
+
+	zbx_vector_ptr_create(&history_in);
+	zbx_vector_ptr_create(&history_out);
+
+	zbx_preprocessor_unpack_task(&itemid, &value_type, &ts, &value, &history_in, &steps, &steps_num,
+			message->data);
+
+	(void)worker_preprocess_steps(value_type, &value, ts, steps, steps_num, &history_in, &history_out, &error);
+
 	size = zbx_preprocessor_pack_result(&data, &value, &history_out, error);
 	zbx_variant_clear(&value);
 	zbx_free(error);
@@ -343,12 +383,6 @@ static void	worker_preprocess_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t
 
 	zbx_free(data);
 
-	zbx_variant_clear(&value_start);
-
-	for (i = 0; i < results_num; i++)
-		zbx_variant_clear(&results[i].value);
-	zbx_free(results);
-
 	zbx_vector_ptr_clear_ext(&history_out, (zbx_clean_func_t)zbx_preproc_op_history_free);
 	zbx_vector_ptr_destroy(&history_out);
 
@@ -356,6 +390,81 @@ static void	worker_preprocess_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t
 	zbx_vector_ptr_destroy(&history_in);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: worker_preprocess_dependents                                     *
+ *                                                                            *
+ * Purpose: handle batched dependent item preprocessing task                  *
+ *                                                                            *
+ * Parameters: socket  - [IN] IPC socket                                      *
+ *             message - [IN] packed batched preprocessing task               *
+ *                                                                            *
+ * Comments: The master item value is received once and each dependent item  *
+ *           is preprocessed on its own copy of it. Results are returned in   *
+ *           a single message, in the order dependent items were received.    *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_preprocess_dependents(zbx_ipc_socket_t *socket, zbx_ipc_message_t *message)
+{
+	zbx_uint32_t			size = 0;
+	unsigned char			*data = NULL;
+	zbx_variant_t			value;
+	int				i, dependents_num;
+	zbx_timespec_t			*ts;
+	zbx_preproc_dependent_t		*dependents, *dependent;
+	zbx_preproc_dependent_result_t	*results, *result;
+
+	zbx_preprocessor_unpack_dependent_task(&ts, &value, &dependents, &dependents_num, message->data);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() dependents:%d", __func__, dependents_num);
+
+	results = (zbx_preproc_dependent_result_t *)zbx_malloc(NULL, sizeof(zbx_preproc_dependent_result_t) *
+			dependents_num);
+
+	for (i = 0; i < dependents_num; i++)
+	{
+		dependent = &dependents[i];
+		result = &results[i];
+
+		zbx_variant_copy(&result->value, &value);
+		zbx_vector_ptr_create(&result->history);
+		result->error = NULL;
+
+		(void)worker_preprocess_steps(dependent->value_type, &result->value, ts, dependent->steps,
+				dependent->steps_num, dependent->history, &result->history, &result->error);
+	}
+
+	size = zbx_preprocessor_pack_dependent_result(&data, results, dependents_num);
+
+	if (FAIL == zbx_ipc_socket_write(socket, ZBX_IPC_PREPROCESSOR_DEPENDENT_RESULT, data, size))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot send preprocessing result");
+		exit(EXIT_FAILURE);
+	}
+
+	zbx_free(data);
+
+	for (i = 0; i < dependents_num; i++)
+	{
+		zbx_variant_clear(&results[i].value);
+		zbx_free(results[i].error);
+		zbx_vector_ptr_clear_ext(&results[i].history, (zbx_clean_func_t)zbx_preproc_op_history_free);
+		zbx_vector_ptr_destroy(&results[i].history);
+
+		zbx_vector_ptr_clear_ext(dependents[i].history, (zbx_clean_func_t)zbx_preproc_op_history_free);
+		zbx_vector_ptr_destroy(dependents[i].history);
+		zbx_free(dependents[i].history);
+		zbx_free(dependents[i].steps);
+	}
+
+	zbx_free(results);
+	zbx_free(dependents);
+	zbx_variant_clear(&value);
+	zbx_free(ts);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: worker_test_value                                                *
@@ -422,12 +531,51 @@ static void	worker_test_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t *messa
 	zbx_vector_ptr_destroy(&history_in);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: worker_send_regexp_stats                                         *
+ *                                                                            *
+ * Purpose: report regular expression cache statistics increments to the     *
+ *          preprocessing manager                                             *
+ *                                                                            *
+ * Parameters: socket      - [IN] IPC socket                                  *
+ *             hits_sent   - [IN/OUT] the number of already reported hits     *
+ *             misses_sent - [IN/OUT] the number of already reported misses   *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_send_regexp_stats(zbx_ipc_socket_t *socket, zbx_uint64_t *hits_sent, zbx_uint64_t *misses_sent)
+{
+	unsigned char	data[sizeof(zbx_uint64_t) * 2], *ptr = data;
+	zbx_uint64_t	hits, misses, value;
+
+	zbx_regexp_cache_get_stats(&hits, &misses);
+
+	if (hits == *hits_sent && misses == *misses_sent)
+		return;
+
+	value = hits - *hits_sent;
+	ptr += zbx_serialize_uint64(ptr, value);
+	value = misses - *misses_sent;
+	(void)zbx_serialize_uint64(ptr, value);
+
+	if (FAIL == zbx_ipc_socket_write(socket, ZBX_IPC_PREPROCESSOR_REGEXP_STATS, data, sizeof(data)))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot send preprocessing statistics");
+		exit(EXIT_FAILURE);
+	}
+
+	*hits_sent = hits;
+	*misses_sent = misses;
+}
+
 ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 {
 	pid_t			ppid;
 	char			*error = NULL;
 	zbx_ipc_socket_t	socket;
 	zbx_ipc_message_t	message;
+	zbx_uint64_t		regexp_hits = 0, regexp_misses = 0;
+	double			time_stats = 0, time_now;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -439,13 +587,21 @@ ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 
 	zbx_ipc_message_init(&message);
 
-	if (FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN, &error))
+	if (FAIL == zbx_ipc_socket_open(&socket, zbx_preprocessor_service_name(
+			zbx_preprocessor_get_worker_shard(process_num)), SEC_PER_MIN, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
 		zbx_free(error);
 		exit(EXIT_FAILURE);
 	}
 
+	if (FAIL == zbx_ipc_socket_attach_shm(&socket, ZBX_PREPROCESSING_SHM_SIZE, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot use shared memory for preprocessing service connection: %s",
+				error);
+		zbx_free(error);
+	}
+
 	ppid = getppid();
 	zbx_ipc_socket_write(&socket, ZBX_IPC_PREPROCESSOR_WORKER, (unsigned char *)&ppid, sizeof(ppid));
 
@@ -467,19 +623,30 @@ ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 		}
 
 		update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
-		zbx_update_env(zbx_time());
+		time_now = zbx_time();
+		zbx_update_env(time_now);
 
 		switch (message.code)
 		{
 			case ZBX_IPC_PREPROCESSOR_REQUEST:
 				worker_preprocess_value(&socket, &message);
 				break;
+			case ZBX_IPC_PREPROCESSOR_DEPENDENT_REQUEST:
+				worker_preprocess_dependents(&socket, &message);
+				break;
 			case ZBX_IPC_PREPROCESSOR_TEST_REQUEST:
 				worker_test_value(&socket, &message);
 				break;
 		}
 
 		zbx_ipc_message_clean(&message);
+
+		/* regexp cache statistics are reported after the result to avoid delaying value processing */
+		if (ZBX_PREPROC_REGEXP_STATS_INTERVAL <= time_now - time_stats)
+		{
+			worker_send_regexp_stats(&socket, &regexp_hits, &regexp_misses);
+			time_stats = time_now;
+		}
 	}
 
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
@@ -44,8 +44,18 @@ zbx_packed_field_t;
 #define PACKED_FIELD(value, size)	\
 		(zbx_packed_field_t){(value), (size), (0 == (size) ? PACKED_FIELD_STRING : PACKED_FIELD_RAW)};
 
-static zbx_ipc_message_t	cached_message;
-static int			cached_values;
+/* connection to preprocessing manager shard */
+typedef struct
+{
+	zbx_ipc_socket_t	socket;
+	zbx_ipc_message_t	cached_message;	/* values cached locally before sending to manager */
+	int			cached_values;
+}
+zbx_preprocessor_shard_t;
+
+extern int	CONFIG_PREPROCMAN_FORKS;
+
+static zbx_preprocessor_shard_t	*shards = NULL;
 
 /******************************************************************************
  *                                                                            *
@@ -544,6 +554,126 @@ zbx_uint32_t	zbx_preprocessor_pack_result(unsigned char **data, zbx_variant_t *v
 	return size;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_pack_dependent_task                             *
+ *                                                                            *
+ * Purpose: pack batched dependent item preprocessing task data into a single *
+ *          buffer that can be used in IPC                                    *
+ *                                                                            *
+ * Parameters: data           - [OUT] memory buffer for packed data           *
+ *             ts             - [IN] value timestamp                          *
+ *             value          - [IN] master item value, shared by all         *
+ *                                   dependent items                          *
+ *             dependents     - [IN] dependent items                          *
+ *             dependents_num - [IN] dependent item count                     *
+ *                                                                            *
+ * Return value: size of packed data                                          *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_preprocessor_pack_dependent_task(unsigned char **data, zbx_timespec_t *ts, zbx_variant_t *value,
+		const zbx_preproc_dependent_t *dependents, int dependents_num)
+{
+	zbx_packed_field_t	*offset, *fields;
+	unsigned char		ts_marker;
+	zbx_uint32_t		size;
+	int			i, fields_num, *history_num;
+	zbx_ipc_message_t	message;
+
+	history_num = (int *)zbx_malloc(NULL, sizeof(int) * dependents_num);
+
+	/* 6 is a max field count (without dependent item fields) */
+	fields_num = 6;
+
+	for (i = 0; i < dependents_num; i++)
+	{
+		history_num[i] = (NULL != dependents[i].history ? dependents[i].history->values_num : 0);
+
+		/* 4 is a max field count (without preprocessing step and history fields) */
+		fields_num += 4 + dependents[i].steps_num * 4 + history_num[i] * 5;
+	}
+
+	fields = (zbx_packed_field_t *)zbx_malloc(NULL, fields_num * sizeof(zbx_packed_field_t));
+
+	offset = fields;
+	ts_marker = (NULL != ts);
+
+	*offset++ = PACKED_FIELD(&ts_marker, sizeof(unsigned char));
+
+	if (NULL != ts)
+	{
+		*offset++ = PACKED_FIELD(&ts->sec, sizeof(int));
+		*offset++ = PACKED_FIELD(&ts->ns, sizeof(int));
+	}
+
+	offset += preprocessor_pack_variant(offset, value);
+	*offset++ = PACKED_FIELD(&dependents_num, sizeof(int));
+
+	for (i = 0; i < dependents_num; i++)
+	{
+		*offset++ = PACKED_FIELD(&dependents[i].itemid, sizeof(zbx_uint64_t));
+		*offset++ = PACKED_FIELD(&dependents[i].value_type, sizeof(unsigned char));
+		offset += preprocessor_pack_history(offset, dependents[i].history, &history_num[i]);
+		offset += preprocessor_pack_steps(offset, dependents[i].steps, &dependents[i].steps_num);
+	}
+
+	zbx_ipc_message_init(&message);
+	size = message_pack_data(&message, fields, offset - fields);
+	*data = message.data;
+	zbx_free(fields);
+	zbx_free(history_num);
+
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_pack_dependent_result                           *
+ *                                                                            *
+ * Purpose: pack batched dependent item preprocessing results into a single   *
+ *          buffer that can be used in IPC                                    *
+ *                                                                            *
+ * Parameters: data        - [OUT] memory buffer for packed data              *
+ *             results     - [IN] the dependent item results, in the same     *
+ *                                order as dependent items were received      *
+ *             results_num - [IN] the number of results                       *
+ *                                                                            *
+ * Return value: size of packed data                                          *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_preprocessor_pack_dependent_result(unsigned char **data,
+		const zbx_preproc_dependent_result_t *results, int results_num)
+{
+	zbx_packed_field_t	*offset, *fields;
+	zbx_uint32_t		size;
+	zbx_ipc_message_t	message;
+	int			i, fields_num = 1;
+
+	/* 4 is a max field count (without history fields) */
+	for (i = 0; i < results_num; i++)
+		fields_num += 4 + results[i].history.values_num * 5;
+
+	fields = (zbx_packed_field_t *)zbx_malloc(NULL, fields_num * sizeof(zbx_packed_field_t));
+	offset = fields;
+
+	*offset++ = PACKED_FIELD(&results_num, sizeof(int));
+
+	for (i = 0; i < results_num; i++)
+	{
+		offset += preprocessor_pack_variant(offset, &results[i].value);
+		offset += preprocessor_pack_history(offset, &results[i].history, &results[i].history.values_num);
+		*offset++ = PACKED_FIELD(results[i].error, 0);
+	}
+
+	zbx_ipc_message_init(&message);
+	size = message_pack_data(&message, fields, offset - fields);
+	*data = message.data;
+
+	zbx_free(fields);
+
+	return size;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_preprocessor_pack_test_result                                *
@@ -607,22 +737,30 @@ zbx_uint32_t	zbx_preprocessor_pack_test_result(unsigned char **data, const zbx_p
  *             values_num         - [IN] the number of queued values          *
  *             values_preproc_num - [IN] the number of queued values with     *
  *                                       preprocessing steps                  *
- *             data               - [IN] IPC data buffer                      *
+ *             regexp_hits        - [IN] the number of regular expressions    *
+ *                                       found in worker caches               *
+ *             regexp_misses      - [IN] the number of regular expressions    *
+ *                                       compiled by workers                  *
  *                                                                            *
  ******************************************************************************/
-zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int values_num, int values_preproc_num)
+zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int values_num, int values_preproc_num,
+		zbx_uint64_t regexp_hits, zbx_uint64_t regexp_misses)
 {
 	unsigned char	*ptr;
 	zbx_uint32_t	data_len = 0;
 
 	zbx_serialize_prepare_value(data_len, values_num);
 	zbx_serialize_prepare_value(data_len, values_preproc_num);
+	zbx_serialize_prepare_value(data_len, regexp_hits);
+	zbx_serialize_prepare_value(data_len, regexp_misses);
 
 	*data = (unsigned char *)zbx_malloc(NULL, data_len);
 
 	ptr = *data;
 	ptr += zbx_serialize_value(ptr, values_num);
-	(void)zbx_serialize_value(ptr, values_preproc_num);
+	ptr += zbx_serialize_value(ptr, values_preproc_num);
+	ptr += zbx_serialize_value(ptr, regexp_hits);
+	(void)zbx_serialize_value(ptr, regexp_misses);
 
 	return data_len;
 }
@@ -831,6 +969,97 @@ void	zbx_preprocessor_unpack_result(zbx_variant_t *value, zbx_vector_ptr_t *hist
 	(void)zbx_deserialize_str(offset, error, value_len);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_unpack_dependent_task                           *
+ *                                                                            *
+ * Purpose: unpack batched dependent item preprocessing task data from IPC    *
+ *          data buffer                                                       *
+ *                                                                            *
+ * Parameters: ts             - [OUT] value timestamp                         *
+ *             value          - [OUT] master item value                       *
+ *             dependents     - [OUT] dependent items                         *
+ *             dependents_num - [OUT] dependent item count                    *
+ *             data           - [IN] IPC data buffer                          *
+ *                                                                            *
+ * Comments: Preprocessing step parameters reference the IPC data buffer.     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_preprocessor_unpack_dependent_task(zbx_timespec_t **ts, zbx_variant_t *value,
+		zbx_preproc_dependent_t **dependents, int *dependents_num, const unsigned char *data)
+{
+	const unsigned char	*offset = data;
+	unsigned char 		ts_marker;
+	zbx_timespec_t		*timespec = NULL;
+	int			i;
+	zbx_preproc_dependent_t	*dependent;
+
+	offset += zbx_deserialize_char(offset, &ts_marker);
+
+	if (0 != ts_marker)
+	{
+		timespec = (zbx_timespec_t *)zbx_malloc(NULL, sizeof(zbx_timespec_t));
+
+		offset += zbx_deserialize_int(offset, &timespec->sec);
+		offset += zbx_deserialize_int(offset, &timespec->ns);
+	}
+
+	*ts = timespec;
+
+	offset += preprocesser_unpack_variant(offset, value);
+	offset += zbx_deserialize_int(offset, dependents_num);
+
+	*dependents = (zbx_preproc_dependent_t *)zbx_malloc(NULL, sizeof(zbx_preproc_dependent_t) *
+			*dependents_num);
+
+	for (i = 0; i < *dependents_num; i++)
+	{
+		dependent = *dependents + i;
+
+		offset += zbx_deserialize_uint64(offset, &dependent->itemid);
+		offset += zbx_deserialize_char(offset, &dependent->value_type);
+
+		dependent->history = (zbx_vector_ptr_t *)zbx_malloc(NULL, sizeof(zbx_vector_ptr_t));
+		zbx_vector_ptr_create(dependent->history);
+		offset += preprocesser_unpack_history(offset, dependent->history);
+		offset += preprocessor_unpack_steps(offset, &dependent->steps, &dependent->steps_num);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_unpack_dependent_result                         *
+ *                                                                            *
+ * Purpose: unpack batched dependent item preprocessing results from IPC data *
+ *          buffer                                                            *
+ *                                                                            *
+ * Parameters: results     - [OUT] the dependent item results                 *
+ *             results_num - [OUT] the number of results                      *
+ *             data        - [IN] IPC data buffer                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_preprocessor_unpack_dependent_result(zbx_preproc_dependent_result_t **results, int *results_num,
+		const unsigned char *data)
+{
+	zbx_uint32_t		value_len;
+	const unsigned char	*offset = data;
+	int			i;
+
+	offset += zbx_deserialize_int(offset, results_num);
+
+	*results = (zbx_preproc_dependent_result_t *)zbx_malloc(NULL, sizeof(zbx_preproc_dependent_result_t) *
+			*results_num);
+
+	for (i = 0; i < *results_num; i++)
+	{
+		zbx_vector_ptr_create(&(*results)[i].history);
+
+		offset += preprocesser_unpack_variant(offset, &(*results)[i].value);
+		offset += preprocesser_unpack_history(offset, &(*results)[i].history);
+		offset += zbx_deserialize_str(offset, &(*results)[i].error, value_len);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_preprocessor_unpack_test_result                              *
@@ -878,15 +1107,22 @@ void	zbx_preprocessor_unpack_test_result(zbx_vector_ptr_t *results, zbx_vector_p
  * Parameters: values_num         - [OUT] the number of queued values         *
  *             values_preproc_num - [OUT] the number of queued values with    *
  *                                       preprocessing steps                  *
+ *             regexp_hits        - [OUT] the number of regular expressions   *
+ *                                        found in worker caches              *
+ *             regexp_misses      - [OUT] the number of regular expressions   *
+ *                                        compiled by workers                 *
  *             data               - [IN] IPC data buffer                      *
  *                                                                            *
  ******************************************************************************/
-void	zbx_preprocessor_unpack_diag_stats(int *values_num, int *values_preproc_num, const unsigned char *data)
+void	zbx_preprocessor_unpack_diag_stats(int *values_num, int *values_preproc_num, zbx_uint64_t *regexp_hits,
+		zbx_uint64_t *regexp_misses, const unsigned char *data)
 {
 	const unsigned char	*offset = data;
 
 	offset += zbx_deserialize_int(offset, values_num);
-	(void)zbx_deserialize_int(offset, values_preproc_num);
+	offset += zbx_deserialize_int(offset, values_preproc_num);
+	offset += zbx_deserialize_uint64(offset, regexp_hits);
+	(void)zbx_deserialize_uint64(offset, regexp_misses);
 }
 
 /******************************************************************************
@@ -937,46 +1173,166 @@ void	zbx_preprocessor_unpack_top_result(zbx_vector_ptr_t *items, const unsigned
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_service_name                                    *
+ *                                                                            *
+ * Purpose: gets IPC service name of preprocessing manager shard              *
+ *                                                                            *
+ * Parameters: shard - [IN] the shard index, starting with 0                  *
+ *                                                                            *
+ * Return value: The service name (the first shard uses the default name).    *
+ *                                                                            *
+ * Comments: The returned string is valid until the next call.                *
+ *                                                                            *
+ ******************************************************************************/
+const char	*zbx_preprocessor_service_name(int shard)
+{
+	static char	name[sizeof(ZBX_IPC_SERVICE_PREPROCESSING) + MAX_ID_LEN];
+
+	if (0 == shard)
+		return ZBX_IPC_SERVICE_PREPROCESSING;
+
+	zbx_snprintf(name, sizeof(name), "%s%d", ZBX_IPC_SERVICE_PREPROCESSING, shard + 1);
+
+	return name;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_get_shard                                       *
+ *                                                                            *
+ * Purpose: gets preprocessing manager shard responsible for the item         *
+ *                                                                            *
+ * Parameters: itemid - [IN] the item identifier                              *
+ *                                                                            *
+ * Return value: The shard index.                                             *
+ *                                                                            *
+ * Comments: Values of dependent items are produced by the shard processing   *
+ *           their master item, so all preprocessing history and ordering     *
+ *           of an item is kept within single shard.                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_preprocessor_get_shard(zbx_uint64_t itemid)
+{
+	if (1 >= CONFIG_PREPROCMAN_FORKS)
+		return 0;
+
+	return (int)(ZBX_DEFAULT_UINT64_HASH_FUNC(&itemid) % (zbx_hash_t)CONFIG_PREPROCMAN_FORKS);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_get_worker_shard                                *
+ *                                                                            *
+ * Purpose: gets preprocessing manager shard the worker is serving            *
+ *                                                                            *
+ * Parameters: worker_num - [IN] the worker process number, starting with 1   *
+ *                                                                            *
+ * Return value: The shard index.                                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_preprocessor_get_worker_shard(int worker_num)
+{
+	return (worker_num - 1) % CONFIG_PREPROCMAN_FORKS;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_get_shard                                           *
+ *                                                                            *
+ * Purpose: gets connection to preprocessing manager shard                    *
+ *                                                                            *
+ * Parameters: shard - [IN] the shard index                                   *
+ *                                                                            *
+ * Return value: The shard connection data.                                   *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_preprocessor_shard_t	*preprocessor_get_shard(int shard)
+{
+	if (NULL == shards)
+	{
+		shards = (zbx_preprocessor_shard_t *)zbx_calloc(NULL, CONFIG_PREPROCMAN_FORKS,
+				sizeof(zbx_preprocessor_shard_t));
+	}
+
+	return &shards[shard];
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_send                                                *
  *                                                                            *
  * Purpose: sends command to preprocessor manager                             *
  *                                                                            *
- * Parameters: code     - [IN] message code                                   *
+ * Parameters: shard    - [IN] the preprocessing manager shard                *
+ *             code     - [IN] message code                                   *
  *             data     - [IN] message data                                   *
  *             size     - [IN] message data size                              *
  *             response - [OUT] response message (can be NULL if response is  *
  *                              not requested)                                *
  *                                                                            *
  ******************************************************************************/
-static void	preprocessor_send(zbx_uint32_t code, unsigned char *data, zbx_uint32_t size,
+static void	preprocessor_send(int shard, zbx_uint32_t code, unsigned char *data, zbx_uint32_t size,
 		zbx_ipc_message_t *response)
 {
 	char			*error = NULL;
-	static zbx_ipc_socket_t	socket = {0};
+	zbx_ipc_socket_t	*socket = &preprocessor_get_shard(shard)->socket;
 
 	/* each process has a permanent connection to preprocessing manager */
-	if (0 == socket.fd && FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN,
-			&error))
+	if (0 == socket->fd)
 	{
-		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
-		exit(EXIT_FAILURE);
+		if (FAIL == zbx_ipc_socket_open(socket, zbx_preprocessor_service_name(shard), SEC_PER_MIN, &error))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
+			exit(EXIT_FAILURE);
+		}
+
+		if (FAIL == zbx_ipc_socket_attach_shm(socket, ZBX_PREPROCESSING_SHM_SIZE, &error))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot use shared memory for preprocessing service"
+					" connection: %s", error);
+			zbx_free(error);
+		}
 	}
 
-	if (FAIL == zbx_ipc_socket_write(&socket, code, data, size))
+	if (FAIL == zbx_ipc_socket_write(socket, code, data, size))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing service");
 		exit(EXIT_FAILURE);
 	}
 
-	if (NULL != response && FAIL == zbx_ipc_socket_read(&socket, response))
+	if (NULL != response && FAIL == zbx_ipc_socket_read(socket, response))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot receive data from preprocessing service");
 		exit(EXIT_FAILURE);
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_flush_shard                                         *
+ *                                                                            *
+ * Purpose: sends locally cached values to preprocessing manager shard        *
+ *                                                                            *
+ * Parameters: shard - [IN] the preprocessing manager shard                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_flush_shard(int shard)
+{
+	zbx_preprocessor_shard_t	*conn = &shards[shard];
+
+	if (0 < conn->cached_message.size)
+	{
+		preprocessor_send(shard, ZBX_IPC_PREPROCESSOR_REQUEST, conn->cached_message.data,
+				conn->cached_message.size, NULL);
+
+		zbx_ipc_message_clean(&conn->cached_message);
+		zbx_ipc_message_init(&conn->cached_message);
+		conn->cached_values = 0;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_preprocess_item_value                                        *
@@ -1000,15 +1356,20 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, unsigned char item_value_typ
 	zbx_preproc_item_value_t	value = {.itemid = itemid, .item_value_type = item_value_type,
 					.error = error, .item_flags = item_flags, .state = state, .ts = ts};
 	zbx_result_ptr_t			result_ptr = {.result = result};
+	zbx_preprocessor_shard_t		*conn;
+	int					shard;
 
 	value.result_ptr = &result_ptr;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	preprocessor_pack_value(&cached_message, &value);
+	shard = zbx_preprocessor_get_shard(itemid);
+	conn = preprocessor_get_shard(shard);
+
+	preprocessor_pack_value(&conn->cached_message, &value);
 
-	if (MAX_VALUES_LOCAL < ++cached_values)
-		zbx_preprocessor_flush();
+	if (MAX_VALUES_LOCAL < ++conn->cached_values)
+		preprocessor_flush_shard(shard);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -1022,14 +1383,13 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, unsigned char item_value_typ
  ******************************************************************************/
 void	zbx_preprocessor_flush(void)
 {
-	if (0 < cached_message.size)
-	{
-		preprocessor_send(ZBX_IPC_PREPROCESSOR_REQUEST, cached_message.data, cached_message.size, NULL);
+	int	i;
 
-		zbx_ipc_message_clean(&cached_message);
-		zbx_ipc_message_init(&cached_message);
-		cached_values = 0;
-	}
+	if (NULL == shards)
+		return;
+
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
+		preprocessor_flush_shard(i);
 }
 
 /******************************************************************************
@@ -1038,20 +1398,26 @@ void	zbx_preprocessor_flush(void)
  *                                                                            *
  * Purpose: get queue size (enqueued value count) of preprocessing manager    *
  *                                                                            *
- * Return value: enqueued item count                                          *
+ * Return value: enqueued item count of all manager shards                    *
  *                                                                            *
  ******************************************************************************/
 zbx_uint64_t	zbx_preprocessor_get_queue_size(void)
 {
-	zbx_uint64_t		size;
+	zbx_uint64_t		size, total = 0;
 	zbx_ipc_message_t	message;
+	int			i;
 
-	zbx_ipc_message_init(&message);
-	preprocessor_send(ZBX_IPC_PREPROCESSOR_QUEUE, NULL, 0, &message);
-	memcpy(&size, message.data, sizeof(zbx_uint64_t));
-	zbx_ipc_message_clean(&message);
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
+	{
+		zbx_ipc_message_init(&message);
+		preprocessor_send(i, ZBX_IPC_PREPROCESSOR_QUEUE, NULL, 0, &message);
+		memcpy(&size, message.data, sizeof(zbx_uint64_t));
+		zbx_ipc_message_clean(&message);
 
-	return size;
+		total += size;
+	}
+
+	return total;
 }
 
 /******************************************************************************
@@ -1177,7 +1543,8 @@ int	zbx_preprocessor_test(unsigned char value_type, const char *value, const zbx
 
 	size = preprocessor_pack_test_request(&data, value_type, value, ts, history, steps);
 
-	if (SUCCEED != zbx_ipc_async_exchange(ZBX_IPC_SERVICE_PREPROCESSING, ZBX_IPC_PREPROCESSOR_TEST_REQUEST,
+	/* any shard can process preprocessing test requests, they are not bound to items */
+	if (SUCCEED != zbx_ipc_async_exchange(zbx_preprocessor_service_name(0), ZBX_IPC_PREPROCESSOR_TEST_REQUEST,
 			SEC_PER_MIN, data, size, &result, error))
 	{
 		goto out;
@@ -1200,22 +1567,54 @@ out:
  * Purpose: get preprocessing manager diagnostic statistics                   *
  *                                                                            *
  ******************************************************************************/
-int	zbx_preprocessor_get_diag_stats(int *values_num, int *values_preproc_num, char **error)
+int	zbx_preprocessor_get_diag_stats(int *values_num, int *values_preproc_num, zbx_uint64_t *regexp_hits,
+		zbx_uint64_t *regexp_misses, char **error)
 {
 	unsigned char	*result;
+	int		i, shard_values_num, shard_values_preproc_num;
+	zbx_uint64_t	shard_regexp_hits, shard_regexp_misses;
 
-	if (SUCCEED != zbx_ipc_async_exchange(ZBX_IPC_SERVICE_PREPROCESSING, ZBX_IPC_PREPROCESSOR_DIAG_STATS,
-			SEC_PER_MIN, NULL, 0, &result, error))
+	*values_num = 0;
+	*values_preproc_num = 0;
+	*regexp_hits = 0;
+	*regexp_misses = 0;
+
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
 	{
-		return FAIL;
-	}
+		if (SUCCEED != zbx_ipc_async_exchange(zbx_preprocessor_service_name(i), ZBX_IPC_PREPROCESSOR_DIAG_STATS,
+				SEC_PER_MIN, NULL, 0, &result, error))
+		{
+			return FAIL;
+		}
 
-	zbx_preprocessor_unpack_diag_stats(values_num, values_preproc_num, result);
-	zbx_free(result);
+		zbx_preprocessor_unpack_diag_stats(&shard_values_num, &shard_values_preproc_num, &shard_regexp_hits,
+				&shard_regexp_misses, result);
+		zbx_free(result);
+
+		*values_num += shard_values_num;
+		*values_preproc_num += shard_values_preproc_num;
+		*regexp_hits += shard_regexp_hits;
+		*regexp_misses += shard_regexp_misses;
+	}
 
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preproc_sort_item_by_values_desc                                 *
+ *                                                                            *
+ * Purpose: compare item statistics by value                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	preproc_sort_item_by_values_desc(const void *d1, const void *d2)
+{
+	const zbx_preproc_item_stats_t	*i1 = *(const zbx_preproc_item_stats_t * const *)d1;
+	const zbx_preproc_item_stats_t	*i2 = *(const zbx_preproc_item_stats_t * const *)d2;
+
+	return i2->values_num - i1->values_num;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_preprocessor_get_top_items                                   *
@@ -1225,20 +1624,35 @@ int	zbx_preprocessor_get_diag_stats(int *values_num, int *values_preproc_num, ch
  ******************************************************************************/
 int	zbx_preprocessor_get_top_items(int limit, zbx_vector_ptr_t *items, char **error)
 {
-	int		ret;
+	int		ret = SUCCEED, i;
 	unsigned char	*data, *result;
 	zbx_uint32_t	data_len;
 
 	data_len = zbx_preprocessor_pack_top_items_request(&data, limit);
 
-	if (SUCCEED != (ret = zbx_ipc_async_exchange(ZBX_IPC_SERVICE_PREPROCESSING, ZBX_IPC_PREPROCESSOR_TOP_ITEMS,
-			SEC_PER_MIN, data, data_len, &result, error)))
+	/* items are partitioned between shards, so the top items are merged from top items of each shard */
+	for (i = 0; i < CONFIG_PREPROCMAN_FORKS; i++)
 	{
-		goto out;
+		if (SUCCEED != (ret = zbx_ipc_async_exchange(zbx_preprocessor_service_name(i),
+				ZBX_IPC_PREPROCESSOR_TOP_ITEMS, SEC_PER_MIN, data, data_len, &result, error)))
+		{
+			goto out;
+		}
+
+		zbx_preprocessor_unpack_top_result(items, result);
+		zbx_free(result);
 	}
 
-	zbx_preprocessor_unpack_top_result(items, result);
-	zbx_free(result);
+	if (1 < CONFIG_PREPROCMAN_FORKS)
+	{
+		zbx_vector_ptr_sort(items, preproc_sort_item_by_values_desc);
+
+		while (limit < items->values_num)
+		{
+			zbx_free(items->values[items->values_num - 1]);
+			zbx_vector_ptr_remove(items, items->values_num - 1);
+		}
+	}
 out:
 	zbx_free(data);
 
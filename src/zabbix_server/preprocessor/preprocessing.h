@@ -28,6 +28,9 @@
 
 #define ZBX_IPC_SERVICE_PREPROCESSING	"preprocessing"
 
+/* the size of shared memory rings used to exchange data with preprocessing service */
+#define ZBX_PREPROCESSING_SHM_SIZE	(ZBX_KIBIBYTE * 64)
+
 #define ZBX_IPC_PREPROCESSOR_WORKER		1
 #define ZBX_IPC_PREPROCESSOR_REQUEST		2
 #define ZBX_IPC_PREPROCESSOR_RESULT		3
@@ -38,6 +41,9 @@
 #define ZBX_IPC_PREPROCESSOR_DIAG_STATS_RESULT	8
 #define ZBX_IPC_PREPROCESSOR_TOP_ITEMS		9
 #define ZBX_IPC_PREPROCESSOR_TOP_ITEMS_RESULT	10
+#define ZBX_IPC_PREPROCESSOR_REGEXP_STATS	11
+#define ZBX_IPC_PREPROCESSOR_DEPENDENT_REQUEST	12
+#define ZBX_IPC_PREPROCESSOR_DEPENDENT_RESULT	13
 
 typedef struct {
 	AGENT_RESULT	*result;
@@ -57,18 +63,47 @@ typedef struct
 }
 zbx_preproc_item_value_t;
 
+/* dependent item data of a batched preprocessing task sharing the master item value */
+typedef struct
+{
+	zbx_uint64_t		itemid;		/* dependent item id */
+	unsigned char		value_type;	/* dependent item value type */
+	zbx_vector_ptr_t	*history;	/* preprocessing history (can be NULL when packing) */
+	zbx_preproc_op_t	*steps;		/* preprocessing steps */
+	int			steps_num;	/* number of preprocessing steps */
+}
+zbx_preproc_dependent_t;
+
+/* preprocessing result of a dependent item in a batched preprocessing task */
+typedef struct
+{
+	zbx_variant_t		value;		/* result value */
+	zbx_vector_ptr_t	history;	/* preprocessing history */
+	char			*error;		/* preprocessing error (if any) */
+}
+zbx_preproc_dependent_result_t;
+
 zbx_uint32_t	zbx_preprocessor_pack_task(unsigned char **data, zbx_uint64_t itemid, unsigned char value_type,
 		zbx_timespec_t *ts, zbx_variant_t *value, const zbx_vector_ptr_t *history,
 		const zbx_preproc_op_t *steps, int steps_num);
 zbx_uint32_t	zbx_preprocessor_pack_result(unsigned char **data, zbx_variant_t *value,
 		const zbx_vector_ptr_t *history, char *error);
 
+zbx_uint32_t	zbx_preprocessor_pack_dependent_task(unsigned char **data, zbx_timespec_t *ts, zbx_variant_t *value,
+		const zbx_preproc_dependent_t *dependents, int dependents_num);
+zbx_uint32_t	zbx_preprocessor_pack_dependent_result(unsigned char **data,
+		const zbx_preproc_dependent_result_t *results, int results_num);
+
 zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_preproc_item_value_t *value, unsigned char *data);
 void	zbx_preprocessor_unpack_task(zbx_uint64_t *itemid, unsigned char *value_type, zbx_timespec_t **ts,
 		zbx_variant_t *value, zbx_vector_ptr_t *history, zbx_preproc_op_t **steps,
 		int *steps_num, const unsigned char *data);
 void	zbx_preprocessor_unpack_result(zbx_variant_t *value, zbx_vector_ptr_t *history, char **error,
 		const unsigned char *data);
+void	zbx_preprocessor_unpack_dependent_task(zbx_timespec_t **ts, zbx_variant_t *value,
+		zbx_preproc_dependent_t **dependents, int *dependents_num, const unsigned char *data);
+void	zbx_preprocessor_unpack_dependent_result(zbx_preproc_dependent_result_t **results, int *results_num,
+		const unsigned char *data);
 
 void	zbx_preprocessor_unpack_test_request(unsigned char *value_type, char **value, zbx_timespec_t *ts,
 		zbx_vector_ptr_t *history, zbx_preproc_op_t **steps, int *steps_num, const unsigned char *data);
@@ -79,9 +114,11 @@ zbx_uint32_t	zbx_preprocessor_pack_test_result(unsigned char **data, const zbx_p
 void	zbx_preprocessor_unpack_test_result(zbx_vector_ptr_t *results, zbx_vector_ptr_t *history,
 		char **error, const unsigned char *data);
 
-zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int values_num, int values_preproc_num);
+zbx_uint32_t	zbx_preprocessor_pack_diag_stats(unsigned char **data, int values_num, int values_preproc_num,
+		zbx_uint64_t regexp_hits, zbx_uint64_t regexp_misses);
 
-void	zbx_preprocessor_unpack_diag_stats(int *values_num, int *values_preproc_num, const unsigned char *data);
+void	zbx_preprocessor_unpack_diag_stats(int *values_num, int *values_preproc_num, zbx_uint64_t *regexp_hits,
+		zbx_uint64_t *regexp_misses, const unsigned char *data);
 
 zbx_uint32_t	zbx_preprocessor_pack_top_items_request(unsigned char **data, int limit);
 
@@ -92,4 +129,8 @@ zbx_uint32_t	zbx_preprocessor_pack_top_items_result(unsigned char **data, zbx_pr
 
 void	zbx_preprocessor_unpack_top_result(zbx_vector_ptr_t *items, const unsigned char *data);
 
+const char	*zbx_preprocessor_service_name(int shard);
+int	zbx_preprocessor_get_shard(zbx_uint64_t itemid);
+int	zbx_preprocessor_get_worker_shard(int worker_num);
+
 #endif /* ZABBIX_PREPROCESSING_H */
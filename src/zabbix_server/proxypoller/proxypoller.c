@@ -239,7 +239,7 @@ static int	proxy_send_configuration(DC_PROXY *proxy)
 	zbx_json_addstring(&j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PROXY_CONFIG, ZBX_JSON_TYPE_STRING);
 	zbx_json_addobject(&j, ZBX_PROTO_TAG_DATA);
 
-	if (SUCCEED != (ret = get_proxyconfig_data(proxy->hostid, &j, &error)))
+	if (SUCCEED != (ret = get_proxyconfig_data(proxy->hostid, NULL, &j, &error)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot collect configuration data for proxy \"%s\": %s",
 				proxy->host, error);
@@ -37,10 +37,11 @@
  ******************************************************************************/
 void	send_proxyconfig(zbx_socket_t *sock, struct zbx_json_parse *jp)
 {
-	char		*error = NULL;
-	struct zbx_json	j;
-	DC_PROXY	proxy;
-	int		flags = ZBX_TCP_PROTOCOL;
+	char			*error = NULL;
+	struct zbx_json		j;
+	struct zbx_json_parse	jp_revision, *jp_revision_ptr = NULL;
+	DC_PROXY		proxy;
+	int			flags = ZBX_TCP_PROTOCOL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -66,7 +67,11 @@ void	send_proxyconfig(zbx_socket_t *sock, struct zbx_json_parse *jp)
 
 	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
 
-	if (SUCCEED != get_proxyconfig_data(proxy.hostid, &j, &error))
+	/* send only configuration changes if proxy has sent revision of its configuration */
+	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_CONFIG_REVISION, &jp_revision))
+		jp_revision_ptr = &jp_revision;
+
+	if (SUCCEED != get_proxyconfig_data(proxy.hostid, jp_revision_ptr, &j, &error))
 	{
 		zbx_send_response_ext(sock, FAIL, error, NULL, flags, CONFIG_TIMEOUT);
 		zabbix_log(LOG_LEVEL_WARNING, "cannot collect configuration data for proxy \"%s\" at \"%s\": %s",
@@ -36,11 +36,14 @@ AC_DEFUN([CONF_TESTS],[
 		tests/libs/zbxserver/Makefile
 		tests/libs/zbxprometheus/Makefile
 		tests/zabbix_server/Makefile
+		tests/zabbix_server/housekeeper/Makefile
+		tests/zabbix_server/poller/Makefile
 		tests/zabbix_server/preprocessor/Makefile
 		tests/libs/zbxcomms/Makefile
 		tests/zabbix_server/trapper/Makefile
 		tests/libs/zbxregexp/Makefile
 		tests/libs/zbxtrends/Makefile
+		tests/libs/zbxipcservice/Makefile
 		tests/mocks/Makefile
 		tests/mocks/configcache/Makefile
 		tests/mocks/valuecache/Makefile
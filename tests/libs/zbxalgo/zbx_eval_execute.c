@@ -0,0 +1,176 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+typedef struct
+{
+	zbx_uint64_t	functionid;
+	zbx_variant_t	value;
+	int		unknown_idx;
+}
+zbx_mock_function_t;
+
+static void	mock_function_free(zbx_mock_function_t *function)
+{
+	zbx_variant_clear(&function->value);
+	zbx_free(function);
+}
+
+static const zbx_variant_t	*mock_function_value(zbx_uint64_t functionid, void *data, int *unknown_idx)
+{
+	zbx_vector_ptr_t	*functions = (zbx_vector_ptr_t *)data;
+	int			i;
+
+	for (i = 0; i < functions->values_num; i++)
+	{
+		zbx_mock_function_t	*function = (zbx_mock_function_t *)functions->values[i];
+
+		if (functionid == function->functionid)
+		{
+			*unknown_idx = function->unknown_idx;
+			return &function->value;
+		}
+	}
+
+	fail_msg("Unexpected function reference {" ZBX_FS_UI64 "}", functionid);
+
+	return NULL;
+}
+
+static void	mock_read_functions(zbx_vector_ptr_t *functions)
+{
+	zbx_mock_handle_t	hfunctions, hfunction;
+	zbx_mock_error_t	err;
+	zbx_mock_function_t	*function;
+	const char		*value;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter_exists("in.functions"))
+		return;
+
+	hfunctions = zbx_mock_get_parameter_handle("in.functions");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hfunctions, &hfunction))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read function: %s", zbx_mock_error_string(err));
+
+		function = (zbx_mock_function_t *)zbx_malloc(NULL, sizeof(zbx_mock_function_t));
+		function->functionid = zbx_mock_get_object_member_uint64(hfunction, "functionid");
+		function->unknown_idx = -1;
+		value = zbx_mock_get_object_member_string(hfunction, "value");
+
+		if (0 == strncmp(value, ZBX_UNKNOWN_STR, ZBX_UNKNOWN_STR_LEN))
+		{
+			zbx_variant_set_dbl(&function->value, ZBX_UNKNOWN);
+			function->unknown_idx = atoi(value + ZBX_UNKNOWN_STR_LEN);
+		}
+		else
+		{
+			zbx_variant_set_str(&function->value, zbx_strdup(NULL, value));
+
+			if (SUCCEED != zbx_variant_convert(&function->value, zbx_mock_str_to_variant(
+					zbx_mock_get_object_member_string(hfunction, "variant"))))
+			{
+				fail_msg("Cannot convert function value \"%s\"", value);
+			}
+		}
+
+		zbx_vector_ptr_append(functions, function);
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	double			expected_value = 0.0, actual_value;
+	const char		*tmp, *expression;
+	char			actual_error[256];
+	int			expected_result, actual_result, trigger_value = 0;
+	unsigned char		*bin;
+	zbx_vector_ptr_t	functions;
+
+	ZBX_UNUSED(state);
+
+	expression = zbx_mock_get_parameter_string("in.expression");
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.trigger_value"))
+		trigger_value = (int)zbx_mock_get_parameter_uint64("in.trigger_value");
+
+	bin = zbx_eval_compile(expression);
+
+	if (0 == strcmp(zbx_mock_get_parameter_string("out.compiled"), "no"))
+	{
+		if (NULL != bin)
+			fail_msg("Expression \"%s\" was compiled while it should be left for evaluate()", expression);
+		return;
+	}
+
+	if (NULL == bin)
+		fail_msg("Cannot compile expression \"%s\"", expression);
+
+	expected_result = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return"));
+
+	zbx_vector_ptr_create(&functions);
+	mock_read_functions(&functions);
+
+	actual_result = zbx_eval_execute(bin, (unsigned char)trigger_value, mock_function_value, &functions,
+			&actual_value, actual_error, sizeof(actual_error), NULL);
+
+	zbx_free(bin);
+	zbx_vector_ptr_clear_ext(&functions, (zbx_clean_func_t)mock_function_free);
+	zbx_vector_ptr_destroy(&functions);
+
+	if (expected_result != actual_result)
+	{
+		fail_msg("Got %s instead of %s as a result. Error: %s", zbx_sysinfo_ret_string(actual_result),
+			zbx_sysinfo_ret_string(expected_result), actual_error);
+	}
+
+	if (SUCCEED != expected_result)
+	{
+		tmp = zbx_mock_get_parameter_string("out.error");
+
+		if (0 != strcmp(actual_error, tmp))
+			fail_msg("Got\n'%s' instead of\n'%s' as an error.", actual_error, tmp);
+
+		return;
+	}
+
+	tmp = zbx_mock_get_parameter_string("out.value");
+
+	if (SUCCEED != is_double(tmp, &expected_value))
+	{
+		if (0 == strcmp(tmp, ZBX_UNKNOWN_STR))
+			expected_value = ZBX_UNKNOWN;
+		else
+			fail_msg("out.value parameter \"%s\" is not double or is out of range.", tmp);
+	}
+
+	if (ZBX_UNKNOWN == expected_value)
+	{
+		if (actual_value != expected_value)
+			fail_msg("Value %f not equal expected ZBX_UNKNOWN. Error: %s", actual_value, actual_error);
+	}
+	else if (0 != zbx_double_compare(actual_value, expected_value))
+		fail_msg("Value %f not equal expected %f. Error: %s", actual_value, expected_value, actual_error);
+}
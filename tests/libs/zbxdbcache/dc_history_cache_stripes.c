@@ -0,0 +1,173 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "dbcache.h"
+#include "sysinfo.h"
+#include "mutexs.h"
+
+extern unsigned char	program_type;
+
+int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error);
+void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex);
+
+int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error)
+{
+	ZBX_UNUSED(name);
+	ZBX_UNUSED(error);
+
+	*mutex = ZBX_MUTEX_NULL;
+
+	return SUCCEED;
+}
+
+void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex)
+{
+	ZBX_UNUSED(mutex);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_mock_add_values                                               *
+ *                                                                            *
+ * Purpose: adds values from test case to the history cache                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_mock_add_values(void)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_mock_error_t	err;
+	AGENT_RESULT		result;
+	zbx_timespec_t		ts = {1000, 0};
+	zbx_uint64_t		itemid;
+	unsigned char		value_type;
+	const char		*value;
+
+	hvalues = zbx_mock_get_parameter_handle("in.values");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hvalues, &hvalue))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read value: %s", zbx_mock_error_string(err));
+
+		itemid = zbx_mock_get_object_member_uint64(hvalue, "itemid");
+		value_type = zbx_mock_str_to_value_type(zbx_mock_get_object_member_string(hvalue, "value_type"));
+		value = zbx_mock_get_object_member_string(hvalue, "value");
+
+		init_result(&result);
+		SET_STR_RESULT(&result, zbx_strdup(NULL, value));
+		dc_add_history(itemid, value_type, 0, &result, &ts, ITEM_STATE_NORMAL, NULL);
+		free_result(&result);
+
+		ts.ns++;
+	}
+
+	dc_flush_history();
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_mock_check_items                                              *
+ *                                                                            *
+ * Purpose: checks number of cached values of each item                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_mock_check_items(void)
+{
+	zbx_mock_handle_t		hitems, hitem;
+	zbx_mock_error_t		err;
+	zbx_vector_uint64_pair_t	items;
+	zbx_uint64_pair_t		pair;
+	int				i, items_num = 0;
+
+	zbx_vector_uint64_pair_create(&items);
+	zbx_hc_get_items(&items);
+
+	hitems = zbx_mock_get_parameter_handle("out.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hitems, &hitem))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(err));
+
+		pair.first = zbx_mock_get_object_member_uint64(hitem, "itemid");
+		pair.second = zbx_mock_get_object_member_uint64(hitem, "values");
+
+		for (i = 0; i < items.values_num; i++)
+		{
+			if (items.values[i].first == pair.first)
+				break;
+		}
+
+		if (i == items.values_num)
+			fail_msg("item " ZBX_FS_UI64 " is not cached", pair.first);
+
+		zbx_mock_assert_uint64_eq("number of cached item values", pair.second, items.values[i].second);
+		items_num++;
+	}
+
+	zbx_mock_assert_int_eq("number of cached items", items_num, items.values_num);
+
+	zbx_vector_uint64_pair_destroy(&items);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	char		*error = NULL;
+	zbx_uint64_t	items_num, values_num;
+
+	ZBX_UNUSED(state);
+
+	program_type = ZBX_PROGRAM_TYPE_PROXY;
+
+	CONFIG_HISTORY_CACHE_STRIPES = (int)zbx_mock_get_parameter_uint64("in.stripes");
+	CONFIG_HISTORY_CACHE_SIZE = zbx_mock_get_parameter_uint64("in.history_cache_size");
+	CONFIG_HISTORY_INDEX_CACHE_SIZE = zbx_mock_get_parameter_uint64("in.history_index_cache_size");
+
+	if (SUCCEED != init_database_cache(&error))
+		fail_msg("cannot initialize history cache: %s", error);
+
+	hc_mock_add_values();
+	hc_mock_check_items();
+
+	zbx_hc_get_diag_stats(&items_num, &values_num);
+	zbx_mock_assert_uint64_eq("diagnostic values number", zbx_mock_get_parameter_uint64("out.values"), values_num);
+
+	zbx_mock_assert_uint64_eq("history counter", zbx_mock_get_parameter_uint64("out.history_counter"),
+			*(zbx_uint64_t *)DCget_stats(ZBX_STATS_HISTORY_COUNTER));
+	zbx_mock_assert_uint64_eq("uint history counter", zbx_mock_get_parameter_uint64("out.uint_counter"),
+			*(zbx_uint64_t *)DCget_stats(ZBX_STATS_HISTORY_UINT_COUNTER));
+	zbx_mock_assert_uint64_eq("str history counter", zbx_mock_get_parameter_uint64("out.str_counter"),
+			*(zbx_uint64_t *)DCget_stats(ZBX_STATS_HISTORY_STR_COUNTER));
+
+	/* stripes split the configured size, their total must not exceed it */
+	if (CONFIG_HISTORY_CACHE_SIZE < *(zbx_uint64_t *)DCget_stats(ZBX_STATS_HISTORY_TOTAL))
+		fail_msg("history cache total size exceeds configured size");
+
+	if (CONFIG_HISTORY_CACHE_SIZE / 2 > *(zbx_uint64_t *)DCget_stats(ZBX_STATS_HISTORY_TOTAL))
+		fail_msg("history cache total size is not summed over stripes");
+
+	if (0 == *(zbx_uint64_t *)DCget_stats(ZBX_STATS_HISTORY_USED))
+		fail_msg("history cache used size is not summed over stripes");
+}
@@ -41,6 +41,9 @@
 #define ZBX_ITEM_COLLECTED		0x01
 #define ZBX_HOST_UNREACHABLE		0x02
 
+#define ZBX_SNMP_OID_TYPE_NORMAL	0
+#define ZBX_SNMP_OID_TYPE_DYNAMIC	1
+
 /* YAML fields for test set */
 #define PARAM_MONITORED	("access")
 #define PARAM_TYPE	("type")
@@ -49,6 +52,7 @@
 #define PARAM_FLAGS	("flags")
 #define PARAM_RESULT	("result")
 #define PARAM_REF	("ref")
+#define PARAM_OID	("oid")
 
 typedef struct
 {
@@ -59,6 +63,7 @@ typedef struct
 	unsigned char		flags;
 	unsigned char		result_poller_type;
 	zbx_uint32_t		test_number;
+	const char		*oid;
 }
 test_config_t;
 
@@ -94,6 +99,7 @@ static unsigned char str2pollertype(const char *str)
 		_ZBX_MKMAP(ZBX_NO_POLLER),			_ZBX_MKMAP(ZBX_POLLER_TYPE_NORMAL),
 		_ZBX_MKMAP(ZBX_POLLER_TYPE_UNREACHABLE),	_ZBX_MKMAP(ZBX_POLLER_TYPE_IPMI),
 		_ZBX_MKMAP(ZBX_POLLER_TYPE_PINGER),		_ZBX_MKMAP(ZBX_POLLER_TYPE_JAVA),
+		_ZBX_MKMAP(ZBX_POLLER_TYPE_AGENT),		_ZBX_MKMAP(ZBX_POLLER_TYPE_SNMP),
 		{ 0 }
 	};
 
@@ -152,7 +158,8 @@ static const char	*read_string(const zbx_mock_handle_t *handle, const char *read
 
 static void	read_test(const zbx_mock_handle_t *handle, test_config_t *test_config)
 {
-	const char	*str;
+	const char		*str;
+	zbx_mock_handle_t	string_handle;
 
 	str = read_string(handle, PARAM_MONITORED);
 	test_config->monitored = 0 == strcmp(str, "DIRECT") ? DIRECT : PROXY;
@@ -176,6 +183,41 @@ static void	read_test(const zbx_mock_handle_t *handle, test_config_t *test_confi
 	/* test number is for reference only */
 	str = read_string(handle, PARAM_REF);
 	test_config->test_number = (zbx_uint32_t)strtol(str, NULL, 10);
+
+	/* SNMP OID type, 'normal' or 'dynamic', is optional */
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(*handle, PARAM_OID, &string_handle) ||
+			ZBX_MOCK_SUCCESS != zbx_mock_string(string_handle, &test_config->oid))
+	{
+		test_config->oid = NULL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: add_snmp_item                                                    *
+ *                                                                            *
+ * Purpose: add SNMP item to configuration cache, SNMP pollers are only given *
+ *          items with static OIDs                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	add_snmp_item(zbx_uint64_t itemid, const char *oid)
+{
+	ZBX_DC_SNMPITEM	snmpitem;
+
+	if (NULL == config)
+	{
+		config = (ZBX_DC_CONFIG *)zbx_malloc(NULL, sizeof(ZBX_DC_CONFIG));
+		memset(config, 0, sizeof(ZBX_DC_CONFIG));
+		zbx_hashset_create(&config->snmpitems, 10, ZBX_DEFAULT_UINT64_HASH_FUNC,
+				ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	memset(&snmpitem, 0, sizeof(snmpitem));
+	snmpitem.itemid = itemid;
+	snmpitem.snmp_oid_type = (0 == strcmp(oid, "dynamic") ? ZBX_SNMP_OID_TYPE_DYNAMIC :
+			ZBX_SNMP_OID_TYPE_NORMAL);
+
+	zbx_hashset_insert(&config->snmpitems, &snmpitem, sizeof(snmpitem));
 }
 
 /******************************************************************************
@@ -186,7 +228,7 @@ static void	read_test(const zbx_mock_handle_t *handle, test_config_t *test_confi
 void	zbx_mock_test_entry(void **state)
 {
 	zbx_mock_error_t	mock_error;
-	zbx_mock_handle_t	handle, elem_handle;
+	zbx_mock_handle_t	handle, elem_handle, pollers_handle;
 	test_config_t		test_config;
 	ZBX_DC_ITEM		item;
 	ZBX_DC_HOST		host;
@@ -200,6 +242,10 @@ void	zbx_mock_test_entry(void **state)
 
 	init_test();
 
+	/* SNMP pollers are disabled by default */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_in_parameter("snmp_pollers", &pollers_handle))
+		CONFIG_SNMPPOLLER_FORKS = (int)zbx_mock_get_parameter_uint64("in.snmp_pollers");
+
 	while (ZBX_MOCK_SUCCESS == (mock_error = zbx_mock_vector_element(handle, &elem_handle)))
 	{
 		read_test(&elem_handle, &test_config);
@@ -207,6 +253,7 @@ void	zbx_mock_test_entry(void **state)
 		memset((void*)&host, 0, sizeof(host));
 		memset((void*)&item, 0, sizeof(item));
 
+		item.itemid = test_config.test_number;
 		item.type = test_config.type;
 		item.key = test_config.key;
 		item.poller_type = test_config.poller_type;
@@ -224,6 +271,9 @@ void	zbx_mock_test_entry(void **state)
 				(int)test_config.type, test_config.key, (int)test_config.poller_type,
 				(int)test_config.flags, (int)test_config.test_number);
 
+		if (NULL != test_config.oid)
+			add_snmp_item(item.itemid, test_config.oid);
+
 		DCitem_poller_type_update_test(&item, &host, test_config.flags);
 
 		zbx_mock_assert_int_eq(buffer, test_config.result_poller_type, item.poller_type);
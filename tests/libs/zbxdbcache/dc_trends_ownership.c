@@ -0,0 +1,246 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "common.h"
+#include "db.h"
+#include "dbcache.h"
+#include "mutexs.h"
+#include "zbxhistory.h"
+
+#include "dc_trends_ownership_test.h"
+
+extern unsigned char	program_type;
+
+/* the current time of test step */
+static int			mock_time;
+
+/* the trend rows inserted into database */
+static zbx_vector_uint64_pair_t	mock_trends;
+
+int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error);
+void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex);
+time_t	__wrap_time(time_t *ptr);
+void	__wrap_zbx_timespec(zbx_timespec_t *ts);
+void	__wrap_zbx_config_get(zbx_config_t *cfg, zbx_uint64_t flags);
+int	__wrap_zbx_db_insert_execute(zbx_db_insert_t *self);
+int	__wrap_DBexecute(const char *fmt, ...);
+
+int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error)
+{
+	ZBX_UNUSED(name);
+	ZBX_UNUSED(error);
+
+	*mutex = ZBX_MUTEX_NULL;
+
+	return SUCCEED;
+}
+
+void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex)
+{
+	ZBX_UNUSED(mutex);
+}
+
+time_t	__wrap_time(time_t *ptr)
+{
+	if (NULL != ptr)
+		*ptr = mock_time;
+
+	return mock_time;
+}
+
+void	__wrap_zbx_timespec(zbx_timespec_t *ts)
+{
+	ts->sec = mock_time;
+	ts->ns = 0;
+}
+
+void	__wrap_zbx_config_get(zbx_config_t *cfg, zbx_uint64_t flags)
+{
+	memset(cfg, 0, sizeof(zbx_config_t));
+	cfg->flags = flags;
+}
+
+int	__wrap_zbx_db_insert_execute(zbx_db_insert_t *self)
+{
+	int	i;
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		zbx_db_value_t		*row = (zbx_db_value_t *)self->rows.values[i];
+		zbx_uint64_pair_t	pair;
+
+		/* the trend itemid and clock */
+		pair.first = row[0].ui64;
+		pair.second = (zbx_uint64_t)row[1].i32;
+		zbx_vector_uint64_pair_append(&mock_trends, pair);
+	}
+
+	return SUCCEED;
+}
+
+int	__wrap_DBexecute(const char *fmt, ...)
+{
+	ZBX_UNUSED(fmt);
+
+	return ZBX_DB_OK;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_check_trends                                                *
+ *                                                                            *
+ * Purpose: checks the trend rows inserted during test step                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_check_trends(zbx_mock_handle_t hstep, int step)
+{
+	zbx_mock_handle_t	htrends, htrend;
+	zbx_mock_error_t	err;
+	zbx_uint64_pair_t	pair;
+	int			i, trends_num = 0;
+
+	htrends = zbx_mock_get_object_member_handle(hstep, "trends");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(htrends, &htrend))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read trend: %s", zbx_mock_error_string(err));
+
+		pair.first = zbx_mock_get_object_member_uint64(htrend, "itemid");
+		pair.second = zbx_mock_get_object_member_uint64(htrend, "clock");
+
+		for (i = 0; i < mock_trends.values_num; i++)
+		{
+			if (mock_trends.values[i].first == pair.first && mock_trends.values[i].second == pair.second)
+				break;
+		}
+
+		if (i == mock_trends.values_num)
+		{
+			fail_msg("step #%d: trend of item " ZBX_FS_UI64 " at " ZBX_FS_UI64 " was not inserted", step,
+					pair.first, pair.second);
+		}
+
+		trends_num++;
+	}
+
+	zbx_mock_assert_int_eq("number of inserted trends", trends_num, mock_trends.values_num);
+	zbx_vector_uint64_pair_clear(&mock_trends);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_process_step                                                *
+ *                                                                            *
+ * Purpose: adds values of test step to trend cache and flushes the trends    *
+ *          to database                                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_process_step(zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_mock_error_t	err;
+	ZBX_DC_HISTORY		*history = NULL;
+	int			history_num = 0, history_alloc = 0;
+
+	mock_time = (int)zbx_mock_get_object_member_uint64(hstep, "time");
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "sync", &hvalue))
+	{
+		zbx_dc_trends_test_sync();
+		return;
+	}
+
+	hvalues = zbx_mock_get_object_member_handle(hstep, "values");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hvalues, &hvalue))))
+	{
+		ZBX_DC_HISTORY	*h;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read value: %s", zbx_mock_error_string(err));
+
+		if (history_num == history_alloc)
+		{
+			history_alloc += 8;
+			history = (ZBX_DC_HISTORY *)zbx_realloc(history, sizeof(ZBX_DC_HISTORY) * history_alloc);
+		}
+
+		h = &history[history_num++];
+		memset(h, 0, sizeof(ZBX_DC_HISTORY));
+		h->itemid = zbx_mock_get_object_member_uint64(hvalue, "itemid");
+		h->ts.sec = (int)zbx_mock_get_object_member_uint64(hvalue, "clock");
+		h->value_type = ITEM_VALUE_TYPE_FLOAT;
+		h->value.dbl = atof(zbx_mock_get_object_member_string(hvalue, "value"));
+	}
+
+	zbx_dc_trends_test_update(history, history_num);
+	zbx_free(history);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_mock_error_t	err;
+	char			*error = NULL;
+	int			step = 1;
+
+	ZBX_UNUSED(state);
+
+	program_type = ZBX_PROGRAM_TYPE_SERVER;
+
+	CONFIG_HISTORY_CACHE_SIZE = 4 * ZBX_MEBIBYTE;
+	CONFIG_HISTORY_INDEX_CACHE_SIZE = ZBX_MEBIBYTE;
+	CONFIG_TRENDS_CACHE_SIZE = ZBX_MEBIBYTE;
+
+	zbx_mockdb_init();
+	zbx_vector_uint64_pair_create(&mock_trends);
+
+	if (SUCCEED != zbx_history_init(&error))
+		fail_msg("cannot initialize history storage: %s", error);
+
+	if (SUCCEED != init_database_cache(&error))
+		fail_msg("cannot initialize database cache: %s", error);
+
+	mock_time = (int)zbx_mock_get_parameter_uint64("in.time");
+	DCload_trends_ownership();
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hsteps, &hstep))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read step: %s", zbx_mock_error_string(err));
+
+		mock_process_step(hstep);
+		mock_check_trends(hstep, step++);
+	}
+
+	zbx_mock_assert_int_eq("trend ownership", (int)zbx_mock_get_parameter_uint64("out.owned_from"),
+			zbx_dc_trends_test_owned_from());
+
+	zbx_vector_uint64_pair_destroy(&mock_trends);
+	zbx_mockdb_destroy();
+}
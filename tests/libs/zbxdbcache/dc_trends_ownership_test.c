@@ -0,0 +1,46 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "dc_trends_ownership_test.h"
+
+void	zbx_dc_trends_test_update(const ZBX_DC_HISTORY *history, int history_num)
+{
+	ZBX_DC_TREND			*trends = NULL;
+	int				trends_num = 0;
+	zbx_vector_uint64_pair_t	trends_diff;
+
+	zbx_vector_uint64_pair_create(&trends_diff);
+
+	DCmass_update_trends(history, history_num, &trends, &trends_num, 0);
+	DBmass_update_trends(trends, trends_num, &trends_diff);
+	DCupdate_trends(&trends_diff);
+
+	zbx_vector_uint64_pair_destroy(&trends_diff);
+	zbx_free(trends);
+}
+
+void	zbx_dc_trends_test_sync(void)
+{
+	DCsync_trends();
+}
+
+int	zbx_dc_trends_test_owned_from(void)
+{
+	return cache->trends_owned_from;
+}
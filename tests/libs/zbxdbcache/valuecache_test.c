@@ -119,3 +119,8 @@ int	zbx_vc_get_cache_state(int *mode, zbx_uint64_t *hits, zbx_uint64_t *misses)
 
 	return SUCCEED;
 }
+
+void	zbx_vc_get_working_set(zbx_vector_vc_prefetch_item_t *items)
+{
+	vc_get_working_set(items, time(NULL));
+}
@@ -0,0 +1,215 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "common.h"
+#include "db.h"
+#define ZBX_DBCONFIG_IMPL
+#include "dbcache.h"
+#include "dbconfig.h"
+#include "dbsync.h"
+
+int	__wrap_DBtable_exists(const char *table_name);
+int	__wrap_DBtrigger_exists(const char *table_name, const char *trigger_name);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_str_in_vector                                               *
+ *                                                                            *
+ * Purpose: checks if test case string vector contains the specified value    *
+ *                                                                            *
+ ******************************************************************************/
+static int	mock_str_in_vector(const char *path, const char *value)
+{
+	zbx_mock_handle_t	hvector, hvalue;
+	zbx_mock_error_t	err;
+	const char		*str;
+
+	hvector = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hvector, &hvalue))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &str)))
+			fail_msg("cannot read \"%s\" value: %s", path, zbx_mock_error_string(err));
+
+		if (0 == strcmp(str, value))
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+int	__wrap_DBtable_exists(const char *table_name)
+{
+	return mock_str_in_vector("in.tables", table_name);
+}
+
+int	__wrap_DBtrigger_exists(const char *table_name, const char *trigger_name)
+{
+	ZBX_UNUSED(table_name);
+
+	return mock_str_in_vector("in.triggers", trigger_name);
+}
+
+static unsigned char	mock_str_to_sync_mode(const char *str)
+{
+	if (0 == strcmp(str, "init"))
+		return ZBX_DBSYNC_INIT;
+
+	if (0 == strcmp(str, "update"))
+		return ZBX_DBSYNC_UPDATE;
+
+	if (0 == strcmp(str, "full"))
+		return ZBX_SYNC_FULL;
+
+	fail_msg("unknown synchronization mode \"%s\"", str);
+
+	return ZBX_DBSYNC_INIT;
+}
+
+static unsigned char	mock_str_to_row_tag(const char *str)
+{
+	if (0 == strcmp(str, "add"))
+		return ZBX_DBSYNC_ROW_ADD;
+
+	if (0 == strcmp(str, "update"))
+		return ZBX_DBSYNC_ROW_UPDATE;
+
+	if (0 == strcmp(str, "remove"))
+		return ZBX_DBSYNC_ROW_REMOVE;
+
+	fail_msg("unknown row tag \"%s\"", str);
+
+	return ZBX_DBSYNC_ROW_NONE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_add_functions                                               *
+ *                                                                            *
+ * Purpose: adds cached functions from test case to configuration cache       *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_add_functions(ZBX_DC_CONFIG *cache)
+{
+	zbx_mock_handle_t	hfunctions, hfunction;
+	zbx_mock_error_t	err;
+	ZBX_DC_FUNCTION		function_local;
+
+	zbx_hashset_create(&cache->functions, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	hfunctions = zbx_mock_get_parameter_handle("in.functions");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hfunctions, &hfunction))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read function: %s", zbx_mock_error_string(err));
+
+		memset(&function_local, 0, sizeof(function_local));
+		function_local.functionid = zbx_mock_get_object_member_uint64(hfunction, "functionid");
+		function_local.itemid = zbx_mock_get_object_member_uint64(hfunction, "itemid");
+		function_local.triggerid = zbx_mock_get_object_member_uint64(hfunction, "triggerid");
+		function_local.function = zbx_mock_get_object_member_string(hfunction, "name");
+		function_local.parameter = zbx_mock_get_object_member_string(hfunction, "parameter");
+
+		zbx_hashset_insert(&cache->functions, &function_local, sizeof(function_local));
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_check_rows                                                  *
+ *                                                                            *
+ * Purpose: compares changeset rows with test case                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_check_rows(zbx_dbsync_t *sync)
+{
+	zbx_mock_handle_t	hrows, hrow;
+	zbx_mock_error_t	err;
+	zbx_uint64_t		rowid;
+	char			**row;
+	unsigned char		tag;
+	int			i = 0;
+
+	hrows = zbx_mock_get_parameter_handle("out.rows");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hrows, &hrow))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read row: %s", zbx_mock_error_string(err));
+
+		if (SUCCEED != zbx_dbsync_next(sync, &rowid, &row, &tag))
+			fail_msg("expected row #%d is missing from changeset", i + 1);
+
+		zbx_mock_assert_uint64_eq("row identifier", zbx_mock_get_object_member_uint64(hrow, "functionid"),
+				rowid);
+		zbx_mock_assert_int_eq("row tag", mock_str_to_row_tag(zbx_mock_get_object_member_string(hrow, "tag")),
+				tag);
+		i++;
+	}
+
+	if (SUCCEED == zbx_dbsync_next(sync, &rowid, &row, &tag))
+		fail_msg("unexpected row " ZBX_FS_UI64 " in changeset", rowid);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	ZBX_DC_CONFIG	*cache;
+	zbx_dbsync_t	sync;
+	unsigned char	mode;
+
+	ZBX_UNUSED(state);
+
+	zbx_mockdb_init();
+
+	cache = (ZBX_DC_CONFIG *)zbx_calloc(NULL, 1, sizeof(ZBX_DC_CONFIG));
+	mock_add_functions(cache);
+
+	/* changelog existence is checked by the synchronization preceding the tested one */
+	zbx_dbsync_init_env(cache);
+	zbx_dbsync_env_prepare(mock_str_to_sync_mode(zbx_mock_get_parameter_string("in.previous")));
+	zbx_dbsync_free_env();
+
+	mode = mock_str_to_sync_mode(zbx_mock_get_parameter_string("in.mode"));
+
+	zbx_dbsync_init_env(cache);
+	zbx_dbsync_env_prepare(mode);
+
+	zbx_dbsync_init(&sync, ZBX_SYNC_FULL == mode ? ZBX_DBSYNC_UPDATE : mode);
+
+	if (SUCCEED != zbx_dbsync_compare_functions(&sync))
+		fail_msg("cannot compare functions");
+
+	mock_check_rows(&sync);
+
+	zbx_dbsync_clear(&sync);
+	zbx_dbsync_env_flush_changelog();
+	zbx_dbsync_free_env();
+
+	zbx_hashset_destroy(&cache->functions);
+	zbx_free(cache);
+
+	zbx_mockdb_destroy();
+}
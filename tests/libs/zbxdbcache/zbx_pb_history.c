@@ -0,0 +1,235 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "dbcache.h"
+
+#include "mutexs.h"
+
+#include "zbx_pb_history_test.h"
+
+#define PB_VALUES_MAX	100
+
+int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error);
+void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex);
+
+int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error)
+{
+	ZBX_UNUSED(name);
+	ZBX_UNUSED(error);
+
+	*mutex = ZBX_MUTEX_NULL;
+
+	return SUCCEED;
+}
+
+void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex)
+{
+	ZBX_UNUSED(mutex);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_mock_add                                                      *
+ *                                                                            *
+ * Purpose: writes values from test step to the buffer                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_mock_add(zbx_mock_handle_t hstep, zbx_uint64_t *itemid)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hage;
+	zbx_pb_history_t	values[PB_VALUES_MAX];
+	int			values_num = 0, expected_ret, clock;
+
+	clock = (int)time(NULL);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "age", &hage))
+		clock -= (int)zbx_mock_get_object_member_uint64(hstep, "age");
+
+	hvalues = zbx_mock_get_object_member_handle(hstep, "values");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hvalues, &hvalue))))
+	{
+		zbx_pb_history_t	*h;
+
+		if (ZBX_MOCK_SUCCESS != err || PB_VALUES_MAX == values_num)
+			fail_msg("cannot read value #%d", values_num);
+
+		h = &values[values_num++];
+
+		memset(h, 0, sizeof(zbx_pb_history_t));
+		h->itemid = ++(*itemid);
+		h->clock = clock;
+		h->write_clock = clock;
+		h->source = "";
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &h->value)))
+			fail_msg("cannot read value #%d: %s", values_num, zbx_mock_error_string(err));
+	}
+
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "return"));
+	zbx_mock_assert_result_eq("zbx_pb_history_add()", expected_ret, zbx_pb_history_add(values, values_num));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_mock_send                                                     *
+ *                                                                            *
+ * Purpose: reads values from the buffer, compares them with the expected     *
+ *          values and moves the read position after them                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_mock_send(zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_mock_error_t	err;
+	zbx_pb_history_t	values[PB_VALUES_MAX];
+	int			values_num, values_max, i = 0;
+	const char		*value;
+
+	values_max = (int)zbx_mock_get_object_member_uint64(hstep, "max");
+	values_num = zbx_pb_history_get(0, values, values_max);
+
+	hvalues = zbx_mock_get_object_member_handle(hstep, "values");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hvalues, &hvalue))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &value)))
+			fail_msg("cannot read value #%d: %s", i, zbx_mock_error_string(err));
+
+		if (i >= values_num)
+			fail_msg("expected value \"%s\" was not read from buffer", value);
+
+		zbx_mock_assert_str_eq("value", value, values[i++].value);
+	}
+
+	zbx_mock_assert_int_eq("number of values", i, values_num);
+
+	if (0 != values_num)
+		zbx_pb_history_set_lastid(values[values_num - 1].id);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: pb_mock_source                                                   *
+ *                                                                            *
+ * Purpose: checks the source of history to send                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	pb_mock_source(zbx_mock_handle_t hstep)
+{
+	const char	*source;
+	zbx_uint64_t	db_maxid;
+	int		ret;
+
+	ret = zbx_pb_history_get_source(&db_maxid);
+	source = zbx_mock_get_object_member_string(hstep, "source");
+
+	if (0 == strcmp(source, "buffer"))
+	{
+		zbx_mock_assert_result_eq("zbx_pb_history_get_source()", SUCCEED, ret);
+	}
+	else if (0 == strcmp(source, "database"))
+	{
+		zbx_mock_assert_result_eq("zbx_pb_history_get_source()", FAIL, ret);
+		zbx_mock_assert_uint64_eq("database history limit", zbx_mock_get_object_member_uint64(hstep, "maxid"),
+				db_maxid);
+	}
+	else
+		fail_msg("unknown history source \"%s\"", source);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_test_entry                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_mock_error_t	err;
+	zbx_uint64_t		itemid = 0, db_batches = 0;
+	char			*error = NULL;
+	const char		*op;
+	int			step = 0, expected_ret;
+
+	ZBX_UNUSED(state);
+
+	if (SUCCEED != zbx_pb_init(NULL, zbx_mock_get_parameter_uint64("in.size"),
+			(int)zbx_mock_get_parameter_uint64("in.age"), &error))
+	{
+		fail_msg("cannot initialize proxy history buffer: %s", error);
+	}
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hsteps, &hstep))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read step #%d: %s", step, zbx_mock_error_string(err));
+
+		op = zbx_mock_get_object_member_string(hstep, "op");
+
+		if (0 == strcmp(op, "add"))
+			pb_mock_add(hstep, &itemid);
+		else if (0 == strcmp(op, "written"))
+			zbx_pb_history_db_written();
+		else if (0 == strcmp(op, "send"))
+			pb_mock_send(hstep);
+		else if (0 == strcmp(op, "source"))
+			pb_mock_source(hstep);
+		else if (0 == strcmp(op, "sent"))
+			zbx_pb_history_set_db_sent();
+		else if (0 == strcmp(op, "check"))
+		{
+			expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "return"));
+			zbx_mock_assert_result_eq("zbx_pb_history_check_overflow()", expected_ret,
+					zbx_pb_history_check_overflow(&db_batches));
+		}
+		else if (0 == strcmp(op, "reset"))
+		{
+			expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "return"));
+			zbx_mock_assert_result_eq("zbx_pb_history_reset_overflow()", expected_ret,
+					zbx_pb_history_reset_overflow(db_batches,
+					zbx_mock_get_object_member_uint64(hstep, "maxid")));
+		}
+		else if (0 == strcmp(op, "count"))
+		{
+			zbx_mock_assert_uint64_eq("zbx_pb_history_count()",
+					zbx_mock_get_object_member_uint64(hstep, "count"), zbx_pb_history_count());
+		}
+		else if (0 == strcmp(op, "corrupt"))
+			zbx_pb_test_corrupt(zbx_mock_get_object_member_uint64(hstep, "offset"));
+		else if (0 == strcmp(op, "recover"))
+			zbx_pb_test_recover();
+		else
+			fail_msg("unknown step operation \"%s\"", op);
+
+		step++;
+	}
+
+	zbx_pb_destroy();
+}
@@ -0,0 +1,32 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbx_pb_history_test.h"
+
+/* inverts a byte in buffer data area, simulating record partially written before crash */
+void	zbx_pb_test_corrupt(zbx_uint64_t offset)
+{
+	pb_data[offset % pb_header->size] ^= 0xff;
+}
+
+/* validates records as if the buffer was loaded from file */
+void	zbx_pb_test_recover(void)
+{
+	pb_recover();
+}
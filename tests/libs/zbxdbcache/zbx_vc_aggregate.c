@@ -0,0 +1,144 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+
+static int	str_to_aggregate_op(const char *str)
+{
+	if (0 == strcmp(str, "count"))
+		return ZBX_VC_AGGREGATE_COUNT;
+
+	if (0 == strcmp(str, "sum"))
+		return ZBX_VC_AGGREGATE_SUM;
+
+	if (0 == strcmp(str, "avg"))
+		return ZBX_VC_AGGREGATE_AVG;
+
+	if (0 == strcmp(str, "min"))
+		return ZBX_VC_AGGREGATE_MIN;
+
+	if (0 == strcmp(str, "max"))
+		return ZBX_VC_AGGREGATE_MAX;
+
+	if (0 == strcmp(str, "delta"))
+		return ZBX_VC_AGGREGATE_DELTA;
+
+	fail_msg("Unknown aggregate function \"%s\"", str);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_test_entry                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	char				*error = NULL;
+	const char			*expected_value;
+	int				err, seconds, count, op, values_num;
+	zbx_timespec_t			ts;
+	zbx_uint64_t			itemid, cache_hits, cache_misses, expected_hits, expected_misses;
+	unsigned char			value_type;
+	zbx_mock_handle_t		handle, hitem;
+	zbx_mock_error_t		mock_err;
+	history_value_t			value;
+	int				cache_mode;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_VALUE_CACHE_SIZE = ZBX_MEBIBYTE;
+
+	err = zbx_vc_init(&error);
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, err);
+
+	zbx_vc_enable();
+
+	zbx_vcmock_ds_init();
+
+	/* precache values */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.precache", &handle))
+	{
+		while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(handle, &hitem))))
+		{
+			zbx_vcmock_set_time(hitem, "time");
+			zbx_vcmock_get_request_params(hitem, &itemid, &value_type, &seconds, &count, &ts);
+			zbx_vc_precache_values(itemid, value_type, seconds, count, &ts);
+		}
+	}
+
+	/* perform request */
+
+	handle = zbx_mock_get_parameter_handle("in.test");
+	zbx_vcmock_set_time(handle, "time");
+	zbx_vcmock_get_request_params(handle, &itemid, &value_type, &seconds, &count, &ts);
+	op = str_to_aggregate_op(zbx_mock_get_object_member_string(handle, "function"));
+
+	err = zbx_vc_aggregate(itemid, value_type, op, seconds, count, &ts, &value, &values_num);
+	zbx_mock_assert_result_eq("zbx_vc_aggregate() return value", SUCCEED, err);
+
+	/* validate results */
+
+	zbx_mock_assert_int_eq("values_num", atoi(zbx_mock_get_parameter_string("out.values_num")), values_num);
+
+	if (0 != values_num || ZBX_VC_AGGREGATE_COUNT == op || ZBX_VC_AGGREGATE_SUM == op)
+	{
+		expected_value = zbx_mock_get_parameter_string("out.value");
+
+		if (ZBX_VC_AGGREGATE_AVG == op || (ITEM_VALUE_TYPE_FLOAT == value_type && ZBX_VC_AGGREGATE_COUNT != op))
+		{
+			zbx_mock_assert_double_eq("aggregated value", atof(expected_value), value.dbl);
+		}
+		else
+		{
+			zbx_mock_assert_uint64_eq("aggregated value", (zbx_uint64_t)strtoull(expected_value, NULL, 10),
+					value.ui64);
+		}
+	}
+
+	/* validate cache state */
+
+	zbx_vc_get_cache_state(&cache_mode, &cache_hits, &cache_misses);
+
+	if (FAIL == is_uint64(zbx_mock_get_parameter_string("out.cache.hits"), &expected_hits))
+		fail_msg("Invalid out.cache.hits value");
+	zbx_mock_assert_uint64_eq("cache.hits", expected_hits, cache_hits);
+
+	if (FAIL == is_uint64(zbx_mock_get_parameter_string("out.cache.misses"), &expected_misses))
+		fail_msg("Invalid out.cache.misses value");
+	zbx_mock_assert_uint64_eq("cache.misses", expected_misses, cache_misses);
+
+	/* cleanup */
+
+	zbx_vcmock_ds_destroy();
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+}
@@ -0,0 +1,160 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+
+static int	str_to_aggregate_op(const char *str)
+{
+	if (0 == strcmp(str, "count"))
+		return ZBX_VC_AGGREGATE_COUNT;
+
+	if (0 == strcmp(str, "sum"))
+		return ZBX_VC_AGGREGATE_SUM;
+
+	if (0 == strcmp(str, "avg"))
+		return ZBX_VC_AGGREGATE_AVG;
+
+	if (0 == strcmp(str, "min"))
+		return ZBX_VC_AGGREGATE_MIN;
+
+	if (0 == strcmp(str, "max"))
+		return ZBX_VC_AGGREGATE_MAX;
+
+	if (0 == strcmp(str, "delta"))
+		return ZBX_VC_AGGREGATE_DELTA;
+
+	if (0 == strcmp(str, "percentile"))
+		return ZBX_VC_AGGREGATE_PERCENTILE;
+
+	fail_msg("Unknown aggregate function \"%s\"", str);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_test_entry                                              *
+ *                                                                            *
+ * Comments: Each step adds the specified values to the value cache and       *
+ *           performs aggregate request. Repeated requests are served from    *
+ *           running windows, so the results check that windows are updated   *
+ *           with new values and expire old values correctly.                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	char			*error = NULL, msg[MAX_STRING_LEN];
+	const char		*expected_value;
+	int			err, seconds, count, op, values_num, step = 0;
+	zbx_timespec_t		ts;
+	zbx_uint64_t		itemid;
+	unsigned char		value_type;
+	zbx_mock_handle_t	hsteps, hstep, hvalues;
+	zbx_mock_error_t	mock_err;
+	history_value_t		value;
+	zbx_vector_ptr_t	history;
+	double			percentage;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_VALUE_CACHE_SIZE = ZBX_MEBIBYTE;
+
+	err = zbx_vc_init(&error);
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, err);
+
+	zbx_vc_enable();
+
+	zbx_vcmock_ds_init();
+	zbx_vector_ptr_create(&history);
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(hsteps, &hstep))))
+	{
+		if (ZBX_MOCK_SUCCESS != mock_err)
+			fail_msg("Cannot read step #%d: %s", step, zbx_mock_error_string(mock_err));
+
+		zbx_vcmock_set_time(hstep, "time");
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "values", &hvalues))
+		{
+			zbx_vcmock_get_dc_history(hvalues, &history);
+
+			err = zbx_vc_add_values(&history);
+			zbx_mock_assert_result_eq("zbx_vc_add_values() return value", SUCCEED, err);
+
+			zbx_vector_ptr_clear_ext(&history, zbx_vcmock_free_dc_history);
+		}
+
+		zbx_vcmock_get_request_params(hstep, &itemid, &value_type, &seconds, &count, &ts);
+		op = str_to_aggregate_op(zbx_mock_get_object_member_string(hstep, "function"));
+
+		if (ZBX_VC_AGGREGATE_PERCENTILE == op)
+		{
+			percentage = atof(zbx_mock_get_object_member_string(hstep, "percentage"));
+			err = zbx_vc_get_percentile(itemid, value_type, seconds, count, &ts, percentage, &value,
+					&values_num);
+		}
+		else
+			err = zbx_vc_aggregate(itemid, value_type, op, seconds, count, &ts, &value, &values_num);
+
+		zbx_snprintf(msg, sizeof(msg), "step #%d return value", step);
+		zbx_mock_assert_result_eq(msg, SUCCEED, err);
+
+		zbx_snprintf(msg, sizeof(msg), "step #%d values_num", step);
+		zbx_mock_assert_int_eq(msg, atoi(zbx_mock_get_object_member_string(hstep, "values_num")), values_num);
+
+		if (0 != values_num || ZBX_VC_AGGREGATE_COUNT == op || ZBX_VC_AGGREGATE_SUM == op)
+		{
+			expected_value = zbx_mock_get_object_member_string(hstep, "value");
+			zbx_snprintf(msg, sizeof(msg), "step #%d aggregated value", step);
+
+			if (ZBX_VC_AGGREGATE_AVG == op || (ITEM_VALUE_TYPE_FLOAT == value_type &&
+					ZBX_VC_AGGREGATE_COUNT != op))
+			{
+				zbx_mock_assert_double_eq(msg, atof(expected_value), value.dbl);
+			}
+			else
+			{
+				zbx_mock_assert_uint64_eq(msg, (zbx_uint64_t)strtoull(expected_value, NULL, 10),
+						value.ui64);
+			}
+		}
+
+		step++;
+	}
+
+	/* cleanup */
+
+	zbx_vector_ptr_destroy(&history);
+	zbx_vcmock_ds_destroy();
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+}
@@ -0,0 +1,200 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_mock_check_items                                              *
+ *                                                                            *
+ * Purpose: compares cached items with test case                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_mock_check_items(void)
+{
+	zbx_mock_handle_t		hitems, hitem, hstatus;
+	zbx_mock_error_t		mock_err;
+	zbx_vector_history_record_t	expected, returned;
+	zbx_timespec_t			ts;
+	zbx_uint64_t			itemid;
+	unsigned char			value_type;
+	const char			*data;
+	int				err, item_status, item_active_range, item_values_total, item_db_cached_from;
+
+	zbx_history_record_vector_create(&expected);
+	zbx_history_record_vector_create(&returned);
+
+	hitems = zbx_mock_get_parameter_handle("out.cache.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(hitems, &hitem))))
+	{
+		if (ZBX_MOCK_SUCCESS != mock_err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(mock_err));
+
+		itemid = zbx_mock_get_object_member_uint64(hitem, "itemid");
+
+		err = zbx_vc_get_item_state(itemid, &item_status, &item_active_range, &item_values_total,
+				&item_db_cached_from);
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hitem, "status", &hstatus))
+		{
+			zbx_mock_assert_result_eq("zbx_vc_get_item_state() return value", FAIL, err);
+			continue;
+		}
+
+		zbx_mock_assert_result_eq("zbx_vc_get_item_state() return value", SUCCEED, err);
+
+		if (ZBX_MOCK_SUCCESS != (mock_err = zbx_mock_string(hstatus, &data)))
+			fail_msg("Cannot read item status: %s", zbx_mock_error_string(mock_err));
+
+		zbx_mock_assert_int_eq("item.status", zbx_vcmock_str_to_item_status(data), item_status);
+		zbx_mock_assert_int_eq("item.active_range",
+				atoi(zbx_mock_get_object_member_string(hitem, "active_range")), item_active_range);
+		zbx_mock_assert_int_eq("item.values_total",
+				atoi(zbx_mock_get_object_member_string(hitem, "values_total")), item_values_total);
+
+		if (ZBX_MOCK_SUCCESS != (mock_err = zbx_strtime_to_timespec(
+				zbx_mock_get_object_member_string(hitem, "db_cached_from"), &ts)))
+		{
+			fail_msg("Cannot read item db_cached_from timestamp: %s", zbx_mock_error_string(mock_err));
+		}
+
+		zbx_mock_assert_time_eq("item.db_cached_from", ts.sec, item_db_cached_from);
+
+		value_type = zbx_mock_str_to_value_type(zbx_mock_get_object_member_string(hitem, "value type"));
+
+		zbx_vcmock_read_values(zbx_mock_get_object_member_handle(hitem, "data"), value_type, &expected);
+		zbx_vc_get_cached_values(itemid, value_type, &returned);
+
+		zbx_vcmock_check_records("Cached values", value_type, &expected, &returned);
+
+		zbx_history_record_vector_clean(&expected, value_type);
+		zbx_history_record_vector_clean(&returned, value_type);
+	}
+
+	zbx_vector_history_record_destroy(&returned);
+	zbx_vector_history_record_destroy(&expected);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_mock_check_working_set                                        *
+ *                                                                            *
+ * Purpose: compares the working set to be saved with test case              *
+ *                                                                            *
+ * Comments: The items are expected as working set file lines in any order.   *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_mock_check_working_set(void)
+{
+	zbx_vector_vc_prefetch_item_t	items;
+	zbx_vector_str_t		expected, returned;
+	zbx_mock_handle_t		hlines, hline;
+	zbx_mock_error_t		err;
+	const char			*line;
+	int				i;
+
+	zbx_vector_vc_prefetch_item_create(&items);
+	zbx_vector_str_create(&expected);
+	zbx_vector_str_create(&returned);
+
+	zbx_vc_get_working_set(&items);
+
+	for (i = 0; i < items.values_num; i++)
+	{
+		zbx_vector_str_append(&returned, zbx_dsprintf(NULL, ZBX_FS_UI64 " %d %d %d", items.values[i].itemid,
+				items.values[i].value_type, items.values[i].range, items.values[i].values_num));
+	}
+
+	hlines = zbx_mock_get_parameter_handle("out['working set']");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hlines, &hline))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != zbx_mock_string(hline, &line))
+			fail_msg("cannot read working set line");
+
+		zbx_vector_str_append(&expected, zbx_strdup(NULL, line));
+	}
+
+	zbx_vector_str_sort(&expected, ZBX_DEFAULT_STR_COMPARE_FUNC);
+	zbx_vector_str_sort(&returned, ZBX_DEFAULT_STR_COMPARE_FUNC);
+
+	zbx_mock_assert_int_eq("number of working set items", expected.values_num, returned.values_num);
+
+	for (i = 0; i < expected.values_num; i++)
+		zbx_mock_assert_str_eq("working set item", expected.values[i], returned.values[i]);
+
+	zbx_vector_str_clear_ext(&returned, zbx_str_free);
+	zbx_vector_str_clear_ext(&expected, zbx_str_free);
+	zbx_vector_str_destroy(&returned);
+	zbx_vector_str_destroy(&expected);
+	zbx_vector_vc_prefetch_item_destroy(&items);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	char			*error = NULL;
+	int			seconds, count;
+	zbx_timespec_t		ts;
+	zbx_uint64_t		itemid;
+	unsigned char		value_type;
+	zbx_mock_handle_t	handle, hitem;
+	zbx_mock_error_t	mock_err;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_VALUE_CACHE_SIZE = ZBX_MEBIBYTE;
+
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, zbx_vc_init(&error));
+
+	zbx_vc_enable();
+	zbx_vcmock_ds_init();
+
+	/* items cached before prefetching must be left as they are */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.precache", &handle))
+	{
+		while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(handle, &hitem))))
+		{
+			zbx_vcmock_set_time(hitem, "time");
+			zbx_vcmock_get_request_params(hitem, &itemid, &value_type, &seconds, &count, &ts);
+			zbx_vc_precache_values(itemid, value_type, seconds, count, &ts);
+		}
+	}
+
+	zbx_vcmock_set_time(zbx_mock_get_parameter_handle("in"), "time");
+	zbx_vc_prefetch_working_set(zbx_mock_get_parameter_string("in.file"));
+
+	vc_mock_check_items();
+	vc_mock_check_working_set();
+
+	zbx_vcmock_ds_destroy();
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+}
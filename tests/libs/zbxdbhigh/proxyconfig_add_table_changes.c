@@ -0,0 +1,141 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "common.h"
+#include "db.h"
+#include "zbxjson.h"
+#include "proxyconfig_add_table_changes_test.h"
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_check_ids                                                   *
+ *                                                                            *
+ * Purpose: compares identifiers in json array with test case                 *
+ *                                                                            *
+ * Parameters: path - [IN] the test case identifier list                      *
+ *             jp   - [IN] the json array, the first value of nested arrays   *
+ *                         is used                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_check_ids(const char *path, const struct zbx_json_parse *jp)
+{
+	zbx_mock_handle_t	hids, hid;
+	zbx_mock_error_t	err;
+	struct zbx_json_parse	jp_row;
+	const char		*p = NULL, *value;
+	char			buf[MAX_ID_LEN + 1];
+	int			i = 0;
+
+	hids = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hids, &hid))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hid, &value)))
+			fail_msg("cannot read \"%s\" element: %s", path, zbx_mock_error_string(err));
+
+		if (NULL == (p = zbx_json_next(jp, p)))
+			fail_msg("expected \"%s\" element #%d is missing", path, i + 1);
+
+		if (SUCCEED == zbx_json_brackets_open(p, &jp_row))
+			zbx_json_next_value(&jp_row, NULL, buf, sizeof(buf), NULL);
+		else
+			zbx_json_decodevalue(p, buf, sizeof(buf), NULL);
+
+		zbx_mock_assert_str_eq(path, value, buf);
+		i++;
+	}
+
+	if (NULL != zbx_json_next(jp, p))
+		fail_msg("unexpected \"%s\" elements", path);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const ZBX_TABLE		*table;
+	struct zbx_json		j, j_revision;
+	struct zbx_json_parse	jp, jp_revision, jp_table, jp_array;
+	const char		*revision;
+	int			ret;
+
+	ZBX_UNUSED(state);
+
+	zbx_mockdb_init();
+
+	if (NULL == (table = DBget_table(zbx_mock_get_parameter_string("in.table"))))
+		fail_msg("unknown table");
+
+	zbx_json_init(&j_revision, ZBX_JSON_STAT_BUF_LEN);
+
+	/* calculate the revision from proxy database if it is not given in test case */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.revision"))
+		revision = zbx_mock_get_parameter_string("in.revision");
+	else
+	{
+		get_proxyconfig_table_revision_test(&j_revision, table);
+		revision = j_revision.buffer;
+	}
+
+	if (SUCCEED != zbx_json_open(revision, &jp_revision))
+		fail_msg("invalid revision: %s", revision);
+
+	if (SUCCEED != zbx_json_open(zbx_mock_get_parameter_string("in.data"), &jp_table))
+		fail_msg("invalid table data");
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+
+	ret = proxyconfig_add_table_changes_test(&j, &jp_table, table, &jp_revision);
+	zbx_mock_assert_result_eq("proxyconfig_add_table_changes() return value",
+			zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return")), ret);
+
+	if (SUCCEED != zbx_json_open(j.buffer, &jp))
+		fail_msg("invalid output: %s", j.buffer);
+
+	/* unchanged tables are not added to output */
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter_exists("out.changed"))
+	{
+		if (SUCCEED == zbx_json_brackets_by_name(&jp, table->table, &jp_table))
+			fail_msg("unexpected table changes: %s", j.buffer);
+	}
+	else
+	{
+		if (SUCCEED != zbx_json_brackets_by_name(&jp, table->table, &jp_table))
+			fail_msg("missing table changes: %s", j.buffer);
+
+		if (SUCCEED != zbx_json_brackets_by_name(&jp_table, ZBX_PROTO_TAG_CHANGED, &jp_array))
+			fail_msg("missing changed buckets: %s", j.buffer);
+
+		mock_check_ids("out.changed", &jp_array);
+
+		if (SUCCEED != zbx_json_brackets_by_name(&jp_table, ZBX_PROTO_TAG_DATA, &jp_array))
+			fail_msg("missing table data: %s", j.buffer);
+
+		mock_check_ids("out.rows", &jp_array);
+	}
+
+	zbx_json_free(&j);
+	zbx_json_free(&j_revision);
+
+	zbx_mockdb_destroy();
+}
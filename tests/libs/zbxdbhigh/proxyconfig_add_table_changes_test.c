@@ -0,0 +1,31 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "proxyconfig_add_table_changes_test.h"
+
+int	proxyconfig_add_table_changes_test(struct zbx_json *j, const struct zbx_json_parse *jp_table,
+		const ZBX_TABLE *table, const struct zbx_json_parse *jp_revision)
+{
+	return proxyconfig_add_table_changes(j, jp_table, table, jp_revision);
+}
+
+void	get_proxyconfig_table_revision_test(struct zbx_json *j, const ZBX_TABLE *table)
+{
+	get_proxyconfig_table_revision(j, table);
+}
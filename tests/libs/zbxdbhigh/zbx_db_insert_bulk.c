@@ -0,0 +1,287 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "db.h"
+#include "zbxdb.h"
+
+#define ZBX_MOCK_BULK_MAX_FIELDS	16
+
+/* the data passed to database by bulk insert, formatted for comparison with test case */
+static zbx_vector_str_t	bulk_sql, bulk_data;
+
+#ifdef HAVE_POSTGRESQL
+int	__wrap_zbx_db_copy(const char *sql, const char *data, size_t size);
+
+int	__wrap_zbx_db_copy(const char *sql, const char *data, size_t size)
+{
+	char	*hex = NULL;
+	size_t	hex_alloc = 0, hex_offset = 0, i;
+
+	for (i = 0; i < size; i++)
+		zbx_snprintf_alloc(&hex, &hex_alloc, &hex_offset, "%02x", (unsigned char)data[i]);
+
+	zbx_vector_str_append(&bulk_sql, zbx_strdup(NULL, sql));
+	zbx_vector_str_append(&bulk_data, hex);
+
+	return ZBX_DB_OK;
+}
+#endif
+
+#if defined(HAVE_MYSQL) || defined(HAVE_ORACLE)
+static zbx_db_bind_context_t	bulk_binds[ZBX_MOCK_BULK_MAX_FIELDS];
+static int			bulk_binds_num;
+
+int	__wrap_zbx_db_statement_prepare(const char *sql);
+int	__wrap_zbx_db_bind_parameter_dyn(zbx_db_bind_context_t *context, int position, unsigned char type,
+		zbx_db_value_t **rows, int rows_num);
+void	__wrap_zbx_db_clean_bind_context(zbx_db_bind_context_t *context);
+int	__wrap_zbx_db_statement_execute(int iters);
+
+int	__wrap_zbx_db_statement_prepare(const char *sql)
+{
+	zbx_vector_str_append(&bulk_sql, zbx_strdup(NULL, sql));
+	bulk_binds_num = 0;
+
+	return ZBX_DB_OK;
+}
+
+int	__wrap_zbx_db_bind_parameter_dyn(zbx_db_bind_context_t *context, int position, unsigned char type,
+		zbx_db_value_t **rows, int rows_num)
+{
+	ZBX_UNUSED(rows_num);
+
+	if (ZBX_MOCK_BULK_MAX_FIELDS <= position)
+		fail_msg("too many bound fields");
+
+	context->position = position;
+	context->type = type;
+	context->rows = rows;
+	context->data = NULL;
+
+	bulk_binds[position] = *context;
+	bulk_binds_num = MAX(bulk_binds_num, position + 1);
+
+	return ZBX_DB_OK;
+}
+
+void	__wrap_zbx_db_clean_bind_context(zbx_db_bind_context_t *context)
+{
+	ZBX_UNUSED(context);
+}
+
+int	__wrap_zbx_db_statement_execute(int iters)
+{
+	char		*values = NULL;
+	size_t		values_alloc = 0, values_offset = 0;
+	int		i, j;
+	zbx_db_value_t	*value;
+
+	for (i = 0; i < iters; i++)
+	{
+		for (j = 0; j < bulk_binds_num; j++)
+		{
+			zbx_strcpy_alloc(&values, &values_alloc, &values_offset, 0 == j ? (0 == i ? "(" : ",(") : ",");
+			value = &bulk_binds[j].rows[i][j];
+
+			switch (bulk_binds[j].type)
+			{
+				case ZBX_TYPE_ID:
+					if (0 == value->ui64)
+					{
+						zbx_strcpy_alloc(&values, &values_alloc, &values_offset, "NULL");
+						break;
+					}
+					ZBX_FALLTHROUGH;
+				case ZBX_TYPE_UINT:
+					zbx_snprintf_alloc(&values, &values_alloc, &values_offset, ZBX_FS_UI64, value->ui64);
+					break;
+				case ZBX_TYPE_INT:
+					zbx_snprintf_alloc(&values, &values_alloc, &values_offset, "%d", value->i32);
+					break;
+				case ZBX_TYPE_FLOAT:
+					zbx_snprintf_alloc(&values, &values_alloc, &values_offset, "%.17g", value->dbl);
+					break;
+				default:
+					zbx_snprintf_alloc(&values, &values_alloc, &values_offset, "'%s'", value->str);
+					break;
+			}
+		}
+
+		zbx_chrcpy_alloc(&values, &values_alloc, &values_offset, ')');
+	}
+
+	zbx_vector_str_append(&bulk_data, values);
+
+	return iters;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_bulk_add_rows                                               *
+ *                                                                            *
+ * Purpose: adds rows from test case to the bulk insert                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_bulk_add_rows(zbx_db_insert_t *db_insert, const ZBX_FIELD **fields, int fields_num)
+{
+	zbx_mock_handle_t	hrows, hrow, hvalue;
+	zbx_mock_error_t	err;
+	zbx_db_value_t		values[ZBX_MOCK_BULK_MAX_FIELDS];
+	const zbx_db_value_t	*row[ZBX_MOCK_BULK_MAX_FIELDS];
+	const char		*value;
+	int			i;
+
+	hrows = zbx_mock_get_parameter_handle("in.rows");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hrows, &hrow))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read row: %s", zbx_mock_error_string(err));
+
+		for (i = 0; i < fields_num; i++)
+		{
+			if (ZBX_MOCK_SUCCESS != (err = zbx_mock_vector_element(hrow, &hvalue)) ||
+					ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hvalue, &value)))
+			{
+				fail_msg("cannot read field \"%s\" value: %s", fields[i]->name,
+						zbx_mock_error_string(err));
+			}
+
+			switch (fields[i]->type)
+			{
+				case ZBX_TYPE_ID:
+				case ZBX_TYPE_UINT:
+					ZBX_STR2UINT64(values[i].ui64, value);
+					break;
+				case ZBX_TYPE_INT:
+					values[i].i32 = atoi(value);
+					break;
+				case ZBX_TYPE_FLOAT:
+					values[i].dbl = atof(value);
+					break;
+				default:
+					values[i].str = (char *)value;
+			}
+
+			row[i] = &values[i];
+		}
+
+		zbx_db_insert_add_values_dyn(db_insert, row, fields_num);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_bulk_check                                                  *
+ *                                                                            *
+ * Purpose: compares the data passed to database with test case               *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_bulk_check(const char *path)
+{
+	zbx_mock_handle_t	hexpected, hstatement;
+	zbx_mock_error_t	err;
+	int			i = 0;
+	char			*data;
+
+	hexpected = zbx_mock_get_parameter_handle(path);
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hexpected, &hstatement))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read statement: %s", zbx_mock_error_string(err));
+
+		if (i >= bulk_sql.values_num)
+			fail_msg("expected statement #%d was not executed", i + 1);
+
+		zbx_mock_assert_str_eq("statement", zbx_mock_get_object_member_string(hstatement, "sql"),
+				bulk_sql.values[i]);
+
+		data = zbx_strdup(NULL, zbx_mock_get_object_member_string(hstatement, "data"));
+#ifdef HAVE_POSTGRESQL
+		/* allow splitting long hex dump of binary data over several lines */
+		zbx_remove_whitespace(data);
+#endif
+		zbx_mock_assert_str_eq("data", data, bulk_data.values[i]);
+		zbx_free(data);
+
+		i++;
+	}
+
+	zbx_mock_assert_int_eq("number of statements", i, bulk_sql.values_num);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hfields, hfield;
+	zbx_mock_error_t	err;
+	zbx_db_insert_t		db_insert;
+	const ZBX_TABLE		*table;
+	const ZBX_FIELD		*fields[ZBX_MOCK_BULK_MAX_FIELDS];
+	const char		*name;
+	int			fields_num = 0;
+
+	ZBX_UNUSED(state);
+
+#if !defined(HAVE_POSTGRESQL) && !defined(HAVE_MYSQL)
+	skip();
+#endif
+	zbx_vector_str_create(&bulk_sql);
+	zbx_vector_str_create(&bulk_data);
+
+	if (NULL == (table = DBget_table(zbx_mock_get_parameter_string("in.table"))))
+		fail_msg("unknown table");
+
+	hfields = zbx_mock_get_parameter_handle("in.fields");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hfields, &hfield))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != zbx_mock_string(hfield, &name))
+			fail_msg("cannot read field name");
+
+		if (ZBX_MOCK_BULK_MAX_FIELDS == fields_num)
+			fail_msg("too many fields");
+
+		if (NULL == (fields[fields_num++] = DBget_field(table, name)))
+			fail_msg("unknown field \"%s\"", name);
+	}
+
+	zbx_db_insert_prepare_dyn(&db_insert, table, fields, fields_num);
+	mock_bulk_add_rows(&db_insert, fields, fields_num);
+
+	zbx_mock_assert_result_eq("zbx_db_insert_execute() return value", SUCCEED, zbx_db_insert_execute(&db_insert));
+	zbx_db_insert_clean(&db_insert);
+
+#if defined(HAVE_POSTGRESQL)
+	mock_bulk_check("out.copy");
+#elif defined(HAVE_MYSQL)
+	mock_bulk_check("out.statements");
+#endif
+	zbx_vector_str_clear_ext(&bulk_sql, zbx_str_free);
+	zbx_vector_str_clear_ext(&bulk_data, zbx_str_free);
+	zbx_vector_str_destroy(&bulk_sql);
+	zbx_vector_str_destroy(&bulk_data);
+}
@@ -0,0 +1,438 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxalgo.h"
+#include "zbxhistory.h"
+#include "dbcache.h"
+#include "log.h"
+#include "mutexs.h"
+#include "history.h"
+
+#if defined(HAVE_LIBCURL)
+#	include <curl/curl.h>
+#endif
+
+#if defined(HAVE_LIBCURL) && LIBCURL_VERSION_NUM >= 0x071c00
+#	include "history_elastic_test.h"
+#endif
+
+#define ZBX_ELASTIC_TEST_TIMEOUT	10
+#define ZBX_ELASTIC_TEST_MAX_RESPONSES	8
+
+extern char	*CONFIG_HISTORY_STORAGE_URL;
+extern int	CONFIG_HISTORY_STORAGE_CONCURRENCY;
+
+typedef struct
+{
+	int		status;
+	const char	*body;
+}
+zbx_elastic_test_response_t;
+
+int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error);
+void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex);
+
+int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error)
+{
+	ZBX_UNUSED(name);
+	ZBX_UNUSED(error);
+
+	*mutex = ZBX_MUTEX_NULL;
+
+	return SUCCEED;
+}
+
+void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex)
+{
+	ZBX_UNUSED(mutex);
+}
+
+#if defined(HAVE_LIBCURL) && LIBCURL_VERSION_NUM >= 0x071c00
+
+/******************************************************************************
+ *                                                                            *
+ * Function: elastic_http_read_request                                        *
+ *                                                                            *
+ * Purpose: reads HTTP request with its body                                  *
+ *                                                                            *
+ * Return value: the request body or NULL on failure                          *
+ *                                                                            *
+ ******************************************************************************/
+static char	*elastic_http_read_request(int fd)
+{
+	char	*buf = NULL, *body, *ptr, chunk[4096];
+	size_t	buf_alloc = 0, buf_offset = 0;
+	ssize_t	n;
+	long	length = 0;
+	int	expect = 0;
+
+	while (NULL == buf || NULL == (body = strstr(buf, "\r\n\r\n")))
+	{
+		if (0 >= (n = recv(fd, chunk, sizeof(chunk), 0)))
+			goto fail;
+
+		zbx_strncpy_alloc(&buf, &buf_alloc, &buf_offset, chunk, (size_t)n);
+	}
+
+	body += 4;
+
+	for (ptr = buf; ptr < body; ptr = strstr(ptr, "\r\n") + 2)
+	{
+		if (0 == zbx_strncasecmp(ptr, "Content-Length:", ZBX_CONST_STRLEN("Content-Length:")))
+			length = atol(ptr + ZBX_CONST_STRLEN("Content-Length:"));
+		else if (0 == zbx_strncasecmp(ptr, "Expect: 100-continue", ZBX_CONST_STRLEN("Expect: 100-continue")))
+			expect = 1;
+	}
+
+	if (1 == expect && buf + buf_offset == body)
+	{
+		const char	*cont = "HTTP/1.1 100 Continue\r\n\r\n";
+
+		if (-1 == send(fd, cont, strlen(cont), 0))
+			goto fail;
+	}
+
+	while ((long)(buf + buf_offset - body) < length)
+	{
+		size_t	body_offset = body - buf;
+
+		if (0 >= (n = recv(fd, chunk, sizeof(chunk), 0)))
+			goto fail;
+
+		zbx_strncpy_alloc(&buf, &buf_alloc, &buf_offset, chunk, (size_t)n);
+		body = buf + body_offset;
+	}
+
+	body = zbx_strdup(NULL, body);
+	zbx_free(buf);
+
+	return body;
+fail:
+	zbx_free(buf);
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: elastic_http_serve                                               *
+ *                                                                            *
+ * Purpose: replies to bulk requests with the test case responses and reports *
+ *          the item identifiers of each request                              *
+ *                                                                            *
+ * Parameters: fd_listen     - [IN] the listening socket                      *
+ *             fd_out        - [IN] the pipe to write item identifiers to     *
+ *             responses     - [IN] the responses                             *
+ *             responses_num - [IN] the number of responses                   *
+ *                                                                            *
+ * Return value: exit code for the stand-in process                           *
+ *                                                                            *
+ * Comments: Item identifiers of a request are written as a comma separated   *
+ *           line.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	elastic_http_serve(int fd_listen, int fd_out, const zbx_elastic_test_response_t *responses,
+		int responses_num)
+{
+	int		i, fd;
+	char		*body, *line = NULL, *reply = NULL;
+	size_t		line_alloc = 0, line_offset, reply_alloc = 0, reply_offset;
+	const char	*ptr;
+
+	alarm(ZBX_ELASTIC_TEST_TIMEOUT);
+
+	for (i = 0; i < responses_num; i++)
+	{
+		if (-1 == (fd = accept(fd_listen, NULL, NULL)))
+			return EXIT_FAILURE;
+
+		if (NULL == (body = elastic_http_read_request(fd)))
+			return EXIT_FAILURE;
+
+		line_offset = 0;
+
+		for (ptr = body; NULL != (ptr = strstr(ptr, "\"itemid\":")); )
+		{
+			ptr += ZBX_CONST_STRLEN("\"itemid\":");
+
+			if (0 != line_offset)
+				zbx_chrcpy_alloc(&line, &line_alloc, &line_offset, ',');
+
+			zbx_strncpy_alloc(&line, &line_alloc, &line_offset, ptr, strspn(ptr, "0123456789"));
+		}
+
+		zbx_chrcpy_alloc(&line, &line_alloc, &line_offset, '\n');
+		zbx_free(body);
+
+		if (-1 == write(fd_out, line, line_offset))
+			return EXIT_FAILURE;
+
+		reply_offset = 0;
+		zbx_snprintf_alloc(&reply, &reply_alloc, &reply_offset, "HTTP/1.1 %d Test\r\n"
+				"Content-Type: application/json\r\n"
+				"Content-Length: " ZBX_FS_SIZE_T "\r\n"
+				"Connection: close\r\n\r\n%s", responses[i].status,
+				(zbx_fs_size_t)strlen(responses[i].body), responses[i].body);
+
+		if (-1 == send(fd, reply, reply_offset, 0))
+			return EXIT_FAILURE;
+
+		close(fd);
+	}
+
+	zbx_free(line);
+	zbx_free(reply);
+
+	return EXIT_SUCCESS;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: elastic_http_start                                               *
+ *                                                                            *
+ * Purpose: starts HTTP stand-in process for elasticsearch                    *
+ *                                                                            *
+ * Parameters: fd_out - [OUT] the pipe to read item identifiers from          *
+ *             port   - [OUT] the port the stand-in listens on                *
+ *                                                                            *
+ * Return value: the stand-in process identifier                              *
+ *                                                                            *
+ ******************************************************************************/
+static pid_t	elastic_http_start(int *fd_out, unsigned short *port)
+{
+	zbx_elastic_test_response_t	responses[ZBX_ELASTIC_TEST_MAX_RESPONSES];
+	zbx_mock_handle_t		hresponses, hresponse;
+	zbx_mock_error_t		err;
+	struct sockaddr_in		addr;
+	socklen_t			addr_len = sizeof(addr);
+	int				fd_listen, fds[2], responses_num = 0;
+	pid_t				pid;
+
+	hresponses = zbx_mock_get_parameter_handle("in.responses");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hresponses, &hresponse))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read response: %s", zbx_mock_error_string(err));
+
+		if (ZBX_ELASTIC_TEST_MAX_RESPONSES == responses_num)
+			fail_msg("too many responses in test case");
+
+		responses[responses_num].status = (int)zbx_mock_get_object_member_uint64(hresponse, "status");
+		responses[responses_num].body = zbx_mock_get_object_member_string(hresponse, "body");
+		responses_num++;
+	}
+
+	if (-1 == (fd_listen = socket(AF_INET, SOCK_STREAM, 0)))
+		fail_msg("cannot create socket: %s", zbx_strerror(errno));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (-1 == bind(fd_listen, (struct sockaddr *)&addr, sizeof(addr)) || -1 == listen(fd_listen, 8) ||
+			-1 == getsockname(fd_listen, (struct sockaddr *)&addr, &addr_len))
+	{
+		fail_msg("cannot listen on loopback interface: %s", zbx_strerror(errno));
+	}
+
+	if (-1 == pipe(fds))
+		fail_msg("cannot create pipe: %s", zbx_strerror(errno));
+
+	if (-1 == (pid = fork()))
+		fail_msg("cannot fork: %s", zbx_strerror(errno));
+
+	if (0 == pid)
+	{
+		close(fds[0]);
+		_exit(elastic_http_serve(fd_listen, fds[1], responses, responses_num));
+	}
+
+	close(fds[1]);
+	close(fd_listen);
+
+	*fd_out = fds[0];
+	*port = ntohs(addr.sin_port);
+
+	return pid;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: elastic_mock_add_values                                          *
+ *                                                                            *
+ * Purpose: passes values from test case to the history storage interface     *
+ *                                                                            *
+ ******************************************************************************/
+static void	elastic_mock_add_values(zbx_history_iface_t *hist)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_mock_error_t	err;
+	zbx_vector_ptr_t	history;
+	ZBX_DC_HISTORY		*h;
+	zbx_timespec_t		ts = {1600000000, 0};
+
+	zbx_vector_ptr_create(&history);
+
+	hvalues = zbx_mock_get_parameter_handle("in.values");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hvalues, &hvalue))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read value: %s", zbx_mock_error_string(err));
+
+		h = (ZBX_DC_HISTORY *)zbx_malloc(NULL, sizeof(ZBX_DC_HISTORY));
+		memset(h, 0, sizeof(ZBX_DC_HISTORY));
+		h->itemid = zbx_mock_get_object_member_uint64(hvalue, "itemid");
+		h->value_type = ITEM_VALUE_TYPE_FLOAT;
+		h->value.dbl = atof(zbx_mock_get_object_member_string(hvalue, "value"));
+		h->ts = ts;
+		h->ttl = SEC_PER_DAY;
+		zbx_vector_ptr_append(&history, h);
+
+		ts.ns++;
+	}
+
+	zbx_mock_assert_int_eq("added values", history.values_num, hist->add_values(hist, &history));
+	zbx_mock_assert_result_eq("flush() return value", SUCCEED, hist->flush(hist));
+
+	zbx_vector_ptr_clear_ext(&history, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&history);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: elastic_mock_check_requests                                      *
+ *                                                                            *
+ * Purpose: compares the item identifiers received by stand-in with test case *
+ *                                                                            *
+ ******************************************************************************/
+static void	elastic_mock_check_requests(int fd)
+{
+	zbx_mock_handle_t	hrequests, hrequest;
+	zbx_mock_error_t	err;
+	char			*data = NULL, *line, *saveptr = NULL, chunk[4096];
+	size_t			data_alloc = 0, data_offset = 0;
+	ssize_t			n;
+	const char		*expected;
+	int			i = 0;
+
+	while (0 < (n = read(fd, chunk, sizeof(chunk))))
+		zbx_strncpy_alloc(&data, &data_alloc, &data_offset, chunk, (size_t)n);
+
+	close(fd);
+
+	line = NULL != data ? strtok_r(data, "\n", &saveptr) : NULL;
+	hrequests = zbx_mock_get_parameter_handle("out.requests");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hrequests, &hrequest))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != zbx_mock_string(hrequest, &expected))
+			fail_msg("cannot read request");
+
+		if (NULL == line)
+			fail_msg("expected request #%d was not sent", i + 1);
+
+		zbx_mock_assert_str_eq("request item identifiers", expected, line);
+
+		line = strtok_r(NULL, "\n", &saveptr);
+		i++;
+	}
+
+	if (NULL != line)
+		fail_msg("unexpected request with items %s", line);
+
+	zbx_free(data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: elastic_mock_check_stats                                         *
+ *                                                                            *
+ * Purpose: compares bulk writer statistics with test case                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	elastic_mock_check_stats(void)
+{
+	zbx_history_storage_stats_t	stats;
+
+	zbx_history_get_storage_stats(&stats);
+
+	zbx_mock_assert_uint64_eq("requests", zbx_mock_get_parameter_uint64("out.stats.requests"), stats.requests);
+	zbx_mock_assert_uint64_eq("values", zbx_mock_get_parameter_uint64("out.stats.values"), stats.values);
+	zbx_mock_assert_uint64_eq("retried", zbx_mock_get_parameter_uint64("out.stats.retried"), stats.retried);
+	zbx_mock_assert_uint64_eq("rejected", zbx_mock_get_parameter_uint64("out.stats.rejected"), stats.rejected);
+	zbx_mock_assert_uint64_eq("throttled", zbx_mock_get_parameter_uint64("out.stats.throttled"),
+			stats.throttled);
+}
+
+#endif
+
+void	zbx_mock_test_entry(void **state)
+{
+#if defined(HAVE_LIBCURL) && LIBCURL_VERSION_NUM >= 0x071c00
+	zbx_history_iface_t	hist;
+	char			*error = NULL;
+	int			fd, status;
+	unsigned short		port;
+	pid_t			pid;
+
+	ZBX_UNUSED(state);
+
+	/* requests must reach the stand-in directly */
+	unsetenv("http_proxy");
+	unsetenv("HTTP_PROXY");
+	unsetenv("all_proxy");
+	unsetenv("ALL_PROXY");
+
+	pid = elastic_http_start(&fd, &port);
+
+	CONFIG_HISTORY_STORAGE_URL = zbx_dsprintf(NULL, "http://127.0.0.1:%hu", port);
+	CONFIG_HISTORY_STORAGE_CONCURRENCY = (int)zbx_mock_get_parameter_uint64("in.concurrency");
+
+	if (SUCCEED != zbx_history_elastic_init(&hist, ITEM_VALUE_TYPE_FLOAT, &error))
+		fail_msg("cannot initialize elasticsearch history storage: %s", error);
+
+	elastic_mock_add_values(&hist);
+
+	kill(pid, SIGTERM);
+	waitpid(pid, &status, 0);
+
+	elastic_mock_check_requests(fd);
+	elastic_mock_check_stats();
+
+	zbx_mock_assert_int_eq("concurrency", (int)zbx_mock_get_parameter_uint64("out.concurrency"),
+			zbx_history_elastic_test_concurrency(&hist));
+	zbx_mock_assert_int_eq("backoff", (int)zbx_mock_get_parameter_uint64("out.backoff"),
+			zbx_history_elastic_test_backoff());
+
+	hist.destroy(&hist);
+	zbx_free(CONFIG_HISTORY_STORAGE_URL);
+#else
+	ZBX_UNUSED(state);
+
+	skip();
+#endif
+}
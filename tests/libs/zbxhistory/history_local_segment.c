@@ -0,0 +1,176 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxalgo.h"
+#include "zbxhistory.h"
+
+#include "history_local_test.h"
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_read_records                                                *
+ *                                                                            *
+ * Purpose: reads history records from test case                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_read_records(zbx_mock_handle_t hrecords, unsigned char value_type,
+		zbx_vector_history_record_t *records)
+{
+	zbx_mock_handle_t	hrecord;
+	zbx_mock_error_t	err;
+	zbx_history_record_t	record;
+	const char		*value, *ts;
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hrecords, &hrecord))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read record: %s", zbx_mock_error_string(err));
+
+		value = zbx_mock_get_object_member_string(hrecord, "value");
+
+		if (ITEM_VALUE_TYPE_UINT64 == value_type)
+		{
+			if (SUCCEED != is_uint64(value, &record.value.ui64))
+				fail_msg("invalid unsigned value \"%s\"", value);
+		}
+		else
+			record.value.dbl = atof(value);
+
+		ts = zbx_mock_get_object_member_string(hrecord, "ts");
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_strtime_to_timespec(ts, &record.timestamp)))
+			fail_msg("invalid timestamp \"%s\": %s", ts, zbx_mock_error_string(err));
+
+		zbx_vector_history_record_append_ptr(records, &record);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_encode_segment                                              *
+ *                                                                            *
+ * Purpose: encodes test case blocks into segment, truncating blocks to       *
+ *          simulate partial writes                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_encode_segment(unsigned char value_type, unsigned char **segment, size_t *segment_size)
+{
+	zbx_mock_handle_t		hblocks, hblock, hsizes, hsize;
+	zbx_mock_error_t		err;
+	zbx_vector_history_record_t	records;
+	unsigned char			*data;
+	size_t				size, segment_alloc = 0;
+	zbx_uint64_t			expected_size;
+
+	zbx_history_record_vector_create(&records);
+
+	hblocks = zbx_mock_get_parameter_handle("in.blocks");
+	hsizes = zbx_mock_get_parameter_handle("out.sizes");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hblocks, &hblock))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read block: %s", zbx_mock_error_string(err));
+
+		zbx_vector_history_record_clear(&records);
+		mock_read_records(zbx_mock_get_object_member_handle(hblock, "values"), value_type, &records);
+		zbx_history_local_test_encode(value_type, &records, &data, &size);
+
+		if (ZBX_MOCK_SUCCESS != zbx_mock_vector_element(hsizes, &hsize) ||
+				ZBX_MOCK_SUCCESS != zbx_mock_uint64(hsize, &expected_size))
+		{
+			fail_msg("cannot read expected block size");
+		}
+
+		zbx_mock_assert_uint64_eq("encoded block size", expected_size, size);
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hblock, "truncate", &hsize))
+		{
+			if (ZBX_MOCK_SUCCESS != zbx_mock_uint64(hsize, &expected_size) || size < expected_size)
+				fail_msg("invalid block truncation size");
+
+			size = (size_t)expected_size;
+		}
+
+		if (*segment_size + size > segment_alloc)
+		{
+			segment_alloc = *segment_size + size;
+			*segment = (unsigned char *)zbx_realloc(*segment, segment_alloc);
+		}
+
+		memcpy(*segment + *segment_size, data, size);
+		*segment_size += size;
+
+		zbx_free(data);
+	}
+
+	zbx_history_record_vector_destroy(&records, value_type);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_vector_history_record_t	expected, returned;
+	unsigned char			value_type, *segment = NULL;
+	size_t				segment_size = 0;
+	int				i;
+	char				buffer[MAX_STRING_LEN];
+
+	ZBX_UNUSED(state);
+
+	value_type = zbx_mock_str_to_value_type(zbx_mock_get_parameter_string("in.value_type"));
+
+	zbx_history_record_vector_create(&expected);
+	zbx_history_record_vector_create(&returned);
+
+	mock_encode_segment(value_type, &segment, &segment_size);
+
+	zbx_history_local_test_decode(value_type, segment, segment_size,
+			(int)zbx_mock_get_parameter_uint64("in.start"), (int)zbx_mock_get_parameter_uint64("in.end"),
+			&returned);
+
+	mock_read_records(zbx_mock_get_parameter_handle("out.values"), value_type, &expected);
+
+	zbx_vector_history_record_sort(&returned, (zbx_compare_func_t)zbx_history_record_compare_desc_func);
+	zbx_vector_history_record_sort(&expected, (zbx_compare_func_t)zbx_history_record_compare_desc_func);
+
+	zbx_mock_assert_int_eq("number of decoded values", expected.values_num, returned.values_num);
+
+	for (i = 0; i < expected.values_num; i++)
+	{
+		zbx_snprintf(buffer, sizeof(buffer), "value #%d timestamp", i);
+		zbx_mock_assert_timespec_eq(buffer, &expected.values[i].timestamp, &returned.values[i].timestamp);
+
+		zbx_snprintf(buffer, sizeof(buffer), "value #%d", i);
+
+		if (ITEM_VALUE_TYPE_UINT64 == value_type)
+			zbx_mock_assert_uint64_eq(buffer, expected.values[i].value.ui64, returned.values[i].value.ui64);
+		else
+			zbx_mock_assert_double_eq(buffer, expected.values[i].value.dbl, returned.values[i].value.dbl);
+	}
+
+	zbx_free(segment);
+	zbx_history_record_vector_destroy(&returned, value_type);
+	zbx_history_record_vector_destroy(&expected, value_type);
+}
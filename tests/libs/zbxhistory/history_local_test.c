@@ -0,0 +1,49 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "history_local_test.h"
+
+void	zbx_history_local_test_encode(unsigned char value_type, const zbx_vector_history_record_t *records,
+		unsigned char **data, size_t *size)
+{
+	zbx_local_writer_t	writer = {NULL, 0, 0};
+	zbx_local_value_t	*values;
+	int			i;
+
+	values = (zbx_local_value_t *)zbx_malloc(NULL, sizeof(zbx_local_value_t) * records->values_num);
+
+	for (i = 0; i < records->values_num; i++)
+	{
+		values[i].itemid = 0;
+		values[i].ts = records->values[i].timestamp;
+		values[i].value = records->values[i].value;
+	}
+
+	local_encode_block(&writer, value_type, values, records->values_num);
+	zbx_free(values);
+
+	*data = writer.data;
+	*size = (writer.bits + 7) / 8;
+}
+
+void	zbx_history_local_test_decode(unsigned char value_type, const unsigned char *data, size_t size, int start,
+		int end, zbx_vector_history_record_t *records)
+{
+	local_decode_segment(value_type, data, size, start, end, records);
+}
@@ -0,0 +1,28 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef HISTORY_LOCAL_TEST_H
+#define HISTORY_LOCAL_TEST_H
+
+void	zbx_history_local_test_encode(unsigned char value_type, const zbx_vector_history_record_t *records,
+		unsigned char **data, size_t *size);
+void	zbx_history_local_test_decode(unsigned char value_type, const unsigned char *data, size_t size, int start,
+		int end, zbx_vector_history_record_t *records);
+
+#endif /* HISTORY_LOCAL_TEST_H */
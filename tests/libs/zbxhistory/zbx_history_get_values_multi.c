@@ -0,0 +1,218 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "common.h"
+#include "zbxalgo.h"
+#include "zbxhistory.h"
+#include "zbxdb.h"
+#include "db.h"
+
+void	__wrap_zbx_sleep_loop(int sleeptime);
+zbx_uint64_t	__wrap_DCget_nextid(const char *table_name, int num);
+int	__wrap_zbx_host_availability_is_set(const zbx_host_availability_t *ha);
+int	__wrap_zbx_add_event(unsigned char source, unsigned char object, zbx_uint64_t objectid,
+		const zbx_timespec_t *timespec, int value, const char *trigger_description,
+		const char *trigger_expression, const char *trigger_recovery_expression, unsigned char trigger_priority,
+		unsigned char trigger_type, const zbx_vector_ptr_t *trigger_tags,
+		unsigned char trigger_correlation_mode, const char *trigger_correlation_tag,
+		unsigned char trigger_value, const char *trigger_opdata, const char *error);
+int	__wrap_zbx_process_events(zbx_vector_ptr_t *trigger_diff, zbx_vector_uint64_t *triggerids_lock);
+void	__wrap_zbx_clean_events(void);
+
+void	__wrap_zbx_sleep_loop(int sleeptime)
+{
+	ZBX_UNUSED(sleeptime);
+}
+
+zbx_uint64_t	__wrap_DCget_nextid(const char *table_name, int num)
+{
+	ZBX_UNUSED(table_name);
+	ZBX_UNUSED(num);
+	return 0;
+}
+
+int	__wrap_zbx_host_availability_is_set(const zbx_host_availability_t *ha)
+{
+	ZBX_UNUSED(ha);
+	return SUCCEED;
+}
+
+int	__wrap_zbx_add_event(unsigned char source, unsigned char object, zbx_uint64_t objectid,
+		const zbx_timespec_t *timespec, int value, const char *trigger_description,
+		const char *trigger_expression, const char *trigger_recovery_expression, unsigned char trigger_priority,
+		unsigned char trigger_type, const zbx_vector_ptr_t *trigger_tags,
+		unsigned char trigger_correlation_mode, const char *trigger_correlation_tag,
+		unsigned char trigger_value, const char *trigger_opdata, const char *error)
+{
+	ZBX_UNUSED(source);
+	ZBX_UNUSED(object);
+	ZBX_UNUSED(objectid);
+	ZBX_UNUSED(timespec);
+	ZBX_UNUSED(value);
+	ZBX_UNUSED(trigger_description);
+	ZBX_UNUSED(trigger_expression);
+	ZBX_UNUSED(trigger_recovery_expression);
+	ZBX_UNUSED(trigger_priority);
+	ZBX_UNUSED(trigger_type);
+	ZBX_UNUSED(trigger_tags);
+	ZBX_UNUSED(trigger_correlation_mode);
+	ZBX_UNUSED(trigger_correlation_tag);
+	ZBX_UNUSED(trigger_value);
+	ZBX_UNUSED(trigger_opdata);
+	ZBX_UNUSED(error);
+	return SUCCEED;
+}
+
+int	__wrap_zbx_process_events(zbx_vector_ptr_t *trigger_diff, zbx_vector_uint64_t *triggerids_lock)
+{
+	ZBX_UNUSED(trigger_diff);
+	ZBX_UNUSED(triggerids_lock);
+	return SUCCEED;
+}
+
+void	__wrap_zbx_clean_events(void)
+{
+}
+
+static void	history_item_values_clean(void *data)
+{
+	zbx_history_item_values_t	*item = (zbx_history_item_values_t *)data;
+
+	zbx_vector_history_record_destroy(&item->values);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: history_mock_check_item                                          *
+ *                                                                            *
+ * Purpose: compares item values read from history with test case            *
+ *                                                                            *
+ * Comments: The values are expected as '<clock>.<ns> <value>' strings in     *
+ *           ascending timestamp order.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	history_mock_check_item(zbx_mock_handle_t hitem, int value_type, zbx_hashset_t *items)
+{
+	zbx_history_item_values_t	*item;
+	zbx_mock_handle_t		hvalues, hvalue;
+	zbx_mock_error_t		err;
+	zbx_uint64_t			itemid;
+	const char			*expected;
+	char				value[MAX_STRING_LEN], returned[MAX_STRING_LEN];
+	int				i = 0;
+
+	itemid = zbx_mock_get_object_member_uint64(hitem, "itemid");
+
+	if (NULL == (item = (zbx_history_item_values_t *)zbx_hashset_search(items, &itemid)))
+		fail_msg("item " ZBX_FS_UI64 " is not in the request", itemid);
+
+	zbx_vector_history_record_sort(&item->values, (zbx_compare_func_t)zbx_history_record_compare_asc_func);
+
+	hvalues = zbx_mock_get_object_member_handle(hitem, "values");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hvalues, &hvalue))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != zbx_mock_string(hvalue, &expected))
+			fail_msg("cannot read item " ZBX_FS_UI64 " value", itemid);
+
+		if (i >= item->values.values_num)
+			fail_msg("item " ZBX_FS_UI64 " has less values than expected", itemid);
+
+		zbx_history_value2str(value, sizeof(value), &item->values.values[i].value, value_type);
+		zbx_snprintf(returned, sizeof(returned), "%d.%d %s", item->values.values[i].timestamp.sec,
+				item->values.values[i].timestamp.ns, value);
+
+		zbx_mock_assert_str_eq("item value", expected, returned);
+		i++;
+	}
+
+	zbx_mock_assert_int_eq("number of item values", i, item->values.values_num);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	char				*error = NULL;
+	int				value_type, items_num = 0, values_num = 0;
+	zbx_hashset_t			items;
+	zbx_hashset_iter_t		iter;
+	zbx_history_item_values_t	*item, item_local;
+	zbx_mock_handle_t		hitems, hitem;
+	zbx_mock_error_t		err;
+
+	ZBX_UNUSED(state);
+
+	zbx_mockdb_init();
+
+	zbx_mock_assert_result_eq("zbx_history_init()", SUCCEED, zbx_history_init(&error));
+
+	value_type = zbx_mock_str_to_value_type(zbx_mock_get_parameter_string("in['value type']"));
+
+	zbx_hashset_create_ext(&items, 10, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			history_item_values_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+			ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hitems, &hitem))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != zbx_mock_uint64(hitem, &item_local.itemid))
+			fail_msg("cannot read itemid");
+
+		item = (zbx_history_item_values_t *)zbx_hashset_insert(&items, &item_local, sizeof(item_local));
+		zbx_vector_history_record_create(&item->values);
+	}
+
+	zbx_mock_assert_result_eq("zbx_history_get_values_multi()", SUCCEED,
+			zbx_history_get_values_multi(value_type, (int)zbx_mock_get_parameter_uint64("in.start"),
+			(int)zbx_mock_get_parameter_uint64("in.count"), (int)zbx_mock_get_parameter_uint64("in.end"),
+			&items));
+
+	hitems = zbx_mock_get_parameter_handle("out.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hitems, &hitem))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(err));
+
+		history_mock_check_item(hitem, value_type, &items);
+		items_num++;
+	}
+
+	zbx_hashset_iter_reset(&items, &iter);
+	while (NULL != (item = (zbx_history_item_values_t *)zbx_hashset_iter_next(&iter)))
+	{
+		values_num += item->values.values_num;
+		zbx_history_record_vector_clean(&item->values, value_type);
+	}
+
+	zbx_mock_assert_int_eq("number of read values", (int)zbx_mock_get_parameter_uint64("out.values"), values_num);
+	zbx_mock_assert_int_eq("number of items", items.num_data, items_num);
+
+	zbx_hashset_destroy(&items);
+
+	zbx_history_destroy();
+
+	zbx_mockdb_destroy();
+}
@@ -0,0 +1,244 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "log.h"
+#include "zbxipcservice.h"
+
+#define ZBX_IPC_SHM_TEST_SERVICE	"shm_test"
+#define ZBX_IPC_SHM_TEST_TIMEOUT	10
+#define ZBX_IPC_SHM_TEST_MAX_MESSAGES	16
+
+typedef struct
+{
+	zbx_uint32_t	request;
+	zbx_uint32_t	response;
+}
+zbx_ipc_shm_test_message_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_fill                                                     *
+ *                                                                            *
+ * Purpose: fills message data with pattern depending on message code        *
+ *                                                                            *
+ ******************************************************************************/
+static unsigned char	*ipc_shm_fill(zbx_uint32_t code, zbx_uint32_t size)
+{
+	unsigned char	*data;
+	zbx_uint32_t	i;
+
+	data = (unsigned char *)zbx_malloc(NULL, size + 1);
+
+	for (i = 0; i < size; i++)
+		data[i] = (unsigned char)(code * 31 + i);
+
+	return data;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_check                                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the message has expected code, size and pattern    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_check(const zbx_ipc_message_t *message, zbx_uint32_t code, zbx_uint32_t size)
+{
+	zbx_uint32_t	i;
+
+	if (message->code != code || message->size != size)
+		return FAIL;
+
+	for (i = 0; i < size; i++)
+	{
+		if (message->data[i] != (unsigned char)(code * 31 + i))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_shm_client                                                   *
+ *                                                                            *
+ * Purpose: writes all requests before reading responses, so the service     *
+ *          must send responses while incoming ring is being filled           *
+ *                                                                            *
+ * Return value: exit code for the client process                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_shm_client(zbx_uint32_t ring_size, const zbx_ipc_shm_test_message_t *messages, int messages_num)
+{
+	zbx_ipc_socket_t	csocket;
+	zbx_ipc_message_t	message;
+	unsigned char		*data;
+	char			*error = NULL;
+	int			i, ret = EXIT_FAILURE;
+
+	alarm(ZBX_IPC_SHM_TEST_TIMEOUT);
+
+	if (FAIL == zbx_ipc_socket_open(&csocket, ZBX_IPC_SHM_TEST_SERVICE, ZBX_IPC_SHM_TEST_TIMEOUT, &error))
+		return EXIT_FAILURE;
+
+	if (FAIL == zbx_ipc_socket_attach_shm(&csocket, ring_size, &error))
+		goto out;
+
+	for (i = 0; i < messages_num; i++)
+	{
+		data = ipc_shm_fill(i, messages[i].request);
+
+		if (FAIL == zbx_ipc_socket_write(&csocket, i, data, messages[i].request))
+		{
+			zbx_free(data);
+			goto out;
+		}
+
+		zbx_free(data);
+	}
+
+	for (i = 0; i < messages_num; i++)
+	{
+		if (FAIL == zbx_ipc_socket_read(&csocket, &message))
+			goto out;
+
+		if (FAIL == ipc_shm_check(&message, i, messages[i].response))
+		{
+			zbx_ipc_message_clean(&message);
+			goto out;
+		}
+
+		zbx_ipc_message_clean(&message);
+	}
+
+	ret = EXIT_SUCCESS;
+out:
+	zbx_free(error);
+	zbx_ipc_socket_close(&csocket);
+
+	return ret;
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_ipc_shm_test_message_t	messages[ZBX_IPC_SHM_TEST_MAX_MESSAGES];
+	zbx_mock_handle_t		hmessages, hmessage;
+	zbx_ipc_service_t		service;
+	zbx_ipc_client_t		*client;
+	zbx_ipc_message_t		*message;
+	unsigned char			*data;
+	const char			*root;
+	char				*error = NULL;
+	int				messages_num = 0, received = 0, status;
+	zbx_uint32_t			ring_size;
+	time_t				deadline;
+	pid_t				pid;
+
+	ZBX_UNUSED(state);
+
+	hmessages = zbx_mock_get_parameter_handle("in.messages");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hmessages, &hmessage))
+	{
+		if (ZBX_IPC_SHM_TEST_MAX_MESSAGES == messages_num)
+			fail_msg("too many messages in test case");
+
+		messages[messages_num].request = zbx_mock_get_object_member_uint64(hmessage, "request");
+		messages[messages_num].response = zbx_mock_get_object_member_uint64(hmessage, "response");
+		messages_num++;
+	}
+
+	ring_size = zbx_mock_get_parameter_uint64("in.ring");
+
+	/* the service root must be listed in mocked directories for stat() to succeed */
+	if (ZBX_MOCK_SUCCESS != zbx_mock_vector_element(zbx_mock_get_parameter_handle("in.directories"), &hmessage) ||
+			ZBX_MOCK_SUCCESS != zbx_mock_string(hmessage, &root))
+	{
+		fail_msg("cannot read IPC root directory");
+	}
+
+	if (-1 == mkdir(root, S_IRWXU) && EEXIST != errno)
+		fail_msg("cannot create IPC root directory \"%s\": %s", root, zbx_strerror(errno));
+
+	if (SUCCEED != zbx_ipc_service_init_env(root, &error))
+		fail_msg("cannot initialize IPC environment: %s", error);
+
+	if (SUCCEED != zbx_ipc_service_start(&service, ZBX_IPC_SHM_TEST_SERVICE, &error))
+		fail_msg("cannot start IPC service: %s", error);
+
+	if (-1 == (pid = fork()))
+		fail_msg("cannot fork: %s", zbx_strerror(errno));
+
+	if (0 == pid)
+		_exit(ipc_shm_client(ring_size, messages, messages_num));
+
+	deadline = time(NULL) + ZBX_IPC_SHM_TEST_TIMEOUT;
+
+	while (received < messages_num && time(NULL) < deadline)
+	{
+		zbx_ipc_service_recv(&service, 1, &client, &message);
+
+		if (NULL == message)
+			continue;
+
+		if (SUCCEED != ipc_shm_check(message, received, messages[received].request))
+			fail_msg("unexpected request #%d with code %u and size %u", received, message->code, message->size);
+
+		/* let the client write the next request and ring the doorbell before the response */
+		/* fills the ring - the service must not consume that doorbell while writing         */
+		usleep(100000);
+
+		data = ipc_shm_fill(received, messages[received].response);
+		zbx_mock_assert_result_eq("zbx_ipc_client_send() return value", SUCCEED,
+				zbx_ipc_client_send(client, received, data, messages[received].response));
+		zbx_free(data);
+		zbx_ipc_message_free(message);
+
+		received++;
+	}
+
+	zbx_mock_assert_int_eq("received requests", messages_num, received);
+
+	/* keep flushing responses from service event loop until client exits */
+	while (0 == waitpid(pid, &status, WNOHANG))
+	{
+		if (time(NULL) >= deadline)
+		{
+			kill(pid, SIGKILL);
+			fail_msg("client did not receive responses in time");
+		}
+
+		zbx_ipc_service_recv(&service, 1, &client, &message);
+
+		if (NULL != message)
+			fail_msg("unexpected message with code %u", message->code);
+	}
+
+	zbx_ipc_service_close(&service);
+	rmdir(root);
+
+	zbx_mock_assert_int_eq("client exit status", EXIT_SUCCESS, WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+}
@@ -55,9 +55,10 @@ void	zbx_mock_test_entry(void **state)
 {
 	const char		*data, *path;
 	struct zbx_json_parse	jp;
-	char			*output = NULL;
+	char			*output = NULL, *output_index = NULL;
 	int			expected_ret, returned_ret;
 	zbx_mock_handle_t	handle;
+	zbx_jsonpath_index_t	*index;
 
 	ZBX_UNUSED(state);
 
@@ -96,5 +97,17 @@ void	zbx_mock_test_entry(void **state)
 	else
 		zbx_mock_assert_str_ne("tzbx_jsonpath_query() error", "", zbx_json_strerror());
 
+	/* indexed query (with cached compiled jsonpath) must return the same result */
+	index = zbx_jsonpath_index_create(&jp);
+	returned_ret = zbx_jsonpath_query_index(index, path, &output_index);
+	zbx_mock_assert_result_eq("zbx_jsonpath_query_index() return value", expected_ret, returned_ret);
+
+	if (NULL == output)
+		zbx_mock_assert_ptr_eq("Indexed query result", NULL, output_index);
+	else
+		zbx_mock_assert_str_eq("Indexed query result", output, output_index);
+
+	zbx_jsonpath_index_free(index);
+	zbx_free(output_index);
 	zbx_free(output);
 }
@@ -0,0 +1,124 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxregexp.h"
+
+/******************************************************************************
+ *                                                                            *
+ * Function: regexp_fill_cache                                                *
+ *                                                                            *
+ * Purpose: compiles the specified number of other regular expressions, so    *
+ *          not pinned cache entries are evicted                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	regexp_fill_cache(int num)
+{
+	int		i, len;
+	char		pattern[32], value[32];
+	zbx_regexp_t	*regexp;
+	const char	*error = NULL;
+
+	for (i = 0; i < num; i++)
+	{
+		zbx_snprintf(value, sizeof(value), "fill%d", i);
+		zbx_snprintf(pattern, sizeof(pattern), "^%s$", value);
+
+		if (0 == i % 2)
+		{
+			zbx_mock_assert_result_eq("zbx_regexp_compile_cached() return value", SUCCEED,
+					zbx_regexp_compile_cached(pattern, &regexp, &error));
+			zbx_regexp_release(regexp);
+		}
+		else
+		{
+			zbx_mock_assert_ptr_ne("zbx_regexp_match() result", NULL,
+					zbx_regexp_match(value, pattern, &len));
+		}
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char		*pattern, *str, *error = NULL;
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_regexp_t		*regexp;
+	int			ret, expected_ret, fill;
+	zbx_uint64_t		hits, misses, misses_pinned;
+
+	ZBX_UNUSED(state);
+
+	pattern = zbx_mock_get_parameter_string("in.pattern");
+	fill = atoi(zbx_mock_get_parameter_string("in.fill"));
+	expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_parameter_string("out.return"));
+
+	ret = zbx_regexp_compile_cached(pattern, &regexp, &error);
+	zbx_mock_assert_result_eq("zbx_regexp_compile_cached() return value", expected_ret, ret);
+
+	if (FAIL == ret)
+	{
+		zbx_mock_assert_ptr_ne("compilation error", NULL, error);
+		return;
+	}
+
+	/* the pinned regexp must survive eviction of the other cached regexps */
+	regexp_fill_cache(fill);
+
+	hvalues = zbx_mock_get_parameter_handle("out.values");
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(hvalues, &hvalue))
+	{
+		str = zbx_mock_get_object_member_string(hvalue, "value");
+		expected_ret = zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hvalue, "result"));
+		ret = (0 == zbx_regexp_match_precompiled(str, regexp) ? SUCCEED : FAIL);
+
+		if (ret != expected_ret)
+		{
+			fail_msg("String \"%s\" unexpectedly %s regular expression \"%s\"",
+					str, SUCCEED == ret ? "matches" : "doesn't match", pattern);
+		}
+	}
+
+	/* the pinned regexp is still cached */
+	zbx_regexp_cache_get_stats(&hits, &misses_pinned);
+	zbx_mock_assert_result_eq("zbx_regexp_compile_cached() return value", SUCCEED,
+			zbx_regexp_compile_cached(pattern, &regexp, &error));
+	zbx_regexp_release(regexp);
+	zbx_regexp_cache_get_stats(&hits, &misses);
+	zbx_mock_assert_uint64_eq("cache misses of pinned regexp", misses_pinned, misses);
+
+	/* once released the regexp can be evicted */
+	zbx_regexp_release(regexp);
+	regexp_fill_cache(fill);
+
+	zbx_regexp_cache_get_stats(&hits, &misses);
+	zbx_mock_assert_result_eq("zbx_regexp_compile_cached() return value", SUCCEED,
+			zbx_regexp_compile_cached(pattern, &regexp, &error));
+	zbx_regexp_release(regexp);
+	zbx_regexp_cache_get_stats(&hits, &misses_pinned);
+
+	if (0 == strcmp(zbx_mock_get_parameter_string("out.released"), "evicted"))
+		misses++;
+
+	zbx_mock_assert_uint64_eq("cache misses of released regexp", misses, misses_pinned);
+}
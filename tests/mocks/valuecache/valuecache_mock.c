@@ -51,6 +51,7 @@ void	__wrap___zbx_mem_free(const char *file, int line, zbx_mem_info_t *info, voi
 void	__wrap_zbx_mem_dump_stats(int level, zbx_mem_info_t *info);
 int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
+int	__wrap_zbx_history_get_values_multi(int value_type, int start, int count, int end, zbx_hashset_t *items);
 int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history);
 int	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
 int	__wrap_zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
@@ -635,6 +636,45 @@ int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start
 	return SUCCEED;
 }
 
+int	__wrap_zbx_history_get_values_multi(int value_type, int start, int count, int end, zbx_hashset_t *items)
+{
+	zbx_hashset_iter_t		iter;
+	zbx_history_item_values_t	*hitem;
+	zbx_vcmock_ds_item_t		*item;
+	zbx_history_record_t		*rec, rec_local;
+	int				i, values_num = 0;
+
+	if (0 > start)
+		fail_msg("invalid parameters passed to zbx_history_get_values_multi function (start < 0)");
+
+	if (start >= end)
+		fail_msg("invalid parameters passed to zbx_history_get_values_multi function (start >= end)");
+
+	zbx_hashset_iter_reset(items, &iter);
+	while (NULL != (hitem = (zbx_history_item_values_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL == (item = zbx_hashset_search(&vc_ds.items, &hitem->itemid)))
+			continue;
+
+		for (i = 0; i < item->data.values_num; i++)
+		{
+			rec = &item->data.values[i];
+
+			if (rec->timestamp.sec <= start || rec->timestamp.sec > end)
+				continue;
+
+			if (0 != count && values_num == count)
+				return SUCCEED;
+
+			zbx_vcmock_ds_clone_record(rec, value_type, &rec_local);
+			zbx_vector_history_record_append_ptr(&hitem->values, &rec_local);
+			values_num++;
+		}
+	}
+
+	return SUCCEED;
+}
+
 int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history)
 {
 	int			i;
@@ -0,0 +1,180 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+#include "zbxmockdb.h"
+
+#include "common.h"
+#include "db.h"
+#include "zbxdb.h"
+#include "../../../src/zabbix_server/housekeeper/history_partition.h"
+
+extern int	CONFIG_HOUSEKEEPING_PARTITION_DAYS;
+
+/* the statements executed by partition management */
+static zbx_vector_str_t	statements;
+
+/* the statements failing on their first execution */
+static zbx_vector_str_t	failing;
+
+int	__wrap_DBexecute(const char *fmt, ...);
+void	__wrap_DBrollback(void);
+
+int	__wrap_DBexecute(const char *fmt, ...)
+{
+	va_list	args;
+	char	*sql;
+	int	i;
+
+	va_start(args, fmt);
+	sql = zbx_dvsprintf(NULL, fmt, args);
+	va_end(args);
+
+	zbx_vector_str_append(&statements, sql);
+
+	for (i = 0; i < failing.values_num; i++)
+	{
+		if (0 == strcmp(failing.values[i], sql))
+		{
+			zbx_vector_str_remove(&failing, i);
+			return ZBX_DB_FAIL;
+		}
+	}
+
+	return ZBX_DB_OK;
+}
+
+void	__wrap_DBrollback(void)
+{
+}
+
+#ifdef HAVE_POSTGRESQL
+int	__wrap_zbx_dbms_get_version(void);
+
+int	__wrap_zbx_dbms_get_version(void)
+{
+	return (int)zbx_mock_get_parameter_uint64("in.version");
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_check_statements                                            *
+ *                                                                            *
+ * Purpose: compares the executed statements with test case                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_check_statements(void)
+{
+	zbx_mock_handle_t	hstatements, hstatement;
+	zbx_mock_error_t	err;
+	const char		*sql;
+	int			i = 0;
+
+	hstatements = zbx_mock_get_parameter_handle("out.statements");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hstatements, &hstatement))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hstatement, &sql)))
+			fail_msg("cannot read statement: %s", zbx_mock_error_string(err));
+
+		if (i >= statements.values_num)
+			fail_msg("expected statement \"%s\" was not executed", sql);
+
+		zbx_mock_assert_str_eq("statement", sql, statements.values[i]);
+		i++;
+	}
+
+	zbx_mock_assert_int_eq("number of statements", i, statements.values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mock_read_failing                                                *
+ *                                                                            *
+ * Purpose: reads the statements failing on their first execution            *
+ *                                                                            *
+ ******************************************************************************/
+static void	mock_read_failing(void)
+{
+	zbx_mock_handle_t	hstatements, hstatement;
+	zbx_mock_error_t	err;
+	const char		*sql;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_parameter("in.fail", &hstatements))
+		return;
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hstatements, &hstatement))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hstatement, &sql)))
+			fail_msg("cannot read statement: %s", zbx_mock_error_string(err));
+
+		zbx_vector_str_append(&failing, (char *)sql);
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	const char	*database;
+	int		clock_min;
+
+	ZBX_UNUSED(state);
+
+	database = zbx_mock_get_parameter_string("in.database");
+
+#if defined(HAVE_POSTGRESQL)
+	if (0 != strcmp(database, "postgresql"))
+		skip();
+#elif defined(HAVE_MYSQL)
+	if (0 != strcmp(database, "mysql"))
+		skip();
+#else
+	ZBX_UNUSED(database);
+	skip();
+#endif
+	zbx_mockdb_init();
+	zbx_vector_str_create(&statements);
+	zbx_vector_str_create(&failing);
+	mock_read_failing();
+
+	CONFIG_HOUSEKEEPING_PARTITION_DAYS = (int)zbx_mock_get_parameter_uint64("in.days");
+
+	clock_min = hk_history_partitions_update(zbx_mock_get_parameter_string("in.table"),
+			(int)zbx_mock_get_parameter_uint64("in.keep_from"), (int)zbx_mock_get_parameter_uint64("in.now"));
+
+	zbx_mock_assert_int_eq("hk_history_partitions_update() return value",
+			(int)zbx_mock_get_parameter_uint64("out.clock_min"), clock_min);
+
+	/* the next update without dropping expired partitions */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter_exists("in.retry"))
+	{
+		hk_history_partitions_update(zbx_mock_get_parameter_string("in.table"), 0,
+				(int)zbx_mock_get_parameter_uint64("in.now"));
+	}
+
+	mock_check_statements();
+
+	zbx_vector_str_destroy(&failing);
+	zbx_vector_str_clear_ext(&statements, zbx_str_free);
+	zbx_vector_str_destroy(&statements);
+	zbx_mockdb_destroy();
+}
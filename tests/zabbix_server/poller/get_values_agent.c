@@ -0,0 +1,404 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "comms.h"
+#include "log.h"
+#include "dbcache.h"
+#include "version.h"
+#include "../../../src/zabbix_server/poller/checks_agent.h"
+
+#define ZBX_AGENT_TEST_MAX_AGENTS	8
+#define ZBX_AGENT_TEST_MAX_ITEMS	32
+#define ZBX_AGENT_TEST_ADDR		"127.0.0.1"
+
+typedef struct
+{
+	int		fd;
+	unsigned short	port;
+	pid_t		pid;
+	int		version;
+}
+zbx_agent_test_agent_t;
+
+/* response of the agent stand-in to a request */
+typedef struct
+{
+	int		delay;		/* the delay before response, in milliseconds */
+	const char	*data;		/* the response, NULL to close connection without response */
+}
+zbx_agent_test_response_t;
+
+typedef struct
+{
+	zbx_uint64_t	interfaceid;
+	int		version;
+}
+zbx_agent_test_version_t;
+
+static zbx_agent_test_version_t	versions[ZBX_AGENT_TEST_MAX_ITEMS];
+static int			versions_num;
+
+void	__wrap_DCconfig_update_interface_version(zbx_uint64_t interfaceid, int version);
+
+void	__wrap_DCconfig_update_interface_version(zbx_uint64_t interfaceid, int version)
+{
+	if (ZBX_AGENT_TEST_MAX_ITEMS == versions_num)
+		fail_msg("too many agent version updates");
+
+	versions[versions_num].interfaceid = interfaceid;
+	versions[versions_num++].version = version;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_test_str_to_version                                        *
+ *                                                                            *
+ * Purpose: convert agent version from test case ('unknown', 'legacy' or      *
+ *          'major.minor') into agent version known by server                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_test_str_to_version(const char *str)
+{
+	char	buf[32];
+
+	if (0 == strcmp(str, "unknown"))
+		return ZBX_AGENT_VERSION_UNKNOWN;
+
+	if (0 == strcmp(str, "legacy"))
+		return ZBX_AGENT_VERSION_LEGACY;
+
+	zbx_strlcpy(buf, str, sizeof(buf));
+
+	return zbx_get_component_version(buf);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_test_listen                                                *
+ *                                                                            *
+ * Purpose: start listening on a free local port                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_test_listen(zbx_agent_test_agent_t *agent)
+{
+	struct sockaddr_in	addr;
+	socklen_t		addr_len = sizeof(addr);
+
+	if (-1 == (agent->fd = socket(AF_INET, SOCK_STREAM, 0)))
+		fail_msg("cannot create socket: %s", zbx_strerror(errno));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = inet_addr(ZBX_AGENT_TEST_ADDR);
+
+	if (0 != bind(agent->fd, (struct sockaddr *)&addr, sizeof(addr)) || 0 != listen(agent->fd, SOMAXCONN))
+		fail_msg("cannot listen: %s", zbx_strerror(errno));
+
+	if (0 != getsockname(agent->fd, (struct sockaddr *)&addr, &addr_len))
+		fail_msg("cannot get socket name: %s", zbx_strerror(errno));
+
+	agent->port = ntohs(addr.sin_port);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_test_serve                                                 *
+ *                                                                            *
+ * Purpose: answer passive check requests like Zabbix agent would             *
+ *                                                                            *
+ * Parameters: fd     - [IN] the listening socket                             *
+ *             single - [IN] the response to single key request               *
+ *             multi  - [IN] the response to multiple keys request, NULL if   *
+ *                           agent does not support such requests             *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_test_serve(int fd, const zbx_agent_test_response_t *single,
+		const zbx_agent_test_response_t *multi)
+{
+	zbx_socket_t			s;
+	const zbx_agent_test_response_t	*response;
+	pid_t				pid;
+
+	/* agent has several listeners, so connections are served concurrently by processes of one group */
+	setpgid(0, 0);
+	signal(SIGCHLD, SIG_IGN);
+
+	for (;;)
+	{
+		memset(&s, 0, sizeof(s));
+		s.buf_type = ZBX_BUF_TYPE_STAT;
+		s.connection_type = ZBX_TCP_SEC_UNENCRYPTED;
+
+		if (-1 == (s.socket = accept(fd, NULL, NULL)))
+			_exit(EXIT_FAILURE);
+
+		if (0 != (pid = fork()))
+		{
+			if (-1 == pid)
+				_exit(EXIT_FAILURE);
+
+			close(s.socket);
+			continue;
+		}
+
+		if (SUCCEED == zbx_tcp_recv(&s))
+		{
+			response = single;
+
+			/* old agents do not know multiple keys request and treat it as unsupported key */
+			if ('{' == *s.buffer && NULL == (response = multi))
+			{
+				zbx_tcp_send(&s, ZBX_NOTSUPPORTED);
+			}
+			else
+			{
+				usleep(response->delay * 1000);
+
+				if (NULL != response->data)
+					zbx_tcp_send(&s, response->data);
+			}
+		}
+
+		zbx_tcp_close(&s);
+		_exit(EXIT_SUCCESS);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_test_get_response                                          *
+ *                                                                            *
+ * Purpose: read agent stand-in response from test case                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_test_get_response(zbx_mock_handle_t handle, zbx_agent_test_response_t *response)
+{
+	zbx_mock_handle_t	hdata;
+
+	response->delay = (int)zbx_mock_get_object_member_uint64(handle, "delay");
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(handle, "response", &hdata) ||
+			ZBX_MOCK_SUCCESS != zbx_mock_string(hdata, &response->data))
+	{
+		response->data = NULL;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_test_start_agents                                          *
+ *                                                                            *
+ * Purpose: start agent stand-ins described by test case                      *
+ *                                                                            *
+ * Return value: the number of agents                                         *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_test_start_agents(zbx_agent_test_agent_t *agents)
+{
+	zbx_mock_handle_t		hagents, hagent, hmulti, hversion;
+	zbx_mock_error_t		err;
+	zbx_agent_test_response_t	single, multi, *pmulti;
+	const char			*version;
+	int				agents_num = 0;
+
+	hagents = zbx_mock_get_parameter_handle("in.agents");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hagents, &hagent))))
+	{
+		zbx_agent_test_agent_t	*agent = &agents[agents_num];
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read agent: %s", zbx_mock_error_string(err));
+
+		if (ZBX_AGENT_TEST_MAX_AGENTS == agents_num++)
+			fail_msg("too many agents in test case");
+
+		agent_test_listen(agent);
+		agent->pid = -1;
+
+		/* agent version learned by server before the checks */
+		if (ZBX_MOCK_SUCCESS != zbx_mock_object_member(hagent, "version", &hversion) ||
+				ZBX_MOCK_SUCCESS != zbx_mock_string(hversion, &version))
+		{
+			version = "unknown";
+		}
+
+		agent->version = agent_test_str_to_version(version);
+
+		/* agent that is down refuses connections */
+		if (0 == strcmp(zbx_mock_get_object_member_string(hagent, "status"), "down"))
+		{
+			close(agent->fd);
+			continue;
+		}
+
+		agent_test_get_response(hagent, &single);
+
+		pmulti = NULL;
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hagent, "multi", &hmulti))
+			agent_test_get_response(hmulti, pmulti = &multi);
+
+		if (-1 == (agent->pid = fork()))
+			fail_msg("cannot fork: %s", zbx_strerror(errno));
+
+		if (0 == agent->pid)
+			agent_test_serve(agent->fd, &single, pmulti);
+
+		/* set the group in both processes, so it exists whichever runs first */
+		setpgid(agent->pid, agent->pid);
+
+		close(agent->fd);
+	}
+
+	return agents_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_test_stop_agents                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_test_stop_agents(zbx_agent_test_agent_t *agents, int agents_num)
+{
+	int	i;
+
+	for (i = 0; i < agents_num; i++)
+	{
+		if (-1 == agents[i].pid)
+			continue;
+
+		kill(-agents[i].pid, SIGKILL);
+		waitpid(agents[i].pid, NULL, 0);
+	}
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_agent_test_agent_t	agents[ZBX_AGENT_TEST_MAX_AGENTS];
+	DC_ITEM			items[ZBX_AGENT_TEST_MAX_ITEMS];
+	AGENT_RESULT		results[ZBX_AGENT_TEST_MAX_ITEMS];
+	int			errcodes[ZBX_AGENT_TEST_MAX_ITEMS];
+	zbx_mock_handle_t	hitems, hitem;
+	zbx_mock_error_t	err;
+	int			agents_num, items_num = 0, i, agent;
+	double			duration;
+
+	ZBX_UNUSED(state);
+
+	CONFIG_TIMEOUT = (int)zbx_mock_get_parameter_uint64("in.timeout");
+
+	agents_num = agent_test_start_agents(agents);
+
+	memset(items, 0, sizeof(items));
+	hitems = zbx_mock_get_parameter_handle("in.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hitems, &hitem))))
+	{
+		DC_ITEM	*item = &items[items_num];
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item: %s", zbx_mock_error_string(err));
+
+		if (ZBX_AGENT_TEST_MAX_ITEMS == items_num++)
+			fail_msg("too many items in test case");
+
+		if (agents_num <= (agent = (int)zbx_mock_get_object_member_uint64(hitem, "agent")))
+			fail_msg("item refers to unknown agent %d", agent);
+
+		item->itemid = items_num;
+		item->key = (char *)zbx_mock_get_object_member_string(hitem, "key");
+		zbx_strlcpy(item->host.host, "test", sizeof(item->host.host));
+		item->host.tls_connect = ZBX_TCP_SEC_UNENCRYPTED;
+		item->interface.interfaceid = agent + 1;
+		item->interface.addr = (char *)ZBX_AGENT_TEST_ADDR;
+		item->interface.port = agents[agent].port;
+		item->interface.version = agents[agent].version;
+
+		init_result(&results[items_num - 1]);
+		errcodes[items_num - 1] = SUCCEED;
+	}
+
+	duration = zbx_time();
+	get_values_agent(items, results, errcodes, items_num);
+	duration = zbx_time() - duration;
+
+	agent_test_stop_agents(agents, agents_num);
+
+	hitems = zbx_mock_get_parameter_handle("out.items");
+
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hitems, &hitem))); i++)
+	{
+		zbx_mock_handle_t	hvalue;
+		const char		*value;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read item result: %s", zbx_mock_error_string(err));
+
+		if (i == items_num)
+			fail_msg("too many item results in test case");
+
+		zbx_mock_assert_int_eq("item error code",
+				zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hitem, "errcode")),
+				errcodes[i]);
+
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hitem, "value", &hvalue) &&
+				ZBX_MOCK_SUCCESS == zbx_mock_string(hvalue, &value))
+		{
+			if (NULL == GET_TEXT_RESULT(&results[i]))
+				fail_msg("item %d has no value", i);
+
+			zbx_mock_assert_str_eq("item value", value, *GET_TEXT_RESULT(&results[i]));
+		}
+
+		free_result(&results[i]);
+	}
+
+	zbx_mock_assert_int_eq("number of item results", items_num, i);
+
+	/* agent versions learned by the checks */
+	hitems = zbx_mock_get_parameter_handle("out.versions");
+
+	for (i = 0; ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hitems, &hitem))); i++)
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read agent version: %s", zbx_mock_error_string(err));
+
+		if (i == versions_num)
+			fail_msg("agent version was not updated");
+
+		zbx_mock_assert_uint64_eq("agent interface", zbx_mock_get_object_member_uint64(hitem, "agent") + 1,
+				versions[i].interfaceid);
+		zbx_mock_assert_int_eq("agent version",
+				agent_test_str_to_version(zbx_mock_get_object_member_string(hitem, "version")),
+				versions[i].version);
+	}
+
+	zbx_mock_assert_int_eq("number of agent version updates", i, versions_num);
+
+	/* checks run concurrently, each within its own timeout */
+	if ((double)zbx_mock_get_parameter_uint64("out.duration") < duration)
+		fail_msg("checks took %.3f seconds", duration);
+}
@@ -0,0 +1,169 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "dbcache.h"
+#include "../../../src/zabbix_server/poller/checks_snmp.h"
+#include "snmp_walk_cache_test.h"
+
+#define ZBX_SNMP_TEST_MAX_VALUES	32
+
+void	__wrap_DCconfig_update_interface_snmp_stats(zbx_uint64_t interfaceid, int max_snmp_succeed, int min_snmp_fail);
+int	__wrap_DCconfig_get_suggested_snmp_vars(zbx_uint64_t interfaceid, int *bulk);
+
+/* walk and dynamic index caches do not use SNMP statistics of configuration cache */
+void	__wrap_DCconfig_update_interface_snmp_stats(zbx_uint64_t interfaceid, int max_snmp_succeed, int min_snmp_fail)
+{
+	ZBX_UNUSED(interfaceid);
+	ZBX_UNUSED(max_snmp_succeed);
+	ZBX_UNUSED(min_snmp_fail);
+}
+
+int	__wrap_DCconfig_get_suggested_snmp_vars(zbx_uint64_t interfaceid, int *bulk)
+{
+	ZBX_UNUSED(interfaceid);
+	ZBX_UNUSED(bulk);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: snmp_test_walk                                                   *
+ *                                                                            *
+ * Purpose: store values of walked OID in walk and dynamic index caches       *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_test_walk(const DC_ITEM *item, zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hvalues, hvalue;
+	zbx_mock_error_t	err;
+	const char		*indexes[ZBX_SNMP_TEST_MAX_VALUES], *values[ZBX_SNMP_TEST_MAX_VALUES];
+	int			num = 0;
+
+	hvalues = zbx_mock_get_object_member_handle(hstep, "values");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hvalues, &hvalue))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read walked value: %s", zbx_mock_error_string(err));
+
+		if (ZBX_SNMP_TEST_MAX_VALUES == num)
+			fail_msg("too many walked values in test case");
+
+		indexes[num] = zbx_mock_get_object_member_string(hvalue, "index");
+		values[num++] = zbx_mock_get_object_member_string(hvalue, "value");
+	}
+
+	zbx_snmp_walk_cache_test_put(item, zbx_mock_get_object_member_string(hstep, "oid"), indexes, values, num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: snmp_test_check                                                  *
+ *                                                                            *
+ * Purpose: check index of the value in dynamic index cache and the number of *
+ *          references to the walked value                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	snmp_test_check(const DC_ITEM *item, zbx_mock_handle_t hstep)
+{
+	zbx_mock_handle_t	hindex;
+	const char		*snmp_oid, *value, *index;
+	char			*idx = NULL;
+	size_t			idx_alloc = 0;
+	int			ret;
+
+	snmp_oid = zbx_mock_get_object_member_string(hstep, "oid");
+	value = zbx_mock_get_object_member_string(hstep, "value");
+
+	ret = zbx_snmp_index_cache_test_get(item, snmp_oid, value, &idx, &idx_alloc);
+
+	if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "index", &hindex) &&
+			ZBX_MOCK_SUCCESS == zbx_mock_string(hindex, &index))
+	{
+		zbx_mock_assert_result_eq("cache_get_snmp_index() return value", SUCCEED, ret);
+		zbx_mock_assert_str_eq("cached index", index, idx);
+	}
+	else
+		zbx_mock_assert_result_eq("cache_get_snmp_index() return value", FAIL, ret);
+
+	zbx_mock_assert_int_eq("walked value references",
+			(int)zbx_mock_get_object_member_uint64(hstep, "references"),
+			zbx_snmp_index_cache_test_refcount(item, snmp_oid, value));
+
+	zbx_free(idx);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	DC_ITEM			item;
+	zbx_mock_handle_t	hsteps, hstep;
+	zbx_mock_error_t	err;
+	const char		*action;
+
+	ZBX_UNUSED(state);
+
+	memset(&item, 0, sizeof(item));
+	item.interface.addr = (char *)"127.0.0.1";
+	item.interface.port = 161;
+	item.snmp_version = ZBX_IF_SNMP_VERSION_2;
+	item.snmp_community = (char *)"public";
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hsteps, &hstep))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("cannot read step: %s", zbx_mock_error_string(err));
+
+		action = zbx_mock_get_object_member_string(hstep, "action");
+
+		if (0 == strcmp(action, "walk"))
+		{
+			snmp_test_walk(&item, hstep);
+		}
+		else if (0 == strcmp(action, "cached walk"))
+		{
+			zbx_mock_assert_result_eq("cache_get_snmp_walk() return value",
+					zbx_mock_str_to_return_code(zbx_mock_get_object_member_string(hstep, "result")),
+					zbx_snmp_walk_cache_test_get(&item, zbx_mock_get_object_member_string(hstep,
+					"oid")));
+		}
+		else if (0 == strcmp(action, "clear walks"))
+		{
+			zbx_clear_walk_cache_snmp();
+		}
+		else if (0 == strcmp(action, "clear index"))
+		{
+			zbx_snmp_index_cache_test_clear(&item, zbx_mock_get_object_member_string(hstep, "oid"));
+		}
+		else if (0 == strcmp(action, "check"))
+		{
+			snmp_test_check(&item, hstep);
+		}
+		else
+			fail_msg("unknown step action \"%s\"", action);
+	}
+}
@@ -0,0 +1,87 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "snmp_walk_cache_test.h"
+
+void	zbx_snmp_walk_cache_test_put(const DC_ITEM *item, const char *snmp_oid, const char **indexes,
+		const char **values, int num)
+{
+	zbx_snmp_walk_oid_t	*walk_oid;
+	zbx_snmp_walk_value_t	*walk_value;
+	int			i;
+
+	walk_oid = zbx_snmp_walk_oid_create(snmp_oid);
+
+	/* values are passed to dynamic index cache as they are walked */
+	for (i = 0; i < num; i++)
+	{
+		walk_value = zbx_snmp_walk_value_create(indexes[i], values[i]);
+		zbx_snmp_walk_cache_cb((void *)item, walk_oid->num, snmp_oid, walk_value);
+		zbx_vector_ptr_append(&walk_oid->values, walk_value);
+	}
+
+	cache_put_snmp_walk(item, walk_oid);
+	zbx_snmp_walk_oid_free(walk_oid);
+}
+
+int	zbx_snmp_walk_cache_test_get(const DC_ITEM *item, const char *snmp_oid)
+{
+	zbx_snmp_walk_oid_t	*walk_oid;
+	int			ret;
+
+	walk_oid = zbx_snmp_walk_oid_create(snmp_oid);
+	ret = cache_get_snmp_walk(item, walk_oid, zbx_snmp_walk_cache_cb, (void *)item);
+	zbx_snmp_walk_oid_free(walk_oid);
+
+	return ret;
+}
+
+void	zbx_snmp_index_cache_test_clear(const DC_ITEM *item, const char *snmp_oid)
+{
+	cache_del_snmp_index_subtree(item, snmp_oid);
+}
+
+int	zbx_snmp_index_cache_test_get(const DC_ITEM *item, const char *snmp_oid, const char *value, char **idx,
+		size_t *idx_alloc)
+{
+	return cache_get_snmp_index(item, snmp_oid, value, idx, idx_alloc);
+}
+
+int	zbx_snmp_index_cache_test_refcount(const DC_ITEM *item, const char *snmp_oid, const char *value)
+{
+	zbx_snmpidx_main_key_t	*main_key, main_key_local;
+	zbx_snmpidx_mapping_t	*mapping;
+
+	if (NULL == snmpidx.slots)
+		return 0;
+
+	main_key_local.addr = item->interface.addr;
+	main_key_local.port = item->interface.port;
+	main_key_local.oid = (char *)snmp_oid;
+	main_key_local.community_context = get_item_community_context(item);
+	main_key_local.security_name = get_item_security_name(item);
+
+	if (NULL == (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_search(&snmpidx, &main_key_local)))
+		return 0;
+
+	if (NULL == (mapping = (zbx_snmpidx_mapping_t *)zbx_hashset_search(main_key->mappings, &value)))
+		return 0;
+
+	return (int)mapping->walk_value->refcount;
+}
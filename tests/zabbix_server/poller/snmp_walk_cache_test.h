@@ -0,0 +1,31 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef SNMP_WALK_CACHE_TEST_H
+#define SNMP_WALK_CACHE_TEST_H
+
+void	zbx_snmp_walk_cache_test_put(const DC_ITEM *item, const char *snmp_oid, const char **indexes,
+		const char **values, int num);
+int	zbx_snmp_walk_cache_test_get(const DC_ITEM *item, const char *snmp_oid);
+void	zbx_snmp_index_cache_test_clear(const DC_ITEM *item, const char *snmp_oid);
+int	zbx_snmp_index_cache_test_get(const DC_ITEM *item, const char *snmp_oid, const char *value, char **idx,
+		size_t *idx_alloc);
+int	zbx_snmp_index_cache_test_refcount(const DC_ITEM *item, const char *snmp_oid, const char *value);
+
+#endif /* SNMP_WALK_CACHE_TEST_H */
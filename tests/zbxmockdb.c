@@ -131,6 +131,10 @@ static char	*generate_data_source(const char *sql)
 			break;
 	}
 
+	/* table name at the end of query is not followed by separator */
+	if (0 != found)
+		*(ptr_ds++) = ' ';
+
 	if (ptr_ds == data_source)
 		zbx_free(data_source);	/* failed to generate data_source */
 	else
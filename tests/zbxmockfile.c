@@ -37,6 +37,9 @@ void	*mock_streams[ZBX_MOCK_MAX_FILES];
 
 static zbx_mock_handle_t	fragments;
 
+/* the descriptor returning mocked fragments, other descriptors are passed to real functions */
+static int			fragments_fd = -1;
+
 struct zbx_mock_IO_FILE
 {
 	const char	*contents;
@@ -53,6 +56,8 @@ int	__wrap___xstat(int ver, const char *pathname, struct stat *buf);
 int	__wrap___fxstat(int __ver, int __fildes, struct stat *__stat_buf);
 
 int	__real_open(const char *path, int oflag, ...);
+int	__real_connect(int socket, __CONST_SOCKADDR_ARG addr, socklen_t address_len);
+ssize_t	__real_read(int fildes, void *buf, size_t nbyte);
 int	__real_stat(const char *path, struct stat *buf);
 int	__real___fxstat(int __ver, int __fildes, struct stat *__stat_buf);
 
@@ -72,6 +77,30 @@ static int	is_profiler_path(const char *path)
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Comments: Directories are listed in "directories" vector of "in" section.  *
+ *           Tests must create listed directories themselves if they use them *
+ *           through functions that are not mocked.                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	is_mock_directory(const char *path)
+{
+	zbx_mock_handle_t	directories, directory;
+	const char		*name;
+
+	if (ZBX_MOCK_SUCCESS != zbx_mock_in_parameter("directories", &directories))
+		return FAIL;
+
+	while (ZBX_MOCK_SUCCESS == zbx_mock_vector_element(directories, &directory))
+	{
+		if (ZBX_MOCK_SUCCESS == zbx_mock_string(directory, &name) && 0 == strcmp(path, name))
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
 static int	is_mock_stream(FILE *stream)
 {
 	int	i;
@@ -170,14 +199,11 @@ char	*__wrap_fgets(char *s, int size, FILE *stream)
 
 int	__wrap_connect(int socket, __CONST_SOCKADDR_ARG addr, socklen_t address_len)
 {
-	zbx_mock_error_t	error;
-
-	ZBX_UNUSED(socket);
-	ZBX_UNUSED(addr);
-	ZBX_UNUSED(address_len);
+	/* tests without fragments use real connections, for example to local IPC services */
+	if (ZBX_MOCK_SUCCESS != zbx_mock_in_parameter("fragments", &fragments))
+		return __real_connect(socket, addr, address_len);
 
-	if (ZBX_MOCK_SUCCESS != (error = zbx_mock_in_parameter("fragments", &fragments)))
-		fail_msg("Cannot get fragments handle: %s", zbx_mock_error_string(error));
+	fragments_fd = socket;
 
 	return 0;
 }
@@ -196,17 +222,16 @@ int	__wrap_open(const char *path, int oflag, ...)
 	}
 
 	fragments = zbx_mock_get_parameter_handle("in.fragments");
+	fragments_fd = INT_MAX;
 
 	return INT_MAX;
 }
 
 /******************************************************************************
  *                                                                            *
- * Comments: Note that simply wrapping read function will break any compiled  *
- *           in tool, that would attempt to use read() function. In this case *
- *           some safeguards must be added to implement pass-through          *
- *           functionality like it's done with open/fxstat etc functions for  *
- *           coverage builds.                                                 *
+ * Comments: Only the descriptor returned by mocked open() or connect() is   *
+ *           read from fragments, other descriptors are passed through to the *
+ *           real read() function.                                            *
  *                                                                            *
  ******************************************************************************/
 ssize_t	__wrap_read(int fildes, void *buf, size_t nbyte)
@@ -217,7 +242,8 @@ ssize_t	__wrap_read(int fildes, void *buf, size_t nbyte)
 	zbx_mock_handle_t	fragment;
 	size_t			length;
 
-	ZBX_UNUSED(fildes);
+	if (fildes != fragments_fd)
+		return __real_read(fildes, buf, nbyte);
 
 	if (0 == remaining_length)
 	{
@@ -263,9 +289,9 @@ int	__wrap_stat(const char *path, struct stat *buf)
 	if (ZBX_MOCK_NO_PARAMETER != error)
 		fail_msg("Error during path \"%s\" lookup among files: %s", path, zbx_mock_error_string(error));
 
-	if (0)	/* directory lookup is not implemented */
+	if (SUCCEED == is_mock_directory(path))
 	{
-		buf->st_mode = S_IFMT & S_IFDIR;
+		buf->st_mode = S_IFDIR;
 		return 0;
 	}
 
@@ -193,7 +193,7 @@ class CTask extends CApiService {
 					]]
 				]],
 				'preprocessing' =>	['type' => API_OBJECT, 'fields' => [
-					'stats' =>			['type' => API_OUTPUT, 'in' => implode(',', ['values', 'preproc.values']), 'default' => API_OUTPUT_EXTEND],
+					'stats' =>			['type' => API_OUTPUT, 'in' => implode(',', ['values', 'preproc.values', 'regexp.hits', 'regexp.misses']), 'default' => API_OUTPUT_EXTEND],
 					'top' =>			['type' => API_OBJECT, 'fields' => [
 						'values' =>			['type' => API_INT32]
 					]]
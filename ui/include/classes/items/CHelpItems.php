@@ -1156,7 +1156,7 @@ class CHelpItems {
 				],
 				[
 					'key' => 'zabbix[rcache,<cache>,<mode>]',
-					'description' => _('Configuration cache statistics. Cache - buffer (modes: pfree, total, used, free).')
+					'description' => _('Configuration cache statistics. Cache - buffer (modes: pfree, total, used, free), sync (modes: lock, lockmax).')
 				],
 				[
 					'key' => 'zabbix[requiredperformance]',